@@ -104,6 +104,20 @@ SOURCES += \
     $$PWD/src/DetectorInfoListModel.cc \
     $$PWD/src/TagDatabase.cc \
     $$PWD/src/PulseInfoList.cc \
+    $$PWD/src/PulseLog.cc \
+    $$PWD/src/PulseIngest.cc \
+    $$PWD/src/BearingEstimator.cc \
+    $$PWD/src/ChannelizerTuner.cc \
+    $$PWD/src/TagTrackerSession.cc \
+    $$PWD/src/TagTriangulator.cc \
+    $$PWD/src/PulseHeatMap.cc \
+    $$PWD/src/TunnelCommandQueue.cc \
+    $$PWD/src/DeadlineWheel.cc \
+    $$PWD/src/SpectrogramPyramid.cc \
+    $$PWD/src/CaptureViewer.cc \
+    $$PWD/src/PulseTimeSeries.cc \
+    $$PWD/src/PulseHistory.cc \
+    $$PWD/src/PipelineTelemetry.cc \
 
 HEADERS += \
     $$PWD/src/CustomOptions.h \
@@ -113,6 +127,56 @@ HEADERS += \
     $$PWD/src/DetectorInfoListModel.h \
     $$PWD/src/TagDatabase.h \
     $$PWD/src/PulseInfoList.h \
+    $$PWD/src/PulseLog.h \
+    $$PWD/src/PulseIngest.h \
+    $$PWD/src/BearingEstimator.h \
+    $$PWD/src/ChannelizerTuner.h \
+    $$PWD/src/TagTrackerSession.h \
+    $$PWD/src/TagTriangulator.h \
+    $$PWD/src/PulseHeatMap.h \
+    $$PWD/src/TunnelCommandQueue.h \
+    $$PWD/src/DeadlineWheel.h \
+    $$PWD/src/SpectrogramPyramid.h \
+    $$PWD/src/CaptureViewer.h \
+    $$PWD/src/PulseTimeSeries.h \
+    $$PWD/src/PulseHistory.h \
+    $$PWD/src/PipelineTelemetry.h \
+
+# TagTracker unit tests
+DebugBuild {
+    INCLUDEPATH += \
+        $$PWD/test \
+
+    SOURCES += \
+        $$PWD/test/PulseLogTest.cc \
+        $$PWD/test/BearingEstimatorTest.cc \
+        $$PWD/test/ChannelizerTunerTest.cc \
+        $$PWD/test/TagTriangulatorTest.cc \
+        $$PWD/test/PulseHeatMapTest.cc \
+        $$PWD/test/TunnelCommandQueueTest.cc \
+        $$PWD/test/DeadlineWheelTest.cc \
+        $$PWD/test/SpectrogramPyramidTest.cc \
+        $$PWD/test/TagDatabaseTest.cc \
+        $$PWD/test/PulseTimeSeriesTest.cc \
+        $$PWD/test/PipelineTelemetryTest.cc \
+        $$PWD/test/PulseReplayer.cc \
+        $$PWD/test/PulseReplayTest.cc \
+
+    HEADERS += \
+        $$PWD/test/PulseLogTest.h \
+        $$PWD/test/BearingEstimatorTest.h \
+        $$PWD/test/ChannelizerTunerTest.h \
+        $$PWD/test/TagTriangulatorTest.h \
+        $$PWD/test/PulseHeatMapTest.h \
+        $$PWD/test/TunnelCommandQueueTest.h \
+        $$PWD/test/DeadlineWheelTest.h \
+        $$PWD/test/SpectrogramPyramidTest.h \
+        $$PWD/test/TagDatabaseTest.h \
+        $$PWD/test/PulseTimeSeriesTest.h \
+        $$PWD/test/PipelineTelemetryTest.h \
+        $$PWD/test/PulseReplayer.h \
+        $$PWD/test/PulseReplayTest.h \
+}
 
 # Bearing calc matlab code
     INCLUDEPATH += \
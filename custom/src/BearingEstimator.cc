@@ -0,0 +1,135 @@
+#include "BearingEstimator.h"
+
+#include <QtMath>
+
+#include <limits>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(BearingEstimatorLog, "BearingEstimatorLog")
+
+BearingEstimator::BearingEstimator()
+{
+
+}
+
+void BearingEstimator::reset(void)
+{
+    _slices.clear();
+    _binMaxSNR.clear();
+    _currentSliceMaxSNR = qQNaN();
+    _bearing            = qQNaN();
+}
+
+void BearingEstimator::addPulse(const PulseInfo_t& pulseInfo)
+{
+    if (qIsNaN(_currentSliceMaxSNR) || pulseInfo.snr > _currentSliceMaxSNR) {
+        _currentSliceMaxSNR = pulseInfo.snr;
+    }
+}
+
+void BearingEstimator::resetBinned(int binCount)
+{
+    reset();
+
+    binCount = qMax(binCount, 1);
+    _slices.resize(binCount);
+    _binMaxSNR.fill(qQNaN(), binCount);
+    for (int i=0; i<binCount; i++) {
+        _slices[i].headingRadians   = qDegreesToRadians((360.0 * i) / binCount);
+        _slices[i].linearPower      = 0;
+    }
+}
+
+int BearingEstimator::binForHeading(double headingDegrees) const
+{
+    int binCount    = _binMaxSNR.count();
+    int bin         = qRound(fmod(headingDegrees, 360.0) / (360.0 / binCount)) % binCount;
+
+    return bin < 0 ? bin + binCount : bin;
+}
+
+int BearingEstimator::addBinnedPulse(const PulseInfo_t& pulseInfo, double antennaHeadingDegrees)
+{
+    int bin = binForHeading(antennaHeadingDegrees);
+
+    // Only a new strongest pulse for a bin can move the estimate
+    if (qIsNaN(_binMaxSNR[bin]) || pulseInfo.snr > _binMaxSNR[bin]) {
+        _binMaxSNR[bin]             = pulseInfo.snr;
+        _slices[bin].linearPower    = qPow(10.0, pulseInfo.snr / 10.0);
+        _updateBearing();
+    }
+
+    return bin;
+}
+
+double BearingEstimator::headingFromOrientation(const PulseInfo_t& pulseInfo)
+{
+    double w = pulseInfo.orientation_w;
+    double x = pulseInfo.orientation_x;
+    double y = pulseInfo.orientation_y;
+    double z = pulseInfo.orientation_z;
+
+    // Controllers without attitude information send an all zero quaternion
+    if ((w * w) + (x * x) + (y * y) + (z * z) < 0.5) {
+        return qQNaN();
+    }
+
+    double heading = qRadiansToDegrees(qAtan2(2 * ((w * z) + (x * y)), 1 - (2 * ((y * y) + (z * z)))));
+
+    // fmod also folds a tiny negative heading, which rounds to 360 once shifted, back to 0
+    return fmod(heading + 360.0, 360.0);
+}
+
+double BearingEstimator::completeSlice(double antennaHeadingDegrees)
+{
+    Slice_t slice;
+
+    slice.headingRadians = qDegreesToRadians(antennaHeadingDegrees);
+    // Slices with no pulses contribute no power but still count towards the weakest slice
+    slice.linearPower = qIsNaN(_currentSliceMaxSNR) ? 0.0 : qPow(10.0, _currentSliceMaxSNR / 10.0);
+    _slices.append(slice);
+
+    qCDebug(BearingEstimatorLog) << "completeSlice heading:snr" << antennaHeadingDegrees << _currentSliceMaxSNR;
+
+    _currentSliceMaxSNR = qQNaN();
+    _updateBearing();
+
+    return _bearing;
+}
+
+void BearingEstimator::_updateBearing(void)
+{
+    // With a continuous rotation finer bins can be passed over between pulses, so empty bins are ignored rather than
+    // treated as having no signal
+    bool binned = !_binMaxSNR.isEmpty();
+
+    double minPower = std::numeric_limits<double>::max();
+    for (int i=0; i<_slices.count(); i++) {
+        if (!binned || !qIsNaN(_binMaxSNR[i])) {
+            minPower = qMin(minPower, _slices[i].linearPower);
+        }
+    }
+
+    double sumX = 0;
+    double sumY = 0;
+    for (int i=0; i<_slices.count(); i++) {
+        if (binned && qIsNaN(_binMaxSNR[i])) {
+            continue;
+        }
+        const Slice_t&  slice   = _slices[i];
+        double          weight  = slice.linearPower - minPower;
+        sumX += weight * qCos(slice.headingRadians);
+        sumY += weight * qSin(slice.headingRadians);
+    }
+
+    if (sumX == 0 && sumY == 0) {
+        // Not enough variation in signal strength yet to point anywhere
+        _bearing = qQNaN();
+        return;
+    }
+
+    _bearing = fmod(qRadiansToDegrees(qAtan2(sumY, sumX)) + 360.0, 360.0);
+
+    qCDebug(BearingEstimatorLog) << "bearing estimate" << _bearing << "slices" << _slices.count();
+}
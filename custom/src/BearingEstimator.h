@@ -0,0 +1,68 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+#include "TunnelProtocol.h"
+
+#include <QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(BearingEstimatorLog)
+
+/// Incremental bearing estimate for a single rotation. Pulses are fed in as they arrive. When the vehicle finishes
+/// dwelling at a heading the slice is closed and the bearing estimate is updated. This allows a bearing to be
+/// available immediately after the last slice without going back through the rotation log.
+///
+/// The estimate is the circular mean of the slice headings weighted by the linear pulse power above the weakest slice.
+/// Subtracting the weakest slice removes the omni-directional component of the antenna pattern from the estimate.
+///
+/// For a continuous rotation there are no slices. Instead each pulse is placed in a fixed angular bin using the heading
+/// the antenna was pointing at when the pulse was received and the bins take the place of slices in the estimate.
+class BearingEstimator
+{
+public:
+    BearingEstimator();
+
+    void    reset           (void);
+    void    addPulse        (const TunnelProtocol::PulseInfo_t& pulseInfo);
+
+    /// Resets for a continuous rotation with pulses binned by heading
+    ///     @param binCount Number of equal bins, bin 0 is centered on 0 degrees
+    void    resetBinned     (int binCount);
+
+    /// Adds a pulse to the bin for the specified heading and updates the bearing estimate
+    ///     @param antennaHeadingDegrees Heading the antenna was pointing at when the pulse was received
+    /// @return Bin the pulse was added to
+    int     addBinnedPulse  (const TunnelProtocol::PulseInfo_t& pulseInfo, double antennaHeadingDegrees);
+
+    /// @return Bin index for the specified heading. Only valid after resetBinned.
+    int     binForHeading   (double headingDegrees) const;
+
+    /// @return Max snr for the bin, NaN if no pulses have landed in it
+    double  binMaxSNR       (int bin) const { return _binMaxSNR[bin]; }
+    int     binCount        (void) const { return _binMaxSNR.count(); }
+
+    /// Vehicle heading from the pulse orientation, which is the NED body to earth quaternion at the time of the pulse
+    /// @return Heading in degrees [0, 360), NaN if the pulse has no orientation
+    static double headingFromOrientation(const TunnelProtocol::PulseInfo_t& pulseInfo);
+
+    /// Closes out the current slice
+    ///     @param antennaHeadingDegrees Heading the antenna was pointing at during the slice
+    /// @return Updated bearing estimate in degrees [0, 360), NaN if no bearing is available yet
+    double  completeSlice   (double antennaHeadingDegrees);
+
+    /// @return Current bearing estimate in degrees [0, 360), NaN if no bearing is available yet
+    double  bearing         (void) const { return _bearing; }
+    int     sliceCount      (void) const { return _slices.count(); }
+
+private:
+    typedef struct {
+        double headingRadians;
+        double linearPower;
+    } Slice_t;
+
+    void _updateBearing(void);
+
+    QVector<Slice_t>    _slices;
+    QVector<double>     _binMaxSNR;
+    double              _currentSliceMaxSNR = qQNaN();
+    double              _bearing            = qQNaN();
+};
@@ -0,0 +1,323 @@
+#include "CaptureViewer.h"
+#include "QGCApplication.h"
+#include "MultiVehicleManager.h"
+#include "Vehicle.h"
+#include "FTPManager.h"
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(CaptureViewerLog, "CaptureViewerLog")
+
+CaptureViewer::CaptureViewer(QObject* parent)
+    : QObject(parent)
+{
+    _retryTimer.setSingleShot(true);
+    _retryTimer.setInterval(_retryMsecs);
+    connect(&_retryTimer, &QTimer::timeout, this, &CaptureViewer::_fetchNext);
+
+    _updateTimer.setSingleShot(true);
+    _updateTimer.setInterval(_updateMsecs);
+    connect(&_updateTimer, &QTimer::timeout, this, [this]() {
+        _image = _pyramid ? _pyramid->render(_level, _firstViewRow(), viewRows) : QImage();
+        _revision++;
+        emit imageChanged();
+    });
+}
+
+bool CaptureViewer::isCaptureFile(const QString& fileName)
+{
+    return fileName.startsWith(QStringLiteral("data_record")) || fileName.startsWith(QStringLiteral("spectro_segment"));
+}
+
+FTPManager* CaptureViewer::_activeFTPManager(void)
+{
+    Vehicle* vehicle = qgcApp()->toolbox()->multiVehicleManager()->activeVehicle();
+
+    return vehicle ? vehicle->ftpManager() : nullptr;
+}
+
+void CaptureViewer::listCaptures(const QString& logDir)
+{
+    FTPManager* ftpManager = _activeFTPManager();
+    if (!ftpManager) {
+        return;
+    }
+
+    connect(ftpManager, &FTPManager::listDirectoryComplete, this, &CaptureViewer::_listDirectoryComplete);
+    if (!ftpManager->listDirectory(MAV_COMP_ID_ONBOARD_COMPUTER, logDir)) {
+        qCDebug(CaptureViewerLog) << "listCaptures - listDirectory: returned false";
+        disconnect(ftpManager, &FTPManager::listDirectoryComplete, this, &CaptureViewer::_listDirectoryComplete);
+        _setErrorString(tr("Controller is busy with another transfer"));
+    }
+}
+
+void CaptureViewer::_listDirectoryComplete(const QStringList& dirList, const QString& errorMsg)
+{
+    disconnect(qobject_cast<FTPManager*>(sender()), &FTPManager::listDirectoryComplete, this, &CaptureViewer::_listDirectoryComplete);
+
+    _captureFiles.clear();
+    if (errorMsg.isEmpty()) {
+        for (const QString& entry: dirList) {
+            // Note MavlinkTagController only sends file name. It doesn't include file size.
+            if (entry.startsWith("F") && isCaptureFile(entry.mid(1))) {
+                _captureFiles.append(entry.mid(1));
+            }
+        }
+        _captureFiles.sort();
+    } else {
+        qCDebug(CaptureViewerLog) << "_listDirectoryComplete: error" << errorMsg;
+        _setErrorString(errorMsg);
+    }
+
+    emit captureFilesChanged();
+}
+
+void CaptureViewer::open(const QString& logDir, const QString& fileName)
+{
+    close();
+
+    FTPManager* ftpManager = _activeFTPManager();
+    if (!ftpManager) {
+        _setErrorString(tr("No vehicle connected"));
+        return;
+    }
+
+    qCDebug(CaptureViewerLog) << "open - logDir:fileName" << logDir << fileName;
+
+    _ftpManager         = ftpManager;
+    _fileName           = fileName;
+    _filePathOnVehicle  = QStringLiteral("%1/%2").arg(logDir, fileName);
+    _setErrorString(QString());
+    connect(ftpManager, &FTPManager::readFileRangeComplete, this, &CaptureViewer::_readFileRangeComplete);
+
+    emit fileChanged();
+
+    // The directory listing has no file sizes. The first read returns it along with the start of the file.
+    _pendingFetch.level     = 0;
+    _pendingFetch.firstRow  = 0;
+    _pendingFetch.rowCount  = SpectrogramPyramid::maxFramesPerRow;
+    _pendingFetch.offset    = 0;
+    _pendingFetch.size      = SpectrogramPyramid::maxFramesPerRow * SpectrogramPyramid::bytesPerFrame;
+    _readRange(_pendingFetch.offset, _pendingFetch.size);
+}
+
+void CaptureViewer::close(void)
+{
+    _retryTimer.stop();
+    _updateTimer.stop();
+
+    if (_ftpManager) {
+        _disconnectFTP();
+        if (_fetchInProgress) {
+            _ftpManager->cancelDownload();
+        }
+    }
+    _ftpManager = nullptr;
+
+    _fetchInProgress    = false;
+    _cFetchErrors       = 0;
+    _bytesRead          = 0;
+    _fileSize           = 0;
+    _level              = 0;
+    _position           = 0;
+    _fileName.clear();
+    _filePathOnVehicle.clear();
+    _pyramid.reset();
+    _image = QImage();
+    _revision++;
+
+    _setBusy(false);
+    emit fileChanged();
+    emit viewChanged();
+    emit imageChanged();
+}
+
+void CaptureViewer::_disconnectFTP(void)
+{
+    disconnect(_ftpManager, &FTPManager::readFileRangeComplete, this, &CaptureViewer::_readFileRangeComplete);
+}
+
+bool CaptureViewer::_readRange(uint32_t offset, uint32_t size)
+{
+    if (!_ftpManager) {
+        _setErrorString(tr("Vehicle connection lost"));
+        _setBusy(false);
+        return false;
+    }
+
+    _setBusy(true);
+    if (!_ftpManager->readFileRange(MAV_COMP_ID_ONBOARD_COMPUTER, _filePathOnVehicle, offset, size)) {
+        // Another transfer is using FTP, wait for it to finish
+        qCDebug(CaptureViewerLog) << "_readRange - readFileRange: returned false, retrying";
+        _retryTimer.start();
+        return false;
+    }
+    _fetchInProgress = true;
+
+    return true;
+}
+
+void CaptureViewer::_fetchNext(void)
+{
+    if (_fetchInProgress || _filePathOnVehicle.isEmpty()) {
+        return;
+    }
+
+    // Until the file size is known the first read is repeated
+    if (_pyramid) {
+        // The overview comes first so the view always has something to fall back on
+        if (!_pyramid->nextFetch(_pyramid->levelCount() - 1, 0, viewRows, _pendingFetch) &&
+                !_pyramid->nextFetch(_level, _firstViewRow(), viewRows, _pendingFetch)) {
+            _setBusy(false);
+            return;
+        }
+    }
+
+    _readRange(_pendingFetch.offset, _pendingFetch.size);
+}
+
+void CaptureViewer::_readFileRangeComplete(const QString& file, uint32_t offset, const QByteArray& data, uint32_t fileSize, const QString& errorMsg)
+{
+    if (!_fetchInProgress || file != _filePathOnVehicle) {
+        return;
+    }
+    _fetchInProgress = false;
+
+    if (!errorMsg.isEmpty()) {
+        qCDebug(CaptureViewerLog) << "_readFileRangeComplete: error offset:errorMsg" << offset << errorMsg;
+        if (++_cFetchErrors >= _maxFetchErrors) {
+            _setErrorString(errorMsg);
+            _setBusy(false);
+        } else {
+            _retryTimer.start();
+        }
+        return;
+    }
+    _cFetchErrors   = 0;
+    _bytesRead      += data.size();
+
+    if (!_pyramid) {
+        _fileSize = fileSize;
+        _pyramid.reset(new SpectrogramPyramid(fileSize, maxCacheBytes));
+        _level = _pyramid->levelCount() - 1;
+        qCDebug(CaptureViewerLog) << "_readFileRangeComplete: fileSize:levelCount" << fileSize << _pyramid->levelCount();
+        emit fileChanged();
+        emit viewChanged();
+    }
+
+    _pyramid->addFetchData(_pendingFetch, data);
+    _scheduleUpdate();
+    _fetchNext();
+}
+
+double CaptureViewer::durationSecs(void) const
+{
+    return static_cast<double>(_fileSize / SpectrogramPyramid::bytesPerSample) / sampleRateHz;
+}
+
+double CaptureViewer::viewFraction(void) const
+{
+    if (!_pyramid || _pyramid->frameCount() == 0) {
+        return 1.0;
+    }
+
+    return std::min(1.0, static_cast<double>(static_cast<qint64>(viewRows) << _level) / _pyramid->frameCount());
+}
+
+qint64 CaptureViewer::_firstViewRow(void) const
+{
+    if (!_pyramid) {
+        return 0;
+    }
+
+    qint64 rowCount = _pyramid->rowCount(_level);
+
+    return std::clamp(static_cast<qint64>(_position * rowCount), static_cast<qint64>(0), std::max(rowCount - viewRows, static_cast<qint64>(0)));
+}
+
+void CaptureViewer::setLevel(int level)
+{
+    level = std::clamp(level, 0, std::max(levelCount() - 1, 0));
+    if (level == _level) {
+        return;
+    }
+
+    // Zoom around the center of the view
+    double center = _position + (viewFraction() / 2);
+    _level = level;
+    _position = std::clamp(center - (viewFraction() / 2), 0.0, 1.0 - viewFraction());
+
+    emit viewChanged();
+    _scheduleUpdate();
+    _fetchNext();
+}
+
+void CaptureViewer::setPosition(double position)
+{
+    position = std::clamp(position, 0.0, 1.0 - viewFraction());
+    if (qFuzzyCompare(position, _position)) {
+        return;
+    }
+    _position = position;
+
+    emit viewChanged();
+    _scheduleUpdate();
+    _fetchNext();
+}
+
+QString CaptureViewer::imageUrl(void) const
+{
+    // The revision forces QML to request a new image when the contents change
+    return QStringLiteral("image://%1/%2").arg(imageProviderId).arg(_revision);
+}
+
+double CaptureViewer::coverage(void) const
+{
+    return _pyramid ? _pyramid->coverage(_level, _firstViewRow(), viewRows) : 0.0;
+}
+
+void CaptureViewer::_scheduleUpdate(void)
+{
+    if (!_updateTimer.isActive()) {
+        _updateTimer.start();
+    }
+}
+
+void CaptureViewer::_setBusy(bool busy)
+{
+    if (busy != _busy) {
+        _busy = busy;
+        emit busyChanged(_busy);
+    }
+}
+
+void CaptureViewer::_setErrorString(const QString& errorString)
+{
+    if (errorString != _errorString) {
+        _errorString = errorString;
+        emit errorStringChanged(_errorString);
+    }
+}
+
+CaptureViewerImageProvider::CaptureViewerImageProvider(CaptureViewer* captureViewer)
+    : QQuickImageProvider   (QQuickImageProvider::Image)
+    , _captureViewer        (captureViewer)
+{
+
+}
+
+QImage CaptureViewerImageProvider::requestImage(const QString& /*id*/, QSize* size, const QSize& /*requestedSize*/)
+{
+    QImage image = _captureViewer->image();
+
+    if (image.isNull()) {
+        // QML still asks for an image before the first read completes
+        image = QImage(1, 1, QImage::Format_RGB32);
+        image.fill(Qt::black);
+    }
+    if (size) {
+        *size = image.size();
+    }
+
+    return image;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+#include "SpectrogramPyramid.h"
+
+#include <QObject>
+#include <QImage>
+#include <QPointer>
+#include <QQuickImageProvider>
+#include <QScopedPointer>
+#include <QStringList>
+#include <QTimer>
+
+Q_DECLARE_LOGGING_CATEGORY(CaptureViewerLog)
+
+class FTPManager;
+
+/// Shows the raw capture and spectrogram segment files in a controller log directory without downloading them. The
+/// file is read over FTP a range at a time, only the parts needed for the current view. The whole file overview is
+/// read first and the view at the current zoom level fills in over it.
+class CaptureViewer : public QObject
+{
+    Q_OBJECT
+
+public:
+    CaptureViewer(QObject* parent = nullptr);
+
+    Q_PROPERTY(QStringList  captureFiles    READ captureFiles   NOTIFY captureFilesChanged)
+    Q_PROPERTY(QString      fileName        READ fileName       NOTIFY fileChanged)
+    Q_PROPERTY(bool         fileOpen        READ fileOpen       NOTIFY fileChanged)
+    Q_PROPERTY(qint64       fileSize        READ fileSize       NOTIFY fileChanged)
+    Q_PROPERTY(double       durationSecs    READ durationSecs   NOTIFY fileChanged)
+    Q_PROPERTY(int          levelCount      READ levelCount     NOTIFY fileChanged)
+    Q_PROPERTY(int          level           READ level          WRITE setLevel      NOTIFY viewChanged)
+    Q_PROPERTY(double       position        READ position       WRITE setPosition   NOTIFY viewChanged)
+    Q_PROPERTY(double       viewFraction    READ viewFraction   NOTIFY viewChanged)
+    Q_PROPERTY(QString      imageUrl        READ imageUrl       NOTIFY imageChanged)
+    Q_PROPERTY(double       coverage        READ coverage       NOTIFY imageChanged)
+    Q_PROPERTY(qint64       bytesRead       READ bytesRead      NOTIFY imageChanged)
+    Q_PROPERTY(bool         busy            READ busy           NOTIFY busyChanged)
+    Q_PROPERTY(QString      errorString     READ errorString    NOTIFY errorStringChanged)
+
+    /// Lists the capture files in a log directory on the controller. Signals captureFilesChanged.
+    Q_INVOKABLE void listCaptures   (const QString& logDir);
+
+    /// Starts streaming a capture file from a log directory on the controller
+    Q_INVOKABLE void open           (const QString& logDir, const QString& fileName);
+    Q_INVOKABLE void close          (void);
+
+    QStringList captureFiles    (void) const { return _captureFiles; }
+    QString     fileName        (void) const { return _fileName; }
+    bool        fileOpen        (void) const { return !_pyramid.isNull(); }
+    qint64      fileSize        (void) const { return _fileSize; }
+    double      durationSecs    (void) const;
+    int         levelCount      (void) const { return _pyramid ? _pyramid->levelCount() : 0; }
+    int         level           (void) const { return _level; }
+    double      position        (void) const { return _position; }
+    double      viewFraction    (void) const;
+    QString     imageUrl        (void) const;
+    double      coverage        (void) const;
+    qint64      bytesRead       (void) const { return _bytesRead; }
+    bool        busy            (void) const { return _busy; }
+    QString     errorString     (void) const { return _errorString; }
+    QImage      image           (void) const { return _image; }
+
+    /// 0 is full time resolution, levelCount() - 1 shows the whole file
+    void setLevel       (int level);
+
+    /// Start of the view as a fraction of the file
+    void setPosition    (double position);
+
+    static bool isCaptureFile(const QString& fileName);
+
+    static constexpr int        viewRows            = SpectrogramPyramid::tileRows;
+    static constexpr uint32_t   sampleRateHz        = 375000;   ///< Raw SDR rate, same as the channelizer setup in TagDatabase
+    static constexpr int        maxCacheBytes       = 32 * 1024 * 1024;
+    static constexpr const char* imageProviderId    = "captureViewer";
+
+signals:
+    void captureFilesChanged    (void);
+    void fileChanged            (void);
+    void viewChanged            (void);
+    void imageChanged           (void);
+    void busyChanged            (bool busy);
+    void errorStringChanged     (const QString& errorString);
+
+private slots:
+    void _listDirectoryComplete (const QStringList& dirList, const QString& errorMsg);
+    void _readFileRangeComplete (const QString& file, uint32_t offset, const QByteArray& data, uint32_t fileSize, const QString& errorMsg);
+    void _fetchNext             (void);
+
+private:
+    FTPManager* _activeFTPManager   (void);
+    qint64      _firstViewRow       (void) const;
+    bool        _readRange          (uint32_t offset, uint32_t size);
+    void        _setBusy            (bool busy);
+    void        _setErrorString     (const QString& errorString);
+    void        _scheduleUpdate     (void);
+    void        _disconnectFTP      (void);
+
+    QStringList                         _captureFiles;
+    QString                             _fileName;
+    QString                             _filePathOnVehicle;
+    qint64                              _fileSize           = 0;
+    QScopedPointer<SpectrogramPyramid>  _pyramid;
+    QPointer<FTPManager>                _ftpManager;
+
+    int                                 _level              = 0;
+    double                              _position           = 0;
+
+    bool                                _fetchInProgress    = false;
+    SpectrogramPyramid::Fetch_t         _pendingFetch;
+    int                                 _cFetchErrors       = 0;
+    qint64                              _bytesRead          = 0;
+    bool                                _busy               = false;
+    QString                             _errorString;
+    QTimer                              _retryTimer;
+
+    QImage                              _image;
+    uint32_t                            _revision           = 0;
+    QTimer                              _updateTimer;
+
+    static constexpr int _maxFetchErrors    = 3;
+    static constexpr int _retryMsecs        = 500;
+    static constexpr int _updateMsecs       = 250;
+};
+
+/// Serves the current capture view to QML as image://captureViewer/<revision>
+class CaptureViewerImageProvider : public QQuickImageProvider
+{
+public:
+    CaptureViewerImageProvider(CaptureViewer* captureViewer);
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) final;
+
+private:
+    CaptureViewer* _captureViewer;
+};
@@ -0,0 +1,113 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Dialogs
+import QtQuick.Layouts
+
+import QGroundControl
+import QGroundControl.Controls
+import QGroundControl.Palette
+import QGroundControl.ScreenTools
+
+/// Streams a raw capture or spectrogram segment from a controller log directory and shows it as a spectrogram
+QGCPopupDialog {
+    id:         root
+    title:      qsTr("Captures - %1").arg(logDir)
+    buttons:    Dialog.Close
+
+    property string logDir
+
+    property var    _captureViewer: QGroundControl.corePlugin.captureViewer
+
+    Component.onCompleted:  _captureViewer.listCaptures(logDir)
+    onClosed:               _captureViewer.close()
+
+    RowLayout {
+        spacing: ScreenTools.defaultFontPixelWidth
+
+        ColumnLayout {
+            Layout.alignment:   Qt.AlignTop
+            spacing:            ScreenTools.defaultFontPixelHeight / 2
+
+            QGCLabel {
+                text:       qsTr("No captures found")
+                visible:    _captureViewer.captureFiles.length === 0
+            }
+
+            Repeater {
+                model: _captureViewer.captureFiles
+
+                QGCButton {
+                    Layout.fillWidth:   true
+                    text:               modelData
+                    checkable:          true
+                    checked:            _captureViewer.fileName === modelData
+                    onClicked:          _captureViewer.open(logDir, modelData)
+                }
+            }
+        }
+
+        ColumnLayout {
+            spacing:    ScreenTools.defaultFontPixelHeight / 2
+            visible:    _captureViewer.fileName !== ""
+
+            Image {
+                Layout.preferredWidth:  ScreenTools.defaultFontPixelWidth * 60
+                Layout.preferredHeight: ScreenTools.defaultFontPixelHeight * 25
+                source:                 _captureViewer.imageUrl
+                smooth:                 false
+                cache:                  false
+                fillMode:               Image.Stretch
+            }
+
+            QGCLabel {
+                text: qsTr("%1 - %2 to %3 secs of %4 secs - %5% loaded, %6 KB read").arg(_captureViewer.fileName)
+                        .arg((_captureViewer.position * _captureViewer.durationSecs).toFixed(2))
+                        .arg(((_captureViewer.position + _captureViewer.viewFraction) * _captureViewer.durationSecs).toFixed(2))
+                        .arg(_captureViewer.durationSecs.toFixed(2))
+                        .arg(Math.round(_captureViewer.coverage * 100))
+                        .arg(Math.round(_captureViewer.bytesRead / 1024))
+            }
+
+            RowLayout {
+                Layout.fillWidth:   true
+                spacing:            ScreenTools.defaultFontPixelWidth
+
+                QGCButton {
+                    text:       qsTr("Zoom In")
+                    enabled:    _captureViewer.level > 0
+                    onClicked:  _captureViewer.level = _captureViewer.level - 1
+                }
+
+                QGCButton {
+                    text:       qsTr("Zoom Out")
+                    enabled:    _captureViewer.level < _captureViewer.levelCount - 1
+                    onClicked:  _captureViewer.level = _captureViewer.level + 1
+                }
+
+                QGCSlider {
+                    Layout.fillWidth:   true
+                    from:               0
+                    to:                 Math.max(1 - _captureViewer.viewFraction, 0)
+                    value:              _captureViewer.position
+                    enabled:            _captureViewer.viewFraction < 1
+                    onMoved:            _captureViewer.position = value
+                }
+            }
+
+            QGCLabel {
+                text:       _captureViewer.errorString
+                visible:    _captureViewer.errorString !== ""
+                color:      QGroundControl.globalPalette.warningText
+            }
+        }
+    }
+}
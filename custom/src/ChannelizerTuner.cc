@@ -0,0 +1,273 @@
+#include "ChannelizerTuner.h"
+
+#include <QtConcurrent>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
+
+ChannelizerTuner::ChannelizerTuner(uint32_t sampleRateHz, uint32_t nChannels)
+    : _sampleRateHz     (sampleRateHz)
+    , _nChannels        (std::min(nChannels, maxChannels))
+    , _halfBwHz         (sampleRateHz / 2)
+    , _channelBwHz      (sampleRateHz / _nChannels)
+    , _halfChannelBwHz  (_channelBwHz / 2)
+    , _shoulderHz       (static_cast<uint32_t>(std::floor(_halfChannelBwHz * _shoulderPercent)))
+{
+
+}
+
+// Returns the average distance from channel center for the candidate, or _invalidScore if the candidate is not usable.
+// This is the hot loop of the search so it works on raw buffers and does no allocations.
+uint32_t ChannelizerTuner::_scoreCandidate(const uint32_t* freqsHz, int cFreqs, uint32_t centerHz) const
+{
+    uint64_t    channelUsage[maxChannels / 64] = { 0, 0 };
+    uint64_t    distanceSumHz       = 0;
+    int64_t     firstChannelStartHz = static_cast<int64_t>(centerHz) - _halfChannelBwHz;
+
+    for (int i=0; i<cFreqs; i++) {
+        // If the requested frequency is below the center frequency channel, we add the sample rate to it.
+        // This simplifies channel calculations.
+        int64_t  wrappedFreqHz          = freqsHz[i] >= firstChannelStartHz ? freqsHz[i] : static_cast<int64_t>(freqsHz[i]) + _sampleRateHz;
+        uint32_t zeroBasedBandwidthHz   = static_cast<uint32_t>(wrappedFreqHz - firstChannelStartHz);
+        uint32_t zeroBasedChannel       = zeroBasedBandwidthHz / _channelBwHz;
+
+        if (zeroBasedChannel >= _nChannels) {
+            return _invalidScore;
+        }
+
+        // Only one frequency is allowed per channel
+        uint64_t& usageWord = channelUsage[zeroBasedChannel >> 6];
+        uint64_t  usageBit  = 1ull << (zeroBasedChannel & 63);
+        if (usageWord & usageBit) {
+            return _invalidScore;
+        }
+        usageWord |= usageBit;
+
+        uint32_t withinChannelHz            = zeroBasedBandwidthHz - (zeroBasedChannel * _channelBwHz);
+        uint32_t distanceFromChannelCenter  = withinChannelHz > _halfChannelBwHz ? withinChannelHz - _halfChannelBwHz : _halfChannelBwHz - withinChannelHz;
+
+        // Frequencies are not allowed to be in the shoulder of the channel
+        if (distanceFromChannelCenter > _shoulderHz) {
+            return _invalidScore;
+        }
+
+        distanceSumHz += distanceFromChannelCenter;
+    }
+
+    return static_cast<uint32_t>(distanceSumHz / static_cast<uint64_t>(cFreqs));
+}
+
+uint32_t ChannelizerTuner::_searchRange(const uint32_t* freqsHz, int cFreqs, uint32_t firstCenterHz, uint32_t stepSizeHz, uint32_t firstIndex, uint32_t endIndex, uint32_t& bestIndex) const
+{
+    uint32_t bestScore = _invalidScore;
+
+    for (uint32_t i=firstIndex; i<endIndex; i++) {
+        uint32_t score = _scoreCandidate(freqsHz, cFreqs, firstCenterHz + (i * stepSizeHz));
+        // Strictly less than so the lowest center wins ties
+        if (score < bestScore) {
+            bestScore = score;
+            bestIndex = i;
+        }
+    }
+
+    return bestScore;
+}
+
+// Candidate centers run from the min to max requested frequency. Only centers for which all requested frequencies fall
+// within the full bandwidth are usable. Since candidates are evenly spaced the usable ones form a contiguous range.
+bool ChannelizerTuner::_candidateRange(const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, uint32_t& firstCenterHz, uint32_t& cCandidates) const
+{
+    auto minMax = std::minmax_element(freqsHz.begin(), freqsHz.end());
+    uint32_t freqMinHz = *minMax.first;
+    uint32_t freqMaxHz = *minMax.second;
+
+    if (freqMaxHz - freqMinHz > _sampleRateHz) {
+        return false;
+    }
+
+    if (freqMinHz == freqMaxHz) {
+        firstCenterHz   = freqMaxHz;
+        cCandidates     = 1;
+        return true;
+    }
+
+    // Usable centers must satisfy: freqMax - halfBw <= center <= freqMin + halfBw
+    int64_t  lowestUsableHz     = static_cast<int64_t>(freqMaxHz) - _halfBwHz;
+    int64_t  highestUsableHz    = std::min(static_cast<int64_t>(freqMinHz) + _halfBwHz, static_cast<int64_t>(freqMaxHz));
+    uint32_t firstIndex         = 0;
+
+    if (lowestUsableHz > freqMinHz) {
+        firstIndex = static_cast<uint32_t>((lowestUsableHz - freqMinHz + stepSizeHz - 1) / stepSizeHz);
+    }
+    firstCenterHz = freqMinHz + (firstIndex * stepSizeHz);
+    if (firstCenterHz > highestUsableHz) {
+        cCandidates = 0;
+        return true;
+    }
+    cCandidates = static_cast<uint32_t>((highestUsableHz - firstCenterHz) / stepSizeHz) + 1;
+
+    return true;
+}
+
+bool ChannelizerTuner::tune(const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, bool multiThreaded, Result_t& result) const
+{
+    if (freqsHz.isEmpty() || stepSizeHz == 0) {
+        return false;
+    }
+
+    uint32_t firstCenterHz;
+    uint32_t cCandidates;
+    if (!_candidateRange(freqsHz, stepSizeHz, firstCenterHz, cCandidates) || cCandidates == 0) {
+        return false;
+    }
+
+    const uint32_t* rawFreqsHz  = freqsHz.constData();
+    int             cFreqs      = freqsHz.count();
+    uint32_t        bestIndex   = 0;
+    uint32_t        bestScore   = _invalidScore;
+    int             cThreads    = multiThreaded ? QThreadPool::globalInstance()->maxThreadCount() : 1;
+
+    if (cThreads <= 1 || cCandidates < _minCandidatesPerThread * 2) {
+        bestScore = _searchRange(rawFreqsHz, cFreqs, firstCenterHz, stepSizeHz, 0, cCandidates, bestIndex);
+    } else {
+        typedef struct {
+            uint32_t firstIndex;
+            uint32_t endIndex;
+            uint32_t bestIndex;
+            uint32_t bestScore;
+        } Chunk_t;
+
+        uint32_t cChunks            = std::min(static_cast<uint32_t>(cThreads), cCandidates / _minCandidatesPerThread);
+        uint32_t candidatesPerChunk = (cCandidates + cChunks - 1) / cChunks;
+
+        QVector<Chunk_t> chunks(cChunks);
+        for (uint32_t i=0; i<cChunks; i++) {
+            chunks[i].firstIndex    = i * candidatesPerChunk;
+            chunks[i].endIndex      = std::min(cCandidates, chunks[i].firstIndex + candidatesPerChunk);
+            chunks[i].bestIndex     = 0;
+            chunks[i].bestScore     = _invalidScore;
+        }
+
+        QtConcurrent::blockingMap(chunks, [this, rawFreqsHz, cFreqs, firstCenterHz, stepSizeHz](Chunk_t& chunk) {
+            chunk.bestScore = _searchRange(rawFreqsHz, cFreqs, firstCenterHz, stepSizeHz, chunk.firstIndex, chunk.endIndex, chunk.bestIndex);
+        });
+
+        // Chunks are in center frequency order so strictly less than keeps the lowest center on ties
+        for (const Chunk_t& chunk: chunks) {
+            if (chunk.bestScore < bestScore) {
+                bestScore = chunk.bestScore;
+                bestIndex = chunk.bestIndex;
+            }
+        }
+    }
+
+    if (bestScore == _invalidScore) {
+        return false;
+    }
+
+    _fillResult(freqsHz, firstCenterHz + (bestIndex * stepSizeHz), bestScore, result);
+
+    return true;
+}
+
+bool ChannelizerTuner::bruteForceTune(const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, Result_t& result) const
+{
+    if (freqsHz.isEmpty() || stepSizeHz == 0) {
+        return false;
+    }
+
+    uint32_t freqMaxHz = *std::max_element(freqsHz.begin(), freqsHz.end());
+    uint32_t freqMinHz = *std::min_element(freqsHz.begin(), freqsHz.end());
+
+    if (freqMaxHz - freqMinHz > _sampleRateHz) {
+        return false;
+    }
+
+    QVector<uint32_t> testCentersHz;
+    if (freqMinHz == freqMaxHz) {
+        testCentersHz.append(freqMaxHz);
+    } else {
+        for (uint64_t testCenterHz = freqMinHz; testCenterHz <= freqMaxHz; testCenterHz += stepSizeHz) {
+            if (static_cast<int64_t>(freqMinHz) < static_cast<int64_t>(testCenterHz) - _halfBwHz || freqMaxHz > testCenterHz + _halfBwHz) {
+                continue;
+            }
+            testCentersHz.append(static_cast<uint32_t>(testCenterHz));
+        }
+    }
+
+    uint32_t bestScore      = _invalidScore;
+    uint32_t bestCenterHz   = 0;
+
+    for (uint32_t testCenterHz: testCentersHz) {
+        QVector<uint32_t>   channelUsageCounts(_nChannels, 0);
+        QVector<uint32_t>   distancesFromCenter;
+        bool                inShoulder = false;
+
+        for (uint32_t freqHz: freqsHz) {
+            int64_t wrappedFreqHz   = freqHz >= static_cast<int64_t>(testCenterHz) - _halfChannelBwHz ? freqHz : static_cast<int64_t>(freqHz) + _sampleRateHz;
+            int64_t zeroBasedHz     = wrappedFreqHz - (static_cast<int64_t>(testCenterHz) - _halfChannelBwHz);
+            int64_t channel         = zeroBasedHz / _channelBwHz;
+            int64_t withinChannelHz = zeroBasedHz - (channel * _channelBwHz);
+            int64_t distance        = std::abs(withinChannelHz - static_cast<int64_t>(_halfChannelBwHz));
+
+            if (channel >= _nChannels) {
+                inShoulder = true;
+                break;
+            }
+            channelUsageCounts[channel]++;
+            distancesFromCenter.append(static_cast<uint32_t>(distance));
+            if (distance > _halfChannelBwHz * _shoulderPercent) {
+                inShoulder = true;
+            }
+        }
+
+        if (inShoulder || std::any_of(channelUsageCounts.begin(), channelUsageCounts.end(), [](uint32_t n) { return n > 1; })) {
+            continue;
+        }
+
+        uint64_t distanceSum = 0;
+        for (uint32_t distance: distancesFromCenter) {
+            distanceSum += distance;
+        }
+        uint32_t score = static_cast<uint32_t>(distanceSum / distancesFromCenter.count());
+        if (score < bestScore) {
+            bestScore       = score;
+            bestCenterHz    = testCenterHz;
+        }
+    }
+
+    if (bestScore == _invalidScore) {
+        return false;
+    }
+
+    _fillResult(freqsHz, bestCenterHz, bestScore, result);
+
+    return true;
+}
+
+void ChannelizerTuner::_fillResult(const QVector<uint32_t>& freqsHz, uint32_t centerHz, uint32_t averageDistanceHz, Result_t& result) const
+{
+    int64_t firstChannelStartHz = static_cast<int64_t>(centerHz) - _halfChannelBwHz;
+
+    result.centerHz                     = centerHz;
+    result.averageDistanceFromCenterHz  = averageDistanceHz;
+
+    result.oneBasedChannels.resize(freqsHz.count());
+    for (int i=0; i<freqsHz.count(); i++) {
+        int64_t wrappedFreqHz = freqsHz[i] >= firstChannelStartHz ? freqsHz[i] : static_cast<int64_t>(freqsHz[i]) + _sampleRateHz;
+        result.oneBasedChannels[i] = static_cast<uint32_t>((wrappedFreqHz - firstChannelStartHz) / _channelBwHz) + 1;
+    }
+
+    result.channelCentersHz.resize(_nChannels);
+    uint32_t nextCenterHz = centerHz;
+    for (uint32_t i=0; i<_nChannels; i++) {
+        if (i > _nChannels / 2) {
+            // Deal with odd matlab channel wrap-around
+            result.channelCentersHz[i] = nextCenterHz - _sampleRateHz;
+        } else {
+            result.channelCentersHz[i] = nextCenterHz;
+        }
+        nextCenterHz += _channelBwHz;
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QVector>
+
+#include <cstdint>
+
+/// Finds the best radio center frequency for a set of tag frequencies such that there is only one tag per channelizer
+/// channel, no tag falls within the shoulder of a channel and tags are on average as close to their channel center
+/// as possible.
+///
+/// The channel structure follows the functionality of Matlab dsp.channelizer. Channel numbers are 1-based to follow
+/// Matlab's 1-based vector/array indexing. Channel 1 is centered at the radio center frequency. The remainder of the
+/// channels follow and wrap around back to the beginning of the bandwidth.
+class ChannelizerTuner
+{
+public:
+    typedef struct {
+        uint32_t            centerHz                    = 0;
+        uint32_t            averageDistanceFromCenterHz = 0;
+        QVector<uint32_t>   oneBasedChannels;           ///< Channel for each requested frequency, same order as request
+        QVector<uint32_t>   channelCentersHz;           ///< Center frequency for each zero-based channel index
+    } Result_t;
+
+    ChannelizerTuner(uint32_t sampleRateHz, uint32_t nChannels);
+
+    /// Searches all candidate centers from the min to max requested frequency
+    ///     @param freqsHz      Requested tag frequencies
+    ///     @param stepSizeHz   Step between candidate centers
+    ///     @param multiThreaded true: Candidates are split across the global thread pool
+    ///     @param result[out]  Best center information
+    /// @return false: no valid center frequency exists
+    bool tune(const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, bool multiThreaded, Result_t& result) const;
+
+    /// Straightforward reference implementation of tune. Used to validate the optimized search.
+    bool bruteForceTune(const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, Result_t& result) const;
+
+    uint32_t sampleRateHz   (void) const { return _sampleRateHz; }
+    uint32_t channelBwHz    (void) const { return _channelBwHz; }
+
+    static constexpr uint32_t maxChannels = 128;
+
+private:
+    static constexpr uint32_t _invalidScore = UINT32_MAX;
+
+    uint32_t    _scoreCandidate     (const uint32_t* freqsHz, int cFreqs, uint32_t centerHz) const;
+    uint32_t    _searchRange        (const uint32_t* freqsHz, int cFreqs, uint32_t firstCenterHz, uint32_t stepSizeHz, uint32_t firstIndex, uint32_t endIndex, uint32_t& bestIndex) const;
+    void        _fillResult         (const QVector<uint32_t>& freqsHz, uint32_t centerHz, uint32_t averageDistanceHz, Result_t& result) const;
+    bool        _candidateRange     (const QVector<uint32_t>& freqsHz, uint32_t stepSizeHz, uint32_t& firstCenterHz, uint32_t& cCandidates) const;
+
+    uint32_t    _sampleRateHz;
+    uint32_t    _nChannels;
+    uint32_t    _halfBwHz;
+    uint32_t    _channelBwHz;
+    uint32_t    _halfChannelBwHz;
+    uint32_t    _shoulderHz;
+
+    static constexpr double     _shoulderPercent            = 0.85; // Shoulder is 15% from channel edge
+    static constexpr uint32_t   _minCandidatesPerThread     = 2048;
+};
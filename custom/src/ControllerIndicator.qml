@@ -29,6 +29,7 @@ Item {
     property bool showIndicator: true
 
     property var    activeVehicle:  QGroundControl.multiVehicleManager.activeVehicle
+    property var    activeSession:  QGroundControl.corePlugin.activeSession
     property real   maxStrength:         QGroundControl.corePlugin.customSettings.maxPulseStrength.rawValue
 
     Row {
@@ -40,11 +41,11 @@ Item {
         Rectangle {
             height: parent.height
             width:  ScreenTools.defaultFontPixelWidth * 3
-            color:  QGroundControl.corePlugin.controllerLostHeartbeat ? "red" : "green"
+            color:  !activeSession || activeSession.controllerLostHeartbeat ? "red" : "green"
 
             QGCLabel {
                 anchors.fill:           parent
-                text:                   QGroundControl.corePlugin.controllerCPUTemp.toFixed(0)
+                text:                   activeSession ? activeSession.controllerCPUTemp.toFixed(0) : ""
                 color:                  "black"
                 horizontalAlignment:    Text.AlignHCenter
                 verticalAlignment:      Text.AlignVCenter
@@ -56,7 +57,7 @@ Item {
             spacing:    2
 
             Repeater {
-                model: QGroundControl.corePlugin.detectorInfoList
+                model: activeSession ? activeSession.detectorInfoList : 0
 
                 RowLayout {
                     property real filteredSNR: Math.max(0, Math.min(object.lastPulseStrength, maxStrength))
@@ -320,6 +321,12 @@ Item {
         }
     }
 
+    Component {
+        id: pipelineTelemetryDialogComponent
+
+        PipelineTelemetryDialog { }
+    }
+
     Component {
         id: indciatorContentComponent
 
@@ -344,6 +351,12 @@ Item {
                     onClicked:  manufacturersDialogComponent.createObject(mainWindow).open()
                 }
 
+                QGCButton {
+                    text:       qsTr("Telemetry")
+                    visible:    activeSession
+                    onClicked:  pipelineTelemetryDialogComponent.createObject(mainWindow, { session: activeSession }).open()
+                }
+
                 QGCButton {
                     text:       qsTr("New Tag")
                     onClicked: { 
@@ -415,6 +428,49 @@ Item {
                     }
                 }
             }
+
+            RowLayout {
+                spacing: ScreenTools.defaultFontPixelWidth
+                visible: activeSession
+
+                QGCLabel { text: qsTr("Pulse History") }
+
+                QGCComboBox {
+                    id:             historyMetricCombo
+                    sizeToContents: true
+                    model:          [ qsTr("SNR"), qsTr("STFT Score"), qsTr("Noise PSD") ]
+                }
+
+                QGCComboBox {
+                    id:             historyWindowCombo
+                    sizeToContents: true
+                    model:          [ qsTr("1 min"), qsTr("10 min"), qsTr("Session") ]
+
+                    property var windowSecs: [ 60, 600, 0 ]
+                }
+            }
+
+            Repeater {
+                model: activeSession ? activeSession.detectorInfoList : 0
+
+                RowLayout {
+                    spacing: ScreenTools.defaultFontPixelWidth
+
+                    QGCLabel {
+                        Layout.preferredWidth:  ScreenTools.defaultFontPixelWidth * 6
+                        text:                   object.tagId + object.tagLabel[0]
+                    }
+
+                    PulseHistoryChart {
+                        Layout.preferredWidth:  ScreenTools.defaultFontPixelWidth * 50
+                        Layout.preferredHeight: ScreenTools.defaultFontPixelHeight * 3
+                        pulseHistory:           activeSession.pulseHistory
+                        tagId:                  object.tagId
+                        metric:                 historyMetricCombo.currentIndex
+                        windowSecs:             historyWindowCombo.windowSecs[historyWindowCombo.currentIndex]
+                    }
+                }
+            }
         }
     }
 
@@ -440,6 +496,16 @@ Item {
                 fact:   _customSettings.showPulseOnMap
             }
 
+            FactCheckBox {
+                text:   qsTr("Adaptive rotation dwell")
+                fact:   _customSettings.rotationAdaptiveDwell
+            }
+
+            FactCheckBox {
+                text:   qsTr("Continuous rotation")
+                fact:   _customSettings.rotationContinuous
+            }
+
             FactTextFieldGrid {
                 id: grid
 
@@ -450,9 +516,23 @@ Item {
                     _customSettings.falseAlarmProbability,
                     _customSettings.maxPulseStrength,
                     _customSettings.antennaOffset,
+                    _customSettings.rotationKWaitCount,
+                    _customSettings.rotationAdaptiveMinDwellPct,
+                    _customSettings.rotationContinuousRate,
+                    _customSettings.rotationContinuousBins,
+                    _customSettings.pulseHeatMapResolution,
                 ]
             }
 
+            RowLayout {
+                QGCLabel { text: qsTr("Heat map cell strength") }
+                FactComboBox {
+                    fact:           _customSettings.pulseHeatMapMode
+                    indexModel:     false
+                    sizeToContents: true
+                }
+            }
+
             FactComboBox {
                 fact:           QGroundControl.corePlugin.customSettings.sdrType
                 indexModel:     false
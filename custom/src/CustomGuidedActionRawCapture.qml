@@ -14,6 +14,8 @@ GuidedToolStripAction {
     text:       _guidedController.rawCaptureTitle
     iconSource: "/res/action.svg"
     visible:    true
-    enabled:    QGroundControl.multiVehicleManager.activeVehicle && QGroundControl.corePlugin.controllerStatus == CustomPlugin.ControllerStatusHasTags
+    enabled:    _activeSession && _activeSession.controllerStatus == CustomPlugin.ControllerStatusHasTags
     actionID:   _guidedController.actionRawCapture
+
+    property var _activeSession: QGroundControl.corePlugin.activeSession
 }
@@ -18,7 +18,8 @@ GuidedToolStripAction {
     actionID:   _guidedController.actionSendTags
 
     property bool actionEnabled: true
-    property var controllerStatus: QGroundControl.corePlugin.controllerStatus
+    property var controllerStatus: _activeSession ? _activeSession.controllerStatus : CustomPlugin.ControllerStatusIdle
+    property var _activeSession:  QGroundControl.corePlugin.activeSession
 
     onControllerStatusChanged: _update(controllerStatus)
 
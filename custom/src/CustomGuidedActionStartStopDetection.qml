@@ -21,7 +21,8 @@ GuidedToolStripAction {
     actionID:   _guidedController.actionStartDetection
 
     property bool actionEnabled: false
-    property var controllerStatus: QGroundControl.corePlugin.controllerStatus
+    property var controllerStatus: _activeSession ? _activeSession.controllerStatus : CustomPlugin.ControllerStatusIdle
+    property var _activeSession:  QGroundControl.corePlugin.activeSession
 
     onControllerStatusChanged: _update(controllerStatus)
 
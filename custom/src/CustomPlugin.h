@@ -10,14 +10,16 @@
 #include "CustomSettings.h"
 #include "FactSystem.h"
 #include "TunnelProtocol.h"
-#include "DetectorInfoListModel.h"
 #include "TagDatabase.h"
+#include "TagTrackerSession.h"
+#include "TagTriangulator.h"
+#include "PulseHeatMap.h"
+#include "CaptureViewer.h"
 
-#include <QElapsedTimer>
 #include <QGeoCoordinate>
-#include <QTimer>
 #include <QLoggingCategory>
 #include <QFile>
+#include <QMap>
 
 Q_DECLARE_LOGGING_CATEGORY(CustomPluginLog)
 
@@ -45,24 +47,30 @@ public:
     };
 
     Q_PROPERTY(CustomSettings*      customSettings          READ    customSettings              CONSTANT)
-    Q_PROPERTY(QList<QList<double>> angleRatios             MEMBER  _rgAngleRatios              NOTIFY angleRatiosChanged)
-    Q_PROPERTY(QList<double>        calcedBearings          MEMBER  _rgCalcedBearings           NOTIFY calcedBearingsChanged)
-    Q_PROPERTY(bool                 flightMachineActive     MEMBER  _flightStateMachineActive   NOTIFY flightMachineActiveChanged)
-    Q_PROPERTY(bool                 controllerLostHeartbeat MEMBER  _controllerLostHeartbeat    NOTIFY controllerLostHeartbeatChanged)
-    Q_PROPERTY(int                  controllerStatus        MEMBER  _controllerStatus           NOTIFY controllerStatusChanged)
-    Q_PROPERTY(float                controllerCPUTemp       MEMBER  _controllerCPUTemp          NOTIFY controllerCPUTempChanged)
-    Q_PROPERTY(QmlObjectListModel*  detectorInfoList        READ    detectorInfoList            CONSTANT)
     Q_PROPERTY(TagDatabase*         tagDatabase             MEMBER  _tagDatabase                CONSTANT)
+    Q_PROPERTY(TagTrackerSession*   activeSession           MEMBER  _activeSession              NOTIFY activeSessionChanged)
+    Q_PROPERTY(TagTriangulator*     triangulator            READ    triangulator                CONSTANT)
+    Q_PROPERTY(PulseHeatMap*        pulseHeatMap            MEMBER  _pulseHeatMap               CONSTANT)
+    Q_PROPERTY(CaptureViewer*       captureViewer           MEMBER  _captureViewer              CONSTANT)
 
     CustomSettings*     customSettings  () { return _customSettings; }
-    QmlObjectListModel* detectorInfoList() { return dynamic_cast<QmlObjectListModel*>(&_detectorInfoListModel); }
+    TagDatabase*        tagDatabase     () { return _tagDatabase; }
+    TagTriangulator*    triangulator    () { return &_triangulator; }
+    PulseHeatMap*       pulseHeatMap    () { return _pulseHeatMap; }
+    int                 sessionCount    () const { return _sessions.count(); }
+    QString             logSavePath     (void);
+    void                say             (const QString& text);
 
+    static QString tunnelCommandIdToText(uint32_t command);
+
+    // These operate on the session for the active vehicle
     Q_INVOKABLE void startRotation      (void);
     Q_INVOKABLE void cancelAndReturn    (void);
     Q_INVOKABLE void sendTags           (void);
     Q_INVOKABLE void startDetection     (void);
     Q_INVOKABLE void stopDetection      (void);
     Q_INVOKABLE void rawCapture         (void);
+
     Q_INVOKABLE void downloadLogDirList (void);
     Q_INVOKABLE void downloadLogDirFiles(const QString& dirPath);
     Q_INVOKABLE void captureScreen      (void);
@@ -73,125 +81,42 @@ public:
     bool                adjustSettingMetaData   (const QString& settingsGroup, FactMetaData& metaData) final;
     QmlObjectListModel* customMapItems          (void) final;
     const QVariantList& toolBarIndicators       (void) final;
+    QQmlApplicationEngine* createQmlApplicationEngine(QObject* parent) final;
 
     // Overrides from QGCTool
     void setToolbox(QGCToolbox* toolbox) final;
 
 signals:
-    void angleRatiosChanged             (void);
-    void calcedBearingsChanged          (void);
-    void flightMachineActiveChanged     (bool flightMachineActive);
-    void pulseInfoListsChanged          (void);
-    void controllerLostHeartbeatChanged ();
-    void controllerStatusChanged        ();
-    void controllerCPUTempChanged       ();
+    void activeSessionChanged           (void);
     void logDirListDownloaded           (const QStringList& dirList, const QString& errorMsg);
     void downloadLogDirFilesComplete    (const QString& errorMsg);
 
 private slots:
-    void _vehicleStateRawValueChanged   (QVariant rawValue);
-    void _advanceStateMachine           (void);
-    void _vehicleStateTimeout           (void);
-    void _updateFlightMachineActive     (bool flightMachineActive);
-    void _mavCommandResult              (int vehicleId, int component, int command, int result, bool noResponseFromVehicle);
-    void _tunnelCommandAckFailed        (void);
-    void _controllerHeartbeatFailed     (void);
+    void _activeVehicleChanged          (Vehicle* activeVehicle);
+    void _vehicleRemoved                (Vehicle* vehicle);
     void _logDirListDownloaded          (const QStringList& dirList, const QString& errorMsg);
     void _logDirDownloadedForFiles      (const QStringList& dirList, const QString& errorMsg);
-    void _logFileDownloadComplete       (const QString& file, const QString& errorMsg);
+    void _logFilesDownloadComplete      (const QString& errorMsg);
 
 private:
-    typedef enum {
-        CommandTakeoff,
-        CommandSetHeading,
-        CommandWaitForHeartbeats,
-    } VehicleStateCommand_t;
-
-    typedef struct VehicleState_t {
-        VehicleStateCommand_t   command;
-        Fact*                   fact;
-        int                     targetValueWaitMsecs;
-        double                  targetValue;
-        double                  targetVariance;
-    } VehicleState_t;
-
-    typedef struct HeartbeatInfo_t {
-        bool    heartbeatLost               { true };
-        uint    heartbeatTimerInterval      { 0 };
-        QTimer  timer;
-        uint    rotationDelayHeartbeatCount { 0 };
-    } HeartbeatInfo_t;
-
-    void    _handleTunnelCommandAck     (const mavlink_tunnel_t& tunnel);
-    void    _handleTunnelPulse          (const mavlink_tunnel_t& tunnel);
-    void    _handleTunnelHeartbeat      (const mavlink_tunnel_t& tunnel);
-    void    _rotateVehicle              (Vehicle* vehicle, double headingDegrees);
-    void    _say                        (QString text);
-    bool    _armVehicleAndValidate      (Vehicle* vehicle);
-    bool    _setRTLFlightModeAndValidate(Vehicle* vehicle);
-    void    _sendCommandAndVerify       (Vehicle* vehicle, MAV_CMD command, double param1 = 0.0, double param2 = 0.0, double param3 = 0.0, double param4 = 0.0, double param5 = 0.0, double param6 = 0.0, double param7 = 0.0);
-    void    _takeoff                    (Vehicle* vehicle, double takeoffAltRel);
-    void    _resetStateAndRTL           (void);
-    int     _rawPulseToPct              (double rawPulse);
-    void    _sendTunnelCommand          (uint8_t* payload, size_t payloadSize);
-    QString _tunnelCommandIdToText      (uint32_t command);
-    double  _pulseTimeSeconds           (void) { return _lastPulseInfo.start_time_seconds; }
-    double  _pulseSNR                   (void) { return _lastPulseInfo.snr; }
-    bool    _pulseConfirmed             (void) { return _lastPulseInfo.confirmed_status; }
-    void    _sendNextTag                (void);
-    void    _sendEndTags                (void);
-    void    _setupDelayForSteadyCapture (void);
-    void    _rotationDelayComplete      (void);
-    QString _logSavePath             (void);
-    void    _csvStartFullPulseLog       (void);
-    void    _csvStopFullPulseLog        (void);
-    void    _csvClearPrevRotationLogs   (void);
-    void    _csvStartRotationPulseLog   (int rotationCount);
-    void    _csvStopRotationPulseLog    (bool calcBearing);
-    void    _csvLogPulse                (QFile& csvFile, const TunnelProtocol::PulseInfo_t& pulseInfo);
-    void    _csvLogRotationStartStop    (QFile& csvFile, bool startRotation);
-    void    _logFilesDownloadWorker     (void);
-    bool    _useSNRForPulseStrength     (void) { return _customSettings->useSNRForPulseStrength()->rawValue().toBool(); }
-    void    _captureScreen              (void);
+    TagTrackerSession*  _sessionForVehicleId    (int vehicleId);
+    TagTrackerSession*  _activeVehicleSession   (void);
+    void                _clearPrevRotationLogs  (void);
+    void                _captureScreen          (void);
 
     QVariantList            _settingsPages;
     QVariantList            _instrumentPages;
-    int                     _vehicleStateIndex;
-    QList<VehicleState_t>   _vehicleStates;
-    QList<QList<double>>    _rgAngleStrengths;
-    QList<QList<double>>    _rgAngleRatios;
-    QList<double>           _rgCalcedBearings;
-    bool                    _flightStateMachineActive;
-    int                     _currentSlice;
-    int                     _cSlice;
-    int                     _detectionStatus    = -1;
-    bool                    _retryRotation      = false;
-    int                     _controllerStatus   = ControllerStatusIdle;
-    float                   _controllerCPUTemp  = 0.0;
-    int                     _nextTagIndexToSend = 0;
-
-    QTimer                  _vehicleStateTimeoutTimer;
-    QTimer                  _tunnelCommandAckTimer;
-    uint32_t                _tunnelCommandAckExpected;
-    CustomOptions*          _customOptions;
-    CustomSettings*         _customSettings;
-    int                     _vehicleFrequency;
-    int                     _lastPulseSendIndex;
-    int                     _missedPulseCount;
+    CustomOptions*          _customOptions      = nullptr;
+    CustomSettings*         _customSettings     = nullptr;
     QmlObjectListModel      _customMapItems;
-    QFile                   _csvFullPulseLogFile;
-    QFile                   _csvRotationPulseLogFile;
-    int                     _csvRotationCount = 1;
-    TunnelProtocol::PulseInfo_t _lastPulseInfo;
-
-    DetectorInfoListModel   _detectorInfoListModel;
+    TagDatabase*            _tagDatabase        = nullptr;
 
-    TagDatabase*             _tagDatabase = nullptr;
+    QMap<int, TagTrackerSession*>   _sessions;                  ///< Keyed by vehicle id
+    TagTrackerSession*              _activeSession  = nullptr;  ///< Session for the active vehicle
+    TagTriangulator                 _triangulator;              ///< Combines the bearings from all sessions
+    PulseHeatMap*                   _pulseHeatMap   = nullptr;  ///< Pulses from all sessions
+    CaptureViewer*                  _captureViewer  = nullptr;
 
-    bool                    _controllerLostHeartbeat { true };
-    QTimer                  _controllerHeartbeatTimer;
-
-    int                     _curLogFileDownloadIndex;
     QString                 _logDirPathOnVehicle;
     QStringList             _logFileDownloadList;
 };
@@ -200,45 +125,61 @@ class PulseRoseMapItem : public QObject
 {
     Q_OBJECT
 
-    Q_PROPERTY(QString          url             MEMBER _url             CONSTANT)
-    Q_PROPERTY(int              rotationIndex   MEMBER _rotationIndex   CONSTANT)
-    Q_PROPERTY(QGeoCoordinate   rotationCenter  MEMBER _rotationCenter  CONSTANT)
+    Q_PROPERTY(QString              url             MEMBER _url             CONSTANT)
+    Q_PROPERTY(TagTrackerSession*   session         MEMBER _session         CONSTANT)
+    Q_PROPERTY(int                  rotationIndex   MEMBER _rotationIndex   CONSTANT)
+    Q_PROPERTY(QGeoCoordinate       rotationCenter  MEMBER _rotationCenter  CONSTANT)
 
 public:
-    PulseRoseMapItem(QUrl& itemUrl, int rotationIndex, QGeoCoordinate rotationCenter, QObject* parent)
+    PulseRoseMapItem(QUrl& itemUrl, TagTrackerSession* session, int rotationIndex, QGeoCoordinate rotationCenter, QObject* parent)
         : QObject(parent)
         , _url(itemUrl.toString())
+        , _session(session)
         , _rotationIndex(rotationIndex)
         , _rotationCenter(rotationCenter)
     { }
 
 private:
-    QString         _url;
-    int             _rotationIndex;
-    QGeoCoordinate  _rotationCenter;
+    QString             _url;
+    TagTrackerSession*  _session;
+    int                 _rotationIndex;
+    QGeoCoordinate      _rotationCenter;
 };
 
-class PulseMapItem : public QObject
+class PulseHeatMapItem : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY(QString          url         MEMBER _url         CONSTANT)
-    Q_PROPERTY(QGeoCoordinate   coordinate  MEMBER _coordinate  CONSTANT)
-    Q_PROPERTY(uint             tagId       MEMBER _tagId       CONSTANT)
-    Q_PROPERTY(double           snr         MEMBER _snr         CONSTANT)
+    Q_PROPERTY(PulseHeatMap*    heatMap     MEMBER _heatMap     CONSTANT)
 
 public:
-    PulseMapItem(QUrl& itemUrl, QGeoCoordinate coordinate, uint tagId, double snr, QObject* parent)
+    PulseHeatMapItem(QUrl& itemUrl, PulseHeatMap* heatMap, QObject* parent)
+        : QObject   (parent)
+        , _url      (itemUrl.toString())
+        , _heatMap  (heatMap)
+    { }
+
+private:
+    QString         _url;
+    PulseHeatMap*   _heatMap;
+};
+
+class TriangulationMapItem : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(QString          url             MEMBER _url             CONSTANT)
+    Q_PROPERTY(TagTriangulator* triangulator    MEMBER _triangulator    CONSTANT)
+
+public:
+    TriangulationMapItem(QUrl& itemUrl, TagTriangulator* triangulator, QObject* parent)
         : QObject       (parent)
         , _url          (itemUrl.toString())
-        , _coordinate   (coordinate)
-        , _tagId        (tagId)
-        , _snr          (snr)
+        , _triangulator (triangulator)
     { }
 
 private:
-    QString         _url;
-    QGeoCoordinate  _coordinate;
-    uint            _tagId;
-    double          _snr;
+    QString             _url;
+    TagTriangulator*    _triangulator;
 };
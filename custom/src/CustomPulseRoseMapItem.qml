@@ -28,11 +28,11 @@ MapQuickItem {
     property var    _activeVehicle: QGroundControl.multiVehicleManager.activeVehicle
     property var    _flightMap:     parent
     property var    _corePlugin:    QGroundControl.corePlugin
-    property var    _vhfSettings:   _corePlugin.customSettings
-    property var    _divisions:     _vhfSettings.divisions.rawValue
-    property real   _sliceSize:     360 / _divisions
+    property var    _session:       customMapObject.session
     property int    _rotationIndex: customMapObject.rotationIndex
-    property real   _ratio:         _corePlugin.angleRatios.length - 1 == _rotationIndex ? _largeRatio : _smallRatio
+    property int    _divisions:     _session.angleRatios[_rotationIndex].length
+    property real   _sliceSize:     360 / _divisions
+    property real   _ratio:         _session.angleRatios.length - 1 == _rotationIndex ? _largeRatio : _smallRatio
 
     readonly property real _largeRatio: 0.5
     readonly property real _smallRatio: 0.3
@@ -78,15 +78,23 @@ MapQuickItem {
                 property real centerX:          width / 2
                 property real centerY:          height / 2
                 property real arcRadians:       (Math.PI * 2) / _divisions
-                property real strengthRatio:    _corePlugin.angleRatios[_rotationIndex][index]
+                property real strengthRatio:    _session.angleRatios[_rotationIndex][index]
 
                 Connections {
-                    target:                 _corePlugin
+                    target:                 _session
                     onAngleRatiosChanged:   arcCanvas.requestPaint()
                 }
             }
         }
 
+        QGCLabel {
+            anchors.horizontalCenter:   parent.horizontalCenter
+            anchors.top:                parent.bottom
+            text:                       qsTr("Vehicle %1").arg(_session.vehicleId)
+            color:                      mapPal.text
+            visible:                    QGroundControl.multiVehicleManager.vehicles.count > 1
+        }
+
         Rectangle {
             id:             calcedBearingIndicator
             width:          radius * 2
@@ -104,7 +112,7 @@ MapQuickItem {
                 angle:      isNaN(calcedBearingIndicator._calcedBearing) ? 0 : calcedBearingIndicator._calcedBearing
             }
 
-            property real _calcedBearing: _corePlugin.calcedBearings[_rotationIndex]
+            property real _calcedBearing: _session.calcedBearings[_rotationIndex]
             property real _radius:        ScreenTools.defaultFontPixelWidth * 4
 
             QGCLabel {
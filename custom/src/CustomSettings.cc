@@ -27,3 +27,12 @@ DECLARE_SETTINGSFACT(CustomSettings, showPulseOnMap)
 DECLARE_SETTINGSFACT(CustomSettings, antennaOffset)
 DECLARE_SETTINGSFACT(CustomSettings, rotationKWaitCount)
 DECLARE_SETTINGSFACT(CustomSettings, useSNRForPulseStrength)
+DECLARE_SETTINGSFACT(CustomSettings, bearingCsvCrossCheck)
+DECLARE_SETTINGSFACT(CustomSettings, channelizerTunerStepHz)
+DECLARE_SETTINGSFACT(CustomSettings, rotationAdaptiveDwell)
+DECLARE_SETTINGSFACT(CustomSettings, rotationAdaptiveMinDwellPct)
+DECLARE_SETTINGSFACT(CustomSettings, rotationContinuous)
+DECLARE_SETTINGSFACT(CustomSettings, rotationContinuousRate)
+DECLARE_SETTINGSFACT(CustomSettings, rotationContinuousBins)
+DECLARE_SETTINGSFACT(CustomSettings, pulseHeatMapResolution)
+DECLARE_SETTINGSFACT(CustomSettings, pulseHeatMapMode)
@@ -30,4 +30,13 @@ public:
     DEFINE_SETTINGFACT(antennaOffset)
     DEFINE_SETTINGFACT(rotationKWaitCount)
     DEFINE_SETTINGFACT(useSNRForPulseStrength)
+    DEFINE_SETTINGFACT(bearingCsvCrossCheck)
+    DEFINE_SETTINGFACT(channelizerTunerStepHz)
+    DEFINE_SETTINGFACT(rotationAdaptiveDwell)
+    DEFINE_SETTINGFACT(rotationAdaptiveMinDwellPct)
+    DEFINE_SETTINGFACT(rotationContinuous)
+    DEFINE_SETTINGFACT(rotationContinuousRate)
+    DEFINE_SETTINGFACT(rotationContinuousBins)
+    DEFINE_SETTINGFACT(pulseHeatMapResolution)
+    DEFINE_SETTINGFACT(pulseHeatMapMode)
 };
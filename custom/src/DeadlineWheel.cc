@@ -0,0 +1,101 @@
+#include "DeadlineWheel.h"
+
+#include <algorithm>
+
+DeadlineWheel::DeadlineWheel(int tickMsecs, int slotCount)
+    : _tickMsecs    (tickMsecs)
+    , _slots        (slotCount)
+{
+
+}
+
+void DeadlineWheel::reset(int idCount)
+{
+    for (QVector<int>& slot: _slots) {
+        slot.clear();
+    }
+    _deadlines.fill(-1, idCount);
+    _scheduledTicks.fill(-1, idCount);
+    _scheduledCount = 0;
+}
+
+void DeadlineWheel::setDeadline(int id, qint64 deadlineMsecs)
+{
+    _deadlines[id] = deadlineMsecs;
+
+    // Entries are allowed to sit in a slot which is earlier than their deadline, they get moved when the slot is
+    // processed. An entry only needs to be moved now if the new deadline is earlier than its slot.
+    qint64 tick = std::max(_tickForTime(deadlineMsecs), _currentTick + 1);
+    if (_scheduledTicks[id] < 0 || tick < _scheduledTicks[id]) {
+        _schedule(id, tick);
+    }
+}
+
+void DeadlineWheel::clearDeadline(int id)
+{
+    if (_scheduledTicks[id] >= 0) {
+        // The stale slot entry is skipped when it is processed
+        _scheduledTicks[id] = -1;
+        _scheduledCount--;
+    }
+    _deadlines[id] = -1;
+}
+
+QVector<int> DeadlineWheel::advance(qint64 nowMsecs)
+{
+    QVector<int>    expiredIds;
+    qint64          nowTick = _tickForTime(nowMsecs);
+
+    // After a long gap each slot only needs to be processed once
+    qint64 firstTick = std::max(_currentTick + 1, nowTick - _slots.count() + 1);
+
+    for (qint64 tick=firstTick; tick<=nowTick; tick++) {
+        _currentTick = tick;
+        _processSlot(tick, nowMsecs, expiredIds);
+    }
+    _currentTick = std::max(_currentTick, nowTick);
+
+    return expiredIds;
+}
+
+void DeadlineWheel::_schedule(int id, qint64 tick)
+{
+    // Entries are never more than one turn ahead. Later deadlines wait in the last slot of the turn and are moved
+    // along when it is processed. This means any entry in a slot whose tick doesn't match is stale.
+    tick = std::min(tick, _currentTick + _slots.count() - 1);
+
+    if (_scheduledTicks[id] < 0) {
+        _scheduledCount++;
+    }
+    _scheduledTicks[id] = tick;
+    _slots[tick % _slots.count()].append(id);
+}
+
+void DeadlineWheel::_processSlot(qint64 tick, qint64 nowMsecs, QVector<int>& expiredIds)
+{
+    int             slotIndex = tick % _slots.count();
+    QVector<int>    slot;
+
+    slot.swap(_slots[slotIndex]);
+
+    for (int id: slot) {
+        qint64 scheduledTick = _scheduledTicks[id];
+
+        // Skip entries which were cleared or moved to a different slot. A scheduled tick earlier than the current
+        // one is a live entry which was skipped over by a gap in advance calls.
+        if (scheduledTick < 0 || scheduledTick % _slots.count() != slotIndex || scheduledTick > tick) {
+            continue;
+        }
+
+        _scheduledTicks[id] = -1;
+        _scheduledCount--;
+
+        if (_deadlines[id] <= nowMsecs) {
+            _deadlines[id] = -1;
+            expiredIds.append(id);
+        } else {
+            // Deadline was pushed back since the entry was slotted
+            _schedule(id, std::max(_tickForTime(_deadlines[id]), tick + 1));
+        }
+    }
+}
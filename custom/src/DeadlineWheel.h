@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QVector>
+
+/// Hashed timer wheel for deadlines which are pushed back far more often than they expire, such as heartbeat
+/// timeouts. Moving a deadline later only stores the new value. The entry stays in its current slot and is moved
+/// to the slot for its new deadline when that slot comes around. This makes the common case constant time with no
+/// timer registration.
+///
+/// Deadlines further out than one turn of the wheel are carried forward a turn at a time.
+class DeadlineWheel
+{
+public:
+    DeadlineWheel(int tickMsecs, int slotCount);
+
+    /// Removes all deadlines and resizes for ids [0, idCount)
+    void    reset           (int idCount);
+
+    /// Sets or replaces the deadline for an id
+    void    setDeadline     (int id, qint64 deadlineMsecs);
+    void    clearDeadline   (int id);
+    bool    hasDeadline     (int id) const { return _deadlines[id] >= 0; }
+
+    /// Advances the wheel to the specified time
+    /// @return Ids whose deadlines have passed, these no longer have a deadline
+    QVector<int> advance    (qint64 nowMsecs);
+
+    bool    isEmpty         (void) const { return _scheduledCount == 0; }
+    int     tickMsecs       (void) const { return _tickMsecs; }
+
+private:
+    qint64  _tickForTime    (qint64 msecs) const { return msecs / _tickMsecs; }
+    void    _schedule       (int id, qint64 tick);
+    void    _processSlot    (qint64 tick, qint64 nowMsecs, QVector<int>& expiredIds);
+
+    int                     _tickMsecs;
+    QVector<QVector<int>>   _slots;
+    QVector<qint64>         _deadlines;         ///< -1 if no deadline
+    QVector<qint64>         _scheduledTicks;    ///< Tick of the slot which holds the live entry for the id, -1 if none
+    qint64                  _currentTick        = 0;
+    int                     _scheduledCount     = 0;
+};
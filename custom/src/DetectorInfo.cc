@@ -25,23 +25,9 @@ DetectorInfo::DetectorInfo(uint32_t tagId, const QString& tagLabel, uint32_t int
     , _intraPulseMsecs  (intraPulseMsecs)
     , _k                (k)
 {
-    _heartbeatTimerInterval = ((_k + 1) * intraPulseMsecs) + 1000;
+    _livenessTimeoutMsecs = ((_k + 1) * intraPulseMsecs) + 1000;
 
-    qDebug() << "DetectorInfo::DetectorInfo" << _tagId << _tagLabel << _intraPulseMsecs << _k << _heartbeatTimerInterval;
-
-    _heartbeatTimeoutTimer.setSingleShot(true);
-    _heartbeatTimeoutTimer.setInterval(_heartbeatTimerInterval);
-    _heartbeatTimeoutTimer.callOnTimeout([this]() {
-        _heartbeatLost = true;
-        emit heartbeatLostChanged();
-    });
-
-    _stalePulseStrengthTimer.setSingleShot(true);
-    _stalePulseStrengthTimer.setInterval(_heartbeatTimerInterval);
-    _stalePulseStrengthTimer.callOnTimeout([this]() {
-        _lastPulseStale = true;
-        emit lastPulseStaleChanged();
-    });
+    qDebug() << "DetectorInfo::DetectorInfo" << _tagId << _tagLabel << _intraPulseMsecs << _k << _livenessTimeoutMsecs;
 }
 
 DetectorInfo::~DetectorInfo()
@@ -49,48 +35,72 @@ DetectorInfo::~DetectorInfo()
 
 }
 
-void DetectorInfo::handleTunnelPulse(const mavlink_tunnel_t& tunnel)
+DetectorInfo::PulseType_t DetectorInfo::handlePulse(const PulseInfo_t& pulseInfo)
 {
-    if (tunnel.payload_length != sizeof(PulseInfo_t)) {
-        qWarning() << "handleTunnelPulse Received incorrectly sized PulseInfo payload expected:actual" <<  sizeof(PulseInfo_t) << tunnel.payload_length;
-    }
-
-    PulseInfo_t pulseInfo;
-    memcpy(&pulseInfo, tunnel.payload, sizeof(pulseInfo));
-
     bool isDetectorHeartbeat = pulseInfo.frequency_hz == 0;
 
-    if (pulseInfo.tag_id == _tagId) {
-        if (isDetectorHeartbeat) {
+    if (isDetectorHeartbeat) {
+        if (_heartbeatLost) {
             _heartbeatLost = false;
-            _heartbeatCount++;
-            _heartbeatTimeoutTimer.start();
-            emit heartbeatLostChanged();
-            qCDebug(DetectorInfoLog) << "HEARTBEAT from Detector id" << _tagId;
-        } else if (pulseInfo.confirmed_status) {
-            qCDebug(DetectorInfoLog) << "CONFIRMED tag_id:frequency_hz:seq_ctr:snr:stft_score:noise_psd" <<
-                                        pulseInfo.tag_id <<
-                                        pulseInfo.frequency_hz <<
-                                        pulseInfo.group_seq_counter <<
-                                        pulseInfo.snr <<
-                                        pulseInfo.stft_score <<
-                                        pulseInfo.noise_psd;
-
-            // We track the max pulse in each K group
-            if (_lastPulseGroupSeqCtr != pulseInfo.group_seq_counter) {
-                _lastPulseGroupSeqCtr = pulseInfo.group_seq_counter;
-                _pulseGroupGrount++;
-                _lastPulseStrength = pulseInfo.snr;
-            } else {
-                _lastPulseStrength = std::max(pulseInfo.snr, _lastPulseStrength);
-            }
-            _lastPulseStale = false;
-
-            emit lastPulseStrengthChanged();
-            emit lastPulseStaleChanged();
-            _stalePulseStrengthTimer.start();
-
-            _maxStrength = qMax(_maxStrength, pulseInfo.snr);
+            _heartbeatLostDirty = true;
         }
-    } 
+        _heartbeatCount++;
+        qCDebug(DetectorInfoLog) << "HEARTBEAT from Detector id" << _tagId;
+
+        return PulseDetectorHeartbeat;
+    } else if (pulseInfo.confirmed_status) {
+        qCDebug(DetectorInfoLog) << "CONFIRMED tag_id:frequency_hz:seq_ctr:snr:stft_score:noise_psd" <<
+                                    pulseInfo.tag_id <<
+                                    pulseInfo.frequency_hz <<
+                                    pulseInfo.group_seq_counter <<
+                                    pulseInfo.snr <<
+                                    pulseInfo.stft_score <<
+                                    pulseInfo.noise_psd;
+
+        // We track the max pulse in each K group
+        if (_lastPulseGroupSeqCtr != pulseInfo.group_seq_counter) {
+            _lastPulseGroupSeqCtr = pulseInfo.group_seq_counter;
+            _pulseGroupGrount++;
+            _lastPulseStrength = pulseInfo.snr;
+        } else {
+            _lastPulseStrength = std::max(pulseInfo.snr, _lastPulseStrength);
+        }
+        _lastPulseStale = false;
+        _lastPulseDirty = true;
+
+        _maxStrength = qMax(_maxStrength, pulseInfo.snr);
+
+        return PulseConfirmed;
+    }
+
+    return PulseIgnored;
+}
+
+void DetectorInfo::heartbeatTimedOut()
+{
+    if (!_heartbeatLost) {
+        _heartbeatLost = true;
+        emit heartbeatLostChanged();
+    }
+}
+
+void DetectorInfo::pulseTimedOut()
+{
+    if (!_lastPulseStale) {
+        _lastPulseStale = true;
+        emit lastPulseStaleChanged();
+    }
+}
+
+void DetectorInfo::emitPendingPropertyChanges()
+{
+    if (_heartbeatLostDirty) {
+        _heartbeatLostDirty = false;
+        emit heartbeatLostChanged();
+    }
+    if (_lastPulseDirty) {
+        _lastPulseDirty = false;
+        emit lastPulseStrengthChanged();
+        emit lastPulseStaleChanged();
+    }
 }
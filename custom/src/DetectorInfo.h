@@ -5,7 +5,6 @@
 #include "QGCMAVLink.h"
 
 #include <QObject>
-#include <QTimer>
 
 Q_DECLARE_LOGGING_CATEGORY(DetectorInfoLog)
 
@@ -23,7 +22,22 @@ public:
     Q_PROPERTY(double   lastPulseStrength   MEMBER _lastPulseStrength   NOTIFY lastPulseStrengthChanged)
     Q_PROPERTY(bool     lastPulseStale      MEMBER _lastPulseStale      NOTIFY lastPulseStaleChanged)
 
-    void        handleTunnelPulse   (const mavlink_tunnel_t& tunnel);
+    typedef enum {
+        PulseIgnored,
+        PulseDetectorHeartbeat,
+        PulseConfirmed,
+    } PulseType_t;
+
+    /// Updates detector state from a pulse routed to this detector. Property change signals are held back until
+    /// emitPendingPropertyChanges is called so a burst of pulses results in a single ui update.
+    /// @return How the pulse was handled, used by the owner to push back the liveness deadlines
+    PulseType_t handlePulse                 (const TunnelProtocol::PulseInfo_t& pulseInfo);
+    void        emitPendingPropertyChanges  ();
+
+    /// Called by the owner when no heartbeat or confirmed pulse has arrived within livenessTimeoutMsecs
+    void        heartbeatTimedOut   ();
+    void        pulseTimedOut       ();
+    uint32_t    livenessTimeoutMsecs() const                        { return _livenessTimeoutMsecs; }
     void        resetMaxStrength    ()                              { _maxStrength = 0.0; }
     void        resetHeartbeatCount ()                              { _heartbeatCount = 0; }
     void        resetPulseGroupCount()                              { _pulseGroupGrount = 0; }
@@ -45,10 +59,10 @@ private:
     double          _lastPulseStrength      = 0.0;
     int             _lastPulseGroupSeqCtr   = -1;
     bool            _lastPulseStale         = true;
-    uint32_t        _heartbeatTimerInterval = 0;
-    QTimer          _heartbeatTimeoutTimer;
-    QTimer          _stalePulseStrengthTimer;
+    uint32_t        _livenessTimeoutMsecs   = 0;
     double          _maxStrength                 = 0.0;
     uint32_t        _heartbeatCount         = 0;
     uint32_t        _pulseGroupGrount       = 0;
+    bool            _heartbeatLostDirty     = false;
+    bool            _lastPulseDirty         = false;
 };
@@ -9,11 +9,15 @@
 #include <QPointF>
 #include <QLineF>
 #include <QQmlEngine>
+#include <QSet>
 
 DetectorInfoListModel::DetectorInfoListModel(QObject* parent)
-    : QmlObjectListModel(parent)
+    : QmlObjectListModel    (parent)
+    , _livenessWheel        (_livenessTickMsecs, _livenessWheelSlots)
 {
-
+    _livenessClock.start();
+    _livenessTickTimer.setInterval(_livenessTickMsecs);
+    connect(&_livenessTickTimer, &QTimer::timeout, this, &DetectorInfoListModel::_livenessTick);
 }
 
 DetectorInfoListModel::~DetectorInfoListModel()
@@ -24,43 +28,93 @@ DetectorInfoListModel::~DetectorInfoListModel()
 void DetectorInfoListModel::setupFromTags(TagDatabase* tagDB)
 {
     clearAndDeleteContents();
+    _detectorIndexByTagId.clear();
+    _livenessTickTimer.stop();
 
-    QmlObjectListModel* tagInfoList         = tagDB->tagInfoListModel();
-    CustomSettings*     customSettings      = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin())->customSettings();
+    CustomSettings* customSettings = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin())->customSettings();
 
-    for (int i=0; i<tagInfoList->count(); i++) {
-        TagInfo* tagInfo = tagInfoList->value<TagInfo*>(i);
-        if (!tagInfo->selected()->rawValue().toBool()) {
+    for (const TagRecord_t& tagRecord: tagDB->tagRecords()) {
+        if (!tagRecord.selected) {
             continue;
         }
 
-        TagManufacturer* tagManufacturer = tagDB->findTagManufacturer(tagInfo->manufacturerId()->rawValue().toUInt());
+        const ManufacturerRecord_t* tagManufacturer = tagDB->findManufacturerRecord(tagRecord.manufacturerId);
 
         DetectorInfo* detectorInfo = new DetectorInfo(
-                                            tagInfo->id()->rawValue().toUInt(),
-                                            tagManufacturer->ip_msecs_1_id()->rawValue().toString(),
-                                            tagManufacturer->ip_msecs_1()->rawValue().toUInt(),
+                                            tagRecord.id,
+                                            tagManufacturer->ip_msecs_1_id,
+                                            tagManufacturer->ip_msecs_1,
                                             customSettings->k()->rawValue().toUInt(),
                                             this);
+        _detectorIndexByTagId[tagRecord.id] = count();
         append(detectorInfo);
 
-        if (tagManufacturer->ip_msecs_2()->rawValue().toUInt() != 0) {
+        if (tagManufacturer->ip_msecs_2 != 0) {
             DetectorInfo* detectorInfo = new DetectorInfo(
-                                                tagInfo->id()->rawValue().toUInt() + 1,
-                                                tagManufacturer->ip_msecs_2_id()->rawValue().toString(),
-                                                tagManufacturer->ip_msecs_2()->rawValue().toUInt(),
+                                                tagRecord.id + 1,
+                                                tagManufacturer->ip_msecs_2_id,
+                                                tagManufacturer->ip_msecs_2,
                                                 customSettings->k()->rawValue().toUInt(),
                                                 this);
+            _detectorIndexByTagId[tagRecord.id + 1] = count();
             append(detectorInfo);
         }
     }
+
+    _livenessWheel.reset(count() * DeadlineCount);
 }
 
-void DetectorInfoListModel::handleTunnelPulse(const mavlink_tunnel_t& tunnel)
+void DetectorInfoListModel::handlePulses(const PulseInfoPtrList& pulses)
 {
-    for (int i=0; i<count(); i++) {
-        DetectorInfo* detectorInfo = qobject_cast<DetectorInfo*>(get(i));
-        detectorInfo->handleTunnelPulse(tunnel);
+    QSet<DetectorInfo*> updatedDetectorInfos;
+    qint64              nowMsecs = _livenessClock.elapsed();
+
+    for (const PulseInfoPtr& pulseInfo: pulses) {
+        int index = _detectorIndexByTagId.value(pulseInfo->tag_id, -1);
+        if (index < 0) {
+            continue;
+        }
+
+        DetectorInfo* detectorInfo = _detectorInfo(index);
+
+        // Pushing a deadline back only stores the new time in the wheel
+        switch (detectorInfo->handlePulse(*pulseInfo)) {
+        case DetectorInfo::PulseDetectorHeartbeat:
+            _livenessWheel.setDeadline((index * DeadlineCount) + DeadlineHeartbeat, nowMsecs + detectorInfo->livenessTimeoutMsecs());
+            break;
+        case DetectorInfo::PulseConfirmed:
+            _livenessWheel.setDeadline((index * DeadlineCount) + DeadlinePulse, nowMsecs + detectorInfo->livenessTimeoutMsecs());
+            break;
+        case DetectorInfo::PulseIgnored:
+            break;
+        }
+        updatedDetectorInfos.insert(detectorInfo);
+    }
+
+    for (DetectorInfo* detectorInfo: updatedDetectorInfos) {
+        detectorInfo->emitPendingPropertyChanges();
+    }
+
+    if (!_livenessWheel.isEmpty() && !_livenessTickTimer.isActive()) {
+        _livenessTickTimer.start();
+    }
+}
+
+void DetectorInfoListModel::_livenessTick()
+{
+    for (int id: _livenessWheel.advance(_livenessClock.elapsed())) {
+        DetectorInfo* detectorInfo = _detectorInfo(id / DeadlineCount);
+
+        if (id % DeadlineCount == DeadlineHeartbeat) {
+            detectorInfo->heartbeatTimedOut();
+        } else {
+            detectorInfo->pulseTimedOut();
+        }
+    }
+
+    // No need to keep ticking once every detector has timed out
+    if (_livenessWheel.isEmpty()) {
+        _livenessTickTimer.stop();
     }
 }
 
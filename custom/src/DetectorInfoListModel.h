@@ -2,9 +2,18 @@
 
 #include "QmlObjectListModel.h"
 #include "QGCMAVLink.h"
+#include "PulseIngest.h"
+#include "DeadlineWheel.h"
+
+#include <QHash>
+#include <QElapsedTimer>
+#include <QTimer>
 
 class TagDatabase;
+class DetectorInfo;
 
+/// Detectors for the selected tags. Heartbeat lost and stale pulse deadlines for all detectors are tracked by a single
+/// timer wheel which is checked on one shared tick instead of each detector restarting its own timers on every pulse.
 class DetectorInfoListModel : public QmlObjectListModel
 {
     Q_OBJECT
@@ -14,10 +23,31 @@ public:
     ~DetectorInfoListModel();
 
     void    setupFromTags               (TagDatabase* tagDB);
-    void    handleTunnelPulse           (const mavlink_tunnel_t& tunnel);
+    void    handlePulses                (const PulseInfoPtrList& pulses);
     void    resetMaxStrength            ();
     void    resetPulseGroupCount        ();
     double  maxStrength                 () const;
     bool    allHeartbeatCountsReached   (uint32_t targetHeartbeatCount) const;
     bool    allPulseGroupCountsReached  (uint32_t targetPulseGroupCount) const;
+
+private slots:
+    void _livenessTick(void);
+
+private:
+    // Each detector has two deadlines in the wheel
+    typedef enum {
+        DeadlineHeartbeat   = 0,
+        DeadlinePulse       = 1,
+        DeadlineCount       = 2,
+    } DeadlineType_t;
+
+    DetectorInfo* _detectorInfo(int index) { return qobject_cast<DetectorInfo*>((*this)[index]); }
+
+    QHash<uint32_t, int>    _detectorIndexByTagId;
+    DeadlineWheel           _livenessWheel;
+    QElapsedTimer           _livenessClock;
+    QTimer                  _livenessTickTimer;
+
+    static constexpr int    _livenessTickMsecs  = 100;
+    static constexpr int    _livenessWheelSlots = 256;  ///< One turn covers the longest expected detector timeout
 };
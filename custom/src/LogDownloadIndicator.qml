@@ -59,6 +59,12 @@ Item {
         }
     }
 
+    Component {
+        id: captureViewerDialogComponent
+
+        CaptureViewerDialog { }
+    }
+
     Component {
         id: indicatorContentComponent
 
@@ -96,6 +102,11 @@ Item {
                         text:       qsTr("Download")
                         onClicked:  QGroundControl.corePlugin.downloadLogDirFiles(modelData)
                     }
+
+                    QGCButton {
+                        text:       qsTr("Captures")
+                        onClicked:  captureViewerDialogComponent.createObject(mainWindow, { logDir: modelData }).open()
+                    }
                 }
             }
         }
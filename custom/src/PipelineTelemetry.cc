@@ -0,0 +1,367 @@
+#include "PipelineTelemetry.h"
+
+#include <QFile>
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(PipelineTelemetryLog, "PipelineTelemetryLog")
+
+int LatencyHistogram::bucketForMsecs(qint64 msecs)
+{
+    if (msecs < 1) {
+        return 0;
+    }
+
+    int bucket = 1;
+    while (bucket < bucketCount - 1 && msecs >= (Q_INT64_C(1) << bucket)) {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+qint64 LatencyHistogram::bucketUpperMsecs(int index)
+{
+    return Q_INT64_C(1) << index;
+}
+
+void LatencyHistogram::add(qint64 msecs)
+{
+    // Clock offset between the controller and us can make latencies negative, these land in the first bucket but
+    // still show up in the min
+    if (_count == 0) {
+        _minMsecs = msecs;
+        _maxMsecs = msecs;
+    } else {
+        _minMsecs = std::min(_minMsecs, msecs);
+        _maxMsecs = std::max(_maxMsecs, msecs);
+    }
+    _count++;
+    _sumMsecs += msecs;
+    _buckets[bucketForMsecs(msecs)]++;
+}
+
+void LatencyHistogram::clear(void)
+{
+    _buckets.fill(0);
+    _count      = 0;
+    _sumMsecs   = 0;
+    _minMsecs   = 0;
+    _maxMsecs   = 0;
+}
+
+qint64 LatencyHistogram::percentile(double pct) const
+{
+    if (_count == 0) {
+        return 0;
+    }
+
+    qint64 targetCount      = std::max(static_cast<qint64>(qCeil((pct / 100.0) * _count)), Q_INT64_C(1));
+    qint64 cumulativeCount  = 0;
+    for (int i=0; i<bucketCount; i++) {
+        cumulativeCount += _buckets[i];
+        if (cumulativeCount >= targetCount) {
+            // The overflow bucket has no upper bound and nothing is above the max
+            return i == bucketCount - 1 ? _maxMsecs : std::min(bucketUpperMsecs(i), _maxMsecs);
+        }
+    }
+
+    return _maxMsecs;
+}
+
+void IntervalStats::add(qint64 msecs)
+{
+    if (_lastMsecs >= 0) {
+        qint64 intervalMsecs = msecs - _lastMsecs;
+
+        // Welford's running variance
+        _intervalCount++;
+        double delta = intervalMsecs - _meanMsecs;
+        _meanMsecs += delta / _intervalCount;
+        _m2 += delta * (intervalMsecs - _meanMsecs);
+
+        _maxIntervalMsecs = std::max(_maxIntervalMsecs, intervalMsecs);
+    }
+
+    _lastMsecs = msecs;
+    _count++;
+}
+
+double IntervalStats::jitterMsecs(void) const
+{
+    return _intervalCount > 1 ? qSqrt(_m2 / (_intervalCount - 1)) : 0;
+}
+
+PipelineTelemetry::PipelineTelemetry(QObject* parent)
+    : QObject(parent)
+{
+    _updateTimer.setSingleShot(true);
+    _updateTimer.setInterval(_updateMsecs);
+    connect(&_updateTimer, &QTimer::timeout, this, &PipelineTelemetry::update);
+}
+
+PipelineTelemetry::~PipelineTelemetry()
+{
+    qDeleteAll(_detectors);
+}
+
+QStringList PipelineTelemetry::bucketLabels(void) const
+{
+    QStringList labels;
+
+    for (int i=0; i<LatencyHistogram::bucketCount - 1; i++) {
+        labels.append(QStringLiteral("<%1").arg(LatencyHistogram::bucketUpperMsecs(i)));
+    }
+    labels.append(QStringLiteral(">=%1").arg(LatencyHistogram::bucketUpperMsecs(LatencyHistogram::bucketCount - 2)));
+
+    return labels;
+}
+
+PipelineTelemetry::DetectorTelemetry_t* PipelineTelemetry::_detectorTelemetry(uint32_t tagId)
+{
+    DetectorTelemetry_t* detector = _detectors.value(tagId, nullptr);
+    if (!detector) {
+        detector = new DetectorTelemetry_t();
+        _detectors[tagId] = detector;
+    }
+    return detector;
+}
+
+qint64 PipelineTelemetry::_pulseAgeMsecs(const PulseInfo_t& pulseInfo, qint64 nowMsecs)
+{
+    return nowMsecs - qRound64(pulseInfo.start_time_seconds * 1000.0);
+}
+
+void PipelineTelemetry::recordPulseReceived(const PulseInfo_t& pulseInfo, qint64 arrivalMsecs)
+{
+    DetectorTelemetry_t* detector = _detectorTelemetry(pulseInfo.tag_id);
+
+    if (pulseInfo.frequency_hz == 0) {
+        detector->heartbeats.add(arrivalMsecs);
+    } else {
+        detector->receivedAge.add(_pulseAgeMsecs(pulseInfo, arrivalMsecs));
+
+        if (pulseInfo.confirmed_status) {
+            // Every pulse in a K group carries the same counter, so only a jump of more than one is a lost group
+            int groupSeqCounter = static_cast<int>(pulseInfo.group_seq_counter);
+            if (detector->lastGroupSeqCounter >= 0) {
+                if (groupSeqCounter > detector->lastGroupSeqCounter + 1) {
+                    detector->groupSeqGaps++;
+                    detector->droppedGroups += groupSeqCounter - detector->lastGroupSeqCounter - 1;
+                    qCDebug(PipelineTelemetryLog) << "Group sequence gap tag_id:last:current" << pulseInfo.tag_id << detector->lastGroupSeqCounter << groupSeqCounter;
+                } else if (groupSeqCounter < detector->lastGroupSeqCounter) {
+                    // Detector restarted
+                    detector->groupSeqResets++;
+                }
+            }
+            detector->lastGroupSeqCounter = groupSeqCounter;
+        }
+    }
+
+    _scheduleUpdate();
+}
+
+void PipelineTelemetry::recordPulsesProcessed(const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs, qint64 nowMsecs)
+{
+    Q_ASSERT(pulses.count() == arrivalMsecs.count());
+
+    for (int i=0; i<pulses.count(); i++) {
+        const PulseInfoPtr& pulseInfo = pulses[i];
+
+        recordPulseReceived(*pulseInfo, arrivalMsecs[i]);
+        if (pulseInfo->frequency_hz != 0) {
+            _detectorTelemetry(pulseInfo->tag_id)->processedAge.add(_pulseAgeMsecs(*pulseInfo, nowMsecs));
+        }
+    }
+
+    _scheduleUpdate();
+}
+
+void PipelineTelemetry::recordControllerHeartbeat(qint64 nowMsecs, double cpuTempC)
+{
+    _controllerHeartbeats.add(nowMsecs);
+
+    CpuTemp_t cpuTemp = { nowMsecs, cpuTempC };
+    if (_cpuTemps.count() < maxCpuTempSamples) {
+        _cpuTemps.append(cpuTemp);
+    } else {
+        _cpuTemps[_nextCpuTemp] = cpuTemp;
+    }
+    _nextCpuTemp = (_nextCpuTemp + 1) % maxCpuTempSamples;
+
+    _scheduleUpdate();
+}
+
+void PipelineTelemetry::recordChannelizerHeartbeat(qint64 nowMsecs)
+{
+    _channelizerHeartbeats.add(nowMsecs);
+
+    _scheduleUpdate();
+}
+
+void PipelineTelemetry::clear(void)
+{
+    qDeleteAll(_detectors);
+    _detectors.clear();
+    _controllerHeartbeats   = IntervalStats();
+    _channelizerHeartbeats  = IntervalStats();
+    _cpuTemps.clear();
+    _nextCpuTemp            = 0;
+
+    update();
+}
+
+void PipelineTelemetry::_scheduleUpdate(void)
+{
+    if (!_updateTimer.isActive()) {
+        _updateTimer.start();
+    }
+}
+
+QVariantMap PipelineTelemetry::_heartbeatRow(const IntervalStats& intervalStats)
+{
+    QVariantMap row;
+
+    row[QStringLiteral("count")]        = intervalStats.count();
+    row[QStringLiteral("meanMsecs")]    = intervalStats.meanMsecs();
+    row[QStringLiteral("jitterMsecs")]  = intervalStats.jitterMsecs();
+    row[QStringLiteral("maxMsecs")]     = intervalStats.maxMsecs();
+
+    return row;
+}
+
+QVariantMap PipelineTelemetry::_detectorRow(uint32_t tagId, const DetectorTelemetry_t& detector) const
+{
+    QVariantMap     row;
+    QVariantList    receivedBuckets;
+    QVariantList    processedBuckets;
+
+    for (int i=0; i<LatencyHistogram::bucketCount; i++) {
+        receivedBuckets.append(detector.receivedAge.bucket(i));
+        processedBuckets.append(detector.processedAge.bucket(i));
+    }
+
+    row[QStringLiteral("tagId")]            = tagId;
+    row[QStringLiteral("pulseCount")]       = detector.receivedAge.count();
+    row[QStringLiteral("receivedP50")]      = detector.receivedAge.percentile(50);
+    row[QStringLiteral("receivedP90")]      = detector.receivedAge.percentile(90);
+    row[QStringLiteral("receivedP99")]      = detector.receivedAge.percentile(99);
+    row[QStringLiteral("receivedMax")]      = detector.receivedAge.maxMsecs();
+    row[QStringLiteral("processedP50")]     = detector.processedAge.percentile(50);
+    row[QStringLiteral("processedP90")]     = detector.processedAge.percentile(90);
+    row[QStringLiteral("processedP99")]     = detector.processedAge.percentile(99);
+    row[QStringLiteral("processedMax")]     = detector.processedAge.maxMsecs();
+    row[QStringLiteral("ingestMeanMsecs")]  = detector.processedAge.meanMsecs() - detector.receivedAge.meanMsecs();
+    row[QStringLiteral("receivedBuckets")]  = receivedBuckets;
+    row[QStringLiteral("processedBuckets")] = processedBuckets;
+    row[QStringLiteral("heartbeat")]        = _heartbeatRow(detector.heartbeats);
+    row[QStringLiteral("groupSeqGaps")]     = detector.groupSeqGaps;
+    row[QStringLiteral("droppedGroups")]    = detector.droppedGroups;
+    row[QStringLiteral("groupSeqResets")]   = detector.groupSeqResets;
+
+    return row;
+}
+
+void PipelineTelemetry::update(void)
+{
+    _updateTimer.stop();
+
+    _detectorRows.clear();
+    for (auto it = _detectors.constBegin(); it != _detectors.constEnd(); ++it) {
+        _detectorRows.append(_detectorRow(it.key(), *it.value()));
+    }
+
+    _controllerHeartbeatRow     = _heartbeatRow(_controllerHeartbeats);
+    _channelizerHeartbeatRow    = _heartbeatRow(_channelizerHeartbeats);
+
+    // Oldest first
+    _cpuTempTimes.clear();
+    _cpuTempValues.clear();
+    int firstIndex = _cpuTemps.count() < maxCpuTempSamples ? 0 : _nextCpuTemp;
+    for (int i=0; i<_cpuTemps.count(); i++) {
+        const CpuTemp_t& cpuTemp = _cpuTemps[(firstIndex + i) % _cpuTemps.count()];
+        _cpuTempTimes.append((cpuTemp.msecs - _cpuTemps[firstIndex].msecs) / 1000.0);
+        _cpuTempValues.append(cpuTemp.tempC);
+    }
+
+    emit telemetryChanged();
+}
+
+bool PipelineTelemetry::exportToCsv(const QString& csvFileName, QString& errorString) const
+{
+    QFile csvFile(csvFileName);
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        errorString = QStringLiteral("Open of '%1' failed: %2").arg(csvFileName, csvFile.errorString());
+        return false;
+    }
+
+    csvFile.write("# detector, tag_id, pulses, received_p50_ms, received_p90_ms, received_p99_ms, received_max_ms, processed_p50_ms, processed_p90_ms, processed_p99_ms, processed_max_ms, heartbeats, heartbeat_mean_ms, heartbeat_jitter_ms, heartbeat_max_ms, group_seq_gaps, dropped_groups, group_seq_resets\n");
+    for (auto it = _detectors.constBegin(); it != _detectors.constEnd(); ++it) {
+        const DetectorTelemetry_t& detector = *it.value();
+        csvFile.write(QString("detector, %1, %2, %3, %4, %5, %6, %7, %8, %9, %10, %11, %12, %13, %14, %15, %16, %17\n")
+            .arg(it.key())
+            .arg(detector.receivedAge.count())
+            .arg(detector.receivedAge.percentile(50))
+            .arg(detector.receivedAge.percentile(90))
+            .arg(detector.receivedAge.percentile(99))
+            .arg(detector.receivedAge.maxMsecs())
+            .arg(detector.processedAge.percentile(50))
+            .arg(detector.processedAge.percentile(90))
+            .arg(detector.processedAge.percentile(99))
+            .arg(detector.processedAge.maxMsecs())
+            .arg(detector.heartbeats.count())
+            .arg(detector.heartbeats.meanMsecs(),   0, 'f', 1)
+            .arg(detector.heartbeats.jitterMsecs(), 0, 'f', 1)
+            .arg(detector.heartbeats.maxMsecs())
+            .arg(detector.groupSeqGaps)
+            .arg(detector.droppedGroups)
+            .arg(detector.groupSeqResets)
+            .toUtf8());
+    }
+
+    csvFile.write(QString("# histogram, tag_id, stage, %1\n").arg(bucketLabels().join(", ")).toUtf8());
+    for (auto it = _detectors.constBegin(); it != _detectors.constEnd(); ++it) {
+        const DetectorTelemetry_t& detector = *it.value();
+        QStringList receivedCounts;
+        QStringList processedCounts;
+        for (int i=0; i<LatencyHistogram::bucketCount; i++) {
+            receivedCounts.append(QString::number(detector.receivedAge.bucket(i)));
+            processedCounts.append(QString::number(detector.processedAge.bucket(i)));
+        }
+        csvFile.write(QString("histogram, %1, received, %2\n").arg(it.key()).arg(receivedCounts.join(", ")).toUtf8());
+        csvFile.write(QString("histogram, %1, processed, %2\n").arg(it.key()).arg(processedCounts.join(", ")).toUtf8());
+    }
+
+    csvFile.write("# heartbeat, source, count, mean_ms, jitter_ms, max_ms\n");
+    const QList<QPair<QString, const IntervalStats*>> heartbeatSources = {
+        { QStringLiteral("controller"),     &_controllerHeartbeats },
+        { QStringLiteral("channelizer"),    &_channelizerHeartbeats },
+    };
+    for (const auto& heartbeatSource: heartbeatSources) {
+        const IntervalStats& intervalStats = *heartbeatSource.second;
+        csvFile.write(QString("heartbeat, %1, %2, %3, %4, %5\n")
+            .arg(heartbeatSource.first)
+            .arg(intervalStats.count())
+            .arg(intervalStats.meanMsecs(),     0, 'f', 1)
+            .arg(intervalStats.jitterMsecs(),   0, 'f', 1)
+            .arg(intervalStats.maxMsecs())
+            .toUtf8());
+    }
+
+    csvFile.write("# cpu_temp, time_msecs, temp_c\n");
+    int firstIndex = _cpuTemps.count() < maxCpuTempSamples ? 0 : _nextCpuTemp;
+    for (int i=0; i<_cpuTemps.count(); i++) {
+        const CpuTemp_t& cpuTemp = _cpuTemps[(firstIndex + i) % _cpuTemps.count()];
+        csvFile.write(QString("cpu_temp, %1, %2\n").arg(cpuTemp.msecs).arg(cpuTemp.tempC, 0, 'f', 1).toUtf8());
+    }
+
+    if (csvFile.error() != QFileDevice::NoError) {
+        errorString = QStringLiteral("Write of '%1' failed: %2").arg(csvFileName, csvFile.errorString());
+        return false;
+    }
+
+    return true;
+}
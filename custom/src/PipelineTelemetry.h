@@ -0,0 +1,158 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+#include "TunnelProtocol.h"
+#include "PulseIngest.h"
+
+#include <QObject>
+#include <QMap>
+#include <QTimer>
+#include <QVariantList>
+#include <QStringList>
+#include <QVector>
+
+#include <array>
+
+Q_DECLARE_LOGGING_CATEGORY(PipelineTelemetryLog)
+
+/// Latency histogram with power of two millisecond buckets. Bucket 0 holds latencies under 1 ms, bucket i holds
+/// [2^(i-1), 2^i) ms and the last bucket holds everything longer. Constant size no matter how many samples are added.
+class LatencyHistogram
+{
+public:
+    static constexpr int bucketCount = 18;
+
+    void    add             (qint64 msecs);
+    void    clear           (void);
+
+    /// @return Upper bound of the bucket holding the percentile, 0 if empty
+    qint64  percentile      (double pct) const;
+
+    qint64  count           (void) const { return _count; }
+    qint64  minMsecs        (void) const { return _minMsecs; }
+    qint64  maxMsecs        (void) const { return _maxMsecs; }
+    double  meanMsecs       (void) const { return _count ? static_cast<double>(_sumMsecs) / _count : 0; }
+    quint32 bucket          (int index) const { return _buckets[index]; }
+
+    static int      bucketForMsecs      (qint64 msecs);
+    static qint64   bucketUpperMsecs    (int index);
+
+private:
+    std::array<quint32, bucketCount>    _buckets    { };
+    qint64                              _count      = 0;
+    qint64                              _sumMsecs   = 0;
+    qint64                              _minMsecs   = 0;
+    qint64                              _maxMsecs   = 0;
+};
+
+/// Running interval statistics for a periodic message such as a heartbeat. Jitter is the standard deviation of the
+/// arrival interval.
+class IntervalStats
+{
+public:
+    void    add             (qint64 msecs);
+
+    qint64  count           (void) const { return _count; }
+    double  meanMsecs       (void) const { return _meanMsecs; }
+    double  jitterMsecs     (void) const;
+    qint64  maxMsecs        (void) const { return _maxIntervalMsecs; }
+
+private:
+    qint64  _count              = 0;
+    qint64  _lastMsecs          = -1;
+    qint64  _intervalCount      = 0;
+    double  _meanMsecs          = 0;
+    double  _m2                 = 0;
+    qint64  _maxIntervalMsecs   = 0;
+};
+
+/// Instrumentation for the controller to ground station pulse pipeline of a single vehicle. Tracks:
+///     Pulse age at receipt and after ingest, from the SDR pulse start time. This includes any clock offset between
+///     the controller and the ground station, so the spread and trend are more meaningful than the absolute values.
+///     Detector, controller and channelizer heartbeat jitter
+///     Gaps in the detector group sequence counter, which are groups lost between the detector and us
+///     Controller CPU temperature over time
+class PipelineTelemetry : public QObject
+{
+    Q_OBJECT
+
+public:
+    PipelineTelemetry(QObject* parent = nullptr);
+    ~PipelineTelemetry();
+
+    /// One QVariantMap per detector, see _detectorRow for the keys
+    Q_PROPERTY(QVariantList     detectors               MEMBER _detectorRows            NOTIFY telemetryChanged)
+    Q_PROPERTY(QVariantMap      controllerHeartbeat     MEMBER _controllerHeartbeatRow  NOTIFY telemetryChanged)
+    Q_PROPERTY(QVariantMap      channelizerHeartbeat    MEMBER _channelizerHeartbeatRow NOTIFY telemetryChanged)
+    Q_PROPERTY(QList<double>    cpuTempTimes            MEMBER _cpuTempTimes            NOTIFY telemetryChanged)    ///< Seconds from first sample
+    Q_PROPERTY(QList<double>    cpuTempValues           MEMBER _cpuTempValues           NOTIFY telemetryChanged)
+    Q_PROPERTY(QStringList      bucketLabels            READ   bucketLabels             CONSTANT)
+
+    QStringList bucketLabels(void) const;
+
+    /// Records a pulse as of the time its tunnel message arrived, before it was queued for ingest
+    void recordPulseReceived    (const TunnelProtocol::PulseInfo_t& pulseInfo, qint64 arrivalMsecs);
+
+    /// Called once ingested pulses have been handled. Records the receipt of each pulse as well, from the arrival
+    /// times stamped by PulseIngest.
+    void recordPulsesProcessed  (const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs, qint64 nowMsecs);
+
+    void recordControllerHeartbeat  (qint64 nowMsecs, double cpuTempC);
+    void recordChannelizerHeartbeat (qint64 nowMsecs);
+
+    void clear                  (void);
+
+    /// Writes the current telemetry. The first column of each row is the row type.
+    bool exportToCsv            (const QString& csvFileName, QString& errorString) const;
+
+    typedef struct DetectorTelemetry_t {
+        LatencyHistogram    receivedAge;
+        LatencyHistogram    processedAge;
+        IntervalStats       heartbeats;
+        int                 lastGroupSeqCounter = -1;
+        qint64              groupSeqGaps        = 0;
+        qint64              droppedGroups       = 0;
+        qint64              groupSeqResets      = 0;
+    } DetectorTelemetry_t;
+
+    /// @return nullptr: nothing seen from the detector
+    const DetectorTelemetry_t*  detector            (uint32_t tagId) const { return _detectors.value(tagId, nullptr); }
+    const IntervalStats&        controllerHeartbeats(void) const { return _controllerHeartbeats; }
+    const IntervalStats&        channelizerHeartbeats(void) const { return _channelizerHeartbeats; }
+    int                         cpuTempCount        (void) const { return _cpuTemps.count(); }
+
+    /// Recalculates the QML properties now instead of waiting for the update timer
+    void update                 (void);
+
+    static constexpr int maxCpuTempSamples = 720;   ///< One hour of controller heartbeats
+
+signals:
+    void telemetryChanged(void);
+
+private:
+    typedef struct {
+        qint64  msecs;
+        double  tempC;
+    } CpuTemp_t;
+
+    DetectorTelemetry_t*    _detectorTelemetry  (uint32_t tagId);
+    QVariantMap             _detectorRow        (uint32_t tagId, const DetectorTelemetry_t& detector) const;
+    static QVariantMap      _heartbeatRow       (const IntervalStats& intervalStats);
+    static qint64           _pulseAgeMsecs      (const TunnelProtocol::PulseInfo_t& pulseInfo, qint64 nowMsecs);
+    void                    _scheduleUpdate     (void);
+
+    QMap<uint32_t, DetectorTelemetry_t*>    _detectors;
+    IntervalStats                           _controllerHeartbeats;
+    IntervalStats                           _channelizerHeartbeats;
+    QVector<CpuTemp_t>                      _cpuTemps;          ///< Ring buffer once full
+    int                                     _nextCpuTemp        = 0;
+
+    QVariantList                            _detectorRows;
+    QVariantMap                             _controllerHeartbeatRow;
+    QVariantMap                             _channelizerHeartbeatRow;
+    QList<double>                           _cpuTempTimes;
+    QList<double>                           _cpuTempValues;
+    QTimer                                  _updateTimer;
+
+    static constexpr int _updateMsecs = 1000;
+};
@@ -0,0 +1,177 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Dialogs
+import QtQuick.Layouts
+
+import QGroundControl
+import QGroundControl.Controls
+import QGroundControl.Palette
+import QGroundControl.ScreenTools
+
+/// Pulse pipeline telemetry for a session: pulse age, heartbeat jitter, lost K groups and controller temperature
+QGCPopupDialog {
+    id:         root
+    title:      qsTr("Pipeline Telemetry - Vehicle %1").arg(session.vehicleId)
+    buttons:    Dialog.Close
+
+    property var session
+
+    property var    _telemetry:     session.pipelineTelemetry
+    property real   _columnWidth:   ScreenTools.defaultFontPixelWidth * 10
+
+    function _heartbeatText(heartbeat) {
+        return qsTr("%1 heartbeats, interval %2 ms, jitter %3 ms, max %4 ms")
+            .arg(heartbeat.count).arg(heartbeat.meanMsecs.toFixed(0)).arg(heartbeat.jitterMsecs.toFixed(0)).arg(heartbeat.maxMsecs)
+    }
+
+    QGCPalette { id: qgcPal; colorGroupEnabled: true }
+
+    ColumnLayout {
+        spacing: ScreenTools.defaultFontPixelHeight / 2
+
+        QGCLabel { text: qsTr("Controller: %1").arg(_heartbeatText(_telemetry.controllerHeartbeat)) }
+        QGCLabel { text: qsTr("Channelizer: %1").arg(_heartbeatText(_telemetry.channelizerHeartbeat)) }
+
+        QGCLabel { text: qsTr("Controller CPU Temperature") }
+
+        Rectangle {
+            Layout.preferredWidth:  ScreenTools.defaultFontPixelWidth * 70
+            Layout.preferredHeight: ScreenTools.defaultFontPixelHeight * 4
+            color:                  qgcPal.windowShade
+
+            Canvas {
+                id:             cpuTempCanvas
+                anchors.fill:   parent
+
+                Connections {
+                    target:             _telemetry
+                    function onTelemetryChanged() { cpuTempCanvas.requestPaint() }
+                }
+
+                onPaint: {
+                    var ctx = getContext("2d")
+                    ctx.reset()
+
+                    var times   = _telemetry.cpuTempTimes
+                    var values  = _telemetry.cpuTempValues
+                    if (times.length < 2) {
+                        return
+                    }
+
+                    var spanSecs    = Math.max(times[times.length - 1], 1)
+                    var minValue    = Math.min.apply(null, values) - 1
+                    var maxValue    = Math.max.apply(null, values) + 1
+                    function x(i) { return (times[i] / spanSecs) * width }
+                    function y(value) { return height - ((value - minValue) / (maxValue - minValue)) * height }
+
+                    ctx.strokeStyle = "#00E04B"
+                    ctx.lineWidth   = 1
+                    ctx.beginPath()
+                    ctx.moveTo(x(0), y(values[0]))
+                    for (var i = 1; i < times.length; i++) {
+                        ctx.lineTo(x(i), y(values[i]))
+                    }
+                    ctx.stroke()
+                }
+            }
+
+            QGCLabel {
+                anchors.left:   parent.left
+                anchors.top:    parent.top
+                text:           _telemetry.cpuTempValues.length ? qsTr("%1 C").arg(_telemetry.cpuTempValues[_telemetry.cpuTempValues.length - 1].toFixed(0)) : qsTr("No heartbeats")
+                font.pointSize: ScreenTools.smallFontPointSize
+            }
+        }
+
+        QGCLabel { text: qsTr("Pulse age in ms since SDR pulse start. Includes controller clock offset.") }
+
+        RowLayout {
+            spacing: 0
+
+            Repeater {
+                model: [ qsTr("Tag"), qsTr("Pulses"), qsTr("Rcvd p50"), qsTr("Rcvd p99"), qsTr("Rcvd max"), qsTr("Ingest"), qsTr("Hb jitter"), qsTr("Seq gaps"), qsTr("Lost groups") ]
+
+                QGCLabel {
+                    Layout.preferredWidth:  _columnWidth
+                    text:                   modelData
+                }
+            }
+
+            QGCLabel { text: qsTr("Received age histogram") }
+        }
+
+        Repeater {
+            model: _telemetry.detectors
+
+            RowLayout {
+                spacing: 0
+
+                property var detector: modelData
+
+                Repeater {
+                    model: [
+                        detector.tagId,
+                        detector.pulseCount,
+                        detector.receivedP50,
+                        detector.receivedP99,
+                        detector.receivedMax,
+                        detector.ingestMeanMsecs.toFixed(0),
+                        detector.heartbeat.jitterMsecs.toFixed(0),
+                        detector.groupSeqGaps,
+                        detector.droppedGroups,
+                    ]
+
+                    QGCLabel {
+                        Layout.preferredWidth:  _columnWidth
+                        text:                   modelData
+                    }
+                }
+
+                Canvas {
+                    Layout.preferredWidth:  ScreenTools.defaultFontPixelWidth * 30
+                    Layout.preferredHeight: ScreenTools.defaultFontPixelHeight
+
+                    property var buckets: detector.receivedBuckets
+
+                    onBucketsChanged: requestPaint()
+
+                    onPaint: {
+                        var ctx = getContext("2d")
+                        ctx.reset()
+
+                        var maxCount = Math.max.apply(null, buckets)
+                        if (maxCount === 0) {
+                            return
+                        }
+
+                        var barWidth = width / buckets.length
+                        ctx.fillStyle = "#00E04B"
+                        for (var i = 0; i < buckets.length; i++) {
+                            var barHeight = (buckets[i] / maxCount) * height
+                            ctx.fillRect(i * barWidth, height - barHeight, barWidth - 1, barHeight)
+                        }
+                    }
+                }
+            }
+        }
+
+        QGCLabel {
+            text:           qsTr("Histogram buckets %1 to %2 ms").arg(_telemetry.bucketLabels[0]).arg(_telemetry.bucketLabels[_telemetry.bucketLabels.length - 1])
+            font.pointSize: ScreenTools.smallFontPointSize
+        }
+
+        QGCButton {
+            text:       qsTr("Export")
+            onClicked:  session.exportTelemetry()
+        }
+    }
+}
@@ -0,0 +1,277 @@
+#include "PulseHeatMap.h"
+
+#include <QColor>
+#include <QtMath>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(PulseHeatMapLog, "PulseHeatMapLog")
+
+PulseHeatMap::PulseHeatMap(double resolutionMeters, double maxStrength, QObject* parent)
+    : QObject           (parent)
+    , _resolutionMeters (resolutionMeters)
+    , _maxStrength      (maxStrength)
+{
+    _updateTimer.setSingleShot(true);
+    _updateTimer.setInterval(_updateMsecs);
+    connect(&_updateTimer, &QTimer::timeout, this, [this]() {
+        _revision++;
+        emit imageChanged();
+    });
+}
+
+void PulseHeatMap::addPulse(const QGeoCoordinate& coord, double strength)
+{
+    if (!coord.isValid() || qIsNaN(strength)) {
+        return;
+    }
+
+    if (!_origin.isValid()) {
+        double latRadians = qDegreesToRadians(coord.latitude());
+
+        _origin             = coord;
+        _metersPerDegreeLat = 111132.954 - (559.822 * qCos(2 * latRadians)) + (1.175 * qCos(4 * latRadians));
+        _metersPerDegreeLon = (111412.84 * qCos(latRadians)) - (93.5 * qCos(3 * latRadians));
+    }
+
+    int cellX, cellY;
+    if (!_cellIndex(coord, cellX, cellY) || !_growToInclude(cellX, cellY)) {
+        qCDebug(PulseHeatMapLog) << "Pulse outside of maximum grid area dropped" << coord;
+        return;
+    }
+
+    int     gridX   = cellX - _gridMinX;
+    int     gridY   = cellY - _gridMinY;
+    Cell_t& cell    = _cells[(gridY * _gridWidth) + gridX];
+
+    if (cell.count == 0) {
+        cell.maxStrength = static_cast<float>(strength);
+        _cellCount++;
+    } else {
+        cell.maxStrength = std::max(cell.maxStrength, static_cast<float>(strength));
+    }
+    cell.sumStrength += static_cast<float>(strength);
+    cell.count++;
+
+    _paintCell(gridX, gridY);
+    _scheduleUpdate();
+}
+
+void PulseHeatMap::clear(void)
+{
+    _origin     = QGeoCoordinate();
+    _gridMinX   = 0;
+    _gridMinY   = 0;
+    _gridWidth  = 0;
+    _gridHeight = 0;
+    _cellCount  = 0;
+    _cells.clear();
+    _image      = QImage();
+
+    _updateTimer.stop();
+    _revision++;
+    emit imageChanged();
+}
+
+void PulseHeatMap::setResolution(double resolutionMeters)
+{
+    if (resolutionMeters > 0 && !qFuzzyCompare(resolutionMeters, _resolutionMeters)) {
+        _resolutionMeters = resolutionMeters;
+        clear();
+    }
+}
+
+void PulseHeatMap::setMode(Mode mode)
+{
+    if (mode != _mode) {
+        _mode = mode;
+        _repaintAll();
+        _scheduleUpdate();
+    }
+}
+
+void PulseHeatMap::setMaxStrength(double maxStrength)
+{
+    if (maxStrength > 0 && !qFuzzyCompare(maxStrength, _maxStrength)) {
+        _maxStrength = maxStrength;
+        _repaintAll();
+        _scheduleUpdate();
+    }
+}
+
+QString PulseHeatMap::imageUrl(void) const
+{
+    // The revision forces QML to request a new image when the contents change
+    return QStringLiteral("image://%1/%2").arg(imageProviderId).arg(_revision);
+}
+
+QGeoCoordinate PulseHeatMap::topLeft(void) const
+{
+    if (!valid()) {
+        return QGeoCoordinate();
+    }
+
+    double east     = _gridMinX * _resolutionMeters;
+    double north    = (_gridMinY + _gridHeight) * _resolutionMeters;
+
+    return QGeoCoordinate(_origin.latitude() + (north / _metersPerDegreeLat), _origin.longitude() + (east / _metersPerDegreeLon));
+}
+
+double PulseHeatMap::cellValue(const QGeoCoordinate& coord) const
+{
+    int cellX, cellY;
+    if (!valid() || !_cellIndex(coord, cellX, cellY)) {
+        return qQNaN();
+    }
+
+    int gridX = cellX - _gridMinX;
+    int gridY = cellY - _gridMinY;
+    if (gridX < 0 || gridX >= _gridWidth || gridY < 0 || gridY >= _gridHeight) {
+        return qQNaN();
+    }
+
+    const Cell_t& cell = _cells[(gridY * _gridWidth) + gridX];
+    return cell.count ? _cellValue(cell) : qQNaN();
+}
+
+bool PulseHeatMap::_cellIndex(const QGeoCoordinate& coord, int& cellX, int& cellY) const
+{
+    if (!_origin.isValid()) {
+        return false;
+    }
+
+    double east     = (coord.longitude() - _origin.longitude()) * _metersPerDegreeLon;
+    double north    = (coord.latitude() - _origin.latitude()) * _metersPerDegreeLat;
+    double x        = qFloor(east / _resolutionMeters);
+    double y        = qFloor(north / _resolutionMeters);
+
+    // Anything this far out could never fit in the grid anyway
+    if (qAbs(x) > 2 * maxGridDimension || qAbs(y) > 2 * maxGridDimension) {
+        return false;
+    }
+
+    cellX = static_cast<int>(x);
+    cellY = static_cast<int>(y);
+
+    return true;
+}
+
+// Grows the grid such that it includes the specified cell. Growth adds a margin so that it doesn't happen on every
+// new cell. Returns false if the grid would exceed the maximum dimensions.
+bool PulseHeatMap::_growToInclude(int cellX, int cellY)
+{
+    if (_gridWidth && cellX >= _gridMinX && cellX < _gridMinX + _gridWidth && cellY >= _gridMinY && cellY < _gridMinY + _gridHeight) {
+        return true;
+    }
+
+    int minX, maxX, minY, maxY;
+    if (_gridWidth == 0) {
+        minX = cellX - _growMarginCells;
+        maxX = cellX + _growMarginCells;
+        minY = cellY - _growMarginCells;
+        maxY = cellY + _growMarginCells;
+    } else {
+        minX = std::min(_gridMinX, cellX - _growMarginCells);
+        maxX = std::max(_gridMinX + _gridWidth - 1, cellX + _growMarginCells);
+        minY = std::min(_gridMinY, cellY - _growMarginCells);
+        maxY = std::max(_gridMinY + _gridHeight - 1, cellY + _growMarginCells);
+    }
+
+    // Drop the margin if that is what it takes to stay within the maximum size
+    if (maxX - minX + 1 > maxGridDimension) {
+        minX = std::min(_gridWidth ? _gridMinX : cellX, cellX);
+        maxX = std::max(_gridWidth ? _gridMinX + _gridWidth - 1 : cellX, cellX);
+    }
+    if (maxY - minY + 1 > maxGridDimension) {
+        minY = std::min(_gridHeight ? _gridMinY : cellY, cellY);
+        maxY = std::max(_gridHeight ? _gridMinY + _gridHeight - 1 : cellY, cellY);
+    }
+    if (maxX - minX + 1 > maxGridDimension || maxY - minY + 1 > maxGridDimension) {
+        return false;
+    }
+
+    int             newWidth    = maxX - minX + 1;
+    int             newHeight   = maxY - minY + 1;
+    QVector<Cell_t> newCells(newWidth * newHeight, Cell_t{ 0, 0, 0 });
+
+    for (int y=0; y<_gridHeight; y++) {
+        const Cell_t* src = &_cells[y * _gridWidth];
+        Cell_t*       dst = &newCells[((y + _gridMinY - minY) * newWidth) + (_gridMinX - minX)];
+        std::copy(src, src + _gridWidth, dst);
+    }
+
+    qCDebug(PulseHeatMapLog) << "Grid resized width:height" << newWidth << newHeight;
+
+    _gridMinX   = minX;
+    _gridMinY   = minY;
+    _gridWidth  = newWidth;
+    _gridHeight = newHeight;
+    _cells.swap(newCells);
+
+    _image = QImage(_gridWidth, _gridHeight, QImage::Format_ARGB32);
+    _repaintAll();
+
+    return true;
+}
+
+double PulseHeatMap::_cellValue(const Cell_t& cell) const
+{
+    return _mode == ModeMax ? cell.maxStrength : cell.sumStrength / cell.count;
+}
+
+void PulseHeatMap::_paintCell(int gridX, int gridY)
+{
+    const Cell_t& cell = _cells[(gridY * _gridWidth) + gridX];
+
+    // Image rows run north to south
+    int imageY = _gridHeight - 1 - gridY;
+
+    if (cell.count == 0) {
+        _image.setPixel(gridX, imageY, qRgba(0, 0, 0, 0));
+        return;
+    }
+
+    // Weak pulses are blue, strong pulses are red
+    double ratio = qBound(0.0, _cellValue(cell) / _maxStrength, 1.0);
+    _image.setPixelColor(gridX, imageY, QColor::fromHsvF((1.0 - ratio) * (240.0 / 360.0), 1.0, 1.0, 0.7));
+}
+
+void PulseHeatMap::_repaintAll(void)
+{
+    for (int y=0; y<_gridHeight; y++) {
+        for (int x=0; x<_gridWidth; x++) {
+            _paintCell(x, y);
+        }
+    }
+}
+
+void PulseHeatMap::_scheduleUpdate(void)
+{
+    // Image updates are throttled so a burst of pulses results in a single reload on the map
+    if (!_updateTimer.isActive()) {
+        _updateTimer.start();
+    }
+}
+
+PulseHeatMapImageProvider::PulseHeatMapImageProvider(PulseHeatMap* pulseHeatMap)
+    : QQuickImageProvider   (QQuickImageProvider::Image)
+    , _pulseHeatMap         (pulseHeatMap)
+{
+
+}
+
+QImage PulseHeatMapImageProvider::requestImage(const QString& /*id*/, QSize* size, const QSize& /*requestedSize*/)
+{
+    QImage image = _pulseHeatMap->image();
+
+    if (image.isNull()) {
+        // QML still asks for an image before the first pulse
+        image = QImage(1, 1, QImage::Format_ARGB32);
+        image.fill(Qt::transparent);
+    }
+    if (size) {
+        *size = image.size();
+    }
+
+    return image;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+
+#include <QObject>
+#include <QGeoCoordinate>
+#include <QImage>
+#include <QQuickImageProvider>
+#include <QTimer>
+#include <QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(PulseHeatMapLog)
+
+/// Aggregates pulse strengths into a geospatial grid of fixed size cells. Each pulse updates a single cell in place so
+/// memory is bounded by the area flown instead of the number of pulses. The grid is kept as an image which is shown on
+/// the map as a single layer.
+///
+/// Cells are laid out on a local tangent plane centered on the first pulse. Grid growth is padded so the grid is only
+/// re-laid out occasionally as the vehicle flies out of the current bounds.
+class PulseHeatMap : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        ModeMax     = 0,    ///< Cell shows the strongest pulse
+        ModeMean    = 1,    ///< Cell shows the average pulse strength
+    };
+    Q_ENUM(Mode)
+
+    PulseHeatMap(double resolutionMeters, double maxStrength, QObject* parent = nullptr);
+
+    Q_PROPERTY(bool             valid           READ valid          NOTIFY imageChanged)
+    Q_PROPERTY(QString          imageUrl        READ imageUrl       NOTIFY imageChanged)
+    Q_PROPERTY(QGeoCoordinate   topLeft         READ topLeft        NOTIFY imageChanged)
+    Q_PROPERTY(double           widthMeters     READ widthMeters    NOTIFY imageChanged)
+    Q_PROPERTY(double           heightMeters    READ heightMeters   NOTIFY imageChanged)
+    Q_PROPERTY(int              cellCount       READ cellCount      NOTIFY imageChanged)
+
+    void    addPulse        (const QGeoCoordinate& coord, double strength);
+    void    clear           (void);
+
+    /// Changing the resolution clears the grid since pulses are not kept
+    void    setResolution   (double resolutionMeters);
+    void    setMode         (Mode mode);
+    void    setMaxStrength  (double maxStrength);
+
+    bool            valid           (void) const { return _cellCount > 0; }
+    QString         imageUrl        (void) const;
+    QGeoCoordinate  topLeft         (void) const;
+    double          widthMeters     (void) const { return _gridWidth * _resolutionMeters; }
+    double          heightMeters    (void) const { return _gridHeight * _resolutionMeters; }
+    int             cellCount       (void) const { return _cellCount; }
+    QImage          image           (void) const { return _image; }
+
+    /// @return Cell value for the location based on the current mode, NaN if the cell has no pulses
+    double          cellValue       (const QGeoCoordinate& coord) const;
+
+    static constexpr int        maxGridDimension    = 2048;
+    static constexpr const char* imageProviderId    = "pulseHeatMap";
+
+signals:
+    void imageChanged(void);
+
+private:
+    typedef struct {
+        float       maxStrength;
+        float       sumStrength;
+        uint32_t    count;
+    } Cell_t;
+
+    bool    _cellIndex      (const QGeoCoordinate& coord, int& cellX, int& cellY) const;
+    bool    _growToInclude  (int cellX, int cellY);
+    double  _cellValue      (const Cell_t& cell) const;
+    void    _paintCell      (int gridX, int gridY);
+    void    _repaintAll     (void);
+    void    _scheduleUpdate (void);
+
+    double              _resolutionMeters;
+    double              _maxStrength;
+    Mode                _mode               = ModeMax;
+
+    QGeoCoordinate      _origin;
+    double              _metersPerDegreeLat = 0;
+    double              _metersPerDegreeLon = 0;
+
+    // Grid covers cells [_gridMinX, _gridMinX + _gridWidth) x [_gridMinY, _gridMinY + _gridHeight), Y is north
+    int                 _gridMinX           = 0;
+    int                 _gridMinY           = 0;
+    int                 _gridWidth          = 0;
+    int                 _gridHeight         = 0;
+    QVector<Cell_t>     _cells;
+    QImage              _image;
+    int                 _cellCount          = 0;
+
+    uint32_t            _revision           = 0;
+    QTimer              _updateTimer;
+
+    static constexpr int _growMarginCells   = 32;
+    static constexpr int _updateMsecs       = 500;
+};
+
+/// Serves the current heat map image to QML as image://pulseHeatMap/<revision>
+class PulseHeatMapImageProvider : public QQuickImageProvider
+{
+public:
+    PulseHeatMapImageProvider(PulseHeatMap* pulseHeatMap);
+
+    QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) final;
+
+private:
+    PulseHeatMap* _pulseHeatMap;
+};
@@ -0,0 +1,40 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick          2.3
+import QtLocation       5.15
+
+import QGroundControl   1.0
+
+/// Pulse strength heat map from all vehicles shown as a single image layer
+MapQuickItem {
+    coordinate:     _heatMap.topLeft
+    visible:        _heatMap.valid && _customSettings.showPulseOnMap.rawValue
+    anchorPoint.x:  0
+    anchorPoint.y:  0
+    zoomLevel:      _zoomLevel
+    z:              QGroundControl.zOrderWidgets - 2
+
+    property var customMapObject
+
+    property var    _heatMap:           customMapObject.heatMap
+    property var    _customSettings:    QGroundControl.corePlugin.customSettings
+    property real   _zoomLevel:         20
+    // Web mercator ground resolution at the fixed zoom level, this is what sizes the image in meters
+    property real   _metersPerPixel:    156543.03392 * Math.cos(_heatMap.topLeft.latitude * Math.PI / 180) / Math.pow(2, _zoomLevel)
+
+    sourceItem: Image {
+        width:      _heatMap.widthMeters / _metersPerPixel
+        height:     _heatMap.heightMeters / _metersPerPixel
+        source:     _heatMap.valid ? _heatMap.imageUrl : ""
+        smooth:     false
+        cache:      false
+        fillMode:   Image.Stretch
+    }
+}
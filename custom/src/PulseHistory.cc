@@ -0,0 +1,172 @@
+#include "PulseHistory.h"
+
+#include <algorithm>
+
+PulseHistory::PulseHistory(QObject* parent)
+    : QObject(parent)
+{
+
+}
+
+PulseHistory::~PulseHistory()
+{
+    qDeleteAll(_timeSeries);
+}
+
+QList<int> PulseHistory::tagIds(void) const
+{
+    QList<int> tagIds;
+
+    for (uint32_t tagId: _timeSeries.keys()) {
+        tagIds.append(static_cast<int>(tagId));
+    }
+
+    return tagIds;
+}
+
+void PulseHistory::addPulses(const PulseInfoPtrList& pulses)
+{
+    bool newTag     = false;
+    bool newSamples = false;
+
+    for (const PulseInfoPtr& pulseInfo: pulses) {
+        // Detector heartbeats have no metrics
+        if (!pulseInfo->confirmed_status || pulseInfo->frequency_hz == 0) {
+            continue;
+        }
+
+        PulseTimeSeries* timeSeries = _timeSeries.value(pulseInfo->tag_id, nullptr);
+        if (!timeSeries) {
+            timeSeries = new PulseTimeSeries();
+            _timeSeries[pulseInfo->tag_id] = timeSeries;
+            newTag = true;
+        }
+        timeSeries->addSample(static_cast<qint64>(pulseInfo->start_time_seconds * 1000.0), pulseInfo->snr, pulseInfo->stft_score, pulseInfo->noise_psd);
+        newSamples = true;
+    }
+
+    if (newTag) {
+        emit tagIdsChanged();
+    }
+    if (newSamples) {
+        emit samplesAdded();
+    }
+}
+
+void PulseHistory::clear(void)
+{
+    qDeleteAll(_timeSeries);
+    _timeSeries.clear();
+
+    emit tagIdsChanged();
+    emit samplesAdded();
+}
+
+PulseHistoryChartModel::PulseHistoryChartModel(QObject* parent)
+    : QObject(parent)
+{
+    _updateTimer.setSingleShot(true);
+    _updateTimer.setInterval(_updateMsecs);
+    connect(&_updateTimer, &QTimer::timeout, this, &PulseHistoryChartModel::update);
+}
+
+void PulseHistoryChartModel::setPulseHistory(PulseHistory* pulseHistory)
+{
+    if (pulseHistory == _pulseHistory) {
+        return;
+    }
+
+    if (_pulseHistory) {
+        disconnect(_pulseHistory, &PulseHistory::samplesAdded, this, &PulseHistoryChartModel::_scheduleUpdate);
+    }
+    _pulseHistory = pulseHistory;
+    if (_pulseHistory) {
+        connect(_pulseHistory, &PulseHistory::samplesAdded, this, &PulseHistoryChartModel::_scheduleUpdate);
+    }
+
+    emit pulseHistoryChanged();
+    _scheduleUpdate();
+}
+
+void PulseHistoryChartModel::setTagId(int tagId)
+{
+    if (tagId != _tagId) {
+        _tagId = tagId;
+        emit tagIdChanged();
+        _scheduleUpdate();
+    }
+}
+
+void PulseHistoryChartModel::setMetric(Metric metric)
+{
+    if (metric != _metric) {
+        _metric = metric;
+        emit metricChanged();
+        _scheduleUpdate();
+    }
+}
+
+void PulseHistoryChartModel::setWindowSecs(double windowSecs)
+{
+    if (!qFuzzyCompare(windowSecs, _windowSecs)) {
+        _windowSecs = windowSecs;
+        emit windowSecsChanged();
+        _scheduleUpdate();
+    }
+}
+
+void PulseHistoryChartModel::setPointCount(int pointCount)
+{
+    pointCount = std::max(pointCount, 3);
+    if (pointCount != _pointCount) {
+        _pointCount = pointCount;
+        emit pointCountChanged();
+        _scheduleUpdate();
+    }
+}
+
+void PulseHistoryChartModel::_scheduleUpdate(void)
+{
+    if (!_updateTimer.isActive()) {
+        _updateTimer.start();
+    }
+}
+
+void PulseHistoryChartModel::update(void)
+{
+    _updateTimer.stop();
+
+    _times.clear();
+    _minValues.clear();
+    _maxValues.clear();
+    _meanValues.clear();
+    _spanSecs   = 0;
+    _valueMin   = 0;
+    _valueMax   = 0;
+
+    const PulseTimeSeries* timeSeries = _pulseHistory ? _pulseHistory->timeSeries(static_cast<uint32_t>(_tagId)) : nullptr;
+    if (timeSeries && !timeSeries->isEmpty()) {
+        // The window always ends at the newest sample so the chart scrolls with the flight
+        qint64 toMsecs      = timeSeries->lastMsecs() + 1;
+        qint64 fromMsecs    = timeSeries->firstMsecs();
+        if (_windowSecs > 0) {
+            fromMsecs = std::max(fromMsecs, toMsecs - static_cast<qint64>(_windowSecs * 1000.0));
+        }
+        _spanSecs = (toMsecs - fromMsecs) / 1000.0;
+
+        const QVector<PulseTimeSeries::Point_t> points = timeSeries->query(static_cast<PulseTimeSeries::Metric_t>(_metric), fromMsecs, toMsecs, _pointCount);
+        for (const PulseTimeSeries::Point_t& point: points) {
+            // The first bucket can start before the window
+            _times.append(std::max(point.timeMsecs - fromMsecs, static_cast<qint64>(0)) / 1000.0);
+            _minValues.append(point.min);
+            _maxValues.append(point.max);
+            _meanValues.append(point.mean);
+        }
+        if (!points.isEmpty()) {
+            _valueMin = *std::min_element(_minValues.constBegin(), _minValues.constEnd());
+            _valueMax = *std::max_element(_maxValues.constBegin(), _maxValues.constEnd());
+        }
+    }
+
+    emit pointsChanged();
+}
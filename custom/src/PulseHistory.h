@@ -0,0 +1,112 @@
+#pragma once
+
+#include "PulseTimeSeries.h"
+#include "PulseIngest.h"
+
+#include <QObject>
+#include <QMap>
+#include <QPointer>
+#include <QTimer>
+
+/// Confirmed pulse metrics for each detector over the whole session, keyed by pulse tag id
+class PulseHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    PulseHistory(QObject* parent = nullptr);
+    ~PulseHistory();
+
+    Q_PROPERTY(QList<int> tagIds READ tagIds NOTIFY tagIdsChanged)
+
+    QList<int> tagIds(void) const;
+
+    /// Adds the confirmed pulses from a batch. Signals samplesAdded once for the batch.
+    void addPulses  (const PulseInfoPtrList& pulses);
+    void clear      (void);
+
+    /// @return nullptr: no pulses seen for the tag
+    const PulseTimeSeries* timeSeries(uint32_t tagId) const { return _timeSeries.value(tagId, nullptr); }
+
+signals:
+    void tagIdsChanged  (void);
+    void samplesAdded   (void);
+
+private:
+    QMap<uint32_t, PulseTimeSeries*> _timeSeries;
+};
+
+/// Downsampled view of one metric of one tag for drawing a chart from QML. The point count is fixed so a redraw costs
+/// the same no matter how long the flight has been going.
+class PulseHistoryChartModel : public QObject
+{
+    Q_OBJECT
+
+public:
+    PulseHistoryChartModel(QObject* parent = nullptr);
+
+    enum Metric {
+        MetricSnr       = PulseTimeSeries::MetricSnr,
+        MetricStftScore = PulseTimeSeries::MetricStftScore,
+        MetricNoisePsd  = PulseTimeSeries::MetricNoisePsd,
+    };
+    Q_ENUM(Metric)
+
+    Q_PROPERTY(PulseHistory*    pulseHistory    READ pulseHistory   WRITE setPulseHistory   NOTIFY pulseHistoryChanged)
+    Q_PROPERTY(int              tagId           READ tagId          WRITE setTagId          NOTIFY tagIdChanged)
+    Q_PROPERTY(Metric           metric          READ metric         WRITE setMetric         NOTIFY metricChanged)
+    Q_PROPERTY(double           windowSecs      READ windowSecs     WRITE setWindowSecs     NOTIFY windowSecsChanged)   ///< 0 for the whole session
+    Q_PROPERTY(int              pointCount      READ pointCount     WRITE setPointCount     NOTIFY pointCountChanged)
+
+    /// Point times are in seconds from the start of the window
+    Q_PROPERTY(QList<double>    times           MEMBER _times       NOTIFY pointsChanged)
+    Q_PROPERTY(QList<double>    minValues       MEMBER _minValues   NOTIFY pointsChanged)
+    Q_PROPERTY(QList<double>    maxValues       MEMBER _maxValues   NOTIFY pointsChanged)
+    Q_PROPERTY(QList<double>    meanValues      MEMBER _meanValues  NOTIFY pointsChanged)
+    Q_PROPERTY(double           spanSecs        MEMBER _spanSecs    NOTIFY pointsChanged)
+    Q_PROPERTY(double           valueMin        MEMBER _valueMin    NOTIFY pointsChanged)
+    Q_PROPERTY(double           valueMax        MEMBER _valueMax    NOTIFY pointsChanged)
+
+    PulseHistory*   pulseHistory    (void) const { return _pulseHistory; }
+    int             tagId           (void) const { return _tagId; }
+    Metric          metric          (void) const { return _metric; }
+    double          windowSecs      (void) const { return _windowSecs; }
+    int             pointCount      (void) const { return _pointCount; }
+
+    void setPulseHistory    (PulseHistory* pulseHistory);
+    void setTagId           (int tagId);
+    void setMetric          (Metric metric);
+    void setWindowSecs      (double windowSecs);
+    void setPointCount      (int pointCount);
+
+    /// Recalculates the points now instead of waiting for the update timer
+    void update             (void);
+
+signals:
+    void pulseHistoryChanged    (void);
+    void tagIdChanged           (void);
+    void metricChanged          (void);
+    void windowSecsChanged      (void);
+    void pointCountChanged      (void);
+    void pointsChanged          (void);
+
+private:
+    void _scheduleUpdate(void);
+
+    QPointer<PulseHistory>  _pulseHistory;
+    int                     _tagId          = 0;
+    Metric                  _metric         = MetricSnr;
+    double                  _windowSecs     = 0;
+    int                     _pointCount     = 100;
+
+    QList<double>           _times;
+    QList<double>           _minValues;
+    QList<double>           _maxValues;
+    QList<double>           _meanValues;
+    double                  _spanSecs       = 0;
+    double                  _valueMin       = 0;
+    double                  _valueMax       = 0;
+    QTimer                  _updateTimer;
+
+    static constexpr int _updateMsecs = 500;
+};
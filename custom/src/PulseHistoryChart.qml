@@ -0,0 +1,95 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick
+
+import QGroundControl
+import QGroundControl.Controls
+import QGroundControl.Palette
+import QGroundControl.ScreenTools
+
+/// Pulse metric history for a single detector. Shaded band is the min/max envelope, the line is the mean.
+Rectangle {
+    id:     root
+    color:  qgcPal.windowShade
+
+    property alias pulseHistory:    chartModel.pulseHistory
+    property alias tagId:           chartModel.tagId
+    property alias metric:          chartModel.metric
+    property alias windowSecs:      chartModel.windowSecs
+
+    QGCPalette { id: qgcPal; colorGroupEnabled: true }
+
+    PulseHistoryChartModel {
+        id:             chartModel
+        pointCount:     Math.max(Math.round(root.width / 3), 3)
+        onPointsChanged: canvas.requestPaint()
+    }
+
+    Canvas {
+        id:             canvas
+        anchors.fill:   parent
+
+        onPaint: {
+            var ctx = getContext("2d")
+            ctx.reset()
+
+            var count = chartModel.times.length
+            if (count === 0 || chartModel.spanSecs <= 0) {
+                return
+            }
+
+            var valueRange  = Math.max(chartModel.valueMax - chartModel.valueMin, 1e-6)
+            function x(i) { return (chartModel.times[i] / chartModel.spanSecs) * width }
+            function y(value) { return height - ((value - chartModel.valueMin) / valueRange) * height }
+
+            ctx.fillStyle = Qt.rgba(0, 0.8, 0.3, 0.3)
+            ctx.beginPath()
+            ctx.moveTo(x(0), y(chartModel.maxValues[0]))
+            for (var i = 1; i < count; i++) {
+                ctx.lineTo(x(i), y(chartModel.maxValues[i]))
+            }
+            for (i = count - 1; i >= 0; i--) {
+                ctx.lineTo(x(i), y(chartModel.minValues[i]))
+            }
+            ctx.closePath()
+            ctx.fill()
+
+            ctx.strokeStyle = "#00E04B"
+            ctx.lineWidth   = 1
+            ctx.beginPath()
+            ctx.moveTo(x(0), y(chartModel.meanValues[0]))
+            for (i = 1; i < count; i++) {
+                ctx.lineTo(x(i), y(chartModel.meanValues[i]))
+            }
+            ctx.stroke()
+        }
+    }
+
+    QGCLabel {
+        anchors.left:   parent.left
+        anchors.top:    parent.top
+        text:           chartModel.times.length ? chartModel.valueMax.toFixed(1) : qsTr("No pulses")
+        font.pointSize: ScreenTools.smallFontPointSize
+    }
+
+    QGCLabel {
+        anchors.left:   parent.left
+        anchors.bottom: parent.bottom
+        text:           chartModel.times.length ? chartModel.valueMin.toFixed(1) : ""
+        font.pointSize: ScreenTools.smallFontPointSize
+    }
+
+    QGCLabel {
+        anchors.right:  parent.right
+        anchors.bottom: parent.bottom
+        text:           chartModel.times.length ? qsTr("%1 secs").arg(chartModel.spanSecs.toFixed(0)) : ""
+        font.pointSize: ScreenTools.smallFontPointSize
+    }
+}
@@ -0,0 +1,83 @@
+#include "PulseIngest.h"
+
+#include <QDebug>
+#include <QDateTime>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(PulseIngestLog, "PulseIngestLog")
+
+PulseIngestWorker::PulseIngestWorker(int deliveryIntervalMsecs)
+    : _deliveryIntervalMsecs(deliveryIntervalMsecs)
+{
+
+}
+
+// Must be called on the worker thread
+void PulseIngestWorker::start(void)
+{
+    _deliveryTimer = new QTimer(this);
+    _deliveryTimer->setSingleShot(true);
+    _deliveryTimer->setInterval(_deliveryIntervalMsecs);
+    _deliveryTimer->callOnTimeout(this, &PulseIngestWorker::_deliverPulses);
+}
+
+void PulseIngestWorker::ingestTunnel(const mavlink_tunnel_t& tunnel, qint64 arrivalMsecs)
+{
+    if (tunnel.payload_length != sizeof(PulseInfo_t)) {
+        qCWarning(PulseIngestLog) << "Received incorrectly sized PulseInfo payload expected:actual" <<  sizeof(PulseInfo_t) << tunnel.payload_length;
+        if (tunnel.payload_length < sizeof(PulseInfo_t)) {
+            return;
+        }
+    }
+
+    auto pulseInfo = QSharedPointer<PulseInfo_t>::create();
+    memcpy(pulseInfo.data(), tunnel.payload, sizeof(PulseInfo_t));
+    _pendingPulses.append(pulseInfo);
+    _pendingArrivalMsecs.append(arrivalMsecs);
+
+    // The first pulse of a burst starts the delivery window, the rest of the burst rides along with it
+    if (!_deliveryTimer->isActive()) {
+        _deliveryTimer->start();
+    }
+}
+
+void PulseIngestWorker::_deliverPulses(void)
+{
+    if (_pendingPulses.isEmpty()) {
+        return;
+    }
+
+    PulseInfoPtrList    pulses;
+    QList<qint64>       arrivalMsecs;
+    pulses.swap(_pendingPulses);
+    arrivalMsecs.swap(_pendingArrivalMsecs);
+    emit pulsesDecoded(pulses, arrivalMsecs);
+}
+
+PulseIngest::PulseIngest(QObject* parent)
+    : QObject   (parent)
+    , _worker   (new PulseIngestWorker(_deliveryIntervalMsecs))
+{
+    qRegisterMetaType<PulseInfoPtrList>();
+
+    _thread.setObjectName("PulseIngest");
+    _worker->moveToThread(&_thread);
+    connect(&_thread, &QThread::finished, _worker, &QObject::deleteLater);
+    connect(_worker, &PulseIngestWorker::pulsesDecoded, this, &PulseIngest::pulsesReady, Qt::QueuedConnection);
+    _thread.start();
+
+    QMetaObject::invokeMethod(_worker, [this]() { _worker->start(); }, Qt::QueuedConnection);
+}
+
+PulseIngest::~PulseIngest()
+{
+    _thread.quit();
+    _thread.wait();
+}
+
+void PulseIngest::ingest(const mavlink_tunnel_t& tunnel)
+{
+    qint64 arrivalMsecs = QDateTime::currentMSecsSinceEpoch();
+    QMetaObject::invokeMethod(_worker, [worker = _worker, tunnel, arrivalMsecs]() { worker->ingestTunnel(tunnel, arrivalMsecs); }, Qt::QueuedConnection);
+}
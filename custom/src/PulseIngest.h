@@ -0,0 +1,66 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+#include "TunnelProtocol.h"
+#include "QGCMAVLink.h"
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QSharedPointer>
+#include <QList>
+
+Q_DECLARE_LOGGING_CATEGORY(PulseIngestLog)
+
+/// A decoded pulse. Decoded once by the ingest thread and then shared read-only by all consumers.
+typedef QSharedPointer<const TunnelProtocol::PulseInfo_t> PulseInfoPtr;
+typedef QList<PulseInfoPtr>                                PulseInfoPtrList;
+
+Q_DECLARE_METATYPE(PulseInfoPtrList)
+
+class PulseIngestWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    PulseIngestWorker(int deliveryIntervalMsecs);
+
+    void start          (void);
+    void ingestTunnel   (const mavlink_tunnel_t& tunnel, qint64 arrivalMsecs);
+
+signals:
+    void pulsesDecoded(const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs);
+
+private:
+    void _deliverPulses(void);
+
+    QTimer*             _deliveryTimer          = nullptr;
+    int                 _deliveryIntervalMsecs;
+    PulseInfoPtrList    _pendingPulses;
+    QList<qint64>       _pendingArrivalMsecs;   ///< Parallel to _pendingPulses
+};
+
+/// Decodes pulse tunnel messages on a dedicated thread. Decoded pulses are delivered back to the owning thread in
+/// batches at most once per delivery interval so pulse bursts turn into a single ui update.
+class PulseIngest : public QObject
+{
+    Q_OBJECT
+
+public:
+    PulseIngest(QObject* parent = nullptr);
+    ~PulseIngest();
+
+    /// Queues a COMMAND_ID_PULSE tunnel message for decoding, stamped with the time it arrived. Can be called from
+    /// any thread.
+    void ingest(const mavlink_tunnel_t& tunnel);
+
+signals:
+    /// @param arrivalMsecs Time each pulse was passed to ingest, parallel to pulses
+    void pulsesReady(const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs);
+
+private:
+    QThread             _thread;
+    PulseIngestWorker*  _worker = nullptr;
+
+    static constexpr int _deliveryIntervalMsecs = 100;
+};
@@ -0,0 +1,260 @@
+#include "PulseLog.h"
+
+#include <QDebug>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(PulseLogLog, "PulseLogLog")
+
+PulseLogWriter::PulseLogWriter(QObject* parent)
+    : QThread(parent)
+{
+    _pendingBatch.reserve(maxBatchRecords);
+    _writeBatchBuffer.reserve(maxBatchRecords);
+}
+
+PulseLogWriter::~PulseLogWriter()
+{
+    close();
+}
+
+bool PulseLogWriter::open(const QString& fileName)
+{
+    if (_open) {
+        qCWarning(PulseLogLog) << "open: log already open" << _fileName;
+        return false;
+    }
+
+    _fileName = fileName;
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(PulseLogLog) << "open: failed" << fileName << _file.errorString();
+        return false;
+    }
+
+    PulseLogHeader_t header;
+    memcpy(header.magic, PulseLogMagic, sizeof(header.magic));
+    header.schemaVersion    = PulseLogSchemaVersion;
+    header.headerSize       = sizeof(PulseLogHeader_t);
+    header.recordSize       = sizeof(PulseLogRecord_t);
+    header.pulseInfoSize    = sizeof(PulseInfo_t);
+    if (_file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header)) {
+        qCWarning(PulseLogLog) << "open: header write failed" << fileName << _file.errorString();
+        _file.close();
+        return false;
+    }
+
+    qCDebug(PulseLogLog) << "Pulse logging to:" << fileName;
+
+    _stopRequested  = false;
+    _open           = true;
+    start(QThread::LowPriority);
+
+    return true;
+}
+
+void PulseLogWriter::close(void)
+{
+    if (!_open) {
+        return;
+    }
+
+    QMutexLocker lock(&_batchMutex);
+    _stopRequested = true;
+    _batchWaitCondition.wakeAll();
+    lock.unlock();
+
+    // The writer thread drains the remaining batch before exiting
+    wait();
+
+    _file.close();
+    _open = false;
+}
+
+void PulseLogWriter::logPulse(const PulseInfo_t& pulseInfo, double antennaOffset)
+{
+    PulseLogRecord_t record;
+
+    memset(&record, 0, sizeof(record));
+    record.recordType       = PulseLogRecordPulse;
+    record.antennaOffset    = antennaOffset;
+    record.pulseInfo        = pulseInfo;
+
+    _enqueue(record);
+}
+
+void PulseLogWriter::logRotationStartStop(bool startRotation, double latitude, double longitude, double altitudeAMSL)
+{
+    PulseLogRecord_t record;
+
+    memset(&record, 0, sizeof(record));
+    record.recordType                   = startRotation ? PulseLogRecordRotationStart : PulseLogRecordRotationStop;
+    record.rotationInfo.latitude        = latitude;
+    record.rotationInfo.longitude       = longitude;
+    record.rotationInfo.altitudeAMSL    = altitudeAMSL;
+
+    _enqueue(record);
+}
+
+void PulseLogWriter::_enqueue(const PulseLogRecord_t& record)
+{
+    if (!_open) {
+        return;
+    }
+
+    QMutexLocker lock(&_batchMutex);
+    _pendingBatch.append(record);
+    if (_pendingBatch.count() >= maxBatchRecords) {
+        _batchWaitCondition.wakeAll();
+    }
+}
+
+void PulseLogWriter::run(void)
+{
+    QMutexLocker lock(&_batchMutex);
+
+    while (true) {
+        if (_pendingBatch.count() < maxBatchRecords && !_stopRequested) {
+            _batchWaitCondition.wait(lock.mutex(), flushIntervalMsecs);
+        }
+
+        // Swap buffers so the GUI thread can keep appending while we write
+        _writeBatchBuffer.swap(_pendingBatch);
+        bool stop = _stopRequested;
+
+        lock.unlock();
+        _writeBatch(_writeBatchBuffer);
+        _writeBatchBuffer.clear();
+        lock.relock();
+
+        if (stop && _pendingBatch.isEmpty()) {
+            break;
+        }
+    }
+}
+
+void PulseLogWriter::_writeBatch(const QVector<PulseLogRecord_t>& batch)
+{
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    qint64 cBytes = batch.count() * static_cast<qint64>(sizeof(PulseLogRecord_t));
+    if (_file.write(reinterpret_cast<const char*>(batch.constData()), cBytes) != cBytes) {
+        qCWarning(PulseLogLog) << "_writeBatch: write failed" << _fileName << _file.errorString();
+    }
+    _file.flush();
+}
+
+PulseLogReader::PulseLogReader(const QString& fileName)
+    : _file(fileName)
+{
+
+}
+
+bool PulseLogReader::open(void)
+{
+    if (!_file.open(QIODevice::ReadOnly)) {
+        _errorString = QStringLiteral("Open of '%1' failed: %2").arg(_file.fileName(), _file.errorString());
+        return false;
+    }
+
+    PulseLogHeader_t header;
+    if (_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)) {
+        _errorString = QStringLiteral("'%1' is too small to be a pulse log").arg(_file.fileName());
+        return false;
+    }
+    if (memcmp(header.magic, PulseLogMagic, sizeof(header.magic)) != 0) {
+        _errorString = QStringLiteral("'%1' is not a pulse log").arg(_file.fileName());
+        return false;
+    }
+    if (header.schemaVersion != PulseLogSchemaVersion || header.recordSize != sizeof(PulseLogRecord_t) || header.pulseInfoSize != sizeof(PulseInfo_t)) {
+        _errorString = QStringLiteral("'%1' has unsupported schema version:recordSize:pulseInfoSize %2:%3:%4").arg(_file.fileName()).arg(header.schemaVersion).arg(header.recordSize).arg(header.pulseInfoSize);
+        return false;
+    }
+    if (!_file.seek(header.headerSize)) {
+        _errorString = QStringLiteral("Seek in '%1' failed: %2").arg(_file.fileName(), _file.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+bool PulseLogReader::nextRecord(PulseLogRecord_t& record)
+{
+    // A short read means the writer was interrupted mid record, treat as end of file
+    return _file.read(reinterpret_cast<char*>(&record), sizeof(record)) == sizeof(record);
+}
+
+bool PulseLogReader::exportToCsv(const QString& pulseLogFileName, const QString& csvFileName, QString& errorString)
+{
+    PulseLogReader reader(pulseLogFileName);
+    if (!reader.open()) {
+        errorString = reader.errorString();
+        return false;
+    }
+
+    QFile csvFile(csvFileName);
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        errorString = QStringLiteral("Open of '%1' failed: %2").arg(csvFileName, csvFile.errorString());
+        return false;
+    }
+
+    PulseLogRecord_t    record;
+    bool                firstRecord = true;
+
+    while (reader.nextRecord(record)) {
+        switch (record.recordType) {
+        case PulseLogRecordPulse:
+        {
+            const PulseInfo_t& pulseInfo = record.pulseInfo;
+
+            // The csv header is only written when the log starts with a pulse. This matches the original csv writer.
+            if (firstRecord) {
+                csvFile.write(QString("# %1, tag_id, frequency_hz, start_time_seconds, predict_next_start_seconds, snr, stft_score, group_seq_counter, group_ind, group_snr, noise_psd, detection_status, confirmed_status, position_x, _y, _z, orientation_x, _y, _z, _w, antenna_offset\n")
+                    .arg(COMMAND_ID_PULSE)
+                    .toUtf8());
+            }
+            csvFile.write(QString("%1, %2, %3, %4, %5, %6, %7, %8, %9, %10, %11, %12, %13, %14, %15, %16, %17, %18, %19, %20, %21\n")
+                .arg(COMMAND_ID_PULSE)
+                .arg(pulseInfo.tag_id)
+                .arg(pulseInfo.frequency_hz)
+                .arg(pulseInfo.start_time_seconds,          0, 'f', 6)
+                .arg(pulseInfo.predict_next_start_seconds,  0, 'f', 6)
+                .arg(pulseInfo.snr,                         0, 'f', 6)
+                .arg(pulseInfo.stft_score,                  0, 'f', 6)
+                .arg(pulseInfo.group_seq_counter)
+                .arg(pulseInfo.group_ind)
+                .arg(pulseInfo.group_snr,                   0, 'f', 6)
+                .arg(pulseInfo.noise_psd,                   0, 'g', 7)
+                .arg(pulseInfo.detection_status)
+                .arg(pulseInfo.confirmed_status)
+                .arg(pulseInfo.position_x,                  0, 'f', 6)
+                .arg(pulseInfo.position_y,                  0, 'f', 6)
+                .arg(pulseInfo.position_z,                  0, 'f', 6)
+                .arg(pulseInfo.orientation_x,               0, 'f', 6)
+                .arg(pulseInfo.orientation_y,               0, 'f', 6)
+                .arg(pulseInfo.orientation_z,               0, 'f', 6)
+                .arg(pulseInfo.orientation_w,               0, 'f', 6)
+                .arg(record.antennaOffset,                  0, 'f', 6)
+                .toUtf8());
+            break;
+        }
+        case PulseLogRecordRotationStart:
+        case PulseLogRecordRotationStop:
+            csvFile.write(QString("%1,%2,%3,%4\n").arg(record.recordType == PulseLogRecordRotationStart ? COMMAND_ID_START_ROTATION : COMMAND_ID_STOP_ROTATION)
+                .arg(record.rotationInfo.latitude,      0, 'f', 6)
+                .arg(record.rotationInfo.longitude,     0, 'f', 6)
+                .arg(record.rotationInfo.altitudeAMSL,  0, 'f', 6)
+                .toUtf8());
+            break;
+        default:
+            qCWarning(PulseLogLog) << "exportToCsv: unknown record type" << record.recordType;
+            break;
+        }
+
+        firstRecord = false;
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+#include "TunnelProtocol.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QFile>
+
+Q_DECLARE_LOGGING_CATEGORY(PulseLogLog)
+
+// Binary pulse log file format
+//
+// The file starts with a single PulseLogHeader_t followed by any number of fixed size PulseLogRecord_t entries.
+// Records are written as raw packed structs in host byte order. Readers must validate the magic, schema version and
+// record size from the header before reading records. Any change to PulseInfo_t or PulseLogRecord_t requires a bump
+// of PulseLogSchemaVersion.
+
+static constexpr char       PulseLogMagic[8]        = { 'U', 'A', 'V', 'R', 'T', 'P', 'L', 'S' };
+static constexpr uint32_t   PulseLogSchemaVersion   = 1;
+static constexpr char       PulseLogFileExtension[] = "pulses";
+
+#pragma pack(push, 1)
+
+typedef struct {
+    char        magic[8];
+    uint32_t    schemaVersion;
+    uint32_t    headerSize;
+    uint32_t    recordSize;
+    uint32_t    pulseInfoSize;
+} PulseLogHeader_t;
+
+typedef enum {
+    PulseLogRecordPulse         = 1,
+    PulseLogRecordRotationStart = 2,
+    PulseLogRecordRotationStop  = 3,
+} PulseLogRecordType_t;
+
+typedef struct {
+    double latitude;
+    double longitude;
+    double altitudeAMSL;
+} PulseLogRotationInfo_t;
+
+typedef struct {
+    uint32_t    recordType;         // PulseLogRecordType_t
+    uint32_t    reserved;
+    double      antennaOffset;      // Only valid for PulseLogRecordPulse
+    union {
+        TunnelProtocol::PulseInfo_t pulseInfo;
+        PulseLogRotationInfo_t      rotationInfo;
+    };
+} PulseLogRecord_t;
+
+#pragma pack(pop)
+
+/// Writes pulse records to a binary pulse log from a background thread. Callers on the GUI thread only append the
+/// record to an in memory batch. The batch is written to disk when it fills or the flush interval expires.
+class PulseLogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    PulseLogWriter(QObject* parent = nullptr);
+    ~PulseLogWriter();
+
+    bool    open                (const QString& fileName);
+    void    close               (void);
+    bool    isOpen              (void) const { return _open; }
+    QString fileName            (void) const { return _fileName; }
+    void    logPulse            (const TunnelProtocol::PulseInfo_t& pulseInfo, double antennaOffset);
+    void    logRotationStartStop(bool startRotation, double latitude, double longitude, double altitudeAMSL);
+
+    static constexpr int maxBatchRecords    = 64;   ///< A full batch is written immediately
+    static constexpr int flushIntervalMsecs = 1000; ///< Partial batches are written at least this often
+
+protected:
+    void run() final;
+
+private:
+    void _enqueue       (const PulseLogRecord_t& record);
+    void _writeBatch    (const QVector<PulseLogRecord_t>& batch);
+
+    QString                     _fileName;
+    QFile                       _file;
+    bool                        _open           = false;
+    bool                        _stopRequested  = false;
+    QMutex                      _batchMutex;
+    QWaitCondition              _batchWaitCondition;
+    QVector<PulseLogRecord_t>   _pendingBatch;
+    QVector<PulseLogRecord_t>   _writeBatchBuffer;
+};
+
+/// Reads binary pulse logs
+class PulseLogReader
+{
+public:
+    PulseLogReader(const QString& fileName);
+
+    bool    open        (void);
+    bool    nextRecord  (PulseLogRecord_t& record);
+    QString errorString (void) const { return _errorString; }
+
+    /// Converts a binary pulse log to the csv format used by the Matlab bearing tools
+    ///     @return true: success, false: failure, see errorString
+    static bool exportToCsv(const QString& pulseLogFileName, const QString& csvFileName, QString& errorString);
+
+private:
+    QFile   _file;
+    QString _errorString;
+};
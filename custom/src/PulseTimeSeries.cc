@@ -0,0 +1,188 @@
+#include "PulseTimeSeries.h"
+
+#include <algorithm>
+#include <cmath>
+
+PulseTimeSeries::PulseTimeSeries(int bucketsPerLevel)
+    : _bucketsPerLevel  (std::max(bucketsPerLevel, 2))
+    , _levels           (levelCount)
+{
+    qint64 bucketMsecs = baseBucketMsecs;
+    for (Level_t& level: _levels) {
+        level.bucketMsecs = bucketMsecs;
+        bucketMsecs *= levelFactor;
+    }
+}
+
+const PulseTimeSeries::Bucket_t& PulseTimeSeries::_bucket(const Level_t& level, int age) const
+{
+    return level.ring[(level.newest - age + _bucketsPerLevel) % _bucketsPerLevel];
+}
+
+void PulseTimeSeries::addSample(qint64 timeMsecs, float snr, float stftScore, float noisePsd)
+{
+    const float values[MetricCount] = { snr, stftScore, noisePsd };
+
+    if (_sampleCount == 0) {
+        _firstMsecs = timeMsecs;
+    }
+    _sampleCount++;
+    _firstMsecs = std::min(_firstMsecs, timeMsecs);
+    _lastMsecs  = std::max(_lastMsecs, timeMsecs);
+
+    for (Level_t& level: _levels) {
+        qint64 startMsecs = timeMsecs - (timeMsecs % level.bucketMsecs);
+
+        // Samples which arrive late are folded into the newest bucket
+        if (level.count > 0 && level.ring[level.newest].startMsecs >= startMsecs) {
+            Bucket_t& bucket = level.ring[level.newest];
+            bucket.count++;
+            for (int metric=0; metric<MetricCount; metric++) {
+                bucket.min[metric] = std::min(bucket.min[metric], values[metric]);
+                bucket.max[metric] = std::max(bucket.max[metric], values[metric]);
+                bucket.sum[metric] += values[metric];
+            }
+            continue;
+        }
+
+        if (level.ring.isEmpty()) {
+            level.ring.resize(_bucketsPerLevel);
+        }
+        level.newest    = (level.newest + 1) % _bucketsPerLevel;
+        level.count     = std::min(level.count + 1, _bucketsPerLevel);
+
+        Bucket_t& bucket = level.ring[level.newest];
+        bucket.startMsecs   = startMsecs;
+        bucket.count        = 1;
+        for (int metric=0; metric<MetricCount; metric++) {
+            bucket.min[metric] = values[metric];
+            bucket.max[metric] = values[metric];
+            bucket.sum[metric] = values[metric];
+        }
+    }
+}
+
+int PulseTimeSeries::levelForRange(qint64 fromMsecs, qint64 toMsecs, int maxPoints) const
+{
+    qint64 maxBuckets = static_cast<qint64>(std::max(maxPoints, 3)) * lttbOversample;
+
+    for (int i=0; i<levelCount-1; i++) {
+        const Level_t& level = _levels[i];
+
+        // The level must still hold the start of the range, history which has rolled off is only in coarser levels
+        qint64 cBuckets = ((toMsecs - fromMsecs) + level.bucketMsecs - 1) / level.bucketMsecs;
+        if (cBuckets <= maxBuckets && (level.count < _bucketsPerLevel || _oldestMsecs(level) <= fromMsecs)) {
+            return i;
+        }
+    }
+
+    return levelCount - 1;
+}
+
+QVector<PulseTimeSeries::Point_t> PulseTimeSeries::query(Metric_t metric, qint64 fromMsecs, qint64 toMsecs, int maxPoints) const
+{
+    QVector<Point_t> points;
+
+    if (_sampleCount == 0 || toMsecs <= fromMsecs) {
+        return points;
+    }
+    maxPoints = std::max(maxPoints, 3);
+
+    // Newest to oldest, stopping at the start of the range
+    const Level_t&              level = _levels[levelForRange(fromMsecs, toMsecs, maxPoints)];
+    QVector<const Bucket_t*>    buckets;
+    for (int age=0; age<level.count; age++) {
+        const Bucket_t& bucket = _bucket(level, age);
+        if (bucket.startMsecs + level.bucketMsecs <= fromMsecs) {
+            break;
+        }
+        if (bucket.startMsecs < toMsecs) {
+            buckets.append(&bucket);
+        }
+    }
+    std::reverse(buckets.begin(), buckets.end());
+
+    QVector<QPointF> means;
+    means.reserve(buckets.count());
+    for (const Bucket_t* bucket: buckets) {
+        means.append(QPointF(bucket->startMsecs, bucket->sum[metric] / bucket->count));
+    }
+
+    // Each picked point carries the envelope of the LTTB bin it was picked from so narrow peaks are not lost
+    QVector<int>    picked  = lttb(means, maxPoints);
+    int             n       = means.count();
+    double          every   = picked.count() > 2 ? static_cast<double>(n - 2) / (picked.count() - 2) : 0;
+    points.reserve(picked.count());
+    for (int i=0; i<picked.count(); i++) {
+        int binStart    = picked[i];
+        int binEnd      = picked[i] + 1;
+        if (picked.count() < n && i > 0 && i < picked.count() - 1) {
+            binStart    = static_cast<int>(std::floor((i - 1) * every)) + 1;
+            binEnd      = static_cast<int>(std::floor(i * every)) + 1;
+        }
+
+        Point_t point;
+        point.timeMsecs = buckets[picked[i]]->startMsecs;
+        point.mean      = static_cast<float>(means[picked[i]].y());
+        point.min       = buckets[binStart]->min[metric];
+        point.max       = buckets[binStart]->max[metric];
+        for (int j=binStart+1; j<binEnd; j++) {
+            point.min = std::min(point.min, buckets[j]->min[metric]);
+            point.max = std::max(point.max, buckets[j]->max[metric]);
+        }
+        points.append(point);
+    }
+
+    return points;
+}
+
+QVector<int> PulseTimeSeries::lttb(const QVector<QPointF>& points, int pointCount)
+{
+    QVector<int>    picked;
+    int             n = points.count();
+
+    if (pointCount >= n || pointCount < 3) {
+        for (int i=0; i<n; i++) {
+            picked.append(i);
+        }
+        return picked;
+    }
+
+    // First and last points are always kept, the rest are split into pointCount - 2 bins. From each bin the point
+    // which makes the largest triangle with the previous pick and the average of the next bin is kept.
+    double every = static_cast<double>(n - 2) / (pointCount - 2);
+    int    a     = 0;
+
+    picked.reserve(pointCount);
+    picked.append(0);
+    for (int i=0; i<pointCount-2; i++) {
+        int nextStart   = static_cast<int>(std::floor((i + 1) * every)) + 1;
+        int nextEnd     = std::min(static_cast<int>(std::floor((i + 2) * every)) + 1, n);
+        double avgX     = 0;
+        double avgY     = 0;
+        for (int j=nextStart; j<nextEnd; j++) {
+            avgX += points[j].x();
+            avgY += points[j].y();
+        }
+        avgX /= (nextEnd - nextStart);
+        avgY /= (nextEnd - nextStart);
+
+        int     binStart    = static_cast<int>(std::floor(i * every)) + 1;
+        int     binEnd      = static_cast<int>(std::floor((i + 1) * every)) + 1;
+        double  maxArea     = -1;
+        int     maxIndex    = binStart;
+        for (int j=binStart; j<binEnd; j++) {
+            double area = std::abs(((points[a].x() - avgX) * (points[j].y() - points[a].y())) -
+                                   ((points[a].x() - points[j].x()) * (avgY - points[a].y())));
+            if (area > maxArea) {
+                maxArea     = area;
+                maxIndex    = j;
+            }
+        }
+        picked.append(maxIndex);
+        a = maxIndex;
+    }
+    picked.append(n - 1);
+
+    return picked;
+}
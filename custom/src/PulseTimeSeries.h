@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QPointF>
+#include <QVector>
+
+/// Pulse metrics for a single tag over a whole flight. Samples are folded into fixed time buckets at several
+/// resolutions, each level a ring of the same size whose buckets are levelFactor times longer than the level below.
+/// Each bucket keeps the min, max and mean of every metric. Adding a sample and querying a time range are both bounded
+/// by the ring size so neither gets slower as the flight gets longer. Older history is only kept at coarser levels.
+class PulseTimeSeries
+{
+public:
+    typedef enum {
+        MetricSnr,
+        MetricStftScore,
+        MetricNoisePsd,
+        MetricCount,
+    } Metric_t;
+
+    struct Point_t {
+        qint64  timeMsecs;  ///< Start of the bucket picked for this point
+        float   min;        ///< Envelope of all the buckets the point stands in for
+        float   max;
+        float   mean;       ///< Mean of the picked bucket
+    };
+
+    PulseTimeSeries(int bucketsPerLevel = defaultBucketsPerLevel);
+
+    void    addSample   (qint64 timeMsecs, float snr, float stftScore, float noisePsd);
+
+    /// Downsamples the buckets in [fromMsecs, toMsecs) to at most maxPoints points. The finest level with no more
+    /// than maxPoints * lttbOversample buckets in the range is used, then LTTB picks the points from those.
+    QVector<Point_t> query(Metric_t metric, qint64 fromMsecs, qint64 toMsecs, int maxPoints) const;
+
+    /// @return Level query uses for the range
+    int     levelForRange   (qint64 fromMsecs, qint64 toMsecs, int maxPoints) const;
+
+    bool    isEmpty         (void) const { return _sampleCount == 0; }
+    qint64  sampleCount     (void) const { return _sampleCount; }
+    qint64  firstMsecs      (void) const { return _firstMsecs; }
+    qint64  lastMsecs       (void) const { return _lastMsecs; }
+    qint64  bucketMsecs     (int level) const { return _levels[level].bucketMsecs; }
+
+    /// Largest-Triangle-Three-Buckets downsampling
+    /// @return Indices of the points to keep, always includes the first and last point
+    static QVector<int> lttb(const QVector<QPointF>& points, int pointCount);
+
+    static constexpr int    levelCount              = 7;
+    static constexpr int    levelFactor             = 4;
+    static constexpr qint64 baseBucketMsecs         = 250;
+    static constexpr int    defaultBucketsPerLevel  = 1024;
+    static constexpr int    lttbOversample          = 4;
+
+private:
+    struct Bucket_t {
+        qint64      startMsecs;
+        uint32_t    count;
+        float       min[MetricCount];
+        float       max[MetricCount];
+        double      sum[MetricCount];
+    };
+
+    struct Level_t {
+        qint64              bucketMsecs;
+        QVector<Bucket_t>   ring;           ///< Allocated on first sample
+        int                 newest  = -1;
+        int                 count   = 0;
+    };
+
+    const Bucket_t& _bucket         (const Level_t& level, int age) const;
+    qint64          _oldestMsecs    (const Level_t& level) const { return _bucket(level, level.count - 1).startMsecs; }
+
+    int                 _bucketsPerLevel;
+    QVector<Level_t>    _levels;
+    qint64              _sampleCount    = 0;
+    qint64              _firstMsecs     = 0;
+    qint64              _lastMsecs      = 0;
+};
@@ -0,0 +1,252 @@
+#include "SpectrogramPyramid.h"
+
+#include <QColor>
+#include <QtEndian>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+SpectrogramPyramid::SpectrogramPyramid(qint64 fileSize, int maxCacheBytes)
+    : _frameCount   (fileSize / bytesPerFrame)
+    , _tiles        (std::max(maxCacheBytes, tileBytes))
+    , _window       (fftSize)
+    , _minDb        (std::numeric_limits<float>::max())
+    , _maxDb        (std::numeric_limits<float>::lowest())
+    , _palette      (256)
+{
+    while (rowCount(_levelCount - 1) > tileRows) {
+        _levelCount++;
+    }
+
+    // Hann window, power is normalized by the window gain so levels don't depend on fftSize
+    double windowSum = 0;
+    for (int i=0; i<fftSize; i++) {
+        _window[i] = static_cast<float>(0.5 - (0.5 * qCos((2.0 * M_PI * i) / fftSize)));
+        windowSum += _window[i];
+    }
+    _windowPowerGain = static_cast<float>(windowSum * windowSum);
+
+    // Same blue to red ramp as the pulse heat map
+    for (int i=0; i<_palette.count(); i++) {
+        double ratio = static_cast<double>(i) / (_palette.count() - 1);
+        _palette[i] = QColor::fromHsvF((1.0 - ratio) * (240.0 / 360.0), 1.0, 0.25 + (0.75 * ratio)).rgb();
+    }
+}
+
+int SpectrogramPyramid::_framesForRow(int level, qint64 row) const
+{
+    qint64 firstFrame = row << level;
+
+    return static_cast<int>(std::min({ static_cast<qint64>(1) << level, static_cast<qint64>(maxFramesPerRow), _frameCount - firstFrame }));
+}
+
+SpectrogramPyramid::Fetch_t SpectrogramPyramid::fetchForRows(int level, qint64 firstRow, int rowCount) const
+{
+    Fetch_t fetch;
+
+    fetch.level     = level;
+    fetch.firstRow  = firstRow;
+    fetch.rowCount  = _readsAllFrames(level) ? rowCount : 1;
+
+    qint64 firstFrame   = firstRow << level;
+    qint64 frameCount   = 0;
+    if (_readsAllFrames(level)) {
+        frameCount = std::min((firstRow + fetch.rowCount) << level, _frameCount) - firstFrame;
+    } else {
+        frameCount = _framesForRow(level, firstRow);
+    }
+
+    fetch.offset    = static_cast<uint32_t>(firstFrame * bytesPerFrame);
+    fetch.size      = static_cast<uint32_t>(std::max(frameCount, static_cast<qint64>(0)) * bytesPerFrame);
+
+    return fetch;
+}
+
+bool SpectrogramPyramid::nextFetch(int level, qint64 firstRow, int rowCount, Fetch_t& fetch) const
+{
+    firstRow = std::max(firstRow, static_cast<qint64>(0));
+    qint64 endRow = std::min(firstRow + rowCount, this->rowCount(level));
+    if (endRow <= firstRow) {
+        return false;
+    }
+
+    int stride = 1;
+    while (stride * 2 < endRow - firstRow) {
+        stride *= 2;
+    }
+
+    for (; stride >= 1; stride /= 2) {
+        for (qint64 row=firstRow; row<endRow; row+=stride) {
+            if (rowAvailable(level, row)) {
+                continue;
+            }
+
+            int fetchRows = 1;
+            if (stride == 1 && _readsAllFrames(level)) {
+                // Last pass reads runs of missing rows in one go, bounded so a single read stays short
+                int maxRows = std::max((maxFramesPerRow * 4) >> level, 1);
+                while (fetchRows < maxRows && row + fetchRows < endRow && !rowAvailable(level, row + fetchRows)) {
+                    fetchRows++;
+                }
+            }
+            fetch = fetchForRows(level, row, fetchRows);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SpectrogramPyramid::addFetchData(const Fetch_t& fetch, const QByteArray& data)
+{
+    qint64 fetchFirstFrame = fetch.firstRow << fetch.level;
+
+    for (qint64 row=fetch.firstRow; row<fetch.firstRow+fetch.rowCount && row<rowCount(fetch.level); row++) {
+        qint64  dataOffset  = ((row << fetch.level) - fetchFirstFrame) * bytesPerFrame;
+        int     frameCount  = _framesForRow(fetch.level, row);
+
+        if (dataOffset + (static_cast<qint64>(frameCount) * bytesPerFrame) > data.size()) {
+            break;
+        }
+
+        qint64  tileIndex   = row / tileRows;
+        qint64  key         = _tileKey(fetch.level, tileIndex);
+        Tile_t* tile        = _tiles.object(key);
+        if (!tile) {
+            tile = new Tile_t;
+            tile->powerDb.resize(tileRows * fftSize);
+            tile->valid.resize(tileRows);
+            _tiles.insert(key, tile, tileBytes);
+        }
+
+        int tileRow = static_cast<int>(row % tileRows);
+        _decodeRow(data.constData() + dataOffset, frameCount, tile->powerDb.data() + (tileRow * fftSize));
+        tile->valid.setBit(tileRow);
+    }
+}
+
+void SpectrogramPyramid::_decodeRow(const char* frames, int frameCount, float* powerDb)
+{
+    QVector<std::complex<float>>    bins    (fftSize);
+    QVector<float>                  power   (fftSize, 0.0f);
+
+    for (int frame=0; frame<frameCount; frame++) {
+        const char* samples = frames + (frame * bytesPerFrame);
+
+        for (int i=0; i<fftSize; i++) {
+            float sampleI = qFromLittleEndian<float>(samples + (i * bytesPerSample));
+            float sampleQ = qFromLittleEndian<float>(samples + (i * bytesPerSample) + sizeof(float));
+            bins[i] = std::complex<float>(sampleI, sampleQ) * _window[i];
+        }
+        fft(bins);
+        for (int i=0; i<fftSize; i++) {
+            power[i] += std::norm(bins[i]);
+        }
+    }
+
+    // Swap halves so negative frequencies are on the left
+    for (int i=0; i<fftSize; i++) {
+        float   binPower    = power[(i + (fftSize / 2)) % fftSize] / (frameCount * _windowPowerGain);
+        float   db          = 10.0f * std::log10(binPower + 1e-20f);
+
+        powerDb[i] = db;
+        if (std::isfinite(db) && db > -190.0f) {
+            _minDb = std::min(_minDb, db);
+            _maxDb = std::max(_maxDb, db);
+        }
+    }
+}
+
+const float* SpectrogramPyramid::_row(int level, qint64 row) const
+{
+    if (level < 0 || level >= _levelCount || row < 0 || row >= rowCount(level)) {
+        return nullptr;
+    }
+
+    const Tile_t* tile = _tiles.object(_tileKey(level, row / tileRows));
+    if (!tile || !tile->valid.testBit(static_cast<int>(row % tileRows))) {
+        return nullptr;
+    }
+
+    return tile->powerDb.constData() + ((row % tileRows) * fftSize);
+}
+
+QImage SpectrogramPyramid::render(int level, qint64 firstRow, int rowCount) const
+{
+    QImage image(fftSize, std::max(rowCount, 1), QImage::Format_RGB32);
+
+    image.fill(Qt::black);
+
+    float dbRange = std::max(_maxDb - _minDb, 1.0f);
+
+    for (int imageRow=0; imageRow<rowCount; imageRow++) {
+        qint64          row         = firstRow + imageRow;
+        const float*    powerDb     = nullptr;
+
+        // Fall back to coarser levels until the row is read
+        for (int rowLevel=level; rowLevel<_levelCount && !powerDb; rowLevel++) {
+            powerDb = _row(rowLevel, row >> (rowLevel - level));
+        }
+        if (!powerDb) {
+            continue;
+        }
+
+        QRgb* scanLine = reinterpret_cast<QRgb*>(image.scanLine(imageRow));
+        for (int i=0; i<fftSize; i++) {
+            float ratio = qBound(0.0f, (powerDb[i] - _minDb) / dbRange, 1.0f);
+            scanLine[i] = _palette[static_cast<int>(ratio * (_palette.count() - 1))];
+        }
+    }
+
+    return image;
+}
+
+double SpectrogramPyramid::coverage(int level, qint64 firstRow, int rowCount) const
+{
+    qint64 endRow = std::min(firstRow + rowCount, this->rowCount(level));
+    if (endRow <= firstRow) {
+        return 1.0;
+    }
+
+    int cAvailable = 0;
+    for (qint64 row=firstRow; row<endRow; row++) {
+        if (rowAvailable(level, row)) {
+            cAvailable++;
+        }
+    }
+
+    return static_cast<double>(cAvailable) / (endRow - firstRow);
+}
+
+void SpectrogramPyramid::fft(QVector<std::complex<float>>& data)
+{
+    int count = data.count();
+
+    // Bit reversal permutation
+    for (int i=1, j=0; i<count; i++) {
+        int bit = count >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    for (int length=2; length<=count; length<<=1) {
+        std::complex<float> step = std::polar(1.0f, static_cast<float>(-2.0 * M_PI / length));
+        for (int start=0; start<count; start+=length) {
+            std::complex<float> twiddle(1.0f, 0.0f);
+            for (int i=0; i<length/2; i++) {
+                std::complex<float> even    = data[start + i];
+                std::complex<float> odd     = data[start + i + (length / 2)] * twiddle;
+                data[start + i]                 = even + odd;
+                data[start + i + (length / 2)]  = even - odd;
+                twiddle *= step;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QVector>
+
+#include <complex>
+
+/// Decimated spectrogram of an IQ capture file which is read a piece at a time. Level 0 has one row per FFT frame
+/// and each level above it halves the number of rows. A row above level 0 is the average of a bounded number of
+/// frames from the start of the span it covers, so an overview of a large file only needs a small part of it.
+///
+/// Rows are kept in fixed size tiles in a cache with a byte limit. Rows which have not been read yet are drawn from
+/// the nearest coarser level which has them, so the image fills in progressively.
+///
+/// Samples are interleaved little endian float32 I/Q.
+class SpectrogramPyramid
+{
+public:
+    struct Fetch_t {
+        int         level;
+        qint64      firstRow;
+        int         rowCount;
+        uint32_t    offset;     ///< File offset of first byte to read
+        uint32_t    size;       ///< Number of bytes to read
+    };
+
+    SpectrogramPyramid(qint64 fileSize, int maxCacheBytes);
+
+    /// Top level always fits in a single tile
+    int     levelCount      (void) const { return _levelCount; }
+    qint64  rowCount        (int level) const { return (_frameCount + (Q_INT64_C(1) << level) - 1) >> level; }
+    qint64  frameCount      (void) const { return _frameCount; }
+
+    /// Finds the next piece of the file to read for the specified rows. Rows are handed out coarse to fine across the
+    /// whole range so a partially read range is evenly filled. The cache must be able to hold the tiles for the range.
+    /// @return false: all rows are available
+    bool    nextFetch       (int level, qint64 firstRow, int rowCount, Fetch_t& fetch) const;
+
+    /// @return Fetch which covers the specified rows. Levels which don't read every frame only fetch a single row.
+    Fetch_t fetchForRows    (int level, qint64 firstRow, int rowCount) const;
+
+    /// Decodes the data read for a fetch into rows. A short read only fills the rows it fully covers.
+    void    addFetchData    (const Fetch_t& fetch, const QByteArray& data);
+
+    /// Renders rows into an image fftSize wide and rowCount high. Time goes down, DC is in the center.
+    QImage  render          (int level, qint64 firstRow, int rowCount) const;
+
+    /// @return Fraction of the rows which are available at the level itself
+    double  coverage        (int level, qint64 firstRow, int rowCount) const;
+
+    bool    rowAvailable    (int level, qint64 row) const { return _row(level, row) != nullptr; }
+    qint64  cacheBytes      (void) const { return _tiles.totalCost(); }
+
+    /// In place radix-2 FFT, size must be a power of two
+    static void fft(QVector<std::complex<float>>& data);
+
+    static constexpr int fftSize            = 256;
+    static constexpr int bytesPerSample     = 2 * sizeof(float);
+    static constexpr int bytesPerFrame      = fftSize * bytesPerSample;
+    static constexpr int tileRows           = 256;
+    static constexpr int maxFramesPerRow    = 8;
+    static constexpr int tileBytes          = tileRows * fftSize * sizeof(float);
+
+private:
+    struct Tile_t {
+        QVector<float>  powerDb;    ///< tileRows x fftSize
+        QBitArray       valid;
+    };
+
+    int             _framesForRow   (int level, qint64 row) const;
+    const float*    _row            (int level, qint64 row) const;
+    void            _decodeRow      (const char* frames, int frameCount, float* powerDb);
+    bool            _readsAllFrames (int level) const { return (1 << level) <= maxFramesPerRow; }
+
+    static qint64   _tileKey        (int level, qint64 tileIndex) { return (static_cast<qint64>(level) << 48) | tileIndex; }
+
+    qint64                  _frameCount;
+    int                     _levelCount     = 1;
+    QCache<qint64, Tile_t>  _tiles;
+    QVector<float>          _window;
+    float                   _windowPowerGain;
+    float                   _minDb          = 0;    ///< Color range, from everything decoded so far
+    float                   _maxDb          = 0;
+    QVector<QRgb>           _palette;
+};
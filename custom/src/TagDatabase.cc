@@ -5,260 +5,305 @@
 #include "QGCApplication.h"
 #include "AppSettings.h"
 #include "SettingsManager.h"
+#include "CustomPlugin.h"
+#include "CustomSettings.h"
+#include "ChannelizerTuner.h"
 
 #include <QFile>
+#include <QSaveFile>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 //#define DEBUG_TUNER
 
-TagInfo::TagInfo(TagDatabase* parent)
+static Fact* _newFact(FactMetaData* metaData, const QVariant& rawValue, QObject* parent)
 {
-    _initCommon(parent);
+    Fact* fact = new Fact(-1, metaData->name(), metaData->type(), parent);
 
-    uint32_t manufacturerId = 1;
-    if (_parent->_tagManufacturerListModel->count() > 0) {
-        TagManufacturer* tagManufacturer = _parent->_tagManufacturerListModel->value<TagManufacturer*>(0);
-        manufacturerId = tagManufacturer->_idFact->rawValue().toUInt();
-    } else {
-        qWarning() << "TagInfo::TagInfo(default) - Internal error: no TagManufacturer objects found.";
-    }
-    _init(
-        false,                      // selected
-        _parent->_nextTagInfoId(),
-        _nextTagName(),
-        manufacturerId,
-        _tagInfoMetaData["freq_hz"]->rawDefaultValue().toUInt());
-}
+    fact->setMetaData(metaData, false /* setDefaultFromMetaData */);
+    fact->setRawValue(rawValue);
 
-TagInfo::TagInfo(bool selected, uint32_t id, QString& name, uint32_t manufacturerId, uint32_t frequencyHz, TagDatabase* parent)
-{
-    _initCommon(parent);
-    _init(selected, id, name, manufacturerId, frequencyHz);
+    return fact;
 }
 
-QString TagInfo::_nextTagName()
+TagInfo::TagInfo(const TagRecord_t& record, TagDatabase* parent)
+    : _parent   (parent)
+    , _recordId (record.id)
 {
-    QString nextNameFmt("Tag %1");
+    const QMap<QString, FactMetaData*>& metaData = _parent->_tagInfoMetaData();
 
-    int nextIndex = 1;
-    QString nextName = nextNameFmt.arg(nextIndex);
-    while (true) {
-        bool duplicate = false;
-        for (int i=0; i<_parent->_tagInfoListModel->count(); i++) {
-            TagInfo* tagInfo = _parent->_tagInfoListModel->value<TagInfo*>(i);
-            if (tagInfo->_nameFact->rawValue().toString() == nextName) {
-                duplicate = true;
-                break;
-            }
-        }
-        if (duplicate) {
-            nextIndex++;
-            nextName = nextNameFmt.arg(nextIndex);
-        } else {
-            return nextName;
-        }
+    _selectedFact       = _newFact(metaData["selected"],        record.selected,        this);
+    _idFact             = _newFact(metaData["id"],              record.id,              this);
+    _nameFact           = _newFact(metaData["name"],            record.name,            this);
+    _manufacturerIdFact = _newFact(metaData["manufacturerId"],  record.manufacturerId,  this);
+    _frequencyHzFact    = _newFact(metaData["freq_hz"],         record.frequencyHz,     this);
+
+    for (Fact* fact: { _selectedFact, _idFact, _nameFact, _manufacturerIdFact, _frequencyHzFact }) {
+        connect(fact, &Fact::rawValueChanged, this, [this]() { _parent->_tagInfoChanged(this); });
     }
 }
 
-void TagInfo::_initCommon(TagDatabase* parent)
+TagManufacturer::TagManufacturer(const ManufacturerRecord_t& record, TagDatabase* parent)
+    : _parent   (parent)
+    , _recordId (record.id)
 {
-    _parent = parent;
+    const QMap<QString, FactMetaData*>& metaData = _parent->_tagManufacturerMetaData();
+
+    _idFact                     = _newFact(metaData["id"],                      record.id,                      this);
+    _nameFact                   = _newFact(metaData["name"],                    record.name,                    this);
+    _ip_msecs_1Fact             = _newFact(metaData["ip_msecs_1"],              record.ip_msecs_1,              this);
+    _ip_msecs_2Fact             = _newFact(metaData["ip_msecs_2"],              record.ip_msecs_2,              this);
+    _ip_msecs_1_idFact          = _newFact(metaData["ip_msecs_1_id"],           record.ip_msecs_1_id,           this);
+    _ip_msecs_2_idFact          = _newFact(metaData["ip_msecs_2_id"],           record.ip_msecs_2_id,           this);
+    _pulse_width_msecsFact      = _newFact(metaData["pulse_width_msecs"],       record.pulse_width_msecs,       this);
+    _ip_uncertainty_msecsFact   = _newFact(metaData["ip_uncertainty_msecs"],    record.ip_uncertainty_msecs,    this);
+    _ip_jitter_msecsFact        = _newFact(metaData["ip_jitter_msecs"],         record.ip_jitter_msecs,         this);
 
-    if (_tagInfoMetaData.isEmpty()) {
-        _tagInfoMetaData = FactMetaData::createMapFromJsonFile(":/json/TagInfo.json", this);
+    for (Fact* fact: { _idFact, _nameFact, _ip_msecs_1Fact, _ip_msecs_2Fact, _ip_msecs_1_idFact, _ip_msecs_2_idFact,
+                       _pulse_width_msecsFact, _ip_uncertainty_msecsFact, _ip_jitter_msecsFact }) {
+        connect(fact, &Fact::rawValueChanged, this, [this]() { _parent->_tagManufacturerChanged(this); });
     }
 }
 
-void TagInfo::_init(bool selected, uint32_t id, const QString& name, uint32_t manufacturerId, uint32_t frequencyHz)
+TagDatabase::TagDatabase(QObject* parent, const QString& dirPath)
+    : QObject   (parent)
+    , _dirPath  (dirPath)
 {
-    FactMetaData* selectedMetaData          = _tagInfoMetaData["selected"];
-    FactMetaData* idMetaData                = _tagInfoMetaData["id"];
-    FactMetaData* nameMetaData              = _tagInfoMetaData["name"];
-    FactMetaData* manufacturerIdMetaData    = _tagInfoMetaData["manufacturerId"];
-    FactMetaData* frequencyHzMetaData       = _tagInfoMetaData["freq_hz"];
-
-    _selectedFact       = new Fact(-1, selectedMetaData->name(),        selectedMetaData->type(),       this);
-    _idFact             = new Fact(-1, idMetaData->name(),              idMetaData->type(),             this);
-    _nameFact           = new Fact(-1, nameMetaData->name(),            nameMetaData->type(),           this);
-    _manufacturerIdFact = new Fact(-1, manufacturerIdMetaData->name(),  manufacturerIdMetaData->type(), this);
-    _frequencyHzFact    = new Fact(-1, frequencyHzMetaData->name(),     frequencyHzMetaData->type(),    this);
-
-    _selectedFact->setMetaData(selectedMetaData, false /* setDefaultFromMetaData */);
-    _idFact->setMetaData(idMetaData, false /* setDefaultFromMetaData */);
-    _nameFact->setMetaData(nameMetaData, false /* setDefaultFromMetaData */);
-    _manufacturerIdFact->setMetaData(manufacturerIdMetaData, false /* setDefaultFromMetaData */);
-    _frequencyHzFact->setMetaData(frequencyHzMetaData, false /* setDefaultFromMetaData */);
-
-    _selectedFact->setRawValue(selected);
-    _idFact->setRawValue(id);
-    _nameFact->setRawValue(name);
-    _manufacturerIdFact->setRawValue(manufacturerId);
-    _frequencyHzFact->setRawValue(frequencyHz);
+    connect(&_loadWatcher, &QFutureWatcher<LoadResult_t>::finished, this, &TagDatabase::_ensureLoaded);
+    _load();
 }
 
-TagManufacturer::TagManufacturer(TagDatabase* parent)
+TagDatabase::~TagDatabase()
 {
-    _initCommon(parent);
-    _init(
-        _parent->_nextTagManufacturerId(),
-        _nextManufacturerName(),
-        _tagManufacturerMetaData["ip_msecs_1"]->rawDefaultValue().toUInt(),
-        _tagManufacturerMetaData["ip_msecs_2"]->rawDefaultValue().toUInt(),
-        _tagManufacturerMetaData["ip_msecs_1_id"]->rawDefaultValue().toString(),
-        _tagManufacturerMetaData["ip_msecs_2_id"]->rawDefaultValue().toString(),
-        _tagManufacturerMetaData["pulse_width_msecs"]->rawDefaultValue().toUInt(),
-        _tagManufacturerMetaData["ip_uncertainty_msecs"]->rawDefaultValue().toUInt(),
-        _tagManufacturerMetaData["ip_jitter_msecs"]->rawDefaultValue().toUInt());
+    _loadWatcher.waitForFinished();
+    if (_tagInfoListModel) {
+        _tagInfoListModel->clearAndDeleteContents();
+    }
+    if (_tagManufacturerListModel) {
+        _tagManufacturerListModel->clearAndDeleteContents();
+    }
 }
 
-TagManufacturer::TagManufacturer(
-                    uint32_t        id,
-                    const QString&  name,
-                    uint32_t        ip_msecs_1,
-                    uint32_t        ip_msecs_2,
-                    const QString&  ip_msecs_1_id,
-                    const QString&  ip_msecs_2_id,
-                    uint32_t        pulse_width_msecs,
-                    uint32_t        ip_uncertainty_msecs,
-                    uint32_t        ip_jitter_msecs,
-                    TagDatabase*    parent)
+const QMap<QString, FactMetaData*>& TagDatabase::_tagInfoMetaData()
 {
-    _initCommon(parent);
-    _init(id, name, ip_msecs_1, ip_msecs_2, ip_msecs_1_id, ip_msecs_2_id, pulse_width_msecs, ip_uncertainty_msecs, ip_jitter_msecs);
+    if (_tagInfoMetaDataMap.isEmpty()) {
+        _tagInfoMetaDataMap = FactMetaData::createMapFromJsonFile(":/json/TagInfo.json", this);
+    }
+    return _tagInfoMetaDataMap;
 }
 
-QString TagManufacturer::_nextManufacturerName()
+const QMap<QString, FactMetaData*>& TagDatabase::_tagManufacturerMetaData()
 {
-    QString nextNameFmt("Manufacturer %1");
+    if (_tagManufacturerMetaDataMap.isEmpty()) {
+        _tagManufacturerMetaDataMap = FactMetaData::createMapFromJsonFile(":/json/TagManufacturer.json", this);
+    }
+    return _tagManufacturerMetaDataMap;
+}
 
-    int nextIndex = 1;
-    QString nextName = nextNameFmt.arg(nextIndex);
-    while (true) {
-        bool duplicate = false;
-        for (int i=0; i<_parent->_tagManufacturerListModel->count(); i++) {
-            TagManufacturer* tagManufacturer = _parent->_tagManufacturerListModel->value<TagManufacturer*>(i);
-            if (tagManufacturer->_nameFact->rawValue().toString() == nextName) {
-                duplicate = true;
-                break;
-            }
+QmlObjectListModel* TagDatabase::tagInfoListModel()
+{
+    _ensureLoaded();
+    if (!_tagInfoListModel) {
+        _tagInfoListModel = new QmlObjectListModel(this);
+        for (const TagRecord_t& record: _tagRecords) {
+            _tagInfoListModel->append(new TagInfo(record, this));
         }
-        if (duplicate) {
-            nextIndex++;
-            nextName = nextNameFmt.arg(nextIndex);
-        } else {
-            return nextName;
+    }
+    return _tagInfoListModel;
+}
+
+QmlObjectListModel* TagDatabase::tagManufacturerListModel()
+{
+    _ensureLoaded();
+    if (!_tagManufacturerListModel) {
+        _tagManufacturerListModel = new QmlObjectListModel(this);
+        for (const ManufacturerRecord_t& record: _manufacturerRecords) {
+            _tagManufacturerListModel->append(new TagManufacturer(record, this));
         }
     }
+    return _tagManufacturerListModel;
 }
 
-void TagManufacturer::_initCommon(TagDatabase* parent)
-{
-    _parent = parent;
-
-    if (_tagManufacturerMetaData.isEmpty()) {
-        _tagManufacturerMetaData = FactMetaData::createMapFromJsonFile(":/json/TagManufacturer.json", this);
-    }
-}
-
-void TagManufacturer::_init(
-                uint32_t        id,
-                const QString&  name,
-                uint32_t        ip_msecs_1,
-                uint32_t        ip_msecs_2,
-                const QString&  ip_msecs_1_id,
-                const QString&  ip_msecs_2_id,
-                uint32_t        pulse_width_msecs,
-                uint32_t        ip_uncertainty_msecs,
-                uint32_t        ip_jitter_msecs)
-{
-    FactMetaData* idMetaData                    = _tagManufacturerMetaData["id"];
-    FactMetaData* nameMetaData                  = _tagManufacturerMetaData["name"];
-    FactMetaData* ip_msecs_1MetaData            = _tagManufacturerMetaData["ip_msecs_1"];
-    FactMetaData* ip_msecs_2MetaData            = _tagManufacturerMetaData["ip_msecs_2"];
-    FactMetaData* ip_msecs_1_idMetaData         = _tagManufacturerMetaData["ip_msecs_1_id"];
-    FactMetaData* ip_msecs_2_idMetaData         = _tagManufacturerMetaData["ip_msecs_2_id"];
-    FactMetaData* pulse_width_msecsMetaData     = _tagManufacturerMetaData["pulse_width_msecs"];
-    FactMetaData* ip_uncertainty_msecsMetaData  = _tagManufacturerMetaData["ip_uncertainty_msecs"];
-    FactMetaData* ip_jitter_msecsMetaData       = _tagManufacturerMetaData["ip_jitter_msecs"];
-
-    _idFact                     = new Fact(-1, idMetaData->name(),                      idMetaData->type(),                     this);
-    _nameFact                   = new Fact(-1, nameMetaData->name(),                    nameMetaData->type(),                   this);
-    _ip_msecs_1Fact             = new Fact(-1, ip_msecs_1MetaData->name(),              ip_msecs_1MetaData->type(),             this);
-    _ip_msecs_2Fact             = new Fact(-1, ip_msecs_2MetaData->name(),              ip_msecs_2MetaData->type(),             this);
-    _ip_msecs_1_idFact          = new Fact(-1, ip_msecs_1_idMetaData->name(),           ip_msecs_1_idMetaData->type(),          this);
-    _ip_msecs_2_idFact          = new Fact(-1, ip_msecs_2_idMetaData->name(),           ip_msecs_2_idMetaData->type(),          this);
-    _pulse_width_msecsFact      = new Fact(-1, pulse_width_msecsMetaData->name(),       pulse_width_msecsMetaData->type(),      this);
-    _ip_uncertainty_msecsFact   = new Fact(-1, ip_uncertainty_msecsMetaData->name(),    ip_uncertainty_msecsMetaData->type(),   this);
-    _ip_jitter_msecsFact        = new Fact(-1, ip_jitter_msecsMetaData->name(),         ip_jitter_msecsMetaData->type(),        this);
-
-    _idFact->setMetaData(idMetaData, false /* setDefaultFromMetaData */);
-    _nameFact->setMetaData(nameMetaData, false /* setDefaultFromMetaData */);
-    _ip_msecs_1Fact->setMetaData(ip_msecs_1MetaData, false /* setDefaultFromMetaData */);
-    _ip_msecs_2Fact->setMetaData(ip_msecs_2MetaData, false /* setDefaultFromMetaData */);
-    _ip_msecs_1_idFact->setMetaData(ip_msecs_1_idMetaData, false /* setDefaultFromMetaData */);
-    _ip_msecs_2_idFact->setMetaData(ip_msecs_2_idMetaData, false /* setDefaultFromMetaData */);
-    _pulse_width_msecsFact->setMetaData(pulse_width_msecsMetaData, false /* setDefaultFromMetaData */);
-    _ip_uncertainty_msecsFact->setMetaData(ip_uncertainty_msecsMetaData, false /* setDefaultFromMetaData */);
-    _ip_jitter_msecsFact->setMetaData(ip_jitter_msecsMetaData, false /* setDefaultFromMetaData */);
-
-    _idFact->setRawValue(id);
-    _nameFact->setRawValue(name);
-    _ip_msecs_1Fact->setRawValue(ip_msecs_1);
-    _ip_msecs_2Fact->setRawValue(ip_msecs_2);
-    _ip_msecs_1_idFact->setRawValue(ip_msecs_1_id);
-    _ip_msecs_2_idFact->setRawValue(ip_msecs_2_id);
-    _pulse_width_msecsFact->setRawValue(pulse_width_msecs);
-    _ip_uncertainty_msecsFact->setRawValue(ip_uncertainty_msecs);
-    _ip_jitter_msecsFact->setRawValue(ip_jitter_msecs);
-}
-
-TagDatabase::TagDatabase(QObject* parent)
-    : QObject                   (parent)
-    , _tagInfoListModel         (new QmlObjectListModel(this))
-    , _tagManufacturerListModel (new QmlObjectListModel(this))
+const QVector<TagRecord_t>& TagDatabase::tagRecords()
 {
-    _load();
+    _ensureLoaded();
+    return _tagRecords;
 }
 
-TagDatabase::~TagDatabase()
+const QVector<ManufacturerRecord_t>& TagDatabase::manufacturerRecords()
+{
+    _ensureLoaded();
+    return _manufacturerRecords;
+}
+
+const TagRecord_t* TagDatabase::findTagRecord(uint32_t id)
+{
+    _ensureLoaded();
+    int index = _tagIndexById.value(id, -1);
+    return index < 0 ? nullptr : _tagRecords.constData() + index;
+}
+
+const ManufacturerRecord_t* TagDatabase::findManufacturerRecord(uint32_t id)
 {
-    _tagInfoListModel->clearAndDeleteContents();
-    _tagManufacturerListModel->clearAndDeleteContents();
+    _ensureLoaded();
+    int index = _manufacturerIndexById.value(id, -1);
+    return index < 0 ? nullptr : _manufacturerRecords.constData() + index;
 }
 
 QObject* TagDatabase::newTagInfo()
 {
-    TagInfo* tagInfo = new TagInfo(this);
-    _tagInfoListModel->append(tagInfo);
+    // Make sure the existing objects are created before the new record is added
+    QmlObjectListModel* listModel = tagInfoListModel();
+
+    TagRecord_t record;
+    record.id           = _nextTagInfoId();
+    record.name         = _nextTagName();
+    record.frequencyHz  = _tagInfoMetaData()["freq_hz"]->rawDefaultValue().toUInt();
+    if (_manufacturerRecords.count() > 0) {
+        record.manufacturerId = _manufacturerRecords.first().id;
+    } else {
+        record.manufacturerId = 1;
+        qWarning() << "TagDatabase::newTagInfo - Internal error: no manufacturer records found.";
+    }
+
+    _tagIndexById[record.id] = _tagRecords.count();
+    _tagRecords.append(record);
+    _dirtyTagIds.insert(record.id);
+
+    TagInfo* tagInfo = new TagInfo(record, this);
+    listModel->append(tagInfo);
     return tagInfo;
 }
 
 QObject* TagDatabase::newTagManufacturer()
 {
-    TagManufacturer* tagManufacturer = new TagManufacturer(this);
-    _tagManufacturerListModel->append(tagManufacturer);
+    QmlObjectListModel*                 listModel   = tagManufacturerListModel();
+    const QMap<QString, FactMetaData*>& metaData    = _tagManufacturerMetaData();
+
+    ManufacturerRecord_t record;
+    record.id                   = _nextTagManufacturerId();
+    record.name                 = _nextManufacturerName();
+    record.ip_msecs_1           = metaData["ip_msecs_1"]->rawDefaultValue().toUInt();
+    record.ip_msecs_2           = metaData["ip_msecs_2"]->rawDefaultValue().toUInt();
+    record.ip_msecs_1_id        = metaData["ip_msecs_1_id"]->rawDefaultValue().toString();
+    record.ip_msecs_2_id        = metaData["ip_msecs_2_id"]->rawDefaultValue().toString();
+    record.pulse_width_msecs    = metaData["pulse_width_msecs"]->rawDefaultValue().toUInt();
+    record.ip_uncertainty_msecs = metaData["ip_uncertainty_msecs"]->rawDefaultValue().toUInt();
+    record.ip_jitter_msecs      = metaData["ip_jitter_msecs"]->rawDefaultValue().toUInt();
+
+    _manufacturerIndexById[record.id] = _manufacturerRecords.count();
+    _manufacturerRecords.append(record);
+    _dirtyManufacturerIds.insert(record.id);
+
+    TagManufacturer* tagManufacturer = new TagManufacturer(record, this);
+    listModel->append(tagManufacturer);
     return tagManufacturer;
 }
 
 void TagDatabase::deleteTagInfoListItem(QObject* tagInfoListItem)
 {
-    delete _tagInfoListModel->removeOne(tagInfoListItem);
+    TagInfo* tagInfo = qobject_cast<TagInfo*>(tagInfoListItem);
+    if (!tagInfo) {
+        return;
+    }
+
+    int index = _tagIndexById.value(tagInfo->_recordId, -1);
+    if (index >= 0) {
+        _tagRecords.remove(index);
+        _dirtyTagIds.insert(tagInfo->_recordId);
+        _rebuildIndices();
+    }
+
+    delete tagInfoListModel()->removeOne(tagInfoListItem);
 }
 
 bool TagDatabase::deleteTagManufacturerListItem(QObject* tagManufacturerListItem)
 {
+    TagManufacturer* tagManufacturer = qobject_cast<TagManufacturer*>(tagManufacturerListItem);
+    if (!tagManufacturer) {
+        return false;
+    }
+
     // Check that the manufacturer is not in use by any tag info
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo* tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-        if (tagInfo->_manufacturerIdFact->rawValue().toInt() == qobject_cast<TagManufacturer*>(tagManufacturerListItem)->_idFact->rawValue().toInt()) {
+    for (const TagRecord_t& tagRecord: tagRecords()) {
+        if (tagRecord.manufacturerId == tagManufacturer->_recordId) {
             return false;
         }
     }
 
-    delete _tagManufacturerListModel->removeOne(tagManufacturerListItem);
-    
+    int index = _manufacturerIndexById.value(tagManufacturer->_recordId, -1);
+    if (index >= 0) {
+        _manufacturerRecords.remove(index);
+        _dirtyManufacturerIds.insert(tagManufacturer->_recordId);
+        _rebuildIndices();
+    }
+
+    delete tagManufacturerListModel()->removeOne(tagManufacturerListItem);
+
     return true;
 }
 
+void TagDatabase::_tagInfoChanged(TagInfo* tagInfo)
+{
+    int index = _tagIndexById.value(tagInfo->_recordId, -1);
+    if (index < 0) {
+        return;
+    }
+    TagRecord_t& record = _tagRecords[index];
+
+    // Ids are assigned by the database and referenced by the controller, they can't be edited
+    if (tagInfo->_idFact->rawValue().toUInt() != record.id) {
+        qWarning() << "TagDatabase: tag id can't be changed" << record.id;
+        tagInfo->_idFact->setRawValue(record.id);
+        return;
+    }
+
+    record.selected         = tagInfo->_selectedFact->rawValue().toUInt() != 0;
+    record.name             = tagInfo->_nameFact->rawValue().toString();
+    record.manufacturerId   = tagInfo->_manufacturerIdFact->rawValue().toUInt();
+    record.frequencyHz      = tagInfo->_frequencyHzFact->rawValue().toUInt();
+    _dirtyTagIds.insert(record.id);
+}
+
+void TagDatabase::_tagManufacturerChanged(TagManufacturer* tagManufacturer)
+{
+    int index = _manufacturerIndexById.value(tagManufacturer->_recordId, -1);
+    if (index < 0) {
+        return;
+    }
+    ManufacturerRecord_t& record = _manufacturerRecords[index];
+
+    if (tagManufacturer->_idFact->rawValue().toUInt() != record.id) {
+        qWarning() << "TagDatabase: manufacturer id can't be changed" << record.id;
+        tagManufacturer->_idFact->setRawValue(record.id);
+        return;
+    }
+
+    record.name                 = tagManufacturer->_nameFact->rawValue().toString();
+    record.ip_msecs_1           = tagManufacturer->_ip_msecs_1Fact->rawValue().toUInt();
+    record.ip_msecs_2           = tagManufacturer->_ip_msecs_2Fact->rawValue().toUInt();
+    record.ip_msecs_1_id        = tagManufacturer->_ip_msecs_1_idFact->rawValue().toString();
+    record.ip_msecs_2_id        = tagManufacturer->_ip_msecs_2_idFact->rawValue().toString();
+    record.pulse_width_msecs    = tagManufacturer->_pulse_width_msecsFact->rawValue().toUInt();
+    record.ip_uncertainty_msecs = tagManufacturer->_ip_uncertainty_msecsFact->rawValue().toUInt();
+    record.ip_jitter_msecs      = tagManufacturer->_ip_jitter_msecsFact->rawValue().toUInt();
+    _dirtyManufacturerIds.insert(record.id);
+}
+
+void TagDatabase::_rebuildIndices()
+{
+    _tagIndexById.clear();
+    for (int i=0; i<_tagRecords.count(); i++) {
+        _tagIndexById[_tagRecords[i].id] = i;
+    }
+
+    _manufacturerIndexById.clear();
+    for (int i=0; i<_manufacturerRecords.count(); i++) {
+        _manufacturerIndexById[_manufacturerRecords[i].id] = i;
+    }
+}
+
 uint32_t TagDatabase::_nextTagInfoId()
 {
     uint32_t returnedTagId = _nextTagId;
@@ -273,349 +318,494 @@ uint32_t TagDatabase::_nextTagManufacturerId()
     return returnedManufacturerId;
 }
 
+QString TagDatabase::_nextTagName()
+{
+    QSet<QString> names;
+    for (const TagRecord_t& record: _tagRecords) {
+        names.insert(record.name);
+    }
+
+    int nextIndex = 1;
+    while (names.contains(QStringLiteral("Tag %1").arg(nextIndex))) {
+        nextIndex++;
+    }
+    return QStringLiteral("Tag %1").arg(nextIndex);
+}
+
+QString TagDatabase::_nextManufacturerName()
+{
+    QSet<QString> names;
+    for (const ManufacturerRecord_t& record: _manufacturerRecords) {
+        names.insert(record.name);
+    }
+
+    int nextIndex = 1;
+    while (names.contains(QStringLiteral("Manufacturer %1").arg(nextIndex))) {
+        nextIndex++;
+    }
+    return QStringLiteral("Manufacturer %1").arg(nextIndex);
+}
+
 QString TagDatabase::_tagInfoFilePath()
 {
-    return QString::asprintf(
-                        "%s/TagInfo.db",
-                        qgcApp()->toolbox()->settingsManager()->appSettings()->parameterSavePath().toStdString().c_str());
+    QString dirPath = _dirPath.isEmpty() ? qgcApp()->toolbox()->settingsManager()->appSettings()->parameterSavePath() : _dirPath;
+    return QStringLiteral("%1/TagInfo.db").arg(dirPath);
 }
-   
+
 QString TagDatabase::_tagManufacturerFilePath()
 {
-    return QString::asprintf(
-                        "%s/TagManufacturer.db",
-                        qgcApp()->toolbox()->settingsManager()->appSettings()->parameterSavePath().toStdString().c_str());
+    QString dirPath = _dirPath.isEmpty() ? qgcApp()->toolbox()->settingsManager()->appSettings()->parameterSavePath() : _dirPath;
+    return QStringLiteral("%1/TagManufacturer.db").arg(dirPath);
 }
 
-bool TagDatabase::_saveTagInfo()
+QString TagDatabase::_journalFilePath()
 {
-    QString filename = _tagInfoFilePath();
-    QFile   file(filename);
+    QString dirPath = _dirPath.isEmpty() ? qgcApp()->toolbox()->settingsManager()->appSettings()->parameterSavePath() : _dirPath;
+    return QStringLiteral("%1/TagDatabase.journal").arg(dirPath);
+}
 
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qgcApp()->showAppMessage(QString("Open for write '%1' failed: %2").arg(filename).arg(file.errorString()));
-        return false;
+QByteArray TagDatabase::_tagRecordLine(const TagRecord_t& record)
+{
+    return QStringLiteral("%1,%2,%3,%4,%5\n")
+        .arg(record.selected ? 1 : 0)
+        .arg(record.id)
+        .arg(record.name)
+        .arg(record.manufacturerId)
+        .arg(record.frequencyHz)
+        .toUtf8();
+}
+
+QByteArray TagDatabase::_manufacturerRecordLine(const ManufacturerRecord_t& record)
+{
+    return QStringLiteral("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+        .arg(record.id)
+        .arg(record.name)
+        .arg(record.ip_msecs_1)
+        .arg(record.ip_msecs_2)
+        .arg(record.ip_msecs_1_id)
+        .arg(record.ip_msecs_2_id)
+        .arg(record.pulse_width_msecs)
+        .arg(record.ip_uncertainty_msecs)
+        .arg(record.ip_jitter_msecs)
+        .toUtf8();
+}
+
+void TagDatabase::save()
+{
+    _ensureLoaded();
+    if (_dirtyTagIds.isEmpty() && _dirtyManufacturerIds.isEmpty()) {
+        return;
     }
 
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo* tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-        file.write(QStringLiteral("%1,%2,%3,%4,%5\n")
-            .arg(tagInfo->_selectedFact->rawValue().toInt())
-            .arg(tagInfo->_idFact->rawValue().toInt())
-            .arg(tagInfo->_nameFact->rawValue().toString())
-            .arg(tagInfo->_manufacturerIdFact->rawValue().toInt())
-            .arg(tagInfo->_frequencyHzFact->rawValue().toInt())
-            .toUtf8());
+    // Manufacturers go first so replaying the journal never sees a tag before its manufacturer
+    QByteArray  journalBytes;
+    int         cEntries = 0;
+
+    QList<uint32_t> dirtyIds = _dirtyManufacturerIds.values();
+    std::sort(dirtyIds.begin(), dirtyIds.end());
+    for (uint32_t id: dirtyIds) {
+        const ManufacturerRecord_t* record = findManufacturerRecord(id);
+        if (record) {
+            journalBytes += "M," + _manufacturerRecordLine(*record);
+        } else {
+            journalBytes += "-M," + QByteArray::number(id) + '\n';
+        }
+        cEntries++;
     }
 
-    return true;
-}
+    dirtyIds = _dirtyTagIds.values();
+    std::sort(dirtyIds.begin(), dirtyIds.end());
+    for (uint32_t id: dirtyIds) {
+        const TagRecord_t* record = findTagRecord(id);
+        if (record) {
+            journalBytes += "T," + _tagRecordLine(*record);
+        } else {
+            journalBytes += "-T," + QByteArray::number(id) + '\n';
+        }
+        cEntries++;
+    }
 
-bool TagDatabase::_saveTagManufacturer()
-{
-    QString filename = _tagManufacturerFilePath();
+    QString filename = _journalFilePath();
     QFile   file(filename);
 
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qgcApp()->showAppMessage(QStringLiteral("Open for write '%1' failed: %2").arg(filename).arg(file.errorString()));
-        return false;
+    // Cut off a torn or unreadable tail left from the load, anything appended after it would never be replayed
+    if (_journalValidSize >= 0) {
+        if (!file.resize(_journalValidSize)) {
+            qgcApp()->showAppMessage(QStringLiteral("Truncate '%1' failed: %2").arg(filename).arg(file.errorString()));
+            return;
+        }
+        _journalValidSize = -1;
     }
 
-    for (int i=0; i<_tagManufacturerListModel->count(); i++) {
-        TagManufacturer* tagManufacturer = _tagManufacturerListModel->value<TagManufacturer*>(i);
-        file.write(QStringLiteral("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
-            .arg(tagManufacturer->_idFact->rawValue().toInt())
-            .arg(tagManufacturer->_nameFact->rawValue().toString())
-            .arg(tagManufacturer->_ip_msecs_1Fact->rawValue().toInt())
-            .arg(tagManufacturer->_ip_msecs_2Fact->rawValue().toInt())
-            .arg(tagManufacturer->_ip_msecs_1_idFact->rawValue().toString())
-            .arg(tagManufacturer->_ip_msecs_2_idFact->rawValue().toString())
-            .arg(tagManufacturer->_pulse_width_msecsFact->rawValue().toInt())
-            .arg(tagManufacturer->_ip_uncertainty_msecsFact->rawValue().toInt())
-            .arg(tagManufacturer->_ip_jitter_msecsFact->rawValue().toInt())
-            .toUtf8());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        qgcApp()->showAppMessage(QStringLiteral("Open for write '%1' failed: %2").arg(filename).arg(file.errorString()));
+        return;
+    }
+    if (file.write(journalBytes) != journalBytes.size()) {
+        qgcApp()->showAppMessage(QStringLiteral("Write '%1' failed: %2").arg(filename).arg(file.errorString()));
+        return;
     }
+    file.close();
 
-    return true;
-}
+    _dirtyTagIds.clear();
+    _dirtyManufacturerIds.clear();
+    _journalEntryCount += cEntries;
 
-void TagDatabase::save()
-{
-    _saveTagInfo();
-    _saveTagManufacturer();
+    if (!_loadFailed && _journalEntryCount > std::max(minCompactJournalEntries, static_cast<int>(_tagRecords.count() + _manufacturerRecords.count()))) {
+        _compact();
+    }
 }
 
-TagInfo* TagDatabase::findTagInfo(uint32_t id)
+// Rewrites the snapshot files from the current records and drops the journal. The journal is only removed after both
+// snapshots are written, replaying it again on top of a new snapshot gives the same result.
+bool TagDatabase::_compact()
 {
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo* tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-        if (tagInfo->_idFact->rawValue().toUInt() == id) {
-            return tagInfo;
-        }
+    QByteArray manufacturerBytes;
+    for (const ManufacturerRecord_t& record: _manufacturerRecords) {
+        manufacturerBytes += _manufacturerRecordLine(record);
     }
-    return nullptr;
-}
 
-TagManufacturer* TagDatabase::findTagManufacturer(uint32_t id)
-{
-    for (int i=0; i<_tagManufacturerListModel->count(); i++) {
-        TagManufacturer* tagManufacturer = _tagManufacturerListModel->value<TagManufacturer*>(i);
-        if (tagManufacturer->_idFact->rawValue().toUInt() == id) {
-            return tagManufacturer;
+    QByteArray tagBytes;
+    for (const TagRecord_t& record: _tagRecords) {
+        tagBytes += _tagRecordLine(record);
+    }
+
+    for (const auto& fileBytes: { qMakePair(_tagManufacturerFilePath(), manufacturerBytes), qMakePair(_tagInfoFilePath(), tagBytes) }) {
+        QSaveFile file(fileBytes.first);
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qgcApp()->showAppMessage(QStringLiteral("Open for write '%1' failed: %2").arg(fileBytes.first).arg(file.errorString()));
+            return false;
+        }
+        file.write(fileBytes.second);
+        if (!file.commit()) {
+            qgcApp()->showAppMessage(QStringLiteral("Write '%1' failed: %2").arg(fileBytes.first).arg(file.errorString()));
+            return false;
         }
     }
-    return nullptr;
+
+    QFile::remove(_journalFilePath());
+
+    _dirtyTagIds.clear();
+    _dirtyManufacturerIds.clear();
+    _journalEntryCount = 0;
+
+    return true;
 }
 
 void TagDatabase::_updateNextIds(void)
 {
     uint32_t maxId = 0;
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo* tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-        maxId = std::max(tagInfo->id()->rawValue().toUInt(), maxId);
+    for (const TagRecord_t& record: _tagRecords) {
+        maxId = std::max(record.id, maxId);
     }
     _nextTagId = maxId + 2;
 
     maxId = 0;
-    for (int i=0; i<_tagManufacturerListModel->count(); i++) {
-        TagManufacturer* tagManufacturer = _tagManufacturerListModel->value<TagManufacturer*>(i);
-        maxId = std::max(tagManufacturer->id()->rawValue().toUInt(), maxId);
+    for (const ManufacturerRecord_t& record: _manufacturerRecords) {
+        maxId = std::max(record.id, maxId);
     }
     _nextManufacturerId = maxId + 1;
 }
 
-bool TagDatabase::_loadTagInfo(void)
+bool TagDatabase::_parseTagRecord(const QList<QByteArray>& values, TagRecord_t& record, QString& errorString)
 {
-    QString filename = _tagInfoFilePath();
-    QFile   file(filename);
+    const int cExpectedValueCount = 5;
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qgcApp()->showAppMessage(QStringLiteral("Unable to open `%1` for saving: %2").arg(filename).arg(file.errorString()));
+    if (values.count() != cExpectedValueCount) {
+        errorString = QStringLiteral("Does not contain %1 values").arg(cExpectedValueCount);
         return false;
     }
 
-    QString     strLine;
-    QTextStream stream(&file);
-    int         lineCount           = 0;
-    int         cExpectedValueCount = 5;   
-
-    while (stream.readLineInto(&strLine)) {
-        lineCount++;
-        if (strLine.startsWith("#")) {
-            continue;
-        }
-        if (strLine.length() == 0) {
-            continue;
+    int     valuePosition = 0;
+    auto    toUInt = [&](const char* valueName, uint32_t& value) {
+        bool ok;
+        value = values[valuePosition].toUInt(&ok);
+        if (!ok) {
+            errorString = QStringLiteral("Value:'%1'. Unable to convert %2 to uint.").arg(QString::fromUtf8(values[valuePosition]), valueName);
         }
+        valuePosition++;
+        return ok;
+    };
 
-        QStringList values = strLine.split(",");
-        if (values.count() != cExpectedValueCount) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Does not contain %2 values").arg(lineCount).arg(cExpectedValueCount));
-            return false;
-        }
+    uint32_t selected;
+    if (!toUInt("selected", selected)) {
+        return false;
+    }
+    record.selected = selected != 0;
 
-        bool                ok;
-        QString             valueString;
-        int                 valuePosition = 0;
-        bool                selected;
-        uint32_t            id;
-        QString             name;
-        uint32_t            manufacturerId;
-        uint32_t            frequencyHz;
-
-        valueString = values[valuePosition++];
-        selected    = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Unable to convert selected to boolean.").arg(lineCount).arg(valueString));
-            return false;
-        }
+    if (!toUInt("id", record.id)) {
+        return false;
+    }
+    if (record.id <= 1) {
+        errorString = QStringLiteral("Value:'%1'. Tag ids must be greater than 1").arg(record.id);
+        return false;
+    }
+    if (record.id % 2) {
+        errorString = QStringLiteral("Value:'%1'. Tag ids must be even numbers").arg(record.id);
+        return false;
+    }
 
-        valueString = values[valuePosition++];
-        id          = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Unable to convert id to uint.").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (id <= 1) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Tag ids must be greater than 1").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (id % 2) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Tag ids must be even numbers").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (findTagInfo(id)) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Duplicate tag id.").arg(lineCount).arg(valueString));
-            return false;
-        }
+    record.name = QString::fromUtf8(values[valuePosition++]);
+    if (record.name.length() == 0) {
+        record.name.setNum(record.id);
+    }
 
-        name = values[valuePosition++];
-        if (name.length() == 0) {
-            name.setNum(id);
-        }
+    return toUInt("manufacturer id", record.manufacturerId) && toUInt("frequency", record.frequencyHz);
+}
 
-        valueString     = values[valuePosition++];
-        manufacturerId  = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Unable to convert manufacturer id to uint.").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (!findTagManufacturer(manufacturerId)) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Manufacturer id not found in manufacturer list.").arg(lineCount).arg(valueString));
-            return false;
-        }
+bool TagDatabase::_parseManufacturerRecord(const QList<QByteArray>& values, ManufacturerRecord_t& record, QString& errorString)
+{
+    const int cExpectedValueCount = 9;
+
+    if (values.count() != cExpectedValueCount) {
+        errorString = QStringLiteral("Does not contain %1 values").arg(cExpectedValueCount);
+        return false;
+    }
 
-        valueString = values[valuePosition++];
-        frequencyHz = valueString.toUInt(&ok);
+    int     valuePosition = 0;
+    auto    toUInt = [&](const char* valueName, uint32_t& value) {
+        bool ok;
+        value = values[valuePosition].toUInt(&ok);
         if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Unable to convert frequency to uint.").arg(lineCount).arg(valueString));
-            return false;
+            errorString = QStringLiteral("Value:'%1'. Unable to convert %2 to uint.").arg(QString::fromUtf8(values[valuePosition]), valueName);
         }
+        valuePosition++;
+        return ok;
+    };
 
-        _tagInfoListModel->append(new TagInfo(selected, id, name, manufacturerId, frequencyHz, this));
+    if (!toUInt("id", record.id)) {
+        return false;
+    }
+    if (record.id < 1) {
+        errorString = QStringLiteral("Value:'%1'. Manufacturer ids must be greater than 0").arg(record.id);
+        return false;
     }
 
-    _updateNextIds();
-
-    return true;
-}
-
-bool TagDatabase::_loadTagManufacturer(void)
-{
-    QString filename = _tagManufacturerFilePath();
-    QFile   file(filename);
+    record.name = QString::fromUtf8(values[valuePosition++]);
+    if (record.name.length() == 0) {
+        record.name.setNum(record.id);
+    }
 
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qgcApp()->showAppMessage(QStringLiteral("Unable to open `%1` for reading: %2").arg(filename).arg(file.errorString()));
+    if (!toUInt("ip msecs 1", record.ip_msecs_1) || !toUInt("ip msecs 2", record.ip_msecs_2)) {
         return false;
     }
 
-    QString     strLine;
-    QTextStream stream(&file);
-    int         lineCount           = 0;
-    int         cExpectedValueCount = 9;   
+    record.ip_msecs_1_id = QString::fromUtf8(values[valuePosition++]);
+    if (record.ip_msecs_1_id.length() == 0) {
+        record.ip_msecs_1_id.setNum(1);
+    }
 
-    while (stream.readLineInto(&strLine)) {
-        lineCount++;
-        if (strLine.startsWith("#")) {
-            continue;
-        }
-        if (strLine.length() == 0) {
-            continue;
-        }
+    record.ip_msecs_2_id = QString::fromUtf8(values[valuePosition++]);
+    if (record.ip_msecs_2_id.length() == 0) {
+        record.ip_msecs_2_id.setNum(2);
+    }
 
-        QStringList values = strLine.split(",");
-        if (values.count() != cExpectedValueCount) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Does not contain %2 values").arg(lineCount).arg(cExpectedValueCount));
-            return false;
-        }
+    return toUInt("pulse width msecs", record.pulse_width_msecs) &&
+            toUInt("uncertainty msecs", record.ip_uncertainty_msecs) &&
+            toUInt("jitter msecs", record.ip_jitter_msecs);
+}
 
-        bool                ok;
-        QString             valueString;
-        int                 valuePosition = 0;
-        uint32_t            id;
-        QString             name;
-        uint32_t            ipMsecs1;
-        uint32_t            ipMsecs2;
-        QString             ipMsecs1Id;
-        QString             ipMsecs2Id;
-        uint32_t            pulseWidthMsecs;
-        uint32_t            ipUncertaintyMsecs;
-        uint32_t            ipJitterMsecs;
-
-        valueString = values[valuePosition++];
-        id          = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert id to uint.").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (id < 1) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Manufacturer ids must be greater than 0").arg(lineCount).arg(valueString));
-            return false;
-        }
-        if (findTagManufacturer(id)) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Duplicate manufacturer id.").arg(lineCount).arg(valueString));
+// Runs on a worker thread so it must not touch anything but its arguments
+//
+// Load errors never throw away records which did load. A bad snapshot line is skipped. A bad journal line stops the
+// replay there, the journal is cut back to the last good entry by the next save. An unterminated last journal line is
+// an append torn by a crash and is dropped the same way without reporting an error.
+TagDatabase::LoadResult_t TagDatabase::_loadFiles(const QString& tagInfoPath, const QString& tagManufacturerPath, const QString& journalPath)
+{
+    LoadResult_t            result;
+    QHash<uint32_t, int>    tagIndexById;
+    QHash<uint32_t, int>    manufacturerIndexById;
+    QString                 errorString;
+
+    auto addError = [&result](const QString& error) {
+        if (!result.errorString.isEmpty()) {
+            result.errorString += '\n';
+        }
+        result.errorString += error;
+    };
+    // Missing files are the same as empty ones
+    auto readFile = [&addError](const QString& filename, QIODevice::OpenMode openMode, QByteArray& bytes) {
+        QFile file(filename);
+        if (!file.exists()) {
+            return true;
+        }
+        if (!file.open(QIODevice::ReadOnly | openMode)) {
+            addError(QStringLiteral("Unable to open `%1` for reading: %2").arg(filename).arg(file.errorString()));
             return false;
         }
+        bytes = file.readAll();
+        return true;
+    };
+    auto skipLine = [](const QByteArray& line) {
+        return line.isEmpty() || line.startsWith('#');
+    };
+
+    QByteArray bytes;
+    if (readFile(tagManufacturerPath, QIODevice::Text, bytes)) {
+        QList<QByteArray> lines = bytes.split('\n');
+        for (int i=0; i<lines.count(); i++) {
+            if (skipLine(lines[i])) {
+                continue;
+            }
 
-        name = values[valuePosition++];
-        if (name.length() == 0) {
-            name.setNum(id);
+            ManufacturerRecord_t record;
+            if (!_parseManufacturerRecord(lines[i].split(','), record, errorString)) {
+                addError(QStringLiteral("Load Manufacturer Info: Line #%1 %2").arg(i + 1).arg(errorString));
+                continue;
+            }
+            if (manufacturerIndexById.contains(record.id)) {
+                addError(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Duplicate manufacturer id.").arg(i + 1).arg(record.id));
+                continue;
+            }
+            manufacturerIndexById[record.id] = result.manufacturers.count();
+            result.manufacturers.append(record);
         }
+    }
 
-        valueString = values[valuePosition++];
-        ipMsecs1    = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert ip msecs 1 to uint.").arg(lineCount).arg(valueString));
-            return false;
-        }
+    bytes.clear();
+    if (readFile(tagInfoPath, QIODevice::Text, bytes)) {
+        QList<QByteArray> lines = bytes.split('\n');
+        for (int i=0; i<lines.count(); i++) {
+            if (skipLine(lines[i])) {
+                continue;
+            }
 
-        valueString = values[valuePosition++];
-        ipMsecs2    = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert ip msecs 2 to uint.").arg(lineCount).arg(valueString));
-            return false;
+            TagRecord_t record;
+            if (!_parseTagRecord(lines[i].split(','), record, errorString)) {
+                addError(QStringLiteral("Load Tag Info: Line #%1 %2").arg(i + 1).arg(errorString));
+                continue;
+            }
+            if (tagIndexById.contains(record.id)) {
+                addError(QStringLiteral("Load Tag Info: Line #%1 Value:'%2'. Duplicate tag id.").arg(i + 1).arg(record.id));
+                continue;
+            }
+            tagIndexById[record.id] = result.tags.count();
+            result.tags.append(record);
         }
+    }
 
-        ipMsecs1Id = values[valuePosition++];
-        if (ipMsecs1Id.length() == 0) {
-            ipMsecs1Id.setNum(1);
-        }
+    // Journal entries replace or delete snapshot records. Deleted records are marked with id 0 and dropped at the end
+    // so the indices stay valid during the replay. The journal is read in binary so line lengths are file offsets.
+    bytes.clear();
+    if (readFile(journalPath, QIODevice::NotOpen, bytes)) {
+        QList<QByteArray>   lines       = bytes.split('\n');
+        qint64              lineOffset  = 0;
 
-        ipMsecs2Id = values[valuePosition++];
-        if (ipMsecs2Id.length() == 0) {
-            ipMsecs2Id.setNum(2);
+        // Everything after the last newline, empty for an intact journal
+        QByteArray tornLine = lines.takeLast();
+        if (!tornLine.isEmpty()) {
+            qWarning() << "TagDatabase: dropping unterminated journal entry" << tornLine;
+            result.journalValidSize = bytes.size() - tornLine.size();
         }
 
-        valueString     = values[valuePosition++];
-        pulseWidthMsecs = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert pulse width msecs 2 to uint.").arg(lineCount).arg(valueString));
-            return false;
-        }
+        for (int i=0; i<lines.count(); lineOffset += lines[i].size() + 1, i++) {
+            QByteArray line = lines[i];
+            if (line.endsWith('\r')) {
+                line.chop(1);
+            }
+            if (skipLine(line)) {
+                continue;
+            }
 
-        valueString         = values[valuePosition++];
-        ipUncertaintyMsecs  = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert uncertainty msecs 2 to uint.").arg(lineCount).arg(valueString));
-            return false;
+            QList<QByteArray>   values      = line.split(',');
+            QByteArray          entryType   = values.takeFirst();
+            bool                ok          = false;
+
+            if (entryType == "M") {
+                ManufacturerRecord_t record;
+                if (!_parseManufacturerRecord(values, record, errorString)) {
+                    addError(QStringLiteral("Load Tag Journal: Line #%1 %2").arg(i + 1).arg(errorString));
+                    result.journalValidSize = lineOffset;
+                    break;
+                }
+                int index = manufacturerIndexById.value(record.id, -1);
+                if (index < 0) {
+                    manufacturerIndexById[record.id] = result.manufacturers.count();
+                    result.manufacturers.append(record);
+                } else {
+                    result.manufacturers[index] = record;
+                }
+            } else if (entryType == "T") {
+                TagRecord_t record;
+                if (!_parseTagRecord(values, record, errorString)) {
+                    addError(QStringLiteral("Load Tag Journal: Line #%1 %2").arg(i + 1).arg(errorString));
+                    result.journalValidSize = lineOffset;
+                    break;
+                }
+                int index = tagIndexById.value(record.id, -1);
+                if (index < 0) {
+                    tagIndexById[record.id] = result.tags.count();
+                    result.tags.append(record);
+                } else {
+                    result.tags[index] = record;
+                }
+            } else if (entryType == "-M" && values.count() == 1) {
+                uint32_t id = values[0].toUInt(&ok);
+                if (ok && manufacturerIndexById.contains(id)) {
+                    result.manufacturers[manufacturerIndexById.take(id)].id = 0;
+                }
+            } else if (entryType == "-T" && values.count() == 1) {
+                uint32_t id = values[0].toUInt(&ok);
+                if (ok && tagIndexById.contains(id)) {
+                    result.tags[tagIndexById.take(id)].id = 0;
+                }
+            } else {
+                addError(QStringLiteral("Load Tag Journal: Line #%1 Unknown entry '%2'").arg(i + 1).arg(QString::fromUtf8(line)));
+                result.journalValidSize = lineOffset;
+                break;
+            }
+            result.journalEntryCount++;
         }
+    }
 
-        valueString     = values[valuePosition++];
-        ipJitterMsecs   = valueString.toUInt(&ok);
-        if (!ok) {
-            qgcApp()->showAppMessage(QStringLiteral("Load Manufacturer Info: Line #%1 Value:'%2'. Unable to convert jitter msecs 2 to uint.").arg(lineCount).arg(valueString));
+    result.tags.removeIf([](const TagRecord_t& record) { return record.id == 0; });
+    result.manufacturers.removeIf([](const ManufacturerRecord_t& record) { return record.id == 0; });
+
+    // Tags without a manufacturer are left out of the catalog but stay in the files
+    result.tags.removeIf([&](const TagRecord_t& record) {
+        if (manufacturerIndexById.contains(record.manufacturerId)) {
             return false;
         }
+        addError(QStringLiteral("Load Tag Info: Tag id %1 Value:'%2'. Manufacturer id not found in manufacturer list.").arg(record.id).arg(record.manufacturerId));
+        return true;
+    });
 
-        _tagManufacturerListModel->append(new TagManufacturer(id, name, ipMsecs1, ipMsecs2, ipMsecs1Id, ipMsecs2Id, pulseWidthMsecs, ipUncertaintyMsecs, ipJitterMsecs, this));
-    }
-
-    return true;
+    return result;
 }
 
 void TagDatabase::_load()
 {
-    _tagManufacturerListModel->clearAndDeleteContents();
-    _tagInfoListModel->clearAndDeleteContents();
+    _loaded = false;
+    _loadWatcher.setFuture(QtConcurrent::run(&TagDatabase::_loadFiles, _tagInfoFilePath(), _tagManufacturerFilePath(), _journalFilePath()));
+}
 
-    if (!QFileInfo(_tagInfoFilePath()).exists() || !QFileInfo(_tagManufacturerFilePath()).exists()) {
-        qDebug() << "Not loading tag info since files are missing";
+// Called when the worker finishes, or earlier by anything which needs the records before then. An early caller blocks
+// the calling thread, normally the GUI thread, in waitForFinished until the files are parsed.
+void TagDatabase::_ensureLoaded()
+{
+    if (_loaded) {
         return;
     }
+    _loadWatcher.waitForFinished();
+    _loaded = true;
+    _applyLoadResult(_loadWatcher.result());
+}
 
-    if (!_loadTagManufacturer()) {
-        goto Error;
-    }
-    if (!_loadTagInfo()) {
-        goto Error;
+void TagDatabase::_applyLoadResult(const LoadResult_t& loadResult)
+{
+    if (!loadResult.errorString.isEmpty()) {
+        qgcApp()->showAppMessage(loadResult.errorString);
+        // The snapshot may hold records which did not load, so it must not be rewritten from what did
+        _loadFailed = true;
     }
 
-    return;
-
-Error:
-    _tagManufacturerListModel->clearAndDeleteContents();
-    _tagInfoListModel->clearAndDeleteContents();
+    _tagRecords             = loadResult.tags;
+    _manufacturerRecords    = loadResult.manufacturers;
+    _journalEntryCount      = loadResult.journalEntryCount;
+    _journalValidSize       = loadResult.journalValidSize;
+    _rebuildIndices();
+    _updateNextIds();
 }
 
 void TagDatabase::_setupTunerVars()
@@ -637,214 +827,59 @@ void TagDatabase::_setupTunerVars()
 #endif
 }
 
-// Find the best center frequency for the requested frequencies such that the there is only one frequency per channel
-// bin. And the requested frequested is as close to center within the channel bin as possible. Frequencies are not
-// allowed to be within a shoulder area of the channel bin. Once the best center frequency is found, the channel bin
-// values are updated for each tag.
-//
-// The channel bin structure follows the functionality of Matlab dsp.channelizer. The channel bins are 1-based to follow
-// Matlab's 1-based vector/array indexing. Channel 1 is the centered at the radio center frequency Then remainder of the
-// channels follow and wrap around back to the beginning of the bandwidth.
+// Find the best center frequency for the requested frequencies. See ChannelizerTuner for details. Once the best center
+// frequency is found, the channel bin values are updated for each tag.
 bool TagDatabase::channelizerTuner()
 {
     _setupTunerVars();
 
+    CustomSettings* customSettings = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin())->customSettings();
+    uint32_t        stepSizeHz      = customSettings->channelizerTunerStepHz()->rawValue().toUInt();
+
+    _ensureLoaded();
+
     // Build the list of requested frequencies
     QVector<uint32_t> freqListHz;
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo* tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-
-        if (tagInfo->selected()->rawValue().toUInt()) {
-            freqListHz.push_back(tagInfo->_frequencyHzFact->rawValue().toUInt());
+    for (const TagRecord_t& record: _tagRecords) {
+        if (record.selected) {
+            freqListHz.push_back(record.frequencyHz);
         }
     }
 
-    uint32_t freqMaxHz = *std::max_element(freqListHz.begin(), freqListHz.end());
-    uint32_t freqMinHz = *std::min_element(freqListHz.begin(), freqListHz.end());
+    ChannelizerTuner            tuner(_sampleRateHz, _nChannels);
+    ChannelizerTuner::Result_t  result;
 
-    // First make sure all the requested frequencies can fit within the available bandwidth
-    if (freqMaxHz - freqMinHz > _sampleRateHz) {
-        qCritical() << "Requested frequencies are too far apart to fit within the available bandwidth";
+    if (!tuner.tune(freqListHz, stepSizeHz, true /* multiThreaded */, result)) {
+        qCritical() << "Channelizer tuner unable to find a valid center frequency for" << freqListHz;
+        _radioCenterHz = 0;
         return false;
     }
 
-    QList<uint32_t> testCentersHz;
-
-    // Generate the list of center channels to test against. Start with min to max
-    if (freqMinHz == freqMaxHz) {
-        testCentersHz.push_back(freqMaxHz);
-    } else {
-        uint32_t stepSizeHz     = 100;
-        uint32_t nextPossibleHz = freqMinHz;
-        while (nextPossibleHz <= freqMaxHz) {
-            testCentersHz.push_back(nextPossibleHz);
-            nextPossibleHz += stepSizeHz;
-        }
-    }
-#ifdef DEBUG_TUNER
-    qDebug() << "testCentersHz-raw:" << testCentersHz;
-#endif
-
-    // Remove any test centers for which a requested frequency would fall outside the full bandwidth
-    for (auto testCenterHzIter = testCentersHz.begin(); testCenterHzIter != testCentersHz.end(); ) {
-        if (freqMinHz < *testCenterHzIter - _halfBwHz || freqMaxHz > *testCenterHzIter + _halfBwHz) {
-            testCenterHzIter = testCentersHz.erase(testCenterHzIter);
-        } else {
-            ++testCenterHzIter;
-        }
-    }
-#ifdef DEBUG_TUNER
-    qDebug() << "testCentersHz-filtered:" << testCentersHz;
-#endif
-
-    QVector <uint>          channelBucketUsageCountsForTestCenter (_nChannels);
-    QList   <QList<uint>>   oneBasedChannelBucketsArray;
-    QList   <QVector<uint>> channelBucketUsageCountsArray;
-    QList   <uint32_t>      distanceFromCenterAverages;
-    QList   <QList<bool>>   inShoulderArray;
-
-    for (auto testCenterHz : testCentersHz) {
-        channelBucketUsageCountsForTestCenter.fill(0);
-
-        QList<uint32_t>  distanceFromCenters;
-        QList<bool>     inShoulders;
-        QList<uint>     oneBasedChannelBuckets;
-
-        // If the requested frequency is below the center frequency bucket, we add the sample rate to it.
-        // The simplifies channel bucket calculations.
-        auto wrappedRequestedFreqsHz = freqListHz;
-        std::transform(freqListHz.begin(), freqListHz.end(), wrappedRequestedFreqsHz.begin(),
-            [this, testCenterHz](uint32_t freqHz) {
-                if (freqHz >= testCenterHz - _halfChannelBwHz) {
-                    return freqHz;
-                } else {
-                    return freqHz + _sampleRateHz;
-                }
-            });
-
+    qDebug() << "bestTestCenterHz:" << result.centerHz
+             << "smallestDistanceFromCenterAverage" << result.averageDistanceFromCenterHz
+             << "oneBasedChannelBuckets:" << result.oneBasedChannels;
 #ifdef DEBUG_TUNER
-        qDebug() << "freqListHz:" << freqListHz << "wrappedRequestedFreqsHz:" << wrappedRequestedFreqsHz;
+    _printChannelMap(result.centerHz, freqListHz);
+    qDebug() << "channelCentersHz" << result.channelCentersHz;
 #endif
 
-        for (auto wrappedFreqHz : wrappedRequestedFreqsHz) {
-            uint32_t tagFreqZeroBasedBandwidthHz        = wrappedFreqHz - ((int)testCenterHz - (int)_halfChannelBwHz);      // Adjust to zero-based within total bandwidth
-            uint32_t zeroBasedChannelBucket             = tagFreqZeroBasedBandwidthHz  / _channelBwHz;
-            uint32_t channelStartZeroBasedHz            = zeroBasedChannelBucket * _channelBwHz;                            // Zero based Hz of channel starting point
-            uint32_t tagFreqZeroBasedWithinChannelHz    = tagFreqZeroBasedBandwidthHz - channelStartZeroBasedHz;            // Tag freq adjusted to zero based from start of containing channel
-            uint32_t distanceFromChannelCenter          = abs((int)tagFreqZeroBasedWithinChannelHz - (int)_halfChannelBwHz);
-
-            double  shoulderPercent = 0.85; // Shoulder is 15% from channel edge
-            bool    inShoulder      = distanceFromChannelCenter > _halfChannelBwHz * shoulderPercent;
+    // Add the channel bucket numbers to the tag records
+    int j = 0;
+    for (int i=0; i<_tagRecords.count(); i++) {
+        TagRecord_t& record = _tagRecords[i];
 
-#ifdef DEBUG_TUNER
-            qDebug() << "---- single freq build begin ---";
-            qDebug() <<
-                "testCenterHz:" << testCenterHz <<
-                "wrappedFreqHz:" << wrappedFreqHz <<
-                "tagFreqZeroBasedBandwidthHz:" << tagFreqZeroBasedBandwidthHz <<
-                "zeroBasedChannelBucket:" << zeroBasedChannelBucket <<
-                "channelStartZeroBasedHz:" << channelStartZeroBasedHz <<
-                "tagFreqZeroBasedWithinChannelHz:" << tagFreqZeroBasedWithinChannelHz <<
-                "distanceFromChannelCenter:" << distanceFromChannelCenter <<
-                "inShoulder:" << inShoulder;
-            //_printChannelMap(testCenterHz, QVector<uint32_t>({wrappedFreqHz}));
-            qDebug() << "---- single freq build end ---";
-#endif
-
-            distanceFromCenters.push_back(distanceFromChannelCenter);
-            inShoulders.push_back(inShoulder);
-            oneBasedChannelBuckets.push_back(zeroBasedChannelBucket + 1);
-
-            channelBucketUsageCountsForTestCenter[zeroBasedChannelBucket]++;
+        if (record.selected) {
+            record.channelizer_channel_number               = result.oneBasedChannels[j];
+            record.channelizer_channel_center_frequency_hz  = result.channelCentersHz[result.oneBasedChannels[j] - 1];
+            qDebug() << i << j
+                    << record.channelizer_channel_number
+                    << record.channelizer_channel_center_frequency_hz;
+            j++;
         }
-
-        oneBasedChannelBucketsArray.push_back(oneBasedChannelBuckets);
-        channelBucketUsageCountsArray.push_back(channelBucketUsageCountsForTestCenter);
-        inShoulderArray.push_back(inShoulders);
-
-        // Find the average of the distances from the center of each channel
-        auto averageDistanceFromCenter = std::accumulate(distanceFromCenters.begin(), distanceFromCenters.end(), 0) / distanceFromCenters.size();
-        distanceFromCenterAverages.push_back(averageDistanceFromCenter);
-
-#ifdef DEBUG_TUNER
-        qDebug() << "---- test center build begin ---";
-        qDebug() << "testCenterHz" << testCenterHz;
-        //_printChannelMap(testCenterHz, wrappedRequestedFreqsHz);
-        qDebug() << "averageDistanceFromCenter:" << averageDistanceFromCenter;
-        qDebug() << "---- test center build end ---";
-#endif
     }
 
-    // Find the best center frequency
-
-    uint32_t    smallestDistanceFromCenterAverage   = _channelBwHz;
-    uint32_t    bestTestCenterHz                    = 0;
-    QList<uint> oneBasedChannelBuckets;
-
-    for (int i = 0; i < testCentersHz.size(); i++) {
-        auto testCenterHz = testCentersHz[i];
-
-        // We can't use a center frequency if it has more than one frequency in the same channel
-        if (std::any_of(channelBucketUsageCountsForTestCenter.begin(), channelBucketUsageCountsForTestCenter.end(), [](uint32_t n) { return n > 1; })) {
-            continue;
-        }
-
-        // We can use a center frequency if any of the frequencies are in the shoulder
-        if (std::any_of(inShoulderArray[i].begin(), inShoulderArray[i].end(), [](bool inShoulder) { return inShoulder; })) {
-            continue;
-        }
-
-        // Keep track of the smallest average distance from center
-        if (distanceFromCenterAverages[i] < smallestDistanceFromCenterAverage) {
-            smallestDistanceFromCenterAverage = distanceFromCenterAverages[i];
-            bestTestCenterHz = testCenterHz;
-            oneBasedChannelBuckets = oneBasedChannelBucketsArray[i];
-        }
-    }
-
-    qDebug() << "bestTestCenterHz:" << bestTestCenterHz
-             << "smallestDistanceFromCenterAverage" << smallestDistanceFromCenterAverage
-             << "oneBasedChannelBuckets:" << oneBasedChannelBuckets;
-    if (bestTestCenterHz != 0) {
-        //_printChannelMap(bestTestCenterHz, freqListHz);
-
-        // Generate the channel centers
-
-        QList<uint32_t> channelCentersHz;
-        uint32_t        nextCenterHz = bestTestCenterHz;
-        for (uint i=0; i<_nChannels; i++) {
-            if (i > _nChannels / 2) {
-                // Deal with odd matlab channel wrap-around
-                channelCentersHz.append(nextCenterHz - _fullBwHz);
-            } else {
-                channelCentersHz.append(nextCenterHz);
-            }
-            nextCenterHz += _channelBwHz;
-        }
-        qDebug() << "channelCentersHz" << channelCentersHz;
-
-        // Add the channel bucket numbers to the tagInfo
-        int j = 0;
-        for (int i=0; i<_tagInfoListModel->count(); i++) {
-            auto tagInfo = _tagInfoListModel->value<TagInfo*>(i);
-
-            if (tagInfo->selected()->rawValue().toUInt()) {
-                tagInfo->channelizer_channel_number               = oneBasedChannelBuckets[j];
-                tagInfo->channelizer_channel_center_frequency_hz  = channelCentersHz[oneBasedChannelBuckets[j] - 1];
-                qDebug() << i << j
-                        << tagInfo->channelizer_channel_number
-                        << tagInfo->channelizer_channel_center_frequency_hz;
-                j++;
-            }
-        }
-
-
-        _radioCenterHz = bestTestCenterHz;
-        return true;
-    } else {
-        _radioCenterHz = 0;
-        return false;
-    }
+    _radioCenterHz = result.centerHz;
+    return true;
 }
 
 void TagDatabase::_printChannelMap(const uint32_t centerFreqHz, const QVector<uint32_t>& wrappedRequestedFreqsHz)
@@ -900,14 +935,16 @@ uint32_t TagDatabase::maxIntraPulseMsecs()
 {
     uint32_t maxIntraPulseMsecs  = 0;
 
-    for (int i=0; i<_tagInfoListModel->count(); i++) {
-        TagInfo*            tagInfo         = _tagInfoListModel->value<TagInfo*>(i);
-        TagManufacturer*    tagManufacturer = findTagManufacturer(tagInfo->manufacturerId()->rawValue().toUInt());
+    for (const TagRecord_t& record: tagRecords()) {
+        const ManufacturerRecord_t* manufacturer = findManufacturerRecord(record.manufacturerId);
+        if (!manufacturer) {
+            continue;
+        }
 
-        maxIntraPulseMsecs = std::max(maxIntraPulseMsecs, tagManufacturer->ip_msecs_1()->rawValue().toUInt());
+        maxIntraPulseMsecs = std::max(maxIntraPulseMsecs, manufacturer->ip_msecs_1);
 
-        if (tagManufacturer->ip_msecs_2()->rawValue().toUInt() != 0) {
-            maxIntraPulseMsecs = std::max(maxIntraPulseMsecs, tagManufacturer->ip_msecs_2()->rawValue().toUInt());
+        if (manufacturer->ip_msecs_2 != 0) {
+            maxIntraPulseMsecs = std::max(maxIntraPulseMsecs, manufacturer->ip_msecs_2);
         }
     }
 
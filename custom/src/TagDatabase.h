@@ -2,14 +2,44 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QFutureWatcher>
 
 #include "Fact.h"
 #include "QmlObjectListModel.h"
 
 class FactMetaData;
 class TagDatabase;
-class TagDatabase;
 
+/// Plain tag record. This is what the rest of the plugin works with, the Fact based TagInfo objects only exist for
+/// the editing ui.
+struct TagRecord_t {
+    bool        selected                                = false;
+    uint32_t    id                                      = 0;
+    QString     name;
+    uint32_t    manufacturerId                          = 0;
+    uint32_t    frequencyHz                             = 0;
+    // The 1-based channel index from which this channel is output from the channelizer.
+    uint32_t    channelizer_channel_number              = 0;
+    // The center frequency of the above channel
+    uint32_t    channelizer_channel_center_frequency_hz = 0;
+};
+
+struct ManufacturerRecord_t {
+    uint32_t    id                      = 0;
+    QString     name;
+    uint32_t    ip_msecs_1              = 0;
+    uint32_t    ip_msecs_2              = 0;
+    QString     ip_msecs_1_id;
+    QString     ip_msecs_2_id;
+    uint32_t    pulse_width_msecs       = 0;
+    uint32_t    ip_uncertainty_msecs    = 0;
+    uint32_t    ip_jitter_msecs         = 0;
+};
+
+/// Editable view of a TagRecord_t. Fact changes are written back to the record.
 class TagInfo : public QObject
 {
     Q_OBJECT
@@ -17,8 +47,7 @@ class TagInfo : public QObject
     friend class TagDatabase;
 
 public:
-    TagInfo(TagDatabase* parent);
-    TagInfo(bool selected, uint32_t id, QString& name, uint32_t manufacturerId, uint32_t frequencyHz, TagDatabase* parent);
+    TagInfo(const TagRecord_t& record, TagDatabase* parent);
 
     Q_PROPERTY(Fact* selected       MEMBER _selectedFact        CONSTANT)
     Q_PROPERTY(Fact* id             MEMBER _idFact              CONSTANT)
@@ -32,44 +61,25 @@ public:
     Fact* manufacturerId() { return _manufacturerIdFact; }
     Fact* frequencyHz()    { return _frequencyHzFact; }
 
-	// The 1-based channel index from which this channel is output from the channelizer.
-	uint32_t channelizer_channel_number;
-	// The center frequency of the above channel
-	uint32_t channelizer_channel_center_frequency_hz;
-
 private:
-    void _initCommon(TagDatabase* parent);
-    void _init(bool selected, uint32_t id, const QString& name, uint32_t manufacturedId, uint32_t frequencyHz);
-    QString _nextTagName();
-    
-    TagDatabase*                    _parent             = nullptr;
-    QMap<QString, FactMetaData*>    _tagInfoMetaData;
-    Fact*                           _selectedFact       = nullptr;
-    Fact*                           _idFact             = nullptr;
-    Fact*                           _nameFact           = nullptr;
-    Fact*                           _manufacturerIdFact = nullptr;
-    Fact*                           _frequencyHzFact    = nullptr;
+    TagDatabase*    _parent             = nullptr;
+    uint32_t        _recordId;          ///< Id of the record this object edits
+    Fact*           _selectedFact       = nullptr;
+    Fact*           _idFact             = nullptr;
+    Fact*           _nameFact           = nullptr;
+    Fact*           _manufacturerIdFact = nullptr;
+    Fact*           _frequencyHzFact    = nullptr;
 };
 
+/// Editable view of a ManufacturerRecord_t. Fact changes are written back to the record.
 class TagManufacturer : public QObject
 {
     Q_OBJECT
 
-    friend class TagInfo;
     friend class TagDatabase;
 
 public:
-    TagManufacturer(TagDatabase* parent);
-    TagManufacturer(uint32_t        id,
-                    const QString&  name,
-                    uint32_t        ip_msecs_1, 
-                    uint32_t        ip_msecs_2, 
-                    const QString&  ip_msecs_1_id,
-                    const QString&  ip_msecs_2_id,
-                    uint32_t        pulse_width_msecs, 
-                    uint32_t        ip_uncertainty_msecs,
-                    uint32_t        ip_jitter_msecs,
-                    TagDatabase*    parent);
+    TagManufacturer(const ManufacturerRecord_t& record, TagDatabase* parent);
 
     Q_PROPERTY(Fact* id                     MEMBER _idFact                      CONSTANT)
     Q_PROPERTY(Fact* name                   MEMBER _nameFact                    CONSTANT)
@@ -92,32 +102,26 @@ public:
     Fact* ip_jitter_msecs       () { return _ip_jitter_msecsFact; }
 
 private:
-    void _initCommon(TagDatabase* parent);
-    void _init(
-            uint32_t        id,
-            const QString&  name,
-            uint32_t        ip_msecs_1, 
-            uint32_t        ip_msecs_2, 
-            const QString&  ip_msecs_1_id,
-            const QString&  ip_msecs_2_id,
-            uint32_t        pulse_width_msecs, 
-            uint32_t        ip_uncertainty_msecs,
-            uint32_t        ip_jitter_msecs);
-    QString _nextManufacturerName();
-
-    TagDatabase*                    _parent                      = nullptr;
-    QMap<QString, FactMetaData*>    _tagManufacturerMetaData;
-    Fact*                           _idFact                     = nullptr;
-    Fact*                           _nameFact                   = nullptr;
-    Fact*                           _ip_msecs_1Fact             = nullptr;
-    Fact*                           _ip_msecs_2Fact             = nullptr;
-    Fact*                           _ip_msecs_1_idFact          = nullptr;
-    Fact*                           _ip_msecs_2_idFact          = nullptr;
-    Fact*                           _pulse_width_msecsFact      = nullptr;
-    Fact*                           _ip_uncertainty_msecsFact   = nullptr;
-    Fact*                           _ip_jitter_msecsFact        = nullptr;
+    TagDatabase*    _parent                     = nullptr;
+    uint32_t        _recordId;                  ///< Id of the record this object edits
+    Fact*           _idFact                     = nullptr;
+    Fact*           _nameFact                   = nullptr;
+    Fact*           _ip_msecs_1Fact             = nullptr;
+    Fact*           _ip_msecs_2Fact             = nullptr;
+    Fact*           _ip_msecs_1_idFact          = nullptr;
+    Fact*           _ip_msecs_2_idFact          = nullptr;
+    Fact*           _pulse_width_msecsFact      = nullptr;
+    Fact*           _ip_uncertainty_msecsFact   = nullptr;
+    Fact*           _ip_jitter_msecsFact        = nullptr;
 };
 
+/// Tag and manufacturer store. Records are kept in load order with an id index. The files are parsed on a worker
+/// thread at startup, anything which needs the records before that finishes waits for it.
+///
+/// TagInfo.db and TagManufacturer.db hold a snapshot of the records. save() appends only the records changed since the
+/// last save to TagDatabase.journal, which is replayed on top of the snapshot at load. Once the journal grows past the
+/// record count it is folded back into the snapshot. A load which hits errors keeps the records it could read and leaves
+/// the files as they are, see _loadFiles.
 class TagDatabase : public QObject
 {
     Q_OBJECT
@@ -126,11 +130,12 @@ class TagDatabase : public QObject
     friend class TagManufacturer;
 
 public:
-    TagDatabase(QObject* parent = NULL);
+    /// @param dirPath Directory for the database files, empty for the parameter save path
+    TagDatabase(QObject* parent = NULL, const QString& dirPath = QString());
     ~TagDatabase();
 
-    Q_PROPERTY(QmlObjectListModel* tagInfoList          MEMBER _tagInfoListModel            CONSTANT)
-    Q_PROPERTY(QmlObjectListModel* tagManufacturerList  MEMBER _tagManufacturerListModel    CONSTANT)
+    Q_PROPERTY(QmlObjectListModel* tagInfoList          READ tagInfoListModel           CONSTANT)
+    Q_PROPERTY(QmlObjectListModel* tagManufacturerList  READ tagManufacturerListModel   CONSTANT)
 
     Q_INVOKABLE QObject* newTagInfo();
     Q_INVOKABLE QObject* newTagManufacturer();
@@ -138,36 +143,84 @@ public:
     Q_INVOKABLE bool deleteTagManufacturerListItem(QObject* tagManufacturerListItem);
     Q_INVOKABLE void save();
 
-    QmlObjectListModel* tagInfoListModel        () { return _tagInfoListModel; }
-    QmlObjectListModel* tagManufacturerListModel() { return _tagManufacturerListModel; }
+    /// The list models, and the Facts in them, are only created on first use
+    QmlObjectListModel* tagInfoListModel        ();
+    QmlObjectListModel* tagManufacturerListModel();
+
+    const QVector<TagRecord_t>&             tagRecords          ();
+    const QVector<ManufacturerRecord_t>&    manufacturerRecords ();
 
-    TagInfo*            findTagInfo         (uint32_t id);
-    TagManufacturer*    findTagManufacturer (uint32_t id);
+    /// O(1) lookups
+    /// @return nullptr: not found
+    const TagRecord_t*          findTagRecord           (uint32_t id);
+    const ManufacturerRecord_t* findManufacturerRecord  (uint32_t id);
 
     uint32_t radioCenterHz      () { return _radioCenterHz; }
     uint32_t maxIntraPulseMsecs ();
     bool    channelizerTuner    ();
 
+    /// Number of entries in the journal which have not been folded into the snapshot yet
+    int     journalEntryCount   () const { return _journalEntryCount; }
+
+    static constexpr int minCompactJournalEntries = 64;
+
 private:
+    struct LoadResult_t {
+        QVector<TagRecord_t>            tags;
+        QVector<ManufacturerRecord_t>   manufacturers;
+        int                             journalEntryCount = 0;
+        qint64                          journalValidSize  = -1;     ///< Journal size up to the last good entry, -1: all good
+        QString                         errorString;
+    };
+
     uint32_t _nextTagInfoId();
     uint32_t _nextTagManufacturerId();
+    QString  _nextTagName();
+    QString  _nextManufacturerName();
     QString  _tagInfoFilePath();
     QString  _tagManufacturerFilePath();
-    bool     _saveTagInfo();
-    bool     _saveTagManufacturer();
-    bool     _loadTagInfo();
-    bool     _loadTagManufacturer();
+    QString  _journalFilePath();
+    bool     _compact();
     void     _load();
-    void    _setupTunerVars     ();
-    void    _printChannelMap    (const uint32_t centerFreqHz, const QVector<uint32_t>& wrappedRequestedFreqsHz);
-    int     _firstChannelFreqHz (const int centerFreq);
-    void    _updateNextIds      ();
-    
+    void     _ensureLoaded();
+    void     _applyLoadResult(const LoadResult_t& loadResult);
+    void     _rebuildIndices();
+    void     _tagInfoChanged(TagInfo* tagInfo);
+    void     _tagManufacturerChanged(TagManufacturer* tagManufacturer);
+    void     _setupTunerVars     ();
+    void     _printChannelMap    (const uint32_t centerFreqHz, const QVector<uint32_t>& wrappedRequestedFreqsHz);
+    int      _firstChannelFreqHz (const int centerFreq);
+    void     _updateNextIds      ();
+    const QMap<QString, FactMetaData*>& _tagInfoMetaData();
+    const QMap<QString, FactMetaData*>& _tagManufacturerMetaData();
+
+    static LoadResult_t _loadFiles                  (const QString& tagInfoPath, const QString& tagManufacturerPath, const QString& journalPath);
+    static bool         _parseTagRecord             (const QList<QByteArray>& values, TagRecord_t& record, QString& errorString);
+    static bool         _parseManufacturerRecord    (const QList<QByteArray>& values, ManufacturerRecord_t& record, QString& errorString);
+    static QByteArray   _tagRecordLine              (const TagRecord_t& record);
+    static QByteArray   _manufacturerRecordLine     (const ManufacturerRecord_t& record);
+
 private:
-    QmlObjectListModel* _tagInfoListModel           = nullptr;
-    QmlObjectListModel* _tagManufacturerListModel   = nullptr;
-    uint32_t            _nextTagId                  = 2;
-    uint32_t            _nextManufacturerId         = 1;
+    QString                         _dirPath;
+    QFutureWatcher<LoadResult_t>    _loadWatcher;
+    bool                            _loaded                     = false;
+
+    QVector<TagRecord_t>            _tagRecords;
+    QVector<ManufacturerRecord_t>   _manufacturerRecords;
+    QHash<uint32_t, int>            _tagIndexById;
+    QHash<uint32_t, int>            _manufacturerIndexById;
+    QSet<uint32_t>                  _dirtyTagIds;               ///< Changed or deleted since the last save
+    QSet<uint32_t>                  _dirtyManufacturerIds;
+    int                             _journalEntryCount          = 0;
+    qint64                          _journalValidSize           = -1;       ///< Truncate the journal to this before the next append
+    bool                            _loadFailed                 = false;    ///< Files are never compacted after a failed load
+
+    QmlObjectListModel*             _tagInfoListModel           = nullptr;
+    QmlObjectListModel*             _tagManufacturerListModel   = nullptr;
+    QMap<QString, FactMetaData*>    _tagInfoMetaDataMap;
+    QMap<QString, FactMetaData*>    _tagManufacturerMetaDataMap;
+    uint32_t                        _nextTagId                  = 2;
+    uint32_t                        _nextManufacturerId         = 1;
 
     uint32_t            _radioCenterHz      = 0;
     QVector<uint32_t>   _channelBucketCenters;
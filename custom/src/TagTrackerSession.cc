@@ -0,0 +1,1143 @@
+#include "TagTrackerSession.h"
+#include "CustomPlugin.h"
+#include "CustomSettings.h"
+#include "TagDatabase.h"
+#include "TagTriangulator.h"
+#include "Vehicle.h"
+#include "QGCApplication.h"
+#include "MultiVehicleManager.h"
+#include "QGC.h"
+
+#include "coder_array.h"
+#include "bearing.h"
+
+#include <QDebug>
+#include <QtConcurrent>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(TagTrackerSessionLog, "TagTrackerSessionLog")
+
+static double _normalizeHeading(double headingDegrees)
+{
+    headingDegrees = fmod(headingDegrees, 360.0);
+    return headingDegrees < 0 ? headingDegrees + 360.0 : headingDegrees;
+}
+
+TagTrackerSession::TagTrackerSession(int vehicleId, CustomPlugin* customPlugin)
+    : QObject           (customPlugin)
+    , _vehicleId        (vehicleId)
+    , _customPlugin     (customPlugin)
+    , _customSettings   (customPlugin->customSettings())
+    , _tagDatabase      (customPlugin->tagDatabase())
+    , _controllerStatus (CustomPlugin::ControllerStatusIdle)
+    , _tunnelCommandQueue([this](const QByteArray& payload) { return _transmitTunnelPayload(payload); })
+{
+    _vehicleStateTimeoutTimer.setSingleShot(true);
+    _controllerHeartbeatTimer.setSingleShot(true);
+    _controllerHeartbeatTimer.setInterval(6000);    // We should get heartbeats every 5 seconds
+
+    // Don't send tags too fast
+    _tunnelCommandQueue.setMinSendInterval(COMMAND_ID_TAG, 100);
+
+    connect(&_vehicleStateTimeoutTimer,     &QTimer::timeout, this, &TagTrackerSession::_vehicleStateTimeout);
+    connect(&_tunnelCommandQueue,           &TunnelCommandQueue::commandAcked,  this, &TagTrackerSession::_tunnelCommandAcked);
+    connect(&_tunnelCommandQueue,           &TunnelCommandQueue::commandFailed, this, &TagTrackerSession::_tunnelCommandFailed);
+    connect(&_controllerHeartbeatTimer,     &QTimer::timeout, this, &TagTrackerSession::_controllerHeartbeatFailed);
+    connect(&_pulseIngest,                  &PulseIngest::pulsesReady, this, &TagTrackerSession::_handlePulses);
+}
+
+TagTrackerSession::~TagTrackerSession()
+{
+    _stopFullPulseLog();
+    _stopRotationPulseLog(false /* calcBearing*/);
+}
+
+Vehicle* TagTrackerSession::_vehicle(void)
+{
+    return qgcApp()->toolbox()->multiVehicleManager()->getVehicleById(_vehicleId);
+}
+
+void TagTrackerSession::handleTunnel(const mavlink_tunnel_t& tunnel)
+{
+    HeaderInfo_t header;
+    memcpy(&header, tunnel.payload, sizeof(header));
+
+    switch (header.command) {
+    case COMMAND_ID_ACK:
+        _handleTunnelCommandAck(tunnel);
+        break;
+    case COMMAND_ID_PULSE:
+        // Pulses are stamped with their arrival time, decoded off the gui thread and delivered back in batches to _handlePulses
+        _pulseIngest.ingest(tunnel);
+        break;
+    case COMMAND_ID_HEARTBEAT:
+        _handleTunnelHeartbeat(tunnel);
+        break;
+    }
+}
+
+void TagTrackerSession::vehicleRemoved(void)
+{
+    qCDebug(TagTrackerSessionLog) << "vehicleRemoved" << _vehicleId;
+
+    if (_flightStateMachineActive) {
+        _vehicleStateTimeoutTimer.stop();
+        for (const VehicleState_t& vehicleState: _vehicleStates) {
+            if (vehicleState.fact) {
+                disconnect(vehicleState.fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+            }
+        }
+        _updateFlightMachineActive(false);
+    }
+    _tunnelCommandQueue.clear();
+
+    _stopFullPulseLog();
+    _stopRotationPulseLog(false /* calcBearing*/);
+
+    _controllerHeartbeatTimer.stop();
+    _controllerHeartbeatFailed();
+}
+
+void TagTrackerSession::_handleTunnelHeartbeat(const mavlink_tunnel_t& tunnel)
+{
+    Heartbeat_t heartbeat;
+
+    memcpy(&heartbeat, tunnel.payload, sizeof(heartbeat));
+
+    switch (heartbeat.system_id) {
+    case HEARTBEAT_SYSTEM_ID_MAVLINKCONTROLLER:
+        qCDebug(TagTrackerSessionLog) << "HEARTBEAT from MavlinkTagController - vehicle:counter:status:temp" << _vehicleId << _controllerHeartbeatCounter++ << heartbeat.status << heartbeat.cpu_temp_c;
+        _controllerLostHeartbeat = false;
+        emit controllerLostHeartbeatChanged();
+        _controllerHeartbeatTimer.start();
+        _pipelineTelemetry.recordControllerHeartbeat(QDateTime::currentMSecsSinceEpoch(), heartbeat.cpu_temp_c);
+        if (_controllerStatus != heartbeat.status) {
+            _controllerStatus = heartbeat.status;
+            emit controllerStatusChanged();
+        }
+        if (_controllerCPUTemp != heartbeat.cpu_temp_c) {
+            _controllerCPUTemp = heartbeat.cpu_temp_c;
+            emit controllerCPUTempChanged();
+        }
+        break;
+    case HEARTBEAT_SYSTEM_ID_CHANNELIZER:
+        qCDebug(TagTrackerSessionLog) << "HEARTBEAT from Channelizer - vehicle" << _vehicleId;
+        _pipelineTelemetry.recordChannelizerHeartbeat(QDateTime::currentMSecsSinceEpoch());
+        break;
+    }
+}
+
+void TagTrackerSession::_handleTunnelCommandAck(const mavlink_tunnel_t& tunnel)
+{
+    AckInfo_t ack;
+
+    memcpy(&ack, tunnel.payload, sizeof(ack));
+
+    if (!_tunnelCommandQueue.handleAck(ack.command, ack.result)) {
+        qWarning() << "_handleTunnelCommandAck: Received ack for command which is not in flight vehicle:command" <<
+                      _vehicleId <<
+                      CustomPlugin::tunnelCommandIdToText(ack.command);
+    }
+}
+
+void TagTrackerSession::_tunnelCommandAcked(uint32_t sequenceId, uint32_t command, uint32_t result, qint64 latencyMsecs)
+{
+    qCDebug(TagTrackerSessionLog) << "Tunnel command ack received - vehicle:sequence:command:result:latency" << _vehicleId << sequenceId << CustomPlugin::tunnelCommandIdToText(command) << result << latencyMsecs;
+
+    if (result == COMMAND_RESULT_SUCCESS) {
+        switch (command) {
+        case COMMAND_ID_END_TAGS:
+        {
+            TunnelCommandQueue::CommandStats_t tagStats = _tunnelCommandQueue.stats(COMMAND_ID_TAG);
+            qCDebug(TagTrackerSessionLog) << "Tags sent - vehicle:msecs:tagAcks:retransmits:meanLatency:maxLatency" <<
+                                             _vehicleId <<
+                                             _sendTagsTimer.elapsed() <<
+                                             tagStats.ackCount <<
+                                             tagStats.retransmitCount <<
+                                             tagStats.meanLatencyMsecs <<
+                                             tagStats.maxLatencyMsecs;
+            _detectorInfoListModel.setupFromTags(_tagDatabase);
+            break;
+        }
+        case COMMAND_ID_START_DETECTION:
+            _startFullPulseLog();
+            break;
+        case COMMAND_ID_STOP_DETECTION:
+            _stopFullPulseLog();
+            break;
+        }
+    } else {
+        QString message = QStringLiteral("%1 command failed").arg(CustomPlugin::tunnelCommandIdToText(command));
+
+        _say(message);
+        qgcApp()->showAppMessage(message);
+
+        // Anything queued behind a failed command, such as the rest of a tag upload, is no longer valid
+        _tunnelCommandQueue.clear();
+    }
+}
+
+void TagTrackerSession::_handlePulses(const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs)
+{
+    _pipelineTelemetry.recordPulsesProcessed(pulses, arrivalMsecs, QDateTime::currentMSecsSinceEpoch());
+    _detectorInfoListModel.handlePulses(pulses);
+    _pulseHistory.addPulses(pulses);
+
+    for (const PulseInfoPtr& pulseInfo: pulses) {
+        _handlePulse(*pulseInfo);
+    }
+
+    _checkAdaptiveDwellComplete();
+
+    emit pulsesProcessed(pulses.count());
+}
+
+bool TagTrackerSession::_collectingRotationSlice(void)
+{
+    return _flightStateMachineActive &&
+            _vehicleStateIndex >= 0 &&
+            _vehicleStateIndex < _vehicleStates.count() &&
+            _vehicleStates[_vehicleStateIndex].command == CommandWaitForHeartbeats;
+}
+
+bool TagTrackerSession::_collectingContinuousRotation(void)
+{
+    return _flightStateMachineActive &&
+            _vehicleStateIndex >= 0 &&
+            _vehicleStateIndex < _vehicleStates.count() &&
+            _vehicleStates[_vehicleStateIndex].command == CommandYawAtRate;
+}
+
+bool TagTrackerSession::_useSNRForPulseStrength(void)
+{
+    return _customSettings->useSNRForPulseStrength()->rawValue().toBool();
+}
+
+// With adaptive dwell a slice ends as soon as all detectors have reported the required number of K groups instead
+// of always waiting for the worst case dwell time.
+void TagTrackerSession::_checkAdaptiveDwellComplete(void)
+{
+    if (!_customSettings->rotationAdaptiveDwell()->rawValue().toBool() || !_collectingRotationSlice() || _detectorInfoListModel.count() == 0) {
+        return;
+    }
+
+    uint32_t kGroups = _customSettings->rotationKWaitCount()->rawValue().toUInt();
+    if (!_detectorInfoListModel.allPulseGroupCountsReached(kGroups)) {
+        return;
+    }
+
+    // The confidence floor is the minimum portion of the full dwell which must pass before a slice can end early
+    int fullDwellMsecs  = _vehicleStates[_vehicleStateIndex].targetValueWaitMsecs;
+    int minDwellMsecs   = (fullDwellMsecs * _customSettings->rotationAdaptiveMinDwellPct()->rawValue().toInt()) / 100;
+    int elapsedMsecs    = static_cast<int>(_sliceDwellTimer.elapsed());
+
+    if (elapsedMsecs < minDwellMsecs) {
+        // Let the state timeout fire once the floor is reached
+        _vehicleStateTimeoutTimer.start(minDwellMsecs - elapsedMsecs);
+        return;
+    }
+
+    _vehicleStateTimeoutTimer.stop();
+    _rotationDelayComplete();
+}
+
+void TagTrackerSession::_handlePulse(const PulseInfo_t& pulseInfo)
+{
+    bool isDetectorHeartbeat = pulseInfo.frequency_hz == 0;
+    if (pulseInfo.confirmed_status || isDetectorHeartbeat) {
+        auto evenTagId  = pulseInfo.tag_id - (pulseInfo.tag_id % 2);
+        auto tagRecord  = _tagDatabase->findTagRecord(evenTagId);
+
+        if (!tagRecord) {
+            qWarning() << "_handlePulse: Received pulse for unknown vehicle:tag_id" << _vehicleId << pulseInfo.tag_id;
+            return;
+        }
+
+        if (!isDetectorHeartbeat) {
+            double antennaOffset = _customSettings->antennaOffset()->rawValue().toDouble();
+            _fullPulseLog.logPulse(pulseInfo, antennaOffset);
+            _rotationPulseLog.logPulse(pulseInfo, antennaOffset);
+
+            if (_collectingRotationSlice()) {
+                _bearingEstimator.addPulse(pulseInfo);
+            } else if (_collectingContinuousRotation()) {
+                _addContinuousRotationPulse(pulseInfo);
+            }
+
+            qCDebug(TagTrackerSessionLog) << Qt::fixed << qSetRealNumberPrecision(2) <<
+                                        "CONFIRMED vehicle" <<
+                                        _vehicleId <<
+                                        "tag_id" <<
+                                        pulseInfo.tag_id <<
+                                        "snr" <<
+                                        pulseInfo.snr <<
+                                        "stft_score" <<
+                                        pulseInfo.stft_score;
+
+            // Pulses are always aggregated into the heat map, showPulseOnMap only controls its visibility
+            if (pulseInfo.snr != 0) {
+                _customPlugin->pulseHeatMap()->addPulse(QGeoCoordinate(pulseInfo.position_x, pulseInfo.position_y), _useSNRForPulseStrength() ? pulseInfo.snr : pulseInfo.stft_score);
+            }
+        }
+    } else {
+        qCDebug(TagTrackerSessionLog) << Qt::fixed << qSetRealNumberPrecision(2) <<
+                                    "Uncconfirmed vehicle" <<
+                                    _vehicleId <<
+                                    "tag_id" <<
+                                    pulseInfo.tag_id <<
+                                    "snr" <<
+                                    pulseInfo.snr <<
+                                    "stft_score" <<
+                                    pulseInfo.stft_score;
+    }
+
+}
+
+void TagTrackerSession::_startFullPulseLog(void)
+{
+    if (_fullPulseLog.isOpen()) {
+        qgcApp()->showAppMessage("Unabled to open full pulse log file - log already open");
+        return;
+    }
+
+    QString fileName = QString("%1/Pulse-%2-%3.%4").arg(_customPlugin->logSavePath()).arg(_vehicleId).arg(QDateTime::currentDateTime().toString("yyyy-MM-dd-hh-mm-ss-zzz"), PulseLogFileExtension);
+    qCDebug(TagTrackerSessionLog) << "Full Pulse logging to:" << fileName;
+    if (!_fullPulseLog.open(fileName)) {
+        qgcApp()->showAppMessage(QString("Open of full pulse log file failed: %1").arg(fileName));
+        return;
+    }
+}
+
+void TagTrackerSession::_stopFullPulseLog(void)
+{
+    if (_fullPulseLog.isOpen()) {
+        _fullPulseLog.close();
+
+        // Export a csv copy for the Matlab tools without blocking the ui
+        QString pulseLogFileName    = _fullPulseLog.fileName();
+        QString csvFileName         = QFileInfo(pulseLogFileName).path() + "/" + QFileInfo(pulseLogFileName).completeBaseName() + ".csv";
+        QtConcurrent::run([pulseLogFileName, csvFileName]() {
+            QString errorString;
+            if (!PulseLogReader::exportToCsv(pulseLogFileName, csvFileName, errorString)) {
+                qCWarning(TagTrackerSessionLog) << "Full pulse log csv export failed" << errorString;
+            }
+        });
+    }
+}
+
+void TagTrackerSession::_startRotationPulseLog(int rotationCount)
+{
+    if (_rotationPulseLog.isOpen()) {
+        qgcApp()->showAppMessage("Unabled to open rotation pulse log file - log already open");
+        return;
+    }
+
+    QString fileName = QString("%1/Rotation-%2-%3.%4").arg(_customPlugin->logSavePath()).arg(_vehicleId).arg(rotationCount).arg(PulseLogFileExtension);
+    qCDebug(TagTrackerSessionLog) << "Rotation Pulse logging to:" << fileName;
+    if (!_rotationPulseLog.open(fileName)) {
+        qgcApp()->showAppMessage(QString("Open of rotation pulse log file failed: %1").arg(fileName));
+        return;
+    }
+}
+
+void TagTrackerSession::_stopRotationPulseLog(bool calcBearing)
+{
+    if (_rotationPulseLog.isOpen()) {
+        _logRotationStartStop(_rotationPulseLog, false /* startRotation */);
+        _rotationPulseLog.close();
+
+        // The bearing estimate is updated as each slice completes so there is nothing to calculate here
+        if (!calcBearing) {
+            // Rotation was cancelled, don't leave a partial estimate around
+            if (!_rgCalcedBearings.isEmpty()) {
+                _rgCalcedBearings.last() = qQNaN();
+                _customPlugin->triangulator()->setBearing(_rgTriangulationIds.last(), qQNaN());
+                emit calcedBearingsChanged();
+            }
+        } else if (_customSettings->bearingCsvCrossCheck()->rawValue().toBool()) {
+            _csvBearingCrossCheck(_rotationPulseLog.fileName());
+        }
+    }
+}
+
+void TagTrackerSession::_csvBearingCrossCheck(const QString& pulseLogFileName)
+{
+    // The Matlab bearing code reads the csv format
+    QString csvFileName = QFileInfo(pulseLogFileName).path() + "/" + QFileInfo(pulseLogFileName).completeBaseName() + ".csv";
+    QString errorString;
+    if (!PulseLogReader::exportToCsv(pulseLogFileName, csvFileName, errorString)) {
+        qCWarning(TagTrackerSessionLog) << "_csvBearingCrossCheck: export of rotation pulse log failed" << errorString;
+        return;
+    }
+
+    coder::array<char, 2U> rotationFileNameAsArray;
+    std::string rotationFileName = csvFileName.toStdString();
+    rotationFileNameAsArray.set_size(1, rotationFileName.length());
+    int index = 0;
+    for (auto chr : rotationFileName) {
+        rotationFileNameAsArray[index++] = chr;
+    }
+
+    double csvBearing = bearing(rotationFileNameAsArray);
+    if (csvBearing < 0) {
+        csvBearing += 360;
+    }
+
+    double difference = qAbs(csvBearing - _rgCalcedBearings.last());
+    if (difference > 180) {
+        difference = 360 - difference;
+    }
+    qCDebug(TagTrackerSessionLog) << "Bearing cross check vehicle:calculated:csv:difference" << _vehicleId << _rgCalcedBearings.last() << csvBearing << difference;
+}
+
+void TagTrackerSession::_logRotationStartStop(PulseLogWriter& pulseLog, bool startRotation)
+{
+    Vehicle* vehicle = _vehicle();
+    if (!vehicle) {
+        qCDebug(TagTrackerSessionLog) << "_logRotationStartStop - vehicle no longer available" << _vehicleId;
+        return;
+    }
+
+    if (pulseLog.isOpen()) {
+        QGeoCoordinate coord = vehicle->coordinate();
+        pulseLog.logRotationStartStop(startRotation, coord.latitude(), coord.longitude(), vehicle->altitudeAMSL()->rawValue().toDouble());
+    }
+}
+
+void TagTrackerSession::_updateFlightMachineActive(bool flightMachineActive)
+{
+    _flightStateMachineActive = flightMachineActive;
+    emit flightMachineActiveChanged(flightMachineActive);
+}
+
+void TagTrackerSession::cancelAndReturn(void)
+{
+    _say("Cancelling flight.");
+    _resetStateAndRTL();
+}
+
+void TagTrackerSession::startRotation(void)
+{
+    qCDebug(TagTrackerSessionLog) << "startRotation" << _vehicleId;
+
+    Vehicle* vehicle = _vehicle();
+
+    if (!vehicle) {
+        return;
+    }
+
+    _startRotationPulseLog(_rotationCount++);
+    _logRotationStartStop(_fullPulseLog, true /* startRotation */);
+    _logRotationStartStop(_rotationPulseLog, true /* startRotation */);
+
+    _updateFlightMachineActive(true);
+
+    // Setup new rotation data
+    _rgAngleStrengths.append(QList<double>());
+    _rgAngleRatios.append(QList<double>());
+    _rgCalcedBearings.append(qQNaN());
+    _rgTriangulationIds.append(_customPlugin->triangulator()->addRotation(vehicle->coordinate()));
+    _bearingEstimator.reset();
+
+    QList<double>&  angleStrengths =    _rgAngleStrengths.last();
+    QList<double>&  angleRatios =       _rgAngleRatios.last();
+
+    // A continuous rotation fills heading bins instead of stopping at divisions
+    bool continuousRotation = _customSettings->rotationContinuous()->rawValue().toBool();
+    if (continuousRotation) {
+        _cSlice = _customSettings->rotationContinuousBins()->rawValue().toInt();
+        _bearingEstimator.resetBinned(_cSlice);
+    } else {
+        _cSlice = _customSettings->divisions()->rawValue().toInt();
+    }
+
+    // Prime angle strengths with no values
+    for (int i=0; i<_cSlice; i++) {
+        angleStrengths.append(qQNaN());
+        angleRatios.append(qQNaN());
+    }
+    emit angleRatiosChanged();
+    emit calcedBearingsChanged();
+
+    // Create compass rose ui on map
+    QUrl url = QUrl::fromUserInput("qrc:/qml/CustomPulseRoseMapItem.qml");
+    PulseRoseMapItem* mapItem = new PulseRoseMapItem(url, this, _rgAngleStrengths.count() - 1, vehicle->coordinate(), this);
+    _customPlugin->customMapItems()->append(mapItem);
+
+    // We always start our rotation pulse captures with the antenna a 0 degrees heading
+    double antennaOffset    = _customSettings->antennaOffset()->rawValue().toDouble();
+    double sliceDegrees     = 360.0 / _cSlice;
+    double nextHeading = -antennaOffset;
+
+    // We wait at each rotation for enough time to go by to capture a user specified set of k groups
+    uint32_t    maxK                        = _customSettings->k()->rawValue().toUInt();
+    auto        kGroups                     = _customSettings->rotationKWaitCount()->rawValue().toInt();
+    auto        maxIntraPulseMsecs          = _tagDatabase->maxIntraPulseMsecs();
+    uint32_t    rotationCaptureWaitMsecs    = maxIntraPulseMsecs * ((kGroups * maxK) + 1);
+
+    _currentSlice = 0;
+
+    _vehicleStates.clear();
+
+    // Build rotation state machine entries
+    if (continuousRotation) {
+        _buildContinuousRotationStates(vehicle, nextHeading);
+    } else {
+        for (int i=0; i<_cSlice; i++) {
+            VehicleState_t vehicleState;
+
+            if (nextHeading >= 360) {
+                nextHeading -= 360;
+            } else if (nextHeading < 0) {
+                nextHeading += 360;
+            }
+
+            vehicleState.command                = CommandSetHeading;
+            vehicleState.fact                   = vehicle->heading();
+            vehicleState.targetValueWaitMsecs   = 10 * 1000;
+            vehicleState.targetValue            = nextHeading;
+            vehicleState.targetVariance         = 1;
+            vehicleState.yawRate                = 0;
+            _vehicleStates.append(vehicleState);
+
+            vehicleState.command                = CommandWaitForHeartbeats;
+            vehicleState.fact                   = nullptr;
+            vehicleState.targetValueWaitMsecs   = rotationCaptureWaitMsecs;
+            _vehicleStates.append(vehicleState);
+
+            nextHeading += sliceDegrees;
+        }
+    }
+
+    _vehicleStateIndex          = -1;
+    _retryRotation              = false;
+    _rotationDwellSavedMsecs    = 0;
+    _advanceStateMachine();
+}
+
+// A continuous rotation turns to the start heading at the default rate and then yaws through a full circle at the
+// continuous rate. An absolute heading can't describe a full turn so the circle is flown as quarter turns. Intermediate
+// headings are only passed through, the next segment is commanded before the vehicle settles.
+void TagTrackerSession::_buildContinuousRotationStates(Vehicle* vehicle, double startHeading)
+{
+    const int   cSegments           = 4;
+    double      segmentDegrees      = 360.0 / cSegments;
+    double      yawRate             = _customSettings->rotationContinuousRate()->rawValue().toDouble();
+    int         segmentWaitMsecs    = qRound(((segmentDegrees / yawRate) * 2.0 + 10.0) * 1000.0);
+
+    VehicleState_t vehicleState;
+
+    vehicleState.command                = CommandSetHeading;
+    vehicleState.fact                   = vehicle->heading();
+    vehicleState.targetValueWaitMsecs   = 10 * 1000;
+    vehicleState.targetValue            = _normalizeHeading(startHeading);
+    vehicleState.targetVariance         = 1;
+    vehicleState.yawRate                = 0;
+    _vehicleStates.append(vehicleState);
+
+    for (int i=1; i<=cSegments; i++) {
+        vehicleState.command                = CommandYawAtRate;
+        vehicleState.targetValueWaitMsecs   = segmentWaitMsecs;
+        vehicleState.targetValue            = _normalizeHeading(startHeading + (i * segmentDegrees));
+        vehicleState.targetVariance         = 2;
+        vehicleState.yawRate                = yawRate;
+        _vehicleStates.append(vehicleState);
+    }
+}
+
+void TagTrackerSession::_addContinuousRotationPulse(const PulseInfo_t& pulseInfo)
+{
+    // The pulse orientation is the vehicle attitude at the time the pulse was received. Pulses arrive well after that,
+    // by which time the vehicle has yawed on, so the current vehicle heading is only used when there is no orientation.
+    double vehicleHeading = BearingEstimator::headingFromOrientation(pulseInfo);
+    if (qIsNaN(vehicleHeading)) {
+        Vehicle* vehicle = _vehicle();
+        if (!vehicle) {
+            return;
+        }
+        vehicleHeading = vehicle->heading()->rawValue().toDouble();
+    }
+
+    double  antennaHeading  = _normalizeHeading(vehicleHeading + _customSettings->antennaOffset()->rawValue().toDouble());
+    int     bin             = _bearingEstimator.addBinnedPulse(pulseInfo, antennaHeading);
+    double  strength        = _useSNRForPulseStrength() ? pulseInfo.snr : pulseInfo.stft_score;
+    double& binStrength     = _rgAngleStrengths.last()[bin];
+
+    if (qIsNaN(binStrength) || strength > binStrength) {
+        binStrength = strength;
+        _updateAngleRatios();
+    }
+
+    double bearing = _bearingEstimator.bearing();
+    if (!(qIsNaN(bearing) && qIsNaN(_rgCalcedBearings.last())) && bearing != _rgCalcedBearings.last()) {
+        _rgCalcedBearings.last() = bearing;
+        emit calcedBearingsChanged();
+        _customPlugin->triangulator()->setBearing(_rgTriangulationIds.last(), bearing);
+    }
+}
+
+void TagTrackerSession::exportTelemetry(void)
+{
+    QString fileName = QString("%1/Telemetry-%2-%3.csv").arg(_customPlugin->logSavePath()).arg(_vehicleId).arg(QDateTime::currentDateTime().toString("yyyy-MM-dd-hh-mm-ss-zzz"));
+    QString errorString;
+    if (_pipelineTelemetry.exportToCsv(fileName, errorString)) {
+        qgcApp()->showAppMessage(QString("Telemetry exported to: %1").arg(fileName));
+    } else {
+        qgcApp()->showAppMessage(QString("Telemetry export failed: %1").arg(errorString));
+    }
+}
+
+void TagTrackerSession::startDetection(void)
+{
+    StartDetectionInfo_t startDetectionInfo;
+
+    memset(&startDetectionInfo, 0, sizeof(startDetectionInfo));
+
+    startDetectionInfo.header.command               = COMMAND_ID_START_DETECTION;
+    startDetectionInfo.radio_center_frequency_hz    = _tagDatabase->radioCenterHz();
+    startDetectionInfo.sdr_type                     = _customSettings->sdrType()->rawValue().toUInt();
+
+    _sendTunnelCommand((uint8_t*)&startDetectionInfo, sizeof(startDetectionInfo));
+}
+
+void TagTrackerSession::stopDetection(void)
+{
+    StopDetectionInfo_t stopDetectionInfo;
+
+    stopDetectionInfo.header.command = COMMAND_ID_STOP_DETECTION;
+    _sendTunnelCommand((uint8_t*)&stopDetectionInfo, sizeof(stopDetectionInfo));
+}
+
+void TagTrackerSession::rawCapture(void)
+{
+    RawCapture_t rawCapture;
+
+    rawCapture.header.command   = COMMAND_ID_RAW_CAPTURE;
+    rawCapture.sdr_type         = _customSettings->sdrType()->rawValue().toUInt();
+
+    _sendTunnelCommand((uint8_t*)&rawCapture, sizeof(rawCapture));
+}
+
+void TagTrackerSession::sendTags(void)
+{
+    bool foundSelectedTag = false;
+    for (const TagRecord_t& tagRecord: _tagDatabase->tagRecords()) {
+        if (tagRecord.selected) {
+            foundSelectedTag = true;
+            break;
+        }
+    }
+    if (!foundSelectedTag) {
+        qgcApp()->showAppMessage(("No tags are available/selected to send."));
+        return;
+    }
+
+    if (!_tagDatabase->channelizerTuner()) {
+        qgcApp()->showAppMessage("Channelizer tuner failed. Detectors not started");
+        return;
+    }
+
+    // The whole upload is queued at once. Each tag goes out once the previous one is acked, since tag acks can't be
+    // told apart, and the queue retransmits lost ones instead of the upload failing on the first lost ack.
+    _sendTagsTimer.start();
+
+    StartTagsInfo_t startTagsInfo;
+
+    startTagsInfo.header.command    = COMMAND_ID_START_TAGS;
+    startTagsInfo.sdr_type          = _customSettings->sdrType()->rawValue().toUInt();
+
+    _sendTunnelCommand((uint8_t*)&startTagsInfo, sizeof(startTagsInfo));
+
+    for (const TagRecord_t& tagRecord: _tagDatabase->tagRecords()) {
+        if (tagRecord.selected) {
+            _sendTag(tagRecord);
+        }
+    }
+
+    _sendEndTags();
+}
+
+void TagTrackerSession::_sendTag(const TagRecord_t& tagRecord)
+{
+    TunnelProtocol::TagInfo_t tunnelTagInfo;
+    auto tagManufacturer = _tagDatabase->findManufacturerRecord(tagRecord.manufacturerId);
+
+    memset(&tunnelTagInfo, 0, sizeof(tunnelTagInfo));
+
+    tunnelTagInfo.header.command = COMMAND_ID_TAG;
+    tunnelTagInfo.id                                        = tagRecord.id;
+    tunnelTagInfo.frequency_hz                              = tagRecord.frequencyHz;
+    tunnelTagInfo.pulse_width_msecs                         = tagManufacturer->pulse_width_msecs;
+    tunnelTagInfo.intra_pulse1_msecs                        = tagManufacturer->ip_msecs_1;
+    tunnelTagInfo.intra_pulse2_msecs                        = tagManufacturer->ip_msecs_2;
+    tunnelTagInfo.intra_pulse_uncertainty_msecs             = tagManufacturer->ip_uncertainty_msecs;
+    tunnelTagInfo.intra_pulse_jitter_msecs                  = tagManufacturer->ip_jitter_msecs;
+    tunnelTagInfo.k                                         = _customSettings->k()->rawValue().toUInt();
+    tunnelTagInfo.false_alarm_probability                   = _customSettings->falseAlarmProbability()->rawValue().toDouble() / 100.0;
+    tunnelTagInfo.channelizer_channel_number                = tagRecord.channelizer_channel_number;
+    tunnelTagInfo.channelizer_channel_center_frequency_hz   = tagRecord.channelizer_channel_center_frequency_hz;
+    tunnelTagInfo.ip1_mu                                    = qQNaN();
+    tunnelTagInfo.ip1_sigma                                 = qQNaN();
+    tunnelTagInfo.ip2_mu                                    = qQNaN();
+    tunnelTagInfo.ip2_sigma                                 = qQNaN();
+
+    _sendTunnelCommand((uint8_t*)&tunnelTagInfo, sizeof(tunnelTagInfo), true /* pipelined */);
+}
+
+void TagTrackerSession::_sendEndTags(void)
+{
+    EndTagsInfo_t endTagsInfo;
+
+    endTagsInfo.header.command = COMMAND_ID_END_TAGS;
+    _sendTunnelCommand((uint8_t*)&endTagsInfo, sizeof(endTagsInfo));
+}
+
+void TagTrackerSession::_sendCommandAndVerify(Vehicle* vehicle, MAV_CMD command, double param1, double param2, double param3, double param4, double param5, double param6, double param7)
+{
+    connect(vehicle, &Vehicle::mavCommandResult, this, &TagTrackerSession::_mavCommandResult);
+    vehicle->sendMavCommand(MAV_COMP_ID_AUTOPILOT1,
+                            command,
+                            false /* showError */,
+                            static_cast<float>(param1),
+                            static_cast<float>(param2),
+                            static_cast<float>(param3),
+                            static_cast<float>(param4),
+                            static_cast<float>(param5),
+                            static_cast<float>(param6),
+                            static_cast<float>(param7));
+}
+
+void TagTrackerSession::_mavCommandResult(int vehicleId, int component, int command, int result, bool noResponseFromVehicle)
+{
+    Q_UNUSED(vehicleId);
+    Q_UNUSED(component);
+
+    Vehicle* vehicle = dynamic_cast<Vehicle*>(sender());
+    if (!vehicle) {
+        qWarning() << "Vehicle dynamic cast failed!";
+        return;
+    }
+
+    if (!_flightStateMachineActive) {
+        disconnect(vehicle, &Vehicle::mavCommandResult, this, &TagTrackerSession::_mavCommandResult);
+        return;
+    }
+
+    const VehicleState_t& currentState = _vehicleStates[_vehicleStateIndex];
+
+    if (currentState.command == CommandTakeoff && command == MAV_CMD_NAV_TAKEOFF) {
+        disconnect(vehicle, &Vehicle::mavCommandResult, this, &TagTrackerSession::_mavCommandResult);
+        if (noResponseFromVehicle) {
+            _say(QStringLiteral("Vehicle did not respond to takeoff command"));
+            _updateFlightMachineActive(false);
+        } else if (result != MAV_RESULT_ACCEPTED) {
+            _say(QStringLiteral("takeoff command failed"));
+            _updateFlightMachineActive(false);
+        }
+    } else if ((currentState.command == CommandSetHeading || currentState.command == CommandYawAtRate) && command == (vehicle->px4Firmware() ? MAV_CMD_DO_REPOSITION : MAV_CMD_CONDITION_YAW)) {
+        disconnect(vehicle, &Vehicle::mavCommandResult, this, &TagTrackerSession::_mavCommandResult);
+        if (noResponseFromVehicle) {
+            if (_retryRotation) {
+                _retryRotation = false;
+                _say(QStringLiteral("Vehicle did not response to Rotate command. Retrying."));
+                _rotateVehicle(vehicle, currentState.targetValue, currentState.yawRate);
+            } else {
+                _say(QStringLiteral("Vehicle did not respond to Rotate command. Flight cancelled. Vehicle returning."));
+                _resetStateAndRTL();
+            }
+        } else if (result != MAV_RESULT_ACCEPTED) {
+            _say(QStringLiteral("Rotate command failed. Flight cancelled. Vehicle returning."));
+            _resetStateAndRTL();
+        }
+    }
+}
+
+void TagTrackerSession::_takeoff(Vehicle* vehicle, double takeoffAltRel)
+{
+    double vehicleAltitudeAMSL = vehicle->altitudeAMSL()->rawValue().toDouble();
+    if (qIsNaN(vehicleAltitudeAMSL)) {
+        qgcApp()->informationMessageBoxOnMainThread(tr("Error"), tr("Unable to takeoff, vehicle position not known."));
+        return;
+    }
+
+    double takeoffAltAMSL = takeoffAltRel + vehicleAltitudeAMSL;
+
+    _sendCommandAndVerify(
+                vehicle,
+                MAV_CMD_NAV_TAKEOFF,
+                -1,                             // No pitch requested
+                0, 0,                           // param 2-4 unused
+                qQNaN(), qQNaN(), qQNaN(),      // No yaw, lat, lon
+                takeoffAltAMSL);                // AMSL altitude
+}
+
+void TagTrackerSession::_rotateVehicle(Vehicle* vehicle, double headingDegrees, double yawRate)
+{
+    // DO_REPOSITION has no yaw rate, PX4 always yaws at its auto yaw rate
+    if (vehicle->px4Firmware()) {
+        _sendCommandAndVerify(
+            vehicle,
+            MAV_CMD_DO_REPOSITION,
+            -1,                                     // no change in ground speed
+            MAV_DO_REPOSITION_FLAGS_CHANGE_MODE,    // switch to guided mode
+            0,                                      // reserved
+            qDegreesToRadians(headingDegrees),      // change heading
+            qQNaN(), qQNaN(), qQNaN());             // no change lat, lon, alt
+    } else if (vehicle->apmFirmware()){
+        _sendCommandAndVerify(
+            vehicle,
+            MAV_CMD_CONDITION_YAW,
+            headingDegrees,
+            yawRate,                                // Angular speed, 0 for default
+            1,                                      // Rotate clockwise
+            0,                                      // heading specified as absolute angle
+            0, 0, 0);                               // Unused
+    }
+}
+
+void TagTrackerSession::_setupDelayForSteadyCapture(void)
+{
+    _detectorInfoListModel.resetMaxStrength();
+    _detectorInfoListModel.resetPulseGroupCount();
+    _sliceDwellTimer.start();
+}
+
+void TagTrackerSession::_advanceStateMachine(void)
+{
+    Vehicle* vehicle = _vehicle();
+
+    if (!vehicle) {
+        return;
+    }
+
+    // Clear previous state
+    if (_vehicleStateIndex > 0) {
+        const VehicleState_t& previousState = _vehicleStates[_vehicleStateIndex];
+
+        if (previousState.targetValueWaitMsecs) {
+            _vehicleStateTimeoutTimer.stop();
+            if (previousState.fact) {
+                disconnect(previousState.fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+            }
+        }
+
+        _retryRotation = false;
+    }
+
+    if (_vehicleStateIndex == _vehicleStates.count() - 1) {
+        // State machine complete
+        _say(QStringLiteral("Collection complete."));
+        qCDebug(TagTrackerSessionLog) << "Rotation complete: vehicle:adaptive dwell saved(ms)" << _vehicleId << _rotationDwellSavedMsecs;
+        _updateFlightMachineActive(false);
+        _stopRotationPulseLog(true /* calcBearing*/);
+        return;
+    }
+
+    const VehicleState_t& currentState = _vehicleStates[++_vehicleStateIndex];
+
+    QString holdFlightMode(vehicle->px4Firmware() ? "Hold" : "Guided");
+    if (currentState.command != CommandTakeoff && vehicle->flightMode() != "Takeoff" && vehicle->flightMode() != holdFlightMode) {
+        // User cancel
+        _say(QStringLiteral("Collection cancelled."));
+        _updateFlightMachineActive(false);
+        _stopRotationPulseLog(false /* calcBearing*/);
+        return;
+    }
+
+    switch (currentState.command) {
+    case CommandTakeoff:
+        // Takeoff to specified altitude
+        _say(QStringLiteral("Waiting for takeoff to %1 %2.").arg(FactMetaData::metersToAppSettingsVerticalDistanceUnits(currentState.targetValue).toDouble()).arg(FactMetaData::appSettingsVerticalDistanceUnitsString()));
+        _takeoff(vehicle, currentState.targetValue);
+        break;
+    case CommandSetHeading:
+        _say(QStringLiteral("Waiting for rotate to %1 degrees.").arg(qRound(currentState.targetValue)));
+        _retryRotation = true;
+        _rotateVehicle(vehicle, currentState.targetValue);
+        break;
+    case CommandYawAtRate:
+        if (_vehicleStates[_vehicleStateIndex - 1].command != CommandYawAtRate) {
+            _say(QStringLiteral("Rotating at %1 degrees per second.").arg(currentState.yawRate));
+        }
+        _retryRotation = true;
+        _rotateVehicle(vehicle, currentState.targetValue, currentState.yawRate);
+        break;
+    case CommandWaitForHeartbeats:
+        _say(QStringLiteral("Collecting data for %1 seconds max").arg(currentState.targetValueWaitMsecs / 1000));
+        _setupDelayForSteadyCapture();
+        break;
+    }
+
+    if (currentState.targetValueWaitMsecs) {
+        _vehicleStateTimeoutTimer.setInterval(currentState.targetValueWaitMsecs);
+        _vehicleStateTimeoutTimer.start();
+        if (currentState.fact) {
+            connect(currentState.fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+            currentState.fact->rawValueChanged(currentState.fact->rawValue());
+        }
+    }
+}
+
+// This will advance the state machine if the value reaches the target value
+void TagTrackerSession::_vehicleStateRawValueChanged(QVariant rawValue)
+{
+    Fact* fact = dynamic_cast<Fact*>(sender());
+    if (!fact) {
+        qCritical() << "Fact dynamic cast failed!";
+        return;
+    }
+
+    if (!_flightStateMachineActive) {
+        disconnect(fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+    }
+
+    const VehicleState_t& currentState = _vehicleStates[_vehicleStateIndex];
+
+    //qCDebug(TagTrackerSessionLog) << "Waiting for value actual:wait:variance" << rawValue.toDouble() << currentState.targetValue << currentState.targetVariance;
+
+    double difference = qAbs(rawValue.toDouble() - currentState.targetValue);
+    if (currentState.command == CommandSetHeading || currentState.command == CommandYawAtRate) {
+        // Headings wrap at 360
+        difference = qMin(difference, 360.0 - difference);
+    }
+
+    if (difference <= currentState.targetVariance) {
+        // Target value reached
+        disconnect(fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+        _advanceStateMachine();
+    }
+}
+
+void TagTrackerSession::_say(const QString& text)
+{
+    // With more than one tracker flying the operator needs to know which vehicle is talking
+    if (_customPlugin->sessionCount() > 1) {
+        _customPlugin->say(QStringLiteral("Vehicle %1. %2").arg(_vehicleId).arg(text));
+    } else {
+        _customPlugin->say(text);
+    }
+}
+
+void TagTrackerSession::_rotationDelayComplete(void)
+{
+    double maxStrength = _detectorInfoListModel.maxStrength();
+    qCDebug(TagTrackerSessionLog) << "_rotationDelayComplete: vehicle:max snr" << _vehicleId << maxStrength;
+
+    qint64 fullDwellMsecs   = _vehicleStates[_vehicleStateIndex].targetValueWaitMsecs;
+    qint64 dwellMsecs       = std::min(_sliceDwellTimer.elapsed(), fullDwellMsecs);
+    _rotationDwellSavedMsecs += fullDwellMsecs - dwellMsecs;
+    qCDebug(TagTrackerSessionLog) << "_rotationDelayComplete: slice:dwell(ms):full dwell(ms):saved(ms):rotation saved(ms)"
+                             << _currentSlice
+                             << dwellMsecs
+                             << fullDwellMsecs
+                             << fullDwellMsecs - dwellMsecs
+                             << _rotationDwellSavedMsecs;
+    _rgAngleStrengths.last()[_currentSlice] = maxStrength;
+    _updateAngleRatios();
+
+    // Update the bearing estimate with this slice
+    Vehicle* vehicle = _vehicle();
+    if (vehicle) {
+        double antennaHeading = vehicle->heading()->rawValue().toDouble() + _customSettings->antennaOffset()->rawValue().toDouble();
+        _rgCalcedBearings.last() = _bearingEstimator.completeSlice(fmod(antennaHeading, 360.0));
+        qCDebug(TagTrackerSessionLog) << "Calculated bearing: vehicle:bearing" << _vehicleId << _rgCalcedBearings.last();
+        emit calcedBearingsChanged();
+
+        // Keep the position fix live as the bearing for this rotation firms up
+        _customPlugin->triangulator()->setBearing(_rgTriangulationIds.last(), _rgCalcedBearings.last());
+    }
+
+    // Advance to next slice
+    if (++_currentSlice >= _cSlice) {
+        _currentSlice = 0;
+    }
+
+    _advanceStateMachine();
+}
+
+void TagTrackerSession::_updateAngleRatios(void)
+{
+    // Adjust the angle ratios to the latest angle strengths
+    double maxStrength = 0;
+    for (int i=0; i<_cSlice; i++) {
+        if (_rgAngleStrengths.last()[i] > maxStrength) {
+            maxStrength = _rgAngleStrengths.last()[i];
+        }
+    }
+    for (int i=0; i<_cSlice; i++) {
+        double angleStrength = _rgAngleStrengths.last()[i];
+        if (!qIsNaN(angleStrength)) {
+            _rgAngleRatios.last()[i] = _rgAngleStrengths.last()[i] / maxStrength;
+        }
+    }
+    emit angleRatiosChanged();
+}
+
+void TagTrackerSession::_vehicleStateTimeout(void)
+{
+    if (_vehicleStates[_vehicleStateIndex].command == CommandWaitForHeartbeats) {
+        _rotationDelayComplete();
+        return;
+    } else {
+        _say("Failed to reach target.");
+    }
+    cancelAndReturn();
+}
+
+bool TagTrackerSession::_armVehicleAndValidate(Vehicle* vehicle)
+{
+    if (vehicle->armed()) {
+        return true;
+    }
+
+    bool armedChanged = false;
+
+    // We try arming 3 times
+    for (int retries=0; retries<3; retries++) {
+        vehicle->setArmed(true, false /* showError */);
+
+        // Wait for vehicle to return armed state
+        for (int i=0; i<10; i++) {
+            if (vehicle->armed()) {
+                armedChanged = true;
+                break;
+            }
+            QGC::SLEEP::msleep(100);
+            qgcApp()->processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+        if (armedChanged) {
+            break;
+        }
+    }
+
+    if (!armedChanged) {
+        _say("Vehicle failed to arm");
+    }
+
+    return armedChanged;
+}
+
+bool TagTrackerSession::_setRTLFlightModeAndValidate(Vehicle* vehicle)
+{
+    QString rtlFlightMode = vehicle->rtlFlightMode();
+
+    if (vehicle->flightMode() == rtlFlightMode) {
+        return true;
+    }
+
+    bool flightModeChanged = false;
+
+    // We try 3 times
+    for (int retries=0; retries<3; retries++) {
+        vehicle->setFlightMode(rtlFlightMode);
+
+        // Wait for vehicle to return flight mode
+        for (int i=0; i<10; i++) {
+            if (vehicle->flightMode() == rtlFlightMode) {
+                flightModeChanged = true;
+                break;
+            }
+            QGC::SLEEP::msleep(100);
+            qgcApp()->processEvents(QEventLoop::ExcludeUserInputEvents);
+        }
+        if (flightModeChanged) {
+            break;
+        }
+    }
+
+    if (!flightModeChanged) {
+        _say("Vehicle failed to respond to Return command");
+    }
+
+    return flightModeChanged;
+}
+
+void TagTrackerSession::_resetStateAndRTL(void)
+{
+    qCDebug(TagTrackerSessionLog) << "_resetStateAndRTL" << _vehicleId;
+    _vehicleStateTimeoutTimer.stop();
+
+    Vehicle* vehicle = _vehicle();
+    if (vehicle) {
+        disconnect(vehicle, &Vehicle::mavCommandResult, this, &TagTrackerSession::_mavCommandResult);
+    }
+
+    for (const VehicleState_t& vehicleState: _vehicleStates) {
+        if (vehicleState.fact) {
+            disconnect(vehicleState.fact, &Fact::rawValueChanged, this, &TagTrackerSession::_vehicleStateRawValueChanged);
+        }
+    }
+
+#if 0
+    _setRTLFlightModeAndValidate(vehicle);
+#endif
+
+    _updateFlightMachineActive(false);
+
+    _stopFullPulseLog();
+    _stopRotationPulseLog(false /* calcBearing*/);
+}
+
+void TagTrackerSession::_tunnelCommandFailed(uint32_t /*sequenceId*/, uint32_t command)
+{
+    QString message = QStringLiteral("%1 failed. no response from vehicle.").arg(CustomPlugin::tunnelCommandIdToText(command));
+
+    _say(message);
+    qgcApp()->showAppMessage(message);
+}
+
+void TagTrackerSession::_sendTunnelCommand(uint8_t* payload, size_t payloadSize, bool pipelined)
+{
+    if (!_vehicle()) {
+        qCDebug(TagTrackerSessionLog) << "_sendTunnelCommand called with vehicle no longer available" << _vehicleId;
+        return;
+    }
+
+    _tunnelCommandQueue.enqueue(QByteArray(reinterpret_cast<const char*>(payload), static_cast<int>(payloadSize)), pipelined);
+}
+
+bool TagTrackerSession::_transmitTunnelPayload(const QByteArray& payload)
+{
+    Vehicle* vehicle = _vehicle();
+    if (!vehicle) {
+        return false;
+    }
+
+    WeakLinkInterfacePtr    weakPrimaryLink     = vehicle->vehicleLinkManager()->primaryLink();
+
+    if (weakPrimaryLink.expired()) {
+        return false;
+    }
+
+    SharedLinkInterfacePtr  sharedLink  = weakPrimaryLink.lock();
+    MAVLinkProtocol*        mavlink     = qgcApp()->toolbox()->mavlinkProtocol();
+    mavlink_message_t       msg;
+    mavlink_tunnel_t        tunnel;
+
+    memset(&tunnel, 0, sizeof(tunnel));
+
+    memcpy(tunnel.payload, payload.constData(), payload.size());
+
+    tunnel.target_system    = vehicle->id();
+    tunnel.target_component = MAV_COMP_ID_ONBOARD_COMPUTER;
+    tunnel.payload_type     = MAV_TUNNEL_PAYLOAD_TYPE_UNKNOWN;
+    tunnel.payload_length   = payload.size();
+
+    mavlink_msg_tunnel_encode_chan(
+                static_cast<uint8_t>(mavlink->getSystemId()),
+                static_cast<uint8_t>(mavlink->getComponentId()),
+                sharedLink->mavlinkChannel(),
+                &msg,
+                &tunnel);
+
+    vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), msg);
+
+    return true;
+}
+
+void TagTrackerSession::_controllerHeartbeatFailed()
+{
+    _controllerLostHeartbeat = true;
+    emit controllerLostHeartbeatChanged();
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "QmlObjectListModel.h"
+#include "FactSystem.h"
+#include "TunnelProtocol.h"
+#include "DetectorInfoListModel.h"
+#include "PulseLog.h"
+#include "PulseIngest.h"
+#include "PulseHistory.h"
+#include "PipelineTelemetry.h"
+#include "BearingEstimator.h"
+#include "TunnelCommandQueue.h"
+#include "QGCLoggingCategory.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+Q_DECLARE_LOGGING_CATEGORY(TagTrackerSessionLog)
+
+class CustomPlugin;
+class CustomSettings;
+class TagDatabase;
+struct TagRecord_t;
+class Vehicle;
+
+/// All of the tag tracking state for a single vehicle: rotation state machine, pulse logs, detector models and
+/// controller heartbeat. Sessions are keyed by vehicle id and tunnel traffic is routed to them by message sysid which
+/// allows multiple trackers to be flown at the same time.
+class TagTrackerSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    TagTrackerSession(int vehicleId, CustomPlugin* customPlugin);
+    ~TagTrackerSession();
+
+    Q_PROPERTY(int                  vehicleId               MEMBER  _vehicleId                  CONSTANT)
+    Q_PROPERTY(QList<QList<double>> angleRatios             MEMBER  _rgAngleRatios              NOTIFY angleRatiosChanged)
+    Q_PROPERTY(QList<double>        calcedBearings          MEMBER  _rgCalcedBearings           NOTIFY calcedBearingsChanged)
+    Q_PROPERTY(bool                 flightMachineActive     MEMBER  _flightStateMachineActive   NOTIFY flightMachineActiveChanged)
+    Q_PROPERTY(bool                 controllerLostHeartbeat MEMBER  _controllerLostHeartbeat    NOTIFY controllerLostHeartbeatChanged)
+    Q_PROPERTY(int                  controllerStatus        MEMBER  _controllerStatus           NOTIFY controllerStatusChanged)
+    Q_PROPERTY(float                controllerCPUTemp       MEMBER  _controllerCPUTemp          NOTIFY controllerCPUTempChanged)
+    Q_PROPERTY(QmlObjectListModel*  detectorInfoList        READ    detectorInfoList            CONSTANT)
+    Q_PROPERTY(PulseHistory*        pulseHistory            READ    pulseHistory                CONSTANT)
+    Q_PROPERTY(PipelineTelemetry*   pipelineTelemetry       READ    pipelineTelemetry           CONSTANT)
+
+    int                 vehicleId       () const { return _vehicleId; }
+    QmlObjectListModel* detectorInfoList() { return dynamic_cast<QmlObjectListModel*>(&_detectorInfoListModel); }
+    PulseHistory*       pulseHistory    () { return &_pulseHistory; }
+    PipelineTelemetry*  pipelineTelemetry() { return &_pipelineTelemetry; }
+
+    Q_INVOKABLE void startRotation      (void);
+    Q_INVOKABLE void cancelAndReturn    (void);
+    Q_INVOKABLE void sendTags           (void);
+    Q_INVOKABLE void startDetection     (void);
+    Q_INVOKABLE void stopDetection      (void);
+    Q_INVOKABLE void rawCapture         (void);
+
+    /// Writes the pipeline telemetry to a csv file in the log save directory
+    Q_INVOKABLE void exportTelemetry    (void);
+
+    /// Called with all tunnel messages from this session's vehicle
+    void handleTunnel   (const mavlink_tunnel_t& tunnel);
+
+    /// Called when the vehicle goes away. Any rotation in progress is cancelled and logs are closed. Rotation results
+    /// are kept so they remain visible on the map.
+    void vehicleRemoved (void);
+
+signals:
+    void angleRatiosChanged             (void);
+    void calcedBearingsChanged          (void);
+    void flightMachineActiveChanged     (bool flightMachineActive);
+    void controllerLostHeartbeatChanged ();
+    void controllerStatusChanged        ();
+    void controllerCPUTempChanged       ();
+
+    /// Emitted after each batch of pulses from the ingest thread has been handled
+    void pulsesProcessed                (int pulseCount);
+
+private slots:
+    void _vehicleStateRawValueChanged   (QVariant rawValue);
+    void _advanceStateMachine           (void);
+    void _vehicleStateTimeout           (void);
+    void _updateFlightMachineActive     (bool flightMachineActive);
+    void _mavCommandResult              (int vehicleId, int component, int command, int result, bool noResponseFromVehicle);
+    void _tunnelCommandAcked            (uint32_t sequenceId, uint32_t command, uint32_t result, qint64 latencyMsecs);
+    void _tunnelCommandFailed           (uint32_t sequenceId, uint32_t command);
+    void _controllerHeartbeatFailed     (void);
+    void _handlePulses                  (const PulseInfoPtrList& pulses, const QList<qint64>& arrivalMsecs);
+
+private:
+    typedef enum {
+        CommandTakeoff,
+        CommandSetHeading,
+        CommandWaitForHeartbeats,
+        CommandYawAtRate,           // Continuous rotation segment, pulses are binned by heading while yawing
+    } VehicleStateCommand_t;
+
+    typedef struct VehicleState_t {
+        VehicleStateCommand_t   command;
+        Fact*                   fact;
+        int                     targetValueWaitMsecs;
+        double                  targetValue;
+        double                  targetVariance;
+        double                  yawRate;            // deg/s, 0 for vehicle default
+    } VehicleState_t;
+
+    Vehicle* _vehicle                   (void);
+    void    _handleTunnelCommandAck     (const mavlink_tunnel_t& tunnel);
+    void    _handlePulse                (const TunnelProtocol::PulseInfo_t& pulseInfo);
+    void    _handleTunnelHeartbeat      (const mavlink_tunnel_t& tunnel);
+    void    _rotateVehicle              (Vehicle* vehicle, double headingDegrees, double yawRate = 0.0);
+    void    _say                        (const QString& text);
+    bool    _armVehicleAndValidate      (Vehicle* vehicle);
+    bool    _setRTLFlightModeAndValidate(Vehicle* vehicle);
+    void    _sendCommandAndVerify       (Vehicle* vehicle, MAV_CMD command, double param1 = 0.0, double param2 = 0.0, double param3 = 0.0, double param4 = 0.0, double param5 = 0.0, double param6 = 0.0, double param7 = 0.0);
+    void    _takeoff                    (Vehicle* vehicle, double takeoffAltRel);
+    void    _resetStateAndRTL           (void);
+    void    _sendTunnelCommand          (uint8_t* payload, size_t payloadSize, bool pipelined = false);
+    bool    _transmitTunnelPayload      (const QByteArray& payload);
+    void    _sendTag                    (const TagRecord_t& tagRecord);
+    void    _sendEndTags                (void);
+    void    _setupDelayForSteadyCapture (void);
+    void    _rotationDelayComplete      (void);
+    void    _startFullPulseLog          (void);
+    void    _stopFullPulseLog           (void);
+    void    _startRotationPulseLog      (int rotationCount);
+    void    _stopRotationPulseLog       (bool calcBearing);
+    void    _logRotationStartStop       (PulseLogWriter& pulseLog, bool startRotation);
+    void    _csvBearingCrossCheck       (const QString& pulseLogFileName);
+    bool    _collectingRotationSlice    (void);
+    bool    _collectingContinuousRotation(void);
+    void    _buildContinuousRotationStates(Vehicle* vehicle, double startHeading);
+    void    _addContinuousRotationPulse (const TunnelProtocol::PulseInfo_t& pulseInfo);
+    void    _updateAngleRatios          (void);
+    void    _checkAdaptiveDwellComplete (void);
+    bool    _useSNRForPulseStrength     (void);
+
+    int                     _vehicleId;
+    CustomPlugin*           _customPlugin;
+    CustomSettings*         _customSettings;
+    TagDatabase*            _tagDatabase;
+
+    int                     _vehicleStateIndex          = 0;
+    QList<VehicleState_t>   _vehicleStates;
+    QList<QList<double>>    _rgAngleStrengths;
+    QList<QList<double>>    _rgAngleRatios;
+    QList<double>           _rgCalcedBearings;
+    QList<int>              _rgTriangulationIds;
+    bool                    _flightStateMachineActive   = false;
+    int                     _currentSlice               = 0;
+    int                     _cSlice                     = 0;
+    bool                    _retryRotation              = false;
+    int                     _controllerStatus;
+    float                   _controllerCPUTemp          = 0.0;
+
+    QTimer                  _vehicleStateTimeoutTimer;
+    QElapsedTimer           _sliceDwellTimer;
+    qint64                  _rotationDwellSavedMsecs    = 0;
+    TunnelCommandQueue      _tunnelCommandQueue;
+    QElapsedTimer           _sendTagsTimer;
+    PulseLogWriter          _fullPulseLog;
+    PulseLogWriter          _rotationPulseLog;
+    int                     _rotationCount              = 1;
+    BearingEstimator        _bearingEstimator;
+
+    DetectorInfoListModel   _detectorInfoListModel;
+    PulseIngest             _pulseIngest;
+    PulseHistory            _pulseHistory;
+    PipelineTelemetry       _pipelineTelemetry;
+
+    bool                    _controllerLostHeartbeat    = true;
+    QTimer                  _controllerHeartbeatTimer;
+    uint32_t                _controllerHeartbeatCounter = 0;
+};
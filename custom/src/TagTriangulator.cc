@@ -0,0 +1,164 @@
+#include "TagTriangulator.h"
+
+#include <QtMath>
+
+QGC_LOGGING_CATEGORY(TagTriangulatorLog, "TagTriangulatorLog")
+
+static constexpr double _minIntersectionAngleDegrees    = 2.0;
+static constexpr int    _cEllipsePathPoints             = 36;
+
+TagTriangulator::TagTriangulator(QObject* parent)
+    : QObject(parent)
+{
+
+}
+
+int TagTriangulator::addRotation(const QGeoCoordinate& rotationCenter)
+{
+    if (!_origin.isValid()) {
+        _origin = rotationCenter;
+    }
+
+    double distance = _origin.distanceTo(rotationCenter);
+    double azimuth  = qDegreesToRadians(_origin.azimuthTo(rotationCenter));
+
+    Rotation_t rotation;
+    rotation.east           = distance * qSin(azimuth);
+    rotation.north          = distance * qCos(azimuth);
+    rotation.normalEast     = qQNaN();
+    rotation.normalNorth    = qQNaN();
+    rotation.weight         = 0;
+    _rotations.append(rotation);
+
+    return _rotations.count() - 1;
+}
+
+void TagTriangulator::setBearing(int rotationId, double bearingDegrees, double weight)
+{
+    if (rotationId < 0 || rotationId >= _rotations.count()) {
+        qCWarning(TagTriangulatorLog) << "setBearing: invalid rotation id" << rotationId;
+        return;
+    }
+
+    Rotation_t& rotation = _rotations[rotationId];
+
+    // Back out the previous bearing for this rotation
+    if (!qIsNaN(rotation.normalEast)) {
+        _accumulate(rotation, -1);
+        _cBearings--;
+        rotation.normalEast     = qQNaN();
+        rotation.normalNorth    = qQNaN();
+    }
+
+    if (!qIsNaN(bearingDegrees) && weight > 0) {
+        // Bearing line direction is (sin, cos) in east/north, the normal is perpendicular to that
+        double bearingRadians   = qDegreesToRadians(bearingDegrees);
+        rotation.normalEast     = qCos(bearingRadians);
+        rotation.normalNorth    = -qSin(bearingRadians);
+        rotation.weight         = weight;
+        _accumulate(rotation, 1);
+        _cBearings++;
+    }
+
+    _solve();
+}
+
+void TagTriangulator::_accumulate(const Rotation_t& rotation, double sign)
+{
+    double w    = sign * rotation.weight;
+    double ne   = rotation.normalEast;
+    double nn   = rotation.normalNorth;
+    double c    = (ne * rotation.east) + (nn * rotation.north);
+
+    _sumWNeNe   += w * ne * ne;
+    _sumWNeNn   += w * ne * nn;
+    _sumWNnNn   += w * nn * nn;
+    _sumWNeC    += w * ne * c;
+    _sumWNnC    += w * nn * c;
+    _sumWCC     += w * c * c;
+
+    _sumW       += w;
+    _sumWE      += w * rotation.east;
+    _sumWN      += w * rotation.north;
+    _sumWPP     += w * ((rotation.east * rotation.east) + (rotation.north * rotation.north));
+}
+
+void TagTriangulator::_solve(void)
+{
+    _valid              = false;
+    _estimate           = QGeoCoordinate();
+    _semiMajorMeters    = qQNaN();
+    _semiMinorMeters    = qQNaN();
+    _orientationDegrees = qQNaN();
+
+    double det   = (_sumWNeNe * _sumWNnNn) - (_sumWNeNn * _sumWNeNn);
+    double trace = _sumWNeNe + _sumWNnNn;
+
+    // For two unit weight lines det / trace^2 is sin^2(angle between lines) / 4. Nearly parallel lines give no fix.
+    double minAngleSin = qSin(qDegreesToRadians(_minIntersectionAngleDegrees));
+    if (_cBearings < 2 || det <= (minAngleSin * minAngleSin / 4.0) * trace * trace) {
+        emit estimateChanged();
+        return;
+    }
+
+    double east  = ((_sumWNnNn * _sumWNeC) - (_sumWNeNn * _sumWNnC)) / det;
+    double north = ((_sumWNeNe * _sumWNnC) - (_sumWNeNn * _sumWNeC)) / det;
+
+    // Weighted sum of squared perpendicular distances from the lines to the estimate
+    double residual = qMax(0.0, _sumWCC - (east * _sumWNeC) - (north * _sumWNnC));
+
+    // Weighted mean squared range from the rotation centers to the estimate
+    double meanSqRange = ((east * east) + (north * north)) - (2.0 * ((east * _sumWE) + (north * _sumWN)) / _sumW) + (_sumWPP / _sumW);
+    meanSqRange = qMax(0.0, meanSqRange);
+
+    double bearingSigmaRadians  = qDegreesToRadians(bearingSigmaDegrees);
+    double variance             = bearingSigmaRadians * bearingSigmaRadians * meanSqRange;
+    if (_cBearings > 2) {
+        variance = qMax(variance, residual / (_cBearings - 2));
+    }
+
+    // Covariance = variance * inverse(A)
+    double covEE = variance *  _sumWNnNn / det;
+    double covNN = variance *  _sumWNeNe / det;
+    double covEN = variance * -_sumWNeNn / det;
+
+    double halfTrace    = (covEE + covNN) / 2.0;
+    double spread       = qSqrt((((covEE - covNN) / 2.0) * ((covEE - covNN) / 2.0)) + (covEN * covEN));
+    double majorAngle   = 0.5 * qAtan2(2.0 * covEN, covEE - covNN);  // From east towards north
+
+    _semiMajorMeters    = confidenceScale * qSqrt(halfTrace + spread);
+    _semiMinorMeters    = confidenceScale * qSqrt(qMax(0.0, halfTrace - spread));
+    _orientationDegrees = fmod(90.0 - qRadiansToDegrees(majorAngle) + 360.0, 180.0);
+
+    double distance = qSqrt((east * east) + (north * north));
+    _estimate       = _origin.atDistanceAndAzimuth(distance, qRadiansToDegrees(qAtan2(east, north)));
+    _valid          = true;
+
+    qCDebug(TagTriangulatorLog) << "estimate:bearings:semiMajor:semiMinor:orientation" << _estimate << _cBearings << _semiMajorMeters << _semiMinorMeters << _orientationDegrees;
+
+    emit estimateChanged();
+}
+
+QVariantList TagTriangulator::ellipsePath(void) const
+{
+    QVariantList path;
+
+    if (!_valid) {
+        return path;
+    }
+
+    double orientationRadians = qDegreesToRadians(_orientationDegrees);
+    for (int i=0; i<_cEllipsePathPoints; i++) {
+        double t        = (2.0 * M_PI * i) / _cEllipsePathPoints;
+        double major    = _semiMajorMeters * qCos(t);
+        double minor    = _semiMinorMeters * qSin(t);
+
+        // Rotate from ellipse axes into east/north. The major axis is at the orientation azimuth.
+        double east     = (major * qSin(orientationRadians)) + (minor * qCos(orientationRadians));
+        double north    = (major * qCos(orientationRadians)) - (minor * qSin(orientationRadians));
+
+        path.append(QVariant::fromValue(_estimate.atDistanceAndAzimuth(qSqrt((east * east) + (north * north)), qRadiansToDegrees(qAtan2(east, north)))));
+    }
+
+    return path;
+}
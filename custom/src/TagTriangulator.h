@@ -0,0 +1,99 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+
+#include <QObject>
+#include <QGeoCoordinate>
+#include <QVariantList>
+#include <QVector>
+
+Q_DECLARE_LOGGING_CATEGORY(TagTriangulatorLog)
+
+/// Combines rotation bearings from all vehicles into a tag position estimate.
+///
+/// Each rotation contributes a bearing line from its rotation center. The estimate is the weighted least squares
+/// intersection of those lines in a local tangent plane centered on the first rotation. Only the 2x2 normal equations
+/// are accumulated so adding, updating or removing a bearing is constant time no matter how many rotations have been
+/// flown. This allows the bearing of a rotation to be updated live as each slice completes.
+///
+/// The covariance is the inverse of the normal matrix scaled by the larger of the a posteriori variance of the
+/// residuals and the a priori variance expected from the bearing accuracy at the mean range to the tag.
+class TagTriangulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    TagTriangulator(QObject* parent = nullptr);
+
+    Q_PROPERTY(bool             valid               READ valid              NOTIFY estimateChanged)
+    Q_PROPERTY(QGeoCoordinate   estimate            READ estimate           NOTIFY estimateChanged)
+    Q_PROPERTY(double           semiMajorMeters     READ semiMajorMeters    NOTIFY estimateChanged)
+    Q_PROPERTY(double           semiMinorMeters     READ semiMinorMeters    NOTIFY estimateChanged)
+    Q_PROPERTY(double           orientationDegrees  READ orientationDegrees NOTIFY estimateChanged)
+    Q_PROPERTY(QVariantList     ellipsePath         READ ellipsePath        NOTIFY estimateChanged)
+    Q_PROPERTY(int              bearingCount        READ bearingCount       NOTIFY estimateChanged)
+
+    /// Registers a new rotation
+    ///     @param rotationCenter Vehicle position at the start of the rotation
+    /// @return Id used to set the bearing for the rotation
+    int     addRotation     (const QGeoCoordinate& rotationCenter);
+
+    /// Sets or replaces the bearing for a rotation
+    ///     @param rotationId       Id from addRotation
+    ///     @param bearingDegrees   Bearing to the tag from true north, NaN removes the rotation from the estimate
+    ///     @param weight           Relative confidence in the bearing
+    void    setBearing      (int rotationId, double bearingDegrees, double weight = 1.0);
+
+    bool            valid               (void) const { return _valid; }
+    QGeoCoordinate  estimate            (void) const { return _estimate; }
+    double          semiMajorMeters     (void) const { return _semiMajorMeters; }
+    double          semiMinorMeters     (void) const { return _semiMinorMeters; }
+    double          orientationDegrees  (void) const { return _orientationDegrees; }
+    QVariantList    ellipsePath         (void) const;
+    int             bearingCount        (void) const { return _cBearings; }
+
+    /// Standard deviation of a rotation bearing used for the a priori variance
+    static constexpr double bearingSigmaDegrees = 10.0;
+
+    /// Scale from one sigma to a 95% confidence ellipse for two degrees of freedom: sqrt(chi2inv(0.95, 2))
+    static constexpr double confidenceScale = 2.4477;
+
+signals:
+    void estimateChanged(void);
+
+private:
+    typedef struct {
+        double  east;       ///< Rotation center in meters from the origin
+        double  north;
+        double  normalEast; ///< Unit normal to the bearing line, NaN if no bearing
+        double  normalNorth;
+        double  weight;
+    } Rotation_t;
+
+    void _accumulate    (const Rotation_t& rotation, double sign);
+    void _solve         (void);
+
+    QGeoCoordinate      _origin;
+    QVector<Rotation_t> _rotations;
+    int                 _cBearings  = 0;
+
+    // Normal equation sums: A = sum(w n n'), b = sum(w n c), c = n'p
+    double  _sumWNeNe   = 0;
+    double  _sumWNeNn   = 0;
+    double  _sumWNnNn   = 0;
+    double  _sumWNeC    = 0;
+    double  _sumWNnC    = 0;
+    double  _sumWCC     = 0;
+
+    // Sums used for the mean squared range from the rotation centers to the estimate
+    double  _sumW       = 0;
+    double  _sumWE      = 0;
+    double  _sumWN      = 0;
+    double  _sumWPP     = 0;
+
+    bool            _valid              = false;
+    QGeoCoordinate  _estimate;
+    double          _semiMajorMeters    = qQNaN();
+    double          _semiMinorMeters    = qQNaN();
+    double          _orientationDegrees = qQNaN();
+};
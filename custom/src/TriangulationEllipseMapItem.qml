@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick          2.3
+import QtLocation       5.15
+
+import QGroundControl   1.0
+
+/// 95% confidence ellipse for the triangulated tag position
+MapPolygon {
+    path:           _triangulator.ellipsePath
+    visible:        _triangulator.valid
+    color:          Qt.rgba(1, 0, 0, 0.15)
+    border.color:   "red"
+    border.width:   2
+    z:              QGroundControl.zOrderWidgets - 2
+
+    property var customMapObject
+
+    property var _triangulator: customMapObject.triangulator
+}
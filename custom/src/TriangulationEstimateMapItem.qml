@@ -0,0 +1,54 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick          2.3
+import QtLocation       5.15
+
+import QGroundControl               1.0
+import QGroundControl.ScreenTools   1.0
+import QGroundControl.Controls      1.0
+
+/// Triangulated tag position along with the size of the confidence ellipse
+MapQuickItem {
+    coordinate:     _triangulator.estimate
+    visible:        _triangulator.valid
+    anchorPoint.x:  estimateIndicator.width / 2
+    anchorPoint.y:  estimateIndicator.height / 2
+    z:              QGroundControl.zOrderWidgets - 1
+
+    property var customMapObject
+
+    property var    _triangulator:      customMapObject.triangulator
+    property real   _indicatorRadius:   Math.ceil(ScreenTools.defaultFontPixelHeight / 2)
+
+    sourceItem: Item {
+        width:  estimateIndicator.width
+        height: estimateIndicator.height
+
+        Rectangle {
+            id:             estimateIndicator
+            width:          _indicatorRadius * 2
+            height:         width
+            radius:         _indicatorRadius
+            color:          "red"
+            border.color:   "white"
+            border.width:   2
+        }
+
+        QGCLabel {
+            anchors.left:           estimateIndicator.right
+            anchors.leftMargin:     2
+            anchors.verticalCenter: estimateIndicator.verticalCenter
+            text:                   qsTr("%1 x %2 m").arg(_triangulator.semiMajorMeters.toFixed(0)).arg(_triangulator.semiMinorMeters.toFixed(0))
+            color:                  "white"
+            style:                  Text.Outline
+            styleColor:             "black"
+        }
+    }
+}
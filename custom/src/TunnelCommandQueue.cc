@@ -0,0 +1,218 @@
+#include "TunnelCommandQueue.h"
+#include "TunnelProtocol.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+using namespace TunnelProtocol;
+
+QGC_LOGGING_CATEGORY(TunnelCommandQueueLog, "TunnelCommandQueueLog")
+
+TunnelCommandQueue::TunnelCommandQueue(SendFunction sendFunction, QObject* parent)
+    : QObject       (parent)
+    , _sendFunction (sendFunction)
+{
+    _clock.start();
+    _timeoutTimer.setSingleShot(true);
+    connect(&_timeoutTimer, &QTimer::timeout, this, &TunnelCommandQueue::_checkTimeouts);
+    _sendTimer.setSingleShot(true);
+    connect(&_sendTimer, &QTimer::timeout, this, &TunnelCommandQueue::_sendPending);
+}
+
+uint32_t TunnelCommandQueue::enqueue(const QByteArray& payload, bool pipelined)
+{
+    HeaderInfo_t header;
+    memcpy(&header, payload.constData(), sizeof(header));
+
+    Command_t command;
+    command.sequenceId      = _nextSequenceId++;
+    command.command         = header.command;
+    command.pipelined       = pipelined;
+    command.payload         = payload;
+    command.retries         = 0;
+    command.firstSendMsecs  = 0;
+    command.lastSendMsecs   = 0;
+    _pending.append(command);
+
+    _sendPending();
+
+    return command.sequenceId;
+}
+
+bool TunnelCommandQueue::handleAck(uint32_t command, uint32_t result)
+{
+    for (int i=0; i<_inFlight.count(); i++) {
+        if (_inFlight[i].command == command) {
+            Command_t   ackedCommand    = _inFlight.takeAt(i);
+            qint64      now             = _clock.elapsed();
+            qint64      latencyMsecs    = now - ackedCommand.firstSendMsecs;
+
+            // Karn's algorithm: a retransmitted command can't tell which send the ack belongs to
+            if (ackedCommand.retries == 0) {
+                _updateRtt(now - ackedCommand.lastSendMsecs);
+            }
+
+            _lastAckMsecs[command] = now;
+
+            CommandStats_t& stats = _stats[command];
+            stats.ackCount++;
+            stats.minLatencyMsecs   = stats.ackCount == 1 ? latencyMsecs : std::min(stats.minLatencyMsecs, latencyMsecs);
+            stats.maxLatencyMsecs   = std::max(stats.maxLatencyMsecs, latencyMsecs);
+            stats.meanLatencyMsecs  += (latencyMsecs - stats.meanLatencyMsecs) / stats.ackCount;
+
+            qCDebug(TunnelCommandQueueLog) << "Ack - sequence:command:result:latency:retries" << ackedCommand.sequenceId << command << result << latencyMsecs << ackedCommand.retries;
+
+            emit commandAcked(ackedCommand.sequenceId, command, result, latencyMsecs);
+
+            _sendPending();
+            _scheduleTimeout();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TunnelCommandQueue::clear(void)
+{
+    _pending.clear();
+    _inFlight.clear();
+    _timeoutTimer.stop();
+    _sendTimer.stop();
+}
+
+TunnelCommandQueue::CommandStats_t TunnelCommandQueue::stats(uint32_t command) const
+{
+    return _stats.value(command, CommandStats_t{ 0, 0, 0, 0, 0, 0 });
+}
+
+qint64 TunnelCommandQueue::retransmitTimeout(void) const
+{
+    if (!_haveRtt) {
+        return _maxTimeoutMsecs;
+    }
+    return qBound(static_cast<qint64>(_minTimeoutMsecs), static_cast<qint64>(qCeil(_srttMsecs + (4 * _rttVarMsecs))), static_cast<qint64>(_maxTimeoutMsecs));
+}
+
+void TunnelCommandQueue::_sendPending(void)
+{
+    while (!_pending.isEmpty()) {
+        // Nothing goes out behind a barrier which is still waiting for its ack
+        if (!_inFlight.isEmpty() && !_inFlight.last().pipelined) {
+            break;
+        }
+        // A barrier waits for everything ahead of it
+        if (!_inFlight.isEmpty() && !_pending.first().pipelined) {
+            break;
+        }
+        // An ack can only be matched to a command unambiguously if it is the only one in flight with its id
+        if (_inFlightCommand(_pending.first().command)) {
+            break;
+        }
+        auto minSendInterval = _minSendIntervalMsecs.constFind(_pending.first().command);
+        auto lastAck = _lastAckMsecs.constFind(_pending.first().command);
+        if (minSendInterval != _minSendIntervalMsecs.constEnd() && lastAck != _lastAckMsecs.constEnd()) {
+            qint64 waitMsecs = lastAck.value() + minSendInterval.value() - _clock.elapsed();
+            if (waitMsecs > 0) {
+                _sendTimer.start(static_cast<int>(waitMsecs));
+                break;
+            }
+        }
+
+        Command_t command = _pending.takeFirst();
+        command.firstSendMsecs = _clock.elapsed();
+        _transmit(command);
+        _inFlight.append(command);
+    }
+
+    _scheduleTimeout();
+}
+
+bool TunnelCommandQueue::_inFlightCommand(uint32_t command) const
+{
+    for (const Command_t& inFlightCommand: _inFlight) {
+        if (inFlightCommand.command == command) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TunnelCommandQueue::_transmit(Command_t& command)
+{
+    command.lastSendMsecs = _clock.elapsed();
+
+    qCDebug(TunnelCommandQueueLog) << "Send - sequence:command:retries" << command.sequenceId << command.command << command.retries;
+
+    if (!_sendFunction(command.payload)) {
+        // No link, the retransmit timeout takes care of trying again
+        qCDebug(TunnelCommandQueueLog) << "Send failed, no link - sequence" << command.sequenceId;
+    }
+}
+
+void TunnelCommandQueue::_checkTimeouts(void)
+{
+    qint64  now         = _clock.elapsed();
+    qint64  timeout     = retransmitTimeout();
+    bool    timedOut    = false;
+
+    for (int i=0; i<_inFlight.count(); i++) {
+        if (now - _inFlight[i].lastSendMsecs < timeout) {
+            continue;
+        }
+
+        if (_inFlight[i].retries >= _maxRetries) {
+            uint32_t sequenceId     = _inFlight[i].sequenceId;
+            uint32_t commandId      = _inFlight[i].command;
+
+            qCWarning(TunnelCommandQueueLog) << "No ack after retries - sequence:command" << sequenceId << commandId;
+            _stats[commandId].failedCount++;
+
+            clear();
+            emit commandFailed(sequenceId, commandId);
+            return;
+        }
+
+        timedOut = true;
+
+        Command_t& command = _inFlight[i];
+        command.retries++;
+        _stats[command.command].retransmitCount++;
+        _transmit(command);
+    }
+
+    if (timedOut && _haveRtt) {
+        // Back off so a slow link doesn't get flooded with retransmits
+        _srttMsecs = std::min(_srttMsecs * 2, static_cast<double>(_maxTimeoutMsecs));
+    }
+
+    _scheduleTimeout();
+}
+
+void TunnelCommandQueue::_scheduleTimeout(void)
+{
+    if (_inFlight.isEmpty()) {
+        _timeoutTimer.stop();
+        return;
+    }
+
+    qint64 oldestSend = _inFlight.first().lastSendMsecs;
+    for (const Command_t& command: _inFlight) {
+        oldestSend = std::min(oldestSend, command.lastSendMsecs);
+    }
+
+    _timeoutTimer.start(static_cast<int>(std::max(static_cast<qint64>(0), oldestSend + retransmitTimeout() - _clock.elapsed())));
+}
+
+void TunnelCommandQueue::_updateRtt(qint64 rttMsecs)
+{
+    if (!_haveRtt) {
+        _srttMsecs      = rttMsecs;
+        _rttVarMsecs    = rttMsecs / 2.0;
+        _haveRtt        = true;
+    } else {
+        _rttVarMsecs    = (0.75 * _rttVarMsecs) + (0.25 * qAbs(_srttMsecs - rttMsecs));
+        _srttMsecs      = (0.875 * _srttMsecs) + (0.125 * rttMsecs);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "QGCLoggingCategory.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QTimer>
+
+#include <functional>
+
+Q_DECLARE_LOGGING_CATEGORY(TunnelCommandQueueLog)
+
+/// Retransmitting command transport on top of TUNNEL messages.
+///
+/// Acks on the wire only carry the command id, not a sequence id, so commands with the same id can't be pipelined:
+/// only one command with a given id is ever in flight and the next one waits for its ack. That way an ack always
+/// belongs to exactly one command and a retransmit can never duplicate a command the controller already has. The
+/// sequence ids handed out by enqueue are local only, they identify the command in the commandAcked and commandFailed
+/// signals. Commands which time out are retransmitted on their own, with a timeout which adapts to the measured round
+/// trip time.
+///
+/// Commands which change controller state such as start/end tags are barriers: they are only sent once everything
+/// ahead of them has been acked and nothing behind them is sent until they are acked. Non-barrier commands between
+/// barriers are sent in order, and only overlap with in flight commands which have a different id.
+class TunnelCommandQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Sends a raw tunnel payload to the vehicle. Returns false if there is no link to send on.
+    typedef std::function<bool(const QByteArray& payload)> SendFunction;
+
+    TunnelCommandQueue(SendFunction sendFunction, QObject* parent = nullptr);
+
+    typedef struct {
+        uint32_t    ackCount;
+        uint32_t    retransmitCount;
+        uint32_t    failedCount;
+        qint64      minLatencyMsecs;
+        qint64      maxLatencyMsecs;
+        double      meanLatencyMsecs;
+    } CommandStats_t;
+
+    /// Queues a command for sending
+    ///     @param payload      Tunnel payload, must start with a TunnelProtocol::HeaderInfo_t
+    ///     @param pipelined    true: command can be in flight along with commands with other ids, false: command is a barrier
+    /// @return Sequence id for the command
+    uint32_t enqueue(const QByteArray& payload, bool pipelined = false);
+
+    /// Matches an ack from the vehicle against the commands in flight
+    /// @return false if no command with this id is waiting for an ack
+    bool handleAck(uint32_t command, uint32_t result);
+
+    /// Drops all queued and in flight commands
+    void clear(void);
+
+    bool            idle                (void) const { return _pending.isEmpty() && _inFlight.isEmpty(); }
+    int             inFlightCount       (void) const { return _inFlight.count(); }
+    CommandStats_t  stats               (uint32_t command) const;
+    qint64          retransmitTimeout   (void) const;
+
+    void setMaxRetries      (int maxRetries)                            { _maxRetries = maxRetries; }
+    void setAckTimeoutRange (int minTimeoutMsecs, int maxTimeoutMsecs)  { _minTimeoutMsecs = minTimeoutMsecs; _maxTimeoutMsecs = maxTimeoutMsecs; }
+
+    /// Gives the controller at least intervalMsecs after acking a command before the next one with the same id is sent
+    void setMinSendInterval (uint32_t command, int intervalMsecs)       { _minSendIntervalMsecs[command] = intervalMsecs; }
+
+    static constexpr int defaultMaxRetries      = 3;
+    static constexpr int defaultMinTimeoutMsecs = 500;
+    static constexpr int defaultMaxTimeoutMsecs = 2000;
+
+signals:
+    /// An ack was received for the command. The result is the raw ack result from the vehicle.
+    void commandAcked   (uint32_t sequenceId, uint32_t command, uint32_t result, qint64 latencyMsecs);
+
+    /// No ack was received after all retries. All other queued commands are dropped since the controller state is unknown.
+    void commandFailed  (uint32_t sequenceId, uint32_t command);
+
+private:
+    typedef struct {
+        uint32_t    sequenceId;
+        uint32_t    command;
+        bool        pipelined;
+        QByteArray  payload;
+        int         retries;
+        qint64      firstSendMsecs;
+        qint64      lastSendMsecs;
+    } Command_t;
+
+    void _sendPending       (void);
+    bool _inFlightCommand   (uint32_t command) const;
+    void _transmit          (Command_t& command);
+    void _checkTimeouts     (void);
+    void _scheduleTimeout   (void);
+    void _updateRtt         (qint64 rttMsecs);
+
+    SendFunction            _sendFunction;
+    QList<Command_t>        _pending;
+    QList<Command_t>        _inFlight;
+    uint32_t                _nextSequenceId     = 1;
+    QElapsedTimer           _clock;
+    QTimer                  _timeoutTimer;
+    QTimer                  _sendTimer;                 ///< Holds off a command until its minimum send interval is up
+
+    int                     _maxRetries         = defaultMaxRetries;
+    int                     _minTimeoutMsecs    = defaultMinTimeoutMsecs;
+    int                     _maxTimeoutMsecs    = defaultMaxTimeoutMsecs;
+
+    // Smoothed round trip time and variance used for the retransmit timeout, same approach as TCP (RFC 6298)
+    double                  _srttMsecs          = 0;
+    double                  _rttVarMsecs        = 0;
+    bool                    _haveRtt            = false;
+
+    QMap<uint32_t, CommandStats_t> _stats;                  ///< Keyed by command id
+    QMap<uint32_t, int>             _minSendIntervalMsecs;  ///< Keyed by command id
+    QMap<uint32_t, qint64>          _lastAckMsecs;          ///< Keyed by command id
+};
@@ -0,0 +1,169 @@
+#include "BearingEstimatorTest.h"
+#include "BearingEstimator.h"
+
+#include <QtMath>
+
+using namespace TunnelProtocol;
+
+static PulseInfo_t _pulse(double snr)
+{
+    PulseInfo_t pulseInfo;
+
+    memset(&pulseInfo, 0, sizeof(pulseInfo));
+    pulseInfo.frequency_hz  = 146000000;
+    pulseInfo.snr           = snr;
+
+    return pulseInfo;
+}
+
+static PulseInfo_t _orientedPulse(double w, double x, double y, double z)
+{
+    PulseInfo_t pulseInfo = _pulse(10);
+
+    pulseInfo.orientation_w = w;
+    pulseInfo.orientation_x = x;
+    pulseInfo.orientation_y = y;
+    pulseInfo.orientation_z = z;
+
+    return pulseInfo;
+}
+
+/// Runs a rotation with one slice per heading
+static void _rotate(BearingEstimator& estimator, double startHeading, double stepDegrees, const QList<double>& sliceSNRs)
+{
+    for (int i=0; i<sliceSNRs.count(); i++) {
+        estimator.addPulse(_pulse(sliceSNRs[i]));
+        estimator.completeSlice(startHeading + (i * stepDegrees));
+    }
+}
+
+void BearingEstimatorTest::_singlePeak_test(void)
+{
+    BearingEstimator estimator;
+
+    // A single slice has nothing to compare against
+    estimator.addPulse(_pulse(5));
+    QVERIFY(qIsNaN(estimator.completeSlice(0)));
+
+    // Strongest at 90 with equal shoulders either side
+    estimator.reset();
+    _rotate(estimator, 0, 45, { 0, 10, 20, 10, 0, 0, 0, 0 });
+    QCOMPARE(estimator.sliceCount(), 8);
+    QVERIFY(qAbs(estimator.bearing() - 90.0) < 0.001);
+
+    // Weaker pulses within a slice don't lower the slice power
+    estimator.reset();
+    estimator.addPulse(_pulse(0));
+    estimator.completeSlice(0);
+    estimator.addPulse(_pulse(20));
+    estimator.addPulse(_pulse(3));
+    QVERIFY(qAbs(estimator.completeSlice(180) - 180.0) < 0.001);
+}
+
+void BearingEstimatorTest::_wrap_test(void)
+{
+    BearingEstimator estimator;
+
+    // Rotation starts at 290 so the two strongest slices, 350 and 20, straddle north
+    _rotate(estimator, 290, 30, { 0, 0, 20, 20, 0, 0, 0, 0, 0, 0, 0, 0 });
+    QVERIFY(qAbs(estimator.bearing() - 5.0) < 0.001);
+
+    // Strongest slice exactly at north, bearing must be reported close to 0 or 360 and never negative
+    estimator.reset();
+    _rotate(estimator, 315, 45, { 10, 20, 10, 0, 0, 0, 0, 0 });
+    double bearing = estimator.bearing();
+    QVERIFY(bearing >= 0 && bearing < 360);
+    QVERIFY(qMin(bearing, 360.0 - bearing) < 0.001);
+}
+
+void BearingEstimatorTest::_equalSlices_test(void)
+{
+    BearingEstimator estimator;
+
+    _rotate(estimator, 0, 45, { 12, 12, 12, 12, 12, 12, 12, 12 });
+    QCOMPARE(estimator.sliceCount(), 8);
+    QVERIFY(qIsNaN(estimator.bearing()));
+
+    // Slices without any pulses are equally uninformative
+    estimator.reset();
+    for (int i=0; i<4; i++) {
+        QVERIFY(qIsNaN(estimator.completeSlice(i * 90)));
+    }
+}
+
+void BearingEstimatorTest::_binned_test(void)
+{
+    BearingEstimator estimator;
+
+    estimator.resetBinned(8);
+    QCOMPARE(estimator.binCount(), 8);
+    QCOMPARE(estimator.binForHeading(0), 0);
+    QCOMPARE(estimator.binForHeading(22), 0);
+    QCOMPARE(estimator.binForHeading(23), 1);
+    QCOMPARE(estimator.binForHeading(350), 0);
+    QCOMPARE(estimator.binForHeading(-10), 0);
+    QCOMPARE(estimator.binForHeading(-90), 6);
+    QCOMPARE(estimator.binForHeading(720 + 90), 2);
+    for (int i=0; i<estimator.binCount(); i++) {
+        QVERIFY(qIsNaN(estimator.binMaxSNR(i)));
+    }
+
+    // One filled bin is not enough for a bearing
+    QCOMPARE(estimator.addBinnedPulse(_pulse(20), 88), 2);
+    QVERIFY(qIsNaN(estimator.bearing()));
+
+    // The other bins are still empty and must not count as the weakest bin, otherwise the weaker pulse at 180 would
+    // pull the bearing towards it
+    QCOMPARE(estimator.addBinnedPulse(_pulse(10), 181), 4);
+    QVERIFY(qAbs(estimator.bearing() - 90.0) < 0.001);
+    QVERIFY(qIsNaN(estimator.binMaxSNR(0)));
+    QCOMPARE(estimator.binMaxSNR(2), 20.0);
+
+    // Weaker pulse in a filled bin leaves the bin and the estimate alone
+    QCOMPARE(estimator.addBinnedPulse(_pulse(5), 92), 2);
+    QCOMPARE(estimator.binMaxSNR(2), 20.0);
+    QVERIFY(qAbs(estimator.bearing() - 90.0) < 0.001);
+
+    // A new weakest bin at 0 shifts the estimate towards the stronger bin at 180
+    estimator.addBinnedPulse(_pulse(0), 0);
+    QVERIFY(estimator.bearing() > 90.0 && estimator.bearing() < 180.0);
+
+    // A full rotation with fewer pulses than bins leaves gaps which must not drag the estimate
+    estimator.resetBinned(72);
+    for (int i=0; i<50; i++) {
+        double heading = (360.0 * i) / 50;
+        estimator.addBinnedPulse(_pulse(20.0 + (10.0 * qCos(qDegreesToRadians(heading - 90.0)))), heading);
+    }
+    QVERIFY(qIsNaN(estimator.binMaxSNR(2)));
+    QVERIFY(qAbs(estimator.bearing() - 90.0) < 2.0);
+
+    // Back to a slice based rotation
+    estimator.reset();
+    QCOMPARE(estimator.binCount(), 0);
+    QCOMPARE(estimator.sliceCount(), 0);
+}
+
+void BearingEstimatorTest::_headingFromOrientation_test(void)
+{
+    const double halfRoot2 = qSqrt(2.0) / 2.0;
+
+    // No attitude information
+    QVERIFY(qIsNaN(BearingEstimator::headingFromOrientation(_orientedPulse(0, 0, 0, 0))));
+
+    QVERIFY(qAbs(BearingEstimator::headingFromOrientation(_orientedPulse(1, 0, 0, 0))) < 0.001);
+    QVERIFY(qAbs(BearingEstimator::headingFromOrientation(_orientedPulse(halfRoot2, 0, 0, halfRoot2)) - 90.0) < 0.001);
+    QVERIFY(qAbs(BearingEstimator::headingFromOrientation(_orientedPulse(0, 0, 0, 1)) - 180.0) < 0.001);
+
+    // Negative yaw is reported in [0, 360)
+    QVERIFY(qAbs(BearingEstimator::headingFromOrientation(_orientedPulse(halfRoot2, 0, 0, -halfRoot2)) - 270.0) < 0.001);
+
+    // Yaw 90 with 30 degrees of roll, heading is unaffected by roll
+    const double halfRoll = qDegreesToRadians(30.0) / 2.0;
+    double w = halfRoot2 * qCos(halfRoll);
+    double x = halfRoot2 * qSin(halfRoll);
+    double y = halfRoot2 * qSin(halfRoll);
+    double z = halfRoot2 * qCos(halfRoll);
+    QVERIFY(qAbs(BearingEstimator::headingFromOrientation(_orientedPulse(w, x, y, z)) - 90.0) < 0.001);
+}
+
+UT_REGISTER_TEST(BearingEstimatorTest)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for BearingEstimator
+class BearingEstimatorTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _singlePeak_test               (void);
+    void _wrap_test                     (void);
+    void _equalSlices_test              (void);
+    void _binned_test                   (void);
+    void _headingFromOrientation_test   (void);
+};
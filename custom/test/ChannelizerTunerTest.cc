@@ -0,0 +1,114 @@
+#include "ChannelizerTunerTest.h"
+#include "ChannelizerTuner.h"
+
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+
+static constexpr uint32_t _sampleRateHz = 375000;
+static constexpr uint32_t _nChannels    = 100;
+
+void ChannelizerTunerTest::_singleFrequency_test(void)
+{
+    ChannelizerTuner            tuner(_sampleRateHz, _nChannels);
+    ChannelizerTuner::Result_t  result;
+
+    QVERIFY(tuner.tune({ 146000000 }, 100, false /* multiThreaded */, result));
+    QCOMPARE(result.centerHz, 146000000u);
+    QCOMPARE(result.averageDistanceFromCenterHz, 0u);
+    QCOMPARE(result.oneBasedChannels, QVector<uint32_t>({ 1 }));
+    QCOMPARE(result.channelCentersHz[0], 146000000u);
+}
+
+void ChannelizerTunerTest::_tooWideSpread_test(void)
+{
+    ChannelizerTuner            tuner(_sampleRateHz, _nChannels);
+    ChannelizerTuner::Result_t  result;
+
+    QVERIFY(!tuner.tune({ 146000000, 146000000 + _sampleRateHz + 1 }, 100, false /* multiThreaded */, result));
+    QVERIFY(!tuner.bruteForceTune({ 146000000, 146000000 + _sampleRateHz + 1 }, 100, result));
+}
+
+void ChannelizerTunerTest::_duplicateFrequency_test(void)
+{
+    ChannelizerTuner            tuner(_sampleRateHz, _nChannels);
+    ChannelizerTuner::Result_t  result;
+
+    // Two tags in the same channel can never be separated
+    QVERIFY(!tuner.tune({ 146000000, 146000000 }, 100, false /* multiThreaded */, result));
+    QVERIFY(!tuner.bruteForceTune({ 146000000, 146000000 }, 100, result));
+}
+
+void ChannelizerTunerTest::_randomizedVsBruteForce_test(void)
+{
+    ChannelizerTuner    tuner(_sampleRateHz, _nChannels);
+    QRandomGenerator    random(1234);
+
+    for (int iteration=0; iteration<500; iteration++) {
+        int                 cFreqs      = random.bounded(1, 9);
+        uint32_t            baseHz      = 146000000 + random.bounded(4000000);
+        uint32_t            spreadHz    = random.bounded(1u, _sampleRateHz + 25000);
+        uint32_t            stepSizeHz  = iteration % 2 ? 100 : random.bounded(1, 300);
+        QVector<uint32_t>   freqsHz;
+
+        for (int i=0; i<cFreqs; i++) {
+            freqsHz.append(baseHz + random.bounded(spreadHz));
+        }
+
+        ChannelizerTuner::Result_t referenceResult;
+        ChannelizerTuner::Result_t singleThreadResult;
+        ChannelizerTuner::Result_t multiThreadResult;
+
+        bool referenceSuccess   = tuner.bruteForceTune(freqsHz, stepSizeHz, referenceResult);
+        bool singleThreadSuccess= tuner.tune(freqsHz, stepSizeHz, false /* multiThreaded */, singleThreadResult);
+        bool multiThreadSuccess = tuner.tune(freqsHz, stepSizeHz, true /* multiThreaded */, multiThreadResult);
+
+        QCOMPARE(singleThreadSuccess, referenceSuccess);
+        QCOMPARE(multiThreadSuccess, referenceSuccess);
+        if (referenceSuccess) {
+            QCOMPARE(singleThreadResult.centerHz,                       referenceResult.centerHz);
+            QCOMPARE(singleThreadResult.averageDistanceFromCenterHz,    referenceResult.averageDistanceFromCenterHz);
+            QCOMPARE(singleThreadResult.oneBasedChannels,               referenceResult.oneBasedChannels);
+            QCOMPARE(singleThreadResult.channelCentersHz,               referenceResult.channelCentersHz);
+            QCOMPARE(multiThreadResult.centerHz,                        referenceResult.centerHz);
+            QCOMPARE(multiThreadResult.oneBasedChannels,                referenceResult.oneBasedChannels);
+        }
+    }
+}
+
+void ChannelizerTunerBenchmark::_benchmark(void)
+{
+    ChannelizerTuner    tuner(_sampleRateHz, _nChannels);
+    QRandomGenerator    random(5678);
+    QVector<uint32_t>   freqsHz;
+
+    // Wide tag spread, which is the worst case for the number of candidate centers
+    for (int i=0; i<20; i++) {
+        freqsHz.append(146000000 + random.bounded(_sampleRateHz - 10000));
+    }
+
+    for (uint32_t stepSizeHz: { 100u, 10u, 1u }) {
+        ChannelizerTuner::Result_t  result;
+        QElapsedTimer               timer;
+
+        timer.start();
+        tuner.bruteForceTune(freqsHz, stepSizeHz, result);
+        qint64 bruteForceNsecs = timer.nsecsElapsed();
+
+        timer.restart();
+        tuner.tune(freqsHz, stepSizeHz, false /* multiThreaded */, result);
+        qint64 singleThreadNsecs = timer.nsecsElapsed();
+
+        timer.restart();
+        tuner.tune(freqsHz, stepSizeHz, true /* multiThreaded */, result);
+        qint64 multiThreadNsecs = timer.nsecsElapsed();
+
+        qDebug() << "ChannelizerTuner step(Hz):bruteForce(ms):singleThread(ms):multiThread(ms)"
+                 << stepSizeHz
+                 << bruteForceNsecs / 1.0e6
+                 << singleThreadNsecs / 1.0e6
+                 << multiThreadNsecs / 1.0e6;
+    }
+}
+
+UT_REGISTER_TEST(ChannelizerTunerTest)
+UT_REGISTER_TEST_STANDALONE(ChannelizerTunerBenchmark)
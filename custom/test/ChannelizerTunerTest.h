@@ -0,0 +1,24 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Regression and benchmark tests for ChannelizerTuner
+class ChannelizerTunerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _singleFrequency_test      (void);
+    void _tooWideSpread_test        (void);
+    void _duplicateFrequency_test   (void);
+    void _randomizedVsBruteForce_test(void);
+};
+
+/// Run with --unittest:ChannelizerTunerBenchmark
+class ChannelizerTunerBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _benchmark(void);
+};
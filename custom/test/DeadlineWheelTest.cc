@@ -0,0 +1,103 @@
+#include "DeadlineWheelTest.h"
+#include "DeadlineWheel.h"
+
+#include <algorithm>
+
+void DeadlineWheelTest::_expire_test(void)
+{
+    DeadlineWheel wheel(100, 16);
+
+    wheel.reset(3);
+    QVERIFY(wheel.isEmpty());
+
+    wheel.setDeadline(0, 250);
+    wheel.setDeadline(1, 500);
+    QVERIFY(!wheel.isEmpty());
+
+    QVERIFY(wheel.advance(200).isEmpty());
+    QCOMPARE(wheel.advance(300), QVector<int>({ 0 }));
+    QVERIFY(!wheel.hasDeadline(0));
+    QVERIFY(wheel.hasDeadline(1));
+
+    QCOMPARE(wheel.advance(500), QVector<int>({ 1 }));
+    QVERIFY(wheel.isEmpty());
+    QVERIFY(wheel.advance(1000).isEmpty());
+}
+
+void DeadlineWheelTest::_pushBack_test(void)
+{
+    DeadlineWheel wheel(100, 16);
+
+    wheel.reset(1);
+
+    // Keep pushing the deadline back like a steady heartbeat would, it must never expire
+    for (qint64 now=0; now<5000; now+=100) {
+        wheel.setDeadline(0, now + 300);
+        QVERIFY(wheel.advance(now).isEmpty());
+    }
+
+    // Heartbeats stop
+    QVERIFY(wheel.advance(5100).isEmpty());
+    QCOMPARE(wheel.advance(5200), QVector<int>({ 0 }));
+    QVERIFY(wheel.isEmpty());
+}
+
+void DeadlineWheelTest::_pullForward_test(void)
+{
+    DeadlineWheel wheel(100, 16);
+
+    wheel.reset(1);
+    wheel.setDeadline(0, 1000);
+    wheel.setDeadline(0, 300);
+
+    QCOMPARE(wheel.advance(300), QVector<int>({ 0 }));
+
+    // The entry left behind in the later slot is stale
+    QVERIFY(wheel.advance(1000).isEmpty());
+}
+
+void DeadlineWheelTest::_clear_test(void)
+{
+    DeadlineWheel wheel(100, 16);
+
+    wheel.reset(2);
+    wheel.setDeadline(0, 200);
+    wheel.setDeadline(1, 200);
+    wheel.clearDeadline(0);
+
+    QVERIFY(!wheel.hasDeadline(0));
+    QCOMPARE(wheel.advance(200), QVector<int>({ 1 }));
+    QVERIFY(wheel.isEmpty());
+}
+
+void DeadlineWheelTest::_longDeadline_test(void)
+{
+    DeadlineWheel wheel(100, 8);
+
+    wheel.reset(1);
+
+    // Several turns of the wheel away
+    wheel.setDeadline(0, 3050);
+
+    for (qint64 now=100; now<3000; now+=100) {
+        QVERIFY(wheel.advance(now).isEmpty());
+    }
+    QCOMPARE(wheel.advance(3100), QVector<int>({ 0 }));
+}
+
+void DeadlineWheelTest::_gap_test(void)
+{
+    DeadlineWheel wheel(100, 8);
+
+    wheel.reset(2);
+    wheel.setDeadline(0, 200);
+    wheel.setDeadline(1, 5000);
+
+    // A stalled event loop skips many turns of the wheel, everything due must still expire in one call
+    QVector<int> expired = wheel.advance(10000);
+    std::sort(expired.begin(), expired.end());
+    QCOMPARE(expired, QVector<int>({ 0, 1 }));
+    QVERIFY(wheel.isEmpty());
+}
+
+UT_REGISTER_TEST(DeadlineWheelTest)
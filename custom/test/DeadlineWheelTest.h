@@ -0,0 +1,17 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for DeadlineWheel
+class DeadlineWheelTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _expire_test       (void);
+    void _pushBack_test     (void);
+    void _pullForward_test  (void);
+    void _clear_test        (void);
+    void _longDeadline_test (void);
+    void _gap_test          (void);
+};
@@ -0,0 +1,167 @@
+#include "PipelineTelemetryTest.h"
+#include "PipelineTelemetry.h"
+
+#include <QTemporaryDir>
+#include <QFile>
+
+using namespace TunnelProtocol;
+
+static PulseInfo_t _pulse(uint32_t tagId, double startTimeSeconds, uint32_t groupSeqCounter)
+{
+    PulseInfo_t pulseInfo;
+
+    memset(&pulseInfo, 0, sizeof(pulseInfo));
+    pulseInfo.tag_id                = tagId;
+    pulseInfo.frequency_hz          = 146000000;
+    pulseInfo.start_time_seconds    = startTimeSeconds;
+    pulseInfo.group_seq_counter     = groupSeqCounter;
+    pulseInfo.confirmed_status      = 1;
+
+    return pulseInfo;
+}
+
+void PipelineTelemetryTest::_histogram_test(void)
+{
+    QCOMPARE(LatencyHistogram::bucketForMsecs(-5), 0);
+    QCOMPARE(LatencyHistogram::bucketForMsecs(0), 0);
+    QCOMPARE(LatencyHistogram::bucketForMsecs(1), 1);
+    QCOMPARE(LatencyHistogram::bucketForMsecs(3), 2);
+    QCOMPARE(LatencyHistogram::bucketForMsecs(4), 3);
+    QCOMPARE(LatencyHistogram::bucketForMsecs(1000000), LatencyHistogram::bucketCount - 1);
+
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.percentile(50), static_cast<qint64>(0));
+
+    // 90 fast pulses and 10 slow ones
+    for (int i=0; i<90; i++) {
+        histogram.add(10);
+    }
+    for (int i=0; i<10; i++) {
+        histogram.add(300);
+    }
+    QCOMPARE(histogram.count(), static_cast<qint64>(100));
+    QCOMPARE(histogram.minMsecs(), static_cast<qint64>(10));
+    QCOMPARE(histogram.maxMsecs(), static_cast<qint64>(300));
+    QCOMPARE(histogram.meanMsecs(), 39.0);
+    QCOMPARE(histogram.percentile(50), static_cast<qint64>(16));
+    QCOMPARE(histogram.percentile(90), static_cast<qint64>(16));
+    QCOMPARE(histogram.percentile(99), static_cast<qint64>(300));
+
+    histogram.clear();
+    QCOMPARE(histogram.count(), static_cast<qint64>(0));
+    QCOMPARE(histogram.bucket(LatencyHistogram::bucketForMsecs(10)), 0u);
+}
+
+void PipelineTelemetryTest::_heartbeat_test(void)
+{
+    PipelineTelemetry telemetry;
+
+    // Controller heartbeats every 5 seconds, one late
+    qint64 msecs = 0;
+    for (int i=0; i<10; i++) {
+        msecs += i == 5 ? 7000 : 5000;
+        telemetry.recordControllerHeartbeat(msecs, 50);
+    }
+    QCOMPARE(telemetry.controllerHeartbeats().count(), static_cast<qint64>(10));
+    QCOMPARE(telemetry.controllerHeartbeats().maxMsecs(), static_cast<qint64>(7000));
+    QVERIFY(telemetry.controllerHeartbeats().meanMsecs() > 5000);
+    QVERIFY(telemetry.controllerHeartbeats().jitterMsecs() > 0);
+
+    // Detector heartbeats come in as pulses with no frequency and don't count as pulses
+    PulseInfo_t heartbeat = _pulse(2, 0, 0);
+    heartbeat.frequency_hz = 0;
+    for (int i=0; i<5; i++) {
+        telemetry.recordPulseReceived(heartbeat, i * 1000);
+    }
+    const PipelineTelemetry::DetectorTelemetry_t* detector = telemetry.detector(2);
+    QVERIFY(detector);
+    QCOMPARE(detector->heartbeats.count(), static_cast<qint64>(5));
+    QCOMPARE(detector->heartbeats.meanMsecs(), 1000.0);
+    QCOMPARE(detector->heartbeats.jitterMsecs(), 0.0);
+    QCOMPARE(detector->receivedAge.count(), static_cast<qint64>(0));
+}
+
+void PipelineTelemetryTest::_groupSeqGap_test(void)
+{
+    PipelineTelemetry telemetry;
+
+    // Pulses in the same group share a counter, groups 3 and 4 are lost, then the detector restarts.
+    // They arrive 250ms after their start time and are processed 150ms later.
+    const uint32_t groupSeqCounters[] = { 1, 1, 1, 2, 2, 5, 5, 0, 1 };
+    PulseInfoPtrList    pulses;
+    QList<qint64>       arrivalMsecs;
+    for (uint32_t groupSeqCounter: groupSeqCounters) {
+        pulses.append(PulseInfoPtr::create(_pulse(4, 100.0, groupSeqCounter)));
+        arrivalMsecs.append(100250);
+    }
+    telemetry.recordPulsesProcessed(pulses, arrivalMsecs, 100400);
+
+    const PipelineTelemetry::DetectorTelemetry_t* detector = telemetry.detector(4);
+    QVERIFY(detector);
+    QCOMPARE(detector->groupSeqGaps, static_cast<qint64>(1));
+    QCOMPARE(detector->droppedGroups, static_cast<qint64>(2));
+    QCOMPARE(detector->groupSeqResets, static_cast<qint64>(1));
+    QCOMPARE(detector->receivedAge.count(), static_cast<qint64>(9));
+    QCOMPARE(detector->receivedAge.maxMsecs(), static_cast<qint64>(250));
+    QCOMPARE(detector->processedAge.count(), static_cast<qint64>(9));
+    QCOMPARE(detector->processedAge.maxMsecs(), static_cast<qint64>(400));
+
+    telemetry.update();
+    QVariantList detectors = telemetry.property("detectors").toList();
+    QCOMPARE(detectors.count(), 1);
+    QVariantMap row = detectors[0].toMap();
+    QCOMPARE(row["tagId"].toUInt(), 4u);
+    QCOMPARE(row["droppedGroups"].toLongLong(), static_cast<qint64>(2));
+    QCOMPARE(row["receivedBuckets"].toList().count(), LatencyHistogram::bucketCount);
+    QCOMPARE(row["ingestMeanMsecs"].toDouble(), 150.0);
+}
+
+void PipelineTelemetryTest::_cpuTemp_test(void)
+{
+    PipelineTelemetry telemetry;
+
+    // Ring buffer keeps the newest samples
+    int sampleCount = PipelineTelemetry::maxCpuTempSamples + 10;
+    for (int i=0; i<sampleCount; i++) {
+        telemetry.recordControllerHeartbeat(i * 5000, i);
+    }
+    QCOMPARE(telemetry.cpuTempCount(), PipelineTelemetry::maxCpuTempSamples);
+
+    telemetry.update();
+    QList<double> times     = telemetry.property("cpuTempTimes").value<QList<double>>();
+    QList<double> values    = telemetry.property("cpuTempValues").value<QList<double>>();
+    QCOMPARE(values.count(), PipelineTelemetry::maxCpuTempSamples);
+    QCOMPARE(values.first(), 10.0);
+    QCOMPARE(values.last(), static_cast<double>(sampleCount - 1));
+    QCOMPARE(times.first(), 0.0);
+    QCOMPARE(times.last(), (PipelineTelemetry::maxCpuTempSamples - 1) * 5.0);
+}
+
+void PipelineTelemetryTest::_export_test(void)
+{
+    PipelineTelemetry telemetry;
+    QTemporaryDir     tempDir;
+    QString           csvFileName = tempDir.filePath("Telemetry.csv");
+    QString           errorString;
+
+    telemetry.recordPulseReceived(_pulse(2, 10.0, 1), 10100);
+    telemetry.recordControllerHeartbeat(0, 45);
+    telemetry.recordControllerHeartbeat(5000, 46);
+    telemetry.recordChannelizerHeartbeat(1000);
+
+    QVERIFY2(telemetry.exportToCsv(csvFileName, errorString), qPrintable(errorString));
+
+    QFile csvFile(csvFileName);
+    QVERIFY(csvFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QString csv = QString::fromUtf8(csvFile.readAll());
+    QVERIFY(csv.contains("detector, 2, 1, 100, 100, 100, 100,"));
+    QVERIFY(csv.contains("histogram, 2, received,"));
+    QVERIFY(csv.contains("heartbeat, controller, 2, 5000.0, 0.0, 5000"));
+    QVERIFY(csv.contains("heartbeat, channelizer, 1,"));
+    QVERIFY(csv.contains("cpu_temp, 5000, 46.0"));
+
+    QVERIFY(!telemetry.exportToCsv(tempDir.filePath("missing/Telemetry.csv"), errorString));
+    QVERIFY(!errorString.isEmpty());
+}
+
+UT_REGISTER_TEST(PipelineTelemetryTest)
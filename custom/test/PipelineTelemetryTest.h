@@ -0,0 +1,16 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for PipelineTelemetry
+class PipelineTelemetryTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _histogram_test    (void);
+    void _heartbeat_test    (void);
+    void _groupSeqGap_test  (void);
+    void _cpuTemp_test      (void);
+    void _export_test       (void);
+};
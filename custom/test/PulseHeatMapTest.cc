@@ -0,0 +1,78 @@
+#include "PulseHeatMapTest.h"
+#include "PulseHeatMap.h"
+
+static const QGeoCoordinate _origin(32.0, -110.0);
+
+void PulseHeatMapTest::_aggregate_test(void)
+{
+    PulseHeatMap heatMap(10, 100);
+
+    // Pulses within the same cell update that cell in place
+    heatMap.addPulse(_origin.atDistanceAndAzimuth(1, 45), 10);
+    heatMap.addPulse(_origin.atDistanceAndAzimuth(2, 45), 30);
+    heatMap.addPulse(_origin.atDistanceAndAzimuth(3, 45), 20);
+
+    QVERIFY(heatMap.valid());
+    QCOMPARE(heatMap.cellCount(), 1);
+    QCOMPARE(heatMap.cellValue(_origin.atDistanceAndAzimuth(2, 45)), 30.0);
+
+    heatMap.setMode(PulseHeatMap::ModeMean);
+    QCOMPARE(heatMap.cellValue(_origin.atDistanceAndAzimuth(2, 45)), 20.0);
+
+    // A pulse in a different cell
+    heatMap.addPulse(_origin.atDistanceAndAzimuth(50, 0), 5);
+    QCOMPARE(heatMap.cellCount(), 2);
+    QVERIFY(qIsNaN(heatMap.cellValue(_origin.atDistanceAndAzimuth(50, 180))));
+}
+
+void PulseHeatMapTest::_growth_test(void)
+{
+    PulseHeatMap heatMap(5, 100);
+
+    heatMap.addPulse(_origin, 50);
+    double initialWidth = heatMap.widthMeters();
+
+    // Fly well outside the initial bounds, previous cells must survive the grid re-layout
+    QGeoCoordinate farCoord = _origin.atDistanceAndAzimuth(1000, 45);
+    heatMap.addPulse(farCoord, 70);
+
+    QCOMPARE(heatMap.cellCount(), 2);
+    QVERIFY(heatMap.widthMeters() > initialWidth);
+    QCOMPARE(heatMap.cellValue(_origin), 50.0);
+    QCOMPARE(heatMap.cellValue(farCoord), 70.0);
+    QCOMPARE(heatMap.image().width(), qRound(heatMap.widthMeters() / 5));
+
+    // Grid bounds must contain both pulses
+    QGeoCoordinate topLeft = heatMap.topLeft();
+    QVERIFY(topLeft.latitude() > farCoord.latitude());
+    QVERIFY(topLeft.longitude() < _origin.longitude());
+}
+
+void PulseHeatMapTest::_maxGridSize_test(void)
+{
+    PulseHeatMap heatMap(1, 100);
+
+    heatMap.addPulse(_origin, 50);
+
+    // Further away than the maximum grid dimension allows at this resolution
+    heatMap.addPulse(_origin.atDistanceAndAzimuth(PulseHeatMap::maxGridDimension * 1.5, 90), 50);
+
+    QCOMPARE(heatMap.cellCount(), 1);
+    QVERIFY(heatMap.image().width() <= PulseHeatMap::maxGridDimension);
+    QVERIFY(heatMap.image().height() <= PulseHeatMap::maxGridDimension);
+}
+
+void PulseHeatMapTest::_resolution_test(void)
+{
+    PulseHeatMap heatMap(5, 100);
+
+    heatMap.addPulse(_origin, 50);
+    heatMap.setResolution(5);
+    QCOMPARE(heatMap.cellCount(), 1);
+
+    heatMap.setResolution(20);
+    QVERIFY(!heatMap.valid());
+    QVERIFY(qIsNaN(heatMap.cellValue(_origin)));
+}
+
+UT_REGISTER_TEST(PulseHeatMapTest)
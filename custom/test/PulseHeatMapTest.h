@@ -0,0 +1,15 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for PulseHeatMap
+class PulseHeatMapTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _aggregate_test    (void);
+    void _growth_test       (void);
+    void _maxGridSize_test  (void);
+    void _resolution_test   (void);
+};
@@ -0,0 +1,204 @@
+#include "PulseLogTest.h"
+#include "PulseLog.h"
+
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QFile>
+
+using namespace TunnelProtocol;
+
+static PulseInfo_t _pulse(uint32_t tagId, double startTimeSeconds)
+{
+    PulseInfo_t pulseInfo;
+
+    memset(&pulseInfo, 0, sizeof(pulseInfo));
+    pulseInfo.tag_id                        = tagId;
+    pulseInfo.frequency_hz                  = 146000000;
+    pulseInfo.start_time_seconds            = startTimeSeconds;
+    pulseInfo.predict_next_start_seconds    = startTimeSeconds + 2;
+    pulseInfo.snr                           = 18.25;
+    pulseInfo.stft_score                    = 0.5;
+    pulseInfo.group_seq_counter             = 3;
+    pulseInfo.group_ind                     = 1;
+    pulseInfo.group_snr                     = 17.75;
+    pulseInfo.noise_psd                     = 0.125;
+    pulseInfo.detection_status              = 2;
+    pulseInfo.confirmed_status              = 1;
+    pulseInfo.position_x                    = 1.5;
+    pulseInfo.position_y                    = -2.5;
+    pulseInfo.position_z                    = 10;
+    pulseInfo.orientation_x                 = 0;
+    pulseInfo.orientation_y                 = 0;
+    pulseInfo.orientation_z                 = 0.5;
+    pulseInfo.orientation_w                 = 0.75;
+
+    return pulseInfo;
+}
+
+/// @return Size of a pulse log holding the specified number of records
+static qint64 _logSize(int recordCount)
+{
+    return static_cast<qint64>(sizeof(PulseLogHeader_t)) + (recordCount * static_cast<qint64>(sizeof(PulseLogRecord_t)));
+}
+
+void PulseLogTest::_roundTrip_test(void)
+{
+    QTemporaryDir   tempDir;
+    QString         logFileName = tempDir.filePath(QStringLiteral("RoundTrip.%1").arg(PulseLogFileExtension));
+
+    {
+        PulseLogWriter writer;
+
+        QVERIFY(writer.open(logFileName));
+        QVERIFY(writer.isOpen());
+        QVERIFY(!writer.open(logFileName));
+        writer.logRotationStartStop(true, 32.5, -110.25, 1234.5);
+        for (int i=0; i<3; i++) {
+            writer.logPulse(_pulse(i + 1, 100 + i), i * 90.0);
+        }
+        writer.logRotationStartStop(false, 32.75, -110.5, 1240);
+        writer.close();
+        QVERIFY(!writer.isOpen());
+
+        // Nothing is logged once closed
+        writer.logPulse(_pulse(9, 200), 0);
+    }
+    QCOMPARE(QFile(logFileName).size(), _logSize(5));
+
+    PulseLogReader      reader(logFileName);
+    PulseLogRecord_t    record;
+    QVERIFY2(reader.open(), qPrintable(reader.errorString()));
+
+    QVERIFY(reader.nextRecord(record));
+    QCOMPARE(record.recordType, static_cast<uint32_t>(PulseLogRecordRotationStart));
+    QCOMPARE(record.rotationInfo.latitude,      32.5);
+    QCOMPARE(record.rotationInfo.longitude,     -110.25);
+    QCOMPARE(record.rotationInfo.altitudeAMSL,  1234.5);
+
+    for (int i=0; i<3; i++) {
+        PulseInfo_t expectedPulse = _pulse(i + 1, 100 + i);
+
+        QVERIFY(reader.nextRecord(record));
+        QCOMPARE(record.recordType, static_cast<uint32_t>(PulseLogRecordPulse));
+        QCOMPARE(record.antennaOffset, i * 90.0);
+        QVERIFY(memcmp(&record.pulseInfo, &expectedPulse, sizeof(expectedPulse)) == 0);
+    }
+
+    QVERIFY(reader.nextRecord(record));
+    QCOMPARE(record.recordType, static_cast<uint32_t>(PulseLogRecordRotationStop));
+    QCOMPARE(record.rotationInfo.altitudeAMSL, 1240.0);
+
+    QVERIFY(!reader.nextRecord(record));
+}
+
+void PulseLogTest::_batchFlush_test(void)
+{
+    QTemporaryDir   tempDir;
+    QString         logFileName = tempDir.filePath(QStringLiteral("Flush.%1").arg(PulseLogFileExtension));
+    PulseLogWriter  writer;
+
+    QVERIFY(writer.open(logFileName));
+
+    // A partial batch is written once the flush interval expires
+    QElapsedTimer flushTimer;
+    flushTimer.start();
+    writer.logPulse(_pulse(1, 100), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(QFile(logFileName).size(), _logSize(1), PulseLogWriter::flushIntervalMsecs * 2);
+    QVERIFY(flushTimer.elapsed() < PulseLogWriter::flushIntervalMsecs + 500);
+
+    // The writer has just started a new flush interval, so a full batch must be written well before it expires
+    for (int i=0; i<PulseLogWriter::maxBatchRecords; i++) {
+        writer.logPulse(_pulse(1, 101 + i), 0);
+    }
+    QTRY_COMPARE_WITH_TIMEOUT(QFile(logFileName).size(), _logSize(1 + PulseLogWriter::maxBatchRecords), PulseLogWriter::flushIntervalMsecs / 2);
+
+    // Close drains whatever is left
+    writer.logPulse(_pulse(1, 200), 0);
+    writer.close();
+    QCOMPARE(QFile(logFileName).size(), _logSize(2 + PulseLogWriter::maxBatchRecords));
+}
+
+void PulseLogTest::_badLog_test(void)
+{
+    QTemporaryDir   tempDir;
+    QString         logFileName = tempDir.filePath(QStringLiteral("Bad.%1").arg(PulseLogFileExtension));
+
+    // Missing file
+    PulseLogReader missingReader(logFileName);
+    QVERIFY(!missingReader.open());
+    QVERIFY(!missingReader.errorString().isEmpty());
+
+    // Wrong magic
+    {
+        QFile file(logFileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(sizeof(PulseLogHeader_t), 'x'));
+    }
+    PulseLogReader badMagicReader(logFileName);
+    QVERIFY(!badMagicReader.open());
+    QVERIFY(badMagicReader.errorString().contains("is not a pulse log"));
+
+    // A record cut short by an interrupted writer ends the log
+    {
+        PulseLogWriter writer;
+        QVERIFY(writer.open(logFileName));
+        writer.logPulse(_pulse(1, 100), 0);
+        writer.close();
+    }
+    {
+        QFile file(logFileName);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write(QByteArray(sizeof(PulseLogRecord_t) / 2, '\0'));
+    }
+    PulseLogReader      truncatedReader(logFileName);
+    PulseLogRecord_t    record;
+    QVERIFY2(truncatedReader.open(), qPrintable(truncatedReader.errorString()));
+    QVERIFY(truncatedReader.nextRecord(record));
+    QVERIFY(!truncatedReader.nextRecord(record));
+}
+
+void PulseLogTest::_exportToCsv_test(void)
+{
+    QTemporaryDir   tempDir;
+    QString         logFileName = tempDir.filePath(QStringLiteral("Export.%1").arg(PulseLogFileExtension));
+    QString         csvFileName = tempDir.filePath("Export.csv");
+    QString         errorString;
+
+    PulseLogWriter writer;
+    QVERIFY(writer.open(logFileName));
+    writer.logPulse(_pulse(7, 12.5), 45);
+    writer.logRotationStartStop(true, 32.5, -110.25, 1234.5);
+    writer.logRotationStartStop(false, 32.75, -110.5, 1240);
+    writer.close();
+
+    QVERIFY2(PulseLogReader::exportToCsv(logFileName, csvFileName, errorString), qPrintable(errorString));
+
+    // Expected output of the original per pulse csv writer for the same pulses
+    QStringList expectedLines = {
+        QStringLiteral("# %1, tag_id, frequency_hz, start_time_seconds, predict_next_start_seconds, snr, stft_score, group_seq_counter, group_ind, group_snr, noise_psd, detection_status, confirmed_status, position_x, _y, _z, orientation_x, _y, _z, _w, antenna_offset").arg(COMMAND_ID_PULSE),
+        QStringLiteral("%1, 7, 146000000, 12.500000, 14.500000, 18.250000, 0.500000, 3, 1, 17.750000, 0.125, 2, 1, 1.500000, -2.500000, 10.000000, 0.000000, 0.000000, 0.500000, 0.750000, 45.000000").arg(COMMAND_ID_PULSE),
+        QStringLiteral("%1,32.500000,-110.250000,1234.500000").arg(COMMAND_ID_START_ROTATION),
+        QStringLiteral("%1,32.750000,-110.500000,1240.000000").arg(COMMAND_ID_STOP_ROTATION),
+    };
+
+    QFile csvFile(csvFileName);
+    QVERIFY(csvFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QStringList lines = QString::fromUtf8(csvFile.readAll()).split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines, expectedLines);
+    csvFile.close();
+
+    // Like the original writer the column header is only written when the log starts with a pulse
+    QVERIFY(writer.open(logFileName));
+    writer.logRotationStartStop(true, 32.5, -110.25, 1234.5);
+    writer.logPulse(_pulse(7, 12.5), 45);
+    writer.close();
+
+    QVERIFY2(PulseLogReader::exportToCsv(logFileName, csvFileName, errorString), qPrintable(errorString));
+    QVERIFY(csvFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    lines = QString::fromUtf8(csvFile.readAll()).split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines.count(), 2);
+    QCOMPARE(lines[0], expectedLines[2]);
+    QCOMPARE(lines[1], expectedLines[1]);
+}
+
+UT_REGISTER_TEST(PulseLogTest)
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for PulseLogWriter and PulseLogReader
+class PulseLogTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _roundTrip_test    (void);
+    void _batchFlush_test   (void);
+    void _badLog_test       (void);
+    void _exportToCsv_test  (void);
+};
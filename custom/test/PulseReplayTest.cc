@@ -0,0 +1,207 @@
+#include "PulseReplayTest.h"
+#include "PulseReplayer.h"
+#include "CustomPlugin.h"
+#include "TagTrackerSession.h"
+#include "TagDatabase.h"
+#include "BearingEstimator.h"
+#include "QGCApplication.h"
+#include "MultiVehicleManager.h"
+#include "Vehicle.h"
+
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+// mallinfo2 is glibc only, other builds skip the heap metric
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define PULSE_REPLAY_HEAP_METRIC
+#include <malloc.h>
+#endif
+
+using namespace TunnelProtocol;
+
+#ifdef PULSE_REPLAY_HEAP_METRIC
+// Heap in use, which is the net of allocations and frees rather than an allocation count. The global allocation
+// functions are left alone, so this works beside ASan and other allocator tooling.
+static qint64 _heapBytesInUse(void)
+{
+    return static_cast<qint64>(mallinfo2().uordblks);
+}
+#endif
+
+static const QGeoCoordinate _rotationCenter(32.0, -110.0, 120.0);
+
+// One full rotation of the vehicle with the antenna pointing at the tag at 90 degrees
+static QVector<PulseInfo_t> _generatePulses(uint32_t tagId, int cPulses)
+{
+    QVector<PulseInfo_t> pulses;
+
+    for (int i=0; i<cPulses; i++) {
+        PulseInfo_t pulseInfo;
+        double      headingDegrees  = (360.0 * i) / cPulses;
+        double      halfYawRadians  = qDegreesToRadians(headingDegrees) / 2.0;
+
+        memset(&pulseInfo, 0, sizeof(pulseInfo));
+        pulseInfo.header.command        = COMMAND_ID_PULSE;
+        pulseInfo.tag_id                = tagId;
+        pulseInfo.frequency_hz          = 146000000;
+        pulseInfo.start_time_seconds    = i * 0.1;
+        pulseInfo.snr                   = 20.0 + (10.0 * qCos(qDegreesToRadians(headingDegrees - 90.0)));
+        pulseInfo.stft_score            = pulseInfo.snr;
+        pulseInfo.confirmed_status      = 1;
+        pulseInfo.position_x            = _rotationCenter.latitude();
+        pulseInfo.position_y            = _rotationCenter.longitude();
+        pulseInfo.position_z            = _rotationCenter.altitude();
+        pulseInfo.orientation_w         = qCos(halfYawRadians);
+        pulseInfo.orientation_z         = qSin(halfYawRadians);
+
+        pulses.append(pulseInfo);
+    }
+
+    return pulses;
+}
+
+static TagTrackerSession* _activeSession(void)
+{
+    CustomPlugin* customPlugin = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin());
+    return customPlugin ? customPlugin->property("activeSession").value<TagTrackerSession*>() : nullptr;
+}
+
+static TagInfo* _newTag(void)
+{
+    CustomPlugin* customPlugin = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin());
+    return qobject_cast<TagInfo*>(customPlugin->tagDatabase()->newTagInfo());
+}
+
+static void _deleteTag(TagInfo* tagInfo)
+{
+    CustomPlugin* customPlugin = qobject_cast<CustomPlugin*>(qgcApp()->toolbox()->corePlugin());
+    customPlugin->tagDatabase()->deleteTagInfoListItem(tagInfo);
+}
+
+void PulseReplayTest::_replay_test(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+
+    TagTrackerSession* session = _activeSession();
+    QVERIFY(session);
+
+    TagInfo*        tagInfo = _newTag();
+    PulseReplayer   replayer(_mockLink);
+    int             cProcessed = 0;
+
+    connect(session, &TagTrackerSession::pulsesProcessed, this, [&cProcessed](int pulseCount) { cProcessed += pulseCount; });
+
+    replayer.setPulses(_generatePulses(tagInfo->id()->rawValue().toUInt(), 36));
+    replayer.start(0);
+
+    QTRY_COMPARE_WITH_TIMEOUT(cProcessed, 36, 5000);
+    QCOMPARE(replayer.injectedCount(), 36);
+    QCOMPARE(session->property("controllerLostHeartbeat").toBool(), false);
+
+    // Vehicle state follows the replayed pulses
+    QVERIFY(_vehicle->coordinate().distanceTo(_rotationCenter) < 1.0);
+    QVERIFY(qAbs(_vehicle->heading()->rawValue().toDouble() - 350.0) < 1.0);
+
+    _deleteTag(tagInfo);
+}
+
+void PulseReplayTest::_pulseLog_test(void)
+{
+    QTemporaryDir   tempDir;
+    QString         logFileName = tempDir.filePath("Replay.pulses");
+
+    {
+        PulseLogWriter writer;
+        QVERIFY(writer.open(logFileName));
+        writer.logRotationStartStop(true, _rotationCenter.latitude(), _rotationCenter.longitude(), _rotationCenter.altitude());
+        for (const PulseInfo_t& pulseInfo: _generatePulses(2, 10)) {
+            writer.logPulse(pulseInfo, 0);
+        }
+        writer.logRotationStartStop(false, _rotationCenter.latitude(), _rotationCenter.longitude(), _rotationCenter.altitude());
+        writer.close();
+    }
+
+    PulseReplayer replayer(nullptr);
+    QVERIFY(replayer.load(logFileName));
+    QCOMPARE(replayer.pulseCount(), 10);
+
+    QVERIFY(!replayer.load(tempDir.filePath("Missing.pulses")));
+    QVERIFY(!replayer.errorString().isEmpty());
+}
+
+void PulseReplayBenchmark::_benchmark(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_ARDUPILOTMEGA);
+
+    TagTrackerSession* session = _activeSession();
+    QVERIFY(session);
+
+    TagInfo*        tagInfo     = _newTag();
+    PulseReplayer   replayer(_mockLink);
+    QString         logFileName = qEnvironmentVariable("PULSE_REPLAY_LOG");
+    double          speed       = qEnvironmentVariable("PULSE_REPLAY_SPEED", "0").toDouble();
+
+    if (logFileName.isEmpty()) {
+        replayer.setPulses(_generatePulses(tagInfo->id()->rawValue().toUInt(), 20000));
+    } else {
+        QVERIFY2(replayer.load(logFileName), qPrintable(replayer.errorString()));
+    }
+
+    // Pulses are processed in injection order, so the nth processed pulse was the nth injected
+    QVector<qint64> processedNsecs;
+    processedNsecs.reserve(replayer.pulseCount());
+    connect(session, &TagTrackerSession::pulsesProcessed, this, [&processedNsecs, &replayer](int pulseCount) {
+        qint64 nsecs = replayer.elapsedNsecs();
+        for (int i=0; i<pulseCount; i++) {
+            processedNsecs.append(nsecs);
+        }
+    });
+
+#ifdef PULSE_REPLAY_HEAP_METRIC
+    qint64 startHeapBytes = _heapBytesInUse();
+#endif
+    replayer.start(speed);
+    QTRY_COMPARE_WITH_TIMEOUT(processedNsecs.count(), replayer.pulseCount(), 600000);
+#ifdef PULSE_REPLAY_HEAP_METRIC
+    qint64 endHeapBytes = _heapBytesInUse();
+#endif
+
+    qint64 totalNsecs   = processedNsecs.last();
+    qint64 maxLatency   = 0;
+    double sumLatency   = 0;
+    for (int i=0; i<processedNsecs.count(); i++) {
+        qint64 latency = processedNsecs[i] - replayer.injectNsecs()[i];
+        maxLatency = std::max(maxLatency, latency);
+        sumLatency += latency;
+    }
+
+    // Bearing is updated synchronously when a slice completes, so bearing latency is the pulse latency plus the
+    // slice completion time.
+    BearingEstimator        bearingEstimator;
+    QElapsedTimer           bearingTimer;
+    QVector<PulseInfo_t>    rotationPulses = _generatePulses(2, 16 * 20);
+    for (int i=0; i<rotationPulses.count(); i++) {
+        bearingEstimator.addPulse(rotationPulses[i]);
+        if (i % 20 == 19 && i != rotationPulses.count() - 1) {
+            bearingEstimator.completeSlice(BearingEstimator::headingFromOrientation(rotationPulses[i]));
+        }
+    }
+    bearingTimer.start();
+    bearingEstimator.completeSlice(BearingEstimator::headingFromOrientation(rotationPulses.last()));
+    qint64 completeSliceNsecs = bearingTimer.nsecsElapsed();
+
+    qDebug() << "PulseReplay pulses:pulses/sec:meanLatency(ms):maxLatency(ms):completeSlice(ms)"
+             << processedNsecs.count()
+             << processedNsecs.count() / (totalNsecs / 1.0e9)
+             << sumLatency / processedNsecs.count() / 1.0e6
+             << maxLatency / 1.0e6
+             << completeSliceNsecs / 1.0e6;
+#ifdef PULSE_REPLAY_HEAP_METRIC
+    qDebug() << "PulseReplay netHeapGrowth(bytes)/pulse" << static_cast<double>(endHeapBytes - startHeapBytes) / processedNsecs.count();
+#endif
+
+    _deleteTag(tagInfo);
+}
+
+UT_REGISTER_TEST(PulseReplayTest)
+UT_REGISTER_TEST_STANDALONE(PulseReplayBenchmark)
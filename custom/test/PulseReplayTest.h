@@ -0,0 +1,24 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Drives pulses through the full MAVLink to tag tracker session path using PulseReplayer
+class PulseReplayTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _replay_test       (void);
+    void _pulseLog_test     (void);
+};
+
+/// Run with --unittest:PulseReplayBenchmark
+/// Set PULSE_REPLAY_LOG to replay a recorded pulse log instead of generated pulses. PULSE_REPLAY_SPEED sets the
+/// playback speed, default is as fast as possible.
+class PulseReplayBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _benchmark(void);
+};
@@ -0,0 +1,174 @@
+#include "PulseReplayer.h"
+#include "BearingEstimator.h"
+#include "MockLink.h"
+#include "QGCApplication.h"
+#include "MAVLinkProtocol.h"
+
+#include <QtMath>
+
+using namespace TunnelProtocol;
+
+PulseReplayer::PulseReplayer(MockLink* mockLink, QObject* parent)
+    : QObject   (parent)
+    , _mockLink (mockLink)
+{
+    _injectTimer.setSingleShot(true);
+    connect(&_injectTimer, &QTimer::timeout, this, &PulseReplayer::_injectNextPulses);
+}
+
+bool PulseReplayer::load(const QString& pulseLogFileName)
+{
+    PulseLogReader      reader(pulseLogFileName);
+    PulseLogRecord_t    record;
+
+    _pulses.clear();
+
+    if (!reader.open()) {
+        _errorString = reader.errorString();
+        return false;
+    }
+
+    while (reader.nextRecord(record)) {
+        // Rotation start/stop records are annotations, the pulses carry everything needed for replay
+        if (record.recordType == PulseLogRecordPulse) {
+            _pulses.append(record.pulseInfo);
+        }
+    }
+
+    return true;
+}
+
+void PulseReplayer::start(double speed)
+{
+    _speed              = speed;
+    _nextPulseIndex     = 0;
+    _lastHeartbeatMsecs = 0;
+    _firstPulseSeconds  = _pulses.isEmpty() ? 0 : _pulses.first().start_time_seconds;
+    _injectNsecs.clear();
+    _injectNsecs.reserve(_pulses.count());
+
+    _playbackTimer.start();
+    _injectControllerHeartbeat();
+    _injectTimer.start(0);
+}
+
+void PulseReplayer::stop(void)
+{
+    _injectTimer.stop();
+}
+
+void PulseReplayer::_injectNextPulses(void)
+{
+    int cInjected = 0;
+
+    while (_nextPulseIndex < _pulses.count() && cInjected < _maxPulsesPerTick) {
+        const PulseInfo_t& pulseInfo = _pulses[_nextPulseIndex];
+
+        if (_speed > 0) {
+            qint64 dueMsecs = qRound64(((pulseInfo.start_time_seconds - _firstPulseSeconds) * 1000.0) / _speed);
+            qint64 waitMsecs = dueMsecs - _playbackTimer.elapsed();
+            if (waitMsecs > 0) {
+                _injectTimer.start(static_cast<int>(waitMsecs));
+                return;
+            }
+        }
+
+        _injectPulse(pulseInfo);
+        _injectNsecs.append(_playbackTimer.nsecsElapsed());
+        _nextPulseIndex++;
+        cInjected++;
+    }
+
+    if (_playbackTimer.elapsed() - _lastHeartbeatMsecs >= _heartbeatIntervalMsecs) {
+        _injectControllerHeartbeat();
+    }
+
+    if (_nextPulseIndex < _pulses.count()) {
+        // Go back through the event loop so the application can process what was injected so far
+        _injectTimer.start(0);
+    } else {
+        emit replayComplete();
+    }
+}
+
+void PulseReplayer::_injectPulse(const PulseInfo_t& pulseInfo)
+{
+    mavlink_message_t   message;
+    uint8_t             vehicleId   = static_cast<uint8_t>(_mockLink->vehicleId());
+    uint8_t             channel     = _mockLink->mavlinkChannel();
+    uint32_t            bootMsecs   = static_cast<uint32_t>(_playbackTimer.elapsed());
+    double              heading     = BearingEstimator::headingFromOrientation(pulseInfo);
+
+    // Position and heading first so the pulse is handled with the vehicle state it was recorded with
+    mavlink_msg_global_position_int_pack_chan(vehicleId,
+                                              MAV_COMP_ID_AUTOPILOT1,
+                                              channel,
+                                              &message,
+                                              bootMsecs,
+                                              static_cast<int32_t>(pulseInfo.position_x * 1e7),
+                                              static_cast<int32_t>(pulseInfo.position_y * 1e7),
+                                              static_cast<int32_t>(pulseInfo.position_z * 1000),
+                                              static_cast<int32_t>(pulseInfo.position_z * 1000),
+                                              0, 0, 0,
+                                              qIsNaN(heading) ? UINT16_MAX : static_cast<uint16_t>(heading * 100));
+    _sendMessage(message);
+
+    // Pulses recorded without attitude information have no attitude to replay
+    if (!qIsNaN(heading)) {
+        double w = pulseInfo.orientation_w;
+        double x = pulseInfo.orientation_x;
+        double y = pulseInfo.orientation_y;
+        double z = pulseInfo.orientation_z;
+        mavlink_msg_attitude_pack_chan(vehicleId,
+                                       MAV_COMP_ID_AUTOPILOT1,
+                                       channel,
+                                       &message,
+                                       bootMsecs,
+                                       static_cast<float>(qAtan2(2 * ((w * x) + (y * z)), 1 - (2 * ((x * x) + (y * y))))),
+                                       static_cast<float>(qAsin(qBound(-1.0, 2 * ((w * y) - (z * x)), 1.0))),
+                                       static_cast<float>(qDegreesToRadians(heading)),
+                                       0, 0, 0);
+        _sendMessage(message);
+    }
+
+    mavlink_tunnel_t tunnel;
+
+    memset(&tunnel, 0, sizeof(tunnel));
+    memcpy(tunnel.payload, &pulseInfo, sizeof(pulseInfo));
+    tunnel.target_system    = static_cast<uint8_t>(qgcApp()->toolbox()->mavlinkProtocol()->getSystemId());
+    tunnel.target_component = static_cast<uint8_t>(qgcApp()->toolbox()->mavlinkProtocol()->getComponentId());
+    tunnel.payload_type     = MAV_TUNNEL_PAYLOAD_TYPE_UNKNOWN;
+    tunnel.payload_length   = sizeof(pulseInfo);
+
+    mavlink_msg_tunnel_encode_chan(vehicleId, MAV_COMP_ID_ONBOARD_COMPUTER, channel, &message, &tunnel);
+    _sendMessage(message);
+}
+
+void PulseReplayer::_injectControllerHeartbeat(void)
+{
+    mavlink_message_t   message;
+    mavlink_tunnel_t    tunnel;
+    Heartbeat_t         heartbeat;
+
+    memset(&heartbeat, 0, sizeof(heartbeat));
+    heartbeat.header.command    = COMMAND_ID_HEARTBEAT;
+    heartbeat.system_id         = HEARTBEAT_SYSTEM_ID_MAVLINKCONTROLLER;
+    heartbeat.status            = HEARTBEAT_STATUS_DETECTING;
+
+    memset(&tunnel, 0, sizeof(tunnel));
+    memcpy(tunnel.payload, &heartbeat, sizeof(heartbeat));
+    tunnel.target_system    = static_cast<uint8_t>(qgcApp()->toolbox()->mavlinkProtocol()->getSystemId());
+    tunnel.target_component = static_cast<uint8_t>(qgcApp()->toolbox()->mavlinkProtocol()->getComponentId());
+    tunnel.payload_type     = MAV_TUNNEL_PAYLOAD_TYPE_UNKNOWN;
+    tunnel.payload_length   = sizeof(heartbeat);
+
+    mavlink_msg_tunnel_encode_chan(static_cast<uint8_t>(_mockLink->vehicleId()), MAV_COMP_ID_ONBOARD_COMPUTER, _mockLink->mavlinkChannel(), &message, &tunnel);
+    _sendMessage(message);
+
+    _lastHeartbeatMsecs = _playbackTimer.elapsed();
+}
+
+void PulseReplayer::_sendMessage(mavlink_message_t& message)
+{
+    _mockLink->respondWithMavlinkMessage(message);
+}
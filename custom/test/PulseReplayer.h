@@ -0,0 +1,71 @@
+#pragma once
+
+#include "PulseLog.h"
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QVector>
+
+class MockLink;
+
+/// Replays a binary pulse log into the application through a MockLink. Each pulse is injected as a TUNNEL message from
+/// the mock vehicle along with GLOBAL_POSITION_INT and ATTITUDE messages built from the position and orientation
+/// recorded with the pulse. This drives the full pulse path from MAVLink parsing through the tag tracker session
+/// without a live vehicle or SDR.
+///
+/// Telemetry logs with TUNNEL messages don't need this, they can be replayed as is with LogReplayLink.
+class PulseReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    PulseReplayer(MockLink* mockLink, QObject* parent = nullptr);
+
+    /// Loads all pulse records from the log
+    ///     @return true: success, false: failure, see errorString
+    bool load(const QString& pulseLogFileName);
+
+    /// Loads pulse records directly, used to replay generated pulses
+    void setPulses(const QVector<TunnelProtocol::PulseInfo_t>& pulses) { _pulses = pulses; }
+
+    /// Starts injecting pulses
+    ///     @param speed Playback speed relative to the pulse timestamps, 0 for as fast as possible
+    void start(double speed);
+    void stop (void);
+
+    int     pulseCount          (void) const { return _pulses.count(); }
+    int     injectedCount       (void) const { return _nextPulseIndex; }
+    QString errorString         (void) const { return _errorString; }
+
+    /// Wall clock time in nsecs relative to start() at which each pulse was injected
+    const QVector<qint64>& injectNsecs(void) const { return _injectNsecs; }
+
+    /// Time since start() was called
+    qint64  elapsedNsecs        (void) const { return _playbackTimer.nsecsElapsed(); }
+
+signals:
+    void replayComplete(void);
+
+private slots:
+    void _injectNextPulses(void);
+
+private:
+    void _injectPulse           (const TunnelProtocol::PulseInfo_t& pulseInfo);
+    void _injectControllerHeartbeat(void);
+    void _sendMessage           (mavlink_message_t& message);
+
+    MockLink*                           _mockLink;
+    QVector<TunnelProtocol::PulseInfo_t> _pulses;
+    QVector<qint64>                     _injectNsecs;
+    int                                 _nextPulseIndex     = 0;
+    double                              _speed              = 0;
+    double                              _firstPulseSeconds  = 0;
+    qint64                              _lastHeartbeatMsecs = 0;
+    QElapsedTimer                       _playbackTimer;
+    QTimer                              _injectTimer;
+    QString                             _errorString;
+
+    static constexpr int _maxPulsesPerTick          = 100;
+    static constexpr int _heartbeatIntervalMsecs    = 1000;
+};
@@ -0,0 +1,120 @@
+#include "PulseTimeSeriesTest.h"
+#include "PulseTimeSeries.h"
+
+void PulseTimeSeriesTest::_lttb_test(void)
+{
+    QVector<QPointF> points;
+    for (int i=0; i<100; i++) {
+        points.append(QPointF(i, i == 50 ? 100.0 : 1.0));
+    }
+
+    QVector<int> picked = PulseTimeSeries::lttb(points, 10);
+    QCOMPARE(picked.count(), 10);
+    QCOMPARE(picked.first(), 0);
+    QCOMPARE(picked.last(), 99);
+    QVERIFY(picked.contains(50));
+    QVERIFY(std::is_sorted(picked.begin(), picked.end()));
+
+    // Nothing to drop
+    QCOMPARE(PulseTimeSeries::lttb(points, 100).count(), 100);
+    QCOMPARE(PulseTimeSeries::lttb(points, 200).count(), 100);
+}
+
+void PulseTimeSeriesTest::_bucketing_test(void)
+{
+    PulseTimeSeries timeSeries;
+
+    // First three share a base bucket
+    timeSeries.addSample(1000, 10, 1, -50);
+    timeSeries.addSample(1100, 20, 2, -60);
+    timeSeries.addSample(1200, 30, 3, -70);
+    timeSeries.addSample(1300, 40, 4, -80);
+    QCOMPARE(timeSeries.sampleCount(), static_cast<qint64>(4));
+    QCOMPARE(timeSeries.firstMsecs(), static_cast<qint64>(1000));
+    QCOMPARE(timeSeries.lastMsecs(), static_cast<qint64>(1300));
+    QCOMPARE(timeSeries.levelForRange(1000, 2000, 100), 0);
+
+    QVector<PulseTimeSeries::Point_t> points = timeSeries.query(PulseTimeSeries::MetricSnr, 1000, 2000, 100);
+    QCOMPARE(points.count(), 2);
+    QCOMPARE(points[0].timeMsecs, static_cast<qint64>(1000));
+    QCOMPARE(points[0].min, 10.0f);
+    QCOMPARE(points[0].max, 30.0f);
+    QCOMPARE(points[0].mean, 20.0f);
+    QCOMPARE(points[1].timeMsecs, static_cast<qint64>(1250));
+    QCOMPARE(points[1].mean, 40.0f);
+
+    points = timeSeries.query(PulseTimeSeries::MetricNoisePsd, 1000, 2000, 100);
+    QCOMPARE(points[0].min, -70.0f);
+    QCOMPARE(points[0].max, -50.0f);
+
+    // Range outside the samples
+    QVERIFY(timeSeries.query(PulseTimeSeries::MetricSnr, 5000, 6000, 100).isEmpty());
+}
+
+void PulseTimeSeriesTest::_boundedQuery_test(void)
+{
+    PulseTimeSeries timeSeries;
+
+    // Ten hours of one pulse a second
+    const qint64 endMsecs = 10 * 60 * 60 * 1000;
+    for (qint64 msecs=0; msecs<endMsecs; msecs+=1000) {
+        timeSeries.addSample(msecs, 10, 10, -100);
+    }
+
+    // Whole flight comes from a coarse level and still fits the point budget
+    QVector<PulseTimeSeries::Point_t> points = timeSeries.query(PulseTimeSeries::MetricSnr, 0, endMsecs, 100);
+    QVERIFY(points.count() <= 100);
+    QVERIFY(points.count() > 50);
+    QVERIFY(timeSeries.levelForRange(0, endMsecs, 100) > 0);
+    QVERIFY(points.first().timeMsecs <= timeSeries.bucketMsecs(timeSeries.levelForRange(0, endMsecs, 100)));
+
+    // Recent window comes from full resolution
+    QCOMPARE(timeSeries.levelForRange(endMsecs - 60000, endMsecs, 100), 0);
+    points = timeSeries.query(PulseTimeSeries::MetricSnr, endMsecs - 60000, endMsecs, 100);
+    QCOMPARE(points.count(), 60);
+}
+
+void PulseTimeSeriesTest::_peakEnvelope_test(void)
+{
+    PulseTimeSeries timeSeries;
+
+    const qint64 endMsecs = 60 * 60 * 1000;
+    for (qint64 msecs=0; msecs<endMsecs; msecs+=1000) {
+        timeSeries.addSample(msecs, msecs == endMsecs / 2 ? 50 : 10, 0, 0);
+    }
+
+    // A single strong pulse must survive downsampling an hour into a few points
+    QVector<PulseTimeSeries::Point_t> points = timeSeries.query(PulseTimeSeries::MetricSnr, 0, endMsecs, 20);
+    QVERIFY(points.count() <= 20);
+
+    float maxValue = 0;
+    for (const PulseTimeSeries::Point_t& point: points) {
+        maxValue = std::max(maxValue, point.max);
+        QCOMPARE(point.min, 10.0f);
+    }
+    QCOMPARE(maxValue, 50.0f);
+}
+
+void PulseTimeSeriesTest::_rolledOffHistory_test(void)
+{
+    PulseTimeSeries timeSeries(16);
+
+    // Fills 100 base buckets, only the last 16 are still at level 0
+    for (qint64 i=0; i<100; i++) {
+        timeSeries.addSample(i * PulseTimeSeries::baseBucketMsecs, i, 0, 0);
+    }
+
+    qint64  endMsecs    = 100 * PulseTimeSeries::baseBucketMsecs;
+    int     level       = timeSeries.levelForRange(0, endMsecs, 100);
+    QVERIFY(level > 0);
+
+    QVector<PulseTimeSeries::Point_t> points = timeSeries.query(PulseTimeSeries::MetricSnr, 0, endMsecs, 100);
+    QCOMPARE(points.first().timeMsecs, static_cast<qint64>(0));
+    QCOMPARE(points.first().min, 0.0f);
+    QCOMPARE(points.last().max, 99.0f);
+
+    // Recent history is still at full resolution
+    QCOMPARE(timeSeries.levelForRange(endMsecs - (16 * PulseTimeSeries::baseBucketMsecs), endMsecs, 100), 0);
+}
+
+UT_REGISTER_TEST(PulseTimeSeriesTest)
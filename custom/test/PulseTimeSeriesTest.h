@@ -0,0 +1,16 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for PulseTimeSeries
+class PulseTimeSeriesTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _lttb_test             (void);
+    void _bucketing_test        (void);
+    void _boundedQuery_test     (void);
+    void _peakEnvelope_test     (void);
+    void _rolledOffHistory_test (void);
+};
@@ -0,0 +1,167 @@
+#include "SpectrogramPyramidTest.h"
+#include "SpectrogramPyramid.h"
+
+#include <QtEndian>
+#include <QtMath>
+
+QByteArray SpectrogramPyramidTest::_toneCapture(qint64 frameCount, int bin)
+{
+    QByteArray capture(frameCount * SpectrogramPyramid::bytesPerFrame, 0);
+
+    for (qint64 sample=0; sample<frameCount*SpectrogramPyramid::fftSize; sample++) {
+        double  phase   = (2.0 * M_PI * bin * sample) / SpectrogramPyramid::fftSize;
+        char*   dest    = capture.data() + (sample * SpectrogramPyramid::bytesPerSample);
+        qToLittleEndian<float>(static_cast<float>(qCos(phase)), dest);
+        qToLittleEndian<float>(static_cast<float>(qSin(phase)), dest + sizeof(float));
+    }
+
+    return capture;
+}
+
+void SpectrogramPyramidTest::_fft_test(void)
+{
+    QVector<std::complex<float>> data(64);
+
+    // Impulse has a flat spectrum
+    data[0] = 1.0f;
+    SpectrogramPyramid::fft(data);
+    for (const std::complex<float>& bin: data) {
+        QVERIFY(qAbs(std::abs(bin) - 1.0f) < 1e-4f);
+    }
+
+    // Complex tone lands in a single bin
+    for (int i=0; i<data.count(); i++) {
+        data[i] = std::polar(1.0f, static_cast<float>((2.0 * M_PI * 5 * i) / data.count()));
+    }
+    SpectrogramPyramid::fft(data);
+    for (int i=0; i<data.count(); i++) {
+        if (i == 5) {
+            QVERIFY(qAbs(std::abs(data[i]) - data.count()) < 1e-2f);
+        } else {
+            QVERIFY(std::abs(data[i]) < 1e-2f);
+        }
+    }
+}
+
+void SpectrogramPyramidTest::_levels_test(void)
+{
+    // Less than a tile only has full resolution
+    SpectrogramPyramid small(100 * SpectrogramPyramid::bytesPerFrame, 1024 * 1024);
+    QCOMPARE(small.frameCount(), static_cast<qint64>(100));
+    QCOMPARE(small.levelCount(), 1);
+
+    // Partial frames at the end are dropped
+    SpectrogramPyramid large((10000 * SpectrogramPyramid::bytesPerFrame) + 10, 1024 * 1024);
+    QCOMPARE(large.frameCount(), static_cast<qint64>(10000));
+    QCOMPARE(large.rowCount(0), static_cast<qint64>(10000));
+    QCOMPARE(large.rowCount(1), static_cast<qint64>(5000));
+    QCOMPARE(large.rowCount(5), static_cast<qint64>(313));
+    QCOMPARE(large.levelCount(), 7);
+    QVERIFY(large.rowCount(large.levelCount() - 1) <= SpectrogramPyramid::tileRows);
+
+    // Levels which skip frames only read the start of each row
+    SpectrogramPyramid::Fetch_t fetch = large.fetchForRows(6, 10, 5);
+    QCOMPARE(fetch.rowCount, 1);
+    QCOMPARE(fetch.offset, static_cast<uint32_t>(10 * 64 * SpectrogramPyramid::bytesPerFrame));
+    QCOMPARE(fetch.size, static_cast<uint32_t>(SpectrogramPyramid::maxFramesPerRow * SpectrogramPyramid::bytesPerFrame));
+
+    // Levels which read every frame fetch whole runs of rows, clamped to the end of the file
+    fetch = large.fetchForRows(1, 4998, 5);
+    QCOMPARE(fetch.rowCount, 5);
+    QCOMPARE(fetch.offset, static_cast<uint32_t>(9996 * SpectrogramPyramid::bytesPerFrame));
+    QCOMPARE(fetch.size, static_cast<uint32_t>(4 * SpectrogramPyramid::bytesPerFrame));
+}
+
+void SpectrogramPyramidTest::_fetchOrder_test(void)
+{
+    QByteArray                  capture = _toneCapture(256, 10);
+    SpectrogramPyramid          pyramid(capture.size(), 1024 * 1024);
+    SpectrogramPyramid::Fetch_t fetch;
+
+    // Rows are handed out coarse to fine so the range fills in evenly
+    QList<qint64> expectedRows({ 0, 128, 64, 192 });
+    for (qint64 expectedRow: expectedRows) {
+        QVERIFY(pyramid.nextFetch(0, 0, 256, fetch));
+        QCOMPARE(fetch.firstRow, expectedRow);
+        QCOMPARE(fetch.rowCount, 1);
+        pyramid.addFetchData(fetch, capture.mid(fetch.offset, fetch.size));
+        QVERIFY(pyramid.rowAvailable(0, expectedRow));
+    }
+    QCOMPARE(pyramid.coverage(0, 0, 256), 4.0 / 256.0);
+}
+
+void SpectrogramPyramidTest::_fetchAll_test(void)
+{
+    QByteArray                  capture = _toneCapture(2048, 10);
+    SpectrogramPyramid          pyramid(capture.size(), 16 * 1024 * 1024);
+    SpectrogramPyramid::Fetch_t fetch;
+    int                         topLevel = pyramid.levelCount() - 1;
+    qint64                      bytesRead = 0;
+
+    QCOMPARE(topLevel, 3);
+    while (pyramid.nextFetch(topLevel, 0, SpectrogramPyramid::tileRows, fetch)) {
+        bytesRead += fetch.size;
+        pyramid.addFetchData(fetch, capture.mid(fetch.offset, fetch.size));
+    }
+    QCOMPARE(pyramid.coverage(topLevel, 0, SpectrogramPyramid::tileRows), 1.0);
+
+    // Every frame of the file was needed at this level
+    QCOMPARE(bytesRead, static_cast<qint64>(capture.size()));
+
+    // Tone is in the column for its bin, DC is in the center
+    QImage  image   = pyramid.render(topLevel, 0, SpectrogramPyramid::tileRows);
+    int     column  = 10 + (SpectrogramPyramid::fftSize / 2);
+    QCOMPARE(image.width(), SpectrogramPyramid::fftSize);
+    QCOMPARE(image.height(), SpectrogramPyramid::tileRows);
+    QVERIFY(image.pixelColor(column, 0).hueF() < image.pixelColor(0, 0).hueF());
+    QVERIFY(image.pixelColor(column, 0).hueF() < image.pixelColor(column + 20, 100).hueF());
+}
+
+void SpectrogramPyramidTest::_fallback_test(void)
+{
+    QByteArray                  capture = _toneCapture(4096, 10);
+    SpectrogramPyramid          pyramid(capture.size(), 16 * 1024 * 1024);
+    SpectrogramPyramid::Fetch_t fetch;
+    int                         topLevel = pyramid.levelCount() - 1;
+    qint64                      bytesRead = 0;
+
+    // The overview of a file which is larger than a tile only reads part of it
+    while (pyramid.nextFetch(topLevel, 0, SpectrogramPyramid::tileRows, fetch)) {
+        bytesRead += fetch.size;
+        pyramid.addFetchData(fetch, capture.mid(fetch.offset, fetch.size));
+    }
+    QVERIFY(bytesRead < capture.size());
+
+    // Nothing read at full resolution yet, rows come from the overview
+    QCOMPARE(pyramid.coverage(0, 1000, 256), 0.0);
+    QImage image = pyramid.render(0, 1000, 256);
+    for (int row=0; row<image.height(); row++) {
+        QVERIFY(image.pixel(10 + (SpectrogramPyramid::fftSize / 2), row) != qRgb(0, 0, 0));
+    }
+
+    // Rows past the end of the file stay empty
+    image = pyramid.render(0, 4000, 256);
+    QVERIFY(image.pixel(0, 50) != qRgb(0, 0, 0));
+    QCOMPARE(image.pixel(0, 200), qRgb(0, 0, 0));
+}
+
+void SpectrogramPyramidTest::_cacheBound_test(void)
+{
+    QByteArray          capture = _toneCapture(SpectrogramPyramid::tileRows * 8, 10);
+    SpectrogramPyramid  pyramid(capture.size(), 2 * SpectrogramPyramid::tileBytes);
+
+    for (int tile=0; tile<8; tile++) {
+        SpectrogramPyramid::Fetch_t fetch = pyramid.fetchForRows(0, tile * SpectrogramPyramid::tileRows, SpectrogramPyramid::tileRows);
+
+        pyramid.addFetchData(fetch, capture.mid(fetch.offset, fetch.size));
+        QVERIFY(pyramid.rowAvailable(0, fetch.firstRow));
+        QVERIFY(pyramid.cacheBytes() <= 2 * SpectrogramPyramid::tileBytes);
+    }
+
+    // Only the most recently used tiles are kept
+    QVERIFY(!pyramid.rowAvailable(0, 0));
+    QVERIFY(pyramid.rowAvailable(0, SpectrogramPyramid::tileRows * 6));
+    QVERIFY(pyramid.rowAvailable(0, SpectrogramPyramid::tileRows * 7));
+}
+
+UT_REGISTER_TEST(SpectrogramPyramidTest)
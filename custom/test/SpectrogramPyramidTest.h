@@ -0,0 +1,20 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for SpectrogramPyramid
+class SpectrogramPyramidTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _fft_test          (void);
+    void _levels_test       (void);
+    void _fetchOrder_test   (void);
+    void _fetchAll_test     (void);
+    void _fallback_test     (void);
+    void _cacheBound_test   (void);
+
+private:
+    QByteArray _toneCapture(qint64 frameCount, int bin);
+};
@@ -0,0 +1,245 @@
+#include "TagDatabaseTest.h"
+#include "TagDatabase.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+void TagDatabaseTest::_lookup_test(void)
+{
+    QTemporaryDir   dir;
+    TagDatabase     tagDB(nullptr, dir.path());
+
+    TagManufacturer*    tagManufacturer = qobject_cast<TagManufacturer*>(tagDB.newTagManufacturer());
+    TagInfo*            tagInfo1        = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+    TagInfo*            tagInfo2        = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+    QVERIFY(tagManufacturer && tagInfo1 && tagInfo2);
+
+    uint32_t tagId1 = tagInfo1->id()->rawValue().toUInt();
+    uint32_t tagId2 = tagInfo2->id()->rawValue().toUInt();
+    QCOMPARE(tagId1, 2u);
+    QCOMPARE(tagId2, 4u);
+
+    // Fact edits are written through to the records
+    tagInfo2->frequencyHz()->setRawValue(150000000);
+    tagInfo2->selected()->setRawValue(1);
+    const TagRecord_t* tagRecord = tagDB.findTagRecord(tagId2);
+    QVERIFY(tagRecord);
+    QCOMPARE(tagRecord->frequencyHz, 150000000u);
+    QVERIFY(tagRecord->selected);
+    QCOMPARE(tagRecord->manufacturerId, tagManufacturer->id()->rawValue().toUInt());
+    QVERIFY(tagDB.findManufacturerRecord(tagRecord->manufacturerId));
+
+    // Ids belong to the database
+    tagInfo2->id()->setRawValue(100);
+    QCOMPARE(tagInfo2->id()->rawValue().toUInt(), tagId2);
+    QVERIFY(!tagDB.findTagRecord(100));
+
+    // A manufacturer in use can't be deleted
+    QVERIFY(!tagDB.deleteTagManufacturerListItem(tagManufacturer));
+
+    tagDB.deleteTagInfoListItem(tagInfo1);
+    QVERIFY(!tagDB.findTagRecord(tagId1));
+    QVERIFY(tagDB.findTagRecord(tagId2));
+    QCOMPARE(tagDB.tagRecords().count(), 1);
+    QCOMPARE(tagDB.tagInfoListModel()->count(), 1);
+}
+
+void TagDatabaseTest::_journal_test(void)
+{
+    QTemporaryDir dir;
+
+    {
+        TagDatabase tagDB(nullptr, dir.path());
+
+        tagDB.newTagManufacturer();
+        TagInfo* tagInfo1 = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+        TagInfo* tagInfo2 = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+        tagDB.newTagInfo();
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 4);
+        QVERIFY(QFile::exists(dir.filePath("TagDatabase.journal")));
+        QVERIFY(!QFile::exists(dir.filePath("TagInfo.db")));
+
+        // Nothing changed, nothing written
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 4);
+
+        // Only the changed records are appended
+        tagInfo1->name()->setRawValue(QStringLiteral("Renamed"));
+        tagDB.deleteTagInfoListItem(tagInfo2);
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 6);
+    }
+
+    // The journal is replayed at load and the Fact objects are only created when asked for
+    TagDatabase tagDB(nullptr, dir.path());
+    QCOMPARE(tagDB.tagRecords().count(), 2);
+    QCOMPARE(tagDB.manufacturerRecords().count(), 1);
+    QCOMPARE(tagDB.journalEntryCount(), 6);
+    QVERIFY(!tagDB.findChild<QmlObjectListModel*>());
+
+    QVERIFY(tagDB.findTagRecord(2));
+    QCOMPARE(tagDB.findTagRecord(2)->name, QStringLiteral("Renamed"));
+    QVERIFY(!tagDB.findTagRecord(4));
+    QVERIFY(tagDB.findTagRecord(6));
+
+    QCOMPARE(tagDB.tagInfoListModel()->count(), 2);
+    QCOMPARE(tagDB.tagInfoListModel()->value<TagInfo*>(0)->name()->rawValue().toString(), QStringLiteral("Renamed"));
+
+    // Ids continue after the loaded records
+    TagInfo* tagInfo = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+    QCOMPARE(tagInfo->id()->rawValue().toUInt(), 8u);
+}
+
+void TagDatabaseTest::_compact_test(void)
+{
+    QTemporaryDir   dir;
+    uint32_t        frequencyHz = 0;
+
+    {
+        TagDatabase tagDB(nullptr, dir.path());
+
+        tagDB.newTagManufacturer();
+        TagInfo* tagInfo = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+        tagDB.save();
+
+        // Repeated edits of the same record grow the journal until it is folded into the snapshot
+        int cSaves = 0;
+        while (tagDB.journalEntryCount() != 0) {
+            QVERIFY(cSaves++ <= TagDatabase::minCompactJournalEntries);
+            frequencyHz = 146000000 + cSaves;
+            tagInfo->frequencyHz()->setRawValue(frequencyHz);
+            tagDB.save();
+        }
+        QVERIFY(!QFile::exists(dir.filePath("TagDatabase.journal")));
+        QVERIFY(QFile::exists(dir.filePath("TagInfo.db")));
+        QVERIFY(QFile::exists(dir.filePath("TagManufacturer.db")));
+
+        tagInfo->selected()->setRawValue(1);
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 1);
+    }
+
+    // Snapshot plus journal loads back the same records
+    TagDatabase tagDB(nullptr, dir.path());
+    QCOMPARE(tagDB.tagRecords().count(), 1);
+    QVERIFY(tagDB.tagRecords()[0].selected);
+    QCOMPARE(tagDB.tagRecords()[0].frequencyHz, frequencyHz);
+}
+
+static QByteArray _readFile(const QString& filename)
+{
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+static void _writeFile(const QString& filename, const QByteArray& bytes)
+{
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(bytes), static_cast<qint64>(bytes.size()));
+}
+
+void TagDatabaseTest::_tornJournal_test(void)
+{
+    QTemporaryDir   dir;
+    QString         journalPath = dir.filePath("TagDatabase.journal");
+    uint32_t        frequencyHz = 0;
+
+    {
+        TagDatabase tagDB(nullptr, dir.path());
+
+        tagDB.newTagManufacturer();
+        tagDB.newTagInfo();
+        TagInfo* tagInfo = qobject_cast<TagInfo*>(tagDB.newTagInfo());
+        frequencyHz = tagInfo->frequencyHz()->rawValue().toUInt();
+        tagDB.save();
+        tagInfo->frequencyHz()->setRawValue(146123456);
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 4);
+    }
+
+    // A crash in the middle of the last append leaves part of a line, which would still parse with a truncated frequency
+    QByteArray journal = _readFile(journalPath);
+    QVERIFY(journal.endsWith(",146123456\n"));
+    journal.chop(QByteArray("456\n").size());
+    _writeFile(journalPath, journal);
+
+    {
+        TagDatabase tagDB(nullptr, dir.path());
+
+        QCOMPARE(tagDB.tagRecords().count(), 2);
+        QCOMPARE(tagDB.manufacturerRecords().count(), 1);
+        QCOMPARE(tagDB.journalEntryCount(), 3);
+        QVERIFY(tagDB.findTagRecord(2));
+        QVERIFY(tagDB.findTagRecord(4));
+        QCOMPARE(tagDB.findTagRecord(4)->frequencyHz, frequencyHz);
+
+        // Loading leaves the file alone
+        QCOMPARE(_readFile(journalPath), journal);
+
+        // The next save drops the torn tail before appending
+        qobject_cast<TagInfo*>(tagDB.tagInfoListModel()->get(1))->name()->setRawValue(QStringLiteral("Saved"));
+        tagDB.save();
+        QCOMPARE(tagDB.journalEntryCount(), 4);
+    }
+
+    TagDatabase tagDB(nullptr, dir.path());
+    QCOMPARE(tagDB.tagRecords().count(), 2);
+    QCOMPARE(tagDB.journalEntryCount(), 4);
+    QCOMPARE(tagDB.findTagRecord(4)->name, QStringLiteral("Saved"));
+    QCOMPARE(tagDB.findTagRecord(4)->frequencyHz, frequencyHz);
+}
+
+void TagDatabaseTest::_badJournal_test(void)
+{
+    QTemporaryDir   dir;
+    QString         manufacturerPath    = dir.filePath("TagManufacturer.db");
+    QString         tagInfoPath         = dir.filePath("TagInfo.db");
+    QString         journalPath         = dir.filePath("TagDatabase.journal");
+    QByteArray      manufacturerBytes   = "1,Acme,1000,1100,a,b,15,60,2\n";
+    QByteArray      tagInfoBytes        = "1,2,Alpha,1,146000000\n0,4,Beta,1,146100000\n";
+    QByteArray      goodJournalBytes    = "T,1,6,Gamma,1,146200000\n";
+    QByteArray      journalBytes        = goodJournalBytes + "T,1,8,Delta,1,notanumber\n-T,2\n";
+
+    _writeFile(manufacturerPath, manufacturerBytes);
+    _writeFile(tagInfoPath, tagInfoBytes);
+    _writeFile(journalPath, journalBytes);
+
+    {
+        TagDatabase tagDB(nullptr, dir.path());
+
+        // The snapshot and the journal up to the bad line survive, nothing after it is replayed
+        QCOMPARE(tagDB.manufacturerRecords().count(), 1);
+        QCOMPARE(tagDB.tagRecords().count(), 3);
+        QVERIFY(tagDB.findTagRecord(2));
+        QVERIFY(tagDB.findTagRecord(4));
+        QVERIFY(tagDB.findTagRecord(6));
+        QVERIFY(!tagDB.findTagRecord(8));
+        QCOMPARE(tagDB.journalEntryCount(), 1);
+
+        // Nothing to save leaves every file as it was
+        tagDB.save();
+        QCOMPARE(_readFile(manufacturerPath), manufacturerBytes);
+        QCOMPARE(_readFile(tagInfoPath), tagInfoBytes);
+        QCOMPARE(_readFile(journalPath), journalBytes);
+
+        // A save cuts the journal back to the last good entry and never rewrites the snapshot, even past the
+        // compaction threshold
+        TagInfo* tagInfo = qobject_cast<TagInfo*>(tagDB.tagInfoListModel()->get(0));
+        for (int i=0; i<=TagDatabase::minCompactJournalEntries; i++) {
+            tagInfo->frequencyHz()->setRawValue(147000000 + i);
+            tagDB.save();
+        }
+        QCOMPARE(_readFile(manufacturerPath), manufacturerBytes);
+        QCOMPARE(_readFile(tagInfoPath), tagInfoBytes);
+        QVERIFY(_readFile(journalPath).startsWith(goodJournalBytes + "T,1,2,Alpha,1,147000000\n"));
+    }
+
+    TagDatabase tagDB(nullptr, dir.path());
+    QCOMPARE(tagDB.tagRecords().count(), 3);
+    QCOMPARE(tagDB.findTagRecord(2)->frequencyHz, static_cast<uint32_t>(147000000 + TagDatabase::minCompactJournalEntries));
+    QCOMPARE(tagDB.journalEntryCount(), TagDatabase::minCompactJournalEntries + 2);
+}
+
+UT_REGISTER_TEST(TagDatabaseTest)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for TagDatabase
+class TagDatabaseTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _lookup_test       (void);
+    void _journal_test      (void);
+    void _compact_test      (void);
+    void _tornJournal_test  (void);
+    void _badJournal_test   (void);
+};
@@ -0,0 +1,109 @@
+#include "TagTriangulatorTest.h"
+#include "TagTriangulator.h"
+
+#include <QRandomGenerator>
+
+static const QGeoCoordinate _tagCoord(32.0, -110.0);
+
+// Rotation centers spread around the tag at a few hundred meters
+static QGeoCoordinate _rotationCenter(double azimuthFromTag, double distance)
+{
+    return _tagCoord.atDistanceAndAzimuth(distance, azimuthFromTag);
+}
+
+void TagTriangulatorTest::_singleBearing_test(void)
+{
+    TagTriangulator triangulator;
+
+    QGeoCoordinate center = _rotationCenter(0, 400);
+    triangulator.setBearing(triangulator.addRotation(center), center.azimuthTo(_tagCoord));
+
+    QCOMPARE(triangulator.bearingCount(), 1);
+    QVERIFY(!triangulator.valid());
+    QVERIFY(triangulator.ellipsePath().isEmpty());
+}
+
+void TagTriangulatorTest::_parallelBearings_test(void)
+{
+    TagTriangulator triangulator;
+
+    // Two rotations on the same line looking at the tag give no cross fix
+    QGeoCoordinate center1 = _rotationCenter(90, 400);
+    QGeoCoordinate center2 = _rotationCenter(90, 800);
+    triangulator.setBearing(triangulator.addRotation(center1), center1.azimuthTo(_tagCoord));
+    triangulator.setBearing(triangulator.addRotation(center2), center2.azimuthTo(_tagCoord));
+
+    QCOMPARE(triangulator.bearingCount(), 2);
+    QVERIFY(!triangulator.valid());
+}
+
+void TagTriangulatorTest::_exactIntersection_test(void)
+{
+    TagTriangulator triangulator;
+
+    QGeoCoordinate center1 = _rotationCenter(0, 400);
+    QGeoCoordinate center2 = _rotationCenter(90, 300);
+    triangulator.setBearing(triangulator.addRotation(center1), center1.azimuthTo(_tagCoord));
+    triangulator.setBearing(triangulator.addRotation(center2), center2.azimuthTo(_tagCoord));
+
+    QVERIFY(triangulator.valid());
+    QVERIFY(triangulator.estimate().distanceTo(_tagCoord) < 1.0);
+
+    // With two bearings the uncertainty comes from the a priori bearing accuracy so it must be non-zero
+    QVERIFY(triangulator.semiMajorMeters() > 0);
+    QVERIFY(triangulator.semiMinorMeters() > 0);
+    QVERIFY(triangulator.semiMajorMeters() >= triangulator.semiMinorMeters());
+    QVERIFY(triangulator.orientationDegrees() >= 0 && triangulator.orientationDegrees() < 180);
+
+    // Ellipse path surrounds the estimate at no more than the semi major distance
+    QVariantList path = triangulator.ellipsePath();
+    QVERIFY(!path.isEmpty());
+    for (const QVariant& point: path) {
+        QVERIFY(point.value<QGeoCoordinate>().distanceTo(triangulator.estimate()) <= triangulator.semiMajorMeters() + 1.0);
+    }
+}
+
+void TagTriangulatorTest::_replaceBearing_test(void)
+{
+    TagTriangulator triangulator;
+
+    QGeoCoordinate center1 = _rotationCenter(0, 400);
+    QGeoCoordinate center2 = _rotationCenter(120, 300);
+    QGeoCoordinate center3 = _rotationCenter(240, 500);
+    int rotation1 = triangulator.addRotation(center1);
+    int rotation2 = triangulator.addRotation(center2);
+    int rotation3 = triangulator.addRotation(center3);
+
+    triangulator.setBearing(rotation1, center1.azimuthTo(_tagCoord));
+    triangulator.setBearing(rotation2, center2.azimuthTo(_tagCoord));
+
+    // A bad in progress bearing which is then replaced must leave no trace in the estimate
+    triangulator.setBearing(rotation3, center3.azimuthTo(_tagCoord) + 45);
+    QVERIFY(triangulator.estimate().distanceTo(_tagCoord) > 1.0);
+    triangulator.setBearing(rotation3, center3.azimuthTo(_tagCoord));
+    QCOMPARE(triangulator.bearingCount(), 3);
+    QVERIFY(triangulator.estimate().distanceTo(_tagCoord) < 1.0);
+
+    // Cancelled rotation
+    triangulator.setBearing(rotation2, qQNaN());
+    QCOMPARE(triangulator.bearingCount(), 2);
+    QVERIFY(triangulator.valid());
+    QVERIFY(triangulator.estimate().distanceTo(_tagCoord) < 1.0);
+}
+
+void TagTriangulatorTest::_noisyBearings_test(void)
+{
+    TagTriangulator     triangulator;
+    QRandomGenerator    random(4321);
+
+    for (int i=0; i<20; i++) {
+        QGeoCoordinate  center  = _rotationCenter(random.bounded(360.0), 200 + random.bounded(400.0));
+        double          noise   = (random.bounded(2.0) - 1.0) * 3.0;
+        triangulator.setBearing(triangulator.addRotation(center), center.azimuthTo(_tagCoord) + noise);
+    }
+
+    QVERIFY(triangulator.valid());
+    QVERIFY(triangulator.estimate().distanceTo(_tagCoord) < triangulator.semiMajorMeters());
+}
+
+UT_REGISTER_TEST(TagTriangulatorTest)
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for TagTriangulator
+class TagTriangulatorTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _singleBearing_test        (void);
+    void _parallelBearings_test     (void);
+    void _exactIntersection_test    (void);
+    void _replaceBearing_test       (void);
+    void _noisyBearings_test        (void);
+};
@@ -0,0 +1,178 @@
+#include "TunnelCommandQueueTest.h"
+#include "TunnelCommandQueue.h"
+#include "TunnelProtocol.h"
+
+#include <QSignalSpy>
+
+using namespace TunnelProtocol;
+
+// Payload is the header followed by a marker byte so individual sends can be told apart
+static QByteArray _payload(uint32_t command, char marker)
+{
+    HeaderInfo_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.command = command;
+
+    return QByteArray(reinterpret_cast<const char*>(&header), sizeof(header)) + marker;
+}
+
+static char _marker(const QByteArray& payload)
+{
+    return payload.at(payload.size() - 1);
+}
+
+void TunnelCommandQueueTest::_overlap_test(void)
+{
+    QList<QByteArray>   sent;
+    TunnelCommandQueue  queue([&sent](const QByteArray& payload) { sent.append(payload); return true; });
+
+    const QList<uint32_t> commands = { COMMAND_ID_TAG, COMMAND_ID_START_DETECTION, COMMAND_ID_STOP_DETECTION, COMMAND_ID_RAW_CAPTURE };
+    for (int i=0; i<commands.count(); i++) {
+        queue.enqueue(_payload(commands[i], 'a' + i), true /* pipelined */);
+    }
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'e'), true);
+    queue.enqueue(_payload(COMMAND_ID_START_ROTATION, 'f'), true);
+
+    // Commands with different ids go out together, the second tag waits for the ack of the first
+    QCOMPARE(sent.count(), commands.count());
+    QCOMPARE(queue.inFlightCount(), commands.count());
+
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(sent.count(), commands.count() + 2);
+    QCOMPARE(_marker(sent[commands.count()]), 'e');
+
+    for (int i=1; i<commands.count(); i++) {
+        QVERIFY(queue.handleAck(commands[i], COMMAND_RESULT_SUCCESS));
+    }
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QVERIFY(queue.handleAck(COMMAND_ID_START_ROTATION, COMMAND_RESULT_SUCCESS));
+
+    QVERIFY(queue.idle());
+    QCOMPARE(queue.stats(COMMAND_ID_TAG).ackCount, 2u);
+    QCOMPARE(queue.stats(COMMAND_ID_TAG).retransmitCount, 0u);
+    QVERIFY(!queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+}
+
+void TunnelCommandQueueTest::_barrier_test(void)
+{
+    QList<QByteArray>   sent;
+    TunnelCommandQueue  queue([&sent](const QByteArray& payload) { sent.append(payload); return true; });
+
+    queue.enqueue(_payload(COMMAND_ID_START_TAGS, 's'));
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'a'), true);
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'b'), true);
+    queue.enqueue(_payload(COMMAND_ID_END_TAGS, 'e'));
+
+    // Nothing goes out behind a barrier
+    QCOMPARE(sent.count(), 1);
+
+    // Tags go one at a time since their acks can't be told apart
+    QVERIFY(queue.handleAck(COMMAND_ID_START_TAGS, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(sent.count(), 2);
+    QCOMPARE(_marker(sent.last()), 'a');
+
+    // End barrier waits for both tags
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(sent.count(), 3);
+    QCOMPARE(_marker(sent.last()), 'b');
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(sent.count(), 4);
+    QCOMPARE(_marker(sent.last()), 'e');
+}
+
+void TunnelCommandQueueTest::_selectiveRetransmit_test(void)
+{
+    QList<QByteArray>   sent;
+    TunnelCommandQueue  queue([&sent](const QByteArray& payload) { sent.append(payload); return true; });
+
+    queue.setAckTimeoutRange(50, 50);
+
+    queue.enqueue(_payload(COMMAND_ID_START_DETECTION, 'd'));
+    QCOMPARE(sent.count(), 1);
+
+    // Lost ack, only the command which timed out is resent
+    QTRY_COMPARE_WITH_TIMEOUT(sent.count(), 2, 1000);
+    QCOMPARE(_marker(sent.last()), 'd');
+    QCOMPARE(queue.stats(COMMAND_ID_START_DETECTION).retransmitCount, 1u);
+
+    QSignalSpy ackSpy(&queue, &TunnelCommandQueue::commandAcked);
+    QVERIFY(queue.handleAck(COMMAND_ID_START_DETECTION, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(ackSpy.count(), 1);
+    QVERIFY(queue.idle());
+}
+
+void TunnelCommandQueueTest::_sameCommand_test(void)
+{
+    QList<QByteArray>   sent;
+    TunnelCommandQueue  queue([&sent](const QByteArray& payload) { sent.append(payload); return true; });
+    QSignalSpy          ackSpy(&queue, &TunnelCommandQueue::commandAcked);
+
+    queue.setAckTimeoutRange(50, 50);
+
+    uint32_t firstSequenceId = queue.enqueue(_payload(COMMAND_ID_TAG, 'a'), true);
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'b'), true);
+    QCOMPARE(queue.inFlightCount(), 1);
+
+    // A lost command is resent on its own, nothing else goes out in the meantime
+    QTRY_COMPARE_WITH_TIMEOUT(sent.count(), 2, 1000);
+    QCOMPARE(_marker(sent[1]), 'a');
+    QCOMPARE(queue.inFlightCount(), 1);
+
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(ackSpy.count(), 1);
+    QCOMPARE(ackSpy[0][0].toUInt(), firstSequenceId);
+    QCOMPARE(sent.count(), 3);
+    QCOMPARE(_marker(sent[2]), 'b');
+
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(ackSpy.count(), 2);
+    QVERIFY(ackSpy[1][0].toUInt() != firstSequenceId);
+    QCOMPARE(queue.stats(COMMAND_ID_TAG).ackCount, 2u);
+    QCOMPARE(queue.stats(COMMAND_ID_TAG).retransmitCount, 1u);
+    QVERIFY(queue.idle());
+}
+
+void TunnelCommandQueueTest::_minSendInterval_test(void)
+{
+    QList<QByteArray>   sent;
+    TunnelCommandQueue  queue([&sent](const QByteArray& payload) { sent.append(payload); return true; });
+
+    queue.setMinSendInterval(COMMAND_ID_TAG, 100);
+
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'a'), true);
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'b'), true);
+    QCOMPARE(sent.count(), 1);
+
+    // The next tag waits out the interval after the ack
+    QElapsedTimer ackTimer;
+    ackTimer.start();
+    QVERIFY(queue.handleAck(COMMAND_ID_TAG, COMMAND_RESULT_SUCCESS));
+    QCOMPARE(sent.count(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(sent.count(), 2, 1000);
+    QVERIFY(ackTimer.elapsed() >= 90);
+    QCOMPARE(_marker(sent.last()), 'b');
+}
+
+void TunnelCommandQueueTest::_failure_test(void)
+{
+    TunnelCommandQueue queue([](const QByteArray&) { return true; });
+
+    queue.setAckTimeoutRange(20, 20);
+    queue.setMaxRetries(2);
+
+    QSignalSpy failedSpy(&queue, &TunnelCommandQueue::commandFailed);
+
+    queue.enqueue(_payload(COMMAND_ID_START_TAGS, 's'));
+    queue.enqueue(_payload(COMMAND_ID_TAG, 'a'), true);
+
+    QTRY_COMPARE_WITH_TIMEOUT(failedSpy.count(), 1, 1000);
+    QCOMPARE(failedSpy[0][1].toUInt(), static_cast<uint>(COMMAND_ID_START_TAGS));
+    QCOMPARE(queue.stats(COMMAND_ID_START_TAGS).failedCount, 1u);
+    QCOMPARE(queue.stats(COMMAND_ID_START_TAGS).retransmitCount, 2u);
+
+    // Everything behind the failed command is dropped
+    QVERIFY(queue.idle());
+}
+
+UT_REGISTER_TEST(TunnelCommandQueueTest)
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for TunnelCommandQueue
+class TunnelCommandQueueTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _overlap_test              (void);
+    void _barrier_test              (void);
+    void _selectiveRetransmit_test  (void);
+    void _sameCommand_test          (void);
+    void _minSendInterval_test      (void);
+    void _failure_test              (void);
+};
@@ -427,6 +427,7 @@ HEADERS += \
     src/AnalyzeView/PX4LogParser.h \
     src/AnalyzeView/ULogParser.h \
     src/AnalyzeView/MavlinkConsoleController.h \
+    src/AnalyzeView/MAVLinkProfilerController.h \
     src/Audio/AudioOutput.h \
     src/Vehicle/Autotune.h \
     src/Camera/MavlinkCameraControl.h \
@@ -505,6 +506,7 @@ HEADERS += \
     src/QmlControls/QGCMapPalette.h \
     src/QmlControls/QGCPalette.h \
     src/Utilities/QGCQGeoCoordinate.h \
+    src/Utilities/QGCSPSCQueue.h \
     src/Utilities/QGCTemporaryFile.h \
     src/QGCToolbox.h \
     src/QmlControls/AppMessages.h \
@@ -566,6 +568,7 @@ HEADERS += \
     src/Vehicle/ComponentInformationManager.h \
     src/Vehicle/ComponentInformationTranslation.h \
     src/Vehicle/EventHandler.h \
+    src/Vehicle/FTPBulkDownload.h \
     src/Vehicle/FTPManager.h \
     src/Vehicle/GPSRTKFactGroup.h \
     src/Vehicle/HealthAndArmingCheckReport.h \
@@ -604,6 +607,13 @@ HEADERS += \
     src/comm/LinkInterface.h \
     src/comm/LinkManager.h \
     src/comm/LogReplayLink.h \
+    src/comm/MAVLinkForwardRouter.h \
+    src/comm/MAVLinkFrameParser.h \
+    src/comm/MAVLinkIngest.h \
+    src/comm/MAVLinkLogIndex.h \
+    src/comm/MAVLinkLogWriter.h \
+    src/comm/MAVLinkMessageDispatcher.h \
+    src/comm/MAVLinkProfiler.h \
     src/comm/MAVLinkProtocol.h \
     src/comm/QGCMAVLink.h \
     src/comm/TCPLink.h \
@@ -690,6 +700,7 @@ SOURCES += \
     src/AnalyzeView/PX4LogParser.cc \
     src/AnalyzeView/ULogParser.cc \
     src/AnalyzeView/MavlinkConsoleController.cc \
+    src/AnalyzeView/MAVLinkProfilerController.cc \
     src/Audio/AudioOutput.cc \
     src/Vehicle/Autotune.cpp \
     src/Camera/MavlinkCameraControl.cc \
@@ -825,6 +836,7 @@ SOURCES += \
     src/Vehicle/ComponentInformationManager.cc \
     src/Vehicle/ComponentInformationTranslation.cc \
     src/Vehicle/EventHandler.cc \
+    src/Vehicle/FTPBulkDownload.cc \
     src/Vehicle/FTPManager.cc \
     src/Vehicle/GPSRTKFactGroup.cc \
     src/Vehicle/HealthAndArmingCheckReport.cc \
@@ -863,6 +875,13 @@ SOURCES += \
     src/comm/LinkInterface.cc \
     src/comm/LinkManager.cc \
     src/comm/LogReplayLink.cc \
+    src/comm/MAVLinkForwardRouter.cc \
+    src/comm/MAVLinkFrameParser.cc \
+    src/comm/MAVLinkIngest.cc \
+    src/comm/MAVLinkLogIndex.cc \
+    src/comm/MAVLinkLogWriter.cc \
+    src/comm/MAVLinkMessageDispatcher.cc \
+    src/comm/MAVLinkProfiler.cc \
     src/comm/MAVLinkProtocol.cc \
     src/comm/QGCMAVLink.cc \
     src/comm/TCPLink.cc \
@@ -117,9 +117,9 @@ bool AirlinkLink::_connect()
         }
     });
     MAVLinkProtocol *mavlink = qgcApp()->toolbox()->mavlinkProtocol();
-    auto conn = std::make_shared<QMetaObject::Connection>();
-    *conn = connect(mavlink, &MAVLinkProtocol::messageReceived, [this, conn] (LinkInterface* linkSrc, mavlink_message_t message) {
-        if (this != linkSrc || message.msgid != MAVLINK_MSG_ID_AIRLINK_AUTH_RESPONSE) {
+    auto subscriptionId = std::make_shared<int>();
+    *subscriptionId = mavlink->subscribe(MAVLINK_MSG_ID_AIRLINK_AUTH_RESPONSE, this, [this, mavlink, subscriptionId] (LinkInterface* linkSrc, const mavlink_message_t& message) {
+        if (this != linkSrc) {
             return;
         }
         mavlink_airlink_auth_response_t responseMsg;
@@ -130,7 +130,7 @@ bool AirlinkLink::_connect()
             return;
         }
         qDebug() << "Connected successfully";
-        QObject::disconnect(*conn);
+        mavlink->unsubscribe(*subscriptionId);
         _setConnectFlag(false);
     });
     _setConnectFlag(true);
@@ -0,0 +1,131 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkProfilerController.h"
+#include "MAVLinkProfiler.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "MAVLinkProtocol.h"
+#include "QGCApplication.h"
+
+#include <QVariantMap>
+
+MAVLinkProfilerController::MAVLinkProfilerController()
+    : _profiler(qgcApp()->toolbox()->mavlinkProtocol()->profiler())
+{
+    connect(_profiler, &MAVLinkProfiler::sampled, this, &MAVLinkProfilerController::sampled);
+}
+
+void MAVLinkProfilerController::reset(void)
+{
+    _profiler->reset();
+}
+
+QString MAVLinkProfilerController::saveJson(const QString& fileName)
+{
+    QString errorString;
+    if (!_profiler->saveJson(fileName, errorString)) {
+        return errorString;
+    }
+    return QString();
+}
+
+QVariantList MAVLinkProfilerController::links(void) const
+{
+    QVariantList list;
+    for (const MAVLinkProfiler::LinkStats_t& stats: _profiler->linkStats()) {
+        QVariantMap map;
+        map[QStringLiteral("name")]                 = stats.name;
+        map[QStringLiteral("messages")]             = stats.messages;
+        map[QStringLiteral("messagesPerSec")]       = stats.messagesPerSec;
+        map[QStringLiteral("rxBytesPerSec")]        = stats.rxBytesPerSec;
+        map[QStringLiteral("txBytesPerSec")]        = stats.txBytesPerSec;
+        map[QStringLiteral("pendingWriteBytes")]    = stats.pendingWriteBytes;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantList MAVLinkProfilerController::messages(void) const
+{
+    QVariantList list;
+    for (const MAVLinkProfiler::MessageStats_t& stats: _profiler->messageStats()) {
+        QVariantMap map;
+        map[QStringLiteral("msgid")]            = stats.msgid;
+        map[QStringLiteral("name")]             = stats.name;
+        map[QStringLiteral("count")]            = stats.count;
+        map[QStringLiteral("messagesPerSec")]   = stats.messagesPerSec;
+        map[QStringLiteral("bytesPerSec")]      = stats.bytesPerSec;
+        map[QStringLiteral("avgUsecs")]         = stats.timedCount ? stats.timedNsecs / 1000.0 / stats.timedCount : 0.0;
+        map[QStringLiteral("maxUsecs")]         = stats.maxNsecs / 1000.0;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantList MAVLinkProfilerController::handlers(void) const
+{
+    QVariantList list;
+    for (const MAVLinkProfiler::HandlerStats_t& stats: _profiler->handlerStats()) {
+        QVariantMap map;
+        map[QStringLiteral("owner")]        = stats.owner;
+        map[QStringLiteral("name")]         = stats.name;
+        map[QStringLiteral("msgid")]        = stats.msgid;
+        map[QStringLiteral("allMessages")]  = stats.msgid == MAVLinkMessageDispatcher::allMessages;
+        map[QStringLiteral("calls")]        = stats.calls;
+        map[QStringLiteral("avgUsecs")]     = stats.calls ? stats.totalNsecs / 1000.0 / stats.calls : 0.0;
+        map[QStringLiteral("maxUsecs")]     = stats.maxNsecs / 1000.0;
+        map[QStringLiteral("cpuPercent")]   = stats.cpuPercent;
+        list.append(map);
+    }
+    return list;
+}
+
+QVariantList MAVLinkProfilerController::history(void) const
+{
+    QVariantList list;
+    for (const MAVLinkProfiler::Sample_t& sample: _profiler->history()) {
+        list.append(sample.messagesPerSec);
+    }
+    return list;
+}
+
+double MAVLinkProfilerController::messagesPerSec(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().messagesPerSec;
+}
+
+double MAVLinkProfilerController::rxBytesPerSec(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().rxBytesPerSec;
+}
+
+double MAVLinkProfilerController::txBytesPerSec(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().txBytesPerSec;
+}
+
+double MAVLinkProfilerController::handlerCpuPercent(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().handlerCpuPercent;
+}
+
+int MAVLinkProfilerController::ingestQueueDepth(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : static_cast<int>(_profiler->history().last().queueDepths.ingestQueueDepth);
+}
+
+qint64 MAVLinkProfilerController::ingestBacklogBytes(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().queueDepths.ingestBacklogBytes;
+}
+
+qint64 MAVLinkProfilerController::pendingWriteBytes(void) const
+{
+    return _profiler->history().isEmpty() ? 0 : _profiler->history().last().pendingWriteBytes;
+}
@@ -0,0 +1,60 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+
+class MAVLinkProfiler;
+
+/// Controller for MAVLinkProfilerPage.qml. Refreshed each time the profiler samples.
+class MAVLinkProfilerController : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkProfilerController();
+
+    Q_PROPERTY(QVariantList links               READ links              NOTIFY sampled)
+    Q_PROPERTY(QVariantList messages            READ messages           NOTIFY sampled)
+    Q_PROPERTY(QVariantList handlers            READ handlers           NOTIFY sampled)
+    Q_PROPERTY(QVariantList history             READ history            NOTIFY sampled)     ///< Messages per second
+    Q_PROPERTY(double       messagesPerSec      READ messagesPerSec     NOTIFY sampled)
+    Q_PROPERTY(double       rxBytesPerSec       READ rxBytesPerSec      NOTIFY sampled)
+    Q_PROPERTY(double       txBytesPerSec       READ txBytesPerSec      NOTIFY sampled)
+    Q_PROPERTY(double       handlerCpuPercent   READ handlerCpuPercent  NOTIFY sampled)
+    Q_PROPERTY(int          ingestQueueDepth    READ ingestQueueDepth   NOTIFY sampled)
+    Q_PROPERTY(qint64       ingestBacklogBytes  READ ingestBacklogBytes NOTIFY sampled)
+    Q_PROPERTY(qint64       pendingWriteBytes   READ pendingWriteBytes  NOTIFY sampled)
+
+    Q_INVOKABLE void reset(void);
+
+    /// @return Error string, empty if the profile was saved
+    Q_INVOKABLE QString saveJson(const QString& fileName);
+
+    QVariantList    links               (void) const;
+    QVariantList    messages            (void) const;
+    QVariantList    handlers            (void) const;
+    QVariantList    history             (void) const;
+    double          messagesPerSec      (void) const;
+    double          rxBytesPerSec       (void) const;
+    double          txBytesPerSec       (void) const;
+    double          handlerCpuPercent   (void) const;
+    int             ingestQueueDepth    (void) const;
+    qint64          ingestBacklogBytes  (void) const;
+    qint64          pendingWriteBytes   (void) const;
+
+signals:
+    void sampled(void);
+
+private:
+    MAVLinkProfiler* _profiler;
+};
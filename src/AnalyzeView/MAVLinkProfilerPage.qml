@@ -0,0 +1,205 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+import QtQuick
+import QtQuick.Controls
+import QtQuick.Dialogs
+import QtQuick.Layouts
+
+import QGroundControl
+import QGroundControl.Palette
+import QGroundControl.Controls
+import QGroundControl.Controllers
+import QGroundControl.ScreenTools
+
+AnalyzePage {
+    id:                 root
+    headerComponent:    headerComponent
+    pageComponent:      pageComponent
+    allowPopout:        true
+
+    property real _nameWidth:       ScreenTools.defaultFontPixelWidth * 30
+    property real _valueWidth:      ScreenTools.defaultFontPixelWidth * 12
+    property real _historyHeight:   ScreenTools.defaultFontPixelHeight * 4
+
+    function _rate(value) {
+        return value.toFixed(value < 10 ? 1 : 0)
+    }
+
+    function _bytesRate(value) {
+        return value < 1024 ? qsTr("%1 B/s").arg(value.toFixed(0)) : qsTr("%1 KB/s").arg((value / 1024).toFixed(1))
+    }
+
+    MAVLinkProfilerController {
+        id: controller
+    }
+
+    QGCPalette { id: qgcPal; colorGroupEnabled: true }
+
+    Component {
+        id: headerComponent
+
+        RowLayout {
+            anchors.left:   parent.left
+            anchors.right:  parent.right
+
+            QGCLabel {
+                Layout.fillWidth:   true
+                text:               qsTr("Profile MAVLink throughput and message handling.")
+            }
+            QGCButton {
+                text:       qsTr("Reset")
+                onClicked:  controller.reset()
+            }
+            QGCButton {
+                text:       qsTr("Save JSON")
+                onClicked:  saveFileDialog.openForSave()
+            }
+        }
+    }
+
+    QGCFileDialog {
+        id:             saveFileDialog
+        title:          qsTr("Save Profile")
+        folder:         QGroundControl.settingsManager.appSettings.logSavePath
+        nameFilters:    [qsTr("JSON files (*.json)")]
+        defaultSuffix:  "json"
+        onAcceptedForSave: (file) => {
+            var errorString = controller.saveJson(file)
+            if (errorString !== "") {
+                mainWindow.showMessageDialog(qsTr("Save Profile"), errorString)
+            }
+            close()
+        }
+    }
+
+    Component {
+        id: pageComponent
+
+        QGCFlickable {
+            width:          availableWidth
+            height:         availableHeight
+            contentHeight:  pageColumn.height
+            contentWidth:   pageColumn.width
+
+            Column {
+                id:         pageColumn
+                spacing:    ScreenTools.defaultFontPixelHeight
+
+                GridLayout {
+                    columns:        4
+                    columnSpacing:  ScreenTools.defaultFontPixelWidth * 2
+
+                    QGCLabel { text: qsTr("Messages:") }
+                    QGCLabel { text: qsTr("%1/s").arg(_rate(controller.messagesPerSec)) }
+                    QGCLabel { text: qsTr("Handler CPU:") }
+                    QGCLabel { text: qsTr("%1%").arg(controller.handlerCpuPercent.toFixed(1)) }
+                    QGCLabel { text: qsTr("Received:") }
+                    QGCLabel { text: _bytesRate(controller.rxBytesPerSec) }
+                    QGCLabel { text: qsTr("Sent:") }
+                    QGCLabel { text: _bytesRate(controller.txBytesPerSec) }
+                    QGCLabel { text: qsTr("Ingest queue:") }
+                    QGCLabel { text: qsTr("%1 messages, %2 bytes").arg(controller.ingestQueueDepth).arg(controller.ingestBacklogBytes) }
+                    QGCLabel { text: qsTr("Pending writes:") }
+                    QGCLabel { text: qsTr("%1 bytes").arg(controller.pendingWriteBytes) }
+                }
+
+                // Messages per second over the history, scaled to the busiest sample
+                Row {
+                    id:     historyRow
+                    height: _historyHeight
+                    spacing: 1
+
+                    property real _maxValue: Math.max.apply(null, controller.history.concat([1]))
+
+                    Repeater {
+                        model: controller.history
+
+                        Rectangle {
+                            anchors.bottom: parent.bottom
+                            width:          Math.max(1, ScreenTools.defaultFontPixelWidth / 4)
+                            height:         Math.max(1, _historyHeight * modelData / historyRow._maxValue)
+                            color:          qgcPal.colorGreen
+                        }
+                    }
+                }
+
+                QGCLabel { text: qsTr("Links"); font.bold: true }
+                Column {
+                    RowLayout {
+                        QGCLabel { Layout.preferredWidth: _nameWidth;   text: qsTr("Name") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Msgs/s") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Rx") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Tx") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Pending") }
+                    }
+                    Repeater {
+                        model: controller.links
+
+                        RowLayout {
+                            QGCLabel { Layout.preferredWidth: _nameWidth;   text: modelData.name; elide: Text.ElideRight }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: _rate(modelData.messagesPerSec) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: _bytesRate(modelData.rxBytesPerSec) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: _bytesRate(modelData.txBytesPerSec) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.pendingWriteBytes }
+                        }
+                    }
+                }
+
+                QGCLabel { text: qsTr("Messages"); font.bold: true }
+                Column {
+                    RowLayout {
+                        QGCLabel { Layout.preferredWidth: _nameWidth;   text: qsTr("Name") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Count") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Msgs/s") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Bytes/s") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Avg µs") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Max µs") }
+                    }
+                    Repeater {
+                        model: controller.messages
+
+                        RowLayout {
+                            QGCLabel { Layout.preferredWidth: _nameWidth;   text: qsTr("%1 (%2)").arg(modelData.name).arg(modelData.msgid); elide: Text.ElideRight }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.count }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: _rate(modelData.messagesPerSec) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.bytesPerSec.toFixed(0) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.avgUsecs.toFixed(1) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.maxUsecs.toFixed(1) }
+                        }
+                    }
+                }
+
+                QGCLabel { text: qsTr("Handlers"); font.bold: true }
+                Column {
+                    RowLayout {
+                        QGCLabel { Layout.preferredWidth: _nameWidth;   text: qsTr("Name") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Msg id") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Calls") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Avg µs") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("Max µs") }
+                        QGCLabel { Layout.preferredWidth: _valueWidth;  text: qsTr("CPU %") }
+                    }
+                    Repeater {
+                        model: controller.handlers
+
+                        RowLayout {
+                            QGCLabel { Layout.preferredWidth: _nameWidth;   text: qsTr("%1: %2").arg(modelData.owner).arg(modelData.name); elide: Text.ElideRight }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.allMessages ? qsTr("All") : modelData.msgid }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.calls }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.avgUsecs.toFixed(1) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.maxUsecs.toFixed(1) }
+                            QGCLabel { Layout.preferredWidth: _valueWidth;  text: modelData.cpuPercent.toFixed(2) }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
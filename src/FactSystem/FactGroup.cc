@@ -9,6 +9,7 @@
 
 
 #include "FactGroup.h"
+#include "MAVLinkMessageDispatcher.h"
 
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -181,6 +182,11 @@ void FactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_t& /* mess
     // Default implementation does nothing
 }
 
+QList<uint32_t> FactGroup::handledMessageIds(void) const
+{
+    return { MAVLinkMessageDispatcher::allMessages };
+}
+
 void FactGroup::_setTelemetryAvailable (bool telemetryAvailable)
 {
     if (telemetryAvailable != _telemetryAvailable) {
@@ -53,6 +53,10 @@ public:
     /// Allows a FactGroup to parse incoming messages and fill in values
     virtual void handleMessage(Vehicle* vehicle, mavlink_message_t& message);
 
+    /// @return Message ids which handleMessage should be called for. The default of every message suits FactGroups
+    ///         which don't say, override to only be called for the messages handled.
+    virtual QList<uint32_t> handledMessageIds(void) const;
+
 signals:
     void factNamesChanged           (void);
     void factGroupNamesChanged      (void);
@@ -39,6 +39,7 @@
 #include "CmdLineOptParser.h"
 #include "UDPLink.h"
 #include "LinkManager.h"
+#include "MAVLinkLogIndex.h"
 #include "UASMessageHandler.h"
 #include "QGCTemporaryFile.h"
 #include "QGCPalette.h"
@@ -90,6 +91,7 @@
 #include "QGCFileDownload.h"
 #include "FirmwareImage.h"
 #include "MavlinkConsoleController.h"
+#include "MAVLinkProfilerController.h"
 #include "GeoTagController.h"
 #include "LogReplayLink.h"
 #include "VehicleObjectAvoidance.h"
@@ -499,6 +501,7 @@ void QGCApplication::_initCommon()
 #endif
     qmlRegisterType<GeoTagController>               (kQGCControllers,                       1, 0, "GeoTagController");
     qmlRegisterType<MavlinkConsoleController>       (kQGCControllers,                       1, 0, "MavlinkConsoleController");
+    qmlRegisterType<MAVLinkProfilerController>      (kQGCControllers,                       1, 0, "MAVLinkProfilerController");
 #if !defined(QGC_DISABLE_MAVLINK_INSPECTOR)
     qmlRegisterType<MAVLinkInspectorController>     (kQGCControllers,                       1, 0, "MAVLinkInspectorController");
 #endif
@@ -658,9 +661,13 @@ void QGCApplication::saveTelemetryLogOnMainThread(QString tempLogfile)
         if (!tempFile.copy(saveFilePath)) {
             QString error = tr("Unable to save telemetry log. Error copying telemetry to '%1': '%2'.").arg(saveFilePath).arg(tempFile.errorString());
             showAppMessage(error);
+        } else {
+            // The index only speeds up replay, the log is still usable without it
+            QFile::copy(MAVLinkLogIndex::indexFileName(tempLogfile), MAVLinkLogIndex::indexFileName(saveFilePath));
         }
     }
     QFile::remove(tempLogfile);
+    QFile::remove(MAVLinkLogIndex::indexFileName(tempLogfile));
 }
 
 void QGCApplication::checkTelemetrySavePathOnMainThread()
@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// Bounded lock-free queue for exactly one producer thread and one consumer thread. Entries are written and read in
+/// place, so large entries are never copied:
+///     Producer: entry = reserve(); fill *entry; commit();
+///     Consumer: entry = front(); use *entry; popFront();
+/// The capacity is rounded up to a power of two.
+template <typename T>
+class QGCSPSCQueue
+{
+public:
+    QGCSPSCQueue(size_t capacity)
+        : _capacity (_roundUpPowerOfTwo(capacity))
+        , _mask     (_capacity - 1)
+        , _entries  (_capacity)
+    {
+
+    }
+
+    QGCSPSCQueue(const QGCSPSCQueue&) = delete;
+    QGCSPSCQueue& operator=(const QGCSPSCQueue&) = delete;
+
+    /// Producer only
+    /// @return Next free entry, nullptr if the queue is full. The entry is not visible to the consumer until commit.
+    T* reserve(void)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _headCache == _capacity) {
+            _headCache = _head.load(std::memory_order_acquire);
+            if (tail - _headCache == _capacity) {
+                return nullptr;
+            }
+        }
+        return &_entries[tail & _mask];
+    }
+
+    /// Producer only. Publishes the entry returned by reserve.
+    void commit(void)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Consumer only
+    /// @return Oldest entry, nullptr if the queue is empty. The entry stays valid until popFront.
+    T* front(void)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tailCache) {
+            _tailCache = _tail.load(std::memory_order_acquire);
+            if (head == _tailCache) {
+                return nullptr;
+            }
+        }
+        return &_entries[head & _mask];
+    }
+
+    /// Consumer only. Releases the entry returned by front back to the producer.
+    void popFront(void)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Approximate when called while the other thread is active
+    size_t count(void) const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+
+    size_t capacity(void) const { return _capacity; }
+
+private:
+    static size_t _roundUpPowerOfTwo(size_t value)
+    {
+        size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static constexpr size_t _cacheLineSize = 64;
+
+    const size_t    _capacity;
+    const size_t    _mask;
+    std::vector<T>  _entries;
+
+    // Each side owns its index and keeps a stale copy of the other side's index so it only touches the shared cache
+    // line when it looks full or empty.
+    alignas(_cacheLineSize) std::atomic<size_t> _head       { 0 };
+    size_t                                      _tailCache  = 0;    ///< Consumer's copy of _tail
+    alignas(_cacheLineSize) std::atomic<size_t> _tail       { 0 };
+    size_t                                      _headCache  = 0;    ///< Producer's copy of _head
+};
@@ -0,0 +1,819 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FTPBulkDownload.h"
+#include "MAVLinkProtocol.h"
+#include "Vehicle.h"
+#include "QGCApplication.h"
+#include "QGCLoggingCategory.h"
+
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include <array>
+
+QGC_LOGGING_CATEGORY(FTPBulkDownloadLog, "FTPBulkDownloadLog")
+
+const char* FTPBulkDownload::manifestFileName = ".ftpmanifest.json";
+
+FTPBulkDownload::FTPBulkDownload(Vehicle* vehicle, QObject* parent)
+    : QObject   (parent)
+    , _vehicle  (vehicle)
+{
+    // Mock link responds immediately if at all, speed up unit tests with faster timeout
+    _ackTimeoutMsecs = qgcApp()->runningUnitTests() ? 50 : _defaultAckTimeoutMsecs;
+
+    _clock.start();
+    _timeoutTimer.setSingleShot(true);
+    connect(&_timeoutTimer, &QTimer::timeout, this, &FTPBulkDownload::_checkTimeouts);
+}
+
+FTPBulkDownload::~FTPBulkDownload()
+{
+    qDeleteAll(_transfers);
+}
+
+bool FTPBulkDownload::start(uint8_t compId, const QString& fromDir, const QStringList& fileNames, const QString& toDir, int maxSessions, uint16_t seqNumber)
+{
+    if (_inProgress) {
+        qCDebug(FTPBulkDownloadLog) << "Cannot start. Already in progress";
+        return false;
+    }
+    if (!QDir(toDir).exists()) {
+        qCWarning(FTPBulkDownloadLog) << "Download directory does not exist" << toDir;
+        return false;
+    }
+
+    _compId         = compId;
+    _fromDir        = fromDir;
+    _toDir.setPath(toDir);
+    _maxSessions    = qMax(1, maxSessions);
+    _nextSeqNumber  = seqNumber;
+    _inProgress     = true;
+
+    _files.clear();
+    for (const QString& fileName: fileNames) {
+        File_t file;
+        file.name = fileName;
+        _files.append(file);
+    }
+
+    if (_loadManifest()) {
+        qCDebug(FTPBulkDownloadLog) << "Resuming from manifest";
+    }
+
+    qCDebug(FTPBulkDownloadLog) << "start - fromDir:toDir:fileCount:maxSessions" << fromDir << toDir << _files.count() << _maxSessions;
+
+    _startTransfers();
+    _finishIfDone();
+
+    return true;
+}
+
+void FTPBulkDownload::cancel(void)
+{
+    if (!_inProgress) {
+        return;
+    }
+
+    for (Transfer_t* transfer: _transfers) {
+        // Best effort, there is no one left to handle the ack
+        if (transfer->state != StateOpen && transfer->state != StateChecksum) {
+            _sendTerminate(transfer);
+        }
+        transfer->file.close();
+        _files[transfer->fileIndex].active = false;
+    }
+    _saveManifest();
+
+    qDeleteAll(_transfers);
+    _transfers.clear();
+    _timeoutTimer.stop();
+    _inProgress = false;
+
+    emit complete(tr("Aborted"));
+}
+
+void FTPBulkDownload::mavlinkMessageReceived(const MavlinkFTP::Request* response)
+{
+    // Requests must never reuse a sequence number the server has replied with, otherwise it will treat them as a
+    // retry and resend its last reply
+    uint16_t seqNumber = response->hdr.seqNumber;
+    if (static_cast<int16_t>(static_cast<uint16_t>(seqNumber + 1) - _nextSeqNumber) > 0) {
+        _nextSeqNumber = seqNumber + 1;
+    }
+
+    Transfer_t* transfer = _transferForResponse(response);
+    if (!transfer) {
+        qCDebug(FTPBulkDownloadLog) << "Disregarding response with no matching transfer - req_opcode:session:seqNumber"
+                                    << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(response->hdr.req_opcode))
+                                    << response->hdr.session << seqNumber;
+        return;
+    }
+
+    switch (transfer->state) {
+    case StateOpen:
+        _openAckOrNak(transfer, response);
+        break;
+    case StateBurstRead:
+        _burstReadAckOrNak(transfer, response);
+        break;
+    case StateFillMissing:
+        _fillAckOrNak(transfer, response);
+        break;
+    case StateTerminate:
+        _terminateAckOrNak(transfer, response);
+        break;
+    case StateChecksum:
+        _checksumAckOrNak(transfer, response);
+        break;
+    }
+
+    _scheduleTimeout();
+}
+
+FTPBulkDownload::Transfer_t* FTPBulkDownload::_transferForResponse(const MavlinkFTP::Request* response)
+{
+    // Burst data carries its own sequence numbers so it can only be matched by session
+    if (response->hdr.req_opcode == MavlinkFTP::kCmdBurstReadFile) {
+        for (Transfer_t* transfer: _transfers) {
+            if (transfer->state == StateBurstRead && transfer->sessionId == response->hdr.session) {
+                return transfer;
+            }
+        }
+        return nullptr;
+    }
+
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->request.hdr.opcode == response->hdr.req_opcode && static_cast<uint16_t>(transfer->request.hdr.seqNumber + 1) == response->hdr.seqNumber) {
+            return transfer;
+        }
+    }
+
+    return nullptr;
+}
+
+void FTPBulkDownload::_startTransfers(void)
+{
+    for (int i=0; i<_files.count() && _transfers.count() < _maxSessions; i++) {
+        File_t& file = _files[i];
+
+        if (file.complete || file.failed || file.active) {
+            continue;
+        }
+
+        Transfer_t* transfer = new Transfer_t;
+        transfer->fileIndex = i;
+        file.active = true;
+        _transfers.append(transfer);
+
+        _sendOpen(transfer);
+    }
+
+    _scheduleTimeout();
+}
+
+QString FTPBulkDownload::_vehiclePath(const File_t& file) const
+{
+    return _fromDir.isEmpty() ? file.name : QStringLiteral("%1/%2").arg(_fromDir, file.name);
+}
+
+void FTPBulkDownload::_sendRequest(Transfer_t* transfer)
+{
+    transfer->request.hdr.seqNumber = _nextSeqNumber;
+    _nextSeqNumber += 2;
+    transfer->deadlineMsecs = _clock.elapsed() + _ackTimeoutMsecs;
+
+    WeakLinkInterfacePtr weakLink = _vehicle->vehicleLinkManager()->primaryLink();
+    if (weakLink.expired()) {
+        qCDebug(FTPBulkDownloadLog) << "_sendRequest No primary link. Allowing timeout to fail transfer.";
+        return;
+    }
+
+    SharedLinkInterfacePtr  sharedLink = weakLink.lock();
+    mavlink_message_t       message;
+
+    qCDebug(FTPBulkDownloadLog) << "_sendRequest opcode:session:seqNumber:offset"
+                                << MavlinkFTP::opCodeToString(static_cast<MavlinkFTP::OpCode_t>(transfer->request.hdr.opcode))
+                                << transfer->request.hdr.session << transfer->request.hdr.seqNumber << transfer->request.hdr.offset;
+
+    mavlink_msg_file_transfer_protocol_pack_chan(qgcApp()->toolbox()->mavlinkProtocol()->getSystemId(),
+                                                 qgcApp()->toolbox()->mavlinkProtocol()->getComponentId(),
+                                                 sharedLink->mavlinkChannel(),
+                                                 &message,
+                                                 0,
+                                                 _vehicle->id(),
+                                                 _compId,
+                                                 reinterpret_cast<uint8_t*>(&transfer->request));
+    _vehicle->sendMessageOnLinkThreadSafe(sharedLink.get(), message);
+}
+
+void FTPBulkDownload::_sendOpen(Transfer_t* transfer)
+{
+    QByteArray path = _vehiclePath(_files[transfer->fileIndex]).toUtf8();
+
+    transfer->state     = StateOpen;
+    transfer->request   = {};
+    transfer->request.hdr.opcode    = MavlinkFTP::kCmdOpenFileRO;
+    transfer->request.hdr.size      = static_cast<uint8_t>(qMin(path.size(), static_cast<int>(sizeof(transfer->request.data))));
+    memcpy(transfer->request.data, path.constData(), transfer->request.hdr.size);
+
+    _sendRequest(transfer);
+}
+
+void FTPBulkDownload::_sendBurstRead(Transfer_t* transfer)
+{
+    transfer->state     = StateBurstRead;
+    transfer->request   = {};
+    transfer->request.hdr.session   = transfer->sessionId;
+    transfer->request.hdr.opcode    = MavlinkFTP::kCmdBurstReadFile;
+    transfer->request.hdr.offset    = transfer->expectedOffset;
+    transfer->request.hdr.size      = sizeof(transfer->request.data);
+
+    _sendRequest(transfer);
+}
+
+void FTPBulkDownload::_sendNextFill(Transfer_t* transfer)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    transfer->state = StateFillMissing;
+
+    if (transfer->missing.isEmpty()) {
+        transfer->file.flush();
+        _saveManifest();
+
+        if (_rangesSize(file.received) != file.size) {
+            qCDebug(FTPBulkDownloadLog) << "_sendNextFill: no missing blocks but file still incomplete - received:size" << _rangesSize(file.received) << file.size;
+            _transferComplete(transfer, tr("Download failed"));
+            return;
+        }
+
+        _sendTerminate(transfer);
+        return;
+    }
+
+    const Range_t& range = transfer->missing.first();
+
+    transfer->request = {};
+    transfer->request.hdr.session   = transfer->sessionId;
+    transfer->request.hdr.opcode    = MavlinkFTP::kCmdReadFile;
+    transfer->request.hdr.offset    = range.offset;
+    transfer->request.hdr.size      = static_cast<uint8_t>(qMin(static_cast<uint32_t>(sizeof(transfer->request.data)), range.size));
+
+    _sendRequest(transfer);
+}
+
+void FTPBulkDownload::_sendTerminate(Transfer_t* transfer)
+{
+    transfer->state     = StateTerminate;
+    transfer->request   = {};
+    transfer->request.hdr.session   = transfer->sessionId;
+    transfer->request.hdr.opcode    = MavlinkFTP::kCmdTerminateSession;
+
+    _sendRequest(transfer);
+}
+
+void FTPBulkDownload::_sendChecksum(Transfer_t* transfer)
+{
+    QByteArray path = _vehiclePath(_files[transfer->fileIndex]).toUtf8();
+
+    transfer->state     = StateChecksum;
+    transfer->request   = {};
+    transfer->request.hdr.opcode    = MavlinkFTP::kCmdCalcFileCRC32;
+    transfer->request.hdr.size      = static_cast<uint8_t>(qMin(path.size(), static_cast<int>(sizeof(transfer->request.data))));
+    memcpy(transfer->request.data, path.constData(), transfer->request.hdr.size);
+
+    _sendRequest(transfer);
+}
+
+void FTPBulkDownload::_openAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    if (response->hdr.opcode == MavlinkFTP::kRspNak) {
+        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(response->data[0]);
+
+        if (errorCode == MavlinkFTP::kErrNoSessionsAvailable && _transfers.count() > 1) {
+            // The vehicle supports fewer concurrent sessions than we asked for. Put the file back in the queue
+            // and run with what we have.
+            _maxSessions = _transfers.count() - 1;
+            qCDebug(FTPBulkDownloadLog) << "_openAckOrNak: no sessions available, reducing maxSessions to" << _maxSessions;
+
+            file.active = false;
+            _transfers.removeOne(transfer);
+            delete transfer;
+            return;
+        }
+
+        qCDebug(FTPBulkDownloadLog) << "_openAckOrNak: Nak -" << file.name << MavlinkFTP::errorCodeToString(errorCode);
+        _transferComplete(transfer, tr("Download failed") + ": " + MavlinkFTP::errorCodeToString(errorCode));
+        return;
+    }
+
+    if (response->hdr.size != sizeof(uint32_t)) {
+        qCDebug(FTPBulkDownloadLog) << "_openAckOrNak: Ack hdr.size != sizeof(uint32_t)" << response->hdr.size;
+        _transferComplete(transfer, tr("Download failed"));
+        return;
+    }
+
+    transfer->sessionId     = response->hdr.session;
+    transfer->retryCount    = 0;
+
+    // A change in size means the file changed on the vehicle since the manifest was written
+    QIODevice::OpenMode openMode = QFile::ReadWrite;
+    if (file.size != response->openFileLength || !QFileInfo::exists(_localPath(file))) {
+        file.size       = response->openFileLength;
+        file.received.clear();
+        file.complete   = false;
+        openMode |= QFile::Truncate;
+    }
+
+    transfer->file.setFileName(_localPath(file));
+    if (!transfer->file.open(openMode)) {
+        qCDebug(FTPBulkDownloadLog) << "_openAckOrNak: file open failed" << transfer->file.errorString();
+        _sendTerminate(transfer);
+        _transferComplete(transfer, tr("Download failed: Error saving file"));
+        return;
+    }
+
+    QList<Range_t> missing = _missingRanges(file.received, file.size);
+
+    qCDebug(FTPBulkDownloadLog) << "_openAckOrNak: Ack - file:session:size:missingBytes" << file.name << transfer->sessionId << file.size << _rangesSize(missing);
+
+    if (missing.isEmpty()) {
+        // Already have all the bytes, just needs verifying if it hasn't been already
+        _sendTerminate(transfer);
+    } else if (missing.last().offset + missing.last().size == file.size) {
+        // Burst from the start of the trailing hole, earlier holes are filled in afterwards
+        transfer->expectedOffset = missing.takeLast().offset;
+        transfer->missing = missing;
+        _sendBurstRead(transfer);
+    } else {
+        transfer->missing = missing;
+        _sendNextFill(transfer);
+    }
+}
+
+bool FTPBulkDownload::_writeData(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    if (!transfer->file.seek(response->hdr.offset) || transfer->file.write(reinterpret_cast<const char*>(response->data), response->hdr.size) != response->hdr.size) {
+        _sendTerminate(transfer);
+        _transferComplete(transfer, tr("Download failed: Error saving file"));
+        return false;
+    }
+
+    _addRange(_files[transfer->fileIndex].received, response->hdr.offset, response->hdr.size);
+    return true;
+}
+
+void FTPBulkDownload::_burstReadAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    if (response->hdr.opcode == MavlinkFTP::kRspAck) {
+        if (response->hdr.offset < transfer->expectedOffset) {
+            // Left over from a burst which was retried
+            return;
+        }
+        if (response->hdr.offset > transfer->expectedOffset) {
+            // There is a hole in our data, record it as missing and continue on
+            _addRange(transfer->missing, transfer->expectedOffset, response->hdr.offset - transfer->expectedOffset);
+        }
+
+        if (!_writeData(transfer, response)) {
+            return;
+        }
+        transfer->expectedOffset    = response->hdr.offset + response->hdr.size;
+        transfer->retryCount        = 0;
+        transfer->deadlineMsecs     = _clock.elapsed() + _ackTimeoutMsecs;
+
+        if (response->hdr.burstComplete) {
+            // Record progress at burst boundaries so an interrupted download can be resumed
+            transfer->file.flush();
+            _saveManifest();
+            _emitProgress();
+            _sendBurstRead(transfer);
+        }
+    } else if (response->hdr.opcode == MavlinkFTP::kRspNak) {
+        MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(response->data[0]);
+
+        if (errorCode != MavlinkFTP::kErrEOF) {
+            qCDebug(FTPBulkDownloadLog) << "_burstReadAckOrNak: Nak -" << file.name << MavlinkFTP::errorCodeToString(errorCode);
+            _sendTerminate(transfer);
+            _transferComplete(transfer, tr("Download failed"));
+            return;
+        }
+
+        // Anything lost from the end of the last burst is filled in along with the other holes
+        if (transfer->expectedOffset < file.size) {
+            _addRange(transfer->missing, transfer->expectedOffset, file.size - transfer->expectedOffset);
+        }
+
+        qCDebug(FTPBulkDownloadLog) << "_burstReadAckOrNak: EOF - file:missingBytes" << file.name << _rangesSize(transfer->missing);
+        _sendNextFill(transfer);
+    }
+}
+
+void FTPBulkDownload::_fillAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    if (response->hdr.opcode == MavlinkFTP::kRspNak) {
+        qCDebug(FTPBulkDownloadLog) << "_fillAckOrNak: Nak -" << _files[transfer->fileIndex].name << MavlinkFTP::errorCodeToString(static_cast<MavlinkFTP::ErrorCode_t>(response->data[0]));
+        _sendTerminate(transfer);
+        _transferComplete(transfer, tr("Download failed"));
+        return;
+    }
+
+    Range_t& range = transfer->missing.first();
+
+    if (response->hdr.offset != range.offset || response->hdr.size == 0 || response->hdr.size > range.size) {
+        qCDebug(FTPBulkDownloadLog) << "_fillAckOrNak: unexpected offset:size" << response->hdr.offset << response->hdr.size << range.offset << range.size;
+        return;
+    }
+
+    if (!_writeData(transfer, response)) {
+        return;
+    }
+    transfer->retryCount = 0;
+
+    range.offset    += response->hdr.size;
+    range.size      -= response->hdr.size;
+    if (range.size == 0) {
+        transfer->missing.removeFirst();
+    }
+
+    _sendNextFill(transfer);
+    _emitProgress();
+}
+
+void FTPBulkDownload::_terminateAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    Q_UNUSED(response);
+
+    transfer->file.close();
+    transfer->retryCount = 0;
+
+    if (_files[transfer->fileIndex].complete) {
+        // Verified on a previous run
+        _transferComplete(transfer, QString());
+    } else {
+        _sendChecksum(transfer);
+    }
+}
+
+void FTPBulkDownload::_checksumAckOrNak(Transfer_t* transfer, const MavlinkFTP::Request* response)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    if (response->hdr.opcode == MavlinkFTP::kRspNak || response->hdr.size != sizeof(uint32_t)) {
+        // Not all FTP servers implement this, the file is used as is
+        qCDebug(FTPBulkDownloadLog) << "_checksumAckOrNak: vehicle can't calculate CRC, file not verified" << file.name;
+        file.complete = true;
+        _transferComplete(transfer, QString());
+        return;
+    }
+
+    uint32_t vehicleCrc;
+    memcpy(&vehicleCrc, response->data, sizeof(vehicleCrc));
+
+    QFile localFile(_localPath(file));
+    if (!localFile.open(QFile::ReadOnly)) {
+        _transferComplete(transfer, tr("Download failed: Error reading file"));
+        return;
+    }
+
+    uint32_t localCrc = 0;
+    while (!localFile.atEnd()) {
+        QByteArray bytes = localFile.read(64 * 1024);
+        localCrc = crc32(reinterpret_cast<const uint8_t*>(bytes.constData()), bytes.size(), localCrc);
+    }
+    localFile.close();
+
+    if (localCrc != vehicleCrc) {
+        _retryFile(transfer, QStringLiteral("CRC mismatch vehicle:local %1:%2").arg(vehicleCrc, 8, 16, QChar('0')).arg(localCrc, 8, 16, QChar('0')));
+        return;
+    }
+
+    qCDebug(FTPBulkDownloadLog) << "_checksumAckOrNak: verified" << file.name;
+    file.complete = true;
+    _transferComplete(transfer, QString());
+}
+
+void FTPBulkDownload::_retryFile(Transfer_t* transfer, const QString& reason)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    qCWarning(FTPBulkDownloadLog) << "Download verification failed" << file.name << reason;
+
+    transfer->file.close();
+    QFile::remove(_localPath(file));
+    file.received.clear();
+
+    if (++file.attempts < _maxFileAttempts) {
+        // Back into the queue from scratch
+        file.active = false;
+        _transfers.removeOne(transfer);
+        delete transfer;
+        _saveManifest();
+        _startTransfers();
+    } else {
+        _transferComplete(transfer, tr("Download failed: File verification failed"));
+    }
+}
+
+void FTPBulkDownload::_transferComplete(Transfer_t* transfer, const QString& errorMsg)
+{
+    File_t& file = _files[transfer->fileIndex];
+
+    qCDebug(FTPBulkDownloadLog) << "_transferComplete - file:errorMsg" << file.name << errorMsg;
+
+    transfer->file.close();
+    file.active = false;
+    file.failed = !errorMsg.isEmpty();
+
+    _transfers.removeOne(transfer);
+    delete transfer;
+
+    _saveManifest();
+    _emitProgress();
+    emit fileComplete(_localPath(file), errorMsg);
+
+    _startTransfers();
+    _finishIfDone();
+}
+
+void FTPBulkDownload::_finishIfDone(void)
+{
+    if (!_inProgress || !_transfers.isEmpty()) {
+        return;
+    }
+
+    QStringList failedFiles;
+    for (const File_t& file: _files) {
+        if (!file.complete && !file.failed) {
+            // Still waiting on a session
+            return;
+        }
+        if (file.failed) {
+            failedFiles.append(file.name);
+        }
+    }
+
+    _timeoutTimer.stop();
+    _inProgress = false;
+
+    QString errorMsg;
+    if (!failedFiles.isEmpty()) {
+        errorMsg = tr("Download failed: %1").arg(failedFiles.join(", "));
+    }
+
+    qCDebug(FTPBulkDownloadLog) << "complete - errorMsg" << errorMsg;
+
+    emit complete(errorMsg);
+}
+
+void FTPBulkDownload::_checkTimeouts(void)
+{
+    qint64              now = _clock.elapsed();
+    QList<Transfer_t*>  timedOut;
+
+    for (Transfer_t* transfer: _transfers) {
+        if (transfer->deadlineMsecs <= now) {
+            timedOut.append(transfer);
+        }
+    }
+
+    for (Transfer_t* transfer: timedOut) {
+        if (!_transfers.contains(transfer)) {
+            // Removed while handling an earlier timeout
+            continue;
+        }
+
+        if (++transfer->retryCount > _maxRetry) {
+            qCDebug(FTPBulkDownloadLog) << "_checkTimeouts: retries exceeded - file:state" << _files[transfer->fileIndex].name << transfer->state;
+
+            if (transfer->state == StateTerminate) {
+                // Not being able to close the session doesn't affect the data we have
+                _terminateAckOrNak(transfer, nullptr);
+            } else {
+                _transferComplete(transfer, tr("Download failed"));
+            }
+            continue;
+        }
+
+        qCDebug(FTPBulkDownloadLog) << "_checkTimeouts: retrying - file:state:retryCount" << _files[transfer->fileIndex].name << transfer->state << transfer->retryCount;
+
+        if (transfer->state == StateBurstRead) {
+            // Restart the burst from the last in sequence data
+            _sendBurstRead(transfer);
+        } else {
+            _sendRequest(transfer);
+        }
+    }
+
+    _scheduleTimeout();
+}
+
+void FTPBulkDownload::_scheduleTimeout(void)
+{
+    if (_transfers.isEmpty()) {
+        _timeoutTimer.stop();
+        return;
+    }
+
+    qint64 nextDeadline = _transfers.first()->deadlineMsecs;
+    for (const Transfer_t* transfer: _transfers) {
+        nextDeadline = qMin(nextDeadline, transfer->deadlineMsecs);
+    }
+
+    _timeoutTimer.start(static_cast<int>(qMax(static_cast<qint64>(0), nextDeadline - _clock.elapsed())));
+}
+
+void FTPBulkDownload::_emitProgress(void)
+{
+    if (_files.isEmpty()) {
+        return;
+    }
+
+    double total = 0;
+    for (const File_t& file: _files) {
+        if (file.complete) {
+            total += 1.0;
+        } else if (file.size != 0) {
+            total += static_cast<double>(_rangesSize(file.received)) / file.size;
+        }
+    }
+
+    emit progress(static_cast<float>(total / _files.count()));
+}
+
+bool FTPBulkDownload::_loadManifest(void)
+{
+    QFile manifestFile(_toDir.absoluteFilePath(manifestFileName));
+    if (!manifestFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError jsonParseError;
+    QJsonDocument   doc = QJsonDocument::fromJson(manifestFile.readAll(), &jsonParseError);
+    if (jsonParseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        qCWarning(FTPBulkDownloadLog) << "Ignoring invalid manifest" << jsonParseError.errorString();
+        return false;
+    }
+
+    QJsonObject json = doc.object();
+    if (json["version"].toInt() != _manifestVersion || json["fromDir"].toString() != _fromDir) {
+        return false;
+    }
+
+    QJsonObject filesJson = json["files"].toObject();
+    for (File_t& file: _files) {
+        if (!filesJson.contains(file.name)) {
+            continue;
+        }
+
+        QJsonObject fileJson    = filesJson[file.name].toObject();
+        qint64      localSize   = QFileInfo(_localPath(file)).size();
+        bool        valid       = true;
+
+        file.size = static_cast<uint32_t>(fileJson["size"].toDouble());
+        for (const QJsonValue& rangeValue: fileJson["received"].toArray()) {
+            QJsonArray  rangeJson   = rangeValue.toArray();
+            uint32_t    offset      = static_cast<uint32_t>(rangeJson[0].toDouble());
+            uint32_t    size        = static_cast<uint32_t>(rangeJson[1].toDouble());
+
+            // Only trust bytes which actually made it to disk
+            if (static_cast<qint64>(offset) + size > localSize || static_cast<qint64>(offset) + size > file.size) {
+                valid = false;
+                break;
+            }
+            _addRange(file.received, offset, size);
+        }
+
+        if (valid) {
+            file.complete = fileJson["complete"].toBool() && _rangesSize(file.received) == file.size;
+        } else {
+            file.received.clear();
+            file.complete = false;
+        }
+    }
+
+    return true;
+}
+
+void FTPBulkDownload::_saveManifest(void)
+{
+    QJsonObject filesJson;
+
+    for (const File_t& file: _files) {
+        if (file.size == 0 && file.received.isEmpty()) {
+            continue;
+        }
+
+        QJsonArray receivedJson;
+        for (const Range_t& range: file.received) {
+            receivedJson.append(QJsonArray({ static_cast<double>(range.offset), static_cast<double>(range.size) }));
+        }
+
+        QJsonObject fileJson;
+        fileJson["size"]        = static_cast<double>(file.size);
+        fileJson["complete"]    = file.complete;
+        fileJson["received"]    = receivedJson;
+        filesJson[file.name]    = fileJson;
+    }
+
+    QJsonObject json;
+    json["version"] = _manifestVersion;
+    json["fromDir"] = _fromDir;
+    json["files"]   = filesJson;
+
+    // Written to the side and renamed so a crash never leaves a truncated manifest
+    QSaveFile manifestFile(_toDir.absoluteFilePath(manifestFileName));
+    if (!manifestFile.open(QFile::WriteOnly) || manifestFile.write(QJsonDocument(json).toJson(QJsonDocument::Compact)) < 0 || !manifestFile.commit()) {
+        qCWarning(FTPBulkDownloadLog) << "Failed to write manifest" << manifestFile.errorString();
+    }
+}
+
+void FTPBulkDownload::_addRange(QList<Range_t>& ranges, uint32_t offset, uint32_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    // Data normally arrives in order so this is almost always an append to the last range
+    int index = ranges.count();
+    while (index > 0 && ranges[index - 1].offset > offset) {
+        index--;
+    }
+    ranges.insert(index, Range_t{ offset, size });
+
+    if (index > 0 && ranges[index - 1].offset + ranges[index - 1].size >= offset) {
+        Range_t& previous = ranges[index - 1];
+        previous.size = qMax(previous.offset + previous.size, offset + size) - previous.offset;
+        ranges.removeAt(index);
+        index--;
+    }
+    while (index + 1 < ranges.count() && ranges[index].offset + ranges[index].size >= ranges[index + 1].offset) {
+        Range_t& range = ranges[index];
+        range.size = qMax(range.offset + range.size, ranges[index + 1].offset + ranges[index + 1].size) - range.offset;
+        ranges.removeAt(index + 1);
+    }
+}
+
+QList<FTPBulkDownload::Range_t> FTPBulkDownload::_missingRanges(const QList<Range_t>& received, uint32_t fileSize)
+{
+    QList<Range_t>  missing;
+    uint32_t        offset = 0;
+
+    for (const Range_t& range: received) {
+        if (range.offset > offset) {
+            missing.append(Range_t{ offset, range.offset - offset });
+        }
+        offset = qMax(offset, range.offset + range.size);
+    }
+    if (offset < fileSize) {
+        missing.append(Range_t{ offset, fileSize - offset });
+    }
+
+    return missing;
+}
+
+uint32_t FTPBulkDownload::_rangesSize(const QList<Range_t>& ranges)
+{
+    uint32_t size = 0;
+    for (const Range_t& range: ranges) {
+        size += range.size;
+    }
+    return size;
+}
+
+uint32_t FTPBulkDownload::crc32(const uint8_t* data, qint64 size, uint32_t crc)
+{
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i=0; i<256; i++) {
+            uint32_t value = i;
+            for (int bit=0; bit<8; bit++) {
+                value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    // No pre or post inversion, matching crc32part in PX4 and crc_crc32 in ArduPilot
+    for (qint64 i=0; i<size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
@@ -0,0 +1,162 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QDir>
+#include <QFile>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtCore/QLoggingCategory>
+
+#include "QGCMAVLink.h"
+
+Q_DECLARE_LOGGING_CATEGORY(FTPBulkDownloadLog)
+
+class Vehicle;
+
+/// Downloads a set of files from one directory on a vehicle component using several concurrent MAVLink FTP read
+/// sessions, each running its own burst read. Used by FTPManager::downloadFiles.
+///
+/// The bytes received for each file are recorded in a manifest in the download directory. If a transfer is
+/// interrupted, the next download of the same files only requests what is missing. Once a file is complete it is
+/// checked against the CRC32 calculated by the vehicle. Vehicles which don't support kCmdCalcFileCRC32 skip the check.
+class FTPBulkDownload : public QObject
+{
+    Q_OBJECT
+
+public:
+    FTPBulkDownload(Vehicle* vehicle, QObject* parent = nullptr);
+    ~FTPBulkDownload();
+
+    /// @param compId       Component to download from
+    /// @param fromDir      Directory on vehicle, empty for root
+    /// @param fileNames    Files (no path) within fromDir
+    /// @param toDir        Local directory to download to, must exist
+    /// @param maxSessions  Maximum number of concurrent read sessions. This is reduced if the vehicle runs out of
+    ///                     sessions.
+    /// @param seqNumber    Sequence number to continue from
+    /// @return true: download started, false: error
+    bool start(uint8_t compId, const QString& fromDir, const QStringList& fileNames, const QString& toDir, int maxSessions, uint16_t seqNumber);
+
+    /// Stops all transfers. The manifest is kept so the download can be resumed later. Signals complete.
+    void cancel(void);
+
+    bool        inProgress          (void) const { return _inProgress; }
+    uint8_t     compId              (void) const { return _compId; }
+    uint16_t    nextSeqNumber       (void) const { return _nextSeqNumber; }
+    int         maxSessions         (void) const { return _maxSessions; }
+
+    /// Handles an incoming FTP response for this download
+    void mavlinkMessageReceived(const MavlinkFTP::Request* response);
+
+    /// CRC32 as calculated by the PX4 and ArduPilot FTP servers for kCmdCalcFileCRC32
+    static uint32_t crc32(const uint8_t* data, qint64 size, uint32_t crc = 0);
+
+    static const char* manifestFileName;
+
+signals:
+    /// Signalled as each file finishes
+    ///     @param file     Local file path
+    ///     @param errorMsg Error message, empty if no error
+    void fileComplete(const QString& file, const QString& errorMsg);
+
+    /// @param value Amount of progress across all files: 0.0 = none, 1.0 = complete
+    void progress(float value);
+
+    /// Signalled once all files are finished
+    ///     @param errorMsg Error message, empty if all files were downloaded
+    void complete(const QString& errorMsg);
+
+private slots:
+    void _checkTimeouts(void);
+
+private:
+    struct Range_t {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct File_t {
+        QString         name;
+        uint32_t        size        = 0;
+        QList<Range_t>  received;               ///< Sorted and merged
+        bool            complete    = false;    ///< All bytes received and verified
+        bool            failed      = false;
+        bool            active      = false;    ///< Currently assigned to a transfer
+        int             attempts    = 0;
+    };
+
+    typedef enum {
+        StateOpen,
+        StateBurstRead,
+        StateFillMissing,
+        StateTerminate,
+        StateChecksum,
+    } TransferState_t;
+
+    struct Transfer_t {
+        int                 fileIndex;
+        TransferState_t     state;
+        uint8_t             sessionId       = 0;
+        uint32_t            expectedOffset  = 0;    ///< Next burst offset
+        QList<Range_t>      missing;                ///< Ranges to fill with kCmdReadFile once the burst is done
+        MavlinkFTP::Request request;                ///< Last request sent, for retries
+        qint64              deadlineMsecs   = 0;
+        int                 retryCount      = 0;
+        QFile               file;
+    };
+
+    void        _startTransfers         (void);
+    void        _sendOpen               (Transfer_t* transfer);
+    void        _sendBurstRead          (Transfer_t* transfer);
+    void        _sendNextFill           (Transfer_t* transfer);
+    void        _sendTerminate          (Transfer_t* transfer);
+    void        _sendChecksum           (Transfer_t* transfer);
+    void        _sendRequest            (Transfer_t* transfer);
+    void        _openAckOrNak           (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    void        _burstReadAckOrNak      (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    void        _fillAckOrNak           (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    void        _terminateAckOrNak      (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    void        _checksumAckOrNak       (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    bool        _writeData              (Transfer_t* transfer, const MavlinkFTP::Request* response);
+    void        _transferComplete       (Transfer_t* transfer, const QString& errorMsg);
+    void        _retryFile              (Transfer_t* transfer, const QString& reason);
+    void        _finishIfDone           (void);
+    void        _scheduleTimeout        (void);
+    void        _emitProgress           (void);
+    bool        _loadManifest           (void);
+    void        _saveManifest           (void);
+    QString     _vehiclePath            (const File_t& file) const;
+    QString     _localPath              (const File_t& file) const { return _toDir.absoluteFilePath(file.name); }
+    Transfer_t* _transferForResponse    (const MavlinkFTP::Request* response);
+
+    static void             _addRange       (QList<Range_t>& ranges, uint32_t offset, uint32_t size);
+    static QList<Range_t>   _missingRanges  (const QList<Range_t>& received, uint32_t fileSize);
+    static uint32_t         _rangesSize     (const QList<Range_t>& ranges);
+
+    Vehicle*            _vehicle;
+    bool                _inProgress     = false;
+    uint8_t             _compId         = MAV_COMP_ID_AUTOPILOT1;
+    QString             _fromDir;
+    QDir                _toDir;
+    QList<File_t>       _files;
+    QList<Transfer_t*>  _transfers;
+    int                 _maxSessions    = 1;
+    uint16_t            _nextSeqNumber  = 0;
+    QElapsedTimer       _clock;
+    QTimer              _timeoutTimer;
+    int                 _ackTimeoutMsecs;
+
+    static const int _defaultAckTimeoutMsecs    = 1000;
+    static const int _maxRetry                  = 3;
+    static const int _maxFileAttempts           = 2;    ///< A file which fails verification is downloaded again once
+    static const int _manifestVersion           = 1;
+};
@@ -22,13 +22,22 @@ QGC_LOGGING_CATEGORY(FTPManagerLog, "FTPManagerLog")
 const char* FTPManager::mavlinkFTPScheme = "mftp";
 
 FTPManager::FTPManager(Vehicle* vehicle)
-    : QObject   (vehicle)
-    , _vehicle  (vehicle)
+    : QObject       (vehicle)
+    , _vehicle      (vehicle)
+    , _bulkDownload (vehicle, this)
 {
     _ackOrNakTimeoutTimer.setSingleShot(true);
     // Mock link responds immediately if at all, speed up unit tests with faster timoue
     _ackOrNakTimeoutTimer.setInterval(qgcApp()->runningUnitTests() ? 10 : _ackOrNakTimeoutMsecs);
     connect(&_ackOrNakTimeoutTimer, &QTimer::timeout, this, &FTPManager::_ackOrNakTimeout);
+
+    connect(&_bulkDownload, &FTPBulkDownload::fileComplete, this, &FTPManager::fileDownloadComplete);
+    connect(&_bulkDownload, &FTPBulkDownload::progress,     this, &FTPManager::commandProgress);
+    connect(&_bulkDownload, &FTPBulkDownload::complete,     this, [this](const QString& errorMsg) {
+        // Pick up the sequence numbers from where the bulk download left off
+        _expectedIncomingSeqNumber = _bulkDownload.nextSeqNumber() - 1;
+        emit downloadFilesComplete(errorMsg);
+    });
     
     // Make sure we don't have bad structure packing
     Q_ASSERT(sizeof(MavlinkFTP::RequestHeader) == 12);
@@ -38,7 +47,7 @@ bool FTPManager::download(uint8_t fromCompId, const QString& fromURI, const QStr
 {
     qCDebug(FTPManagerLog) << "download fromURI:" << fromURI << "to:" << toDir << "fromCompId:" << fromCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
+    if (!_rgStateMachine.isEmpty() || _bulkDownload.inProgress()) {
         qCDebug(FTPManagerLog) << "Cannot download. Already in another operation";
         return false;
     }
@@ -86,11 +95,50 @@ bool FTPManager::download(uint8_t fromCompId, const QString& fromURI, const QStr
     return true;
 }
 
+bool FTPManager::readFileRange(uint8_t fromCompId, const QString& fromURI, uint32_t offset, uint32_t size)
+{
+    qCDebug(FTPManagerLog) << "readFileRange fromURI:" << fromURI << "offset:" << offset << "size:" << size << "fromCompId:" << fromCompId;
+
+    if (!_rgStateMachine.isEmpty() || _bulkDownload.inProgress()) {
+        qCDebug(FTPManagerLog) << "Cannot read file range. Already in another operation";
+        return false;
+    }
+
+    // The burst is stopped by terminating the session once the range is filled, a reset would knock out other
+    // sessions the component may be serving.
+    static const StateFunctions_t rgRangeStateMachine[] = {
+        { &FTPManager::_openFileROBegin,            &FTPManager::_openFileROAckOrNak,           &FTPManager::_openFileROTimeout },
+        { &FTPManager::_burstReadFileBegin,         &FTPManager::_burstReadFileAckOrNak,        &FTPManager::_burstReadFileTimeout },
+        { &FTPManager::_fillMissingBlocksBegin,     &FTPManager::_fillMissingBlocksAckOrNak,    &FTPManager::_fillMissingBlocksTimeout },
+        { &FTPManager::_terminateSessionBegin,      &FTPManager::_terminateSessionAckOrNak,     &FTPManager::_terminateSessionTimeout },
+        { &FTPManager::_downloadCompleteNoError,    nullptr,                                    nullptr },
+    };
+    for (size_t i=0; i<sizeof(rgRangeStateMachine)/sizeof(rgRangeStateMachine[0]); i++) {
+        _rgStateMachine.append(rgRangeStateMachine[i]);
+    }
+
+    _downloadState.reset();
+    _downloadState.checksize    = true;
+    _downloadState.rangeRead    = true;
+    _downloadState.rangeOffset  = offset;
+    _downloadState.rangeSize    = size;
+
+    if (!_parseURI(fromCompId, fromURI, _downloadState.fullPathOnVehicle, _ftpCompId)) {
+        qCWarning(FTPManagerLog) << "_parseURI failed";
+        _rgStateMachine.clear();
+        return false;
+    }
+
+    _startStateMachine();
+
+    return true;
+}
+
 bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
 {
     qCDebug(FTPManagerLog) << "list directory fromURI:" << fromURI << "fromCompId:" << fromCompId;
 
-    if (!_rgStateMachine.isEmpty()) {
+    if (!_rgStateMachine.isEmpty() || _bulkDownload.inProgress()) {
         qCDebug(FTPManagerLog) << "Cannot list directory. Already in another operation";
         return false;
     }
@@ -117,6 +165,28 @@ bool FTPManager::listDirectory(uint8_t fromCompId, const QString& fromURI)
     return true;
 }
 
+bool FTPManager::downloadFiles(uint8_t fromCompId, const QString& fromDir, const QStringList& fileNames, const QString& toDir, int maxSessions)
+{
+    qCDebug(FTPManagerLog) << "downloadFiles fromDir:" << fromDir << "to:" << toDir << "fromCompId:" << fromCompId << "fileCount:" << fileNames.count();
+
+    if (!_rgStateMachine.isEmpty() || _bulkDownload.inProgress()) {
+        qCDebug(FTPManagerLog) << "Cannot download files. Already in another operation";
+        return false;
+    }
+
+    QString parsedDir;
+    uint8_t compId;
+    if (!_parseURI(fromCompId, fromDir, parsedDir, compId)) {
+        qCWarning(FTPManagerLog) << "_parseURI failed";
+        return false;
+    }
+    while (parsedDir.endsWith('/')) {
+        parsedDir.chop(1);
+    }
+
+    return _bulkDownload.start(compId, parsedDir, fileNames, toDir, maxSessions, _expectedIncomingSeqNumber + 1);
+}
+
 void FTPManager::cancelDownload()
 {
     if (!_downloadState.inProgress()) {
@@ -190,6 +260,13 @@ void FTPManager::_downloadComplete(const QString& errorMsg)
     _ackOrNakTimeoutTimer.stop();
     _rgStateMachine.clear();
     _currentStateMachineIndex = -1;
+
+    if (_downloadState.rangeRead) {
+        QByteArray data = errorMsg.isEmpty() ? _downloadState.rangeData : QByteArray();
+        emit readFileRangeComplete(_downloadState.fullPathOnVehicle, _downloadState.rangeOffset, data, _downloadState.fileSize, errorMsg);
+        return;
+    }
+
     if (_downloadState.file.isOpen()) {
         _downloadState.file.close();
         if (!errorMsg.isEmpty()) {
@@ -200,6 +277,31 @@ void FTPManager::_downloadComplete(const QString& errorMsg)
     emit downloadComplete(downloadFilePath, errorMsg);
 }
 
+/// Writes the data from a read ack to the download file, or to the range buffer for a range read. Range reads only
+/// keep the bytes which fall inside the range.
+///     @return false: write failed
+bool FTPManager::_writeDownloadData(const MavlinkFTP::Request* ackOrNak)
+{
+    if (_downloadState.rangeRead) {
+        uint32_t start  = qMax(ackOrNak->hdr.offset, _downloadState.rangeOffset);
+        uint32_t end    = qMin(ackOrNak->hdr.offset + ackOrNak->hdr.size, _downloadState.rangeEnd());
+        if (end > start) {
+            memcpy(_downloadState.rangeData.data() + (start - _downloadState.rangeOffset), &ackOrNak->data[start - ackOrNak->hdr.offset], end - start);
+            _downloadState.bytesWritten += end - start;
+        }
+        return true;
+    }
+
+    _downloadState.file.seek(ackOrNak->hdr.offset);
+    int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
+    if (bytesWritten != ackOrNak->hdr.size) {
+        return false;
+    }
+    _downloadState.bytesWritten += ackOrNak->hdr.size;
+
+    return true;
+}
+
 /// Closes out a list directory sequence
 ///     @param errorMsg Error message, empty if no error
 void FTPManager::_listDirectoryComplete(const QString& errorMsg)
@@ -220,12 +322,16 @@ void FTPManager::_listDirectoryComplete(const QString& errorMsg)
 
 void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
 {
-    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL ||
-            message.sysid != _vehicle->id() || message.compid != _ftpCompId) {
+    if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL || message.sysid != _vehicle->id()) {
+        return;
+    }
+
+    bool bulkDownload = _bulkDownload.inProgress();
+    if (message.compid != (bulkDownload ? _bulkDownload.compId() : _ftpCompId)) {
         return;
     }
 
-    if (_currentStateMachineIndex == -1) {
+    if (!bulkDownload && _currentStateMachineIndex == -1) {
         return;
     }
 
@@ -240,6 +346,12 @@ void FTPManager::_mavlinkMessageReceived(const mavlink_message_t& message)
     
     MavlinkFTP::Request* request = (MavlinkFTP::Request*)&data.payload[0];
 
+    if (bulkDownload) {
+        // Concurrent sessions interleave their sequence numbers, the bulk download does its own matching
+        _bulkDownload.mavlinkMessageReceived(request);
+        return;
+    }
+
     // Ignore old/reordered packets (handle wrap-around properly)
     uint16_t actualIncomingSeqNumber = request->hdr.seqNumber;
     if ((uint16_t)((_expectedIncomingSeqNumber - 1) - actualIncomingSeqNumber) < (std::numeric_limits<uint16_t>::max()/2)) {
@@ -340,6 +452,15 @@ void FTPManager::_openFileROAckOrNak(const MavlinkFTP::Request* ackOrNak)
         _downloadState.fileSize         = ackOrNak->openFileLength;
         _downloadState.expectedOffset   = 0;
 
+        if (_downloadState.rangeRead) {
+            _downloadState.rangeOffset      = qMin(_downloadState.rangeOffset, _downloadState.fileSize);
+            _downloadState.rangeSize        = qMin(_downloadState.rangeSize, _downloadState.fileSize - _downloadState.rangeOffset);
+            _downloadState.expectedOffset   = _downloadState.rangeOffset;
+            _downloadState.rangeData.fill(0, _downloadState.rangeSize);
+            _advanceStateMachine();
+            return;
+        }
+
         _downloadState.file.setFileName(_downloadState.toDir.filePath(_downloadState.fileName));
         if (_downloadState.file.open(QFile::WriteOnly | QFile::Truncate)) {
             _advanceStateMachine();
@@ -375,6 +496,11 @@ void FTPManager::_burstReadFileWorker(bool firstRequest)
 
 void FTPManager::_burstReadFileBegin(void)
 {
+    if (_downloadState.rangeRead && _downloadState.expectedOffset >= _downloadState.rangeEnd()) {
+        // Empty range, nothing to read
+        _advanceStateMachine();
+        return;
+    }
     _burstReadFileWorker(true /* firstRequestr */);
 }
 
@@ -407,6 +533,9 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
                 MissingData_t missingData;
                 missingData.offset          = _downloadState.expectedOffset;
                 missingData.cBytesMissing   = ackOrNak->hdr.offset - _downloadState.expectedOffset;
+                if (_downloadState.rangeRead) {
+                    missingData.cBytesMissing = qMin(missingData.cBytesMissing, _downloadState.rangeEnd() - missingData.offset);
+                }
                 _downloadState.rgMissingData.append(missingData);
                 qCDebug(FTPManagerLog) << "_handleBurstReadFileAck: adding missing data offset:cBytesMissing" << missingData.offset << missingData.cBytesMissing;
             } else {
@@ -417,16 +546,17 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
             }
         }
 
-        _downloadState.file.seek(ackOrNak->hdr.offset);
-        int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
-        if (bytesWritten != ackOrNak->hdr.size) {
+        if (!_writeDownloadData(ackOrNak)) {
             _downloadComplete(tr("Download failed: Error saving file"));
             return;
         }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
         _downloadState.expectedOffset = ackOrNak->hdr.offset + ackOrNak->hdr.size;
 
-        if (ackOrNak->hdr.burstComplete) {
+        if (_downloadState.rangeRead && _downloadState.expectedOffset >= _downloadState.rangeEnd()) {
+            // Range is covered, the rest of the burst is stopped by terminating the session
+            _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
+            _advanceStateMachine();
+        } else if (ackOrNak->hdr.burstComplete) {
             // The current burst is done, request next one in offset sequence
             _expectedIncomingSeqNumber = ackOrNak->hdr.seqNumber;
             _burstReadFileWorker(true /* firstRequest */);
@@ -437,8 +567,8 @@ void FTPManager::_burstReadFileAckOrNak(const MavlinkFTP::Request* ackOrNak)
         }
 
         // Emit progress last, as cancel could be called in there
-        if (_downloadState.fileSize != 0) {
-            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
+        if (_downloadState.expectedBytes() != 0) {
+            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.expectedBytes());
         }
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
@@ -596,10 +726,10 @@ void FTPManager::_fillMissingBlocksWorker(bool firstRequest)
         _sendRequestExpectAck(&request);
     } else {
         // We should have the full file now
-        if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
+        if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.expectedBytes()) {
             _advanceStateMachine();
         } else {
-            qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: no missing blocks but file still incomplete - bytesWritten:fileSize" << _downloadState.bytesWritten << _downloadState.fileSize;
+            qCDebug(FTPManagerLog) << "_fillMissingBlocksWorker: no missing blocks but file still incomplete - bytesWritten:expectedBytes" << _downloadState.bytesWritten << _downloadState.expectedBytes();
             _downloadComplete(tr("Download failed"));
         }
     }
@@ -645,13 +775,10 @@ void FTPManager::_fillMissingBlocksAckOrNak(const MavlinkFTP::Request* ackOrNak)
             return;
         }
 
-        _downloadState.file.seek(ackOrNak->hdr.offset);
-        int bytesWritten = _downloadState.file.write((const char*)ackOrNak->data, ackOrNak->hdr.size);
-        if (bytesWritten != ackOrNak->hdr.size) {
+        if (!_writeDownloadData(ackOrNak)) {
             _downloadComplete(tr("Download failed: Error saving file"));
             return;
         }
-        _downloadState.bytesWritten += ackOrNak->hdr.size;
 
         MissingData_t& missingData = _downloadState.rgMissingData.first();
         missingData.offset += ackOrNak->hdr.size;
@@ -665,15 +792,15 @@ void FTPManager::_fillMissingBlocksAckOrNak(const MavlinkFTP::Request* ackOrNak)
         _fillMissingBlocksWorker(true /* firstReqeust */);
 
         // Emit progress last, as cancel could be called in there
-        if (_downloadState.fileSize != 0) {
-            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.fileSize);
+        if (_downloadState.expectedBytes() != 0) {
+            emit commandProgress((float)(_downloadState.bytesWritten) / (float)_downloadState.expectedBytes());
         }
     } else if (ackOrNak->hdr.opcode == MavlinkFTP::kRspNak) {
         MavlinkFTP::ErrorCode_t errorCode = static_cast<MavlinkFTP::ErrorCode_t>(ackOrNak->data[0]);
 
         if (errorCode == MavlinkFTP::kErrEOF) {
             qCDebug(FTPManagerLog) << "_fillMissingBlocksAckOrNak EOF";
-            if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.fileSize) {
+            if (_downloadState.checksize == false || _downloadState.bytesWritten == _downloadState.expectedBytes()) {
                 // We've successfully complete filling in all missing blocks
                 _advanceStateMachine();
                 return;
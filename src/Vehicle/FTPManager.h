@@ -15,6 +15,7 @@
 #include <QtCore/QLoggingCategory>
 
 #include "QGCMAVLink.h"
+#include "FTPBulkDownload.h"
 
 Q_DECLARE_LOGGING_CATEGORY(FTPManagerLog)
 
@@ -52,15 +53,54 @@ public:
     /// Signals listDirectoryComplete
     bool listDirectory(uint8_t fromCompId, const QString& fromURI);
 
+    /// Reads part of a file into memory. Used to look at files which are too large to download in full.
+    ///     @param fromCompId Component id of the component to read from. If fromCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param fromURI    File to read from component, same format as download fromURI
+    ///     @param offset     Offset of first byte to read
+    ///     @param size       Number of bytes to read. The range is clamped to the end of the file.
+    /// @return true: read has started, false: error, no read
+    /// Signals readFileRangeComplete, commandProgress
+    bool readFileRange(uint8_t fromCompId, const QString& fromURI, uint32_t offset, uint32_t size);
+
     /// Cancel the download operation
     /// This will emit downloadComplete() when done, and if there's currently a download in progress
     void cancelDownload();
 
+    /// Downloads a set of files from a directory using several concurrent burst read sessions. A manifest in toDir
+    /// records what has been received so a failed or cancelled download resumes where it left off when started again.
+    /// Each completed file is verified against the CRC32 calculated by the vehicle.
+    ///     @param fromCompId   Component id of the component to download from. If fromCompId is MAV_COMP_ID_ALL, then MAV_COMP_ID_AUTOPILOT1 is used.
+    ///     @param fromDir      Directory on the component, same format as download fromURI
+    ///     @param fileNames    Files (no path) within fromDir to download
+    ///     @param toDir        Local directory to download files to, must exist
+    ///     @param maxSessions  Maximum number of files to transfer at the same time. Reduced automatically if the
+    ///                         component runs out of sessions.
+    /// @return true: download has started, false: error, no download
+    /// Signals downloadFilesComplete, fileDownloadComplete, commandProgress
+    bool downloadFiles(uint8_t fromCompId, const QString& fromDir, const QStringList& fileNames, const QString& toDir, int maxSessions = defaultBulkSessions);
+
+    /// Cancel a downloadFiles operation. Files which are partially downloaded are kept for resuming.
+    /// This will emit downloadFilesComplete() if there's currently a download in progress
+    void cancelDownloadFiles() { _bulkDownload.cancel(); }
+
     static const char* mavlinkFTPScheme;
+    static const int defaultBulkSessions = 3;
 
 signals:
     void downloadComplete       (const QString& file, const QString& errorMsg);
     void listDirectoryComplete  (const QStringList& dirList, const QString& errorMsg);
+    void downloadFilesComplete  (const QString& errorMsg);
+
+    /// Signalled when a readFileRange completes
+    ///     @param file     Fully qualified path to file on vehicle
+    ///     @param offset   Offset of first byte in data
+    ///     @param data     Bytes read, empty on error
+    ///     @param fileSize Size of the whole file as reported by the vehicle
+    ///     @param errorMsg Error message, empty if no error
+    void readFileRangeComplete  (const QString& file, uint32_t offset, const QByteArray& data, uint32_t fileSize, const QString& errorMsg);
+
+    /// Signalled by downloadFiles as each file finishes
+    void fileDownloadComplete   (const QString& file, const QString& errorMsg);
 
     /// Signalled during a lengthy command to show progress
     ///     @param value Amount of progress: 0.0 = none, 1.0 = complete
@@ -97,15 +137,28 @@ private:
         QFile                   file;
         int                     retryCount;
         bool                    checksize;
+        bool                    rangeRead;              ///< true: readFileRange into rangeData, false: download to file
+        uint32_t                rangeOffset;
+        uint32_t                rangeSize;              ///< Clamped to file size once the file is open
+        QByteArray              rangeData;
 
         bool inProgress() const { return fileSize > 0; }
 
+        uint32_t rangeEnd() const { return rangeOffset + rangeSize; }
+
+        /// Number of bytes the transfer must write to be complete
+        uint32_t expectedBytes() const { return rangeRead ? rangeSize : fileSize; }
+
         void reset() {
             sessionId       = 0;
             expectedOffset  = 0;
             bytesWritten    = 0;
             retryCount      = 0;
             fileSize        = 0;
+            rangeRead       = false;
+            rangeOffset     = 0;
+            rangeSize       = 0;
+            rangeData.clear();
             fullPathOnVehicle.clear();
             fileName.clear();
             rgMissingData.clear();
@@ -153,6 +206,7 @@ private:
     void    _sendRequestExpectAck       (MavlinkFTP::Request* request);
     void    _downloadCompleteNoError    (void) { _downloadComplete(QString()); }
     void    _downloadComplete           (const QString& errorMsg);
+    bool    _writeDownloadData          (const MavlinkFTP::Request* ackOrNak);
     void    _fillRequestDataWithString(MavlinkFTP::Request* request, const QString& str);
     void    _fillMissingBlocksWorker    (bool firstRequest);
     void    _burstReadFileWorker        (bool firstRequest);
@@ -172,6 +226,7 @@ private:
     QList<StateFunctions_t> _rgStateMachine;
     DownloadState_t         _downloadState;
     ListDirectoryState_t    _listDirectoryState;
+    FTPBulkDownload         _bulkDownload;
     QTimer                  _ackOrNakTimeoutTimer;
     int                     _currentStateMachineIndex   = -1;
     uint16_t                _expectedIncomingSeqNumber  = 0;
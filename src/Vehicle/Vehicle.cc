@@ -139,6 +139,7 @@ Vehicle::Vehicle(LinkInterface*             link,
 
     connect(_mavlink, &MAVLinkProtocol::messageReceived,        this, &Vehicle::_mavlinkMessageReceived);
     connect(_mavlink, &MAVLinkProtocol::mavlinkMessageStatus,   this, &Vehicle::_mavlinkMessageStatus);
+    _mavlink->profiler()->addDispatcher(tr("Vehicle %1").arg(_id), &_messageDispatcher);
 
     connect(this, &Vehicle::flightModeChanged,          this, &Vehicle::_handleFlightModeChanged);
     connect(this, &Vehicle::armedChanged,               this, &Vehicle::_announceArmedChanged);
@@ -433,6 +434,8 @@ void Vehicle::_commonInit()
         }
     }
 
+    _subscribeMessageHandlers();
+
     _flightDistanceFact.setRawValue(0);
     _flightTimeFact.setRawValue(0);
     _flightTimeUpdater.setInterval(1000);
@@ -551,6 +554,130 @@ void Vehicle::resetCounters()
     _heardFrom          = false;
 }
 
+template<typename Message>
+void Vehicle::_subscribeMessage(uint32_t msgid, const char* name, void (Vehicle::*handler)(Message& message))
+{
+    _messageDispatcher.subscribe(msgid, this, [this, handler](LinkInterface* /* link */, mavlink_message_t& message) { (this->*handler)(message); }, QStringLiteral("Vehicle::%1").arg(name));
+}
+
+void Vehicle::_subscribeMessageHandlers(void)
+{
+    // Handlers are called in the order they subscribe here, including the ones for every message. This keeps the order
+    // from before subscriptions: managers, the wait for message hook, battery and other fact groups, then the vehicle's
+    // own handlers, so those and mavlinkMessageReceived after them see the fact group updates. Fact groups added after
+    // construction subscribe when they show up, which puts them after the vehicle's handlers.
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL, _ftpManager, [this](LinkInterface* /* link */, mavlink_message_t& message) { _ftpManager->_mavlinkMessageReceived(message); });
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_PARAM_VALUE, _parameterManager, [this](LinkInterface* /* link */, mavlink_message_t& message) { _parameterManager->mavlinkMessageReceived(message); });
+    for (uint32_t msgid: { MAVLINK_MSG_ID_DATA_TRANSMISSION_HANDSHAKE, MAVLINK_MSG_ID_ENCAPSULATED_DATA }) {
+        _messageDispatcher.subscribe(msgid, _imageProtocolManager, [this](LinkInterface* /* link */, mavlink_message_t& message) { _imageProtocolManager->mavlinkMessageReceived(message); });
+    }
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_OPEN_DRONE_ID_ARM_STATUS, _remoteIDManager, [this](LinkInterface* /* link */, mavlink_message_t& message) { _remoteIDManager->mavlinkMessageReceived(message); });
+
+    // Needs every message, since any of them can time out the wait
+    _messageDispatcher.subscribe(MAVLinkMessageDispatcher::allMessages, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { _waitForMavlinkMessageMessageReceived(message); }, QStringLiteral("Vehicle::_waitForMavlinkMessageMessageReceived"));
+
+    // Battery fact groups are created dynamically as new batteries are discovered
+    for (uint32_t msgid: VehicleBatteryFactGroup::batteryMessageIds()) {
+        _messageDispatcher.subscribe(msgid, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { VehicleBatteryFactGroup::handleMessageForVehicle(this, message); }, QStringLiteral("VehicleBatteryFactGroup"));
+    }
+
+    _subscribeFactGroups();
+    connect(this, &Vehicle::factGroupNamesChanged, this, &Vehicle::_subscribeFactGroups);
+
+    _subscribeMessage(MAVLINK_MSG_ID_HOME_POSITION,         "_handleHomePosition",          &Vehicle::_handleHomePosition);
+    _subscribeMessage(MAVLINK_MSG_ID_HEARTBEAT,             "_handleHeartbeat",             &Vehicle::_handleHeartbeat);
+    _subscribeMessage(MAVLINK_MSG_ID_RADIO_STATUS,          "_handleRadioStatus",           &Vehicle::_handleRadioStatus);
+    _subscribeMessage(MAVLINK_MSG_ID_RC_CHANNELS,           "_handleRCChannels",            &Vehicle::_handleRCChannels);
+    _subscribeMessage(MAVLINK_MSG_ID_BATTERY_STATUS,        "_handleBatteryStatus",         &Vehicle::_handleBatteryStatus);
+    _subscribeMessage(MAVLINK_MSG_ID_SYS_STATUS,            "_handleSysStatus",             &Vehicle::_handleSysStatus);
+    _subscribeMessage(MAVLINK_MSG_ID_RAW_IMU,               "_handleRawImuTemp",            &Vehicle::_handleRawImuTemp);
+    _subscribeMessage(MAVLINK_MSG_ID_EXTENDED_SYS_STATE,    "_handleExtendedSysState",      &Vehicle::_handleExtendedSysState);
+    _subscribeMessage(MAVLINK_MSG_ID_COMMAND_ACK,           "_handleCommandAck",            &Vehicle::_handleCommandAck);
+    _subscribeMessage(MAVLINK_MSG_ID_LOGGING_DATA,          "_handleMavlinkLoggingData",    &Vehicle::_handleMavlinkLoggingData);
+    _subscribeMessage(MAVLINK_MSG_ID_LOGGING_DATA_ACKED,    "_handleMavlinkLoggingDataAcked", &Vehicle::_handleMavlinkLoggingDataAcked);
+    _subscribeMessage(MAVLINK_MSG_ID_GPS_RAW_INT,           "_handleGpsRawInt",             &Vehicle::_handleGpsRawInt);
+    _subscribeMessage(MAVLINK_MSG_ID_GLOBAL_POSITION_INT,   "_handleGlobalPositionInt",     &Vehicle::_handleGlobalPositionInt);
+    _subscribeMessage(MAVLINK_MSG_ID_ALTITUDE,              "_handleAltitude",              &Vehicle::_handleAltitude);
+    _subscribeMessage(MAVLINK_MSG_ID_VFR_HUD,               "_handleVfrHud",                &Vehicle::_handleVfrHud);
+    _subscribeMessage(MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT, "_handleNavControllerOutput",   &Vehicle::_handleNavControllerOutput);
+    _subscribeMessage(MAVLINK_MSG_ID_CAMERA_IMAGE_CAPTURED, "_handleCameraImageCaptured",   &Vehicle::_handleCameraImageCaptured);
+    _subscribeMessage(MAVLINK_MSG_ID_ADSB_VEHICLE,          "_handleADSBVehicle",           &Vehicle::_handleADSBVehicle);
+    _subscribeMessage(MAVLINK_MSG_ID_HIGH_LATENCY,          "_handleHighLatency",           &Vehicle::_handleHighLatency);
+    _subscribeMessage(MAVLINK_MSG_ID_HIGH_LATENCY2,         "_handleHighLatency2",          &Vehicle::_handleHighLatency2);
+    _subscribeMessage(MAVLINK_MSG_ID_ATTITUDE,              "_handleAttitude",              &Vehicle::_handleAttitude);
+    _subscribeMessage(MAVLINK_MSG_ID_ATTITUDE_QUATERNION,   "_handleAttitudeQuaternion",    &Vehicle::_handleAttitudeQuaternion);
+    _subscribeMessage(MAVLINK_MSG_ID_STATUSTEXT,            "_handleStatusText",            &Vehicle::_handleStatusText);
+    _subscribeMessage(MAVLINK_MSG_ID_ORBIT_EXECUTION_STATUS,"_handleOrbitExecutionStatus",  &Vehicle::_handleOrbitExecutionStatus);
+    _subscribeMessage(MAVLINK_MSG_ID_MOUNT_ORIENTATION,     "_handleGimbalOrientation",     &Vehicle::_handleGimbalOrientation);
+    _subscribeMessage(MAVLINK_MSG_ID_OBSTACLE_DISTANCE,     "_handleObstacleDistance",      &Vehicle::_handleObstacleDistance);
+    _subscribeMessage(MAVLINK_MSG_ID_FENCE_STATUS,          "_handleFenceStatus",           &Vehicle::_handleFenceStatus);
+    _subscribeMessage(MAVLINK_MSG_ID_MESSAGE_INTERVAL,      "_handleMessageInterval",       &Vehicle::_handleMessageInterval);
+#ifdef DAILY_BUILD // Disable use of development/WIP MAVLink messages for release builds
+    _subscribeMessage(MAVLINK_MSG_ID_CURRENT_MODE,          "_handleCurrentMode",           &Vehicle::_handleCurrentMode);
+#endif
+    // Following are ArduPilot dialect messages
+#if !defined(NO_ARDUPILOT_DIALECT)
+    _subscribeMessage(MAVLINK_MSG_ID_CAMERA_FEEDBACK,       "_handleCameraFeedback",        &Vehicle::_handleCameraFeedback);
+    _subscribeMessage(MAVLINK_MSG_ID_RANGEFINDER,           "_handleRangefinder",           &Vehicle::_handleRangefinder);
+#endif
+
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_PING, this, [this](LinkInterface* link, mavlink_message_t& message) { _handlePing(link, message); }, QStringLiteral("Vehicle::_handlePing"));
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_SCALED_IMU, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { emit mavlinkScaledImu1(message); }, QStringLiteral("Vehicle::mavlinkScaledImu1"));
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_SCALED_IMU2, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { emit mavlinkScaledImu2(message); }, QStringLiteral("Vehicle::mavlinkScaledImu2"));
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_SCALED_IMU3, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { emit mavlinkScaledImu3(message); }, QStringLiteral("Vehicle::mavlinkScaledImu3"));
+
+    for (uint32_t msgid: { MAVLINK_MSG_ID_EVENT, MAVLINK_MSG_ID_CURRENT_EVENT_SEQUENCE, MAVLINK_MSG_ID_RESPONSE_EVENT_ERROR }) {
+        _messageDispatcher.subscribe(msgid, this, [this](LinkInterface* /* link */, mavlink_message_t& message) { _eventHandler(message.compid).handleEvents(message); }, QStringLiteral("Vehicle::handleEvents"));
+    }
+
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_SERIAL_CONTROL, this, [this](LinkInterface* /* link */, mavlink_message_t& message) {
+        mavlink_serial_control_t ser;
+        mavlink_msg_serial_control_decode(&message, &ser);
+        if (static_cast<size_t>(ser.count) > sizeof(ser.data)) {
+            qWarning() << "Invalid count for SERIAL_CONTROL, discarding." << ser.count;
+        } else {
+            emit mavlinkSerialControl(ser.device, ser.flags, ser.timeout, ser.baudrate,
+                    QByteArray(reinterpret_cast<const char*>(ser.data), ser.count));
+        }
+    }, QStringLiteral("Vehicle::mavlinkSerialControl"));
+
+#ifdef DAILY_BUILD // Disable use of development/WIP MAVLink messages for release builds
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_AVAILABLE_MODES_MONITOR, this, [this](LinkInterface* /* link */, mavlink_message_t& message) {
+        // Avoid duplicate requests during initial connection setup
+        if (!_initialConnectStateMachine || !_initialConnectStateMachine->active()) {
+            mavlink_available_modes_monitor_t availableModesMonitor;
+            mavlink_msg_available_modes_monitor_decode(&message, &availableModesMonitor);
+            _standardModes->availableModesMonitorReceived(availableModesMonitor.seq);
+        }
+    }, QStringLiteral("Vehicle::availableModesMonitorReceived"));
+#endif // DAILY_BUILD
+
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_LOG_ENTRY, this, [this](LinkInterface* /* link */, mavlink_message_t& message) {
+        mavlink_log_entry_t log;
+        mavlink_msg_log_entry_decode(&message, &log);
+        emit logEntry(log.time_utc, log.size, log.id, log.num_logs, log.last_log_num);
+    }, QStringLiteral("Vehicle::logEntry"));
+    _messageDispatcher.subscribe(MAVLINK_MSG_ID_LOG_DATA, this, [this](LinkInterface* /* link */, mavlink_message_t& message) {
+        mavlink_log_data_t log;
+        mavlink_msg_log_data_decode(&message, &log);
+        emit logData(log.ofs, log.id, log.count, log.data);
+    }, QStringLiteral("Vehicle::logData"));
+}
+
+void Vehicle::_subscribeFactGroups(void)
+{
+    for (FactGroup* factGroup: factGroups()) {
+        if (_subscribedFactGroups.contains(factGroup)) {
+            continue;
+        }
+        _subscribedFactGroups.insert(factGroup);
+
+        for (uint32_t msgid: factGroup->handledMessageIds()) {
+            _messageDispatcher.subscribe(msgid, factGroup, [this, factGroup](LinkInterface* /* link */, mavlink_message_t& message) { factGroup->handleMessage(this, message); });
+        }
+    }
+}
+
 void Vehicle::_mavlinkMessageReceived(LinkInterface* link, mavlink_message_t message)
 {
     // If the link is already running at Mavlink V2 set our max proto version to it.
@@ -609,179 +736,9 @@ void Vehicle::_mavlinkMessageReceived(LinkInterface* link, mavlink_message_t mes
     if (!_terrainProtocolHandler->mavlinkMessageReceived(message)) {
         return;
     }
-    _ftpManager->_mavlinkMessageReceived(message);
-    _parameterManager->mavlinkMessageReceived(message);
-    _imageProtocolManager->mavlinkMessageReceived(message);
-    _remoteIDManager->mavlinkMessageReceived(message);
-
-    _waitForMavlinkMessageMessageReceived(message);
 
-    // Battery fact groups are created dynamically as new batteries are discovered
-    VehicleBatteryFactGroup::handleMessageForFactGroupCreation(this, message);
-
-    // Let the fact groups take a whack at the mavlink traffic
-    for (FactGroup* factGroup : factGroups()) {
-        factGroup->handleMessage(this, message);
-    }
-
-    switch (message.msgid) {
-    case MAVLINK_MSG_ID_HOME_POSITION:
-        _handleHomePosition(message);
-        break;
-    case MAVLINK_MSG_ID_HEARTBEAT:
-        _handleHeartbeat(message);
-        break;
-    case MAVLINK_MSG_ID_RADIO_STATUS:
-        _handleRadioStatus(message);
-        break;
-    case MAVLINK_MSG_ID_RC_CHANNELS:
-        _handleRCChannels(message);
-        break;
-    case MAVLINK_MSG_ID_BATTERY_STATUS:
-        _handleBatteryStatus(message);
-        break;
-    case MAVLINK_MSG_ID_SYS_STATUS:
-        _handleSysStatus(message);
-        break;
-    case MAVLINK_MSG_ID_RAW_IMU:
-        _handleRawImuTemp(message);
-        break;
-    case MAVLINK_MSG_ID_SCALED_IMU:
-        emit mavlinkScaledImu1(message);
-        break;
-    case MAVLINK_MSG_ID_SCALED_IMU2:
-        emit mavlinkScaledImu2(message);
-        break;
-    case MAVLINK_MSG_ID_SCALED_IMU3:
-        emit mavlinkScaledImu3(message);
-        break;
-    case MAVLINK_MSG_ID_EXTENDED_SYS_STATE:
-        _handleExtendedSysState(message);
-        break;
-    case MAVLINK_MSG_ID_COMMAND_ACK:
-        _handleCommandAck(message);
-        break;
-    case MAVLINK_MSG_ID_LOGGING_DATA:
-        _handleMavlinkLoggingData(message);
-        break;
-    case MAVLINK_MSG_ID_LOGGING_DATA_ACKED:
-        _handleMavlinkLoggingDataAcked(message);
-        break;
-    case MAVLINK_MSG_ID_GPS_RAW_INT:
-        _handleGpsRawInt(message);
-        break;
-    case MAVLINK_MSG_ID_GLOBAL_POSITION_INT:
-        _handleGlobalPositionInt(message);
-        break;
-    case MAVLINK_MSG_ID_ALTITUDE:
-        _handleAltitude(message);
-        break;
-    case MAVLINK_MSG_ID_VFR_HUD:
-        _handleVfrHud(message);
-        break;
-    case MAVLINK_MSG_ID_NAV_CONTROLLER_OUTPUT:
-        _handleNavControllerOutput(message);
-        break;
-    case MAVLINK_MSG_ID_CAMERA_IMAGE_CAPTURED:
-        _handleCameraImageCaptured(message);
-        break;
-    case MAVLINK_MSG_ID_ADSB_VEHICLE:
-        _handleADSBVehicle(message);
-        break;
-    case MAVLINK_MSG_ID_HIGH_LATENCY:
-        _handleHighLatency(message);
-        break;
-    case MAVLINK_MSG_ID_HIGH_LATENCY2:
-        _handleHighLatency2(message);
-        break;
-    case MAVLINK_MSG_ID_ATTITUDE:
-        _handleAttitude(message);
-        break;
-    case MAVLINK_MSG_ID_ATTITUDE_QUATERNION:
-        _handleAttitudeQuaternion(message);
-        break;
-    case MAVLINK_MSG_ID_STATUSTEXT:
-        _handleStatusText(message);
-        break;
-    case MAVLINK_MSG_ID_ORBIT_EXECUTION_STATUS:
-        _handleOrbitExecutionStatus(message);
-        break;
-    case MAVLINK_MSG_ID_PING:
-        _handlePing(link, message);
-        break;
-    case MAVLINK_MSG_ID_MOUNT_ORIENTATION:
-        _handleGimbalOrientation(message);
-        break;
-    case MAVLINK_MSG_ID_OBSTACLE_DISTANCE:
-        _handleObstacleDistance(message);
-        break;
-    case MAVLINK_MSG_ID_FENCE_STATUS:
-        _handleFenceStatus(message);
-        break;
-
-    case MAVLINK_MSG_ID_EVENT:
-    case MAVLINK_MSG_ID_CURRENT_EVENT_SEQUENCE:
-    case MAVLINK_MSG_ID_RESPONSE_EVENT_ERROR:
-        _eventHandler(message.compid).handleEvents(message);
-        break;
-
-    case MAVLINK_MSG_ID_SERIAL_CONTROL:
-    {
-        mavlink_serial_control_t ser;
-        mavlink_msg_serial_control_decode(&message, &ser);
-        if (static_cast<size_t>(ser.count) > sizeof(ser.data)) {
-            qWarning() << "Invalid count for SERIAL_CONTROL, discarding." << ser.count;
-        } else {
-            emit mavlinkSerialControl(ser.device, ser.flags, ser.timeout, ser.baudrate,
-                    QByteArray(reinterpret_cast<const char*>(ser.data), ser.count));
-        }
-    }
-        break;
-#ifdef DAILY_BUILD // Disable use of development/WIP MAVLink messages for release builds
-        case MAVLINK_MSG_ID_AVAILABLE_MODES_MONITOR:
-    {
-        // Avoid duplicate requests during initial connection setup
-        if (!_initialConnectStateMachine || !_initialConnectStateMachine->active()) {
-            mavlink_available_modes_monitor_t availableModesMonitor;
-            mavlink_msg_available_modes_monitor_decode(&message, &availableModesMonitor);
-            _standardModes->availableModesMonitorReceived(availableModesMonitor.seq);
-        }
-        break;
-    }
-    case MAVLINK_MSG_ID_CURRENT_MODE:
-        _handleCurrentMode(message);
-        break;
-#endif // DAILY_BUILD
-
-        // Following are ArduPilot dialect messages
-#if !defined(NO_ARDUPILOT_DIALECT)
-    case MAVLINK_MSG_ID_CAMERA_FEEDBACK:
-        _handleCameraFeedback(message);
-        break;
-    case MAVLINK_MSG_ID_RANGEFINDER:
-        _handleRangefinder(message);
-        break;
-#endif
-    case MAVLINK_MSG_ID_LOG_ENTRY:
-    {
-        mavlink_log_entry_t log;
-        mavlink_msg_log_entry_decode(&message, &log);
-        emit logEntry(log.time_utc, log.size, log.id, log.num_logs, log.last_log_num);
-        break;
-    }
-    case MAVLINK_MSG_ID_LOG_DATA:
-    {
-        mavlink_log_data_t log;
-        mavlink_msg_log_data_decode(&message, &log);
-        emit logData(log.ofs, log.id, log.count, log.data);
-        break;
-    }
-    case MAVLINK_MSG_ID_MESSAGE_INTERVAL:
-    {
-        _handleMessageInterval(message);
-        break;
-    }
-    }
+    // Everything else subscribes to the messages it handles, see _subscribeMessageHandlers
+    _messageDispatcher.dispatch(link, message);
 
     // This must be emitted after the vehicle processes the message. This way the vehicle state is up to date when anyone else
     // does processing.
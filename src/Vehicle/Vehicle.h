@@ -14,6 +14,7 @@
 #include <QVariantList>
 #include <QGeoCoordinate>
 #include <QTime>
+#include <QSet>
 #include <QSharedPointer>
 
 #include "FactGroup.h"
@@ -761,6 +762,9 @@ public:
     Autotune*                       autotune            () const { return _autotune; }
     RemoteIDManager*                remoteIDManager     () { return _remoteIDManager; }
 
+    /// Handlers for this vehicle's messages subscribe here, only after the vehicle's generic processing of the message
+    MAVLinkMessageDispatcher*       messageDispatcher   () { return &_messageDispatcher; }
+
     static const int cMaxRcChannels = 18;
 
     /// Sends the specified MAV_CMD to the vehicle. If no Ack is received command will be retried. If a sendMavCommand is already in progress
@@ -1138,6 +1142,10 @@ private:
     void _handleMavlinkLoggingData      (mavlink_message_t& message);
     void _handleMavlinkLoggingDataAcked (mavlink_message_t& message);
     void _ackMavlinkLogData             (uint16_t sequence);
+    void _subscribeMessageHandlers      (void);
+    void _subscribeFactGroups           (void);
+    template<typename Message>
+    void _subscribeMessage              (uint32_t msgid, const char* name, void (Vehicle::*handler)(Message& message));
     void _commonInit                    ();
     void _setupAutoDisarmSignalling     ();
     void _setCapabilities               (uint64_t capabilityBits);
@@ -1528,6 +1536,9 @@ private:
     RemoteIDManager*                _remoteIDManager            = nullptr;
     StandardModes*                  _standardModes              = nullptr;
 
+    MAVLinkMessageDispatcher        _messageDispatcher;
+    QSet<FactGroup*>                _subscribedFactGroups;
+
     static const int _vehicleUIUpdateRateMSecs      = 100;
 
     // Terrain query members, used to get terrain altitude for doSetHome()
@@ -56,25 +56,9 @@ VehicleBatteryFactGroup::VehicleBatteryFactGroup(uint8_t batteryId, QObject* par
     connect(&_timeRemainingFact, &Fact::rawValueChanged, this, &VehicleBatteryFactGroup::_timeRemainingChanged);
 }
 
-void VehicleBatteryFactGroup::handleMessageForFactGroupCreation(Vehicle* vehicle, mavlink_message_t& message)
-{
-    switch (message.msgid) {
-    case MAVLINK_MSG_ID_HIGH_LATENCY:
-    case MAVLINK_MSG_ID_HIGH_LATENCY2:
-        _findOrAddBatteryGroupById(vehicle, 0);
-        break;
-    case MAVLINK_MSG_ID_BATTERY_STATUS:
-    {
-        mavlink_battery_status_t batteryStatus;
-        mavlink_msg_battery_status_decode(&message, &batteryStatus);
-        _findOrAddBatteryGroupById(vehicle, batteryStatus.id);
-    }
-        break;
-    }
-}
-
-void VehicleBatteryFactGroup::handleMessage(Vehicle* vehicle, mavlink_message_t& message)
+void VehicleBatteryFactGroup::handleMessageForVehicle(Vehicle* vehicle, mavlink_message_t& message)
 {
+    // Each handler finds its battery's fact group by id, creating it if this is the first message for it
     switch (message.msgid) {
     case MAVLINK_MSG_ID_HIGH_LATENCY:
         _handleHighLatency(vehicle, message);
@@ -88,6 +72,16 @@ void VehicleBatteryFactGroup::handleMessage(Vehicle* vehicle, mavlink_message_t&
     }
 }
 
+QList<uint32_t> VehicleBatteryFactGroup::batteryMessageIds(void)
+{
+    return { MAVLINK_MSG_ID_HIGH_LATENCY, MAVLINK_MSG_ID_HIGH_LATENCY2, MAVLINK_MSG_ID_BATTERY_STATUS };
+}
+
+void VehicleBatteryFactGroup::handleMessage(Vehicle* vehicle, mavlink_message_t& message)
+{
+    handleMessageForVehicle(vehicle, message);
+}
+
 void VehicleBatteryFactGroup::_handleHighLatency(Vehicle* vehicle, mavlink_message_t& message)
 {
     mavlink_high_latency_t highLatency;
@@ -47,11 +47,15 @@ public:
     Fact* timeRemainingStr          () { return &_timeRemainingStrFact; }
     Fact* chargeState               () { return &_chargeStateFact; }
 
-    /// Creates a new fact group for the battery id as needed and updates the Vehicle with it
-    static void handleMessageForFactGroupCreation(Vehicle* vehicle, mavlink_message_t& message);
+    /// Updates the fact group for the message's battery id, creating it and adding it to the Vehicle as needed
+    static void handleMessageForVehicle(Vehicle* vehicle, mavlink_message_t& message);
+
+    /// @return Message ids handleMessageForVehicle handles
+    static QList<uint32_t> batteryMessageIds(void);
 
     // Overrides from FactGroup
-    void handleMessage(Vehicle* vehicle, mavlink_message_t& message) override;
+    void            handleMessage       (Vehicle* vehicle, mavlink_message_t& message) override;
+    QList<uint32_t> handledMessageIds   (void) const override { return { }; }    // The Vehicle calls handleMessageForVehicle once for all batteries
 
 private slots:
     void _timeRemainingChanged(QVariant value);
@@ -29,6 +29,9 @@ public:
     Fact* currentUTCTime () { return &_currentUTCTimeFact; }
     Fact* currentDate () { return &_currentDateFact; }
 
+    // Overrides from FactGroup
+    QList<uint32_t> handledMessageIds(void) const override { return { }; }    // Values come from the GCS clock
+
 
 
 private slots:
@@ -78,3 +78,8 @@ void VehicleDistanceSensorFactGroup::handleMessage(Vehicle* /* vehicle */, mavli
     maxDistance()->setRawValue(distanceSensor.max_distance / 100.0);
     _setTelemetryAvailable(true);
 }
+
+QList<uint32_t> VehicleDistanceSensorFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_DISTANCE_SENSOR };
+}
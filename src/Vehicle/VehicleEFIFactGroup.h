@@ -50,6 +50,7 @@ public:
 
     // Overrides from FactGroup
     virtual void handleMessage(Vehicle* vehicle, mavlink_message_t& message) override;
+    virtual QList<uint32_t> handledMessageIds(void) const override;
 
 private:
     void _handleEFIStatus(mavlink_message_t& message);
@@ -73,3 +73,8 @@ void VehicleEscStatusFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_me
     voltageThird()->setRawValue                 (content.voltage[2]);
     voltageFourth()->setRawValue                (content.voltage[3]);
 }
+
+QList<uint32_t> VehicleEscStatusFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_ESC_STATUS };
+}
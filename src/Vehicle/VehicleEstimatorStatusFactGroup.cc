@@ -87,3 +87,8 @@ void VehicleEstimatorStatusFactGroup::handleMessage(Vehicle* /* vehicle */, mavl
 
     _setTelemetryAvailable(true);
 }
+
+QList<uint32_t> VehicleEstimatorStatusFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_ESTIMATOR_STATUS };
+}
@@ -56,6 +56,11 @@ void VehicleGPSFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message_
     }
 }
 
+QList<uint32_t> VehicleGPSFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_GPS_RAW_INT, MAVLINK_MSG_ID_HIGH_LATENCY, MAVLINK_MSG_ID_HIGH_LATENCY2 };
+}
+
 void VehicleGPSFactGroup::_handleGpsRawInt(mavlink_message_t& message)
 {
     mavlink_gps_raw_int_t gpsRawInt;
@@ -56,3 +56,8 @@ void VehicleLocalPositionFactGroup::handleMessage(Vehicle* /* vehicle */, mavlin
 
     _setTelemetryAvailable(true);
 }
+
+QList<uint32_t> VehicleLocalPositionFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_LOCAL_POSITION_NED };
+}
@@ -56,3 +56,8 @@ void VehicleLocalPositionSetpointFactGroup::handleMessage(Vehicle* /* vehicle */
 
     _setTelemetryAvailable(true);
 }
+
+QList<uint32_t> VehicleLocalPositionSetpointFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_POSITION_TARGET_LOCAL_NED };
+}
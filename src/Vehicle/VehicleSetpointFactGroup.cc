@@ -61,3 +61,8 @@ void VehicleSetpointFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_mes
 
     _setTelemetryAvailable(true);
 }
+
+QList<uint32_t> VehicleSetpointFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_ATTITUDE_TARGET };
+}
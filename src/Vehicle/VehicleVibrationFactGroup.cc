@@ -50,3 +50,8 @@ void VehicleVibrationFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_me
     _setTelemetryAvailable(true);
 }
 
+QList<uint32_t> VehicleVibrationFactGroup::handledMessageIds(void) const
+{
+    return { MAVLINK_MSG_ID_VIBRATION };
+}
+
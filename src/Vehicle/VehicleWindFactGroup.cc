@@ -50,6 +50,18 @@ void VehicleWindFactGroup::handleMessage(Vehicle* /* vehicle */, mavlink_message
     }
 }
 
+QList<uint32_t> VehicleWindFactGroup::handledMessageIds(void) const
+{
+    return {
+        MAVLINK_MSG_ID_WIND_COV,
+#if !defined(NO_ARDUPILOT_DIALECT)
+        MAVLINK_MSG_ID_WIND,
+#endif
+        MAVLINK_MSG_ID_HIGH_LATENCY,
+        MAVLINK_MSG_ID_HIGH_LATENCY2,
+    };
+}
+
 void VehicleWindFactGroup::_handleHighLatency(mavlink_message_t& message)
 {
     mavlink_high_latency_t highLatency;
@@ -29,6 +29,13 @@ LinkInterface::LinkInterface(SharedLinkConfigurationPtr& config, bool isPX4Flow)
 
     // This will cause the writeBytes calls to end up on the thread of the link
     QObject::connect(this, &LinkInterface::_invokeWriteBytes, this, &LinkInterface::_writeBytes);
+    // Connected after _writeBytes so it runs once the write is done
+    QObject::connect(this, &LinkInterface::_invokeWriteBytes, this, [this](QByteArray bytes) {
+        _pendingWriteBytes -= bytes.length();
+        _totalBytesWritten += bytes.length();
+    });
+    // Counted on whichever thread the link emits from
+    QObject::connect(this, &LinkInterface::bytesReceived, this, [this](LinkInterface*, QByteArray bytes) { _totalBytesReceived += bytes.length(); }, Qt::DirectConnection);
 }
 
 LinkInterface::~LinkInterface()
@@ -85,7 +92,13 @@ void LinkInterface::_freeMavlinkChannel()
 
 void LinkInterface::writeBytesThreadSafe(const char *bytes, int length)
 {
-    emit _invokeWriteBytes(QByteArray(bytes, length));
+    writeBytesThreadSafe(QByteArray(bytes, length));
+}
+
+void LinkInterface::writeBytesThreadSafe(const QByteArray& bytes)
+{
+    _pendingWriteBytes += bytes.length();
+    emit _invokeWriteBytes(bytes);
 }
 
 void LinkInterface::addVehicleReference(void)
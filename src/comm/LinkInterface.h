@@ -12,6 +12,7 @@
 #include <QThread>
 #include <QLoggingCategory>
 
+#include <atomic>
 #include <memory>
 
 #include "LinkConfiguration.h"
@@ -58,9 +59,17 @@ public:
     bool    decodedFirstMavlinkPacket   (void) const { return _decodedFirstMavlinkPacket; }
     bool    setDecodedFirstMavlinkPacket(bool decodedFirstMavlinkPacket) { return _decodedFirstMavlinkPacket = decodedFirstMavlinkPacket; }
     void    writeBytesThreadSafe        (const char *bytes, int length);
+    void    writeBytesThreadSafe        (const QByteArray& bytes);  ///< bytes is shared with the link thread, not copied
     void    addVehicleReference         (void);
     void    removeVehicleReference      (void);
 
+    /// @return Bytes passed to writeBytesThreadSafe which the link thread has not written yet. Can be called from any thread.
+    qint64  pendingWriteBytes           (void) const { return _pendingWriteBytes; }
+
+    /// @return Totals since the link was created, for throughput. Can be called from any thread.
+    quint64 totalBytesReceived          (void) const { return _totalBytesReceived; }
+    quint64 totalBytesWritten           (void) const { return _totalBytesWritten; }
+
 signals:
     void bytesReceived      (LinkInterface* link, QByteArray data);
     void bytesSent          (LinkInterface* link, QByteArray data);
@@ -99,6 +108,10 @@ private:
     bool    _decodedFirstMavlinkPacket  = false;
     bool    _isPX4Flow                  = false;
     int     _vehicleReferenceCount      = 0;
+
+    std::atomic<qint64>     _pendingWriteBytes  { 0 };
+    std::atomic<quint64>    _totalBytesReceived { 0 };
+    std::atomic<quint64>    _totalBytesWritten  { 0 };
 };
 
 typedef std::shared_ptr<LinkInterface>  SharedLinkInterfacePtr;
@@ -160,10 +160,10 @@ bool LinkManager::createConnectedLink(SharedLinkConfigurationPtr& config, bool i
         config->setLink(link);
 
         connect(link.get(), &LinkInterface::communicationError,  _app,                &QGCApplication::criticalMessageBoxOnMainThread);
-        connect(link.get(), &LinkInterface::bytesReceived,       _mavlinkProtocol,    &MAVLinkProtocol::receiveBytes);
         connect(link.get(), &LinkInterface::bytesSent,           _mavlinkProtocol,    &MAVLinkProtocol::logSentBytes);
         connect(link.get(), &LinkInterface::disconnected,        this,                &LinkManager::_linkDisconnected);
 
+        _mavlinkProtocol->connectLink(link.get());
         _mavlinkProtocol->resetMetadataForLink(link.get());
         _mavlinkProtocol->setVersion(_mavlinkProtocol->getCurrentVersion());
 
@@ -222,9 +222,9 @@ void LinkManager::_linkDisconnected(void)
     }
 
     disconnect(link, &LinkInterface::communicationError,  _app,                &QGCApplication::criticalMessageBoxOnMainThread);
-    disconnect(link, &LinkInterface::bytesReceived,       _mavlinkProtocol,    &MAVLinkProtocol::receiveBytes);
     disconnect(link, &LinkInterface::bytesSent,           _mavlinkProtocol,    &MAVLinkProtocol::logSentBytes);
     disconnect(link, &LinkInterface::disconnected,        this,                &LinkManager::_linkDisconnected);
+    _mavlinkProtocol->disconnectLink(link);
 
     link->_freeMavlinkChannel();
     for (int i=0; i<_rgLinks.count(); i++) {
@@ -944,10 +944,11 @@ void LinkManager::freeMavlinkChannel(uint8_t channel)
     _mavlinkChannelsUsedBitMask &= ~(1 << channel);
 }
 
-LogReplayLink* LinkManager::startLogReplay(const QString& logFile)
+LogReplayLink* LinkManager::startLogReplay(const QString& logFile, bool fastAsPossible)
 {
     LogReplayLinkConfiguration* linkConfig = new LogReplayLinkConfiguration(tr("Log Replay"));
     linkConfig->setLogFilename(logFile);
+    linkConfig->setFastAsPossible(fastAsPossible);
     linkConfig->setName(linkConfig->logFilenameShort());
 
     SharedLinkConfigurationPtr sharedConfig = addConfiguration(linkConfig);
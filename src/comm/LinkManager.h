@@ -71,7 +71,8 @@ public:
     // Called to signal app shutdown. Disconnects all links while turning off auto-connect.
     Q_INVOKABLE void shutdown(void);
 
-    Q_INVOKABLE LogReplayLink* startLogReplay(const QString& logFile);
+    /// @param fastAsPossible true: Replay without pacing to log time, for headless analysis
+    Q_INVOKABLE LogReplayLink* startLogReplay(const QString& logFile, bool fastAsPossible = false);
 
     // Property accessors
 
@@ -109,6 +110,9 @@ public:
     /// Returns pointer to the mavlink support forwarding link, or nullptr if it does not exist
     SharedLinkInterfacePtr mavlinkForwardingSupportLink();
 
+    static const char* mavlinkForwardingLinkName       (void) { return _mavlinkForwardingLinkName; }
+    static const char* mavlinkForwardingSupportLinkName(void) { return _mavlinkForwardingSupportLinkName; }
+
     void disconnectAll(void);
 
 #ifdef QT_DEBUG
@@ -11,11 +11,16 @@
 #include "LogReplayLink.h"
 #include "LinkManager.h"
 #include "QGCApplication.h"
+#include "QGCLoggingCategory.h"
 
+#include <QDir>
 #include <QFileInfo>
-#include <QSignalSpy>
+#include <QStandardPaths>
 
-const char*  LogReplayLinkConfiguration::_logFilenameKey = "logFilename";
+QGC_LOGGING_CATEGORY(LogReplayLinkLog, "LogReplayLinkLog")
+
+const char*  LogReplayLinkConfiguration::_logFilenameKey    = "logFilename";
+const char*  LogReplayLinkConfiguration::_fastAsPossibleKey = "fastAsPossible";
 
 LogReplayLinkConfiguration::LogReplayLinkConfiguration(const QString& name)
     : LinkConfiguration(name)
@@ -26,7 +31,8 @@ LogReplayLinkConfiguration::LogReplayLinkConfiguration(const QString& name)
 LogReplayLinkConfiguration::LogReplayLinkConfiguration(LogReplayLinkConfiguration* copy)
     : LinkConfiguration(copy)
 {
-    _logFilename = copy->logFilename();
+    _logFilename    = copy->logFilename();
+    _fastAsPossible = copy->fastAsPossible();
 }
 
 void LogReplayLinkConfiguration::copyFrom(LinkConfiguration *source)
@@ -34,7 +40,8 @@ void LogReplayLinkConfiguration::copyFrom(LinkConfiguration *source)
     LinkConfiguration::copyFrom(source);
     auto* ssource = qobject_cast<LogReplayLinkConfiguration*>(source);
     if (ssource) {
-        _logFilename = ssource->logFilename();
+        _logFilename    = ssource->logFilename();
+        _fastAsPossible = ssource->fastAsPossible();
     } else {
         qWarning() << "Internal error";
     }
@@ -44,13 +51,15 @@ void LogReplayLinkConfiguration::saveSettings(QSettings& settings, const QString
 {
     settings.beginGroup(root);
     settings.setValue(_logFilenameKey, _logFilename);
+    settings.setValue(_fastAsPossibleKey, _fastAsPossible);
     settings.endGroup();
 }
 
 void LogReplayLinkConfiguration::loadSettings(QSettings& settings, const QString& root)
 {
     settings.beginGroup(root);
-    _logFilename = settings.value(_logFilenameKey, "").toString();
+    _logFilename    = settings.value(_logFilenameKey, "").toString();
+    _fastAsPossible = settings.value(_fastAsPossibleKey, false).toBool();
     settings.endGroup();
 }
 
@@ -64,19 +73,22 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPtr& config)
     : LinkInterface              (config)
     , _logReplayConfig           (qobject_cast<LogReplayLinkConfiguration*>(config.get()))
     , _connected                 (false)
-    , _mavlinkChannel            (0)
     , _logCurrentTimeUSecs       (0)
     , _logStartTimeUSecs         (0)
     , _logEndTimeUSecs           (0)
     , _logDurationUSecs          (0)
     , _playbackSpeed             (1)
+    , _fastAsPossible            (false)
     , _playbackStartTimeMSecs    (0)
     , _playbackStartLogTimeUSecs (0)
-    , _mavlink                   (nullptr)
+    , _mavlink                   (qgcApp()->toolbox()->mavlinkProtocol())
     , _logFileSize               (0)
+    , _nextEntry                 (0)
 {
     if (!_logReplayConfig) {
         qWarning() << "Internal error";
+    } else {
+        _fastAsPossible = _logReplayConfig->fastAsPossible();
     }
 
     _errorTitle = tr("Log Replay Error");
@@ -86,6 +98,7 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPtr& config)
     QObject::connect(&_readTickTimer, &QTimer::timeout,                 this, &LogReplayLink::_readNextLogEntry);
     QObject::connect(this, &LogReplayLink::_playOnThread,               this, &LogReplayLink::_play);
     QObject::connect(this, &LogReplayLink::_pauseOnThread,              this, &LogReplayLink::_pause);
+    QObject::connect(this, &LogReplayLink::_movePlayheadOnThread,       this, &LogReplayLink::_movePlayhead);
     QObject::connect(this, &LogReplayLink::_setPlaybackSpeedOnThread,   this, &LogReplayLink::_setPlaybackSpeed);
     
     moveToThread(this);
@@ -153,106 +166,35 @@ void LogReplayLink::_writeBytes(const QByteArray bytes)
     Q_UNUSED(bytes);
 }
 
-/// Parses a BigEndian quint64 timestamp
-/// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
-quint64 LogReplayLink::_parseTimestamp(const QByteArray& bytes)
-{
-    quint64 timestamp = qFromBigEndian(*((quint64*)(bytes.constData())));
-    quint64 currentTimestamp = ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
-    
-    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
-    // little endian, so switch it.
-    if (timestamp > currentTimestamp) {
-        timestamp = qbswap(timestamp);
-    }
-    
-    return timestamp;
-}
-
-/// Reads the next mavlink message from the log
-///     @param bytes[output] Bytes for mavlink message
-/// @return Unix timestamp in microseconds UTC for NEXT mavlink message or 0 if no message found
-quint64 LogReplayLink::_readNextMavlinkMessage(QByteArray& bytes)
+/// Opens the index recorded with the log, or the one saved by an earlier replay. If neither is usable the log is
+/// indexed now and the index saved next to it, or in the temp directory if the log's directory is read only.
+bool LogReplayLink::_loadIndex(const QString& logFilename, QString& errorMsg)
 {
-    char                nextByte;
-    mavlink_status_t    status;
-
-    bytes.clear();
-
-    while (_logFile.getChar(&nextByte)) { // Loop over every byte
-        mavlink_message_t message;
-        bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, &message, &status);
+    QStringList indexFilenames = {
+        MAVLinkLogIndex::indexFileName(logFilename),
+        QDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation)).absoluteFilePath(MAVLinkLogIndex::indexFileName(QFileInfo(logFilename).fileName())),
+    };
 
-        if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
-            // This is the possible beginning of a mavlink message, clear any partial bytes
-            bytes.clear();
-        }
-        bytes.append(nextByte);
-
-        if (messageFound) {
-            // Return the timestamp for the next message
-            QByteArray rawTime = _logFile.read(cbTimestamp);
-            return _parseTimestamp(rawTime);
+    for (const QString& indexFilename: indexFilenames) {
+        QString indexError;
+        if (_index.open(indexFilename, indexError) && _index.coversLog(_logFile)) {
+            qCDebug(LogReplayLinkLog) << "Using index" << indexFilename << _index.count();
+            return true;
         }
+        _index.close();
     }
 
-    return 0;
-}
-
-/// Seeks to the beginning of the next successfully parsed mavlink message in the log file.
-///     @param nextMsg[output] Parsed next message that was found
-/// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
-quint64 LogReplayLink::_seekToNextMavlinkMessage(mavlink_message_t* nextMsg)
-{
-    char                nextByte;
-    mavlink_status_t    status;
-    qint64              messageStartPos = -1;
-
-    mavlink_reset_channel_status(_mavlinkChannel);
-
-    while (_logFile.getChar(&nextByte)) {
-        bool messageFound = mavlink_parse_char(_mavlinkChannel, nextByte, nextMsg, &status);
-
-        if (status.parse_state == MAVLINK_PARSE_STATE_GOT_STX) {
-            // This is the possible beginning of a mavlink message
-            messageStartPos = _logFile.pos() - 1;
-        }
-        
-        // If we've found a message, jump back to the start of the message, grab the timestamp,
-        // and go back to the end of this file.
-        if (messageFound && messageStartPos != -1) {
-            _logFile.seek(messageStartPos - cbTimestamp);
-            QByteArray rawTime = _logFile.read(cbTimestamp);
-            return _parseTimestamp(rawTime);
+    for (const QString& indexFilename: indexFilenames) {
+        QElapsedTimer indexTimer;
+        indexTimer.start();
+        if (MAVLinkLogIndex::build(logFilename, indexFilename, errorMsg) && _index.open(indexFilename, errorMsg)) {
+            qCDebug(LogReplayLinkLog) << "Indexed" << logFilename << _index.count() << "records in" << indexTimer.elapsed() << "msecs";
+            return true;
         }
+        qCDebug(LogReplayLinkLog) << "Index build failed" << errorMsg;
     }
-    
-    return 0;
-}
-
-quint64 LogReplayLink::_findLastTimestamp(void)
-{
-    char                nextByte;
-    mavlink_status_t    status;
-    quint64             lastTimestamp = 0;
-    mavlink_message_t   msg;
-
-    // We read through the entire file looking for the last good timestamp. This can be somewhat slow, but trying to work from the
-    // end of the file can be way slower due to all the seeking back and forth required. So instead we take the simple reliable approach.
-
-    _logFile.reset();
-    mavlink_reset_channel_status(_mavlinkChannel);
 
-    while (_logFile.bytesAvailable() > cbTimestamp) {
-        lastTimestamp = _parseTimestamp(_logFile.read(cbTimestamp));
-
-        bool endOfMessage = false;
-        while (!endOfMessage && _logFile.getChar(&nextByte)) {
-            endOfMessage = mavlink_parse_char(_mavlinkChannel, nextByte, &msg, &status);
-        }
-    }
-
-    return lastTimestamp;
+    return false;
 }
 
 bool LogReplayLink::_loadLogFile(void)
@@ -261,8 +203,6 @@ bool LogReplayLink::_loadLogFile(void)
     QString logFilename = _logReplayConfig->logFilename();
     QFileInfo logFileInfo;
     int logDurationSecondsTotal;
-    quint64 startTimeUSecs;
-    quint64 endTimeUSecs;
 
     if (_logFile.isOpen()) {
         errorMsg = tr("Attempt to load new log while log being played");
@@ -276,23 +216,21 @@ bool LogReplayLink::_loadLogFile(void)
     }
     logFileInfo.setFile(logFilename);
     _logFileSize = logFileInfo.size();
-    
-    startTimeUSecs = _parseTimestamp(_logFile.read(cbTimestamp));
-    endTimeUSecs = _findLastTimestamp();
 
-    if (endTimeUSecs <= startTimeUSecs) {
+    if (!_loadIndex(logFilename, errorMsg)) {
+        goto Error;
+    }
+
+    if (_index.count() == 0 || _index.endTimeUsecs() <= _index.startTimeUsecs()) {
         errorMsg = tr("The log file '%1' is corrupt or empty.").arg(logFilename);
         goto Error;
     }
 
     // Remember the start and end time so we can move around this _logFile with the slider.
-    _logEndTimeUSecs = endTimeUSecs;
-    _logStartTimeUSecs = startTimeUSecs;
-    _logDurationUSecs = endTimeUSecs - startTimeUSecs;
-    _logCurrentTimeUSecs = startTimeUSecs;
-
-    // Reset our log file so when we go to read it for the first time, we start at the beginning.
-    _logFile.reset();
+    _logEndTimeUSecs = _index.endTimeUsecs();
+    _logStartTimeUSecs = _index.startTimeUsecs();
+    _logDurationUSecs = _index.durationUsecs();
+    _resetPlaybackToBeginning();
 
     logDurationSecondsTotal = (_logDurationUSecs) / 1000000;
     
@@ -301,6 +239,7 @@ bool LogReplayLink::_loadLogFile(void)
     return true;
     
 Error:
+    _index.close();
     if (_logFile.isOpen()) {
         _logFile.close();
     }
@@ -308,48 +247,87 @@ Error:
     return false;
 }
 
-/// This function will read the next available log entry. It will then start
-/// the _readTickTimer timer to read the new log entry at the appropriate time.
-/// It might not perfectly match the timing of the log file, but it will never
-/// induce a static drift into the log file replay.
-void LogReplayLink::_readNextLogEntry(void)
+/// @return File offset just past the end of the record for the index entry
+quint64 LogReplayLink::_entryEndOffset(int entry) const
 {
-    QByteArray bytes;
+    return entry + 1 < _index.count() ? _index.entry(entry + 1).offset : _logFileSize;
+}
 
-    // Now parse MAVLink messages, grabbing their timestamps as we go. We stop once we
-    // have at least 3ms until the next one.
+/// Sends the records from _nextEntry up to, but not including, endEntry. Records are contiguous in the log, so each
+/// batch is a single read with the timestamps stripped out, emitted as a single bytesReceived.
+///     @param maxBytes Stop once this much has been sent, the rest goes out on the next tick
+/// @return false: log read failed
+bool LogReplayLink::_deliverEntries(int endEntry, qint64 maxBytes)
+{
+    qint64 deliveredBytes = 0;
 
-    // We track what the next execution time should be in milliseconds, which we use to set
-    // the next timer interrupt.
-    int timeToNextExecutionMSecs = 0;
+    while (_nextEntry < endEntry && deliveredBytes < maxBytes) {
+        quint64 batchStart  = _index.entry(_nextEntry).offset;
+        int     batchEnd    = _nextEntry + 1;
+        while (batchEnd < endEntry && static_cast<qint64>(_entryEndOffset(batchEnd) - batchStart) <= _maxBatchBytes) {
+            batchEnd++;
+        }
 
-    while (timeToNextExecutionMSecs < 3) {
-        // Read the next mavlink message from the log
-        qint64 nextTimeUSecs = _readNextMavlinkMessage(bytes);
-        emit bytesReceived(this, bytes);
-        emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
+        qint64      batchLength = static_cast<qint64>(_entryEndOffset(batchEnd - 1) - batchStart);
+        QByteArray  records;
+        if (_logFile.seek(static_cast<qint64>(batchStart))) {
+            records = _logFile.read(batchLength);
+        }
+        if (records.length() != batchLength) {
+            _replayError(tr("Unable to read log file: %1").arg(_logFile.errorString()));
+            return false;
+        }
 
-        if (_logFile.atEnd()) {
-            _finishPlayback();
-            return;
+        QByteArray bytes;
+        bytes.reserve(records.length());
+        for (int i=_nextEntry; i<batchEnd; i++) {
+            qint64 recordStart  = static_cast<qint64>(_index.entry(i).offset - batchStart);
+            qint64 recordEnd    = static_cast<qint64>(_entryEndOffset(i) - batchStart);
+            if (recordEnd > recordStart + cbTimestamp) {
+                bytes.append(records.constData() + recordStart + cbTimestamp, recordEnd - recordStart - cbTimestamp);
+            }
         }
+        emit bytesReceived(this, bytes);
 
-        _logCurrentTimeUSecs = nextTimeUSecs;
+        _logCurrentTimeUSecs = _index.entry(batchEnd - 1).timeUsecs;
+        _nextEntry = batchEnd;
+        deliveredBytes += batchLength;
+    }
 
-        // Calculate how long we should wait in real time until parsing this message.
-        // We pace ourselves relative to the start time of playback to fix any drift (initially set in play())
+    return true;
+}
 
-        quint64 currentTimeMSecs =                  (quint64)QDateTime::currentMSecsSinceEpoch();
-        quint64 desiredPlayheadMovementTimeMSecs =  ((_logCurrentTimeUSecs - _playbackStartLogTimeUSecs) / 1000) / _playbackSpeed;
-        quint64 desiredCurrentTimeMSecs =           _playbackStartTimeMSecs + desiredPlayheadMovementTimeMSecs;
+/// Called on each tick of _readTickTimer. Sends everything which has come due since the last tick. Pacing is relative
+/// to the start time of playback, so it might not perfectly match the timing of the log file, but it will never
+/// induce a static drift into the log file replay.
+void LogReplayLink::_readNextLogEntry(void)
+{
+    int endEntry;
 
-        timeToNextExecutionMSecs = desiredCurrentTimeMSecs - currentTimeMSecs;
+    if (_fastAsPossible) {
+        // Hold off while the ingest thread is still working through earlier batches
+        if (_mavlink->ingestBacklogBytes() > _maxIngestBacklogBytes) {
+            return;
+        }
+        endEntry = _index.count();
+    } else {
+        quint64 currentTimeMSecs =          (quint64)QDateTime::currentMSecsSinceEpoch();
+        quint64 playheadMovementUSecs =     ((currentTimeMSecs - _playbackStartTimeMSecs) * 1000) * _playbackSpeed;
+        endEntry = _index.entryIndexForTime(_playbackStartLogTimeUSecs + playheadMovementUSecs + 1);
     }
 
-    _signalCurrentLogTimeSecs();
+    if (!_deliverEntries(endEntry, _maxTickBytes)) {
+        _pause();
+        return;
+    }
+
+    if (_nextEntry >= _index.count()) {
+        _signalPlaybackPosition(true);
+        _finishPlayback();
+        return;
+    }
 
-    // And schedule the next execution of this function.
-    _readTickTimer.start(timeToNextExecutionMSecs);
+    _signalPlaybackPosition(false);
 }
 
 void LogReplayLink::_play(void)
@@ -360,13 +338,13 @@ void LogReplayLink::_play(void)
 #endif
     
     // Make sure we aren't at the end of the file, if we are, reset to the beginning and play from there.
-    if (_logFile.atEnd()) {
+    if (_nextEntry >= _index.count()) {
         _resetPlaybackToBeginning();
     }
     
     _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch();
     _playbackStartLogTimeUSecs = _logCurrentTimeUSecs;
-    _readTickTimer.start(1);
+    _readTickTimer.start(_fastAsPossible ? _fastTickMsecs : _tickMsecs);
     
     emit playbackStarted();
 }
@@ -385,9 +363,7 @@ void LogReplayLink::_pause(void)
 
 void LogReplayLink::_resetPlaybackToBeginning(void)
 {
-    if (_logFile.isOpen()) {
-        _logFile.reset();
-    }
+    _nextEntry = 0;
     
     // And since we haven't starting playback, clear the time of initial playback and the current timestamp.
     _playbackStartTimeMSecs = 0;
@@ -395,15 +371,10 @@ void LogReplayLink::_resetPlaybackToBeginning(void)
     _logCurrentTimeUSecs = _logStartTimeUSecs;
 }
 
-void LogReplayLink::movePlayhead(qreal percentComplete)
+void LogReplayLink::_movePlayhead(qreal percentComplete)
 {
     if (isPlaying()) {
-        _pauseOnThread();
-        QSignalSpy waitForPause(this, SIGNAL(playbackPaused()));
-        waitForPause.wait();
-        if (_readTickTimer.isActive()) {
-            return;
-        }
+        _pause();
     }
 
     if (percentComplete < 0) {
@@ -412,58 +383,23 @@ void LogReplayLink::movePlayhead(qreal percentComplete)
     if (percentComplete > 100) {
         percentComplete = 100;
     }
-    
-    qreal percentCompleteMult = percentComplete / 100.0;
-    
-    // But if we have a timestamped MAVLink log, then actually aim to hit that percentage in terms of
-    // time through the file.
-    qint64 newFilePos = (qint64)(percentCompleteMult * (qreal)_logFile.size());
-
-    // Now seek to the appropriate position, failing gracefully if we can't.
-    if (!_logFile.seek(newFilePos)) {
-        _replayError(tr("Unable to seek to new position"));
-        return;
-    }
 
-    // But we do align to the next MAVLink message for consistency.
-    mavlink_message_t dummy;
-    _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
+    quint64 desiredTimeUSecs = _logStartTimeUSecs + static_cast<quint64>((percentComplete / 100.0) * _logDurationUSecs);
 
-    // Now calculate the current file location based on time.
-    qreal newRelativeTimeUSecs = (qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs);
+    _nextEntry = _index.entryIndexForTime(desiredTimeUSecs);
+    _logCurrentTimeUSecs = _nextEntry < _index.count() ? _index.entry(_nextEntry).timeUsecs : _logEndTimeUSecs;
 
-    // Calculate the effective baud rate of the file in bytes/s.
-    qreal baudRate = _logFile.size() / (qreal)_logDurationUSecs / 1e6;
-
-    // And the desired time is:
-    qreal desiredTimeUSecs = percentCompleteMult * _logDurationUSecs;
-
-    // And now jump the necessary number of bytes in the proper direction
-    qint64 offset = (newRelativeTimeUSecs - desiredTimeUSecs) * baudRate;
-    if (!_logFile.seek(_logFile.pos() + offset)) {
-        _replayError(tr("Unable to seek to new position"));
-        return;
-    }
-
-    // And scan until we reach the start of a MAVLink message. We make sure to record this timestamp for
-    // smooth jumping around the file.
-    _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
-    _signalCurrentLogTimeSecs();
-
-    // Now update the UI with our actual final position.
-    newRelativeTimeUSecs = (qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs);
-    percentComplete = (newRelativeTimeUSecs / _logDurationUSecs) * 100;
-    emit playbackPercentCompleteChanged(percentComplete);
+    // Update the UI with our actual final position
+    _signalPlaybackPosition(true);
 }
 
 void LogReplayLink::_setPlaybackSpeed(qreal playbackSpeed)
 {
     _playbackSpeed = playbackSpeed;
     
-    // Let _readNextLogEntry update to correct speed
+    // Pace from the current position at the new speed
     _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch();
     _playbackStartLogTimeUSecs = _logCurrentTimeUSecs;
-    _readTickTimer.start(1);
 }
 
 /// @brief Called when playback is complete
@@ -474,8 +410,15 @@ void LogReplayLink::_finishPlayback(void)
     emit playbackAtEnd();
 }
 
-void LogReplayLink::_signalCurrentLogTimeSecs(void)
+/// Playback position signals drive the UI, so during playback they are limited to one every _positionSignalMsecs
+void LogReplayLink::_signalPlaybackPosition(bool force)
 {
+    if (!force && _positionSignalTimer.isValid() && _positionSignalTimer.elapsed() < _positionSignalMsecs) {
+        return;
+    }
+    _positionSignalTimer.start();
+
+    emit playbackPercentCompleteChanged(((qreal)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (qreal)_logDurationUSecs) * 100);
     emit currentLogTimeSecs((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000000);
 }
 
@@ -10,18 +10,23 @@
 #pragma once
 
 #include "MAVLinkProtocol.h"
+#include "MAVLinkLogIndex.h"
 
 #include <QTimer>
 #include <QFile>
+#include <QElapsedTimer>
 
 class LinkManager;
 
+Q_DECLARE_LOGGING_CATEGORY(LogReplayLinkLog)
+
 class LogReplayLinkConfiguration : public LinkConfiguration
 {
     Q_OBJECT
 
 public:
-    Q_PROPERTY(QString  fileName    READ logFilename    WRITE setLogFilename    NOTIFY fileNameChanged)
+    Q_PROPERTY(QString  fileName        READ logFilename    WRITE setLogFilename        NOTIFY fileNameChanged)
+    Q_PROPERTY(bool     fastAsPossible  READ fastAsPossible WRITE setFastAsPossible     NOTIFY fastAsPossibleChanged)
 
     LogReplayLinkConfiguration(const QString& name);
     LogReplayLinkConfiguration(LogReplayLinkConfiguration* copy);
@@ -31,6 +36,10 @@ public:
 
     QString logFilenameShort(void);
 
+    /// true: Ignore log timing and feed the log through as fast as the application takes it in. For headless analysis.
+    bool fastAsPossible(void) const { return _fastAsPossible; }
+    void setFastAsPossible(bool fastAsPossible) { _fastAsPossible = fastAsPossible; emit fastAsPossibleChanged(); }
+
     // Virtuals from LinkConfiguration
     LinkType    type                    (void) override                                         { return LinkConfiguration::TypeLogReplay; }
     void        copyFrom                (LinkConfiguration* source) override;
@@ -41,13 +50,21 @@ public:
 
 signals:
     void fileNameChanged();
+    void fastAsPossibleChanged();
 
 private:
     static const char*  _logFilenameKey;
+    static const char*  _fastAsPossibleKey;
     QString             _logFilename;
+    bool                _fastAsPossible = false;
 };
 
 /// Pseudo link that reads a telemetry log and feeds it into the application.
+///
+/// The log is indexed up front (see MAVLinkLogIndex), either from the index recorded alongside it or with a one time
+/// pass which is saved next to the log for the next replay. Seeking is then a lookup in the index. Playback runs off
+/// a fixed tick, each tick delivering all the records which have come due as a single batch, so high speed playback
+/// costs a handful of signals per tick rather than one per message. Position updates to the UI are rate limited.
 class LogReplayLink : public LinkInterface
 {
     Q_OBJECT
@@ -61,7 +78,9 @@ public:
 
     void play           (void) { emit _playOnThread(); }
     void pause          (void) { emit _pauseOnThread(); }
-    void movePlayhead   (qreal percentComplete);
+
+    /// Pauses playback and moves to the first message at or after the specified point in the log
+    void movePlayhead   (qreal percentComplete) { emit _movePlayheadOnThread(percentComplete); }
 
     // overrides from LinkInterface
     bool isConnected(void) const override { return _connected; }
@@ -69,7 +88,7 @@ public:
     void disconnect (void) override;
 
 public slots:
-    /// Sets the acceleration factor: -100: 0.01X, 0: 1.0X, 100: 100.0X
+    /// Sets the playback speed multiplier, up to 100.0X
     void setPlaybackSpeed(qreal playbackSpeed) { emit _setPlaybackSpeedOnThread(playbackSpeed); }
 
 signals:
@@ -83,6 +102,7 @@ signals:
     // Internal signals
     void _playOnThread              (void);
     void _pauseOnThread             (void);
+    void _movePlayheadOnThread      (qreal percentComplete);
     void _setPlaybackSpeedOnThread  (qreal playbackSpeed);
 
 private slots:
@@ -92,6 +112,7 @@ private slots:
     void _readNextLogEntry  (void);
     void _play              (void);
     void _pause             (void);
+    void _movePlayhead      (qreal percentComplete);
     void _setPlaybackSpeed  (qreal playbackSpeed);
 
 private:
@@ -100,14 +121,13 @@ private:
     bool _connect(void) override;
 
     void    _replayError                (const QString& errorMsg);
-    quint64 _parseTimestamp             (const QByteArray& bytes);
-    quint64 _seekToNextMavlinkMessage   (mavlink_message_t* nextMsg);
-    quint64 _findLastTimestamp          (void);
-    quint64 _readNextMavlinkMessage     (QByteArray& bytes);
     bool    _loadLogFile                (void);
+    bool    _loadIndex                  (const QString& logFilename, QString& errorMsg);
+    bool    _deliverEntries             (int endEntry, qint64 maxBytes);
+    quint64 _entryEndOffset             (int entry) const;
     void    _finishPlayback             (void);
     void    _resetPlaybackToBeginning   (void);
-    void    _signalCurrentLogTimeSecs   (void);
+    void    _signalPlaybackPosition     (bool force);
 
     // QThread overrides
     void run(void) override;
@@ -115,25 +135,35 @@ private:
     LogReplayLinkConfiguration* _logReplayConfig;
 
     bool    _connected;
-    uint8_t _mavlinkChannel;
-    QTimer  _readTickTimer;      ///< Timer which signals a read of next log record
+    QTimer  _readTickTimer;      ///< Timer which signals a read of the log records which have come due
 
     QString _errorTitle; ///< Title for communicatorError signals
 
-    quint64 _logCurrentTimeUSecs;   ///< The timestamp of the next message in the log file.
+    quint64 _logCurrentTimeUSecs;   ///< The timestamp of the last message delivered, or of the next one after a seek
     quint64 _logStartTimeUSecs;     ///< The first timestamp in the current log file.
     quint64 _logEndTimeUSecs;       ///< The last timestamp in the current log file.
     quint64 _logDurationUSecs;
 
     qreal   _playbackSpeed;
+    bool    _fastAsPossible;
     quint64 _playbackStartTimeMSecs;    ///< The time when the logfile was first played back. This is used to pace out replaying the messages to fix long-term drift/skew. 0 indicates that the player hasn't initiated playback of this log file.
     quint64 _playbackStartLogTimeUSecs;
 
     MAVLinkProtocol*    _mavlink;
     QFile               _logFile;
     quint64             _logFileSize;
+    MAVLinkLogIndex     _index;
+    int                 _nextEntry;         ///< Index entry of the next record to deliver
+    QElapsedTimer       _positionSignalTimer;
 
     static const int cbTimestamp = sizeof(quint64);
+
+    static constexpr int    _tickMsecs              = 20;
+    static constexpr int    _fastTickMsecs          = 1;
+    static constexpr qint64 _maxBatchBytes          = 64 * 1024;        ///< Per bytesReceived signal
+    static constexpr qint64 _maxTickBytes           = 1024 * 1024;      ///< Per tick, keeps the thread responsive to pause and seek
+    static constexpr qint64 _maxIngestBacklogBytes  = 4 * 1024 * 1024;  ///< Fast as possible mode holds off beyond this
+    static constexpr int    _positionSignalMsecs    = 250;
 };
 
 class LogReplayLinkController : public QObject
@@ -0,0 +1,185 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkForwardRouter.h"
+#include "LinkManager.h"
+#include "QGCLoggingCategory.h"
+
+#include <QSettings>
+
+QGC_LOGGING_CATEGORY(MAVLinkForwardRouterLog, "MAVLinkForwardRouterLog")
+
+MAVLinkForwardRouter::MAVLinkForwardRouter(QObject* parent)
+    : QObject(parent)
+{
+    _clock.start();
+}
+
+void MAVLinkForwardRouter::loadSettings(void)
+{
+    QSettings settings;
+    settings.beginGroup("MAVLinkForwardRouter");
+
+    int count = settings.beginReadArray("sinks");
+    for (int i=0; i<count; i++) {
+        settings.setArrayIndex(i);
+
+        SinkConfig_t config;
+        config.linkName = settings.value("linkName").toString();
+        if (config.linkName.isEmpty()) {
+            qCWarning(MAVLinkForwardRouterLog) << "Sink" << i << "has no linkName, ignored";
+            continue;
+        }
+        for (const QString& msgId: settings.value("msgIds").toString().split(',', Qt::SkipEmptyParts)) {
+            config.msgIds.insert(msgId.trimmed().toUInt());
+        }
+        for (const QString& sysId: settings.value("sysIds").toString().split(',', Qt::SkipEmptyParts)) {
+            config.sysIds.insert(static_cast<uint8_t>(sysId.trimmed().toUInt()));
+        }
+        config.maxRateHz        = settings.value("maxRateHz", 0).toDouble();
+        config.maxPendingBytes  = settings.value("maxPendingBytes", defaultMaxPendingBytes).toLongLong();
+
+        qCDebug(MAVLinkForwardRouterLog) << "Sink" << config.linkName << "msgIds" << config.msgIds << "sysIds" << config.sysIds << "maxRateHz" << config.maxRateHz;
+        addSink(config);
+    }
+    settings.endArray();
+}
+
+int MAVLinkForwardRouter::addSink(const SinkConfig_t& config)
+{
+    Sink_t sink;
+
+    sink.id                 = _nextSinkId++;
+    sink.config             = config;
+    sink.enabled            = true;
+    sink.minIntervalNsecs   = config.maxRateHz > 0 ? static_cast<qint64>(1.0e9 / config.maxRateHz) : 0;
+    sink.nextLookupMsecs    = 0;
+    sink.dropping           = false;
+    _sinks.append(sink);
+
+    return sink.id;
+}
+
+void MAVLinkForwardRouter::removeSink(int sinkId)
+{
+    for (int i=0; i<_sinks.count(); i++) {
+        if (_sinks[i].id == sinkId) {
+            _sinks.removeAt(i);
+            return;
+        }
+    }
+}
+
+MAVLinkForwardRouter::Sink_t* MAVLinkForwardRouter::_findSink(int sinkId)
+{
+    for (Sink_t& sink: _sinks) {
+        if (sink.id == sinkId) {
+            return &sink;
+        }
+    }
+    return nullptr;
+}
+
+void MAVLinkForwardRouter::setSinkEnabled(int sinkId, bool enabled)
+{
+    Sink_t* sink = _findSink(sinkId);
+    if (sink) {
+        sink->enabled = enabled;
+    }
+}
+
+MAVLinkForwardRouter::SinkStats_t MAVLinkForwardRouter::sinkStats(int sinkId) const
+{
+    for (const Sink_t& sink: _sinks) {
+        if (sink.id == sinkId) {
+            return sink.stats;
+        }
+    }
+    return SinkStats_t();
+}
+
+SharedLinkInterfacePtr MAVLinkForwardRouter::_sinkLink(Sink_t& sink)
+{
+    SharedLinkInterfacePtr sinkLink = sink.link.lock();
+    if (sinkLink && sinkLink->isConnected()) {
+        return sinkLink;
+    }
+    sink.link.reset();
+
+    // Looking through the links for every message would be wasted on a sink whose link isn't there
+    qint64 nowMsecs = _clock.elapsed();
+    if (!_linkManager || nowMsecs < sink.nextLookupMsecs) {
+        return nullptr;
+    }
+    sink.nextLookupMsecs = nowMsecs + _linkLookupIntervalMsecs;
+
+    for (const SharedLinkInterfacePtr& link: _linkManager->links()) {
+        if (link->linkConfiguration()->name() == sink.config.linkName && link->isConnected()) {
+            qCDebug(MAVLinkForwardRouterLog) << "Sink link found" << sink.config.linkName;
+            sink.link = link;
+            return link;
+        }
+    }
+    return nullptr;
+}
+
+void MAVLinkForwardRouter::route(LinkInterface* sourceLink, const mavlink_message_t& message, const uint8_t* frame, int frameLength)
+{
+    QByteArray  sharedFrame;        // Copied from the frame for the first sink, shared by the rest
+    qint64      nowNsecs = -1;
+
+    for (Sink_t& sink: _sinks) {
+        if (!sink.enabled) {
+            continue;
+        }
+        SharedLinkInterfacePtr sinkLink = _sinkLink(sink);
+        if (!sinkLink || sinkLink.get() == sourceLink) {
+            continue;
+        }
+
+        if ((!sink.config.msgIds.isEmpty() && !sink.config.msgIds.contains(message.msgid)) ||
+                (!sink.config.sysIds.isEmpty() && !sink.config.sysIds.contains(message.sysid))) {
+            sink.stats.filtered++;
+            continue;
+        }
+
+        uint32_t streamKey = (static_cast<uint32_t>(message.sysid) << 24) | message.msgid;
+        if (sink.minIntervalNsecs) {
+            if (nowNsecs < 0) {
+                nowNsecs = _clock.nsecsElapsed();
+            }
+            auto lastForward = sink.lastForwardNsecs.constFind(streamKey);
+            if (lastForward != sink.lastForwardNsecs.constEnd() && nowNsecs - lastForward.value() < sink.minIntervalNsecs) {
+                sink.stats.rateLimited++;
+                continue;
+            }
+        }
+
+        if (sinkLink->pendingWriteBytes() + frameLength > sink.config.maxPendingBytes) {
+            if (!sink.dropping) {
+                qCWarning(MAVLinkForwardRouterLog) << "Sink link" << sink.config.linkName << "is falling behind, dropping frames";
+                sink.dropping = true;
+            }
+            sink.stats.dropped++;
+            continue;
+        } else if (sink.dropping) {
+            qCWarning(MAVLinkForwardRouterLog) << "Sink link" << sink.config.linkName << "caught up, dropped so far" << sink.stats.dropped;
+            sink.dropping = false;
+        }
+
+        if (sharedFrame.isNull()) {
+            sharedFrame = QByteArray(reinterpret_cast<const char*>(frame), frameLength);
+        }
+        sinkLink->writeBytesThreadSafe(sharedFrame);
+        if (sink.minIntervalNsecs) {
+            sink.lastForwardNsecs[streamKey] = nowNsecs;
+        }
+        sink.stats.forwarded++;
+    }
+}
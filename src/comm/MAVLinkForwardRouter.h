@@ -0,0 +1,101 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+#include <QSet>
+#include <QString>
+
+#include "LinkInterface.h"
+#include "QGCMAVLink.h"
+
+class LinkManager;
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkForwardRouterLog)
+
+/// Forwards received MAVLink frames to any number of sink links, each with its own message id/system id filters and
+/// rate limit. A frame is copied once into an implicitly shared QByteArray which every sink's link thread then writes
+/// from. A sink whose link has fallen behind by more than its pending byte limit has frames dropped, rather than
+/// queued without bound on its thread.
+///
+/// Sinks refer to links by link configuration name, the link is looked up again whenever it goes away. Besides the
+/// built in forwarding links, sinks are read from the "MAVLinkForwardRouter" settings group:
+///     sinks/<n>/linkName          Link configuration name
+///     sinks/<n>/msgIds            Comma separated message ids to forward, all if missing
+///     sinks/<n>/sysIds            Comma separated system ids to forward, all if missing
+///     sinks/<n>/maxRateHz         Rate limit for each system id/message id stream, no limit if missing
+///     sinks/<n>/maxPendingBytes   Backpressure limit
+///
+/// All methods must be called on the GUI thread.
+class MAVLinkForwardRouter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 defaultMaxPendingBytes = 256 * 1024;
+
+    typedef struct SinkConfig_t {
+        QString         linkName;
+        QSet<uint32_t>  msgIds;                                 ///< Empty for all
+        QSet<uint8_t>   sysIds;                                 ///< Empty for all
+        double          maxRateHz       = 0;                    ///< Per system id/message id stream, 0 for no limit
+        qint64          maxPendingBytes = defaultMaxPendingBytes;
+    } SinkConfig_t;
+
+    typedef struct SinkStats_t {
+        quint64 forwarded   = 0;
+        quint64 filtered    = 0;    ///< Didn't pass the message id/system id filters
+        quint64 rateLimited = 0;
+        quint64 dropped     = 0;    ///< Link too far behind
+    } SinkStats_t;
+
+    MAVLinkForwardRouter(QObject* parent = nullptr);
+
+    void setLinkManager(LinkManager* linkManager) { _linkManager = linkManager; }
+
+    /// Adds the sinks from settings
+    void loadSettings(void);
+
+    /// @return Sink id
+    int         addSink         (const SinkConfig_t& config);
+    void        removeSink      (int sinkId);
+    void        setSinkEnabled  (int sinkId, bool enabled);
+    SinkStats_t sinkStats       (int sinkId) const;
+
+    /// Forwards the frame as received on sourceLink to every enabled sink it passes, other than sourceLink itself
+    void route(LinkInterface* sourceLink, const mavlink_message_t& message, const uint8_t* frame, int frameLength);
+
+private:
+    typedef struct Sink_t {
+        int                     id;
+        SinkConfig_t            config;
+        bool                    enabled;
+        qint64                  minIntervalNsecs;
+        WeakLinkInterfacePtr    link;
+        qint64                  nextLookupMsecs;
+        QHash<uint32_t, qint64> lastForwardNsecs;               ///< Keyed by system id << 24 | message id
+        bool                    dropping;
+        SinkStats_t             stats;
+    } Sink_t;
+
+    SharedLinkInterfacePtr  _sinkLink   (Sink_t& sink);
+    Sink_t*                 _findSink   (int sinkId);
+
+    LinkManager*    _linkManager    = nullptr;
+    QList<Sink_t>   _sinks;
+    int             _nextSinkId     = 1;
+    QElapsedTimer   _clock;
+
+    static constexpr qint64 _linkLookupIntervalMsecs = 1000;    ///< How often a sink without a link looks for it
+};
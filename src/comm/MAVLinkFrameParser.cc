@@ -0,0 +1,257 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameParser.h"
+
+#include <cstring>
+
+static constexpr int _headerLengthV1 = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1;
+static constexpr int _headerLengthV2 = MAVLINK_NUM_HEADER_BYTES;
+
+MAVLinkFrameParser::MAVLinkFrameParser(void)
+{
+    memset(&_status, 0, sizeof(_status));
+}
+
+void MAVLinkFrameParser::setBuffer(const QByteArray& bytes)
+{
+    if (_data && !_external) {
+        // Previous buffer was abandoned part way through, which leaves the consumed bytes in _held
+        _held.clear();
+    }
+
+    _buffer         = reinterpret_cast<const uint8_t*>(bytes.constData());
+    _bufferLength   = bytes.length();
+    _bufferPosition = 0;
+    _position       = 0;
+
+    if (_held.isEmpty()) {
+        _data       = _buffer;
+        _length     = _bufferLength;
+        _external   = true;
+    } else {
+        _completeHeld();
+        _data       = reinterpret_cast<const uint8_t*>(_held.constData());
+        _length     = _held.length();
+        _external   = false;
+    }
+}
+
+void MAVLinkFrameParser::_completeHeld(void)
+{
+    // The held bytes always start with a start of frame marker
+    while (_bufferPosition < _bufferLength) {
+        int heldLength  = _held.length();
+        int frameLength = _frameLength(reinterpret_cast<const uint8_t*>(_held.constData()), heldLength);
+        if (frameLength == 0) {
+            // Bad header, nextMessage resyncs
+            return;
+        }
+
+        // Until the length is known only take enough for the longest length check
+        int needed = (frameLength < 0 ? 3 : frameLength) - heldLength;
+        if (needed <= 0) {
+            return;
+        }
+        int copyLength = qMin(needed, _bufferLength - _bufferPosition);
+        _held.append(reinterpret_cast<const char*>(_buffer + _bufferPosition), copyLength);
+        _bufferPosition += copyLength;
+    }
+}
+
+void MAVLinkFrameParser::reset(void)
+{
+    memset(&_status, 0, sizeof(_status));
+    _held.clear();
+    _data           = nullptr;
+    _length         = 0;
+    _position       = 0;
+    _external       = false;
+    _buffer         = nullptr;
+    _bufferLength   = 0;
+    _bufferPosition = 0;
+}
+
+int MAVLinkFrameParser::_frameLength(const uint8_t* frame, int available)
+{
+    if (frame[0] == MAVLINK_STX) {
+        if (available < 3) {
+            return -1;
+        }
+        uint8_t incompatFlags = frame[2];
+        if (incompatFlags & ~MAVLINK_IFLAG_MASK) {
+            // Incompatible feature we don't understand
+            return 0;
+        }
+        int signatureLength = incompatFlags & MAVLINK_IFLAG_SIGNED ? MAVLINK_SIGNATURE_BLOCK_LEN : 0;
+        return _headerLengthV2 + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES + signatureLength;
+    } else {
+        if (available < 2) {
+            return -1;
+        }
+        return _headerLengthV1 + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+    }
+}
+
+bool MAVLinkFrameParser::_decode(const uint8_t* frame, mavlink_message_t& message)
+{
+    bool        v2              = frame[0] == MAVLINK_STX;
+    int         headerLength    = v2 ? _headerLengthV2 : _headerLengthV1;
+    uint8_t     payloadLength   = frame[1];
+    uint32_t    msgid           = v2 ? (frame[7] | (frame[8] << 8) | (frame[9] << 16)) : frame[5];
+
+    const mavlink_msg_entry_t* msgEntry = mavlink_get_msg_entry(msgid);
+
+    // CRC covers everything after the start marker up to the checksum, plus the message specific extra byte. Unknown
+    // messages use an extra byte of 0, same as mavlink_parse_char.
+    uint16_t crc = crc_calculate(frame + 1, static_cast<uint16_t>(headerLength - 1 + payloadLength));
+    crc_accumulate(msgEntry ? msgEntry->crc_extra : 0, &crc);
+    const uint8_t* ck = frame + headerLength + payloadLength;
+    if (ck[0] != (crc & 0xFF) || ck[1] != (crc >> 8)) {
+        return false;
+    }
+
+    message.magic           = frame[0];
+    message.len             = payloadLength;
+    message.checksum        = crc;
+    message.ck[0]           = ck[0];
+    message.ck[1]           = ck[1];
+    message.msgid           = msgid;
+    if (v2) {
+        message.incompat_flags  = frame[2];
+        message.compat_flags    = frame[3];
+        message.seq             = frame[4];
+        message.sysid           = frame[5];
+        message.compid          = frame[6];
+        if (message.incompat_flags & MAVLINK_IFLAG_SIGNED) {
+            memcpy(message.signature, ck + MAVLINK_NUM_CHECKSUM_BYTES, MAVLINK_SIGNATURE_BLOCK_LEN);
+        }
+    } else {
+        message.incompat_flags  = 0;
+        message.compat_flags    = 0;
+        message.seq             = frame[2];
+        message.sysid           = frame[3];
+        message.compid          = frame[4];
+    }
+
+    // Zero fill the payload beyond a trimmed mavlink 2 payload, as mavlink_parse_char does. The message is reused
+    // between frames, so unknown messages are cleared to the maximum payload length.
+    char* payload = _MAV_PAYLOAD_NON_CONST(&message);
+    int   fillLength = msgEntry ? msgEntry->max_msg_len : MAVLINK_MAX_PAYLOAD_LEN;
+    memcpy(payload, frame + headerLength, payloadLength);
+    if (payloadLength < fillLength) {
+        memset(payload + payloadLength, 0, fillLength - payloadLength);
+    }
+
+    return true;
+}
+
+bool MAVLinkFrameParser::nextMessage(mavlink_message_t& message, Frame_t& frame)
+{
+    while (true) {
+        if (_nextFrame(message, frame)) {
+            return true;
+        }
+        if (_external || _bufferPosition == _bufferLength) {
+            break;
+        }
+
+        if (_position < _length) {
+            // The held frame was bad and a frame starting in what is left of it runs into the buffer. Copy the rest of
+            // the buffer after it to resync across the boundary.
+            _held.append(reinterpret_cast<const char*>(_buffer + _bufferPosition), _bufferLength - _bufferPosition);
+            _bufferPosition = _bufferLength;
+            _data           = reinterpret_cast<const uint8_t*>(_held.constData());
+            _length         = _held.length();
+        } else {
+            // Done with the held frame, carry on in the caller's buffer past the bytes copied to complete it
+            _held.clear();
+            _data           = _buffer;
+            _length         = _bufferLength;
+            _position       = _bufferPosition;
+            _external       = true;
+        }
+    }
+
+    _holdRemaining();
+    return false;
+}
+
+bool MAVLinkFrameParser::_nextFrame(mavlink_message_t& message, Frame_t& frame)
+{
+    mavlink_status_t* status = &_status;
+
+    while (_position < _length) {
+        // Skip anything before the next start of frame marker
+        const uint8_t* start = _data + _position;
+        const uint8_t* end   = _data + _length;
+        const uint8_t* stx   = start;
+        while (stx < end && *stx != MAVLINK_STX && *stx != MAVLINK_STX_MAVLINK1) {
+            stx++;
+        }
+        if (stx != start) {
+            status->parse_error++;
+        }
+        _position = static_cast<int>(stx - _data);
+        if (stx == end) {
+            break;
+        }
+
+        int available   = _length - _position;
+        int frameLength = _frameLength(stx, available);
+        if (frameLength < 0 || frameLength > available) {
+            // Rest of the frame is in the next buffer
+            break;
+        }
+        if (frameLength == 0 || !_decode(stx, message)) {
+            // Not a frame after all, resync from the next byte
+            if (frameLength == 0) {
+                status->parse_error++;
+            } else {
+                status->packet_rx_drop_count++;
+            }
+            _position++;
+            continue;
+        }
+
+        if (message.magic == MAVLINK_STX_MAVLINK1) {
+            status->flags |= MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+        } else {
+            status->flags &= ~MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+        }
+        status->current_rx_seq = message.seq;
+        status->packet_rx_success_count++;
+        status->msg_received = MAVLINK_FRAMING_OK;
+
+        frame.data      = stx;
+        frame.length    = frameLength;
+        _position       += frameLength;
+        return true;
+    }
+
+    return false;
+}
+
+void MAVLinkFrameParser::_holdRemaining(void)
+{
+    int remaining = _length - _position;
+
+    if (_external) {
+        if (remaining) {
+            _held = QByteArray(reinterpret_cast<const char*>(_data + _position), remaining);
+        }
+    } else {
+        _held.remove(0, _position);
+    }
+
+    _data       = nullptr;
+    _length     = 0;
+    _position   = 0;
+    _external   = false;
+}
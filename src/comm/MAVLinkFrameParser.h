@@ -0,0 +1,78 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+#include "QGCMAVLink.h"
+
+/// Frame level MAVLink parser for a single channel. Instead of running every byte through the mavlink_parse_char
+/// state machine it scans the buffer for a start of frame marker, waits until the whole frame is available and then
+/// validates the header and CRC and decodes it in one step. Frames are handed back as pointers into the received
+/// buffer so they can be forwarded and logged without being re-serialized. A frame split across two buffers is the only
+/// thing copied: its start is held from the first buffer and only the bytes needed to finish it are copied from the
+/// next. If the held bytes turn out not to be a frame after all, the rest of the next buffer is copied behind them so
+/// parsing can resync across the boundary.
+///
+/// Parse statistics are kept in the parser rather than the shared mavlink channel status, since the channel status is
+/// also used for sending on the GUI thread while parsing runs on the ingest thread.
+///
+/// Usage:
+///     parser.setBuffer(bytes);
+///     while (parser.nextMessage(message, frame)) { ... }
+class MAVLinkFrameParser
+{
+public:
+    MAVLinkFrameParser(void);
+
+    /// Raw frame of the last decoded message. Valid until the next call to nextMessage or setBuffer.
+    typedef struct Frame_t {
+        const uint8_t*  data    = nullptr;
+        int             length  = 0;
+    } Frame_t;
+
+    /// Starts parsing a new buffer. The buffer must stay valid until nextMessage returns false. If the previous buffer
+    /// was not parsed to the end its remaining bytes are dropped.
+    void setBuffer(const QByteArray& bytes);
+
+    /// Decodes the next valid frame in the buffer
+    /// @return false: No more complete frames, a trailing partial frame is held for the next buffer
+    bool nextMessage(mavlink_message_t& message, Frame_t& frame);
+
+    /// Drops any held partial frame and clears the statistics
+    void reset(void);
+
+    /// Receive statistics in the same form as mavlink_parse_char keeps them: packet_rx_success_count,
+    /// packet_rx_drop_count, parse_error, current_rx_seq and MAVLINK_STATUS_FLAG_IN_MAVLINK1 for the last frame
+    const mavlink_status_t& status(void) const { return _status; }
+
+    /// @return Number of bytes held from a partial frame between buffers
+    int heldBytes(void) const { return _held.length(); }
+
+    static constexpr int maxFrameLength = MAVLINK_NUM_HEADER_BYTES + MAVLINK_MAX_PAYLOAD_LEN + MAVLINK_NUM_CHECKSUM_BYTES + MAVLINK_SIGNATURE_BLOCK_LEN;
+
+private:
+    /// @return Length of the frame starting at frame[0], -1 if more bytes are needed to tell, 0 if the header is bad
+    static int  _frameLength    (const uint8_t* frame, int available);
+    static bool _decode         (const uint8_t* frame, mavlink_message_t& message);
+    bool        _nextFrame      (mavlink_message_t& message, Frame_t& frame);
+    void        _completeHeld   (void);
+    void        _holdRemaining  (void);
+
+    mavlink_status_t _status;
+    QByteArray       _held;                     ///< Partial frame from the previous buffer, completed from the current one while parsing
+    const uint8_t*   _data              = nullptr;
+    int              _length            = 0;
+    int              _position          = 0;
+    bool             _external          = false;    ///< true: _data points into the caller's buffer, false: into _held
+    const uint8_t*   _buffer            = nullptr;  ///< Caller's buffer from setBuffer
+    int              _bufferLength      = 0;
+    int              _bufferPosition    = 0;        ///< Bytes of the caller's buffer already copied to _held
+};
@@ -0,0 +1,162 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkIngest.h"
+#include "MAVLinkProtocol.h"
+
+#include <QDateTime>
+#include <QThread>
+
+MAVLinkIngestWorker::MAVLinkIngestWorker(MAVLinkProtocol* protocol, MAVLinkIngestQueue* queue)
+    : _protocol (protocol)
+    , _queue    (queue)
+{
+    memset(_lastIndex,              0, sizeof(_lastIndex));
+    memset(_firstMessage,           1, sizeof(_firstMessage));
+    memset(_totalReceiveCounter,    0, sizeof(_totalReceiveCounter));
+    memset(_totalLossCounter,       0, sizeof(_totalLossCounter));
+    memset(_runningLossPercent,     0, sizeof(_runningLossPercent));
+}
+
+void MAVLinkIngestWorker::addLink(LinkInterface* link, uint8_t mavlinkChannel)
+{
+    _linkChannels[link] = mavlinkChannel;
+    _frameParsers[mavlinkChannel].reset();
+}
+
+void MAVLinkIngestWorker::removeLink(LinkInterface* link)
+{
+    _linkChannels.remove(link);
+}
+
+void MAVLinkIngestWorker::resetLink(LinkInterface* link)
+{
+    auto linkChannel = _linkChannels.constFind(link);
+    if (linkChannel == _linkChannels.constEnd()) {
+        return;
+    }
+
+    int channel = linkChannel.value();
+    _totalReceiveCounter[channel] = 0;
+    _totalLossCounter[channel]    = 0;
+    _runningLossPercent[channel]  = 0.0f;
+    for(int i = 0; i < 256; i++) {
+        _firstMessage[channel][i] =  1;
+    }
+    _frameParsers[channel].reset();
+}
+
+MAVLinkIngestMessage_t* MAVLinkIngestWorker::_reserve(void)
+{
+    MAVLinkIngestMessage_t* ingestMessage = _queue->reserve();
+
+    while (!ingestMessage) {
+        // The GUI thread is behind. Hold off parsing rather than dropping messages, the link bytes queue up in this
+        // thread's event queue in the meantime.
+        if (_stopping) {
+            return nullptr;
+        }
+        _queueFullWaits++;
+        _protocol->_scheduleIngestDrain();
+        QThread::usleep(_queueFullWaitUsecs);
+        ingestMessage = _queue->reserve();
+    }
+
+    return ingestMessage;
+}
+
+void MAVLinkIngestWorker::_updateLossStats(uint8_t mavlinkChannel, MAVLinkIngestMessage_t& ingestMessage)
+{
+    const mavlink_message_t& message = ingestMessage.message;
+
+    uint8_t lastSeq = _lastIndex[message.sysid][message.compid];
+    uint8_t expectedSeq = lastSeq + 1;
+    // Increase receive counter
+    _totalReceiveCounter[mavlinkChannel]++;
+    // Determine what the next expected sequence number is, accounting for
+    // never having seen a message for this system/component pair.
+    if(_firstMessage[message.sysid][message.compid]) {
+        _firstMessage[message.sysid][message.compid] = 0;
+        lastSeq     = message.seq;
+        expectedSeq = message.seq;
+    }
+    // And if we didn't encounter that sequence number, record the error
+    if (message.seq != expectedSeq)
+    {
+        int lostMessages = 0;
+        //-- Account for overflow during packet loss
+        if(message.seq < expectedSeq) {
+            lostMessages = (message.seq + 255) - expectedSeq;
+        } else {
+            lostMessages = message.seq - expectedSeq;
+        }
+        // Log how many were lost
+        _totalLossCounter[mavlinkChannel] += static_cast<uint64_t>(lostMessages);
+    }
+
+    // And update the last sequence number for this system/component pair
+    _lastIndex[message.sysid][message.compid] = message.seq;
+    // Calculate new loss ratio
+    uint64_t totalSent = _totalReceiveCounter[mavlinkChannel] + _totalLossCounter[mavlinkChannel];
+    float receiveLossPercent = static_cast<float>(static_cast<double>(_totalLossCounter[mavlinkChannel]) / static_cast<double>(totalSent));
+    receiveLossPercent *= 100.0f;
+    receiveLossPercent = (receiveLossPercent * 0.5f) + (_runningLossPercent[mavlinkChannel] * 0.5f);
+    _runningLossPercent[mavlinkChannel] = receiveLossPercent;
+
+    // Update MAVLink status on every 32th packet
+    ingestMessage.statusUpdate = (_totalReceiveCounter[mavlinkChannel] & 0x1F) == 0;
+    if (ingestMessage.statusUpdate) {
+        ingestMessage.totalSent     = totalSent;
+        ingestMessage.totalReceived = _totalReceiveCounter[mavlinkChannel];
+        ingestMessage.totalLoss     = _totalLossCounter[mavlinkChannel];
+        ingestMessage.lossPercent   = receiveLossPercent;
+    }
+}
+
+void MAVLinkIngestWorker::receiveBytes(LinkInterface* link, QByteArray bytes)
+{
+    // Links are added and removed through this thread's event queue, so bytes which were still queued when the link
+    // went away are dropped here.
+    auto linkChannel = _linkChannels.constFind(link);
+    if (linkChannel == _linkChannels.constEnd()) {
+        qCDebug(MAVLinkProtocolLog) << "receiveBytes: link gone!" << bytes.size() << " bytes arrived too late";
+        return;
+    }
+
+    uint8_t                     mavlinkChannel  = static_cast<uint8_t>(linkChannel.value());
+    MAVLinkFrameParser&         frameParser     = _frameParsers[mavlinkChannel];
+    MAVLinkFrameParser::Frame_t frame;
+    bool                        queued          = false;
+
+    // Everything in the buffer arrived together so it all gets the same log timestamp
+    quint64 logTimeUsecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
+
+    frameParser.setBuffer(bytes);
+    while (true) {
+        // Decode straight into the queue entry
+        MAVLinkIngestMessage_t* ingestMessage = _reserve();
+        if (!ingestMessage || !frameParser.nextMessage(ingestMessage->message, frame)) {
+            break;
+        }
+
+        ingestMessage->link         = link;
+        ingestMessage->frameLength  = frame.length;
+        memcpy(ingestMessage->frame, frame.data, frame.length);
+        _updateLossStats(mavlinkChannel, *ingestMessage);
+
+        _protocol->_logReceivedFrame(logTimeUsecs, frame, ingestMessage->message);
+
+        _queue->commit();
+        queued = true;
+    }
+
+    if (queued) {
+        _protocol->_scheduleIngestDrain();
+    }
+}
@@ -0,0 +1,83 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+
+#include <atomic>
+
+#include "MAVLinkFrameParser.h"
+#include "QGCMAVLink.h"
+#include "QGCSPSCQueue.h"
+
+class LinkInterface;
+class MAVLinkProtocol;
+
+/// Message decoded on the ingest thread, read in place by MAVLinkProtocol on the GUI thread
+typedef struct MAVLinkIngestMessage_t {
+    LinkInterface*      link;
+    mavlink_message_t   message;
+    int                 frameLength;
+    uint8_t             frame[MAVLinkFrameParser::maxFrameLength];  ///< As received, forwarded as is
+    bool                statusUpdate;                               ///< true: loss statistics below are due to be emitted
+    uint64_t            totalSent;
+    uint64_t            totalReceived;
+    uint64_t            totalLoss;
+    float               lossPercent;
+} MAVLinkIngestMessage_t;
+
+typedef QGCSPSCQueue<MAVLinkIngestMessage_t> MAVLinkIngestQueue;
+
+/// Lives on the MAVLink ingest thread. Link bytes are delivered here directly, without going through the GUI thread.
+/// Parses them, does sequence loss accounting and writes the telemetry log, then hands the decoded messages to
+/// MAVLinkProtocol through the ingest queue. This thread is the only producer for the queue.
+class MAVLinkIngestWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkIngestWorker(MAVLinkProtocol* protocol, MAVLinkIngestQueue* queue);
+
+    void addLink    (LinkInterface* link, uint8_t mavlinkChannel);
+    void removeLink (LinkInterface* link);
+
+    /// Resets loss accounting and parser state for the link's channel
+    void resetLink  (LinkInterface* link);
+
+    /// Stops waiting for space in a full queue so the thread can be shut down. Can be called from any thread.
+    void stop       (void) { _stopping = true; }
+
+    /// @return Number of times parsing was held off because the GUI thread had not caught up with the queue
+    uint64_t queueFullWaits(void) const { return _queueFullWaits; }
+
+public slots:
+    void receiveBytes(LinkInterface* link, QByteArray bytes);
+
+private:
+    MAVLinkIngestMessage_t* _reserve            (void);
+    void                    _updateLossStats    (uint8_t mavlinkChannel, MAVLinkIngestMessage_t& ingestMessage);
+
+    MAVLinkProtocol*            _protocol;
+    MAVLinkIngestQueue*         _queue;
+    std::atomic<bool>           _stopping       { false };
+    std::atomic<uint64_t>       _queueFullWaits { 0 };
+    QHash<LinkInterface*, int>  _linkChannels;
+
+    MAVLinkFrameParser  _frameParsers       [MAVLINK_COMM_NUM_BUFFERS];
+    uint8_t             _lastIndex          [256][256];                 ///< Store the last received sequence ID for each system/componenet pair
+    uint8_t             _firstMessage       [256][256];                 ///< First message flag
+    uint64_t            _totalReceiveCounter[MAVLINK_COMM_NUM_BUFFERS]; ///< The total number of successfully received messages
+    uint64_t            _totalLossCounter   [MAVLINK_COMM_NUM_BUFFERS]; ///< Total messages lost during transmission.
+    float               _runningLossPercent [MAVLINK_COMM_NUM_BUFFERS]; ///< Loss rate
+
+    static constexpr unsigned long _queueFullWaitUsecs = 500;
+};
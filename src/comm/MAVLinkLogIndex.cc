@@ -0,0 +1,281 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogIndex.h"
+#include "QGCMAVLink.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+MAVLinkLogIndex::~MAVLinkLogIndex()
+{
+    close();
+}
+
+QByteArray MAVLinkLogIndex::header(void)
+{
+    QByteArray bytes(headerSize, 0);
+
+    memcpy(bytes.data(), _magic, 8);
+    qToLittleEndian(_version, bytes.data() + 8);
+    qToLittleEndian(static_cast<quint32>(entrySize), bytes.data() + 12);
+
+    return bytes;
+}
+
+void MAVLinkLogIndex::appendEntry(QByteArray& buffer, quint64 timeUsecs, quint64 offset, quint32 msgid)
+{
+    uchar entry[entrySize];
+
+    qToLittleEndian(timeUsecs,  entry);
+    qToLittleEndian(offset,     entry + 8);
+    qToLittleEndian(msgid,      entry + 16);
+    buffer.append(reinterpret_cast<const char*>(entry), entrySize);
+}
+
+quint32 MAVLinkLogIndex::msgIdForFrame(const char* data, int length)
+{
+    const uint8_t* frame = reinterpret_cast<const uint8_t*>(data);
+
+    if (length >= MAVLINK_NUM_HEADER_BYTES && frame[0] == MAVLINK_STX) {
+        return frame[7] | (frame[8] << 8) | (frame[9] << 16);
+    } else if (length >= MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 && frame[0] == MAVLINK_STX_MAVLINK1) {
+        return frame[5];
+    }
+    return unknownMsgId;
+}
+
+quint64 MAVLinkLogIndex::logTimestamp(const char* bytes, quint64 nowUsecs)
+{
+    quint64 timestamp = qFromBigEndian<quint64>(bytes);
+
+    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
+    // little endian, so switch it.
+    if (timestamp > nowUsecs) {
+        timestamp = qbswap(timestamp);
+    }
+
+    return timestamp;
+}
+
+bool MAVLinkLogIndex::build(const QString& logFileName, const QString& indexFileName, QString& errorString)
+{
+    QFile logFile(logFileName);
+    if (!logFile.open(QFile::ReadOnly)) {
+        errorString = QObject::tr("Unable to open log file: '%1', error: %2").arg(logFileName).arg(logFile.errorString());
+        return false;
+    }
+
+    QFile indexFile(indexFileName);
+    if (!indexFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        errorString = QObject::tr("Unable to create log index %1: %2").arg(indexFileName).arg(indexFile.errorString());
+        return false;
+    }
+
+    QByteArray indexBatch = header();
+
+    // Framing state is local so this can run on any thread without touching the mavlink channels
+    mavlink_message_t   rxMessage;
+    mavlink_status_t    rxStatus;
+    mavlink_message_t   message;
+    mavlink_status_t    status;
+    memset(&rxStatus, 0, sizeof(rxStatus));
+
+    quint64 nowUsecs        = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) * 1000;
+    quint64 chunkOffset     = 0;
+    quint64 recordOffset    = 0;
+    char    timeBytes[sizeof(quint64)];
+    int     timeByteCount   = 0;
+
+    QByteArray chunk;
+    while (!(chunk = logFile.read(_buildChunkBytes)).isEmpty()) {
+        const char* bytes = chunk.constData();
+
+        for (int i=0; i<chunk.length(); i++) {
+            if (timeByteCount < static_cast<int>(sizeof(timeBytes))) {
+                if (timeByteCount == 0) {
+                    recordOffset = chunkOffset + i;
+                }
+                timeBytes[timeByteCount++] = bytes[i];
+                continue;
+            }
+
+            // Frames which fail the CRC are still complete frames, usually messages from a dialect we weren't built
+            // with, so they end the record as well.
+            if (mavlink_frame_char_buffer(&rxMessage, &rxStatus, static_cast<uint8_t>(bytes[i]), &message, &status) != MAVLINK_FRAMING_INCOMPLETE) {
+                appendEntry(indexBatch, logTimestamp(timeBytes, nowUsecs), recordOffset, message.msgid);
+                timeByteCount = 0;
+            }
+        }
+
+        if (indexFile.write(indexBatch) != indexBatch.length()) {
+            errorString = QObject::tr("Unable to write log index %1: %2").arg(indexFileName).arg(indexFile.errorString());
+            indexFile.close();
+            indexFile.remove();
+            return false;
+        }
+        indexBatch.truncate(0);
+        chunkOffset += static_cast<quint64>(chunk.length());
+    }
+
+    return true;
+}
+
+bool MAVLinkLogIndex::coversLog(QFile& logFile) const
+{
+    if (_count == 0) {
+        return false;
+    }
+
+    Entry_t firstEntry  = entry(0);
+    Entry_t lastEntry   = entry(_count - 1);
+    quint64 logSize     = static_cast<quint64>(logFile.size());
+    quint64 nowUsecs    = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch()) * 1000;
+
+    // Anything past the last record beyond a timestamp and one frame means the log has grown since it was indexed
+    if (firstEntry.offset != 0 || lastEntry.offset + sizeof(quint64) > logSize ||
+            logSize - lastEntry.offset > 2 * (sizeof(quint64) + MAVLINK_MAX_PACKET_LEN)) {
+        return false;
+    }
+
+    qint64 savedPos = logFile.pos();
+    bool matches = true;
+    for (const Entry_t& checkEntry: { firstEntry, lastEntry }) {
+        QByteArray timeBytes;
+        if (logFile.seek(static_cast<qint64>(checkEntry.offset))) {
+            timeBytes = logFile.read(sizeof(quint64));
+        }
+        if (timeBytes.length() != sizeof(quint64) || logTimestamp(timeBytes.constData(), nowUsecs) != checkEntry.timeUsecs) {
+            matches = false;
+            break;
+        }
+    }
+    logFile.seek(savedPos);
+
+    return matches;
+}
+
+bool MAVLinkLogIndex::open(const QString& indexFileName, QString& errorString)
+{
+    close();
+
+    _file.setFileName(indexFileName);
+    if (!_file.open(QFile::ReadOnly)) {
+        errorString = QObject::tr("Unable to open log index %1: %2").arg(indexFileName).arg(_file.errorString());
+        return false;
+    }
+
+    QByteArray fileHeader = _file.read(headerSize);
+    if (fileHeader.length() != headerSize || !fileHeader.startsWith(_magic) ||
+            qFromLittleEndian<quint32>(fileHeader.constData() + 8) != _version ||
+            qFromLittleEndian<quint32>(fileHeader.constData() + 12) != entrySize) {
+        errorString = QObject::tr("%1 is not a valid log index").arg(indexFileName);
+        _file.close();
+        return false;
+    }
+
+    qint64 entryCount = (_file.size() - headerSize) / entrySize;
+    if (entryCount == 0) {
+        // Nothing to map, but still a valid index. A dummy pointer keeps isOpen working.
+        static const uchar emptyEntries = 0;
+        _entries = &emptyEntries;
+        _count = 0;
+        return true;
+    }
+
+    _entries = _file.map(headerSize, entryCount * entrySize);
+    if (!_entries) {
+        errorString = QObject::tr("Unable to map log index %1: %2").arg(indexFileName).arg(_file.errorString());
+        _file.close();
+        return false;
+    }
+    _count = static_cast<int>(entryCount);
+
+    return true;
+}
+
+void MAVLinkLogIndex::close(void)
+{
+    if (_file.isOpen()) {
+        _file.close();      // Also unmaps
+    }
+    _entries = nullptr;
+    _count = 0;
+    _messageIndicesBuilt = false;
+    _messageIndices.clear();
+}
+
+MAVLinkLogIndex::Entry_t MAVLinkLogIndex::entry(int index) const
+{
+    const uchar* raw = _entries + (static_cast<qint64>(index) * entrySize);
+
+    return { qFromLittleEndian<quint64>(raw), qFromLittleEndian<quint64>(raw + 8), qFromLittleEndian<quint32>(raw + 16) };
+}
+
+quint64 MAVLinkLogIndex::_timeUsecs(int index) const
+{
+    return qFromLittleEndian<quint64>(_entries + (static_cast<qint64>(index) * entrySize));
+}
+
+quint64 MAVLinkLogIndex::startTimeUsecs(void) const
+{
+    return _count ? _timeUsecs(0) : 0;
+}
+
+quint64 MAVLinkLogIndex::endTimeUsecs(void) const
+{
+    return _count ? _timeUsecs(_count - 1) : 0;
+}
+
+int MAVLinkLogIndex::entryIndexForTime(quint64 timeUsecs) const
+{
+    int first = 0;
+    int last = _count;
+
+    while (first < last) {
+        int middle = first + ((last - first) / 2);
+        if (_timeUsecs(middle) < timeUsecs) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+void MAVLinkLogIndex::_buildMessageIndices(void)
+{
+    for (int i=0; i<_count; i++) {
+        _messageIndices[qFromLittleEndian<quint32>(_entries + (static_cast<qint64>(i) * entrySize) + 16)].append(i);
+    }
+    _messageIndicesBuilt = true;
+}
+
+QVector<int> MAVLinkLogIndex::entryIndicesForMessage(quint32 msgid, quint64 startTimeUsecs, quint64 endTimeUsecs)
+{
+    if (!_messageIndicesBuilt) {
+        _buildMessageIndices();
+    }
+
+    auto messageIndices = _messageIndices.constFind(msgid);
+    if (messageIndices == _messageIndices.constEnd()) {
+        return QVector<int>();
+    }
+
+    const QVector<int>& indices = messageIndices.value();
+    auto timeLess = [this](int index, quint64 timeUsecs) { return _timeUsecs(index) < timeUsecs; };
+    auto first  = std::lower_bound(indices.constBegin(), indices.constEnd(), startTimeUsecs, timeLess);
+    auto last   = std::lower_bound(first, indices.constEnd(), endTimeUsecs, timeLess);
+
+    return QVector<int>(first, last);
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/// Sidecar index for a telemetry log. The log itself keeps the usual tlog layout (big endian microsecond timestamp
+/// followed by the frame), the index lives next to it in "<log>.idx" and holds one fixed size entry per log record:
+///     header:     "QGCTLIDX" uint32 version, uint32 entry size
+///     entry:      uint64 time usecs, uint64 log file offset of the record, uint32 message id
+/// All index values are little endian. Entries are in log order, so they are also in time order for a log which was
+/// recorded live. A truncated trailing entry, as left by a crash, is ignored.
+///
+/// Logs recorded without an index, or by other tools, are indexed with a single pass through build.
+class MAVLinkLogIndex
+{
+public:
+    MAVLinkLogIndex(void) = default;
+    ~MAVLinkLogIndex();
+
+    MAVLinkLogIndex(const MAVLinkLogIndex&) = delete;
+    MAVLinkLogIndex& operator=(const MAVLinkLogIndex&) = delete;
+
+    typedef struct Entry_t {
+        quint64 timeUsecs;
+        quint64 offset;     ///< Offset of the record (timestamp included) in the log file
+        quint32 msgid;
+    } Entry_t;
+
+    /// Message id recorded for log records which don't start with a MAVLink frame
+    static constexpr quint32    unknownMsgId    = 0xFFFFFFFF;
+    static constexpr int        headerSize      = 16;
+    static constexpr int        entrySize       = 20;
+
+    static QString      indexFileName   (const QString& logFileName) { return logFileName + QStringLiteral(".idx"); }
+    static QByteArray   header          (void);
+    static void         appendEntry     (QByteArray& buffer, quint64 timeUsecs, quint64 offset, quint32 msgid);
+
+    /// @return Message id from the frame header, unknownMsgId if data does not start with a MAVLink frame header
+    static quint32      msgIdForFrame   (const char* data, int length);
+
+    /// @return Record timestamp in microseconds. Old logs stored it little endian, which shows up as a time in the
+    ///         future relative to nowUsecs.
+    static quint64      logTimestamp    (const char* bytes, quint64 nowUsecs);
+
+    /// Indexes an existing log with a single pass through the file. A record runs from its timestamp to the end of the
+    /// next MAVLink frame, which is how the log has always been read back. A trailing incomplete record is not indexed.
+    ///     @return false: log could not be read or index could not be written, errorString set
+    static bool         build           (const QString& logFileName, const QString& indexFileName, QString& errorString);
+
+    /// Maps the index file. The file is not read up front, entries are decoded on demand.
+    ///     @return false: index missing or not a valid index, errorString set
+    bool open   (const QString& indexFileName, QString& errorString);
+    void close  (void);
+
+    /// @return true: Index describes logFile as it is now. Checks the first and last record, so a stale index from a
+    ///         log which was rewritten or appended to is caught.
+    bool    coversLog   (QFile& logFile) const;
+
+    bool    isOpen  (void) const { return _entries != nullptr; }
+    int     count   (void) const { return _count; }
+    Entry_t entry   (int index) const;
+
+    quint64 startTimeUsecs  (void) const;
+    quint64 endTimeUsecs    (void) const;
+    quint64 durationUsecs   (void) const { return endTimeUsecs() - startTimeUsecs(); }
+
+    /// @return Index of the first entry at or after timeUsecs, count() if there is none
+    int entryIndexForTime(quint64 timeUsecs) const;
+
+    /// @return Indices of all entries for msgid within [startTimeUsecs, endTimeUsecs), in log order. The per message id
+    ///         lists are built on first use.
+    QVector<int> entryIndicesForMessage(quint32 msgid, quint64 startTimeUsecs = 0, quint64 endTimeUsecs = UINT64_MAX);
+
+private:
+    quint64 _timeUsecs  (int index) const;
+    void    _buildMessageIndices(void);
+
+    QFile                           _file;
+    const uchar*                    _entries = nullptr;
+    int                             _count = 0;
+    bool                            _messageIndicesBuilt = false;
+    QHash<quint32, QVector<int>>    _messageIndices;
+
+    static constexpr char       _magic[]        = "QGCTLIDX";
+    static constexpr quint32    _version        = 1;
+    static constexpr qint64     _buildChunkBytes = 1024 * 1024;
+};
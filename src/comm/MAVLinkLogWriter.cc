@@ -0,0 +1,171 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkLogIndex.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtEndian>
+
+QGC_LOGGING_CATEGORY(MAVLinkLogWriterLog, "MAVLinkLogWriterLog")
+
+MAVLinkLogWriter::MAVLinkLogWriter(QObject* parent)
+    : QObject(parent)
+{
+
+}
+
+bool MAVLinkLogWriter::open(QFile* logFile)
+{
+    bool indexOpened = false;
+
+    QMetaObject::invokeMethod(this, [this, logFile, &indexOpened]() { _open(logFile, &indexOpened); }, Qt::BlockingQueuedConnection);
+
+    return indexOpened;
+}
+
+void MAVLinkLogWriter::close(void)
+{
+    if (_open) {
+        QMetaObject::invokeMethod(this, &MAVLinkLogWriter::_close, Qt::BlockingQueuedConnection);
+    }
+}
+
+void MAVLinkLogWriter::append(quint64 timeUsecs, const char* data, int length, quint32 msgid)
+{
+    if (!_open) {
+        return;
+    }
+
+    uchar timeBytes[sizeof(quint64)];
+    qToBigEndian(timeUsecs, timeBytes);
+
+    bool scheduleWrite = false;
+    {
+        QMutexLocker batchLocker(&_batchMutex);
+
+        MAVLinkLogIndex::appendEntry(_indexBatch, timeUsecs, _logOffset, msgid);
+        _logBatch.append(reinterpret_cast<const char*>(timeBytes), sizeof(timeBytes));
+        _logBatch.append(data, length);
+        _logOffset += sizeof(timeBytes) + static_cast<quint64>(length);
+
+        if (_logBatch.length() >= _batchBytes && !_writeScheduled) {
+            _writeScheduled = scheduleWrite = true;
+        }
+    }
+
+    if (scheduleWrite) {
+        QMetaObject::invokeMethod(this, &MAVLinkLogWriter::_writeBatch, Qt::QueuedConnection);
+    }
+}
+
+void MAVLinkLogWriter::_open(QFile* logFile, bool* indexOpened)
+{
+    if (!_flushTimer) {
+        // Created here so it belongs to the writer thread
+        _flushTimer = new QTimer(this);
+        _flushTimer->setInterval(_flushMsecs);
+        connect(_flushTimer, &QTimer::timeout, this, &MAVLinkLogWriter::_writeBatch);
+    }
+
+    _logFile        = logFile;
+    _writeFailures  = 0;
+    _logPending.clear();
+    _indexPending.clear();
+    {
+        QMutexLocker batchLocker(&_batchMutex);
+        _logBatch.clear();
+        _indexBatch.clear();
+        _logOffset      = static_cast<quint64>(logFile->size());
+        _writeScheduled = false;
+    }
+
+    _indexFile.setFileName(MAVLinkLogIndex::indexFileName(logFile->fileName()));
+    *indexOpened = _indexFile.open(QFile::WriteOnly | QFile::Truncate);
+    if (*indexOpened) {
+        _indexFile.write(MAVLinkLogIndex::header());
+    } else {
+        qCWarning(MAVLinkLogWriterLog) << "Unable to open log index" << _indexFile.fileName() << _indexFile.errorString();
+    }
+
+    _flushTimer->start();
+    _open = true;
+}
+
+void MAVLinkLogWriter::_close(void)
+{
+    _open = false;
+    _flushTimer->stop();
+
+    _writeBatch();
+    if (!_logPending.isEmpty()) {
+        qCWarning(MAVLinkLogWriterLog) << "Closing with unwritten log data" << _logPending.length();
+    }
+    _logPending.clear();
+    _indexPending.clear();
+
+    _logFile->flush();
+    _logFile = nullptr;
+    if (_indexFile.isOpen()) {
+        _indexFile.close();
+    }
+}
+
+void MAVLinkLogWriter::_writeBatch(void)
+{
+    if (!_logFile) {
+        return;
+    }
+
+    // Swap the batches out so producers can keep appending while this one goes to disk
+    {
+        QMutexLocker batchLocker(&_batchMutex);
+
+        _writeScheduled = false;
+        if (_logPending.isEmpty()) {
+            _logPending.swap(_logBatch);
+            _indexPending.swap(_indexBatch);
+        } else {
+            // Still holding data from a failed write
+            _logPending.append(_logBatch);
+            _indexPending.append(_indexBatch);
+            _logBatch.truncate(0);
+            _indexBatch.truncate(0);
+        }
+    }
+
+    if (_logPending.isEmpty()) {
+        return;
+    }
+
+    qint64 written = _logFile->write(_logPending);
+    if (written > 0) {
+        _logPending.remove(0, static_cast<int>(written));
+    }
+    if (_logPending.isEmpty() && _logFile->flush()) {
+        _writeFailures = 0;
+        // The index only ever points at log data which has made it to the file
+        if (_indexFile.isOpen() && _indexFile.write(_indexPending) != _indexPending.length()) {
+            qCWarning(MAVLinkLogWriterLog) << "Log index write failed, index dropped" << _indexFile.errorString();
+            _indexFile.close();
+            _indexFile.remove();
+        } else {
+            _indexFile.flush();
+        }
+        _indexPending.truncate(0);
+    } else if (++_writeFailures == _maxWriteFailures) {
+        qCWarning(MAVLinkLogWriterLog) << "Log write failed" << _writeFailures << "times in a row" << _logFile->errorString();
+        emit writeFailed(_logFile->errorString());
+    }
+
+    // The emptied buffers keep their capacity for the next swap, unless a failure streak made them grow
+    if (_logPending.isEmpty() && _logPending.capacity() > 4 * _batchBytes) {
+        _logPending.squeeze();
+    }
+}
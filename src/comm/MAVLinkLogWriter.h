@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QTimer>
+
+#include <atomic>
+
+/// Writes a telemetry log and its MAVLinkLogIndex sidecar on the thread it lives on. append can be called from any
+/// thread: records are collected into the active batch and the batches are swapped when one is due to be written, so
+/// producers never wait for the disk. A batch is written when it reaches _batchBytes or when the flush timer fires.
+///
+/// A failed write keeps the unwritten data and is retried with the next batch. writeFailed is only emitted once
+/// writes have kept failing for _maxWriteFailures batches in a row.
+class MAVLinkLogWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    MAVLinkLogWriter(QObject* parent = nullptr);
+
+    /// Starts writing to the already open logFile, and to its index file. Blocks until the writer thread has started.
+    /// logFile must stay open until close returns.
+    ///     @return false: index file could not be opened, the log itself is still written
+    bool open(QFile* logFile);
+
+    /// Writes everything appended so far and closes the index file. Blocks until done.
+    void close(void);
+
+    /// Thread safe. Appends a log record: the timestamp followed by data.
+    void append(quint64 timeUsecs, const char* data, int length, quint32 msgid);
+
+    bool isOpen(void) const { return _open; }
+
+signals:
+    void writeFailed(QString errorString);
+
+private slots:
+    void _writeBatch(void);
+
+private:
+    void _open  (QFile* logFile, bool* indexOpened);
+    void _close (void);
+
+    QMutex          _batchMutex;            ///< Guards _logBatch, _indexBatch, _logOffset, _writeScheduled
+    QByteArray      _logBatch;
+    QByteArray      _indexBatch;
+    quint64         _logOffset      = 0;    ///< File offset of the next record appended
+    bool            _writeScheduled = false;
+
+    // Writer thread only
+    QFile*          _logFile        = nullptr;
+    QFile           _indexFile;
+    QByteArray      _logPending;            ///< Batch being written, holds on to unwritten data after a failure
+    QByteArray      _indexPending;
+    QTimer*         _flushTimer     = nullptr;
+    int             _writeFailures  = 0;
+
+    std::atomic<bool> _open         { false };
+
+    static constexpr int _batchBytes        = 64 * 1024;
+    static constexpr int _flushMsecs        = 500;
+    static constexpr int _maxWriteFailures  = 5;
+};
@@ -0,0 +1,159 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkMessageDispatcher.h"
+#include "QGCLoggingCategory.h"
+
+QGC_LOGGING_CATEGORY(MAVLinkMessageDispatcherLog, "MAVLinkMessageDispatcherLog")
+
+MAVLinkMessageDispatcher::MAVLinkMessageDispatcher(QObject* parent)
+    : QObject(parent)
+{
+    _clock.start();
+}
+
+int MAVLinkMessageDispatcher::subscribe(uint32_t msgid, QObject* context, Handler handler, const QString& name)
+{
+    std::shared_ptr<Subscription_t> subscription = std::make_shared<Subscription_t>();
+
+    subscription->id            = _nextSubscriptionId++;
+    subscription->msgid         = msgid;
+    subscription->context       = context;
+    subscription->handler       = handler;
+    subscription->name          = name.isEmpty() ? QString::fromLatin1(context->metaObject()->className()) : name;
+    subscription->active        = true;
+    subscription->calls         = 0;
+    subscription->totalNsecs    = 0;
+    subscription->maxNsecs      = 0;
+
+    if (msgid == allMessages) {
+        _allMessagesSubscriptions.append(subscription);
+    } else {
+        _subscriptions[msgid].append(subscription);
+    }
+    qCDebug(MAVLinkMessageDispatcherLog) << "subscribe" << subscription->name << msgid << subscription->id;
+
+    int subscriptionId = subscription->id;
+    connect(context, &QObject::destroyed, this, [this, subscriptionId]() { unsubscribe(subscriptionId); });
+
+    return subscriptionId;
+}
+
+void MAVLinkMessageDispatcher::unsubscribe(int subscriptionId)
+{
+    for (int i=0; i<_allMessagesSubscriptions.count(); i++) {
+        if (_allMessagesSubscriptions[i]->id == subscriptionId) {
+            _allMessagesSubscriptions[i]->active = false;
+            _allMessagesSubscriptions.removeAt(i);
+            return;
+        }
+    }
+
+    for (auto subscriptions = _subscriptions.begin(); subscriptions != _subscriptions.end(); subscriptions++) {
+        for (int i=0; i<subscriptions->count(); i++) {
+            if (subscriptions->at(i)->id == subscriptionId) {
+                subscriptions->at(i)->active = false;
+                subscriptions->removeAt(i);
+                if (subscriptions->isEmpty()) {
+                    _subscriptions.erase(subscriptions);
+                }
+                return;
+            }
+        }
+    }
+}
+
+void MAVLinkMessageDispatcher::dispatch(LinkInterface* link, mavlink_message_t& message)
+{
+    auto subscriptions = _subscriptions.constFind(message.msgid);
+    bool hasMessageSubscriptions = subscriptions != _subscriptions.constEnd();
+
+    if (!hasMessageSubscriptions && _allMessagesSubscriptions.isEmpty()) {
+        _unhandledMessages++;
+        return;
+    }
+
+    // Held as copies, which only adds a reference, since a handler can subscribe or unsubscribe
+    const SubscriptionList_t allMessagesSubscriptions   = _allMessagesSubscriptions;
+    const SubscriptionList_t messageSubscriptions       = hasMessageSubscriptions ? subscriptions.value() : SubscriptionList_t();
+
+    // Both lists are in subscription id order, so merging them calls the handlers in the order they subscribed. Each
+    // handler's end time is the next one's start time, so the clock is read once per handler.
+    qint64  startNsecs          = _clock.nsecsElapsed();
+    int     allMessagesIndex    = 0;
+    int     messageIndex        = 0;
+    while (allMessagesIndex < allMessagesSubscriptions.count() || messageIndex < messageSubscriptions.count()) {
+        bool nextAllMessages = messageIndex >= messageSubscriptions.count() ||
+                (allMessagesIndex < allMessagesSubscriptions.count() && allMessagesSubscriptions[allMessagesIndex]->id < messageSubscriptions[messageIndex]->id);
+        const std::shared_ptr<Subscription_t>& subscription = nextAllMessages ? allMessagesSubscriptions[allMessagesIndex++] : messageSubscriptions[messageIndex++];
+        startNsecs = _callHandler(*subscription, link, message, startNsecs);
+    }
+}
+
+qint64 MAVLinkMessageDispatcher::_callHandler(Subscription_t& subscription, LinkInterface* link, mavlink_message_t& message, qint64 startNsecs)
+{
+    // An earlier handler may have unsubscribed this one or destroyed its context
+    if (!subscription.active || !subscription.context) {
+        return startNsecs;
+    }
+
+    subscription.handler(link, message);
+
+    qint64 endNsecs     = _clock.nsecsElapsed();
+    qint64 elapsedNsecs = endNsecs - startNsecs;
+    subscription.calls++;
+    subscription.totalNsecs += elapsedNsecs;
+    if (elapsedNsecs > subscription.maxNsecs) {
+        subscription.maxNsecs = elapsedNsecs;
+    }
+
+    return endNsecs;
+}
+
+QList<MAVLinkMessageDispatcher::HandlerStats_t> MAVLinkMessageDispatcher::handlerStats(void) const
+{
+    QList<HandlerStats_t> stats;
+
+    auto addStats = [&stats](const SubscriptionList_t& subscriptions) {
+        for (const std::shared_ptr<Subscription_t>& subscription: subscriptions) {
+            HandlerStats_t handlerStats;
+            handlerStats.subscriptionId = subscription->id;
+            handlerStats.msgid          = subscription->msgid;
+            handlerStats.name           = subscription->name;
+            handlerStats.calls          = subscription->calls;
+            handlerStats.totalNsecs     = subscription->totalNsecs;
+            handlerStats.maxNsecs       = subscription->maxNsecs;
+            stats.append(handlerStats);
+        }
+    };
+
+    addStats(_allMessagesSubscriptions);
+    for (const SubscriptionList_t& subscriptions: _subscriptions) {
+        addStats(subscriptions);
+    }
+
+    return stats;
+}
+
+void MAVLinkMessageDispatcher::resetHandlerStats(void)
+{
+    auto resetStats = [](const SubscriptionList_t& subscriptions) {
+        for (const std::shared_ptr<Subscription_t>& subscription: subscriptions) {
+            subscription->calls         = 0;
+            subscription->totalNsecs    = 0;
+            subscription->maxNsecs      = 0;
+        }
+    };
+
+    resetStats(_allMessagesSubscriptions);
+    for (const SubscriptionList_t& subscriptions: _subscriptions) {
+        resetStats(subscriptions);
+    }
+    _unhandledMessages = 0;
+}
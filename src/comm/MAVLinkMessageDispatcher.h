@@ -0,0 +1,94 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QLoggingCategory>
+#include <QPointer>
+#include <QString>
+
+#include <functional>
+#include <memory>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkMessageDispatcherLog)
+
+/// Calls the handlers subscribed to a message's id, so a message which nothing subscribed to costs a single hash
+/// lookup. Handlers are called in the order they subscribed, whether they subscribed to allMessages or to the message
+/// id. The time spent in each handler is counted, see handlerStats.
+///
+/// All methods must be called on the thread the dispatcher lives on.
+class MAVLinkMessageDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(LinkInterface* link, mavlink_message_t& message)> Handler;
+
+    static constexpr uint32_t allMessages = UINT32_MAX;    ///< Subscribes to every message id
+
+    typedef struct HandlerStats_t {
+        int         subscriptionId;
+        uint32_t    msgid;
+        QString     name;
+        quint64     calls       = 0;
+        qint64      totalNsecs  = 0;
+        qint64      maxNsecs    = 0;
+    } HandlerStats_t;
+
+    MAVLinkMessageDispatcher(QObject* parent = nullptr);
+
+    /// Calls handler for each dispatched message with the specified id. The subscription ends when context is
+    /// destroyed or through unsubscribe.
+    ///     @param name Identifies the handler in handlerStats, context's class name if empty
+    /// @return Subscription id for unsubscribe
+    int  subscribe  (uint32_t msgid, QObject* context, Handler handler, const QString& name = QString());
+    void unsubscribe(int subscriptionId);
+
+    bool hasHandlers(uint32_t msgid) const { return !_allMessagesSubscriptions.isEmpty() || _subscriptions.contains(msgid); }
+
+    void dispatch(LinkInterface* link, mavlink_message_t& message);
+
+    QList<HandlerStats_t>   handlerStats        (void) const;
+    void                    resetHandlerStats   (void);
+
+    /// @return Number of messages dispatched which had no handlers
+    quint64 unhandledMessages(void) const { return _unhandledMessages; }
+
+private:
+    typedef struct Subscription_t {
+        int                 id;
+        uint32_t            msgid;
+        QPointer<QObject>   context;
+        Handler             handler;
+        QString             name;
+        bool                active;     ///< false: Unsubscribed while a dispatch holding it was in progress
+        quint64             calls;
+        qint64              totalNsecs;
+        qint64              maxNsecs;
+    } Subscription_t;
+
+    /// Shared so a dispatch in progress can hold on to the list through handlers which subscribe or unsubscribe
+    typedef QList<std::shared_ptr<Subscription_t>> SubscriptionList_t;
+
+    qint64 _callHandler(Subscription_t& subscription, LinkInterface* link, mavlink_message_t& message, qint64 startNsecs);
+
+    QHash<uint32_t, SubscriptionList_t> _subscriptions;
+    SubscriptionList_t                  _allMessagesSubscriptions;
+    int                                 _nextSubscriptionId = 1;
+    quint64                             _unhandledMessages  = 0;
+    QElapsedTimer                       _clock;
+};
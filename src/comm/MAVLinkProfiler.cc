@@ -0,0 +1,304 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkProfiler.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "LinkManager.h"
+#include "QGCLoggingCategory.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(MAVLinkProfilerLog, "MAVLinkProfilerLog")
+
+static_assert((MAVLinkProfiler::timingSampleInterval & (MAVLinkProfiler::timingSampleInterval - 1)) == 0, "timingSampleInterval must be a power of two");
+
+MAVLinkProfiler::MAVLinkProfiler(QObject* parent)
+    : QObject(parent)
+{
+    _clock.start();
+
+    _sampleTimer.setInterval(sampleIntervalMsecs);
+    connect(&_sampleTimer, &QTimer::timeout, this, &MAVLinkProfiler::sample);
+}
+
+void MAVLinkProfiler::addDispatcher(const QString& owner, MAVLinkMessageDispatcher* dispatcher)
+{
+    Dispatcher_t entry;
+    entry.owner         = owner;
+    entry.dispatcher    = dispatcher;
+    _dispatchers.append(entry);
+}
+
+void MAVLinkProfiler::sample(void)
+{
+    qint64 nowNsecs     = _clock.nsecsElapsed();
+    double intervalSecs = (nowNsecs - _lastSampleNsecs) / 1.0e9;
+    _lastSampleNsecs    = nowNsecs;
+    if (intervalSecs <= 0) {
+        return;
+    }
+
+    Sample_t newSample;
+    newSample.timeMsecs = QDateTime::currentMSecsSinceEpoch();
+    if (_queueDepthsSource) {
+        newSample.queueDepths = _queueDepthsSource();
+    }
+
+    _sampleMessages(intervalSecs, newSample);
+    _sampleLinks(intervalSecs, newSample);
+    _sampleHandlers(intervalSecs, newSample);
+
+    _history.append(newSample);
+    while (_history.count() > maxHistorySamples) {
+        _history.removeFirst();
+    }
+
+    emit sampled();
+}
+
+void MAVLinkProfiler::_sampleMessages(double intervalSecs, Sample_t& newSample)
+{
+    _messageStats.clear();
+
+    for (auto messageCounters = _messageCounters.begin(); messageCounters != _messageCounters.end(); messageCounters++) {
+        MessageCounters_t& counters = messageCounters.value();
+
+        MessageStats_t stats;
+        stats.msgid             = messageCounters.key();
+        const mavlink_message_info_t* msgInfo = mavlink_get_message_info_by_id(stats.msgid);
+        stats.name              = msgInfo ? QString::fromLatin1(msgInfo->name) : QString::number(stats.msgid);
+        stats.count             = counters.count;
+        stats.bytes             = counters.bytes;
+        stats.messagesPerSec    = (counters.count - counters.lastCount) / intervalSecs;
+        stats.bytesPerSec       = (counters.bytes - counters.lastBytes) / intervalSecs;
+        stats.timedCount        = counters.timedCount;
+        stats.timedNsecs        = counters.timedNsecs;
+        stats.maxNsecs          = counters.maxNsecs;
+        _messageStats.append(stats);
+
+        newSample.messagesPerSec += stats.messagesPerSec;
+
+        counters.lastCount = counters.count;
+        counters.lastBytes = counters.bytes;
+    }
+
+    std::sort(_messageStats.begin(), _messageStats.end(), [](const MessageStats_t& a, const MessageStats_t& b) { return a.msgid < b.msgid; });
+}
+
+void MAVLinkProfiler::_sampleLinks(double intervalSecs, Sample_t& newSample)
+{
+    _linkStats.clear();
+
+    QList<SharedLinkInterfacePtr> links;
+    if (_linkManager) {
+        links = _linkManager->links();
+    }
+
+    QHash<LinkInterface*, LinkCounters_t> linkCounters;
+    for (const SharedLinkInterfacePtr& link: links) {
+        LinkCounters_t counters = _linkCounters.value(link.get());
+
+        LinkStats_t stats;
+        stats.name              = link->linkConfiguration()->name();
+        stats.messages          = _linkMessages.value(link.get());
+        stats.bytesReceived     = link->totalBytesReceived();
+        stats.bytesWritten      = link->totalBytesWritten();
+        stats.messagesPerSec    = (stats.messages - counters.lastMessages) / intervalSecs;
+        stats.rxBytesPerSec     = (stats.bytesReceived - counters.lastBytesReceived) / intervalSecs;
+        stats.txBytesPerSec     = (stats.bytesWritten - counters.lastBytesWritten) / intervalSecs;
+        stats.pendingWriteBytes = link->pendingWriteBytes();
+        _linkStats.append(stats);
+
+        newSample.rxBytesPerSec     += stats.rxBytesPerSec;
+        newSample.txBytesPerSec     += stats.txBytesPerSec;
+        newSample.pendingWriteBytes += stats.pendingWriteBytes;
+
+        counters.lastMessages       = stats.messages;
+        counters.lastBytesReceived  = stats.bytesReceived;
+        counters.lastBytesWritten   = stats.bytesWritten;
+        linkCounters[link.get()]    = counters;
+    }
+
+    // Links which went away are dropped, so a new link at the same address starts from zero
+    _linkCounters = linkCounters;
+    for (auto linkMessages = _linkMessages.begin(); linkMessages != _linkMessages.end(); ) {
+        if (_linkCounters.contains(linkMessages.key())) {
+            linkMessages++;
+        } else {
+            linkMessages = _linkMessages.erase(linkMessages);
+        }
+    }
+    _lastLink           = nullptr;
+    _lastLinkMessages   = nullptr;
+}
+
+void MAVLinkProfiler::_sampleHandlers(double intervalSecs, Sample_t& newSample)
+{
+    _handlerStats.clear();
+
+    double intervalNsecs = intervalSecs * 1.0e9;
+    for (int i=_dispatchers.count() - 1; i>=0; i--) {
+        if (!_dispatchers[i].dispatcher) {
+            _dispatchers.removeAt(i);
+        }
+    }
+
+    for (Dispatcher_t& dispatcher: _dispatchers) {
+        QHash<int, qint64> lastTotalNsecs;
+
+        for (const MAVLinkMessageDispatcher::HandlerStats_t& dispatcherStats: dispatcher.dispatcher->handlerStats()) {
+            HandlerStats_t stats;
+            stats.owner         = dispatcher.owner;
+            stats.name          = dispatcherStats.name;
+            stats.msgid         = dispatcherStats.msgid;
+            stats.calls         = dispatcherStats.calls;
+            stats.totalNsecs    = dispatcherStats.totalNsecs;
+            stats.maxNsecs      = dispatcherStats.maxNsecs;
+            stats.cpuPercent    = 100.0 * (dispatcherStats.totalNsecs - dispatcher.lastTotalNsecs.value(dispatcherStats.subscriptionId)) / intervalNsecs;
+            _handlerStats.append(stats);
+
+            newSample.handlerCpuPercent += stats.cpuPercent;
+
+            lastTotalNsecs[dispatcherStats.subscriptionId] = dispatcherStats.totalNsecs;
+        }
+
+        dispatcher.lastTotalNsecs = lastTotalNsecs;
+    }
+
+    std::sort(_handlerStats.begin(), _handlerStats.end(), [](const HandlerStats_t& a, const HandlerStats_t& b) { return a.totalNsecs > b.totalNsecs; });
+}
+
+void MAVLinkProfiler::reset(void)
+{
+    _messagesReceived = 0;
+    _messageCounters.clear();
+    _linkMessages.clear();
+    _lastLink           = nullptr;
+    _lastLinkMessages   = nullptr;
+    _linkCounters.clear();
+    for (Dispatcher_t& dispatcher: _dispatchers) {
+        dispatcher.lastTotalNsecs.clear();
+        if (dispatcher.dispatcher) {
+            dispatcher.dispatcher->resetHandlerStats();
+        }
+    }
+
+    _messageStats.clear();
+    _linkStats.clear();
+    _handlerStats.clear();
+    _history.clear();
+    _lastSampleNsecs = _clock.nsecsElapsed();
+
+    // Link byte totals are not reset, the next sample starts them from where they are now
+    if (_linkManager) {
+        for (const SharedLinkInterfacePtr& link: _linkManager->links()) {
+            LinkCounters_t& counters = _linkCounters[link.get()];
+            counters.lastBytesReceived  = link->totalBytesReceived();
+            counters.lastBytesWritten   = link->totalBytesWritten();
+        }
+    }
+
+    emit sampled();
+}
+
+QJsonObject MAVLinkProfiler::toJson(void) const
+{
+    QJsonObject json;
+
+    json[QStringLiteral("timeMsecs")]               = QDateTime::currentMSecsSinceEpoch();
+    json[QStringLiteral("sampleIntervalMsecs")]     = sampleIntervalMsecs;
+    json[QStringLiteral("timingSampleInterval")]    = static_cast<int>(timingSampleInterval);
+    json[QStringLiteral("messagesReceived")]        = static_cast<qint64>(_messagesReceived);
+
+    QJsonArray linksJson;
+    for (const LinkStats_t& stats: _linkStats) {
+        QJsonObject linkJson;
+        linkJson[QStringLiteral("name")]                = stats.name;
+        linkJson[QStringLiteral("messages")]            = static_cast<qint64>(stats.messages);
+        linkJson[QStringLiteral("bytesReceived")]       = static_cast<qint64>(stats.bytesReceived);
+        linkJson[QStringLiteral("bytesWritten")]        = static_cast<qint64>(stats.bytesWritten);
+        linkJson[QStringLiteral("messagesPerSec")]      = stats.messagesPerSec;
+        linkJson[QStringLiteral("rxBytesPerSec")]       = stats.rxBytesPerSec;
+        linkJson[QStringLiteral("txBytesPerSec")]       = stats.txBytesPerSec;
+        linkJson[QStringLiteral("pendingWriteBytes")]   = stats.pendingWriteBytes;
+        linksJson.append(linkJson);
+    }
+    json[QStringLiteral("links")] = linksJson;
+
+    QJsonArray messagesJson;
+    for (const MessageStats_t& stats: _messageStats) {
+        QJsonObject messageJson;
+        messageJson[QStringLiteral("msgid")]            = static_cast<qint64>(stats.msgid);
+        messageJson[QStringLiteral("name")]             = stats.name;
+        messageJson[QStringLiteral("count")]            = static_cast<qint64>(stats.count);
+        messageJson[QStringLiteral("bytes")]            = static_cast<qint64>(stats.bytes);
+        messageJson[QStringLiteral("messagesPerSec")]   = stats.messagesPerSec;
+        messageJson[QStringLiteral("bytesPerSec")]      = stats.bytesPerSec;
+        messageJson[QStringLiteral("timedCount")]       = static_cast<qint64>(stats.timedCount);
+        messageJson[QStringLiteral("timedNsecs")]       = stats.timedNsecs;
+        messageJson[QStringLiteral("maxNsecs")]         = stats.maxNsecs;
+        messagesJson.append(messageJson);
+    }
+    json[QStringLiteral("messages")] = messagesJson;
+
+    QJsonArray handlersJson;
+    for (const HandlerStats_t& stats: _handlerStats) {
+        QJsonObject handlerJson;
+        handlerJson[QStringLiteral("owner")]        = stats.owner;
+        handlerJson[QStringLiteral("name")]         = stats.name;
+        handlerJson[QStringLiteral("msgid")]        = static_cast<qint64>(stats.msgid);
+        handlerJson[QStringLiteral("calls")]        = static_cast<qint64>(stats.calls);
+        handlerJson[QStringLiteral("totalNsecs")]   = stats.totalNsecs;
+        handlerJson[QStringLiteral("maxNsecs")]     = stats.maxNsecs;
+        handlerJson[QStringLiteral("cpuPercent")]   = stats.cpuPercent;
+        handlersJson.append(handlerJson);
+    }
+    json[QStringLiteral("handlers")] = handlersJson;
+
+    QJsonArray historyJson;
+    for (const Sample_t& sample: _history) {
+        QJsonObject sampleJson;
+        sampleJson[QStringLiteral("timeMsecs")]             = sample.timeMsecs;
+        sampleJson[QStringLiteral("messagesPerSec")]        = sample.messagesPerSec;
+        sampleJson[QStringLiteral("rxBytesPerSec")]         = sample.rxBytesPerSec;
+        sampleJson[QStringLiteral("txBytesPerSec")]         = sample.txBytesPerSec;
+        sampleJson[QStringLiteral("handlerCpuPercent")]     = sample.handlerCpuPercent;
+        sampleJson[QStringLiteral("pendingWriteBytes")]     = sample.pendingWriteBytes;
+        sampleJson[QStringLiteral("ingestQueueDepth")]      = sample.queueDepths.ingestQueueDepth;
+        sampleJson[QStringLiteral("ingestBacklogBytes")]    = sample.queueDepths.ingestBacklogBytes;
+        sampleJson[QStringLiteral("ingestQueueFullWaits")]  = static_cast<qint64>(sample.queueDepths.ingestQueueFullWaits);
+        historyJson.append(sampleJson);
+    }
+    json[QStringLiteral("history")] = historyJson;
+
+    return json;
+}
+
+bool MAVLinkProfiler::saveJson(const QString& fileName, QString& errorString) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errorString = tr("Unable to open %1 for writing: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    QByteArray bytes = QJsonDocument(toJson()).toJson();
+    if (file.write(bytes) != bytes.length()) {
+        errorString = tr("Unable to write %1: %2").arg(fileName, file.errorString());
+        return false;
+    }
+
+    qCDebug(MAVLinkProfilerLog) << "Saved" << fileName;
+    return true;
+}
@@ -0,0 +1,203 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QLoggingCategory>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+#include "QGCMAVLink.h"
+
+class LinkInterface;
+class LinkManager;
+class MAVLinkMessageDispatcher;
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkProfilerLog)
+
+/// Throughput profile of the MAVLink traffic delivered on the GUI thread: message and byte rates per link and per
+/// message id, the time spent handling each message id, the time spent in each dispatcher handler and the depths of
+/// the queues in between. Once a second the counters are turned into rates and added to a rolling history.
+///
+/// Counting a message is a hash lookup and a few increments. Only one in timingSampleInterval messages has its
+/// handling time measured, so the clock is not read for every message. Link byte counts come from the links' own
+/// atomic counters, read when sampling. Handler times come from the dispatchers added through addDispatcher.
+///
+/// All methods must be called on the GUI thread.
+class MAVLinkProfiler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int    sampleIntervalMsecs     = 1000;
+    static constexpr int    maxHistorySamples       = 300;  ///< Five minutes at the sample interval
+    static constexpr uint   timingSampleInterval    = 16;   ///< Must be a power of two
+
+    typedef struct QueueDepths_t {
+        qint64  ingestQueueDepth    = 0;    ///< Decoded messages waiting for the GUI thread
+        qint64  ingestBacklogBytes  = 0;    ///< Received bytes waiting for the ingest thread
+        quint64 ingestQueueFullWaits= 0;
+    } QueueDepths_t;
+
+    typedef struct MessageStats_t {
+        uint32_t    msgid;
+        QString     name;
+        quint64     count           = 0;
+        quint64     bytes           = 0;
+        double      messagesPerSec  = 0;
+        double      bytesPerSec     = 0;
+        quint64     timedCount      = 0;    ///< Messages whose handling time was measured
+        qint64      timedNsecs      = 0;
+        qint64      maxNsecs        = 0;
+    } MessageStats_t;
+
+    typedef struct LinkStats_t {
+        QString     name;
+        quint64     messages        = 0;
+        quint64     bytesReceived   = 0;
+        quint64     bytesWritten    = 0;
+        double      messagesPerSec  = 0;
+        double      rxBytesPerSec   = 0;
+        double      txBytesPerSec   = 0;
+        qint64      pendingWriteBytes = 0;
+    } LinkStats_t;
+
+    typedef struct HandlerStats_t {
+        QString     owner;                  ///< As passed to addDispatcher
+        QString     name;
+        uint32_t    msgid;
+        quint64     calls           = 0;
+        qint64      totalNsecs      = 0;
+        qint64      maxNsecs        = 0;
+        double      cpuPercent      = 0;    ///< Of the last sample interval
+    } HandlerStats_t;
+
+    typedef struct Sample_t {
+        qint64          timeMsecs           = 0;    ///< Since epoch
+        double          messagesPerSec      = 0;
+        double          rxBytesPerSec       = 0;
+        double          txBytesPerSec       = 0;
+        double          handlerCpuPercent   = 0;
+        qint64          pendingWriteBytes   = 0;    ///< All links
+        QueueDepths_t   queueDepths;
+    } Sample_t;
+
+    MAVLinkProfiler(QObject* parent = nullptr);
+
+    void setLinkManager     (LinkManager* linkManager) { _linkManager = linkManager; }
+    void setQueueDepthsSource(std::function<QueueDepths_t(void)> queueDepthsSource) { _queueDepthsSource = queueDepthsSource; }
+
+    /// Adds the dispatcher's handlers to handlerStats. The dispatcher is dropped once it is destroyed.
+    void addDispatcher(const QString& owner, MAVLinkMessageDispatcher* dispatcher);
+
+    /// Starts sampling every sampleIntervalMsecs
+    void start(void) { _sampleTimer.start(); }
+
+    /// Counts a message about to be handled
+    /// @return Start time to pass to messageHandled, -1 if this message is not timed
+    qint64 messageReceived(LinkInterface* link, const mavlink_message_t& message, int frameLength)
+    {
+        MessageCounters_t& messageCounters = _messageCounters[message.msgid];
+        messageCounters.count++;
+        messageCounters.bytes += static_cast<quint64>(frameLength);
+        if (link != _lastLink) {
+            _lastLink           = link;
+            _lastLinkMessages   = &_linkMessages[link];
+        }
+        (*_lastLinkMessages)++;
+        return (_messagesReceived++ & (timingSampleInterval - 1)) == 0 ? _clock.nsecsElapsed() : -1;
+    }
+
+    /// Ends the timing started by messageReceived
+    void messageHandled(uint32_t msgid, qint64 startNsecs)
+    {
+        if (startNsecs >= 0) {
+            qint64 elapsedNsecs = _clock.nsecsElapsed() - startNsecs;
+            MessageCounters_t& messageCounters = _messageCounters[msgid];
+            messageCounters.timedCount++;
+            messageCounters.timedNsecs += elapsedNsecs;
+            if (elapsedNsecs > messageCounters.maxNsecs) {
+                messageCounters.maxNsecs = elapsedNsecs;
+            }
+        }
+    }
+
+    /// Turns the counters into rates and adds them to the history. Normally called by the sample timer.
+    void sample(void);
+
+    /// Results of the last sample
+    const QList<MessageStats_t>&    messageStats    (void) const { return _messageStats; }
+    const QList<LinkStats_t>&       linkStats       (void) const { return _linkStats; }
+    const QList<HandlerStats_t>&    handlerStats    (void) const { return _handlerStats; }
+    const QList<Sample_t>&          history         (void) const { return _history; }
+    quint64                         messagesReceived(void) const { return _messagesReceived; }
+
+    /// Clears all counters, the history and the handler stats of the dispatchers
+    void reset(void);
+
+    QJsonObject toJson  (void) const;
+    bool        saveJson(const QString& fileName, QString& errorString) const;
+
+signals:
+    void sampled(void);
+
+private:
+    typedef struct MessageCounters_t {
+        quint64 count           = 0;
+        quint64 bytes           = 0;
+        quint64 timedCount      = 0;
+        qint64  timedNsecs      = 0;
+        qint64  maxNsecs        = 0;
+        quint64 lastCount       = 0;    ///< At the previous sample
+        quint64 lastBytes       = 0;
+    } MessageCounters_t;
+
+    typedef struct LinkCounters_t {
+        quint64 lastMessages        = 0;
+        quint64 lastBytesReceived   = 0;
+        quint64 lastBytesWritten    = 0;
+    } LinkCounters_t;
+
+    typedef struct Dispatcher_t {
+        QString                                     owner;
+        QPointer<MAVLinkMessageDispatcher>          dispatcher;
+        QHash<int, qint64>                          lastTotalNsecs;     ///< Keyed by subscription id
+    } Dispatcher_t;
+
+    void _sampleMessages    (double intervalSecs, Sample_t& sample);
+    void _sampleLinks       (double intervalSecs, Sample_t& sample);
+    void _sampleHandlers    (double intervalSecs, Sample_t& sample);
+
+    LinkManager*                        _linkManager = nullptr;
+    std::function<QueueDepths_t(void)>  _queueDepthsSource;
+    QTimer                              _sampleTimer;
+    QElapsedTimer                       _clock;
+    qint64                              _lastSampleNsecs = 0;
+
+    quint64                             _messagesReceived = 0;
+    QHash<uint32_t, MessageCounters_t>  _messageCounters;
+    QHash<LinkInterface*, quint64>      _linkMessages;
+    LinkInterface*                      _lastLink           = nullptr;  ///< Saves the link lookup for runs of messages from the same link
+    quint64*                            _lastLinkMessages   = nullptr;
+    QHash<LinkInterface*, LinkCounters_t> _linkCounters;
+    QList<Dispatcher_t>                 _dispatchers;
+
+    QList<MessageStats_t>               _messageStats;
+    QList<LinkStats_t>                  _linkStats;
+    QList<HandlerStats_t>               _handlerStats;
+    QList<Sample_t>                     _history;
+};
@@ -16,6 +16,7 @@
 #include <QFileInfo>
 
 #include "MAVLinkProtocol.h"
+#include "MAVLinkLogIndex.h"
 #include "LinkManager.h"
 #include "QGCApplication.h"
 #include "QGCLoggingCategory.h"
@@ -36,8 +37,6 @@ const char* MAVLinkProtocol::_logFileExtension      = "mavlink";            ///<
 MAVLinkProtocol::MAVLinkProtocol(QGCApplication* app, QGCToolbox* toolbox)
     : QGCTool(app, toolbox)
     , m_enable_version_check(true)
-    , _message({})
-    , _status({})
     , versionMismatchIgnore(false)
     , systemId(255)
     , _current_version(100)
@@ -46,21 +45,39 @@ MAVLinkProtocol::MAVLinkProtocol(QGCApplication* app, QGCToolbox* toolbox)
     , _logSuspendReplay(false)
     , _vehicleWasArmed(false)
     , _tempLogFile(QString("%2.%3").arg(_tempLogFileTemplate).arg(_logFileExtension))
+    , _logWriter(new MAVLinkLogWriter())
     , _linkMgr(nullptr)
     , _multiVehicleManager(nullptr)
+    , _ingestQueue(_ingestQueueCapacity)
+    , _ingestWorker(new MAVLinkIngestWorker(this, &_ingestQueue))
 {
-    memset(totalReceiveCounter, 0, sizeof(totalReceiveCounter));
-    memset(totalLossCounter,    0, sizeof(totalLossCounter));
-    memset(runningLossPercent,  0, sizeof(runningLossPercent));
-    memset(firstMessage,        1, sizeof(firstMessage));
-    memset(&_status,            0, sizeof(_status));
-    memset(&_message,           0, sizeof(_message));
+    _logThread.setObjectName("MAVLinkLog");
+    _logWriter->moveToThread(&_logThread);
+    connect(&_logThread, &QThread::finished, _logWriter, &QObject::deleteLater);
+    connect(_logWriter, &MAVLinkLogWriter::writeFailed, this, &MAVLinkProtocol::_logWriteFailed);
+    _logThread.start();
+
+    _ingestThread.setObjectName("MAVLinkIngest");
+    _ingestWorker->moveToThread(&_ingestThread);
+    connect(&_ingestThread, &QThread::finished, _ingestWorker, &QObject::deleteLater);
+    _ingestThread.start();
 }
 
 MAVLinkProtocol::~MAVLinkProtocol()
 {
+    _ingestWorker->stop();
+    _ingestThread.quit();
+    _ingestThread.wait();
+
     storeSettings();
-    _closeLogFile();
+
+    {
+        QMutexLocker logLocker(&_logMutex);
+        _closeLogFile();
+    }
+
+    _logThread.quit();
+    _logThread.wait();
 }
 
 void MAVLinkProtocol::setVersion(unsigned version)
@@ -102,6 +119,32 @@ void MAVLinkProtocol::setToolbox(QGCToolbox *toolbox)
    connect(_multiVehicleManager, &MultiVehicleManager::vehicleAdded, this, &MAVLinkProtocol::_vehicleCountChanged);
    connect(_multiVehicleManager, &MultiVehicleManager::vehicleRemoved, this, &MAVLinkProtocol::_vehicleCountChanged);
 
+   // The built in forwarding links are sinks which take everything. The support link only exists while support
+   // forwarding is on.
+   _forwardRouter.setLinkManager(_linkMgr);
+   MAVLinkForwardRouter::SinkConfig_t forwardingConfig;
+   forwardingConfig.linkName = LinkManager::mavlinkForwardingLinkName();
+   int forwardingSinkId = _forwardRouter.addSink(forwardingConfig);
+   MAVLinkForwardRouter::SinkConfig_t supportForwardingConfig;
+   supportForwardingConfig.linkName = LinkManager::mavlinkForwardingSupportLinkName();
+   _forwardRouter.addSink(supportForwardingConfig);
+   _forwardRouter.loadSettings();
+
+   Fact* forwardMavlinkFact = _toolbox->settingsManager()->appSettings()->forwardMavlink();
+   _forwardRouter.setSinkEnabled(forwardingSinkId, forwardMavlinkFact->rawValue().toBool());
+   connect(forwardMavlinkFact, &Fact::rawValueChanged, this, [this, forwardingSinkId](QVariant value) { _forwardRouter.setSinkEnabled(forwardingSinkId, value.toBool()); });
+
+   _profiler.setLinkManager(_linkMgr);
+   _profiler.setQueueDepthsSource([this]() {
+       MAVLinkProfiler::QueueDepths_t queueDepths;
+       queueDepths.ingestQueueDepth     = static_cast<qint64>(_ingestQueue.count());
+       queueDepths.ingestBacklogBytes   = _ingestBacklogBytes;
+       queueDepths.ingestQueueFullWaits = _ingestWorker->queueFullWaits();
+       return queueDepths;
+   });
+   _profiler.addDispatcher(tr("MAVLink protocol"), &_messageDispatcher);
+   _profiler.start();
+
    emit versionCheckChanged(m_enable_version_check);
 }
 
@@ -132,16 +175,35 @@ void MAVLinkProtocol::storeSettings()
 
 void MAVLinkProtocol::resetMetadataForLink(LinkInterface *link)
 {
-    int channel = link->mavlinkChannel();
-    totalReceiveCounter[channel] = 0;
-    totalLossCounter[channel]    = 0;
-    runningLossPercent[channel]  = 0.0f;
-    for(int i = 0; i < 256; i++) {
-        firstMessage[channel][i] =  1;
-    }
+    QMetaObject::invokeMethod(_ingestWorker, [worker = _ingestWorker, link]() { worker->resetLink(link); }, Qt::QueuedConnection);
     link->setDecodedFirstMavlinkPacket(false);
 }
 
+void MAVLinkProtocol::connectLink(LinkInterface* link)
+{
+    // Registration goes through the ingest thread's event queue, so it is ordered with respect to the link's bytes
+    uint8_t mavlinkChannel = link->mavlinkChannel();
+    QMetaObject::invokeMethod(_ingestWorker, [worker = _ingestWorker, link, mavlinkChannel]() { worker->addLink(link, mavlinkChannel); }, Qt::QueuedConnection);
+    // Runs on the link's thread, so the backlog is counted from the moment the bytes are emitted
+    connect(link, &LinkInterface::bytesReceived, _ingestWorker, [this](LinkInterface* link, QByteArray bytes) { _queueReceivedBytes(link, bytes); }, Qt::DirectConnection);
+}
+
+void MAVLinkProtocol::disconnectLink(LinkInterface* link)
+{
+    disconnect(link, &LinkInterface::bytesReceived, _ingestWorker, nullptr);
+    QMetaObject::invokeMethod(_ingestWorker, [worker = _ingestWorker, link]() { worker->removeLink(link); }, Qt::QueuedConnection);
+}
+
+int MAVLinkProtocol::subscribe(uint32_t msgid, QObject* context, MessageHandler handler)
+{
+    return _messageDispatcher.subscribe(msgid, context, handler);
+}
+
+void MAVLinkProtocol::unsubscribe(int subscriptionId)
+{
+    _messageDispatcher.unsubscribe(subscriptionId);
+}
+
 /**
  * This method parses all outcoming bytes and log a MAVLink packet.
  * @param link The interface to read from
@@ -150,230 +212,183 @@ void MAVLinkProtocol::resetMetadataForLink(LinkInterface *link)
 
 void MAVLinkProtocol::logSentBytes(LinkInterface* link, QByteArray b){
 
-    uint8_t bytes_time[sizeof(quint64)];
-
     Q_UNUSED(link);
+    QMutexLocker logLocker(&_logMutex);
     if (!_logSuspendError && !_logSuspendReplay && _tempLogFile.isOpen()) {
-
         quint64 time = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
+        _logWriter->append(time, b.constData(), b.length(), MAVLinkLogIndex::msgIdForFrame(b.constData(), b.length()));
+    }
+
+}
 
-        qToBigEndian(time,bytes_time);
+void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
+{
+    _queueReceivedBytes(link, b);
+}
 
-        b.insert(0,QByteArray((const char*)bytes_time,sizeof(bytes_time)));
+void MAVLinkProtocol::_queueReceivedBytes(LinkInterface* link, const QByteArray& bytes)
+{
+    _ingestBacklogBytes += bytes.length();
+    QMetaObject::invokeMethod(_ingestWorker, [this, link, bytes]() {
+        _ingestWorker->receiveBytes(link, bytes);
+        _ingestBacklogBytes -= bytes.length();
+    }, Qt::QueuedConnection);
+}
 
-        int len = b.length();
+void MAVLinkProtocol::_logReceivedFrame(quint64 timeUsecs, const MAVLinkFrameParser::Frame_t& frame, const mavlink_message_t& message)
+{
+    QMutexLocker logLocker(&_logMutex);
 
-        if(_tempLogFile.write(b) != len)
-        {
-            // If there's an error logging data, raise an alert and stop logging.
-            emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile.fileName()));
-            _stopLogging();
-            _logSuspendError = true;
-        }
+    if (_logSuspendError || _logSuspendReplay || !_tempLogFile.isOpen()) {
+        return;
     }
 
+    // The uint64 time in microseconds goes in big endian format before the message. This timestamp is saved in UTC
+    // time. We are only saving in ms precision because getting more than this isn't possible with Qt without a ton of
+    // extra code.
+    _logWriter->append(timeUsecs, reinterpret_cast<const char*>(frame.data), frame.length, message.msgid);
+
+    // Check for the vehicle arming going by. This is used to trigger log save.
+    if (!_vehicleWasArmed && message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        mavlink_heartbeat_t state;
+        mavlink_msg_heartbeat_decode(&message, &state);
+        if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
+            _vehicleWasArmed = true;
+        }
+    }
 }
 
-/**
- * This method parses all incoming bytes and constructs a MAVLink packet.
- * It can handle multiple links in parallel, as each link has it's own buffer/
- * parsing state machine.
- * @param link The interface to read from
- * @see LinkInterface
- **/
-
-void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
+void MAVLinkProtocol::_scheduleIngestDrain(void)
 {
-    // Since receiveBytes signals cross threads we can end up with signals in the queue
-    // that come through after the link is disconnected. For these we just drop the data
-    // since the link is closed.
-    SharedLinkInterfacePtr linkPtr = _linkMgr->sharedLinkInterfacePointerForLink(link, true);
-    if (!linkPtr) {
-        qCDebug(MAVLinkProtocolLog) << "receiveBytes: link gone!" << b.size() << " bytes arrived too late";
-        return;
+    // Only one drain is outstanding at a time no matter how many buffers the ingest thread queues in the meantime
+    if (!_ingestDrainScheduled.exchange(true)) {
+        QMetaObject::invokeMethod(this, &MAVLinkProtocol::_drainIngestQueue, Qt::QueuedConnection);
     }
+}
 
-    uint8_t mavlinkChannel = link->mavlinkChannel();
+void MAVLinkProtocol::_drainIngestQueue(void)
+{
+    // Cleared before reading so anything queued from here on schedules another drain
+    _ingestDrainScheduled = false;
+
+    // Since bytes are queued across threads we can end up with messages that come through
+    // after the link is disconnected. For these we just drop the message since the link is closed.
+    // Consecutive messages are usually from the same link, so the lookup is only done when it changes.
+    LinkInterface*          lastLink = nullptr;
+    SharedLinkInterfacePtr  linkPtr;
+
+    int messageCount = 0;
+    while (messageCount++ < _maxMessagesPerDrain) {
+        const MAVLinkIngestMessage_t* ingestMessage = _ingestQueue.front();
+        if (!ingestMessage) {
+            break;
+        }
 
-    for (int position = 0; position < b.size(); position++) {
-        if (mavlink_parse_char(mavlinkChannel, static_cast<uint8_t>(b[position]), &_message, &_status)) {
-            // Got a valid message
-            if (!link->decodedFirstMavlinkPacket()) {
-                link->setDecodedFirstMavlinkPacket(true);
-                mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-                if (!(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
-                    qCDebug(MAVLinkProtocolLog) << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
-                    mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-                    // Set all links to v2
-                    setVersion(200);
-                }
+        if (ingestMessage->link != lastLink) {
+            lastLink    = ingestMessage->link;
+            linkPtr     = _linkMgr->sharedLinkInterfacePointerForLink(lastLink, true);
+            if (!linkPtr) {
+                qCDebug(MAVLinkProtocolLog) << "_drainIngestQueue: link gone! message arrived too late";
             }
+        }
 
-            //-----------------------------------------------------------------
-            // MAVLink Status
-            uint8_t lastSeq = lastIndex[_message.sysid][_message.compid];
-            uint8_t expectedSeq = lastSeq + 1;
-            // Increase receive counter
-            totalReceiveCounter[mavlinkChannel]++;
-            // Determine what the next expected sequence number is, accounting for
-            // never having seen a message for this system/component pair.
-            if(firstMessage[_message.sysid][_message.compid]) {
-                firstMessage[_message.sysid][_message.compid] = 0;
-                lastSeq     = _message.seq;
-                expectedSeq = _message.seq;
-            }
-            // And if we didn't encounter that sequence number, record the error
-            //int foo = 0;
-            if (_message.seq != expectedSeq)
-            {
-                //foo = 1;
-                int lostMessages = 0;
-                //-- Account for overflow during packet loss
-                if(_message.seq < expectedSeq) {
-                    lostMessages = (_message.seq + 255) - expectedSeq;
-                } else {
-                    lostMessages = _message.seq - expectedSeq;
-                }
-                // Log how many were lost
-                totalLossCounter[mavlinkChannel] += static_cast<uint64_t>(lostMessages);
-            }
+        if (linkPtr) {
+            qint64 profileStartNsecs = _profiler.messageReceived(lastLink, ingestMessage->message, ingestMessage->frameLength);
+            _handleIngestedMessage(lastLink, *ingestMessage);
+            _profiler.messageHandled(ingestMessage->message.msgid, profileStartNsecs);
 
-            // And update the last sequence number for this system/component pair
-            lastIndex[_message.sysid][_message.compid] = _message.seq;;
-            // Calculate new loss ratio
-            uint64_t totalSent = totalReceiveCounter[mavlinkChannel] + totalLossCounter[mavlinkChannel];
-            float receiveLossPercent = static_cast<float>(static_cast<double>(totalLossCounter[mavlinkChannel]) / static_cast<double>(totalSent));
-            receiveLossPercent *= 100.0f;
-            receiveLossPercent = (receiveLossPercent * 0.5f) + (runningLossPercent[mavlinkChannel] * 0.5f);
-            runningLossPercent[mavlinkChannel] = receiveLossPercent;
-
-            //qDebug() << foo << _message.seq << expectedSeq << lastSeq << totalLossCounter[mavlinkChannel] << totalReceiveCounter[mavlinkChannel] << totalSentCounter[mavlinkChannel] << "(" << _message.sysid << _message.compid << ")";
-
-            //-----------------------------------------------------------------
-            // MAVLink forwarding
-            bool forwardingEnabled = _app->toolbox()->settingsManager()->appSettings()->forwardMavlink()->rawValue().toBool();
-            if (forwardingEnabled) {
-                SharedLinkInterfacePtr forwardingLink = _linkMgr->mavlinkForwardingLink();
-
-                if (forwardingLink) {
-                    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-                    int len = mavlink_msg_to_send_buffer(buf, &_message);
-                    forwardingLink->writeBytesThreadSafe((const char*)buf, len);
-                }
+            // Anyone handling the message could close the connection, which deletes the link,
+            // so we check if it's expired
+            if (1 == linkPtr.use_count()) {
+                linkPtr.reset();
             }
+        }
 
-            // MAVLink forwarding support
-            bool forwardingSupportEnabled = _linkMgr->mavlinkSupportForwardingEnabled();
-            if (forwardingSupportEnabled) {
-                SharedLinkInterfacePtr forwardingSupportLink = _linkMgr->mavlinkForwardingSupportLink();
+        _ingestQueue.popFront();
+    }
 
-                if (forwardingSupportLink) {
-                    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
-                    int len = mavlink_msg_to_send_buffer(buf, &_message);
-                    forwardingSupportLink->writeBytesThreadSafe((const char*)buf, len);
-                }
-            }
+    if (_ingestQueue.front()) {
+        // Give the rest of the event loop a turn before continuing with the backlog
+        _scheduleIngestDrain();
+    }
+}
 
-            //-----------------------------------------------------------------
-            // Log data
-            if (!_logSuspendError && !_logSuspendReplay && _tempLogFile.isOpen()) {
-                uint8_t buf[MAVLINK_MAX_PACKET_LEN+sizeof(quint64)];
-
-                // Write the uint64 time in microseconds in big endian format before the message.
-                // This timestamp is saved in UTC time. We are only saving in ms precision because
-                // getting more than this isn't possible with Qt without a ton of extra code.
-                quint64 time = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-                qToBigEndian(time, buf);
-
-                // Then write the message to the buffer
-                int len = mavlink_msg_to_send_buffer(buf + sizeof(quint64), &_message);
-
-                // Determine how many bytes were written by adding the timestamp size to the message size
-                len += sizeof(quint64);
-
-                // Now write this timestamp/message pair to the log.
-                QByteArray b(reinterpret_cast<const char*>(buf), len);
-                if(_tempLogFile.write(b) != len)
-                {
-                    // If there's an error logging data, raise an alert and stop logging.
-                    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile.fileName()));
-                    _stopLogging();
-                    _logSuspendError = true;
-                }
-
-                // Check for the vehicle arming going by. This is used to trigger log save.
-                if (!_vehicleWasArmed && _message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                    mavlink_heartbeat_t state;
-                    mavlink_msg_heartbeat_decode(&_message, &state);
-                    if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
-                        _vehicleWasArmed = true;
-                    }
-                }
-            }
+void MAVLinkProtocol::_handleIngestedMessage(LinkInterface* link, const MAVLinkIngestMessage_t& ingestMessage)
+{
+    const mavlink_message_t& message = ingestMessage.message;
 
-            if (_message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                _startLogging();
-                mavlink_heartbeat_t heartbeat;
-                mavlink_msg_heartbeat_decode(&_message, &heartbeat);
-                emit vehicleHeartbeatInfo(link, _message.sysid, _message.compid, heartbeat.autopilot, heartbeat.type);
-            } else if (_message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY) {
-                _startLogging();
-                mavlink_high_latency_t highLatency;
-                mavlink_msg_high_latency_decode(&_message, &highLatency);
-                // HIGH_LATENCY does not provide autopilot or type information, generic is our safest bet
-                emit vehicleHeartbeatInfo(link, _message.sysid, _message.compid, MAV_AUTOPILOT_GENERIC, MAV_TYPE_GENERIC);
-            } else if (_message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY2) {
-                _startLogging();
-                mavlink_high_latency2_t highLatency2;
-                mavlink_msg_high_latency2_decode(&_message, &highLatency2);
-                emit vehicleHeartbeatInfo(link, _message.sysid, _message.compid, highLatency2.autopilot, highLatency2.type);
-            }
+    if (!link->decodedFirstMavlinkPacket()) {
+        link->setDecodedFirstMavlinkPacket(true);
+        mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(link->mavlinkChannel());
+        if (message.magic == MAVLINK_STX && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+            qCDebug(MAVLinkProtocolLog) << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkStatus << link->mavlinkChannel() << mavlinkStatus->flags;
+            mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+            // Set all links to v2
+            setVersion(200);
+        }
+    }
+
+    //-----------------------------------------------------------------
+    // MAVLink forwarding. The received frame is sent as is, which is byte for byte what
+    // mavlink_msg_to_send_buffer would produce from the decoded message.
+    _forwardRouter.route(link, message, ingestMessage.frame, ingestMessage.frameLength);
+
+    if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+        _startLogging();
+        mavlink_heartbeat_t heartbeat;
+        mavlink_msg_heartbeat_decode(&message, &heartbeat);
+        emit vehicleHeartbeatInfo(link, message.sysid, message.compid, heartbeat.autopilot, heartbeat.type);
+    } else if (message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY) {
+        _startLogging();
+        mavlink_high_latency_t highLatency;
+        mavlink_msg_high_latency_decode(&message, &highLatency);
+        // HIGH_LATENCY does not provide autopilot or type information, generic is our safest bet
+        emit vehicleHeartbeatInfo(link, message.sysid, message.compid, MAV_AUTOPILOT_GENERIC, MAV_TYPE_GENERIC);
+    } else if (message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY2) {
+        _startLogging();
+        mavlink_high_latency2_t highLatency2;
+        mavlink_msg_high_latency2_decode(&message, &highLatency2);
+        emit vehicleHeartbeatInfo(link, message.sysid, message.compid, highLatency2.autopilot, highLatency2.type);
+    }
 
 #if 0
-            // Given the current state of SiK Radio firmwares there is no way to make the code below work.
-            // The ArduPilot implementation of SiK Radio firmware always sends MAVLINK_MSG_ID_RADIO_STATUS as a mavlink 1
-            // packet even if the vehicle is sending Mavlink 2.
-
-            // Detect if we are talking to an old radio not supporting v2
-            mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-            if (_message.msgid == MAVLINK_MSG_ID_RADIO_STATUS && _radio_version_mismatch_count != -1) {
-                if ((mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1)
-                && !(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
-                    _radio_version_mismatch_count++;
-                }
-            }
+    // Given the current state of SiK Radio firmwares there is no way to make the code below work.
+    // The ArduPilot implementation of SiK Radio firmware always sends MAVLINK_MSG_ID_RADIO_STATUS as a mavlink 1
+    // packet even if the vehicle is sending Mavlink 2.
+
+    // Detect if we are talking to an old radio not supporting v2
+    mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(link->mavlinkChannel());
+    if (message.msgid == MAVLINK_MSG_ID_RADIO_STATUS && _radio_version_mismatch_count != -1) {
+        if (message.magic == MAVLINK_STX_MAVLINK1
+        && !(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+            _radio_version_mismatch_count++;
+        }
+    }
 
-            if (_radio_version_mismatch_count == 5) {
-                // Warn the user if the radio continues to send v1 while the link uses v2
-                emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Detected radio still using MAVLink v1.0 on a link with MAVLink v2.0 enabled. Please upgrade the radio firmware."));
-                // Set to flag warning already shown
-                _radio_version_mismatch_count = -1;
-                // Flick link back to v1
-                qDebug() << "Switching outbound to mavlink 1.0 due to incoming mavlink 1.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
-                mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-            }
+    if (_radio_version_mismatch_count == 5) {
+        // Warn the user if the radio continues to send v1 while the link uses v2
+        emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Detected radio still using MAVLink v1.0 on a link with MAVLink v2.0 enabled. Please upgrade the radio firmware."));
+        // Set to flag warning already shown
+        _radio_version_mismatch_count = -1;
+        // Flick link back to v1
+        qDebug() << "Switching outbound to mavlink 1.0 due to incoming mavlink 1.0 packet:" << mavlinkStatus << link->mavlinkChannel() << mavlinkStatus->flags;
+        mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    }
 #endif
 
-            // Update MAVLink status on every 32th packet
-            if ((totalReceiveCounter[mavlinkChannel] & 0x1F) == 0) {
-                emit mavlinkMessageStatus(_message.sysid, totalSent, totalReceiveCounter[mavlinkChannel], totalLossCounter[mavlinkChannel], receiveLossPercent);
-            }
+    if (ingestMessage.statusUpdate) {
+        emit mavlinkMessageStatus(message.sysid, ingestMessage.totalSent, ingestMessage.totalReceived, ingestMessage.totalLoss, ingestMessage.lossPercent);
+    }
 
-            // The packet is emitted as a whole, as it is only 255 - 261 bytes short
-            // kind of inefficient, but no issue for a groundstation pc.
-            // It buys as reentrancy for the whole code over all threads
-            emit messageReceived(link, _message);
+    // The packet is emitted as a whole, as it is only 255 - 261 bytes short
+    // kind of inefficient, but no issue for a groundstation pc.
+    // It buys as reentrancy for the whole code over all threads
+    emit messageReceived(link, message);
 
-            // Anyone handling the message could close the connection, which deletes the link,
-            // so we check if it's expired
-            if (1 == linkPtr.use_count()) {
-                break;
-            }
-
-            // Reset message parsing
-            memset(&_status,  0, sizeof(_status));
-            memset(&_message, 0, sizeof(_message));
-        }
+    if (_messageDispatcher.hasHandlers(message.msgid)) {
+        // Subscribers see the message as const, the copy is only there to match the dispatcher's handlers
+        mavlink_message_t dispatchMessage = message;
+        _messageDispatcher.dispatch(link, dispatchMessage);
     }
 }
 
@@ -418,13 +433,15 @@ void MAVLinkProtocol::_vehicleCountChanged(void)
     }
 }
 
-/// @brief Closes the log file if it is open
+/// @brief Closes the log file if it is open. Caller must hold _logMutex.
 bool MAVLinkProtocol::_closeLogFile(void)
 {
     if (_tempLogFile.isOpen()) {
+        _logWriter->close();
         if (_tempLogFile.size() == 0) {
             // Don't save zero byte files
             _tempLogFile.remove();
+            QFile::remove(MAVLinkLogIndex::indexFileName(_tempLogFile.fileName()));
             return false;
         } else {
             _tempLogFile.flush();
@@ -453,38 +470,59 @@ void MAVLinkProtocol::_startLogging(void)
 #endif
     //-- Log is always written to a temp file. If later the user decides they want
     //   it, it's all there for them.
+    QMutexLocker logLocker(&_logMutex);
     if (!_tempLogFile.isOpen()) {
         if (!_logSuspendReplay) {
             if (!_tempLogFile.open()) {
-                emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Opening Flight Data file for writing failed. "
-                                                                      "Unable to write to %1. Please choose a different file location.").arg(_tempLogFile.fileName()));
                 _closeLogFile();
                 _logSuspendError = true;
+                logLocker.unlock();
+                emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Opening Flight Data file for writing failed. "
+                                                                      "Unable to write to %1. Please choose a different file location.").arg(_tempLogFile.fileName()));
                 return;
             }
 
             qCDebug(MAVLinkProtocolLog) << "Temp log" << _tempLogFile.fileName();
-            emit checkTelemetrySavePath();
-
+            _logWriter->open(&_tempLogFile);
             _logSuspendError = false;
+            logLocker.unlock();
+
+            emit checkTelemetrySavePath();
         }
     }
 }
 
 void MAVLinkProtocol::_stopLogging(void)
 {
-    if (_tempLogFile.isOpen()) {
-        if (_closeLogFile()) {
-            if ((_vehicleWasArmed || _app->toolbox()->settingsManager()->appSettings()->telemetrySaveNotArmed()->rawValue().toBool()) &&
-                _app->toolbox()->settingsManager()->appSettings()->telemetrySave()->rawValue().toBool() &&
-                !_app->toolbox()->settingsManager()->appSettings()->disableAllPersistence()->rawValue().toBool()) {
-                emit saveTelemetryLog(_tempLogFile.fileName());
-            } else {
-                QFile::remove(_tempLogFile.fileName());
-            }
+    QMutexLocker logLocker(&_logMutex);
+
+    bool vehicleWasArmed = _vehicleWasArmed;
+    bool logClosed = _tempLogFile.isOpen() && _closeLogFile();
+    _vehicleWasArmed = false;
+    logLocker.unlock();
+
+    if (logClosed) {
+        if ((vehicleWasArmed || _app->toolbox()->settingsManager()->appSettings()->telemetrySaveNotArmed()->rawValue().toBool()) &&
+            _app->toolbox()->settingsManager()->appSettings()->telemetrySave()->rawValue().toBool() &&
+            !_app->toolbox()->settingsManager()->appSettings()->disableAllPersistence()->rawValue().toBool()) {
+            emit saveTelemetryLog(_tempLogFile.fileName());
+        } else {
+            QFile::remove(_tempLogFile.fileName());
+            QFile::remove(MAVLinkLogIndex::indexFileName(_tempLogFile.fileName()));
         }
     }
-    _vehicleWasArmed = false;
+}
+
+void MAVLinkProtocol::_logWriteFailed(QString errorString)
+{
+    // If there's an error logging data, raise an alert and stop logging.
+    {
+        QMutexLocker logLocker(&_logMutex);
+        _logSuspendError = true;
+    }
+    qCWarning(MAVLinkProtocolLog) << "Log write failed" << errorString;
+    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile.fileName()));
+    _stopLogging();
 }
 
 /// @brief Checks the temp directory for log files which may have been left there.
@@ -503,6 +541,7 @@ void MAVLinkProtocol::checkForLostLogFiles(void)
         if (fileInfo.size() == 0) {
             // Delete all zero length files
             QFile::remove(fileInfo.filePath());
+            QFile::remove(MAVLinkLogIndex::indexFileName(fileInfo.filePath()));
             continue;
         }
         emit saveTelemetryLog(fileInfo.filePath());
@@ -511,6 +550,7 @@ void MAVLinkProtocol::checkForLostLogFiles(void)
 
 void MAVLinkProtocol::suspendLogForReplay(bool suspend)
 {
+    QMutexLocker logLocker(&_logMutex);
     _logSuspendReplay = suspend;
 }
 
@@ -519,7 +559,7 @@ void MAVLinkProtocol::deleteTempLogFiles(void)
     QDir tempDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
 
     QString filter(QString("*.%1").arg(_logFileExtension));
-    QFileInfoList fileInfoList = tempDir.entryInfoList(QStringList(filter), QDir::Files);
+    QFileInfoList fileInfoList = tempDir.entryInfoList(QStringList(filter) << MAVLinkLogIndex::indexFileName(filter), QDir::Files);
 
     for (const QFileInfo& fileInfo: fileInfoList) {
         QFile::remove(fileInfo.filePath());
@@ -12,8 +12,20 @@
 #include <QString>
 #include <QByteArray>
 #include <QLoggingCategory>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QPointer>
+
+#include <atomic>
+#include <functional>
 
 #include "LinkInterface.h"
+#include "MAVLinkForwardRouter.h"
+#include "MAVLinkIngest.h"
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkMessageDispatcher.h"
+#include "MAVLinkProfiler.h"
 #include "QGCMAVLink.h"
 #include "QGCTemporaryFile.h"
 #include "QGCToolbox.h"
@@ -29,6 +41,11 @@ Q_DECLARE_LOGGING_CATEGORY(MAVLinkProtocolLog)
  *
  * MAVLink is a generic communication protocol for micro air vehicles.
  * for more information, please see the official website: https://mavlink.io
+ *
+ * Link bytes are parsed, loss accounted and logged on a dedicated ingest thread (see MAVLinkIngestWorker). Decoded
+ * messages come back to the GUI thread through a lock-free queue, where they are forwarded (see MAVLinkForwardRouter)
+ * and delivered through messageReceived and to the handlers subscribed to their message id. The telemetry log and its index are written
+ * in batches on a separate log thread (see MAVLinkLogWriter). The GUI thread side is profiled by MAVLinkProfiler.
  **/
 class MAVLinkProtocol : public QGCTool
 {
@@ -62,6 +79,35 @@ public:
      */
     virtual void resetMetadataForLink(LinkInterface *link);
 
+    /// Routes the link's received bytes to the ingest thread
+    void connectLink(LinkInterface* link);
+
+    /// Stops ingesting bytes from the link. Bytes already queued for it are dropped.
+    void disconnectLink(LinkInterface* link);
+
+    typedef std::function<void(LinkInterface* link, const mavlink_message_t& message)> MessageHandler;
+
+    /// Calls handler on the GUI thread for each received message with the specified id. The subscription ends when
+    /// context is destroyed or through unsubscribe.
+    /// @return Subscription id for unsubscribe
+    int subscribe(uint32_t msgid, QObject* context, MessageHandler handler);
+    void unsubscribe(int subscriptionId);
+
+    /// Dispatcher behind subscribe, for its handler stats
+    const MAVLinkMessageDispatcher* messageDispatcher(void) const { return &_messageDispatcher; }
+
+    /// @return Number of times the ingest thread had to wait for the GUI thread to make room in the ingest queue
+    uint64_t ingestQueueFullWaits(void) const { return _ingestWorker->queueFullWaits(); }
+
+    /// @return Bytes received from links which the ingest thread has not parsed yet. Lets sources which can produce
+    ///         faster than real time, such as log replay, hold off.
+    qint64 ingestBacklogBytes(void) const { return _ingestBacklogBytes; }
+
+    MAVLinkForwardRouter* forwardRouter(void) { return &_forwardRouter; }
+
+    /// Throughput profile of the received messages and of the handlers subscribed through here
+    MAVLinkProfiler* profiler(void) { return &_profiler; }
+
     /// Suspend/Restart logging during replay.
     void suspendLogForReplay(bool suspend);
 
@@ -72,7 +118,7 @@ public:
     virtual void setToolbox(QGCToolbox *toolbox);
 
 public slots:
-    /** @brief Receive bytes from a communication interface */
+    /** @brief Receive bytes from a communication interface. Queued to the ingest thread, can be called from any thread. */
     void receiveBytes(LinkInterface* link, QByteArray b);
 
     /** @brief Log bytes sent from a communication interface */
@@ -97,14 +143,6 @@ public slots:
 
 protected:
     bool        m_enable_version_check;                         ///< Enable checking of version match of MAV and QGC
-    uint8_t     lastIndex[256][256];                            ///< Store the last received sequence ID for each system/componenet pair
-    uint8_t     firstMessage[256][256];                         ///< First message flag
-    uint64_t    totalReceiveCounter[MAVLINK_COMM_NUM_BUFFERS];  ///< The total number of successfully received messages
-    uint64_t    totalLossCounter[MAVLINK_COMM_NUM_BUFFERS];     ///< Total messages lost during transmission.
-    float       runningLossPercent[MAVLINK_COMM_NUM_BUFFERS];   ///< Loss rate
-
-    mavlink_message_t _message;
-    mavlink_status_t _status;
 
     bool        versionMismatchIgnore;
     int         systemId;
@@ -148,21 +186,48 @@ signals:
 
 private slots:
     void _vehicleCountChanged(void);
+    void _logWriteFailed(QString errorString);
 
 private:
     bool _closeLogFile(void);
     void _startLogging(void);
     void _stopLogging(void);
 
+    // Called on the ingest thread by MAVLinkIngestWorker
+    void _logReceivedFrame      (quint64 timeUsecs, const MAVLinkFrameParser::Frame_t& frame, const mavlink_message_t& message);
+    void _scheduleIngestDrain   (void);
+
+    void _queueReceivedBytes    (LinkInterface* link, const QByteArray& bytes);
+    void _drainIngestQueue      (void);
+    void _handleIngestedMessage (LinkInterface* link, const MAVLinkIngestMessage_t& ingestMessage);
+
     bool _logSuspendError;      ///< true: Logging suspended due to error
     bool _logSuspendReplay;     ///< true: Logging suspended due to replay
     bool _vehicleWasArmed;      ///< true: Vehicle was armed during log sequence
 
+    QMutex              _logMutex;               ///< Guards the log file and the _log*/_vehicleWasArmed state, which the ingest thread also uses
     QGCTemporaryFile    _tempLogFile;            ///< File to log to
+    QThread             _logThread;
+    MAVLinkLogWriter*   _logWriter;              ///< Lives on _logThread, writes _tempLogFile
     static const char*  _tempLogFileTemplate;    ///< Template for temporary log file
     static const char*  _logFileExtension;       ///< Extension for log files
 
     LinkManager*            _linkMgr;
     MultiVehicleManager*    _multiVehicleManager;
+    MAVLinkForwardRouter    _forwardRouter;
+
+    MAVLinkIngestQueue      _ingestQueue;
+    QThread                 _ingestThread;
+    MAVLinkIngestWorker*    _ingestWorker;
+    std::atomic<bool>       _ingestDrainScheduled { false };
+    std::atomic<qint64>     _ingestBacklogBytes { 0 };
+
+    MAVLinkMessageDispatcher    _messageDispatcher;
+    MAVLinkProfiler             _profiler;
+
+    static constexpr int _ingestQueueCapacity   = 1024;
+    static constexpr int _maxMessagesPerDrain   = 256;  ///< Keeps a backlog from starving the rest of the GUI event loop
+
+    friend class MAVLinkIngestWorker;
 };
 
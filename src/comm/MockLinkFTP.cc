@@ -10,6 +10,7 @@
 
 #include "MockLinkFTP.h"
 #include "MockLink.h"
+#include "FTPBulkDownload.h"
 
 const MockLinkFTP::ErrorMode_t MockLinkFTP::rgFailureModes[] = {
     MockLinkFTP::errModeNoResponse,
@@ -30,6 +31,11 @@ MockLinkFTP::MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, Mock
     srand(0); // make sure unit tests are deterministic
 }
 
+MockLinkFTP::~MockLinkFTP()
+{
+    _closeSessions(false /* removeFiles */);
+}
+
 void MockLinkFTP::ensureNullTemination(MavlinkFTP::Request* request)
 {
     if (request->hdr.size < sizeof(request->data)) {
@@ -112,53 +118,86 @@ void MockLinkFTP::_openCommand(uint8_t senderSystemId, uint8_t senderComponentId
     Q_UNUSED(cchPath); // Fix initialized-but-not-referenced warning on release builds
     path = (char *)request->data;
 
-    _currentFile.close();
-
-    QString sizePrefix = sizeFilenamePrefix;
-    if (path.startsWith(sizePrefix)) {
-        QString sizeString = path.right(path.length() - sizePrefix.length());
-        tmpFilename = _createTestTempFile(sizeString.toInt());
-    } else if (path == "/general.json") {
-        tmpFilename = ":MockLink/General.MetaData.json";
-    } else if (path == "/general.json.xz") {
-        tmpFilename = ":MockLink/General.MetaData.json.xz";
-    } else if (path == "/parameter.json") {
-        tmpFilename = ":MockLink/Parameter.MetaData.json";
-    } else if (path == "/parameter.json.xz") {
-        tmpFilename = ":MockLink/Parameter.MetaData.json.xz";
-    } else if (_BinParamFileEnabled && path == "@PARAM/param.pck") {
-        tmpFilename = ":MockLink/Arduplane.params.ftp.bin";
+    tmpFilename = _localFileForPath(path);
+    if (tmpFilename.isEmpty()) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        return;
     }
 
-    if (!tmpFilename.isEmpty()) {
-        _currentFile.setFileName(tmpFilename);
-        if (!_currentFile.open(QIODevice::ReadOnly)) {
-            _sendNakErrno(senderSystemId, senderComponentId, _currentFile.error(), outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+    uint8_t sessionId = 1;
+    if (_maxSessions <= 1) {
+        _closeSessions(false /* removeFiles */);
+    } else {
+        while (sessionId <= _maxSessions && _sessionFiles.contains(sessionId)) {
+            sessionId++;
+        }
+        if (sessionId > _maxSessions) {
+            _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrNoSessionsAvailable, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
             return;
         }
-    } else {
-        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+    }
+
+    QFile* file = new QFile(tmpFilename);
+    if (!file->open(QIODevice::ReadOnly)) {
+        _sendNakErrno(senderSystemId, senderComponentId, file->error(), outgoingSeqNumber, MavlinkFTP::kCmdOpenFileRO);
+        delete file;
         return;
     }
+    _sessionFiles[sessionId]    = file;
+    _responseSessionId          = sessionId;
     
     response.hdr.opcode     = MavlinkFTP::kRspAck;
     response.hdr.req_opcode = MavlinkFTP::kCmdOpenFileRO;
-    response.hdr.session    = _sessionId;
+    response.hdr.session    = sessionId;
     
     // Data contains file length
     response.hdr.size = sizeof(uint32_t);
     /* Ardupilot sends constant wrong file size for parameter file due to dynamic on the fly generation */
-    response.openFileLength = (path == "@PARAM/param.pck" ? 1024*1024 : _currentFile.size());
+    response.openFileLength = (path == "@PARAM/param.pck" ? 1024*1024 : file->size());
     
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
 
+QString MockLinkFTP::_localFileForPath(const QString& path)
+{
+    QString sizePrefix = sizeFilenamePrefix;
+    if (path.startsWith(sizePrefix)) {
+        QString sizeString = path.right(path.length() - sizePrefix.length());
+        return _createTestTempFile(sizeString.toInt());
+    } else if (path == "/general.json") {
+        return ":MockLink/General.MetaData.json";
+    } else if (path == "/general.json.xz") {
+        return ":MockLink/General.MetaData.json.xz";
+    } else if (path == "/parameter.json") {
+        return ":MockLink/Parameter.MetaData.json";
+    } else if (path == "/parameter.json.xz") {
+        return ":MockLink/Parameter.MetaData.json.xz";
+    } else if (_BinParamFileEnabled && path == "@PARAM/param.pck") {
+        return ":MockLink/Arduplane.params.ftp.bin";
+    }
+
+    return QString();
+}
+
+void MockLinkFTP::_closeSessions(bool removeFiles)
+{
+    for (QFile* file: _sessionFiles) {
+        file->close();
+        if (removeFiles) {
+            file->remove();
+        }
+        delete file;
+    }
+    _sessionFiles.clear();
+}
+
 void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
 {
     MavlinkFTP::Request	response{};
     uint16_t			outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
+    QFile* file = _sessionFiles.value(request->hdr.session, nullptr);
+    if (!file) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
         return;
     }
@@ -177,20 +216,20 @@ void MockLinkFTP::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId
         }
     }
     
-    if (readOffset >= _currentFile.size()) {
+    if (readOffset >= file->size()) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdReadFile);
         return;
     }
     
-    uint8_t cBytesToRead = (uint8_t)qMin((qint64)sizeof(response.data), _currentFile.size() - readOffset);
-    _currentFile.seek(readOffset);
-    QByteArray bytes = _currentFile.read(cBytesToRead);
+    uint8_t cBytesToRead = (uint8_t)qMin((qint64)sizeof(response.data), file->size() - readOffset);
+    file->seek(readOffset);
+    QByteArray bytes = file->read(cBytesToRead);
     memcpy(response.data, bytes.constData(), cBytesToRead);
     
     // We should always have written something, otherwise there is something wrong with the code above
     Q_ASSERT(cBytesToRead);
     
-    response.hdr.session    = _sessionId;
+    response.hdr.session    = request->hdr.session;
     response.hdr.size       = cBytesToRead;
     response.hdr.offset     = request->hdr.offset;
     response.hdr.opcode     = MavlinkFTP::kRspAck;
@@ -204,7 +243,8 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
     uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
     MavlinkFTP::Request response{};
 
-    if (request->hdr.session != _sessionId) {
+    QFile* file = _sessionFiles.value(request->hdr.session, nullptr);
+    if (!file) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFail, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
         return;
     }
@@ -213,18 +253,18 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
     int         burstCount  = 1;
     uint32_t    burstOffset = request->hdr.offset;
 
-    while (burstOffset < _currentFile.size() && burstCount++ < burstMax) {
-        _currentFile.seek(burstOffset);
+    while (burstOffset < file->size() && burstCount++ < burstMax) {
+        file->seek(burstOffset);
 
-        uint8_t     cBytes  = (uint8_t)qMin((qint64)sizeof(response.data), _currentFile.size() - burstOffset);
-        QByteArray  bytes   = _currentFile.read(cBytes);
+        uint8_t     cBytes  = (uint8_t)qMin((qint64)sizeof(response.data), file->size() - burstOffset);
+        QByteArray  bytes   = file->read(cBytes);
 
         // We should always have written something, otherwise there is something wrong with the code above
         Q_ASSERT(cBytes);
 
         memcpy(response.data, bytes.constData(), cBytes);
 
-        response.hdr.session        = _sessionId;
+        response.hdr.session        = request->hdr.session;
         response.hdr.size           = cBytes;
         response.hdr.offset         = burstOffset;
         response.hdr.opcode         = MavlinkFTP::kRspAck;
@@ -237,7 +277,7 @@ void MockLinkFTP::_burstReadCommand(uint8_t senderSystemId, uint8_t senderCompon
         burstOffset += cBytes;
     }
 
-    if (burstOffset >= _currentFile.size()) {
+    if (burstOffset >= file->size()) {
         // Burst is fully complete
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrEOF, outgoingSeqNumber, MavlinkFTP::kCmdBurstReadFile);
     }
@@ -247,10 +287,13 @@ void MockLinkFTP::_terminateCommand(uint8_t senderSystemId, uint8_t senderCompon
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
 
-    if (request->hdr.session != _sessionId) {
+    QFile* file = _sessionFiles.take(request->hdr.session);
+    if (!file) {
         _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrInvalidSession, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
         return;
     }
+    file->close();
+    delete file;
     
     _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdTerminateSession);
 
@@ -261,13 +304,44 @@ void MockLinkFTP::_resetCommand(uint8_t senderSystemId, uint8_t senderComponentI
 {
     uint16_t outgoingSeqNumber = _nextSeqNumber(seqNumber);
     
-    _currentFile.close();
-    _currentFile.remove();
+    _closeSessions(true /* removeFiles */);
     _sendAck(senderSystemId, senderComponentId, outgoingSeqNumber, MavlinkFTP::kCmdResetSessions);
     
     emit resetCommandReceived();
 }
 
+void MockLinkFTP::_crcCommand(uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber)
+{
+    MavlinkFTP::Request response{};
+    uint16_t            outgoingSeqNumber = _nextSeqNumber(seqNumber);
+
+    ensureNullTemination(request);
+
+    QString path        = (char *)request->data;
+    QString localFile   = _localFileForPath(path);
+    QFile   file(localFile);
+    if (localFile.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        _sendNak(senderSystemId, senderComponentId, MavlinkFTP::kErrFailFileNotFound, outgoingSeqNumber, MavlinkFTP::kCmdCalcFileCRC32);
+        return;
+    }
+
+    QByteArray  bytes   = file.readAll();
+    uint32_t    crc     = FTPBulkDownload::crc32(reinterpret_cast<const uint8_t*>(bytes.constData()), bytes.size());
+
+    // Sized test files are generated on each request, unlike the resource files
+    file.close();
+    if (path.startsWith(sizeFilenamePrefix)) {
+        file.remove();
+    }
+
+    response.hdr.opcode     = MavlinkFTP::kRspAck;
+    response.hdr.req_opcode = MavlinkFTP::kCmdCalcFileCRC32;
+    response.hdr.size       = sizeof(uint32_t);
+    memcpy(response.data, &crc, sizeof(crc));
+
+    _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
+}
+
 void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
 {
     if (message.msgid != MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL) {
@@ -303,6 +377,8 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
 
     uint16_t incomingSeqNumber = request->hdr.seqNumber;
     uint16_t outgoingSeqNumber = _nextSeqNumber(incomingSeqNumber);
+
+    _responseSessionId = request->hdr.session;
     
     if (request->hdr.opcode != MavlinkFTP::kCmdResetSessions && request->hdr.opcode != MavlinkFTP::kCmdTerminateSession) {
         if (_errMode == errModeNoResponse) {
@@ -348,6 +424,10 @@ void MockLinkFTP::mavlinkMessageReceived(const mavlink_message_t& message)
         _resetCommand(message.sysid, message.compid, incomingSeqNumber);
         break;
 
+    case MavlinkFTP::kCmdCalcFileCRC32:
+        _crcCommand(message.sysid, message.compid, request, incomingSeqNumber);
+        break;
+
     default:
         // nack for all NYI opcodes
         _sendNak(message.sysid, message.compid, MavlinkFTP::kErrUnknownCommand, outgoingSeqNumber, (MavlinkFTP::OpCode_t)request->hdr.opcode);
@@ -362,7 +442,7 @@ void MockLinkFTP::_sendAck(uint8_t targetSystemId, uint8_t targetComponentId, ui
     
     ackResponse.hdr.opcode      = MavlinkFTP::kRspAck;
     ackResponse.hdr.req_opcode  = reqOpcode;
-    ackResponse.hdr.session     = _sessionId;
+    ackResponse.hdr.session     = _responseSessionId;
     ackResponse.hdr.size        = 0;
     
     _sendResponse(targetSystemId, targetComponentId, &ackResponse, seqNumber);
@@ -374,7 +454,7 @@ void MockLinkFTP::_sendNak(uint8_t targetSystemId, uint8_t targetComponentId, Ma
 
     nakResponse.hdr.opcode      = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode  = reqOpcode;
-    nakResponse.hdr.session     = _sessionId;
+    nakResponse.hdr.session     = _responseSessionId;
     nakResponse.hdr.size        = 1;
     nakResponse.data[0]         = error;
     
@@ -387,7 +467,7 @@ void MockLinkFTP::_sendNakErrno(uint8_t targetSystemId, uint8_t targetComponentI
 
     nakResponse.hdr.opcode      = MavlinkFTP::kRspNak;
     nakResponse.hdr.req_opcode  = reqOpcode;
-    nakResponse.hdr.session     = _sessionId;
+    nakResponse.hdr.session     = _responseSessionId;
     nakResponse.hdr.size        = 2;
     nakResponse.data[0]         = MavlinkFTP::kErrFailErrno;
     nakResponse.data[1]         = nakErrno;
@@ -14,6 +14,7 @@
 
 #include <QStringList>
 #include <QFile>
+#include <QMap>
 
 class MockLink;
 
@@ -24,6 +25,7 @@ class MockLinkFTP : public QObject
     
 public:
     MockLinkFTP(uint8_t systemIdServer, uint8_t componentIdServer, MockLink* mockLink);
+    ~MockLinkFTP();
     
     /// @brief Sets the list of files returned by the List command. Prepend names with F or D
     /// to indicate (F)ile or (D)irectory.
@@ -57,6 +59,10 @@ public:
     void enableRandromDrops(bool enable) { _randomDropsEnabled = enable; }
     void enableBinParamFile(bool enable) { _BinParamFileEnabled = enable; }
 
+    /// Sets the number of files which can be open at the same time. With a single session opening a file replaces
+    /// the file which is currently open.
+    void setMaxSessions(int maxSessions) { _maxSessions = maxSessions; }
+
     static const char* sizeFilenamePrefix;
 
 signals:
@@ -77,6 +83,9 @@ private:
     void        _burstReadCommand          (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _terminateCommand       (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
     void        _resetCommand           (uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
+    void        _crcCommand             (uint8_t senderSystemId, uint8_t senderComponentId, MavlinkFTP::Request* request, uint16_t seqNumber);
+    QString     _localFileForPath       (const QString& path);
+    void        _closeSessions          (bool removeFiles);
     uint16_t    _nextSeqNumber          (uint16_t seqNumber);
     QString     _createTestTempFile     (int size);
     
@@ -85,7 +94,7 @@ private:
 
     QStringList _fileList;  ///< List of files returned by List command
     
-    QFile                   _currentFile;
+    QMap<uint8_t, QFile*>   _sessionFiles;                      ///< Open files keyed by session id
     ErrorMode_t             _errMode            = errModeNone;  ///< Currently set error mode, as specified by setErrorMode
     const uint8_t           _systemIdServer;                    ///< System ID for server
     const uint8_t           _componentIdServer;                 ///< Component ID for server
@@ -96,6 +105,7 @@ private:
     bool                    _randomDropsEnabled = false;
     bool                    _BinParamFileEnabled = false;
 
-    static const uint8_t    _sessionId          = 1;    ///< We only support a single fixed session
+    int                     _maxSessions        = 1;
+    uint8_t                 _responseSessionId  = 0;            ///< Session id returned in responses to the request being handled
 };
 
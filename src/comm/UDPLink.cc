@@ -10,7 +10,6 @@
 #include <QtGlobal>
 #include <QList>
 #include <QDebug>
-#include <QMutexLocker>
 #include <QNetworkProxy>
 #include <QNetworkInterface>
 #include <QHostInfo>
@@ -20,6 +19,12 @@
 #include "SettingsManager.h"
 #include "AutoConnectSettings.h"
 
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cstring>
+#endif
+
 static const char* kZeroconfRegistration = "_qgroundcontrol._udp";
 
 static bool is_ip(const QString& address)
@@ -62,6 +67,35 @@ static bool contains_target(const QList<UDPCLient*> list, const QHostAddress& ad
     return false;
 }
 
+#ifdef Q_OS_LINUX
+/// Receive buffers for recvmmsg. One slot per datagram, set up once and reused for every read.
+struct UDPLink::ReceivePool {
+    static constexpr int batchCount = 64;
+    static constexpr int slotBytes  = 4096;     ///< MAVLink datagrams stay well under the MTU
+
+    ReceivePool(void)
+    {
+        for (int i=0; i<batchCount; i++) {
+            iovecs[i].iov_base = data + (i * slotBytes);
+            iovecs[i].iov_len  = slotBytes;
+            memset(&headers[i], 0, sizeof(headers[i]));
+            headers[i].msg_hdr.msg_name     = &senders[i];
+            headers[i].msg_hdr.msg_iov      = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen   = 1;
+        }
+    }
+
+    mmsghdr             headers[batchCount];
+    iovec               iovecs[batchCount];
+    sockaddr_storage    senders[batchCount];
+    char                data[batchCount * slotBytes];
+
+    /// Raw address of the last sender, so a run of datagrams from the same peer is recognized with a memcmp
+    sockaddr_storage    lastSender;
+    socklen_t           lastSenderLength = 0;
+};
+#endif
+
 UDPLink::UDPLink(SharedLinkConfigurationPtr& config)
     : LinkInterface     (config)
     , _running          (false)
@@ -91,6 +125,7 @@ UDPLink::~UDPLink()
     // Clear client list
     qDeleteAll(_sessionTargets);
     _sessionTargets.clear();
+    _sessionTargetsBySender.clear();
     quit();
     // Wait for it to exit
     wait();
@@ -141,13 +176,10 @@ void UDPLink::_writeBytes(const QByteArray data)
     }
     emit bytesSent(this, data);
 
-    QMutexLocker locker(&_sessionTargetsMutex);
-
     // Send to all manually targeted systems
-    for (int i=0; i<_udpConfig->targetHosts().count(); i++) {
-        UDPCLient* target = _udpConfig->targetHosts()[i];
+    for (const UDPCLient* target: _udpConfig->targetHosts()) {
         // Skip it if it's part of the session clients below
-        if(!contains_target(_sessionTargets, target->address, target->port)) {
+        if (!_sessionTargets.contains(SessionTargetKey(target->address, target->port))) {
             _writeDataGram(data, target);
         }
     }
@@ -165,11 +197,46 @@ void UDPLink::_writeDataGram(const QByteArray data, const UDPCLient* target)
     }
 }
 
+void UDPLink::_sessionTargetSeen(const QHostAddress& sender, quint16 senderPort)
+{
+    // Nearly every datagram comes from the same peer as the one before it
+    if (senderPort == _lastSenderPort && sender == _lastSender) {
+        return;
+    }
+    _lastSender     = sender;
+    _lastSenderPort = senderPort;
+
+    SessionTargetKey senderKey(sender, senderPort);
+    if (_sessionTargetsBySender.contains(senderKey)) {
+        return;
+    }
+
+    // TODO: This doesn't validade the sender. Anything sending UDP packets to this port gets
+    // added to the list and will start receiving datagrams from here. Even a port scanner
+    // would trigger this.
+    // Add host to broadcast list if not yet present, or update its port
+    QHostAddress asender = sender;
+    if(_isIpLocal(sender)) {
+        asender = QHostAddress(QString("127.0.0.1"));
+    }
+    SessionTargetKey targetKey(asender, senderPort);
+    UDPCLient* target = _sessionTargets.value(targetKey);
+    if (!target) {
+        qDebug() << "Adding target" << asender << senderPort;
+        target = new UDPCLient(asender, senderPort);
+        _sessionTargets.insert(targetKey, target);
+    }
+    _sessionTargetsBySender.insert(senderKey, target);
+}
+
 void UDPLink::readBytes()
 {
     if (!_socket) {
         return;
     }
+#ifdef Q_OS_LINUX
+    _readBytesBatched();
+#else
     QByteArray databuffer;
     while (_socket->hasPendingDatagrams())
     {
@@ -189,27 +256,73 @@ void UDPLink::readBytes()
             emit bytesReceived(this, databuffer);
             databuffer.clear();
         }
-        // TODO: This doesn't validade the sender. Anything sending UDP packets to this port gets
-        // added to the list and will start receiving datagrams from here. Even a port scanner
-        // would trigger this.
-        // Add host to broadcast list if not yet present, or update its port
-        QHostAddress asender = sender;
-        if(_isIpLocal(sender)) {
-            asender = QHostAddress(QString("127.0.0.1"));
-        }
-        QMutexLocker locker(&_sessionTargetsMutex);
-        if (!contains_target(_sessionTargets, asender, senderPort)) {
-            qDebug() << "Adding target" << asender << senderPort;
-            UDPCLient* target = new UDPCLient(asender, senderPort);
-            _sessionTargets.append(target);
+        _sessionTargetSeen(sender, senderPort);
+    }
+    //-- Send whatever is left
+    if (databuffer.size()) {
+        emit bytesReceived(this, databuffer);
+    }
+#endif
+}
+
+#ifdef Q_OS_LINUX
+void UDPLink::_readBytesBatched(void)
+{
+    if (!_receivePool) {
+        _receivePool.reset(new ReceivePool);
+    }
+    ReceivePool& pool = *_receivePool;
+    int socketDescriptor = static_cast<int>(_socket->socketDescriptor());
+
+    QByteArray databuffer;
+
+    while (true) {
+        int count;
+        do {
+            for (int i=0; i<ReceivePool::batchCount; i++) {
+                pool.headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+                pool.headers[i].msg_hdr.msg_flags   = 0;
+            }
+            count = recvmmsg(socketDescriptor, pool.headers, ReceivePool::batchCount, MSG_DONTWAIT, nullptr);
+            for (int i=0; i<count; i++) {
+                const msghdr& header = pool.headers[i].msg_hdr;
+                if (header.msg_flags & MSG_TRUNC) {
+                    qWarning() << "UDP datagram truncated to" << ReceivePool::slotBytes << "bytes";
+                }
+                databuffer.append(pool.data + (i * ReceivePool::slotBytes), static_cast<int>(pool.headers[i].msg_len));
+                if (header.msg_namelen != pool.lastSenderLength || memcmp(&pool.senders[i], &pool.lastSender, header.msg_namelen) != 0) {
+                    memcpy(&pool.lastSender, &pool.senders[i], header.msg_namelen);
+                    pool.lastSenderLength = header.msg_namelen;
+                    // The socket is bound to an IPv4 address, so every sender is a sockaddr_in
+                    _sessionTargetSeen(QHostAddress(reinterpret_cast<const sockaddr*>(&pool.senders[i])),
+                                       ntohs(reinterpret_cast<const sockaddr_in*>(&pool.senders[i])->sin_port));
+                }
+            }
+            //-- Wait a bit before sending it over
+            if (databuffer.size() > 10 * 1024) {
+                emit bytesReceived(this, databuffer);
+                databuffer.clear();
+            }
+        } while (count == ReceivePool::batchCount);
+
+        // QUdpSocket only turns its read notification back on from one of its own reads. Once recvmmsg has drained the
+        // socket this normally finds nothing, anything which did slip in gets picked up and the drain starts over.
+        QHostAddress    sender;
+        quint16         senderPort;
+        qint64 slen = _socket->readDatagram(pool.data, ReceivePool::slotBytes, &sender, &senderPort);
+        if (slen < 0) {
+            break;
         }
-        locker.unlock();
+        databuffer.append(pool.data, static_cast<int>(slen));
+        _sessionTargetSeen(sender, senderPort);
+        pool.lastSenderLength = 0;
     }
     //-- Send whatever is left
     if (databuffer.size()) {
         emit bytesReceived(this, databuffer);
     }
 }
+#endif
 
 void UDPLink::disconnect(void)
 {
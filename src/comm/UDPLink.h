@@ -11,11 +11,13 @@
 
 #include <QString>
 #include <QList>
-#include <QMutex>
+#include <QHash>
+#include <QPair>
 #include <QUdpSocket>
-#include <QMutex>
 #include <QByteArray>
 
+#include <memory>
+
 #if defined(QGC_ZEROCONF_ENABLED)
 #include <dns_sd.h>
 #endif
@@ -121,14 +123,29 @@ private:
     void _registerZeroconf  (uint16_t port, const std::string& regType);
     void _deregisterZeroconf(void);
     void _writeDataGram     (const QByteArray data, const UDPCLient* target);
+    void _sessionTargetSeen (const QHostAddress& sender, quint16 senderPort);
+#ifdef Q_OS_LINUX
+    void _readBytesBatched  (void);
+
+    struct ReceivePool;
+#endif
+
+    typedef QPair<QHostAddress, quint16> SessionTargetKey;
 
     bool                _running;
     QUdpSocket*         _socket;
     UDPConfiguration*   _udpConfig;
     bool                _connectState;
-    QList<UDPCLient*>   _sessionTargets;
-    QMutex              _sessionTargetsMutex;
     QList<QHostAddress> _localAddresses;
+
+    // Session targets are only touched from the link thread, which does all of the reading and writing
+    QHash<SessionTargetKey, UDPCLient*>         _sessionTargets;            ///< Keyed by target address/port
+    QHash<SessionTargetKey, UDPCLient*>         _sessionTargetsBySender;    ///< Keyed by sender as received, values owned by _sessionTargets
+    QHostAddress                                _lastSender;
+    quint16                                     _lastSenderPort = 0;
+#ifdef Q_OS_LINUX
+    std::unique_ptr<ReceivePool>                _receivePool;               ///< recvmmsg buffers, reused for every read
+#endif
 #if defined(QGC_ZEROCONF_ENABLED)
     DNSServiceRef       _dnssServiceRef;
 #endif
@@ -30,6 +30,12 @@ ReleaseBuild {
     HEADERS += \
         #$$PWD/AnalyzeView/LogDownloadTest.h \
         $$PWD/Audio/AudioOutputTest.h \
+        $$PWD/comm/MAVLinkForwardRouterTest.h \
+        $$PWD/comm/MAVLinkFrameParserTest.h \
+        $$PWD/comm/MAVLinkLogWriterTest.h \
+        $$PWD/comm/MAVLinkMessageDispatcherTest.h \
+        $$PWD/comm/MAVLinkProfilerTest.h \
+        $$PWD/comm/UDPLinkTest.h \
         $$PWD/FactSystem/FactSystemTestBase.h \
         $$PWD/FactSystem/FactSystemTestGeneric.h \
         $$PWD/FactSystem/FactSystemTestPX4.h \
@@ -78,6 +84,12 @@ ReleaseBuild {
     SOURCES += \
         #$$PWD/AnalyzeView/LogDownloadTest.cc \
         $$PWD/Audio/AudioOutputTest.cc \
+        $$PWD/comm/MAVLinkForwardRouterTest.cc \
+        $$PWD/comm/MAVLinkFrameParserTest.cc \
+        $$PWD/comm/MAVLinkLogWriterTest.cc \
+        $$PWD/comm/MAVLinkMessageDispatcherTest.cc \
+        $$PWD/comm/MAVLinkProfilerTest.cc \
+        $$PWD/comm/UDPLinkTest.cc \
         $$PWD/FactSystem/FactSystemTestBase.cc \
         $$PWD/FactSystem/FactSystemTestGeneric.cc \
         $$PWD/FactSystem/FactSystemTestPX4.cc \
@@ -50,6 +50,12 @@
 #include "VehicleLinkManagerTest.h"
 #include "LandingComplexItemTest.h"
 #include "InitialConnectTest.h"
+#include "MAVLinkForwardRouterTest.h"
+#include "MAVLinkFrameParserTest.h"
+#include "MAVLinkLogWriterTest.h"
+#include "MAVLinkMessageDispatcherTest.h"
+#include "MAVLinkProfilerTest.h"
+#include "UDPLinkTest.h"
 
 UT_REGISTER_TEST(ComponentInformationCacheTest)
 UT_REGISTER_TEST(ComponentInformationTranslationTest)
@@ -64,6 +70,12 @@ UT_REGISTER_TEST(SendMavCommandWithHandlerTest)
 UT_REGISTER_TEST(RequestMessageTest)
 UT_REGISTER_TEST(FTPManagerTest)
 UT_REGISTER_TEST(InitialConnectTest)
+UT_REGISTER_TEST(MAVLinkForwardRouterTest)
+UT_REGISTER_TEST(MAVLinkFrameParserTest)
+UT_REGISTER_TEST(MAVLinkLogWriterTest)
+UT_REGISTER_TEST(MAVLinkMessageDispatcherTest)
+UT_REGISTER_TEST(MAVLinkProfilerTest)
+UT_REGISTER_TEST(UDPLinkTest)
 UT_REGISTER_TEST(MissionItemTest)
 UT_REGISTER_TEST(SimpleMissionItemTest)
 UT_REGISTER_TEST(MissionControllerTest)
@@ -88,6 +100,8 @@ UT_REGISTER_TEST(FWLandingPatternTest)
 UT_REGISTER_TEST(LandingComplexItemTest)
 
 UT_REGISTER_TEST_STANDALONE(MissionCommandTreeEditorTest)
+UT_REGISTER_TEST_STANDALONE(MAVLinkFrameParserBenchmark)
+UT_REGISTER_TEST_STANDALONE(UDPLinkBenchmark)
 
 // List of unit test which are currently disabled.
 // If disabling a new test, include reason in comment.
@@ -13,6 +13,11 @@
 #include "MockLink.h"
 #include "FTPManager.h"
 
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
 const FTPManagerTest::TestCase_t FTPManagerTest::_rgTestCases[] = {
     {  "/general.json" },
 };
@@ -297,3 +302,174 @@ void FTPManagerTest::_testListDirectoryBadSequence(void)
 
     _disconnectMockLink();
 }
+
+void FTPManagerTest::_downloadFilesWorker(const QString& toDir, const QList<int>& fileSizes, int maxSessions)
+{
+    FTPManager* ftpManager = _vehicle->ftpManager();
+    QStringList fileNames;
+
+    for (int fileSize: fileSizes) {
+        fileNames.append(QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(fileSize));
+    }
+
+    QSignalSpy spyDownloadFilesComplete (ftpManager, &FTPManager::downloadFilesComplete);
+    QSignalSpy spyFileDownloadComplete  (ftpManager, &FTPManager::fileDownloadComplete);
+
+    QVERIFY(ftpManager->downloadFiles(MAV_COMP_ID_AUTOPILOT1, QString(), fileNames, toDir, maxSessions));
+
+    // Only one operation at a time
+    QVERIFY(!ftpManager->download(MAV_COMP_ID_AUTOPILOT1, fileNames.first(), toDir));
+
+    QCOMPARE(spyDownloadFilesComplete.wait(10000), true);
+    QCOMPARE(spyDownloadFilesComplete.count(), 1);
+    QVERIFY(spyDownloadFilesComplete.takeFirst()[0].toString().isEmpty());
+    QCOMPARE(spyFileDownloadComplete.count(), fileSizes.count());
+
+    for (int i=0; i<fileSizes.count(); i++) {
+        QFileInfo fileInfo(QDir(toDir).absoluteFilePath(fileNames[i]));
+        QVERIFY(fileInfo.exists());
+        QCOMPARE(fileInfo.size(), fileSizes[i]);
+
+        QFile file(fileInfo.absoluteFilePath());
+        QVERIFY(file.open(QFile::ReadOnly));
+        QByteArray bytes = file.readAll();
+        for (int j=0; j<bytes.size(); j++) {
+            QCOMPARE(bytes[j], (char)(j % 255));
+        }
+    }
+}
+
+void FTPManagerTest::_testDownloadFiles(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _mockLink->mockLinkFTP()->setMaxSessions(3);
+
+    QTemporaryDir toDir;
+    QVERIFY(toDir.isValid());
+
+    // Mix of files smaller than a packet, exactly a packet, multiple bursts and empty
+    const int dataSize = sizeof(((MavlinkFTP::Request*)0)->data);
+    _downloadFilesWorker(toDir.path(), { dataSize - 1, dataSize, 3 * 1024, 10 * 1024, 0 }, 3);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testDownloadFilesLostPackets(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _mockLink->mockLinkFTP()->setMaxSessions(3);
+    _mockLink->mockLinkFTP()->enableRandromDrops(true);
+
+    QTemporaryDir toDir;
+    QVERIFY(toDir.isValid());
+
+    _downloadFilesWorker(toDir.path(), { 4 * 1024, 5 * 1024, 6 * 1024 }, 3);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testDownloadFilesSessionLimit(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _mockLink->mockLinkFTP()->setMaxSessions(2);
+
+    QTemporaryDir toDir;
+    QVERIFY(toDir.isValid());
+
+    // More sessions are requested than the vehicle supports, the download must settle on what is available
+    _downloadFilesWorker(toDir.path(), { 1024, 2048, 3072, 4096 }, 4);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testDownloadFilesResume(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+    _mockLink->mockLinkFTP()->setMaxSessions(2);
+
+    QTemporaryDir toDir;
+    QVERIFY(toDir.isValid());
+
+    const int   fileSize    = 5 * 1024;
+    QString     fileName    = QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(fileSize);
+    QString     filePath    = QDir(toDir.path()).absoluteFilePath(fileName);
+
+    _downloadFilesWorker(toDir.path(), { fileSize, 1024 }, 2);
+
+    // Make it look like the download was interrupted with holes at the start, middle and end of the file
+    QFile manifestFile(QDir(toDir.path()).absoluteFilePath(FTPBulkDownload::manifestFileName));
+    QVERIFY(manifestFile.open(QFile::ReadOnly));
+    QJsonObject manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+    manifestFile.close();
+
+    QJsonObject files       = manifest["files"].toObject();
+    QJsonObject fileJson    = files[fileName].toObject();
+    QCOMPARE(fileJson["complete"].toBool(), true);
+    fileJson["complete"]    = false;
+    fileJson["received"]    = QJsonArray({ QJsonArray({ 100, 1000 }), QJsonArray({ 2000, 1500 }) });
+    files[fileName]         = fileJson;
+    manifest["files"]       = files;
+
+    QVERIFY(manifestFile.open(QFile::WriteOnly | QFile::Truncate));
+    manifestFile.write(QJsonDocument(manifest).toJson());
+    manifestFile.close();
+
+    // Scribble over the missing parts so only a correct resume passes verification
+    QFile file(filePath);
+    QVERIFY(file.open(QFile::ReadWrite));
+    file.seek(0);
+    file.write(QByteArray(100, 'x'));
+    file.seek(1100);
+    file.write(QByteArray(900, 'x'));
+    file.resize(3500);
+    file.close();
+
+    _downloadFilesWorker(toDir.path(), { fileSize, 1024 }, 2);
+
+    _disconnectMockLink();
+}
+
+void FTPManagerTest::_testReadFileRange(void)
+{
+    _connectMockLinkNoInitialConnectSequence();
+
+    FTPManager* ftpManager  = _vehicle->ftpManager();
+    int         fileSize    = 8 * 1024;
+    QString     filename    = QStringLiteral("%1%2").arg(MockLinkFTP::sizeFilenamePrefix).arg(fileSize);
+
+    QSignalSpy spyReadFileRangeComplete(ftpManager, &FTPManager::readFileRangeComplete);
+
+    struct RangeTestCase_t {
+        uint32_t offset;
+        uint32_t size;
+        uint32_t expectedSize;
+    };
+    const RangeTestCase_t rgRangeTestCases[] = {
+        { 3000,                                     1000,   1000 },                         // Within the first burst
+        { 0,                                        5000,   5000 },                         // Across several bursts
+        { static_cast<uint32_t>(fileSize) - 100,    1000,   100 },                          // Clamped to end of file
+        { static_cast<uint32_t>(fileSize) + 100,    1000,   0 },                            // Past end of file
+    };
+
+    for (const RangeTestCase_t& testCase: rgRangeTestCases) {
+        spyReadFileRangeComplete.clear();
+        QVERIFY(ftpManager->readFileRange(MAV_COMP_ID_AUTOPILOT1, filename, testCase.offset, testCase.size));
+
+        QCOMPARE(spyReadFileRangeComplete.wait(10000), true);
+        QCOMPARE(spyReadFileRangeComplete.count(), 1);
+
+        // void readFileRangeComplete(const QString& file, uint32_t offset, const QByteArray& data, uint32_t fileSize, const QString& errorMsg);
+        QList<QVariant> arguments = spyReadFileRangeComplete.takeFirst();
+        QVERIFY(arguments[4].toString().isEmpty());
+        QCOMPARE(arguments[3].toUInt(), static_cast<uint32_t>(fileSize));
+
+        uint32_t    offset  = arguments[1].toUInt();
+        QByteArray  data    = arguments[2].toByteArray();
+        QCOMPARE(static_cast<uint32_t>(data.size()), testCase.expectedSize);
+        for (int i=0; i<data.size(); i++) {
+            QCOMPARE(data[i], (char)((offset + i) % 255));
+        }
+    }
+
+    _disconnectMockLink();
+}
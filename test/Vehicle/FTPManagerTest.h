@@ -24,6 +24,11 @@ private slots:
     void _testListDirectoryNoSecondResponseAllowRetry   (void);
     void _testListDirectoryNakSecondResponse            (void);
     void _testListDirectoryBadSequence                  (void);
+    void _testDownloadFiles                             (void);
+    void _testDownloadFilesLostPackets                  (void);
+    void _testDownloadFilesSessionLimit                 (void);
+    void _testDownloadFilesResume                       (void);
+    void _testReadFileRange                             (void);
 
     // Overrides from UnitTest
     void cleanup(void) override;
@@ -39,6 +44,7 @@ private:
     void _testCaseWorker            (const TestCase_t& testCase);
     void _sizeTestCaseWorker        (int fileSize);
     void _verifyFileSizeAndDelete   (const QString& filename, int expectedSize);
+    void _downloadFilesWorker       (const QString& toDir, const QList<int>& fileSizes, int maxSessions);
 
     static const TestCase_t _rgTestCases[];
 };
@@ -0,0 +1,221 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkForwardRouterTest.h"
+#include "MAVLinkForwardRouter.h"
+#include "LinkManager.h"
+#include "UDPLink.h"
+
+#include <QSemaphore>
+#include <QUdpSocket>
+
+// Channel at the top of the range is not used by any link during unit tests
+static constexpr uint8_t _packChannel = MAVLINK_COMM_NUM_BUFFERS - 1;
+
+typedef struct TestFrame_t {
+    mavlink_message_t   message;
+    uint8_t             frame[MAVLINK_MAX_PACKET_LEN];
+    int                 frameLength;
+} TestFrame_t;
+
+static TestFrame_t _heartbeat(uint8_t sysid)
+{
+    TestFrame_t testFrame;
+    mavlink_msg_heartbeat_pack_chan(sysid, MAV_COMP_ID_AUTOPILOT1, _packChannel, &testFrame.message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, 0, MAV_STATE_ACTIVE);
+    testFrame.frameLength = mavlink_msg_to_send_buffer(testFrame.frame, &testFrame.message);
+    return testFrame;
+}
+
+static TestFrame_t _attitude(uint8_t sysid)
+{
+    TestFrame_t testFrame;
+    mavlink_msg_attitude_pack_chan(sysid, MAV_COMP_ID_AUTOPILOT1, _packChannel, &testFrame.message, 0, 0.1f, 0.2f, 0.3f, 0, 0, 0);
+    testFrame.frameLength = mavlink_msg_to_send_buffer(testFrame.frame, &testFrame.message);
+    return testFrame;
+}
+
+static void _route(MAVLinkForwardRouter& router, const TestFrame_t& testFrame, LinkInterface* sourceLink = nullptr)
+{
+    router.route(sourceLink, testFrame.message, testFrame.frame, testFrame.frameLength);
+}
+
+/// Connects a UDP link with peer as its only target, for use as a sink
+static SharedLinkInterfacePtr _connectSinkLink(LinkManager* linkManager, const QString& name, const QUdpSocket& peer)
+{
+    QUdpSocket portFinder;
+    portFinder.bind(QHostAddress::AnyIPv4, 0);
+
+    UDPConfiguration* udpConfig = new UDPConfiguration(name);
+    udpConfig->setDynamic(true);
+    udpConfig->setLocalPort(portFinder.localPort());
+    udpConfig->addHost(QStringLiteral("127.0.0.1"), peer.localPort());
+    portFinder.close();
+
+    SharedLinkConfigurationPtr config(udpConfig);
+    if (!linkManager->createConnectedLink(config)) {
+        return nullptr;
+    }
+    return linkManager->sharedLinkInterfacePointerForLink(config->link());
+}
+
+/// Reads whatever has arrived at peer into datagrams
+/// @return Total datagram count
+static int _readDatagrams(QUdpSocket& peer, QList<QByteArray>& datagrams)
+{
+    while (peer.hasPendingDatagrams()) {
+        QByteArray datagram(static_cast<int>(peer.pendingDatagramSize()), 0);
+        peer.readDatagram(datagram.data(), datagram.length());
+        datagrams.append(datagram);
+    }
+    return datagrams.count();
+}
+
+void MAVLinkForwardRouterTest::_filter_test(void)
+{
+    QUdpSocket attitudePeer;
+    QUdpSocket system2Peer;
+    QVERIFY(attitudePeer.bind(QHostAddress::LocalHost, 0));
+    QVERIFY(system2Peer.bind(QHostAddress::LocalHost, 0));
+
+    SharedLinkInterfacePtr attitudeLink = _connectSinkLink(_linkManager, QStringLiteral("AttitudeSink"), attitudePeer);
+    SharedLinkInterfacePtr system2Link  = _connectSinkLink(_linkManager, QStringLiteral("System2Sink"), system2Peer);
+    QVERIFY(attitudeLink);
+    QVERIFY(system2Link);
+    QTRY_VERIFY(attitudeLink->isConnected() && system2Link->isConnected());
+
+    MAVLinkForwardRouter router;
+    router.setLinkManager(_linkManager);
+
+    MAVLinkForwardRouter::SinkConfig_t attitudeConfig;
+    attitudeConfig.linkName = QStringLiteral("AttitudeSink");
+    attitudeConfig.msgIds.insert(MAVLINK_MSG_ID_ATTITUDE);
+    int attitudeSinkId = router.addSink(attitudeConfig);
+
+    MAVLinkForwardRouter::SinkConfig_t system2Config;
+    system2Config.linkName = QStringLiteral("System2Sink");
+    system2Config.sysIds.insert(2);
+    int system2SinkId = router.addSink(system2Config);
+
+    const TestFrame_t attitude1     = _attitude(1);
+    const TestFrame_t heartbeat1    = _heartbeat(1);
+    const TestFrame_t heartbeat2    = _heartbeat(2);
+    _route(router, heartbeat1);
+    _route(router, attitude1);
+    _route(router, heartbeat2);
+
+    // Nothing goes back out the link it came in on
+    _route(router, attitude1, attitudeLink.get());
+
+    QList<QByteArray> attitudeDatagrams;
+    QList<QByteArray> system2Datagrams;
+    QTRY_COMPARE(_readDatagrams(attitudePeer, attitudeDatagrams), 1);
+    QTRY_COMPARE(_readDatagrams(system2Peer, system2Datagrams), 1);
+    QTest::qWait(100);
+    QCOMPARE(_readDatagrams(attitudePeer, attitudeDatagrams), 1);
+    QCOMPARE(_readDatagrams(system2Peer, system2Datagrams), 1);
+    QCOMPARE(attitudeDatagrams[0], QByteArray(reinterpret_cast<const char*>(attitude1.frame), attitude1.frameLength));
+    QCOMPARE(system2Datagrams[0], QByteArray(reinterpret_cast<const char*>(heartbeat2.frame), heartbeat2.frameLength));
+
+    MAVLinkForwardRouter::SinkStats_t attitudeStats = router.sinkStats(attitudeSinkId);
+    QCOMPARE(attitudeStats.forwarded, 1ull);
+    QCOMPARE(attitudeStats.filtered, 2ull);
+    MAVLinkForwardRouter::SinkStats_t system2Stats = router.sinkStats(system2SinkId);
+    QCOMPARE(system2Stats.forwarded, 1ull);
+    QCOMPARE(system2Stats.filtered, 3ull);
+
+    // Disabled sinks get nothing
+    router.setSinkEnabled(system2SinkId, false);
+    _route(router, heartbeat2);
+    QTest::qWait(100);
+    QCOMPARE(_readDatagrams(system2Peer, system2Datagrams), 1);
+
+    attitudeLink->disconnect();
+    system2Link->disconnect();
+}
+
+void MAVLinkForwardRouterTest::_rateLimit_test(void)
+{
+    QUdpSocket peer;
+    QVERIFY(peer.bind(QHostAddress::LocalHost, 0));
+
+    SharedLinkInterfacePtr sinkLink = _connectSinkLink(_linkManager, QStringLiteral("RateLimitSink"), peer);
+    QVERIFY(sinkLink);
+    QTRY_VERIFY(sinkLink->isConnected());
+
+    MAVLinkForwardRouter router;
+    router.setLinkManager(_linkManager);
+
+    MAVLinkForwardRouter::SinkConfig_t config;
+    config.linkName     = QStringLiteral("RateLimitSink");
+    config.maxRateHz    = 1;
+    int sinkId = router.addSink(config);
+
+    // Each system id/message id stream is limited on its own
+    const TestFrame_t attitude1 = _attitude(1);
+    const TestFrame_t attitude2 = _attitude(2);
+    for (int i=0; i<50; i++) {
+        _route(router, attitude1);
+        _route(router, attitude2);
+    }
+
+    QList<QByteArray> datagrams;
+    QTRY_COMPARE(_readDatagrams(peer, datagrams), 2);
+    MAVLinkForwardRouter::SinkStats_t stats = router.sinkStats(sinkId);
+    QCOMPARE(stats.forwarded, 2ull);
+    QCOMPARE(stats.rateLimited, 98ull);
+
+    sinkLink->disconnect();
+}
+
+void MAVLinkForwardRouterTest::_backpressure_test(void)
+{
+    QUdpSocket peer;
+    QVERIFY(peer.bind(QHostAddress::LocalHost, 0));
+
+    SharedLinkInterfacePtr sinkLink = _connectSinkLink(_linkManager, QStringLiteral("BackpressureSink"), peer);
+    QVERIFY(sinkLink);
+    QTRY_VERIFY(sinkLink->isConnected());
+
+    const TestFrame_t heartbeat = _heartbeat(1);
+
+    MAVLinkForwardRouter router;
+    router.setLinkManager(_linkManager);
+
+    MAVLinkForwardRouter::SinkConfig_t config;
+    config.linkName         = QStringLiteral("BackpressureSink");
+    config.maxPendingBytes  = 5 * heartbeat.frameLength;
+    int sinkId = router.addSink(config);
+
+    QSemaphore linkThreadBlock;
+    {
+        // Holds up the link thread so nothing routed below is written until this scope ends
+        QSemaphoreReleaser linkThreadRelease(linkThreadBlock);
+        QMetaObject::invokeMethod(sinkLink.get(), [&linkThreadBlock]() { linkThreadBlock.acquire(); }, Qt::QueuedConnection);
+
+        for (int i=0; i<20; i++) {
+            _route(router, heartbeat);
+        }
+        QCOMPARE(sinkLink->pendingWriteBytes(), static_cast<qint64>(5 * heartbeat.frameLength));
+
+        MAVLinkForwardRouter::SinkStats_t stats = router.sinkStats(sinkId);
+        QCOMPARE(stats.forwarded, 5ull);
+        QCOMPARE(stats.dropped, 15ull);
+    }
+
+    QTRY_COMPARE(sinkLink->pendingWriteBytes(), 0ll);
+    QList<QByteArray> datagrams;
+    QTRY_COMPARE(_readDatagrams(peer, datagrams), 5);
+
+    // Caught up, so frames flow again
+    _route(router, heartbeat);
+    QCOMPARE(router.sinkStats(sinkId).forwarded, 6ull);
+    QTRY_COMPARE(_readDatagrams(peer, datagrams), 6);
+
+    sinkLink->disconnect();
+}
@@ -0,0 +1,23 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for MAVLinkForwardRouter. Sinks are UDP links targeting a local socket.
+class MAVLinkForwardRouterTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _filter_test       (void);
+    void _rateLimit_test    (void);
+    void _backpressure_test (void);
+};
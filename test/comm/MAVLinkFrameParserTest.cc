@@ -0,0 +1,316 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkFrameParserTest.h"
+#include "MAVLinkFrameParser.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtEndian>
+
+// Channels at the top of the range are not used by any link during unit tests
+static constexpr uint8_t _generateChannel   = MAVLINK_COMM_NUM_BUFFERS - 1;
+static constexpr uint8_t _referenceChannel  = MAVLINK_COMM_NUM_BUFFERS - 2;
+
+static void _clearChannelStatus(uint8_t channel)
+{
+    memset(mavlink_get_channel_status(channel), 0, sizeof(mavlink_status_t));
+}
+
+/// Stream of typical telemetry. Mavlink 2 payloads are trimmed by the sender, every 7th message is mavlink 1.
+static QByteArray _generateStream(int messageCount, bool includeV1)
+{
+    QByteArray          stream;
+    mavlink_status_t*   status = mavlink_get_channel_status(_generateChannel);
+
+    _clearChannelStatus(_generateChannel);
+    for (int i=0; i<messageCount; i++) {
+        mavlink_message_t message;
+
+        if (includeV1 && i % 7 == 3) {
+            status->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        } else {
+            status->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+        }
+
+        switch (i % 4) {
+        case 0:
+            mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _generateChannel, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, MAV_MODE_FLAG_SAFETY_ARMED, 0, MAV_STATE_ACTIVE);
+            break;
+        case 1:
+            mavlink_msg_attitude_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _generateChannel, &message, i * 10, 0.1f * i, 0.2f, 0.3f, 0, 0, 0);
+            break;
+        case 2:
+            mavlink_msg_global_position_int_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _generateChannel, &message, i * 10, 473977418 + i, 85455939, 0, 0, 0, 0, 0, 0);
+            break;
+        default:
+            mavlink_msg_vfr_hud_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, _generateChannel, &message, 12.5f, 12.0f, 90, 50, 100.0f, 0);
+            break;
+        }
+
+        uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+        int len = mavlink_msg_to_send_buffer(buf, &message);
+        stream.append(reinterpret_cast<const char*>(buf), len);
+    }
+
+    status->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    return stream;
+}
+
+static QByteArray _frameBytes(const mavlink_message_t& message)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    int len = mavlink_msg_to_send_buffer(buf, &message);
+    return QByteArray(reinterpret_cast<const char*>(buf), len);
+}
+
+static QList<mavlink_message_t> _referenceParse(const QByteArray& stream)
+{
+    QList<mavlink_message_t>    messages;
+    mavlink_message_t           message;
+    mavlink_status_t            status;
+
+    _clearChannelStatus(_referenceChannel);
+    for (char byte: stream) {
+        if (mavlink_parse_char(_referenceChannel, static_cast<uint8_t>(byte), &message, &status)) {
+            messages.append(message);
+        }
+    }
+
+    return messages;
+}
+
+static QList<mavlink_message_t> _frameParse(MAVLinkFrameParser& parser, const QByteArray& stream, int chunkSize, QByteArray* frames = nullptr)
+{
+    QList<mavlink_message_t>        messages;
+    mavlink_message_t               message;
+    MAVLinkFrameParser::Frame_t     frame;
+
+    for (int position=0; position<stream.length(); position+=chunkSize) {
+        // Each chunk is a separate allocation, as it would be coming from a link
+        QByteArray chunk = stream.mid(position, chunkSize);
+        parser.setBuffer(chunk);
+        while (parser.nextMessage(message, frame)) {
+            messages.append(message);
+            if (frames) {
+                frames->append(reinterpret_cast<const char*>(frame.data), frame.length);
+            }
+        }
+    }
+
+    return messages;
+}
+
+static bool _sameMessage(const mavlink_message_t& message1, const mavlink_message_t& message2)
+{
+    if (message1.magic != message2.magic || message1.len != message2.len || message1.seq != message2.seq ||
+            message1.sysid != message2.sysid || message1.compid != message2.compid || message1.msgid != message2.msgid ||
+            message1.incompat_flags != message2.incompat_flags || message1.checksum != message2.checksum) {
+        return false;
+    }
+
+    // Decoders read up to the full payload length, which must be zero filled past a trimmed payload
+    const mavlink_msg_entry_t* msgEntry = mavlink_get_msg_entry(message1.msgid);
+    return memcmp(_MAV_PAYLOAD(&message1), _MAV_PAYLOAD(&message2), msgEntry->max_msg_len) == 0;
+}
+
+void MAVLinkFrameParserTest::_parse_test(void)
+{
+    QByteArray                  stream = _generateStream(200, true /* includeV1 */);
+    QList<mavlink_message_t>    referenceMessages = _referenceParse(stream);
+    MAVLinkFrameParser          parser;
+    QByteArray                  frames;
+
+    QList<mavlink_message_t> messages = _frameParse(parser, stream, stream.length(), &frames);
+
+    QCOMPARE(referenceMessages.count(), 200);
+    QCOMPARE(messages.count(), referenceMessages.count());
+    for (int i=0; i<messages.count(); i++) {
+        QVERIFY2(_sameMessage(messages[i], referenceMessages[i]), qPrintable(QStringLiteral("Message %1").arg(i)));
+    }
+
+    // Frames are the received bytes, which is exactly what mavlink_msg_to_send_buffer produces
+    QCOMPARE(frames, stream);
+
+    const mavlink_status_t& status = parser.status();
+    QCOMPARE(status.packet_rx_success_count, static_cast<uint16_t>(200));
+    QCOMPARE(status.parse_error, static_cast<uint8_t>(0));
+    QCOMPARE(status.current_rx_seq, messages.last().seq);
+    QCOMPARE(static_cast<bool>(status.flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1), messages.last().magic == MAVLINK_STX_MAVLINK1);
+}
+
+void MAVLinkFrameParserTest::_splitBuffer_test(void)
+{
+    QByteArray                  stream = _generateStream(50, true /* includeV1 */);
+    QList<mavlink_message_t>    referenceMessages = _referenceParse(stream);
+
+    // Frames split at every possible point across one or more buffers
+    const int chunkSizes[] = { 1, 2, 3, 7, 11, 64, 255, 1000 };
+    for (int chunkSize: chunkSizes) {
+        MAVLinkFrameParser  parser;
+        QByteArray          frames;
+
+        QList<mavlink_message_t> messages = _frameParse(parser, stream, chunkSize, &frames);
+        QCOMPARE(messages.count(), referenceMessages.count());
+        for (int i=0; i<messages.count(); i++) {
+            QVERIFY(_sameMessage(messages[i], referenceMessages[i]));
+        }
+        QCOMPARE(frames, stream);
+        QCOMPARE(parser.heldBytes(), 0);
+    }
+
+    // A partial frame is held until reset
+    MAVLinkFrameParser parser;
+    QCOMPARE(_frameParse(parser, stream.left(5), 5).count(), 0);
+    QCOMPARE(parser.heldBytes(), 5);
+    parser.reset();
+    QCOMPARE(parser.heldBytes(), 0);
+    QCOMPARE(_frameParse(parser, stream, stream.length()).count(), referenceMessages.count());
+
+    // Only the rest of the split frame is copied from the next buffer, the frames after it are parsed in place
+    mavlink_message_t           message;
+    MAVLinkFrameParser::Frame_t frame;
+    QByteArray                  rest = stream.mid(5);
+    parser.reset();
+    parser.setBuffer(stream.left(5));
+    QVERIFY(!parser.nextMessage(message, frame));
+    parser.setBuffer(rest);
+    QVERIFY(parser.nextMessage(message, frame));
+    QCOMPARE(parser.heldBytes(), frame.length);
+    QVERIFY(parser.nextMessage(message, frame));
+    QCOMPARE(parser.heldBytes(), 0);
+    QVERIFY(frame.data >= reinterpret_cast<const uint8_t*>(rest.constData()));
+    QVERIFY(frame.data < reinterpret_cast<const uint8_t*>(rest.constData()) + rest.length());
+}
+
+void MAVLinkFrameParserTest::_resync_test(void)
+{
+    QByteArray                  stream = _generateStream(4, false /* includeV1 */);
+    QList<mavlink_message_t>    generated = _referenceParse(stream);
+    QByteArray                  frameA = _frameBytes(generated[0]);
+    QByteArray                  frameB = _frameBytes(generated[1]);
+    QByteArray                  frameC = _frameBytes(generated[2]);
+    QByteArray                  frameD = _frameBytes(generated[3]);
+
+    // Bad checksum. Zeroed rather than flipped so the corrupt frame can't hold anything that looks like a start marker.
+    frameB[frameB.length() - 2] = 0;
+    frameB[frameB.length() - 1] = 0;
+
+    // Garbage which looks like the start of a frame claiming to run well into the next real frame
+    QByteArray fakeStart("\x01\x02\xFD\x20\x00", 5);
+
+    // Garbage ending in what could be the start of a frame split across buffers
+    QByteArray fakeTail("\x01\x02\xFD\x05", 4);
+
+    MAVLinkFrameParser parser;
+
+    QList<mavlink_message_t> messages;
+    messages += _frameParse(parser, fakeStart + frameA + frameB + frameC + fakeTail, 1000);
+    QCOMPARE(parser.heldBytes(), 2);
+    messages += _frameParse(parser, frameD, 1000);
+
+    QCOMPARE(messages.count(), 3);
+    QVERIFY(_sameMessage(messages[0], generated[0]));
+    QVERIFY(_sameMessage(messages[1], generated[2]));
+    QVERIFY(_sameMessage(messages[2], generated[3]));
+    QCOMPARE(parser.heldBytes(), 0);
+
+    QCOMPARE(parser.status().packet_rx_drop_count, static_cast<uint16_t>(2));
+    QVERIFY(parser.status().parse_error > 0);
+
+    // Unknown incompatibility flags are not a frame
+    QByteArray unknownFlags = frameA;
+    unknownFlags[2] = static_cast<char>(0x80);
+    QList<mavlink_message_t> unknownFlagsMessages = _frameParse(parser, frameC + unknownFlags, 1000);
+    QCOMPARE(unknownFlagsMessages.count(), 1);
+    QVERIFY(_sameMessage(unknownFlagsMessages[0], generated[2]));
+}
+
+void MAVLinkFrameParserBenchmark::_benchmark(void)
+{
+    QByteArray  stream;
+    QString     tlogFileName = qEnvironmentVariable("MAVLINK_BENCHMARK_TLOG");
+
+    if (tlogFileName.isEmpty()) {
+        stream = _generateStream(200000, false /* includeV1 */);
+    } else {
+        // Timestamps between the frames are skipped as garbage by both parsers
+        QFile tlogFile(tlogFileName);
+        QVERIFY2(tlogFile.open(QIODevice::ReadOnly), qPrintable(tlogFile.errorString()));
+        stream = tlogFile.readAll();
+    }
+
+    // Typical size of a serial or UDP read
+    constexpr int chunkSize = 512;
+    QList<QByteArray> chunks;
+    for (int position=0; position<stream.length(); position+=chunkSize) {
+        chunks.append(stream.mid(position, chunkSize));
+    }
+
+    // Both paths do what receiveBytes does with every message: forward it and write it to the telemetry log
+    QBuffer         logBuffer;
+    QElapsedTimer   timer;
+    logBuffer.open(QIODevice::WriteOnly);
+
+    // Previous path: parse a byte at a time, serialize separately for forwarding and logging
+    mavlink_message_t   message;
+    mavlink_status_t    status;
+    qint64              referenceCount = 0;
+    _clearChannelStatus(_referenceChannel);
+    timer.start();
+    for (const QByteArray& chunk: chunks) {
+        for (char byte: chunk) {
+            if (mavlink_parse_char(_referenceChannel, static_cast<uint8_t>(byte), &message, &status)) {
+                uint8_t forwardBuf[MAVLINK_MAX_PACKET_LEN];
+                mavlink_msg_to_send_buffer(forwardBuf, &message);
+
+                uint8_t logBuf[MAVLINK_MAX_PACKET_LEN + sizeof(quint64)];
+                qToBigEndian(static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000), logBuf);
+                int len = mavlink_msg_to_send_buffer(logBuf + sizeof(quint64), &message) + sizeof(quint64);
+                logBuffer.write(QByteArray(reinterpret_cast<const char*>(logBuf), len));
+
+                referenceCount++;
+            }
+        }
+    }
+    qint64 referenceNsecs = timer.nsecsElapsed();
+
+    // Frame parser: received frame is used as is
+    MAVLinkFrameParser          parser;
+    MAVLinkFrameParser::Frame_t frame;
+    qint64                      frameCount = 0;
+    logBuffer.seek(0);
+    timer.start();
+    for (const QByteArray& chunk: chunks) {
+        quint64 logTimeUsecs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
+        parser.setBuffer(chunk);
+        while (parser.nextMessage(message, frame)) {
+            uint8_t logBuf[MAVLinkFrameParser::maxFrameLength + sizeof(quint64)];
+            qToBigEndian(logTimeUsecs, logBuf);
+            memcpy(logBuf + sizeof(quint64), frame.data, frame.length);
+            logBuffer.write(reinterpret_cast<const char*>(logBuf), frame.length + sizeof(quint64));
+
+            frameCount++;
+        }
+    }
+    qint64 frameNsecs = timer.nsecsElapsed();
+
+    // A recorded log can have timestamps which look like a start of frame. mavlink_parse_char can lose a real frame
+    // to those, the frame parser resyncs.
+    QVERIFY(frameCount >= referenceCount);
+
+    qDebug() << "MAVLinkFrameParser bytes:messages:parse_char msgs/sec:frame parser msgs/sec:speedup"
+             << stream.length()
+             << frameCount
+             << referenceCount / (referenceNsecs / 1.0e9)
+             << frameCount / (frameNsecs / 1.0e9)
+             << static_cast<double>(referenceNsecs) / frameNsecs;
+}
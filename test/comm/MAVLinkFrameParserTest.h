@@ -0,0 +1,34 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+/// Unit tests for MAVLinkFrameParser. Results are checked against mavlink_parse_char.
+class MAVLinkFrameParserTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _parse_test        (void);
+    void _splitBuffer_test  (void);
+    void _resync_test       (void);
+};
+
+/// Run with --unittest:MAVLinkFrameParserBenchmark
+/// Set MAVLINK_BENCHMARK_TLOG to parse a recorded telemetry log instead of a generated high rate stream.
+class MAVLinkFrameParserBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _benchmark(void);
+};
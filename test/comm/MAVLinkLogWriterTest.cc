@@ -0,0 +1,188 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkLogWriterTest.h"
+#include "MAVLinkLogWriter.h"
+#include "MAVLinkLogIndex.h"
+#include "QGCMAVLink.h"
+#include "QGCTemporaryFile.h"
+
+#include <QThread>
+#include <QtEndian>
+
+// None of the timestamps which follow a non MAVLink record contain a start of frame byte, which indexing after the
+// fact would take for the start of a frame
+static constexpr quint64    _startTimeUsecs = 1600000006000000ull;
+static constexpr quint64    _stepUsecs      = 1000;
+static constexpr int        _recordCount    = 5000;    ///< Enough to span several batches
+
+/// Writes _recordCount heartbeat/attitude frames, plus every 100th a non MAVLink record, through a writer thread
+static void _writeLog(QFile& logFile)
+{
+    QThread             writerThread;
+    MAVLinkLogWriter*   writer = new MAVLinkLogWriter();
+
+    writer->moveToThread(&writerThread);
+    QObject::connect(&writerThread, &QThread::finished, writer, &QObject::deleteLater);
+    writerThread.start();
+
+    QVERIFY(writer->open(&logFile));
+    for (int i=0; i<_recordCount; i++) {
+        mavlink_message_t   message;
+        uint8_t             buf[MAVLINK_MAX_PACKET_LEN];
+
+        if (i % 100 == 99) {
+            const char notMavlink[] = "not mavlink";
+            writer->append(_startTimeUsecs + (i * _stepUsecs), notMavlink, sizeof(notMavlink), MAVLinkLogIndex::msgIdForFrame(notMavlink, sizeof(notMavlink)));
+            continue;
+        }
+        if (i % 2 == 0) {
+            mavlink_msg_heartbeat_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, 0, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, 0, MAV_STATE_ACTIVE);
+        } else {
+            mavlink_msg_attitude_pack_chan(1, MAV_COMP_ID_AUTOPILOT1, 0, &message, i, 0.1f, 0.2f, 0.3f, 0, 0, 0);
+        }
+        int len = mavlink_msg_to_send_buffer(buf, &message);
+        writer->append(_startTimeUsecs + (i * _stepUsecs), reinterpret_cast<const char*>(buf), len, message.msgid);
+    }
+    writer->close();
+
+    writerThread.quit();
+    writerThread.wait();
+}
+
+void MAVLinkLogWriterTest::_writeAndIndex_test(void)
+{
+    QGCTemporaryFile logFile("MAVLinkLogWriterTestXXXXXX.tlog");
+    logFile.setAutoRemove(true);
+    QVERIFY(logFile.open());
+    _writeLog(logFile);
+    QVERIFY(!QTest::currentTestFailed());
+
+    MAVLinkLogIndex index;
+    QString         errorString;
+    QVERIFY2(index.open(MAVLinkLogIndex::indexFileName(logFile.fileName()), errorString), qPrintable(errorString));
+    QCOMPARE(index.count(), _recordCount);
+    QCOMPARE(index.startTimeUsecs(), _startTimeUsecs);
+    QCOMPARE(index.durationUsecs(), (_recordCount - 1) * _stepUsecs);
+
+    // Every entry must point at its record, timestamp included
+    QVERIFY(logFile.seek(0));
+    QByteArray log = logFile.readAll();
+    for (int i=0; i<index.count(); i++) {
+        MAVLinkLogIndex::Entry_t entry = index.entry(i);
+
+        QVERIFY(entry.offset + sizeof(quint64) < static_cast<quint64>(log.length()));
+        QCOMPARE(qFromBigEndian<quint64>(log.constData() + entry.offset), entry.timeUsecs);
+        if (i % 100 == 99) {
+            QCOMPARE(entry.msgid, MAVLinkLogIndex::unknownMsgId);
+        } else {
+            QCOMPARE(entry.msgid, MAVLinkLogIndex::msgIdForFrame(log.constData() + entry.offset + sizeof(quint64), log.length() - entry.offset - sizeof(quint64)));
+        }
+    }
+
+    index.close();
+    QFile::remove(MAVLinkLogIndex::indexFileName(logFile.fileName()));
+}
+
+void MAVLinkLogWriterTest::_timeSeek_test(void)
+{
+    QGCTemporaryFile logFile("MAVLinkLogWriterTestXXXXXX.tlog");
+    logFile.setAutoRemove(true);
+    QVERIFY(logFile.open());
+    _writeLog(logFile);
+    QVERIFY(!QTest::currentTestFailed());
+
+    MAVLinkLogIndex index;
+    QString         errorString;
+    QVERIFY2(index.open(MAVLinkLogIndex::indexFileName(logFile.fileName()), errorString), qPrintable(errorString));
+
+    QCOMPARE(index.entryIndexForTime(0), 0);
+    QCOMPARE(index.entryIndexForTime(_startTimeUsecs + (1234 * _stepUsecs)), 1234);
+    QCOMPARE(index.entryIndexForTime(_startTimeUsecs + (1234 * _stepUsecs) + 1), 1235);
+    QCOMPARE(index.entryIndexForTime(UINT64_MAX), _recordCount);
+
+    index.close();
+    QFile::remove(MAVLinkLogIndex::indexFileName(logFile.fileName()));
+}
+
+void MAVLinkLogWriterTest::_messageLookup_test(void)
+{
+    QGCTemporaryFile logFile("MAVLinkLogWriterTestXXXXXX.tlog");
+    logFile.setAutoRemove(true);
+    QVERIFY(logFile.open());
+    _writeLog(logFile);
+    QVERIFY(!QTest::currentTestFailed());
+
+    MAVLinkLogIndex index;
+    QString         errorString;
+    QVERIFY2(index.open(MAVLinkLogIndex::indexFileName(logFile.fileName()), errorString), qPrintable(errorString));
+
+    // Records 100 - 199 hold attitude on the odd indices, 199 is the non MAVLink record
+    QVector<int> attitudeIndices = index.entryIndicesForMessage(MAVLINK_MSG_ID_ATTITUDE, _startTimeUsecs + (100 * _stepUsecs), _startTimeUsecs + (200 * _stepUsecs));
+    QCOMPARE(attitudeIndices.count(), 49);
+    for (int entryIndex: attitudeIndices) {
+        QCOMPARE(index.entry(entryIndex).msgid, static_cast<quint32>(MAVLINK_MSG_ID_ATTITUDE));
+        QVERIFY(entryIndex >= 100 && entryIndex < 199);
+    }
+    QCOMPARE(index.entryIndicesForMessage(MAVLINK_MSG_ID_SYS_STATUS).count(), 0);
+
+    index.close();
+    QFile::remove(MAVLinkLogIndex::indexFileName(logFile.fileName()));
+}
+
+void MAVLinkLogWriterTest::_build_test(void)
+{
+    QGCTemporaryFile logFile("MAVLinkLogWriterTestXXXXXX.tlog");
+    logFile.setAutoRemove(true);
+    QVERIFY(logFile.open());
+    _writeLog(logFile);
+    QVERIFY(!QTest::currentTestFailed());
+
+    MAVLinkLogIndex recordedIndex;
+    QString         errorString;
+    QVERIFY2(recordedIndex.open(MAVLinkLogIndex::indexFileName(logFile.fileName()), errorString), qPrintable(errorString));
+    QVERIFY(recordedIndex.coversLog(logFile));
+
+    // Indexing after the fact frames records the way replay always has, from the timestamp to the end of the next
+    // MAVLink frame. So the non MAVLink records are folded into the frame which follows them and their timestamps are
+    // lost. Everything else must match what was recorded.
+    QString builtIndexFileName = logFile.fileName() + ".built.idx";
+    QVERIFY2(MAVLinkLogIndex::build(logFile.fileName(), builtIndexFileName, errorString), qPrintable(errorString));
+
+    MAVLinkLogIndex builtIndex;
+    QVERIFY2(builtIndex.open(builtIndexFileName, errorString), qPrintable(errorString));
+    QVERIFY(builtIndex.coversLog(logFile));
+    QCOMPARE(builtIndex.count(), _recordCount - (_recordCount / 100));
+    QCOMPARE(builtIndex.startTimeUsecs(), recordedIndex.startTimeUsecs());
+
+    int builtEntry = 0;
+    for (int i=0; i<recordedIndex.count(); i++) {
+        MAVLinkLogIndex::Entry_t recordedEntry = recordedIndex.entry(i);
+        if (recordedEntry.msgid == MAVLinkLogIndex::unknownMsgId) {
+            continue;
+        }
+        MAVLinkLogIndex::Entry_t entry = builtIndex.entry(builtEntry++);
+        QCOMPARE(entry.msgid, recordedEntry.msgid);
+        if (i % 100 != 0) {
+            QCOMPARE(entry.offset, recordedEntry.offset);
+            QCOMPARE(entry.timeUsecs, recordedEntry.timeUsecs);
+        }
+    }
+
+    // An index for a different log, or for this one before it grew, must not be used
+    recordedIndex.close();
+    QVERIFY(logFile.seek(logFile.size()));
+    QVERIFY(logFile.write(QByteArray(4096, 0)) == 4096);
+    QVERIFY(logFile.flush());
+    QVERIFY(!builtIndex.coversLog(logFile));
+
+    builtIndex.close();
+    QFile::remove(builtIndexFileName);
+    QFile::remove(MAVLinkLogIndex::indexFileName(logFile.fileName()));
+}
@@ -0,0 +1,24 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for MAVLinkLogWriter and MAVLinkLogIndex
+class MAVLinkLogWriterTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _writeAndIndex_test    (void);
+    void _timeSeek_test         (void);
+    void _messageLookup_test    (void);
+    void _build_test            (void);
+};
@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkMessageDispatcherTest.h"
+#include "MAVLinkMessageDispatcher.h"
+
+#include <QThread>
+
+static mavlink_message_t _message(uint32_t msgid)
+{
+    mavlink_message_t message = {};
+    message.msgid = msgid;
+    return message;
+}
+
+void MAVLinkMessageDispatcherTest::_dispatch_test(void)
+{
+    MAVLinkMessageDispatcher    dispatcher;
+    QObject                     context;
+    QStringList                 calls;
+
+    dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("attitude1"); });
+    dispatcher.subscribe(MAVLINK_MSG_ID_HEARTBEAT, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("heartbeat"); });
+    dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("attitude2"); });
+    QVERIFY(dispatcher.hasHandlers(MAVLINK_MSG_ID_ATTITUDE));
+    QVERIFY(!dispatcher.hasHandlers(MAVLINK_MSG_ID_SYS_STATUS));
+
+    mavlink_message_t attitude  = _message(MAVLINK_MSG_ID_ATTITUDE);
+    mavlink_message_t sysStatus = _message(MAVLINK_MSG_ID_SYS_STATUS);
+    dispatcher.dispatch(nullptr, attitude);
+    dispatcher.dispatch(nullptr, sysStatus);
+    QCOMPARE(calls, QStringList({ "attitude1", "attitude2" }));
+    QCOMPARE(dispatcher.unhandledMessages(), 1ull);
+
+    // Subscribers to all messages are called in subscription order along with the ones for the message id
+    calls.clear();
+    dispatcher.subscribe(MAVLinkMessageDispatcher::allMessages, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("all"); });
+    dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("attitude3"); });
+    QVERIFY(dispatcher.hasHandlers(MAVLINK_MSG_ID_SYS_STATUS));
+    dispatcher.dispatch(nullptr, attitude);
+    dispatcher.dispatch(nullptr, sysStatus);
+    QCOMPARE(calls, QStringList({ "attitude1", "attitude2", "all", "attitude3", "all" }));
+}
+
+void MAVLinkMessageDispatcherTest::_unsubscribe_test(void)
+{
+    MAVLinkMessageDispatcher    dispatcher;
+    QObject                     context;
+    QObject*                    doomedContext = new QObject();
+    QStringList                 calls;
+    int                         secondId = 0;
+
+    // The first handler takes out the second and the third before they are called, the fourth comes in after the
+    // dispatch started so it waits for the next one
+    dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&](LinkInterface*, mavlink_message_t&) {
+        calls.append("first");
+        dispatcher.unsubscribe(secondId);
+        delete doomedContext;
+        doomedContext = nullptr;
+        dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("fourth"); });
+    });
+    secondId = dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("second"); });
+    dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, doomedContext, [&calls](LinkInterface*, mavlink_message_t&) { calls.append("third"); });
+
+    mavlink_message_t attitude = _message(MAVLINK_MSG_ID_ATTITUDE);
+    dispatcher.dispatch(nullptr, attitude);
+    QCOMPARE(calls, QStringList({ "first" }));
+
+    calls.clear();
+    dispatcher.dispatch(nullptr, attitude);
+    QCOMPARE(calls, QStringList({ "first", "fourth" }));
+    QCOMPARE(dispatcher.handlerStats().count(), 3);
+}
+
+void MAVLinkMessageDispatcherTest::_handlerStats_test(void)
+{
+    MAVLinkMessageDispatcher    dispatcher;
+    QObject                     context;
+
+    int attitudeId = dispatcher.subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [](LinkInterface*, mavlink_message_t&) { QThread::usleep(2000); }, QStringLiteral("SlowAttitude"));
+    int heartbeatId = dispatcher.subscribe(MAVLINK_MSG_ID_HEARTBEAT, &context, [](LinkInterface*, mavlink_message_t&) { });
+
+    mavlink_message_t attitude = _message(MAVLINK_MSG_ID_ATTITUDE);
+    for (int i=0; i<3; i++) {
+        dispatcher.dispatch(nullptr, attitude);
+    }
+
+    bool attitudeFound  = false;
+    bool heartbeatFound = false;
+    for (const MAVLinkMessageDispatcher::HandlerStats_t& stats: dispatcher.handlerStats()) {
+        if (stats.subscriptionId == attitudeId) {
+            attitudeFound = true;
+            QCOMPARE(stats.name, QStringLiteral("SlowAttitude"));
+            QCOMPARE(stats.msgid, static_cast<uint32_t>(MAVLINK_MSG_ID_ATTITUDE));
+            QCOMPARE(stats.calls, 3ull);
+            QVERIFY(stats.maxNsecs >= 2000000);
+            QVERIFY(stats.totalNsecs >= 3 * 2000000);
+            QVERIFY(stats.totalNsecs >= stats.maxNsecs);
+        } else if (stats.subscriptionId == heartbeatId) {
+            heartbeatFound = true;
+            QCOMPARE(stats.name, QStringLiteral("QObject"));
+            QCOMPARE(stats.calls, 0ull);
+        }
+    }
+    QVERIFY(attitudeFound && heartbeatFound);
+
+    dispatcher.resetHandlerStats();
+    for (const MAVLinkMessageDispatcher::HandlerStats_t& stats: dispatcher.handlerStats()) {
+        QCOMPARE(stats.calls, 0ull);
+        QCOMPARE(stats.totalNsecs, 0ll);
+    }
+}
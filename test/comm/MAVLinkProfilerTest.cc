@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkProfilerTest.h"
+#include "MAVLinkProfiler.h"
+#include "MAVLinkMessageDispatcher.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QThread>
+
+static constexpr int _frameLength = 20;
+
+static mavlink_message_t _message(uint32_t msgid)
+{
+    mavlink_message_t message = {};
+    message.msgid = msgid;
+    return message;
+}
+
+static void _receive(MAVLinkProfiler& profiler, const mavlink_message_t& message, int count)
+{
+    for (int i=0; i<count; i++) {
+        qint64 startNsecs = profiler.messageReceived(nullptr, message, _frameLength);
+        profiler.messageHandled(message.msgid, startNsecs);
+    }
+}
+
+void MAVLinkProfilerTest::_count_test(void)
+{
+    MAVLinkProfiler profiler;
+
+    _receive(profiler, _message(MAVLINK_MSG_ID_HEARTBEAT), 2);
+    _receive(profiler, _message(MAVLINK_MSG_ID_ATTITUDE), 32);
+    QCOMPARE(profiler.messagesReceived(), 34ull);
+
+    // Nothing shows until the first sample
+    QVERIFY(profiler.messageStats().isEmpty());
+    QTest::qWait(10);
+    profiler.sample();
+
+    const QList<MAVLinkProfiler::MessageStats_t>& messageStats = profiler.messageStats();
+    QCOMPARE(messageStats.count(), 2);
+    QCOMPARE(messageStats[0].msgid, static_cast<uint32_t>(MAVLINK_MSG_ID_HEARTBEAT));
+    QCOMPARE(messageStats[0].name, QStringLiteral("HEARTBEAT"));
+    QCOMPARE(messageStats[0].count, 2ull);
+    QCOMPARE(messageStats[0].bytes, 2ull * _frameLength);
+    QCOMPARE(messageStats[1].msgid, static_cast<uint32_t>(MAVLINK_MSG_ID_ATTITUDE));
+    QCOMPARE(messageStats[1].count, 32ull);
+    QVERIFY(messageStats[1].messagesPerSec > 0);
+
+    // Only one in timingSampleInterval messages is timed: the first heartbeat and two of the attitudes
+    QCOMPARE(messageStats[0].timedCount + messageStats[1].timedCount, 3ull);
+    QCOMPARE(messageStats[0].timedCount, 1ull);
+
+    QCOMPARE(profiler.history().count(), 1);
+    QCOMPARE(profiler.history()[0].messagesPerSec, messageStats[0].messagesPerSec + messageStats[1].messagesPerSec);
+
+    // Rates are for the messages since the last sample
+    QTest::qWait(10);
+    profiler.sample();
+    QCOMPARE(profiler.messageStats()[1].count, 32ull);
+    QCOMPARE(profiler.messageStats()[1].messagesPerSec, 0.0);
+    QCOMPARE(profiler.history().count(), 2);
+
+    profiler.reset();
+    QCOMPARE(profiler.messagesReceived(), 0ull);
+    QVERIFY(profiler.history().isEmpty());
+    QVERIFY(profiler.messageStats().isEmpty());
+}
+
+void MAVLinkProfilerTest::_handler_test(void)
+{
+    MAVLinkProfiler             profiler;
+    MAVLinkMessageDispatcher*   dispatcher = new MAVLinkMessageDispatcher();
+    QObject                     context;
+
+    dispatcher->subscribe(MAVLINK_MSG_ID_ATTITUDE, &context, [](LinkInterface*, mavlink_message_t&) { QThread::msleep(20); }, QStringLiteral("Slow"));
+    profiler.addDispatcher(QStringLiteral("Test"), dispatcher);
+
+    mavlink_message_t attitude = _message(MAVLINK_MSG_ID_ATTITUDE);
+    profiler.sample();
+    dispatcher->dispatch(nullptr, attitude);
+    profiler.sample();
+
+    QCOMPARE(profiler.handlerStats().count(), 1);
+    const MAVLinkProfiler::HandlerStats_t& handlerStats = profiler.handlerStats()[0];
+    QCOMPARE(handlerStats.owner, QStringLiteral("Test"));
+    QCOMPARE(handlerStats.name, QStringLiteral("Slow"));
+    QCOMPARE(handlerStats.calls, 1ull);
+    QVERIFY(handlerStats.totalNsecs >= 20 * 1000000ll);
+    QVERIFY(handlerStats.cpuPercent > 0);
+    QCOMPARE(profiler.history().last().handlerCpuPercent, handlerStats.cpuPercent);
+
+    // CPU time is for the handler calls since the last sample
+    profiler.sample();
+    QCOMPARE(profiler.handlerStats()[0].cpuPercent, 0.0);
+
+    // Reset goes through to the dispatcher
+    profiler.reset();
+    QCOMPARE(dispatcher->handlerStats()[0].calls, 0ull);
+
+    // A destroyed dispatcher is dropped
+    delete dispatcher;
+    profiler.sample();
+    QVERIFY(profiler.handlerStats().isEmpty());
+}
+
+void MAVLinkProfilerTest::_json_test(void)
+{
+    MAVLinkProfiler profiler;
+    profiler.setQueueDepthsSource([]() {
+        MAVLinkProfiler::QueueDepths_t queueDepths;
+        queueDepths.ingestQueueDepth    = 7;
+        queueDepths.ingestBacklogBytes  = 1000;
+        return queueDepths;
+    });
+
+    _receive(profiler, _message(MAVLINK_MSG_ID_HEARTBEAT), 3);
+    QTest::qWait(10);
+    profiler.sample();
+
+    QJsonObject json = profiler.toJson();
+    QCOMPARE(json[QStringLiteral("messagesReceived")].toInt(), 3);
+    QJsonArray messagesJson = json[QStringLiteral("messages")].toArray();
+    QCOMPARE(messagesJson.count(), 1);
+    QCOMPARE(messagesJson[0].toObject()[QStringLiteral("name")].toString(), QStringLiteral("HEARTBEAT"));
+    QCOMPARE(messagesJson[0].toObject()[QStringLiteral("count")].toInt(), 3);
+    QJsonArray historyJson = json[QStringLiteral("history")].toArray();
+    QCOMPARE(historyJson.count(), 1);
+    QCOMPARE(historyJson[0].toObject()[QStringLiteral("ingestQueueDepth")].toInt(), 7);
+    QCOMPARE(historyJson[0].toObject()[QStringLiteral("ingestBacklogBytes")].toInt(), 1000);
+
+    QTemporaryDir tempDir;
+    QString fileName = tempDir.filePath(QStringLiteral("profile.json"));
+    QString errorString;
+    QVERIFY(profiler.saveJson(fileName, errorString));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonObject savedJson = QJsonDocument::fromJson(file.readAll()).object();
+    QCOMPARE(savedJson[QStringLiteral("messages")].toArray(), messagesJson);
+
+    QVERIFY(!profiler.saveJson(tempDir.filePath(QStringLiteral("missing/profile.json")), errorString));
+    QVERIFY(!errorString.isEmpty());
+}
@@ -0,0 +1,240 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "UDPLinkTest.h"
+#include "UDPLink.h"
+#include "LinkManager.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QNetworkInterface>
+#include <QThread>
+#include <QUdpSocket>
+
+#include <atomic>
+
+// Small enough bursts that a loaded machine doesn't overflow the socket receive buffer before the link drains it
+static constexpr int _burstDatagrams    = 32;
+static constexpr int _peerCount         = 4;
+
+static quint16 _freeLocalPort(void)
+{
+    QUdpSocket socket;
+    socket.bind(QHostAddress::AnyIPv4, 0);
+    return socket.localPort();
+}
+
+/// Connects a UDPLink listening on a free local port
+///     @param targetPort Manually configured target host on 127.0.0.1, 0 for none
+static SharedLinkInterfacePtr _connectLink(LinkManager* linkManager, quint16& localPort, quint16 targetPort = 0)
+{
+    UDPConfiguration* udpConfig = new UDPConfiguration(QStringLiteral("UDPLinkTest"));
+    localPort = _freeLocalPort();
+    udpConfig->setDynamic(true);
+    udpConfig->setLocalPort(localPort);
+    if (targetPort) {
+        udpConfig->addHost(QStringLiteral("127.0.0.1"), targetPort);
+    }
+
+    SharedLinkConfigurationPtr config(udpConfig);
+    if (!linkManager->createConnectedLink(config)) {
+        return nullptr;
+    }
+    return linkManager->sharedLinkInterfacePointerForLink(config->link());
+}
+
+/// Datagram i of a test stream, every size from 1 to 1400 bytes shows up
+static QByteArray _datagram(int i)
+{
+    QByteArray datagram((i * 37) % 1400 + 1, 0);
+    for (int j=0; j<datagram.length(); j++) {
+        datagram[j] = static_cast<char>(i + j);
+    }
+    return datagram;
+}
+
+void UDPLinkTest::_receive_test(void)
+{
+    quint16                 localPort;
+    SharedLinkInterfacePtr  link = _connectLink(_linkManager, localPort);
+    QVERIFY(link);
+    QTRY_VERIFY(link->isConnected());
+
+    // Context goes away before received does, even if a check fails part way through
+    QByteArray  received;
+    QObject     context;
+    connect(link.get(), &LinkInterface::bytesReceived, &context, [&received](LinkInterface*, QByteArray data) { received.append(data); });
+
+    QUdpSocket peer;
+    QVERIFY(peer.bind(QHostAddress::LocalHost, 0));
+
+    // Enough datagrams to fill several recvmmsg batches and cross the emit threshold many times
+    QByteArray sent;
+    for (int burst=0; burst<20; burst++) {
+        for (int i=0; i<_burstDatagrams; i++) {
+            QByteArray datagram = _datagram((burst * _burstDatagrams) + i);
+            QCOMPARE(peer.writeDatagram(datagram, QHostAddress::LocalHost, localPort), static_cast<qint64>(datagram.length()));
+            sent.append(datagram);
+        }
+        QTRY_COMPARE(received.length(), sent.length());
+    }
+    QCOMPARE(received, sent);
+
+    link->disconnect();
+}
+
+void UDPLinkTest::_sessionTargets_test(void)
+{
+    QUdpSocket configuredPeer;
+    QUdpSocket sessionPeer;
+    QVERIFY(configuredPeer.bind(QHostAddress::LocalHost, 0));
+    QVERIFY(sessionPeer.bind(QHostAddress::LocalHost, 0));
+
+    quint16                 localPort;
+    SharedLinkInterfacePtr  link = _connectLink(_linkManager, localPort, configuredPeer.localPort());
+    QVERIFY(link);
+    QTRY_VERIFY(link->isConnected());
+
+    int     receivedBytes = 0;
+    QObject context;
+    connect(link.get(), &LinkInterface::bytesReceived, &context, [&receivedBytes](LinkInterface*, QByteArray data) { receivedBytes += data.length(); });
+
+    // Both peers become session targets. The configured one is already a target, it must still only get one copy.
+    const QByteArray configuredHello("configured");
+    const QByteArray sessionHello("session");
+    for (int i=0; i<10; i++) {
+        configuredPeer.writeDatagram(configuredHello, QHostAddress::LocalHost, localPort);
+        sessionPeer.writeDatagram(sessionHello, QHostAddress::LocalHost, localPort);
+    }
+    QTRY_COMPARE(receivedBytes, 10 * (configuredHello.length() + sessionHello.length()));
+
+    const char reply[] = "reply";
+    link->writeBytesThreadSafe(reply, sizeof(reply));
+    for (QUdpSocket* peer: { &configuredPeer, &sessionPeer }) {
+        QTRY_VERIFY(peer->hasPendingDatagrams());
+        QByteArray datagram(static_cast<int>(peer->pendingDatagramSize()), 0);
+        peer->readDatagram(datagram.data(), datagram.length());
+        QCOMPARE(datagram, QByteArray(reply, sizeof(reply)));
+    }
+    QTest::qWait(100);
+    QVERIFY(!configuredPeer.hasPendingDatagrams());
+    QVERIFY(!sessionPeer.hasPendingDatagrams());
+
+    link->disconnect();
+}
+
+void UDPLinkBenchmark::_benchmark(void)
+{
+    constexpr int   burstCount      = 5000;
+    constexpr int   datagramBytes   = 280;      // Full size MAVLink 2 frame
+    constexpr int   totalDatagrams  = burstCount * _burstDatagrams;
+    const QByteArray datagram(datagramBytes, 'x');
+
+    // Several GCS peers, each sending a burst in turn
+    QUdpSocket peers[_peerCount];
+    for (QUdpSocket& peer: peers) {
+        QVERIFY(peer.bind(QHostAddress::LocalHost, 0));
+    }
+
+    QElapsedTimer timer;
+
+    // Previous path: a fresh QByteArray per datagram, and a locked linear session target search for each one
+    QUdpSocket receiver;
+    QVERIFY(receiver.bind(QHostAddress::LocalHost, 0));
+    receiver.setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 512 * 1024);
+
+    QList<QHostAddress>     localAddresses = QNetworkInterface::allAddresses();
+    QList<UDPCLient*>       sessionTargets;
+    QMutex                  sessionTargetsMutex;
+    qint64                  referenceBytes = 0;
+    timer.start();
+    for (int burst=0; burst<burstCount; burst++) {
+        QUdpSocket& peer = peers[burst % _peerCount];
+        for (int i=0; i<_burstDatagrams; i++) {
+            peer.writeDatagram(datagram, QHostAddress::LocalHost, receiver.localPort());
+        }
+
+        QByteArray databuffer;
+        while (receiver.hasPendingDatagrams()) {
+            QByteArray received;
+            received.resize(receiver.pendingDatagramSize());
+            QHostAddress sender;
+            quint16 senderPort;
+            if (receiver.readDatagram(received.data(), received.size(), &sender, &senderPort) == -1) {
+                break;
+            }
+            databuffer.append(received);
+            if (databuffer.size() > 10 * 1024) {
+                referenceBytes += databuffer.size();
+                databuffer.clear();
+            }
+            QHostAddress asender = sender;
+            if (localAddresses.contains(sender)) {
+                asender = QHostAddress(QString("127.0.0.1"));
+            }
+            QMutexLocker locker(&sessionTargetsMutex);
+            bool found = false;
+            for (const UDPCLient* target: sessionTargets) {
+                if (target->address == asender && target->port == senderPort) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                sessionTargets.append(new UDPCLient(asender, senderPort));
+            }
+        }
+        referenceBytes += databuffer.size();
+    }
+    qint64 referenceNsecs = timer.nsecsElapsed();
+    qDeleteAll(sessionTargets);
+    QCOMPARE(referenceBytes, static_cast<qint64>(totalDatagrams) * datagramBytes);
+
+    // UDPLink: received bytes also go through to the MAVLink ingest queue, as they do in the field
+    quint16                 localPort;
+    SharedLinkInterfacePtr  link = _connectLink(_linkManager, localPort);
+    QVERIFY(link);
+    QTRY_VERIFY(link->isConnected());
+
+    // Counted on the link thread, the link is always disconnected before this goes out of scope
+    std::atomic<qint64> linkBytes(0);
+    QObject             context;
+    connect(link.get(), &LinkInterface::bytesReceived, &context, [&linkBytes](LinkInterface*, QByteArray data) { linkBytes += data.length(); }, Qt::DirectConnection);
+
+    bool datagramsLost = false;
+    timer.start();
+    for (int burst=0; burst<burstCount && !datagramsLost; burst++) {
+        QUdpSocket& peer = peers[burst % _peerCount];
+        for (int i=0; i<_burstDatagrams; i++) {
+            peer.writeDatagram(datagram, QHostAddress::LocalHost, localPort);
+        }
+        qint64 expectedBytes = static_cast<qint64>(burst + 1) * _burstDatagrams * datagramBytes;
+        QElapsedTimer burstTimer;
+        burstTimer.start();
+        while (linkBytes < expectedBytes) {
+            if (burstTimer.hasExpired(5000)) {
+                datagramsLost = true;
+                break;
+            }
+            QThread::yieldCurrentThread();
+        }
+    }
+    qint64 linkNsecs = timer.nsecsElapsed();
+
+    link->disconnect();
+    QVERIFY2(!datagramsLost, "UDPLink lost datagrams");
+
+    qDebug() << "UDPLink datagrams:bytes:readDatagram datagrams/sec:UDPLink datagrams/sec:readDatagram nsecs/datagram:UDPLink nsecs/datagram"
+             << totalDatagrams
+             << static_cast<qint64>(totalDatagrams) * datagramBytes
+             << totalDatagrams / (referenceNsecs / 1.0e9)
+             << totalDatagrams / (linkNsecs / 1.0e9)
+             << referenceNsecs / totalDatagrams
+             << linkNsecs / totalDatagrams;
+}
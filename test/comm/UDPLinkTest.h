@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ * (c) 2009-2020 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit tests for UDPLink receive and session target handling
+class UDPLinkTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _receive_test          (void);
+    void _sessionTargets_test   (void);
+};
+
+/// Run with --unittest:UDPLinkBenchmark
+/// Sends bursts of datagrams over loopback, once to a socket read a datagram at a time the way UDPLink used to, once
+/// to a connected UDPLink.
+class UDPLinkBenchmark : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _benchmark(void);
+};